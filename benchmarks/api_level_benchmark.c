@@ -0,0 +1,105 @@
+/*
+ * API level benchmark: the bus's ring lanes as built for one UMSBB_API_LEVEL.
+ * CMake builds it once per level (api_level0_benchmark, api_level1_benchmark,
+ * api_level3_benchmark), each against bus sources compiled at that level, so
+ * the runs carry the same names and compare directly:
+ *
+ *   ./api_level3_benchmark --json full.json
+ *   ./api_level0_benchmark --json minimal.json
+ *   ./api_level0_benchmark --compare full.json minimal.json
+ */
+
+#include "bench_harness.h"
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_POLL_BATCH 64
+#define BENCH_RING_BYTES (4u * 1024 * 1024)
+
+typedef struct {
+    UniversalMultiSegmentedBiBufferBus* bus;
+    uint32_t lanes;
+} level_bench_t;
+
+static void level_destroy(void* ctx) {
+    level_bench_t* l = ctx;
+    umsbb_free(l->bus);
+    free(l);
+}
+
+static void* level_create(uint32_t producers, uint32_t consumers, size_t size, bench_run_t* run) {
+    (void)run;
+    level_bench_t* l = calloc(1, sizeof(*l));
+    if (!l) return NULL;
+    size_t bytes = BENCH_RING_BYTES;
+    while (bytes < size * 2048) bytes *= 2;
+    l->lanes = consumers;
+    l->bus = umsbb_init(bytes, consumers);
+    if (!l->bus) {
+        free(l);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < consumers && producers > consumers; i++) {
+        umsbb_configure_lane_mode(l->bus, i, BI_BUFFER_MODE_MPSC);
+    }
+    return l;
+}
+
+static bool level_send(void* ctx, uint32_t producer, const void* data, size_t size) {
+    level_bench_t* l = ctx;
+    return umsbb_submit_to(l->bus, producer % l->lanes, data, size);
+}
+
+// Zero-copy: batched in-place views
+static size_t level_poll_views(void* ctx, uint32_t consumer, bench_run_t* run) {
+    level_bench_t* l = ctx;
+    umsbb_msg_view views[BENCH_POLL_BATCH];
+    size_t n = umsbb_drain_batch(l->bus, consumer, views, BENCH_POLL_BATCH);
+    for (size_t i = 0; i < n; i++) {
+        bench_consume(run, views[i].data, views[i].size);
+    }
+    if (n) umsbb_release_batch(l->bus, consumer, views, n);
+    return n;
+}
+
+// Copying: umsbb_drain_from, which runs the offload, feedback and batch path
+static size_t level_poll_copy(void* ctx, uint32_t consumer, bench_run_t* run) {
+    level_bench_t* l = ctx;
+    size_t n = 0, size;
+    void* msg;
+    while (n < BENCH_POLL_BATCH && (msg = umsbb_drain_from(l->bus, consumer, &size)) != NULL) {
+        bench_consume(run, msg, size);
+        umsbb_message_release(msg);
+        n++;
+    }
+    return n;
+}
+
+static const bench_transport_t transports[] = {
+    { "lanes", "umsbb_submit_to and batched in-place drains", 0, 0, 0,
+      level_create, level_send, level_poll_views, level_destroy },
+    { "lanes_copy", "umsbb_submit_to and umsbb_drain_from", 0, 0, 0,
+      level_create, level_send, level_poll_copy, level_destroy },
+};
+
+static const bench_plan_t plans[] = {
+    { "message size sweep, closed loop",
+      { 1 }, 1, { 1 }, 1, { 16, 64, 256, 1024 }, 4, { 0 }, 1 },
+    { "shared lanes, 64 B, closed loop",
+      { 4 }, 1, { 1, 2 }, 2, { 64 }, 1, { 0 }, 1 },
+    { "latency at fixed load, open loop",
+      { 1 }, 1, { 1 }, 1, { 64 }, 1, { 100000, 1000000 }, 2 },
+};
+
+int main(int argc, char** argv) {
+    if (!umsbb_features_match()) {
+        fprintf(stderr, "bus library built with features 0x%x, this benchmark with 0x%x\n",
+                umsbb_feature_mask(), UMSBB_FEATURES);
+        return 2;
+    }
+    printf("UMSBB_API_LEVEL %d, features 0x%03x, bus struct %zu bytes\n", UMSBB_API_LEVEL, UMSBB_FEATURES,
+           sizeof(UniversalMultiSegmentedBiBufferBus));
+    return bench_main(argc, argv, "api_level", transports, sizeof(transports) / sizeof(transports[0]), plans,
+                      sizeof(plans) / sizeof(plans[0]));
+}
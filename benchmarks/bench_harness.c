@@ -0,0 +1,880 @@
+/*
+ * Benchmark harness: thread placement, run driver, reporting and the
+ * baseline comparison for the suites under benchmarks/
+ */
+
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // pthread_setaffinity_np
+#endif
+#include "bench_harness.h"
+#include "../include/cpu_topology.h"
+#include "../include/latency_histogram.h"
+#include "../include/umsbb_clock.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#define THREAD_RETURN_TYPE unsigned __stdcall
+typedef HANDLE bench_thread_t;
+#else
+#include <pthread.h>
+#include <sched.h>
+#define THREAD_RETURN_TYPE void*
+typedef pthread_t bench_thread_t;
+#endif
+
+#define BENCH_MAX_SLOTS 128           // Consuming threads tracked separately per run
+#define BENCH_IDLE_SPINS 256          // Empty polls before a consumer yields
+
+static inline void bench_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/* What one consuming thread saw; only that thread writes it. */
+typedef struct {
+    _Alignas(64) atomic_uint_fast64_t consumed;
+    atomic_uint_fast64_t measured;
+    atomic_uint_fast64_t bytes;
+    atomic_uint_fast64_t corrupt;
+} bench_slot_t;
+
+typedef struct {
+    _Alignas(64) bench_run_t* run;
+    uint32_t index;
+    uint64_t sent;
+    uint64_t retries;
+    uint8_t* message;
+} bench_producer_t;
+
+struct bench_run {
+    const bench_transport_t* transport;
+    void* ctx;
+    uint64_t id;
+    uint32_t producers;
+    uint32_t consumers;
+    size_t size;
+    uint64_t rate;
+    bool pin;
+    const uint32_t* cpus;
+    uint32_t cpu_count;
+    uint64_t start_ns;          // Producers go
+    uint64_t measure_ns;        // Warmup over
+    uint64_t stop_ns;           // Producers stop
+    atomic_bool go;
+    atomic_bool done;           // Consumers exit
+    atomic_bool abandon;        // Producers give up on a full transport
+    atomic_uint ready;
+    atomic_uint producing;      // Producer threads not finished yet
+    atomic_uint slot_count;
+    bench_slot_t slots[BENCH_MAX_SLOTS];
+    bench_slot_t shared;        // For threads beyond BENCH_MAX_SLOTS, updated atomically
+    bench_producer_t producer[BENCH_MAX_THREADS];
+    LatencyHistogram* latency;
+};
+
+typedef struct {
+    char name[96];
+    const char* transport;
+    const char* plan;
+    uint32_t producers;
+    uint32_t consumers;
+    uint32_t size;
+    uint64_t rate;
+    bool pinned;
+    double seconds;
+    uint64_t messages;
+    double msgs_per_sec;
+    double mb_per_sec;
+    uint64_t retries;
+    uint64_t lost;
+    uint64_t corrupt;
+    LatencySummary latency;
+} bench_result_t;
+
+typedef struct {
+    const char* transports;     // Comma separated filter, NULL for all
+    uint32_t producers[BENCH_MAX_LIST], producer_count;
+    uint32_t consumers[BENCH_MAX_LIST], consumer_count;
+    uint32_t sizes[BENCH_MAX_LIST], size_count;
+    uint64_t rates[BENCH_MAX_LIST];
+    uint32_t rate_count;
+    double duration;
+    double warmup;
+    bool pin;
+    const char* json;
+} bench_options_t;
+
+static atomic_uint_fast64_t bench_run_ids = 1;
+static _Thread_local uint64_t bench_tls_run;
+static _Thread_local bench_slot_t* bench_tls_slot;
+
+// ============================================================================
+// Threads
+// ============================================================================
+
+static bool thread_start(bench_thread_t* thread, THREAD_RETURN_TYPE (*fn)(void*), void* arg) {
+#ifdef _WIN32
+    *thread = (HANDLE)_beginthreadex(NULL, 0, fn, arg, 0, NULL);
+    return *thread != NULL;
+#else
+    return pthread_create(thread, NULL, fn, arg) == 0;
+#endif
+}
+
+static void thread_join(bench_thread_t thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+static void thread_yield(void) {
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+static void sleep_ns(uint64_t ns) {
+#ifdef _WIN32
+    Sleep((DWORD)(ns / 1000000));
+#else
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+/* Pin the calling thread to the `slot`th CPU of the run's placement. */
+static void pin_self(const bench_run_t* run, uint32_t slot) {
+    if (!run->pin || run->cpu_count == 0) return;
+    uint32_t cpu = run->cpus[slot % run->cpu_count];
+#if defined(_WIN32)
+    GROUP_AFFINITY affinity;
+    memset(&affinity, 0, sizeof(affinity));
+    affinity.Mask = (KAFFINITY)1 << (cpu % 64);
+    affinity.Group = (WORD)(cpu / 64);
+    SetThreadGroupAffinity(GetCurrentThread(), &affinity, NULL);
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+static void wait_for_go(bench_run_t* run) {
+    atomic_fetch_add(&run->ready, 1);
+    while (!atomic_load_explicit(&run->go, memory_order_acquire)) {
+        bench_cpu_relax();
+    }
+}
+
+// ============================================================================
+// Producers and consumers
+// ============================================================================
+
+static inline void counter_add(atomic_uint_fast64_t* counter, uint64_t n) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+static bench_slot_t* consumer_slot(bench_run_t* run) {
+    if (bench_tls_run == run->id) return bench_tls_slot;
+    uint32_t index = atomic_fetch_add(&run->slot_count, 1);
+    bench_tls_slot = index < BENCH_MAX_SLOTS ? &run->slots[index] : NULL;
+    bench_tls_run = run->id;
+    return bench_tls_slot;
+}
+
+void bench_consume(bench_run_t* run, const void* data, size_t size) {
+    bench_slot_t* slot = consumer_slot(run);
+    bench_header_t header;
+    bool intact = size >= sizeof(header);
+    bool measured = false;
+    if (intact) {
+        memcpy(&header, data, sizeof(header));
+        intact = header.producer < run->producers;
+        measured = intact && header.stamp_ns >= run->measure_ns;
+    }
+    if (measured) {
+        uint64_t now = umsbb_clock_ns();
+        latency_histogram_record(run->latency, now > header.stamp_ns ? now - header.stamp_ns : 0);
+    }
+    if (slot) {
+        counter_add(&slot->consumed, 1);
+        counter_add(&slot->bytes, size);
+        if (measured) counter_add(&slot->measured, 1);
+        if (!intact) counter_add(&slot->corrupt, 1);
+    } else {
+        atomic_fetch_add_explicit(&run->shared.consumed, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&run->shared.bytes, size, memory_order_relaxed);
+        if (measured) atomic_fetch_add_explicit(&run->shared.measured, 1, memory_order_relaxed);
+        if (!intact) atomic_fetch_add_explicit(&run->shared.corrupt, 1, memory_order_relaxed);
+    }
+}
+
+/* Send one message, retrying while the transport is full. */
+static bool send_one(bench_run_t* run, bench_producer_t* p, uint64_t stamp) {
+    bench_header_t header = { stamp, p->index, (uint32_t)p->sent };
+    memcpy(p->message, &header, sizeof(header));
+    while (!run->transport->send(run->ctx, p->index, p->message, run->size)) {
+        p->retries++;
+        if (atomic_load_explicit(&run->abandon, memory_order_relaxed)) return false;
+        bench_cpu_relax();
+    }
+    p->sent++;
+    return true;
+}
+
+static THREAD_RETURN_TYPE producer_main(void* arg) {
+    bench_producer_t* p = (bench_producer_t*)arg;
+    bench_run_t* run = p->run;
+    pin_self(run, p->index);
+    wait_for_go(run);
+
+    if (run->rate == 0) {
+        for (;;) {
+            uint64_t now = umsbb_clock_ns();
+            if (now >= run->stop_ns || !send_one(run, p, now)) break;
+        }
+    } else {
+        // Producer i of n sends at start + (k + i/n) * interval, so the
+        // producers interleave instead of bursting together
+        double interval = 1e9 * run->producers / (double)run->rate;
+        double offset = interval * p->index / run->producers;
+        for (uint64_t k = 0;; k++) {
+            uint64_t intended = run->start_ns + (uint64_t)(offset + interval * (double)k);
+            if (intended >= run->stop_ns) break;
+            while (umsbb_clock_ns() < intended) {
+                bench_cpu_relax();
+            }
+            if (!send_one(run, p, intended)) break;
+        }
+    }
+    atomic_fetch_sub(&run->producing, 1);
+    return 0;
+}
+
+typedef struct {
+    bench_run_t* run;
+    uint32_t index;
+} bench_consumer_t;
+
+static THREAD_RETURN_TYPE consumer_main(void* arg) {
+    bench_consumer_t* c = (bench_consumer_t*)arg;
+    bench_run_t* run = c->run;
+    pin_self(run, run->producers + c->index);
+    wait_for_go(run);
+
+    uint32_t idle = 0;
+    while (!atomic_load_explicit(&run->done, memory_order_relaxed)) {
+        if (run->transport->poll(run->ctx, c->index, run) > 0) {
+            idle = 0;
+        } else if (++idle >= BENCH_IDLE_SPINS) {
+            idle = 0;
+            thread_yield();
+        } else {
+            bench_cpu_relax();
+        }
+    }
+    return 0;
+}
+
+static uint64_t slots_total(bench_run_t* run, size_t field) {
+    uint64_t total = 0;
+    for (uint32_t i = 0; i <= BENCH_MAX_SLOTS; i++) {
+        bench_slot_t* slot = i < BENCH_MAX_SLOTS ? &run->slots[i] : &run->shared;
+        total += atomic_load_explicit((atomic_uint_fast64_t*)((char*)slot + field), memory_order_relaxed);
+    }
+    return total;
+}
+
+// ============================================================================
+// Runs
+// ============================================================================
+
+/* What --compare matches runs by. */
+static void result_name(char* out, size_t len, const bench_transport_t* transport, uint32_t producers,
+                        uint32_t consumers, uint32_t size, uint64_t rate) {
+    if (rate == 0) {
+        snprintf(out, len, "%s/p%uc%u/%uB/closed", transport->name, producers, consumers, size);
+    } else {
+        snprintf(out, len, "%s/p%uc%u/%uB/rate%llu", transport->name, producers, consumers, size,
+                 (unsigned long long)rate);
+    }
+}
+
+/* Zeroed and cache-line aligned for the per-thread slots. */
+static bench_run_t* run_alloc(void) {
+#ifdef _WIN32
+    bench_run_t* run = _aligned_malloc(sizeof(bench_run_t), 64);
+#else
+    bench_run_t* run = NULL;
+    if (posix_memalign((void**)&run, 64, sizeof(bench_run_t)) != 0) run = NULL;
+#endif
+    if (run) memset(run, 0, sizeof(*run));
+    return run;
+}
+
+static void run_free(bench_run_t* run) {
+#ifdef _WIN32
+    _aligned_free(run);
+#else
+    free(run);
+#endif
+}
+
+static bool run_one(const bench_transport_t* transport, const bench_options_t* options, const uint32_t* cpus,
+                    uint32_t cpu_count, uint32_t producers, uint32_t consumers, uint32_t size, uint64_t rate,
+                    bench_result_t* result) {
+    bench_run_t* run = run_alloc();
+    if (!run) return false;
+    run->transport = transport;
+    run->id = atomic_fetch_add(&bench_run_ids, 1);
+    run->producers = producers;
+    run->consumers = consumers;
+    run->size = size;
+    run->rate = rate;
+    run->pin = options->pin;
+    run->cpus = cpus;
+    run->cpu_count = cpu_count;
+    run->latency = latency_histogram_create();
+    run->ctx = run->latency ? transport->create(producers, consumers, size, run) : NULL;
+    if (!run->ctx) {
+        latency_histogram_destroy(run->latency);
+        run_free(run);
+        return false;
+    }
+
+    bench_thread_t threads[2 * BENCH_MAX_THREADS];
+    bench_consumer_t consumer[BENCH_MAX_THREADS];
+    uint32_t started = 0;
+    bool ok = true;
+    // Producers and consumers start with go unset and are ready once they spin
+    for (uint32_t i = 0; i < producers && ok; i++) {
+        bench_producer_t* p = &run->producer[i];
+        p->run = run;
+        p->index = i;
+        p->message = malloc(size);
+        if (!p->message) { ok = false; break; }
+        for (uint32_t b = 0; b < size; b++) p->message[b] = (uint8_t)(b * 31 + i);
+        atomic_fetch_add(&run->producing, 1);
+        if (!thread_start(&threads[started], producer_main, p)) {
+            atomic_fetch_sub(&run->producing, 1);
+            ok = false;
+            break;
+        }
+        started++;
+    }
+    uint32_t polling = transport->poll ? consumers : 0;
+    for (uint32_t i = 0; i < polling && ok; i++) {
+        consumer[i].run = run;
+        consumer[i].index = i;
+        if (!thread_start(&threads[started], consumer_main, &consumer[i])) { ok = false; break; }
+        started++;
+    }
+    while (atomic_load(&run->ready) < started) {
+        thread_yield();
+    }
+
+    uint64_t now = umsbb_clock_ns();
+    run->start_ns = now + 1000000;     // Leave the threads a moment to see go
+    run->measure_ns = run->start_ns + (uint64_t)(options->warmup * 1e9);
+    run->stop_ns = run->measure_ns + (uint64_t)(options->duration * 1e9);
+    if (!ok) {
+        run->stop_ns = run->start_ns; // Tear down what did start
+        atomic_store(&run->abandon, true);
+    }
+    atomic_store_explicit(&run->go, true, memory_order_release);
+
+    // Producers are the first `started` threads up to `producers`
+    uint32_t producer_threads = started < producers ? started : producers;
+    while (umsbb_clock_ns() < run->stop_ns) {
+        sleep_ns(1000000);
+    }
+    // A transport that stays full, with no consumer making progress, must
+    // not hang the suite: past the timeout producers drop their last message
+    uint64_t abandon_at = umsbb_clock_ns() + BENCH_DRAIN_TIMEOUT_NS;
+    while (atomic_load(&run->producing) > 0) {
+        if (umsbb_clock_ns() >= abandon_at) atomic_store(&run->abandon, true);
+        sleep_ns(100000);
+    }
+    for (uint32_t i = 0; i < producer_threads; i++) {
+        thread_join(threads[i]);
+    }
+    uint64_t sent = 0;
+    for (uint32_t i = 0; i < producers; i++) {
+        sent += run->producer[i].sent;
+    }
+
+    // Drain phase: consumers keep going until everything sent has arrived
+    uint64_t consumed_field = offsetof(bench_slot_t, consumed);
+    uint64_t drain_deadline = umsbb_clock_ns() + BENCH_DRAIN_TIMEOUT_NS;
+    uint64_t consumed = slots_total(run, consumed_field);
+    while (consumed < sent && umsbb_clock_ns() < drain_deadline) {
+        sleep_ns(100000);
+        consumed = slots_total(run, consumed_field);
+    }
+    uint64_t end_ns = umsbb_clock_ns();
+    atomic_store(&run->done, true);
+    for (uint32_t i = producer_threads; i < started; i++) {
+        thread_join(threads[i]);
+    }
+
+    memset(result, 0, sizeof(*result));
+    result->transport = transport->name;
+    result->producers = producers;
+    result->consumers = consumers;
+    result->size = size;
+    result->rate = rate;
+    result->pinned = options->pin;
+    result->seconds = (double)(end_ns - run->measure_ns) / 1e9;
+    result->messages = slots_total(run, offsetof(bench_slot_t, measured));
+    result->msgs_per_sec = result->seconds > 0 ? (double)result->messages / result->seconds : 0;
+    result->mb_per_sec = result->msgs_per_sec * size / (1024.0 * 1024.0);
+    result->lost = consumed < sent ? sent - consumed : 0;
+    result->corrupt = slots_total(run, offsetof(bench_slot_t, corrupt));
+    for (uint32_t i = 0; i < producers; i++) {
+        result->retries += run->producer[i].retries;
+    }
+    latency_histogram_summary(run->latency, &result->latency);
+    result_name(result->name, sizeof(result->name), transport, producers, consumers, size, rate);
+
+    transport->destroy(run->ctx);
+    for (uint32_t i = 0; i < producers; i++) {
+        free(run->producer[i].message);
+    }
+    latency_histogram_destroy(run->latency);
+    run_free(run);
+    return ok;
+}
+
+// ============================================================================
+// Reporting
+// ============================================================================
+
+static void format_ns(char* out, size_t len, uint64_t ns) {
+    if (ns < 10000) snprintf(out, len, "%llu ns", (unsigned long long)ns);
+    else if (ns < 10000000) snprintf(out, len, "%.1f us", ns / 1e3);
+    else snprintf(out, len, "%.1f ms", ns / 1e6);
+}
+
+static void print_header(void) {
+    printf("%-16s %3s %3s %7s %10s %12s %10s %10s %10s %10s %10s  %s\n", "transport", "P", "C", "size", "load",
+           "msg/s", "MB/s", "p50", "p99", "p99.9", "max", "notes");
+}
+
+static void print_result(const bench_result_t* r) {
+    char load[24], p50[16], p99[16], p999[16], max[16], notes[96] = "";
+    if (r->rate == 0) snprintf(load, sizeof(load), "closed");
+    else snprintf(load, sizeof(load), "%.0fk/s", r->rate / 1e3);
+    format_ns(p50, sizeof(p50), r->latency.p50Ns);
+    format_ns(p99, sizeof(p99), r->latency.p99Ns);
+    format_ns(p999, sizeof(p999), r->latency.p999Ns);
+    format_ns(max, sizeof(max), r->latency.maxNs);
+    size_t n = 0;
+    if (r->lost) n += snprintf(notes + n, sizeof(notes) - n, "lost %llu ", (unsigned long long)r->lost);
+    if (r->corrupt) n += snprintf(notes + n, sizeof(notes) - n, "corrupt %llu ", (unsigned long long)r->corrupt);
+    if (r->rate && r->msgs_per_sec < 0.95 * r->rate) snprintf(notes + n, sizeof(notes) - n, "below target rate");
+    printf("%-16s %3u %3u %6uB %10s %12.0f %10.1f %10s %10s %10s %10s  %s\n", r->transport, r->producers,
+           r->consumers, r->size, load, r->msgs_per_sec, r->mb_per_sec, p50, p99, p999, max, notes);
+    fflush(stdout);
+}
+
+/* One result object per line, so --compare can read files without a JSON parser. */
+static void write_result_json(FILE* f, const bench_result_t* r, bool last) {
+    fprintf(f,
+            "    {\"name\": \"%s\", \"plan\": \"%s\", \"transport\": \"%s\", \"producers\": %u, \"consumers\": %u, "
+            "\"size\": %u, \"rate\": %llu, \"pinned\": %s, \"seconds\": %.6f, \"messages\": %llu, "
+            "\"msgs_per_sec\": %.1f, \"mb_per_sec\": %.3f, \"send_retries\": %llu, \"lost\": %llu, "
+            "\"corrupt\": %llu, \"mean_ns\": %.1f, \"min_ns\": %llu, \"p50_ns\": %llu, \"p90_ns\": %llu, "
+            "\"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu}%s\n",
+            r->name, r->plan, r->transport, r->producers, r->consumers, r->size, (unsigned long long)r->rate,
+            r->pinned ? "true" : "false", r->seconds, (unsigned long long)r->messages, r->msgs_per_sec,
+            r->mb_per_sec, (unsigned long long)r->retries, (unsigned long long)r->lost,
+            (unsigned long long)r->corrupt, r->latency.meanNs, (unsigned long long)r->latency.minNs,
+            (unsigned long long)r->latency.p50Ns, (unsigned long long)r->latency.p90Ns,
+            (unsigned long long)r->latency.p99Ns, (unsigned long long)r->latency.p999Ns,
+            (unsigned long long)r->latency.maxNs, last ? "" : ",");
+}
+
+static bool write_json(const char* path, const char* suite, const bench_options_t* options,
+                       const cpu_topology_t* topology, const bench_result_t* results, size_t count) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "❌ Cannot write %s\n", path);
+        return false;
+    }
+    fprintf(f, "{\n  \"suite\": \"%s\",\n  \"timestamp\": %llu,\n", suite, (unsigned long long)time(NULL));
+    fprintf(f, "  \"cpus\": %u,\n  \"cores\": %u,\n  \"nodes\": %u,\n", topology->cpu_count, topology->core_count,
+            topology->node_count);
+    fprintf(f, "  \"duration_s\": %.3f,\n  \"warmup_s\": %.3f,\n  \"pinned\": %s,\n", options->duration,
+            options->warmup, options->pin ? "true" : "false");
+    fprintf(f, "  \"results\": [\n");
+    for (size_t i = 0; i < count; i++) {
+        write_result_json(f, &results[i], i + 1 == count);
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+// ============================================================================
+// Baseline comparison
+// ============================================================================
+
+typedef struct {
+    char name[96];
+    double msgs_per_sec;
+    double p99_ns;
+} bench_entry_t;
+
+static bool json_string(const char* line, const char* key, char* out, size_t len) {
+    char pattern[48];
+    snprintf(pattern, sizeof(pattern), "\"%s\": \"", key);
+    const char* p = strstr(line, pattern);
+    if (!p) return false;
+    p += strlen(pattern);
+    const char* end = strchr(p, '"');
+    if (!end || (size_t)(end - p) >= len) return false;
+    memcpy(out, p, (size_t)(end - p));
+    out[end - p] = '\0';
+    return true;
+}
+
+static bool json_number(const char* line, const char* key, double* out) {
+    char pattern[48];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char* p = strstr(line, pattern);
+    if (!p) return false;
+    *out = strtod(p + strlen(pattern), NULL);
+    return true;
+}
+
+/* The results of a file written by --json; NULL if unreadable. */
+static bench_entry_t* load_results(const char* path, size_t* count) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "❌ Cannot read %s\n", path);
+        return NULL;
+    }
+    size_t cap = 64;
+    bench_entry_t* entries = malloc(cap * sizeof(*entries));
+    char line[2048];
+    *count = 0;
+    while (entries && fgets(line, sizeof(line), f)) {
+        bench_entry_t e;
+        if (!json_string(line, "name", e.name, sizeof(e.name)) || !json_number(line, "msgs_per_sec", &e.msgs_per_sec) ||
+            !json_number(line, "p99_ns", &e.p99_ns)) {
+            continue;
+        }
+        if (*count == cap) {
+            bench_entry_t* grown = realloc(entries, 2 * cap * sizeof(*entries));
+            if (!grown) break;
+            entries = grown;
+            cap *= 2;
+        }
+        entries[(*count)++] = e;
+    }
+    fclose(f);
+    return entries;
+}
+
+static int compare_files(const char* base_path, const char* current_path, double threshold, double latency_threshold) {
+    size_t base_count = 0, current_count = 0;
+    bench_entry_t* base = load_results(base_path, &base_count);
+    bench_entry_t* current = base ? load_results(current_path, &current_count) : NULL;
+    if (!base || !current) {
+        free(base);
+        return 2;
+    }
+
+    printf("Comparing %s (base) with %s: regression past -%.0f%% msg/s or +%.0f%% p99\n\n", base_path, current_path,
+           threshold, latency_threshold);
+    printf("%-40s %12s %12s %8s %10s %10s %8s\n", "run", "base msg/s", "msg/s", "delta", "base p99", "p99", "delta");
+    uint32_t regressions = 0, missing = 0;
+    for (size_t i = 0; i < current_count; i++) {
+        const bench_entry_t* now = &current[i];
+        const bench_entry_t* then = NULL;
+        for (size_t j = 0; j < base_count && !then; j++) {
+            if (strcmp(base[j].name, now->name) == 0) then = &base[j];
+        }
+        if (!then) {
+            printf("%-40s %12s %12.0f\n", now->name, "new", now->msgs_per_sec);
+            continue;
+        }
+        double rate_delta = then->msgs_per_sec > 0 ? 100.0 * (now->msgs_per_sec / then->msgs_per_sec - 1.0) : 0;
+        double p99_delta = then->p99_ns > 0 ? 100.0 * (now->p99_ns / then->p99_ns - 1.0) : 0;
+        bool slower = rate_delta < -threshold;
+        bool later = p99_delta > latency_threshold;
+        printf("%-40s %12.0f %12.0f %+7.1f%% %10.0f %10.0f %+7.1f%% %s\n", now->name, then->msgs_per_sec,
+               now->msgs_per_sec, rate_delta, then->p99_ns, now->p99_ns, p99_delta,
+               slower || later ? "❌ regression" : "");
+        if (slower || later) regressions++;
+    }
+    for (size_t j = 0; j < base_count; j++) {
+        bool found = false;
+        for (size_t i = 0; i < current_count && !found; i++) {
+            found = strcmp(base[j].name, current[i].name) == 0;
+        }
+        if (!found) {
+            printf("%-40s missing from %s\n", base[j].name, current_path);
+            missing++;
+        }
+    }
+
+    printf("\n%s %u regression(s), %u run(s) missing\n", regressions ? "❌" : "✅", regressions, missing);
+    free(base);
+    free(current);
+    return regressions ? 1 : 0;
+}
+
+// ============================================================================
+// Command line
+// ============================================================================
+
+static void usage(const char* program, const bench_transport_t* transports, size_t transport_count) {
+    printf("Usage: %s [options]\n"
+           "       %s --compare BASE.json CURRENT.json [--threshold PCT] [--latency-threshold PCT]\n\n"
+           "  --transport a,b      Only these transports\n"
+           "  --producers 1,2,4    Producer thread counts\n"
+           "  --consumers 1,2      Consumer thread counts\n"
+           "  --sizes 64,1024      Message sizes in bytes (at least %u)\n"
+           "  --rates 0,100000     Messages a second over all producers; 0 runs closed loop\n"
+           "  --duration S         Measured seconds per run (default 1)\n"
+           "  --warmup S           Unmeasured seconds before that (default 0.2)\n"
+           "  --pin                Pin threads, spread over physical cores first\n"
+           "  --json FILE          Write the results as JSON\n"
+           "  --list               List transports and plans\n\n"
+           "Transports:\n",
+           program, program, (unsigned)sizeof(bench_header_t));
+    for (size_t i = 0; i < transport_count; i++) {
+        printf("  %-16s %s\n", transports[i].name, transports[i].description);
+    }
+}
+
+static bool parse_list(const char* text, uint64_t* out, uint32_t* count) {
+    *count = 0;
+    while (*text) {
+        char* end;
+        unsigned long long value = strtoull(text, &end, 10);
+        if (end == text || *count == BENCH_MAX_LIST) return false;
+        out[(*count)++] = value;
+        if (*end == ',') end++;
+        else if (*end) return false;
+        text = end;
+    }
+    return *count > 0;
+}
+
+static bool parse_list32(const char* text, uint32_t* out, uint32_t* count) {
+    uint64_t values[BENCH_MAX_LIST];
+    if (!parse_list(text, values, count)) return false;
+    for (uint32_t i = 0; i < *count; i++) {
+        if (values[i] > UINT32_MAX) return false;
+        out[i] = (uint32_t)values[i];
+    }
+    return true;
+}
+
+static bool transport_selected(const char* filter, const char* name) {
+    if (!filter) return true;
+    size_t len = strlen(name);
+    for (const char* p = filter; *p;) {
+        const char* end = strchr(p, ',');
+        size_t n = end ? (size_t)(end - p) : strlen(p);
+        if (n == len && strncmp(p, name, len) == 0) return true;
+        p += n + (end ? 1 : 0);
+    }
+    return false;
+}
+
+static bool shape_supported(const bench_transport_t* t, uint32_t producers, uint32_t consumers, uint32_t size) {
+    if (producers == 0 || consumers == 0 || producers > BENCH_MAX_THREADS || consumers > BENCH_MAX_THREADS) return false;
+    if (t->max_producers && producers > t->max_producers) return false;
+    if (t->max_consumers && consumers > t->max_consumers) return false;
+    return t->max_message == 0 || size <= t->max_message;
+}
+
+/* Plans overridden from the command line can repeat a run. */
+static bool already_run(const bench_result_t* results, size_t count, const bench_transport_t* transport,
+                        uint32_t producers, uint32_t consumers, uint32_t size, uint64_t rate) {
+    char name[sizeof(results->name)];
+    result_name(name, sizeof(name), transport, producers, consumers, size, rate);
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(results[i].name, name) == 0) return true;
+    }
+    return false;
+}
+
+int bench_main(int argc, char** argv, const char* suite, const bench_transport_t* transports, size_t transport_count,
+               const bench_plan_t* plans, size_t plan_count) {
+    bench_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.duration = 1.0;
+    options.warmup = 0.2;
+    const char* compare[2] = { NULL, NULL };
+    double threshold = 10.0, latency_threshold = 25.0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool ok = true;
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            usage(argv[0], transports, transport_count);
+            return 0;
+        } else if (strcmp(arg, "--list") == 0) {
+            for (size_t t = 0; t < transport_count; t++) {
+                printf("%-16s %s\n", transports[t].name, transports[t].description);
+            }
+            for (size_t p = 0; p < plan_count; p++) {
+                printf("plan %s\n", plans[p].label);
+            }
+            return 0;
+        } else if (strcmp(arg, "--pin") == 0) {
+            options.pin = true;
+            continue;
+        } else if (strcmp(arg, "--compare") == 0) {
+            if (i + 2 >= argc) ok = false;
+            else {
+                compare[0] = argv[++i];
+                compare[1] = argv[++i];
+            }
+        } else if (!value) {
+            ok = false;
+        } else if (strcmp(arg, "--transport") == 0) {
+            options.transports = value;
+        } else if (strcmp(arg, "--producers") == 0) {
+            ok = parse_list32(value, options.producers, &options.producer_count);
+        } else if (strcmp(arg, "--consumers") == 0) {
+            ok = parse_list32(value, options.consumers, &options.consumer_count);
+        } else if (strcmp(arg, "--sizes") == 0) {
+            ok = parse_list32(value, options.sizes, &options.size_count);
+        } else if (strcmp(arg, "--rates") == 0) {
+            ok = parse_list(value, options.rates, &options.rate_count);
+        } else if (strcmp(arg, "--duration") == 0) {
+            options.duration = atof(value);
+            ok = options.duration > 0;
+        } else if (strcmp(arg, "--warmup") == 0) {
+            options.warmup = atof(value);
+            ok = options.warmup >= 0;
+        } else if (strcmp(arg, "--json") == 0) {
+            options.json = value;
+        } else if (strcmp(arg, "--threshold") == 0) {
+            threshold = atof(value);
+        } else if (strcmp(arg, "--latency-threshold") == 0) {
+            latency_threshold = atof(value);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            fprintf(stderr, "❌ Bad argument %s (see --help)\n", arg);
+            return 2;
+        }
+        if (value && strcmp(arg, "--compare") != 0) i++;
+    }
+    if (compare[0]) {
+        return compare_files(compare[0], compare[1], threshold, latency_threshold);
+    }
+
+    umsbb_clock_init();
+    cpu_topology_t* topology = malloc(sizeof(cpu_topology_t));
+    if (!topology) return 2;
+    cpu_topology_discover(topology);
+    uint32_t cpus[CPU_TOPOLOGY_MAX_CPUS];
+    uint32_t cpu_count = cpu_topology_spread(topology, cpus, CPU_TOPOLOGY_MAX_CPUS);
+#if !defined(_WIN32) && !defined(__linux__)
+    if (options.pin) printf("⚠️  Thread pinning is not supported here; running unpinned\n");
+#endif
+
+    printf("🚀 UMSBB %s benchmark: %u CPUs, %u cores, %u node(s), %.1f s per run after %.1f s warmup%s\n\n", suite,
+           topology->cpu_count, topology->core_count, topology->node_count, options.duration, options.warmup,
+           options.pin ? ", pinned" : "");
+
+    size_t result_cap = 64, result_count = 0;
+    bench_result_t* results = malloc(result_cap * sizeof(bench_result_t));
+    uint32_t failures = 0;
+    for (size_t p = 0; p < plan_count && results; p++) {
+        bench_plan_t plan = plans[p];
+        if (options.producer_count) {
+            memcpy(plan.producers, options.producers, sizeof(plan.producers));
+            plan.producer_count = options.producer_count;
+        }
+        if (options.consumer_count) {
+            memcpy(plan.consumers, options.consumers, sizeof(plan.consumers));
+            plan.consumer_count = options.consumer_count;
+        }
+        if (options.size_count) {
+            memcpy(plan.sizes, options.sizes, sizeof(plan.sizes));
+            plan.size_count = options.size_count;
+        }
+        if (options.rate_count) {
+            memcpy(plan.rates, options.rates, sizeof(plan.rates));
+            plan.rate_count = options.rate_count;
+        }
+
+        printf("== %s ==\n", plan.label);
+        print_header();
+        for (size_t t = 0; t < transport_count; t++) {
+            const bench_transport_t* transport = &transports[t];
+            if (!transport_selected(options.transports, transport->name)) continue;
+            for (uint32_t pi = 0; pi < plan.producer_count; pi++) {
+                for (uint32_t ci = 0; ci < plan.consumer_count; ci++) {
+                    for (uint32_t si = 0; si < plan.size_count; si++) {
+                        for (uint32_t ri = 0; ri < plan.rate_count; ri++) {
+                            uint32_t producers = plan.producers[pi], consumers = plan.consumers[ci];
+                            uint32_t size = plan.sizes[si];
+                            if (size < sizeof(bench_header_t) ||
+                                !shape_supported(transport, producers, consumers, size) ||
+                                already_run(results, result_count, transport, producers, consumers, size,
+                                            plan.rates[ri])) {
+                                continue;
+                            }
+                            if (result_count == result_cap) {
+                                bench_result_t* grown = realloc(results, 2 * result_cap * sizeof(bench_result_t));
+                                if (!grown) break;
+                                results = grown;
+                                result_cap *= 2;
+                            }
+                            bench_result_t* r = &results[result_count];
+                            if (!run_one(transport, &options, cpus, cpu_count, producers, consumers, size,
+                                         plan.rates[ri], r)) {
+                                printf("%-16s %3u %3u %6uB  ❌ could not set up\n", transport->name, producers,
+                                       consumers, size);
+                                failures++;
+                                continue;
+                            }
+                            r->plan = plan.label;
+                            if (r->lost || r->corrupt) failures++;
+                            print_result(r);
+                            result_count++;
+                        }
+                    }
+                }
+            }
+        }
+        printf("\n");
+    }
+
+    int status = failures ? 1 : 0;
+    if (options.json && results && !write_json(options.json, suite, &options, topology, results, result_count)) {
+        status = 2;
+    } else if (options.json) {
+        printf("📄 Results written to %s\n", options.json);
+    }
+    free(results);
+    free(topology);
+    return status;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+Benchmark Harness
+
+Runs N producer threads against M consumers over a transport and reports
+throughput and the send-to-consume latency distribution of every message.
+
+Every message starts with a bench_header_t. In a closed-loop run (rate 0)
+producers send as fast as the transport accepts, retrying while it is full,
+and stamp each message when they send it. In an open-loop run each producer
+sends on a fixed schedule, rate / producers messages a second, and stamps
+the time the schedule says it should have gone out rather than when it did:
+a producer that stalls behind a full queue is charged for the messages it
+could not send, so the histogram is not hiding the stall (coordinated
+omission). Throughput counts only messages stamped after the warmup.
+
+After the measured period producers stop and consumers drain what is left;
+messages that never arrive within BENCH_DRAIN_TIMEOUT_NS are reported lost.
+
+Transports that deliver from threads of their own (a worker pool) leave
+poll NULL and call bench_consume from those threads; everything else is
+polled by the harness's consumer threads, consumer i calling poll(ctx, i).
+*/
+
+#define BENCH_MAX_THREADS 64
+#define BENCH_MAX_LIST 16
+#define BENCH_MAX_PLANS 8
+#define BENCH_DRAIN_TIMEOUT_NS 5000000000ull
+
+typedef struct {
+    uint64_t stamp_ns;      // Send time (closed loop) or scheduled send time (open loop)
+    uint32_t producer;
+    uint32_t sequence;      // Per producer, from 0
+} bench_header_t;
+
+typedef struct bench_run bench_run_t;
+
+typedef struct {
+    const char* name;
+    const char* description;
+    uint32_t max_producers;     // 0: no limit besides BENCH_MAX_THREADS
+    uint32_t max_consumers;
+    size_t max_message;         // 0: no limit
+    // Build a transport for `producers` x `consumers` and messages of up to
+    // `message_size` bytes; NULL if that shape is not supported
+    void* (*create)(uint32_t producers, uint32_t consumers, size_t message_size, bench_run_t* run);
+    // One attempt; false when the transport is full
+    bool (*send)(void* ctx, uint32_t producer, const void* data, size_t size);
+    // Hand whatever is ready for `consumer` to bench_consume; returns how many
+    size_t (*poll)(void* ctx, uint32_t consumer, bench_run_t* run);
+    void (*destroy)(void* ctx);
+} bench_transport_t;
+
+/* The shapes a suite runs: every producer count x consumer count x size x
+ * rate, for every transport that supports it. Command line lists replace
+ * the matching list of every plan. */
+typedef struct {
+    const char* label;
+    uint32_t producers[BENCH_MAX_LIST];
+    uint32_t producer_count;
+    uint32_t consumers[BENCH_MAX_LIST];
+    uint32_t consumer_count;
+    uint32_t sizes[BENCH_MAX_LIST];
+    uint32_t size_count;
+    uint64_t rates[BENCH_MAX_LIST];     // Messages a second over all producers; 0: closed loop
+    uint32_t rate_count;
+} bench_plan_t;
+
+/* Account for one consumed message; any thread. */
+void bench_consume(bench_run_t* run, const void* data, size_t size);
+
+/* Suite driver: parses the command line (--help lists it), runs the plans
+ * and prints a table, optionally writing JSON. Returns the exit status. */
+int bench_main(int argc, char** argv, const char* suite, const bench_transport_t* transports, size_t transport_count,
+               const bench_plan_t* plans, size_t plan_count);
+
+/* Transports over the bus library (bench_transports.c). */
+extern const bench_transport_t bench_bus_transports[];
+extern const size_t bench_bus_transport_count;
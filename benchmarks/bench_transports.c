@@ -0,0 +1,304 @@
+/*
+ * Benchmark transports over the bus library: raw BiBuffers, the bus's ring
+ * lanes, a fast lane, twin lanes and the parallel engine
+ */
+
+#include "bench_harness.h"
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include "../include/bi_buffer.h"
+#include "../include/fast_lane.h"
+#include "../include/twin_lane.h"
+#include "../include/message_pool.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_POLL_BATCH 64
+#define BENCH_RING_BYTES (4u * 1024 * 1024)
+
+/* Room for a few thousand messages whatever the size. */
+static size_t ring_bytes(size_t message_size) {
+    size_t bytes = BENCH_RING_BYTES;
+    while (bytes < message_size * 2048) bytes *= 2;
+    return bytes;
+}
+
+// ============================================================================
+// BiBuffer: one ring per consumer, producer i writing to ring i % consumers,
+// SPSC unless rings are shared by producers
+// ============================================================================
+
+typedef struct {
+    uint32_t count;
+    size_t size;
+    BiBuffer* rings[BENCH_MAX_THREADS];
+} bibuffer_bench_t;
+
+static void bibuffer_destroy(void* ctx) {
+    bibuffer_bench_t* b = ctx;
+    for (uint32_t i = 0; i < b->count; i++) {
+        bi_buffer_free(b->rings[i]);
+    }
+    free(b);
+}
+
+static void* bibuffer_create(uint32_t producers, uint32_t consumers, size_t size, bench_run_t* run) {
+    (void)run;
+    bibuffer_bench_t* b = calloc(1, sizeof(*b));
+    if (!b) return NULL;
+    BiBufferMode mode = producers > consumers ? BI_BUFFER_MODE_MPSC : BI_BUFFER_MODE_SPSC;
+    b->size = size;
+    for (; b->count < consumers; b->count++) {
+        b->rings[b->count] = bi_buffer_create(ring_bytes(size), mode);
+        if (!b->rings[b->count]) {
+            bibuffer_destroy(b);
+            return NULL;
+        }
+    }
+    return b;
+}
+
+static bool bibuffer_send(void* ctx, uint32_t producer, const void* data, size_t size) {
+    bibuffer_bench_t* b = ctx;
+    BiBuffer* ring = b->rings[producer % b->count];
+    void* slot = bi_buffer_claim(ring, size);
+    if (!slot) return false;
+    memcpy(slot, data, size);
+    bi_buffer_commit(ring, slot, size);
+    return true;
+}
+
+static size_t bibuffer_poll(void* ctx, uint32_t consumer, bench_run_t* run) {
+    bibuffer_bench_t* b = ctx;
+    BiBuffer* ring = b->rings[consumer];
+    size_t cursor = bi_buffer_read_cursor(ring);
+    size_t n = 0, size;
+    void* frame;
+    while (n < BENCH_POLL_BATCH && (frame = bi_buffer_peek(ring, &cursor, &size)) != NULL) {
+        bench_consume(run, frame, size);
+        n++;
+    }
+    if (n) bi_buffer_release_to(ring, cursor);
+    return n;
+}
+
+// ============================================================================
+// Bus lanes: umsbb_submit_to into lane i % consumers, batched in-place drains
+// ============================================================================
+
+typedef struct {
+    UniversalMultiSegmentedBiBufferBus* bus;
+    uint32_t lanes;
+} lanes_bench_t;
+
+static void lanes_destroy(void* ctx) {
+    lanes_bench_t* l = ctx;
+    umsbb_free(l->bus);
+    free(l);
+}
+
+static void* lanes_create(uint32_t producers, uint32_t consumers, size_t size, bench_run_t* run) {
+    (void)run;
+    lanes_bench_t* l = calloc(1, sizeof(*l));
+    if (!l) return NULL;
+    l->lanes = consumers;
+    l->bus = umsbb_init(ring_bytes(size), consumers);
+    if (!l->bus) {
+        free(l);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < consumers && producers > consumers; i++) {
+        umsbb_configure_lane_mode(l->bus, i, BI_BUFFER_MODE_MPSC);
+    }
+    return l;
+}
+
+static bool lanes_send(void* ctx, uint32_t producer, const void* data, size_t size) {
+    lanes_bench_t* l = ctx;
+    return umsbb_submit_to(l->bus, producer % l->lanes, data, size);
+}
+
+static size_t lanes_poll(void* ctx, uint32_t consumer, bench_run_t* run) {
+    lanes_bench_t* l = ctx;
+    umsbb_msg_view views[BENCH_POLL_BATCH];
+    size_t n = umsbb_drain_batch(l->bus, consumer, views, BENCH_POLL_BATCH);
+    for (size_t i = 0; i < n; i++) {
+        bench_consume(run, views[i].data, views[i].size);
+    }
+    if (n) umsbb_release_batch(l->bus, consumer, views, n);
+    return n;
+}
+
+// ============================================================================
+// Fast lane: one MPMC express lane shared by everybody, inline slots up to
+// 4 KiB and pooled payloads beyond
+// ============================================================================
+
+static void fastlane_destroy(void* ctx) {
+    fast_lane_destroy(ctx);
+    free(ctx);
+}
+
+static void* fastlane_create(uint32_t producers, uint32_t consumers, size_t size, bench_run_t* run) {
+    (void)producers;
+    (void)consumers;
+    (void)run;
+    fast_lane_manager_t* manager = malloc(sizeof(*manager));
+    if (!manager) return NULL;
+    fast_lane_config_t config[LANE_COUNT];
+    fast_lane_default_config(config);
+    config[LANE_EXPRESS] = size <= 4096 ? (fast_lane_config_t){ 16384, size, FAST_LANE_FLAG_PREFAULT }
+                                        : (fast_lane_config_t){ 16384, size, FAST_LANE_FLAG_INDIRECT };
+    if (!fast_lane_init_ex(manager, config)) {
+        free(manager);
+        return NULL;
+    }
+    return manager;
+}
+
+static bool fastlane_send(void* ctx, uint32_t producer, const void* data, size_t size) {
+    (void)producer;
+    return fast_lane_try_submit(ctx, LANE_EXPRESS, data, size, 0);
+}
+
+static size_t fastlane_poll(void* ctx, uint32_t consumer, bench_run_t* run) {
+    (void)consumer;
+    size_t n = 0, size;
+    void* message;
+    while (n < BENCH_POLL_BATCH && (message = fast_lane_try_drain(ctx, LANE_EXPRESS, &size, NULL)) != NULL) {
+        bench_consume(run, message, size);
+        message_pool_release(message);
+        n++;
+    }
+    return n;
+}
+
+// ============================================================================
+// Twin lanes: one lane per consumer, which drains its TX ring in place and
+// acknowledges the highest sequence seen so the window keeps moving
+// ============================================================================
+
+typedef struct {
+    _Alignas(64) atomic_uint next_sequence;     // Shared by the lane's producers
+    uint32_t acked;                             // Consumer side
+    bool any;
+} twin_bench_lane_t;
+
+typedef struct {
+    twin_lane_manager_t manager;
+    uint32_t count;
+    uint32_t ids[BENCH_MAX_THREADS];
+    twin_bench_lane_t lanes[BENCH_MAX_THREADS];
+} twin_bench_t;
+
+typedef struct {
+    bench_run_t* run;
+    twin_bench_lane_t* lane;
+} twin_bench_drain_t;
+
+static void twin_destroy(void* ctx) {
+    twin_bench_t* t = ctx;
+    twin_lane_destroy(&t->manager);
+    free(t);
+}
+
+static void* twin_create(uint32_t producers, uint32_t consumers, size_t size, bench_run_t* run) {
+    (void)producers;
+    (void)run;
+    twin_bench_t* t = calloc(1, sizeof(*t));
+    if (!t || !twin_lane_init(&t->manager, consumers)) {
+        free(t);
+        return NULL;
+    }
+    for (; t->count < consumers; t->count++) {
+        t->ids[t->count] = twin_lane_create(&t->manager, t->count, ring_bytes(size), TWIN_LANE_MIN_CAPACITY);
+        if (t->ids[t->count] == UINT32_MAX) {
+            twin_destroy(t);
+            return NULL;
+        }
+    }
+    return t;
+}
+
+static bool twin_send(void* ctx, uint32_t producer, const void* data, size_t size) {
+    twin_bench_t* t = ctx;
+    uint32_t lane = producer % t->count;
+    if (!twin_lane_can_send(&t->manager, t->ids[lane])) return false;
+    uint32_t sequence = atomic_fetch_add(&t->lanes[lane].next_sequence, 1);
+    // A sequence lost to a failed send leaves a gap, which cumulative ACKs skip
+    return twin_lane_send(&t->manager, t->ids[lane], data, size, sequence);
+}
+
+static bool twin_frame(void* context, const void* data, size_t size, uint32_t sequence) {
+    twin_bench_drain_t* drain = context;
+    bench_consume(drain->run, data, size);
+    if (!drain->lane->any || (int32_t)(sequence - drain->lane->acked) > 0) {
+        drain->lane->acked = sequence;
+        drain->lane->any = true;
+    }
+    return true;
+}
+
+static size_t twin_poll(void* ctx, uint32_t consumer, bench_run_t* run) {
+    twin_bench_t* t = ctx;
+    twin_bench_drain_t drain = { run, &t->lanes[consumer] };
+    size_t n = twin_lane_drain_tx(&t->manager, t->ids[consumer], twin_frame, &drain, BENCH_POLL_BATCH);
+    if (n) twin_lane_update_flow_control(&t->manager, t->ids[consumer], drain.lane->acked);
+    return n;
+}
+
+#if UMSBB_ENABLE_PARALLEL
+// ============================================================================
+// Parallel engine: producers submit round robin over its lanes and the
+// consumers are its worker threads, which call the handler in batches
+// ============================================================================
+
+#define BENCH_PARALLEL_LANES 4
+
+static void parallel_handler(parallel_work_item_t* items, uint32_t count, void* ctx) {
+    for (uint32_t i = 0; i < count; i++) {
+        bench_consume(ctx, items[i].data, items[i].size);
+    }
+}
+
+static void parallel_destroy(void* ctx) {
+    UniversalMultiSegmentedBiBufferBus* bus = ctx;
+    umsbb_disable_parallel_processing(bus);
+    umsbb_free(bus);
+}
+
+static void* parallel_create(uint32_t producers, uint32_t consumers, size_t size, bench_run_t* run) {
+    (void)producers;
+    (void)size;
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(BENCH_RING_BYTES, 1);
+    if (!bus) return NULL;
+    if (!umsbb_enable_parallel_processing(bus, consumers, THROUGHPUT_STRATEGY_BALANCED)) {
+        umsbb_free(bus);
+        return NULL;
+    }
+    for (uint32_t lane = 0; lane < BENCH_PARALLEL_LANES; lane++) {
+        umsbb_register_parallel_handler(bus, lane, parallel_handler, run);
+    }
+    return bus;
+}
+
+static bool parallel_send(void* ctx, uint32_t producer, const void* data, size_t size) {
+    return umsbb_submit_parallel(ctx, producer % BENCH_PARALLEL_LANES, data, (uint32_t)size, 0, 0);
+}
+#endif
+
+const bench_transport_t bench_bus_transports[] = {
+    { "bibuffer", "BiBuffer rings, one per consumer (SPSC, MPSC when shared)", 0, 0, 0,
+      bibuffer_create, bibuffer_send, bibuffer_poll, bibuffer_destroy },
+    { "lanes", "Bus ring lanes: umsbb_submit_to and batched in-place drains", 0, 0, 0,
+      lanes_create, lanes_send, lanes_poll, lanes_destroy },
+    { "fast_lane", "One MPMC fast lane shared by all threads", 0, 0, FAST_LANE_INDIRECT_MAX,
+      fastlane_create, fastlane_send, fastlane_poll, fastlane_destroy },
+    { "twin_lane", "Twin lanes, TX drained in place with cumulative ACKs", 0, 0, 0,
+      twin_create, twin_send, twin_poll, twin_destroy },
+#if UMSBB_ENABLE_PARALLEL
+    { "parallel", "Parallel engine, the consumers being its worker threads", 0, UMSBB_MAX_WORKER_THREADS, 0,
+      parallel_create, parallel_send, NULL, parallel_destroy },
+#endif
+};
+const size_t bench_bus_transport_count = sizeof(bench_bus_transports) / sizeof(bench_bus_transports[0]);
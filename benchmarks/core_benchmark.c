@@ -0,0 +1,71 @@
+/*
+ * Complete core benchmark: the exported C API (umsbb_api.h) with producers
+ * writing through umsbb_write_message and consumers borrowing messages with
+ * umsbb_peek_message, over message sizes, thread counts and fixed rates.
+ * Built separately from the bus library, whose symbols it would clash with.
+ */
+
+#include "bench_harness.h"
+#include "../include/umsbb_api.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#define BENCH_POLL_BATCH 64
+#define BENCH_CORE_BUFFER_MB 64
+
+static void* core_create(uint32_t producers, uint32_t consumers, size_t size, bench_run_t* run) {
+    (void)producers;
+    (void)consumers;
+    (void)size;
+    (void)run;
+    umsbb_handle_t handle = umsbb_create_buffer(BENCH_CORE_BUFFER_MB);
+    return handle ? (void*)(uintptr_t)handle : NULL;
+}
+
+static bool core_send(void* ctx, uint32_t producer, const void* data, size_t size) {
+    (void)producer;
+    return umsbb_write_message((umsbb_handle_t)(uintptr_t)ctx, data, (uint32_t)size) == UMSBB_SUCCESS;
+}
+
+static size_t core_poll(void* ctx, uint32_t consumer, bench_run_t* run) {
+    (void)consumer;
+    umsbb_handle_t handle = (umsbb_handle_t)(uintptr_t)ctx;
+    size_t n = 0;
+    const void* data;
+    uint32_t size;
+    uint64_t ticket;
+    while (n < BENCH_POLL_BATCH && umsbb_peek_message(handle, &data, &size, &ticket) == UMSBB_SUCCESS) {
+        bench_consume(run, data, size);
+        umsbb_release_message(handle, ticket);
+        n++;
+    }
+    return n;
+}
+
+static void core_destroy(void* ctx) {
+    umsbb_destroy_buffer((umsbb_handle_t)(uintptr_t)ctx);
+}
+
+static const bench_transport_t transports[] = {
+    { "core", "Complete core: umsbb_write_message and umsbb_peek_message", 0, 0, UMSBB_MAX_MESSAGE_SIZE,
+      core_create, core_send, core_poll, core_destroy },
+};
+
+static const bench_plan_t plans[] = {
+    { "message size sweep, closed loop",
+      { 1 }, 1, { 1 }, 1, { 16, 64, 256, 1024, 4096, 16384 }, 6, { 0 }, 1 },
+    { "producer x consumer matrix, 64 B, closed loop",
+      { 1, 2, 4, 8 }, 4, { 1, 2, 4 }, 3, { 64 }, 1, { 0 }, 1 },
+    { "latency at fixed load, open loop",
+      { 1, 4 }, 2, { 1 }, 1, { 64 }, 1, { 100000, 1000000 }, 2 },
+};
+
+int main(int argc, char** argv) {
+    if (umsbb_init_system() != UMSBB_SUCCESS) {
+        return 2;
+    }
+    int status = bench_main(argc, argv, "core", transports, sizeof(transports) / sizeof(transports[0]), plans,
+                            sizeof(plans) / sizeof(plans[0]));
+    umsbb_shutdown_system();
+    return status;
+}
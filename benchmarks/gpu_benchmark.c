@@ -0,0 +1,85 @@
+/*
+ * GPU benchmark: fast lane BULK traffic with and without GPU coalescing,
+ * which packs submits into batches and runs them through the pipeline (on
+ * the GPU where there is one, its CPU fallback otherwise) before they reach
+ * the lane. Run with --help for the options.
+ */
+
+#include "bench_harness.h"
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include "../include/gpu_accelerated_buffer.h"
+#include <stdlib.h>
+
+#define BENCH_POLL_BATCH 64
+
+static void bulk_destroy(void* ctx) {
+    umsbb_free(ctx);
+}
+
+static void* bulk_open(bool coalesce) {
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(1u << 20, 1);
+    if (!bus) return NULL;
+    if (coalesce) {
+        gpu_pipeline_config_t config;
+        gpu_pipeline_default_config(&config);
+        if (!umsbb_enable_gpu_coalescing(bus, &config)) {
+            umsbb_free(bus);
+            return NULL;
+        }
+    }
+    return bus;
+}
+
+static void* bulk_create(uint32_t producers, uint32_t consumers, size_t size, bench_run_t* run) {
+    (void)producers;
+    (void)consumers;
+    (void)size;
+    (void)run;
+    return bulk_open(false);
+}
+
+static void* coalesced_create(uint32_t producers, uint32_t consumers, size_t size, bench_run_t* run) {
+    (void)producers;
+    (void)consumers;
+    (void)size;
+    (void)run;
+    return bulk_open(true);
+}
+
+static bool bulk_send(void* ctx, uint32_t producer, const void* data, size_t size) {
+    (void)producer;
+    return umsbb_fast_lane_submit(ctx, LANE_BULK, data, size, 0);
+}
+
+static size_t bulk_poll(void* ctx, uint32_t consumer, bench_run_t* run) {
+    (void)consumer;
+    size_t n = 0, size;
+    void* message;
+    while (n < BENCH_POLL_BATCH && (message = umsbb_fast_lane_drain(ctx, LANE_BULK, &size, NULL)) != NULL) {
+        bench_consume(run, message, size);
+        umsbb_message_release(message);
+        n++;
+    }
+    return n;
+}
+
+static const bench_transport_t transports[] = {
+    { "bulk_lane", "Fast lane BULK, no coalescing (baseline)", 0, 0, GPU_PIPELINE_STAGING_BYTES,
+      bulk_create, bulk_send, bulk_poll, bulk_destroy },
+    { "gpu_coalesced", "Fast lane BULK through the GPU coalescing pipeline", 0, 0, GPU_PIPELINE_STAGING_BYTES,
+      coalesced_create, bulk_send, bulk_poll, bulk_destroy },
+};
+
+static const bench_plan_t plans[] = {
+    { "message size sweep, closed loop",
+      { 1 }, 1, { 1 }, 1, { 64, 256, 1024, 4096, 16384 }, 5, { 0 }, 1 },
+    { "batching latency, 256 B, open loop",
+      { 1 }, 1, { 1 }, 1, { 256 }, 1, { 10000, 100000 }, 2 },
+    { "concurrent producers, 1 KiB, closed loop",
+      { 2, 4 }, 2, { 1, 2 }, 2, { 1024 }, 1, { 0 }, 1 },
+};
+
+int main(int argc, char** argv) {
+    return bench_main(argc, argv, "gpu", transports, sizeof(transports) / sizeof(transports[0]), plans,
+                      sizeof(plans) / sizeof(plans[0]));
+}
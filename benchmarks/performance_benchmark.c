@@ -0,0 +1,19 @@
+/*
+ * Performance benchmark: message-size sweep of every bus transport with one
+ * producer and one consumer, then latency at fixed open-loop rates.
+ * Run with --help for the options, --json/--compare for regression tracking.
+ */
+
+#include "bench_harness.h"
+
+static const bench_plan_t plans[] = {
+    { "message size sweep, closed loop",
+      { 1 }, 1, { 1 }, 1, { 16, 64, 256, 1024, 4096, 16384 }, 6, { 0 }, 1 },
+    { "latency at fixed load, open loop",
+      { 1 }, 1, { 1 }, 1, { 64 }, 1, { 100000, 1000000 }, 2 },
+};
+
+int main(int argc, char** argv) {
+    return bench_main(argc, argv, "performance", bench_bus_transports, bench_bus_transport_count, plans,
+                      sizeof(plans) / sizeof(plans[0]));
+}
@@ -0,0 +1,19 @@
+/*
+ * Scaling benchmark: N producers x M consumers over every bus transport,
+ * closed loop for peak throughput and open loop for latency under load.
+ * Run with --help for the options, --json/--compare for regression tracking.
+ */
+
+#include "bench_harness.h"
+
+static const bench_plan_t plans[] = {
+    { "producer x consumer matrix, 64 B, closed loop",
+      { 1, 2, 4, 8 }, 4, { 1, 2, 4 }, 3, { 64 }, 1, { 0 }, 1 },
+    { "contended latency, 64 B at 1M msg/s, open loop",
+      { 4 }, 1, { 2 }, 1, { 64 }, 1, { 1000000 }, 1 },
+};
+
+int main(int argc, char** argv) {
+    return bench_main(argc, argv, "scaling", bench_bus_transports, bench_bus_transport_count, plans,
+                      sizeof(plans) / sizeof(plans[0]));
+}
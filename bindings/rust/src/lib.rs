@@ -1,10 +1,13 @@
 //! Universal Multi-Segmented Bi-Buffer Bus - Rust Direct Binding
 //! No API wrapper - Direct FFI connection with auto-scaling and GPU support
 
+use std::cell::Cell;
 use std::ffi::{CStr, CString};
+use std::ops::Deref;
 use std::os::raw::{c_char, c_int, c_uint, c_void};
 use std::ptr;
 use std::slice;
+use std::time::Duration;
 
 // Language types
 #[repr(C)]
@@ -66,6 +69,17 @@ extern "C" {
     fn umsbb_submit_direct(handle: *mut c_void, data: *const UniversalData) -> bool;
     fn umsbb_drain_direct(handle: *mut c_void, target_lang: LanguageType) -> *mut UniversalData;
     fn umsbb_destroy_direct(handle: *mut c_void);
+
+    // Allocation-free transfers
+    fn umsbb_send_direct(handle: *mut c_void, type_id: u32, data: *const c_void, size: usize) -> bool;
+    fn umsbb_take_direct(handle: *mut c_void, size: *mut usize, type_id: *mut u32) -> *mut c_void;
+    fn umsbb_view_direct(handle: *mut c_void, data: *mut *const c_void, size: *mut usize, lane: *mut usize) -> bool;
+    fn umsbb_release_direct(handle: *mut c_void, lane: usize);
+    fn umsbb_message_release(msg: *mut c_void);
+
+    // Wakeups
+    fn umsbb_wait(handle: *mut c_void, timeout_ns: u64) -> bool;
+    fn umsbb_event_fd(handle: *mut c_void) -> c_int;
     
     // GPU functions
     fn initialize_gpu() -> bool;
@@ -92,6 +106,7 @@ pub struct DirectUniversalBus {
     buffer_size: usize,
     segment_count: u32,
     gpu_enabled: bool,
+    view_held: Cell<bool>,
 }
 
 impl DirectUniversalBus {
@@ -144,6 +159,7 @@ impl DirectUniversalBus {
             buffer_size,
             segment_count,
             gpu_enabled,
+            view_held: Cell::new(false),
         })
     }
 
@@ -170,6 +186,9 @@ impl DirectUniversalBus {
 
     /// Send data to the bus
     /// 
+    /// The bytes are copied once, from the borrowed slice straight into the
+    /// ring; nothing is allocated on the way.
+    /// 
     /// # Arguments
     /// * `data` - Data to send (any type that can be converted to bytes)
     /// * `type_id` - Type identifier for routing
@@ -181,23 +200,10 @@ impl DirectUniversalBus {
     /// ```
     pub fn send<T: AsRef<[u8]>>(&self, data: T, type_id: u32) -> Result<(), String> {
         let bytes = data.as_ref();
-        
-        let udata = unsafe {
-            create_universal_data(
-                bytes.as_ptr() as *const c_void,
-                bytes.len(),
-                type_id,
-                LanguageType::Rust,
-            )
+        let result = unsafe {
+            umsbb_send_direct(self.handle, type_id, bytes.as_ptr() as *const c_void, bytes.len())
         };
 
-        if udata.is_null() {
-            return Err("Failed to create universal data".to_string());
-        }
-
-        let result = unsafe { umsbb_submit_direct(self.handle, udata) };
-        unsafe { free_universal_data(udata) };
-
         if result {
             Ok(())
         } else {
@@ -218,19 +224,90 @@ impl DirectUniversalBus {
     /// }
     /// ```
     pub fn receive(&self) -> Option<Vec<u8>> {
-        let udata_ptr = unsafe { umsbb_drain_direct(self.handle, LanguageType::Rust) };
+        self.receive_message().map(|message| message.to_vec())
+    }
+
+    /// Receive data without copying it into a `Vec`
+    /// 
+    /// The returned `Message` owns the pooled buffer the bus drained the
+    /// message into and hands it back when dropped. It may be sent to, and
+    /// dropped on, another thread.
+    /// 
+    /// # Example
+    /// ```rust
+    /// if let Some(message) = bus.receive_message() {
+    ///     println!("Type {}: {} bytes", message.type_id(), message.len());
+    /// }
+    /// ```
+    pub fn receive_message(&self) -> Option<Message> {
+        let mut size = 0usize;
+        let mut type_id = 0u32;
+        let data = unsafe { umsbb_take_direct(self.handle, &mut size, &mut type_id) };
 
-        if udata_ptr.is_null() {
+        if data.is_null() {
             return None;
         }
 
-        let udata = unsafe { &*udata_ptr };
-        let data_slice = unsafe { slice::from_raw_parts(udata.data as *const u8, udata.size) };
-        let result = data_slice.to_vec();
+        Some(Message { data: data as *mut u8, size, type_id })
+    }
 
-        unsafe { free_universal_data(udata_ptr) };
+    /// Borrow the next message in its ring slot
+    /// 
+    /// Nothing is copied: the guard reads the slot directly, and the slot is
+    /// handed back to producers when the guard is dropped. Only one guard
+    /// may be held per bus; while it is, this returns `None`.
+    /// 
+    /// # Example
+    /// ```rust
+    /// if let Some(message) = bus.receive_ref() {
+    ///     process(&message);
+    /// } // The slot is released here
+    /// ```
+    pub fn receive_ref(&self) -> Option<MessageRef<'_>> {
+        if self.view_held.get() {
+            return None;
+        }
+
+        let mut data: *const c_void = ptr::null();
+        let mut size = 0usize;
+        let mut lane = 0usize;
+        if !unsafe { umsbb_view_direct(self.handle, &mut data, &mut size, &mut lane) } {
+            return None;
+        }
 
-        Some(result)
+        self.view_held.set(true);
+        Some(MessageRef { bus: self, data: data as *const u8, size, lane })
+    }
+
+    /// Block until a message may be ready or `timeout` passes (`None` waits
+    /// indefinitely). The wait parks on the bus's event instead of polling.
+    pub fn wait(&self, timeout: Option<Duration>) -> bool {
+        let timeout_ns = timeout.map_or(u64::MAX, |t| t.as_nanos().min(u64::MAX as u128 - 1) as u64);
+        unsafe { umsbb_wait(self.handle, timeout_ns) }
+    }
+
+    /// File descriptor readable while the bus has undrained messages, for
+    /// epoll/poll loops; `None` where eventfd is unavailable
+    #[cfg(unix)]
+    pub fn event_fd(&self) -> Option<std::os::unix::io::RawFd> {
+        let fd = unsafe { umsbb_event_fd(self.handle) };
+        if fd >= 0 { Some(fd) } else { None }
+    }
+
+    /// Stream of received messages woken through the bus's eventfd
+    /// 
+    /// # Example
+    /// ```rust
+    /// use futures::StreamExt;
+    /// 
+    /// let mut messages = bus.stream()?;
+    /// while let Some(message) = messages.next().await {
+    ///     println!("Received {} bytes", message?.len());
+    /// }
+    /// ```
+    #[cfg(all(unix, feature = "tokio"))]
+    pub fn stream(&self) -> std::io::Result<MessageStream<'_>> {
+        MessageStream::new(self)
     }
 
     /// Send data and wait for a response
@@ -263,7 +340,11 @@ impl DirectUniversalBus {
                 return None;
             }
 
-            std::thread::sleep(std::time::Duration::from_micros(100));
+            // Park until a commit signals the bus rather than sleeping
+            let remaining = Duration::from_millis(timeout_ms).saturating_sub(start.elapsed());
+            if !self.wait(Some(remaining)) {
+                return None;
+            }
         }
     }
 
@@ -312,6 +393,157 @@ impl Drop for DirectUniversalBus {
     }
 }
 
+/// A received message in a pooled buffer, returned to the pool on drop
+pub struct Message {
+    data: *mut u8,
+    size: usize,
+    type_id: u32,
+}
+
+// Pooled buffers may be released from any thread
+unsafe impl Send for Message {}
+unsafe impl Sync for Message {}
+
+impl Message {
+    /// Lane the message was drained from, which `send` picks from its type id
+    pub fn type_id(&self) -> u32 {
+        self.type_id
+    }
+}
+
+impl Deref for Message {
+    type Target = [u8];
+
+    fn deref(&self) -> &[u8] {
+        unsafe { slice::from_raw_parts(self.data, self.size) }
+    }
+}
+
+impl AsRef<[u8]> for Message {
+    fn as_ref(&self) -> &[u8] {
+        self
+    }
+}
+
+impl Drop for Message {
+    fn drop(&mut self) {
+        unsafe { umsbb_message_release(self.data as *mut c_void) };
+    }
+}
+
+/// A message borrowed in its ring slot; the slot is released on drop
+pub struct MessageRef<'a> {
+    bus: &'a DirectUniversalBus,
+    data: *const u8,
+    size: usize,
+    lane: usize,
+}
+
+impl MessageRef<'_> {
+    /// Lane holding the message, which `send` picks from its type id
+    pub fn type_id(&self) -> u32 {
+        self.lane as u32
+    }
+}
+
+impl Deref for MessageRef<'_> {
+    type Target = [u8];
+
+    fn deref(&self) -> &[u8] {
+        unsafe { slice::from_raw_parts(self.data, self.size) }
+    }
+}
+
+impl AsRef<[u8]> for MessageRef<'_> {
+    fn as_ref(&self) -> &[u8] {
+        self
+    }
+}
+
+impl Drop for MessageRef<'_> {
+    fn drop(&mut self) {
+        unsafe { umsbb_release_direct(self.bus.handle, self.lane) };
+        self.bus.view_held.set(false);
+    }
+}
+
+/// Async receiver registered on the bus's eventfd with the tokio reactor
+/// 
+/// The eventfd is readable while the bus holds undrained messages. Once a
+/// drain comes back empty the event is cleared (and the fd drained) before the
+/// task parks, so the next commit writes it again and wakes the task; nothing
+/// polls in between. With several consumers a wakeup may find the message
+/// already taken, and the stream simply parks again.
+#[cfg(all(unix, feature = "tokio"))]
+pub struct MessageStream<'a> {
+    bus: &'a DirectUniversalBus,
+    fd: tokio::io::unix::AsyncFd<std::os::unix::io::RawFd>,
+}
+
+#[cfg(all(unix, feature = "tokio"))]
+impl<'a> MessageStream<'a> {
+    fn new(bus: &'a DirectUniversalBus) -> std::io::Result<Self> {
+        let fd = bus.event_fd().ok_or_else(|| {
+            std::io::Error::new(std::io::ErrorKind::Unsupported, "eventfd unavailable")
+        })?;
+        // Registration only; the bus keeps ownership of the descriptor
+        let fd = tokio::io::unix::AsyncFd::with_interest(fd, tokio::io::Interest::READABLE)?;
+        Ok(MessageStream { bus, fd })
+    }
+
+    /// Poll for the next message, registering the task's waker when there is none
+    pub fn poll_recv(&mut self, cx: &mut std::task::Context<'_>) -> std::task::Poll<std::io::Result<Message>> {
+        self.poll_with(cx, |bus| bus.receive_message())
+    }
+
+    /// Wait for the next message
+    pub async fn recv(&mut self) -> std::io::Result<Message> {
+        std::future::poll_fn(|cx| self.poll_recv(cx)).await
+    }
+
+    /// Wait for the next message and borrow it in its ring slot, as
+    /// `receive_ref` does; fails while another guard is held
+    pub async fn recv_ref(&mut self) -> std::io::Result<MessageRef<'a>> {
+        if self.bus.view_held.get() {
+            return Err(std::io::Error::new(std::io::ErrorKind::WouldBlock, "a message is already borrowed"));
+        }
+        let bus = self.bus;
+        std::future::poll_fn(|cx| self.poll_with(cx, |_| bus.receive_ref())).await
+    }
+
+    fn poll_with<T>(
+        &mut self,
+        cx: &mut std::task::Context<'_>,
+        mut take: impl FnMut(&'a DirectUniversalBus) -> Option<T>,
+    ) -> std::task::Poll<std::io::Result<T>> {
+        use std::task::Poll;
+        loop {
+            if let Some(item) = take(self.bus) {
+                return Poll::Ready(Ok(item));
+            }
+            let mut ready = match self.fd.poll_read_ready(cx) {
+                Poll::Ready(Ok(guard)) => guard,
+                Poll::Ready(Err(e)) => return Poll::Ready(Err(e)),
+                Poll::Pending => return Poll::Pending,
+            };
+            // A zero-timeout wait clears the event when the bus is empty, so
+            // the next commit makes the fd readable again
+            if !self.bus.wait(Some(Duration::ZERO)) {
+                ready.clear_ready();
+            }
+        }
+    }
+}
+
+#[cfg(all(unix, feature = "tokio"))]
+impl futures_core::Stream for MessageStream<'_> {
+    type Item = std::io::Result<Message>;
+
+    fn poll_next(mut self: std::pin::Pin<&mut Self>, cx: &mut std::task::Context<'_>) -> std::task::Poll<Option<Self::Item>> {
+        self.poll_recv(cx).map(Some)
+    }
+}
+
 // Helper structures for better Rust ergonomics
 #[derive(Debug, Clone)]
 pub struct GpuInfo {
@@ -368,7 +600,8 @@ impl AutoScalingBus {
         let count = count.unwrap_or_else(|| self.bus.get_scaling_status().optimal_producers);
 
         for worker_id in 0..count {
-            let bus_handle = unsafe { std::ptr::read(&self.bus.handle) };
+            // Raw pointers are not Send; the address crosses as an integer
+            let bus_handle = self.bus.handle as usize;
             let producer_fn = producer_fn.clone();
             let shutdown = self.shutdown.clone();
 
@@ -377,10 +610,11 @@ impl AutoScalingBus {
                     if let Some(data) = producer_fn(worker_id) {
                         // Create a temporary bus instance for this thread
                         let temp_bus = DirectUniversalBus {
-                            handle: bus_handle,
+                            handle: bus_handle as *mut c_void,
                             buffer_size: 0,
                             segment_count: 0,
                             gpu_enabled: false,
+                            view_held: Cell::new(false),
                         };
                         let _ = temp_bus.send(&data, worker_id);
                         std::mem::forget(temp_bus); // Don't drop the handle
@@ -407,7 +641,8 @@ impl AutoScalingBus {
         let count = count.unwrap_or_else(|| self.bus.get_scaling_status().optimal_consumers);
 
         for worker_id in 0..count {
-            let bus_handle = unsafe { std::ptr::read(&self.bus.handle) };
+            // Raw pointers are not Send; the address crosses as an integer
+            let bus_handle = self.bus.handle as usize;
             let consumer_fn = consumer_fn.clone();
             let shutdown = self.shutdown.clone();
 
@@ -415,16 +650,18 @@ impl AutoScalingBus {
                 while !shutdown.load(std::sync::atomic::Ordering::Relaxed) {
                     // Create a temporary bus instance for this thread
                     let temp_bus = DirectUniversalBus {
-                        handle: bus_handle,
+                        handle: bus_handle as *mut c_void,
                         buffer_size: 0,
                         segment_count: 0,
                         gpu_enabled: false,
+                        view_held: Cell::new(false),
                     };
                     
                     if let Some(data) = temp_bus.receive() {
                         consumer_fn(data, worker_id);
                     } else {
-                        std::thread::sleep(std::time::Duration::from_micros(100));
+                        // Bounded so the shutdown flag is still seen
+                        temp_bus.wait(Some(Duration::from_millis(1)));
                     }
                     std::mem::forget(temp_bus); // Don't drop the handle
                 }
@@ -485,6 +722,25 @@ mod tests {
         }
     }
 
+    #[test]
+    fn test_zero_copy_receive() {
+        let bus = DirectUniversalBus::new(64 * 1024, 2, false, false).unwrap();
+        assert!(bus.send(b"borrowed", 1).is_ok());
+        assert!(bus.send(b"pooled", 1).is_ok());
+
+        {
+            let message = bus.receive_ref().expect("a message is waiting");
+            assert_eq!(&*message, b"borrowed");
+            assert_eq!(message.type_id(), 1);
+            assert!(bus.receive_ref().is_none(), "one guard at a time");
+        }
+
+        let message = bus.receive_message().expect("the guard released its slot");
+        assert_eq!(&*message, b"pooled");
+        assert!(bus.receive_message().is_none());
+        assert!(!bus.wait(Some(Duration::from_millis(1))));
+    }
+
     #[test]
     fn test_gpu_info() {
         let bus = DirectUniversalBus::new(1024 * 1024, 4, true, false).unwrap();
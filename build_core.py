@@ -22,6 +22,8 @@ class UMSBBCoreBuilder:
         }
         self.optimization_level = 3
         self.target_platform = 'wasm'
+        self.threads = False
+        self.simd = False
         self.output_dir = self.base_dir / 'build'
     
     def configure_features(self, **kwargs):
@@ -44,6 +46,20 @@ class UMSBBCoreBuilder:
             self.target_platform = platform
             print(f"Target platform set to: {platform}")
     
+    def set_threads(self, enabled):
+        """Build the wasm core over shared memory so every worker can use it"""
+        self.threads = enabled
+        print(f"Shared-memory threads: {'enabled' if enabled else 'disabled'}")
+    
+    def set_simd(self, enabled):
+        """Build the SIMD128 variant; runtimes without SIMD load the scalar one"""
+        self.simd = enabled
+        print(f"WASM SIMD128: {'enabled' if enabled else 'disabled'}")
+    
+    def wasm_stem(self):
+        """Output name for the variant, as the JS connector's loadCore expects"""
+        return 'umsbb_core' + ('_mt' if self.threads else '') + ('_simd' if self.simd else '')
+    
     def generate_build_config(self):
         """Generate build configuration header"""
         config_content = f"""/*
@@ -97,6 +113,8 @@ class UMSBBCoreBuilder:
                     "'_umsbb_create_buffer'," +
                     "'_umsbb_write_message'," +
                     "'_umsbb_read_message'," +
+                    "'_umsbb_write_batch'," +
+                    "'_umsbb_read_batch'," +
                     "'_umsbb_destroy_buffer'," +
                     "'_umsbb_get_total_messages'," +
                     "'_umsbb_get_total_bytes'," +
@@ -108,28 +126,50 @@ class UMSBBCoreBuilder:
                     "'_umsbb_get_error_string'," +
                     "'_umsbb_get_buffer_config'," +
                     "'_umsbb_get_system_info'," +
+                    "'_umsbb_set_checksum_policy'," +
+                    "'_umsbb_wait_message'," +
+                    "'_umsbb_get_wait_address'," +
+                    "'_umsbb_is_shared_memory'," +
+                    "'_umsbb_is_simd_build'," +
                     "'_umsbb_malloc'," +
                     "'_umsbb_free'"
             ]
             
             if self.features['performance_testing']:
-                emcc_flags[3] = emcc_flags[3][:-1] + ",'_umsbb_run_performance_test']"
+                emcc_flags[3] += ",'_umsbb_run_performance_test']"
             else:
                 emcc_flags[3] += "]"
             
             emcc_flags.extend([
-                "-s", "EXPORTED_RUNTIME_METHODS=[\"ccall\", \"cwrap\", \"UTF8ToString\"]",
-                "-s", "ALLOW_MEMORY_GROWTH=1",
-                "-s", "MAXIMUM_MEMORY=134217728",  # 128MB
+                "-s", "EXPORTED_RUNTIME_METHODS=[\"ccall\", \"cwrap\", \"UTF8ToString\", \"HEAPU8\", \"HEAPU32\"]",
                 "-s", "MODULARIZE=1",
                 "-s", "EXPORT_NAME=UMSBBCore",
-                "-s", "ENVIRONMENT=web,node",
                 "-s", "MALLOC=emmalloc",          # Optimized allocator
                 "-s", "ASSERTIONS=0",             # Disable assertions in production
                 "-s", "STACK_OVERFLOW_CHECK=0",   # Disable stack checks for performance
                 "--closure", "1"                  # Enable Closure Compiler optimization
             ])
             
+            if self.simd:
+                # Vector copies, segment scan and checksum engine
+                emcc_flags.append("-msimd128")
+            
+            if self.threads:
+                # SharedArrayBuffer memory and wasm atomics; fixed size, since
+                # growing shared memory leaves JS views stale
+                emcc_flags.extend([
+                    "-pthread",
+                    "-s", "SHARED_MEMORY=1",
+                    "-s", "INITIAL_MEMORY=134217728",
+                    "-s", "ENVIRONMENT=web,worker,node"
+                ])
+            else:
+                emcc_flags.extend([
+                    "-s", "ALLOW_MEMORY_GROWTH=1",
+                    "-s", "MAXIMUM_MEMORY=134217728",  # 128MB
+                    "-s", "ENVIRONMENT=web,node"
+                ])
+            
             # Add optimization flags based on level
             if self.optimization_level >= 2:
                 emcc_flags.extend(["-s", "AGGRESSIVE_VARIABLE_ELIMINATION=1"])
@@ -171,7 +211,7 @@ class UMSBBCoreBuilder:
         # Determine compiler and output
         if self.target_platform == 'wasm':
             compiler = 'emcc'
-            output_file = self.output_dir / 'umsbb_core.js'
+            output_file = self.output_dir / f'{self.wasm_stem()}.js'
         else:
             compiler = 'gcc'
             if 'windows' in self.target_platform:
@@ -182,7 +222,11 @@ class UMSBBCoreBuilder:
         # Build command
         cmd = [compiler] + self.get_compiler_flags() + [
             f"-I{self.base_dir}",
+            f"-I{self.base_dir / 'include'}",
             str(source_file),
+            str(self.base_dir / 'src' / 'wasm_kernels.c'),
+            str(self.base_dir / 'src' / 'checksum_engine.c'),
+            str(self.base_dir / 'src' / 'umsbb_clock.c'),
             "-o", str(output_file)
         ]
         
@@ -225,8 +269,9 @@ class UMSBBCoreBuilder:
         """Deploy built files to connector directories"""
         if self.target_platform == 'wasm':
             # Deploy to JavaScript and web directories
-            js_file = self.output_dir / 'umsbb_core.js'
-            wasm_file = self.output_dir / 'umsbb_core.wasm'
+            stem = self.wasm_stem()
+            js_file = self.output_dir / f'{stem}.js'
+            wasm_file = self.output_dir / f'{stem}.wasm'
             
             target_dirs = [
                 self.base_dir / 'connectors' / 'javascript',
@@ -280,6 +325,10 @@ def main():
                        help='Enable memory debugging')
     parser.add_argument('--enable-compression', action='store_true',
                        help='Enable compression support')
+    parser.add_argument('--threads', action='store_true',
+                       help='Shared-memory wasm build usable from every worker')
+    parser.add_argument('--simd', action='store_true',
+                       help='WASM SIMD128 variant; build without it too for the scalar fallback')
     
     args = parser.parse_args()
     
@@ -300,6 +349,10 @@ def main():
         builder.configure_features(**feature_config)
     
     builder.set_target(args.target)
+    if args.threads:
+        builder.set_threads(True)
+    if args.simd:
+        builder.set_simd(True)
     builder.set_optimization(args.optimization)
     
     if args.action == 'build':
@@ -27,21 +27,34 @@ echo.
 REM Create build directory
 if not exist build mkdir build
 
-REM Compile the WebAssembly core with optimized settings
-emcc -O3 -s WASM=1 ^
-    -s "EXPORTED_FUNCTIONS=['_umsbb_init_system','_umsbb_shutdown_system','_umsbb_create_buffer','_umsbb_write_message','_umsbb_read_message','_umsbb_destroy_buffer','_umsbb_get_total_messages','_umsbb_get_total_bytes','_umsbb_get_pending_messages','_umsbb_get_version','_umsbb_get_error_string','_umsbb_run_performance_test','_umsbb_malloc','_umsbb_free']" ^
-    -s "EXPORTED_RUNTIME_METHODS=['ccall', 'cwrap', 'UTF8ToString']" ^
-    -s ALLOW_MEMORY_GROWTH=1 ^
-    -s INITIAL_MEMORY=33554432 ^
-    -s MAXIMUM_MEMORY=134217728 ^
-    -s MODULARIZE=1 ^
-    -s EXPORT_NAME=UMSBBCore ^
-    -s ENVIRONMENT=web,node ^
-    -s MALLOC=emmalloc ^
-    -s ASSERTIONS=0 ^
-    -s STACK_OVERFLOW_CHECK=0 ^
-    --closure 1 ^
-    src/umsbb_wasm_core.c -o dist/umsbb_core.js
+REM --threads adds the shared-memory build; --simd adds a SIMD128 variant of
+REM every build. The scalar modules run everywhere and stay the fallback.
+set THREADS=0
+set SIMD=0
+for %%a in (%*) do (
+    if "%%a"=="--threads" set THREADS=1
+    if "%%a"=="--simd" set SIMD=1
+)
+
+REM Growable memory for the single-threaded core
+set SINGLE_FLAGS=-s ALLOW_MEMORY_GROWTH=1 -s INITIAL_MEMORY=33554432 -s MAXIMUM_MEMORY=134217728 -s EXPORT_NAME=UMSBBCore -s ENVIRONMENT=web,node
+REM Shared memory is fixed, since growing it leaves JS views stale
+set SHARED_FLAGS=-pthread -s SHARED_MEMORY=1 -s INITIAL_MEMORY=67108864 -s EXPORT_NAME=UMSBBCoreMT -s ENVIRONMENT=web,worker,node
+
+set CORE_FLAGS=%SINGLE_FLAGS%
+call :build_core umsbb_core
+if %errorlevel% equ 0 if %SIMD%==1 (
+    set CORE_FLAGS=%SINGLE_FLAGS% -msimd128
+    call :build_core umsbb_core_simd
+)
+if %errorlevel% equ 0 if %THREADS%==1 (
+    set CORE_FLAGS=%SHARED_FLAGS%
+    call :build_core umsbb_core_mt
+)
+if %errorlevel% equ 0 if %THREADS%==1 if %SIMD%==1 (
+    set CORE_FLAGS=%SHARED_FLAGS% -msimd128
+    call :build_core umsbb_core_mt_simd
+)
 
 if %errorlevel% equ 0 (
     echo.
@@ -50,6 +63,8 @@ if %errorlevel% equ 0 (
     echo Generated files:
     echo   🔹 umsbb_core.js   - JavaScript loader/wrapper
     echo   🔹 umsbb_core.wasm - WebAssembly binary
+    if %SIMD%==1 echo   🔹 umsbb_core_simd.js / .wasm - SIMD128 build
+    if %THREADS%==1 echo   🔹 umsbb_core_mt.js / .wasm - shared-memory build for workers
     echo.
     echo 📁 Files are ready for web deployment!
     echo.
@@ -72,4 +87,19 @@ if %errorlevel% equ 0 (
 )
 
 echo.
-pause
\ No newline at end of file
+pause
+goto :eof
+
+REM build_core <output stem>, with CORE_FLAGS for the variant
+:build_core
+emcc -O3 -s WASM=1 ^
+    -s "EXPORTED_FUNCTIONS=['_umsbb_init_system','_umsbb_shutdown_system','_umsbb_create_buffer','_umsbb_write_message','_umsbb_read_message','_umsbb_write_batch','_umsbb_read_batch','_umsbb_destroy_buffer','_umsbb_get_total_messages','_umsbb_get_total_bytes','_umsbb_get_pending_messages','_umsbb_get_version','_umsbb_get_error_string','_umsbb_run_performance_test','_umsbb_set_checksum_policy','_umsbb_wait_message','_umsbb_get_wait_address','_umsbb_is_shared_memory','_umsbb_is_simd_build','_umsbb_malloc','_umsbb_free']" ^
+    -s "EXPORTED_RUNTIME_METHODS=['ccall', 'cwrap', 'UTF8ToString', 'HEAPU8', 'HEAPU32']" ^
+    -s MODULARIZE=1 ^
+    -s MALLOC=emmalloc ^
+    -s ASSERTIONS=0 ^
+    -s STACK_OVERFLOW_CHECK=0 ^
+    --closure 1 ^
+    -Iinclude %CORE_FLAGS% ^
+    src/umsbb_wasm_core.c src/wasm_heap.c src/wasm_kernels.c src/checksum_engine.c src/umsbb_clock.c -o dist/%1.js
+exit /b %errorlevel%
@@ -25,37 +25,85 @@ echo
 # Create build directory
 mkdir -p build
 
-# Compile the WebAssembly core
+EXPORTS="['_umsbb_init_system','_umsbb_shutdown_system','_umsbb_create_buffer','_umsbb_write_message','_umsbb_read_message','_umsbb_write_batch','_umsbb_read_batch','_umsbb_destroy_buffer','_umsbb_get_total_messages','_umsbb_get_total_bytes','_umsbb_get_pending_messages','_umsbb_get_version','_umsbb_get_error_string','_umsbb_run_performance_test','_umsbb_set_checksum_policy','_umsbb_wait_message','_umsbb_get_wait_address','_umsbb_is_shared_memory','_umsbb_is_simd_build','_umsbb_malloc','_umsbb_free']"
+
+# --threads adds the shared-memory build; --simd adds a SIMD128 variant of
+# every build. The scalar modules run everywhere and stay the fallback.
+THREADS=0
+SIMD=0
+for arg in "$@"; do
+    case "$arg" in
+        --threads) THREADS=1 ;;
+        --simd) SIMD=1 ;;
+    esac
+done
+SOURCES="src/umsbb_wasm_core.c src/wasm_heap.c src/wasm_kernels.c src/checksum_engine.c src/umsbb_clock.c"
+
+# build_core <output stem> <extra emcc flags...>
+build_core() {
+    local stem=$1
+    shift
+    emcc -O3 -s WASM=1 \
+        -s "EXPORTED_FUNCTIONS=$EXPORTS" \
+        -s "EXPORTED_RUNTIME_METHODS=['ccall', 'cwrap', 'UTF8ToString', 'HEAPU8', 'HEAPU32']" \
+        -s MODULARIZE=1 \
+        -s MALLOC=emmalloc \
+        -s ASSERTIONS=0 \
+        -s STACK_OVERFLOW_CHECK=0 \
+        --closure 1 \
+        -Iinclude "$@" \
+        $SOURCES -o "dist/$stem.js"
+}
+
+# Growable memory for the single-threaded core
+SINGLE_FLAGS="-s ALLOW_MEMORY_GROWTH=1 -s INITIAL_MEMORY=33554432 -s MAXIMUM_MEMORY=134217728 -s EXPORT_NAME=UMSBBCore -s ENVIRONMENT=web,node"
+# Shared memory is fixed, since growing it leaves JS views stale; pages
+# need cross-origin isolation (COOP/COEP headers) for SharedArrayBuffer
+SHARED_FLAGS="-pthread -s SHARED_MEMORY=1 -s INITIAL_MEMORY=67108864 -s EXPORT_NAME=UMSBBCoreMT -s ENVIRONMENT=web,worker,node"
+
 echo "🔧 Compiling WebAssembly core with optimizations..."
+build_core umsbb_core $SINGLE_FLAGS
+STATUS=$?
 
-emcc -O3 -s WASM=1 \
-    -s "EXPORTED_FUNCTIONS=['_umsbb_init_system','_umsbb_shutdown_system','_umsbb_create_buffer','_umsbb_write_message','_umsbb_read_message','_umsbb_destroy_buffer','_umsbb_get_total_messages','_umsbb_get_total_bytes','_umsbb_get_pending_messages','_umsbb_get_version','_umsbb_get_error_string','_umsbb_run_performance_test','_umsbb_malloc','_umsbb_free']" \
-    -s "EXPORTED_RUNTIME_METHODS=['ccall', 'cwrap', 'UTF8ToString']" \
-    -s ALLOW_MEMORY_GROWTH=1 \
-    -s INITIAL_MEMORY=33554432 \
-    -s MAXIMUM_MEMORY=134217728 \
-    -s MODULARIZE=1 \
-    -s EXPORT_NAME=UMSBBCore \
-    -s ENVIRONMENT=web,node \
-    -s MALLOC=emmalloc \
-    -s ASSERTIONS=0 \
-    -s STACK_OVERFLOW_CHECK=0 \
-    --closure 1 \
-    src/umsbb_wasm_core.c -o dist/umsbb_core.js
+if [ $STATUS -eq 0 ] && [ $SIMD -eq 1 ]; then
+    echo "🔧 Compiling SIMD128 core (-msimd128)..."
+    build_core umsbb_core_simd $SINGLE_FLAGS -msimd128
+    STATUS=$?
+fi
+
+if [ $STATUS -eq 0 ] && [ $THREADS -eq 1 ]; then
+    echo "🔧 Compiling shared-memory core (-pthread)..."
+    build_core umsbb_core_mt $SHARED_FLAGS
+    STATUS=$?
+fi
+
+if [ $STATUS -eq 0 ] && [ $THREADS -eq 1 ] && [ $SIMD -eq 1 ]; then
+    echo "🔧 Compiling shared-memory SIMD128 core..."
+    build_core umsbb_core_mt_simd $SHARED_FLAGS -msimd128
+    STATUS=$?
+fi
 
-if [ $? -eq 0 ]; then
+if [ $STATUS -eq 0 ]; then
     echo
     echo "✅ WebAssembly compilation successful!"
     echo
     echo "Generated files:"
     echo "  🔹 umsbb_core.js   - JavaScript loader/wrapper"
     echo "  🔹 umsbb_core.wasm - WebAssembly binary"
+    if [ $SIMD -eq 1 ]; then
+        echo "  🔹 umsbb_core_simd.js / .wasm - SIMD128 build"
+    fi
+    if [ $THREADS -eq 1 ]; then
+        echo "  🔹 umsbb_core_mt.js / .wasm - shared-memory build for workers"
+        [ $SIMD -eq 1 ] && echo "  🔹 umsbb_core_mt_simd.js / .wasm - shared-memory SIMD128 build"
+    fi
     echo
     echo "📁 Files are ready for web deployment!"
     echo
     echo "Usage:"
     echo "  1. Include umsbb_core.js in your webpage"
-    echo "  2. Load with: const core = await UMSBBCore()"
+    echo "  2. Load with: const core = await UMSBBCore(), or let the connector's"
+    echo "     loadCore() pick the SIMD128 build where the browser supports it"
     echo "  3. Use: core.ccall('umsbb_init_system', 'number', [], [])"
     echo
     echo "🌐 Open web_demo.html to see it in action!"
@@ -0,0 +1,304 @@
+/*
+ * Zero-copy C++ layer for the UMSBB core (header-only, C++20)
+ *
+ * Writes land straight in the ring through umsbb_reserve_message and
+ * umsbb_commit_message, and reads borrow the record where it lies through
+ * umsbb_peek_message until the guard is destroyed. Nothing on these paths
+ * allocates or takes a lock: the core reserves space with a CAS and gives
+ * each reading thread its own segment. The producer and consumer policies
+ * only decide whether this layer's own counters have to be atomic.
+ */
+
+#ifndef UMSBB_CPP_CHANNEL_HPP
+#define UMSBB_CPP_CHANNEL_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "umsbb_connector.hpp"
+#include "../../include/umsbb_api.h"
+
+namespace umsbb {
+
+// How many threads use one side of a Bus at a time
+struct SingleProducer {};
+struct MultiProducer {};
+struct SingleConsumer {};
+struct MultiConsumer {};
+
+namespace detail {
+
+template <typename Policy> struct is_concurrent : std::true_type {};
+template <> struct is_concurrent<SingleProducer> : std::false_type {};
+template <> struct is_concurrent<SingleConsumer> : std::false_type {};
+
+// Message and byte tally for one side; a plain counter when only one
+// thread can touch it
+template <bool Concurrent>
+class Tally {
+public:
+    void add(uint64_t bytes) noexcept { messages_++; bytes_ += bytes; }
+    uint64_t messages() const noexcept { return messages_; }
+    uint64_t bytes() const noexcept { return bytes_; }
+
+private:
+    uint64_t messages_{0};
+    uint64_t bytes_{0};
+};
+
+template <>
+class Tally<true> {
+public:
+    void add(uint64_t bytes) noexcept {
+        messages_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    uint64_t messages() const noexcept { return messages_.load(std::memory_order_relaxed); }
+    uint64_t bytes() const noexcept { return bytes_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> messages_{0};
+    std::atomic<uint64_t> bytes_{0};
+};
+
+} // namespace detail
+
+// A message borrowed in its segment; the segment goes back to readers when
+// the guard is destroyed, so keep it short-lived
+class ReadGuard {
+public:
+    ReadGuard() noexcept = default;
+    ReadGuard(ReadGuard&& other) noexcept
+        : handle_(std::exchange(other.handle_, 0)), data_(other.data_), ticket_(other.ticket_) {}
+    ReadGuard& operator=(ReadGuard&& other) noexcept {
+        if (this != &other) {
+            release();
+            handle_ = std::exchange(other.handle_, 0);
+            data_ = other.data_;
+            ticket_ = other.ticket_;
+        }
+        return *this;
+    }
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+    ~ReadGuard() { release(); }
+
+    explicit operator bool() const noexcept { return handle_ != 0; }
+    std::span<const std::byte> data() const noexcept { return data_; }
+    size_t size() const noexcept { return data_.size(); }
+    std::string_view view() const noexcept {
+        return {reinterpret_cast<const char*>(data_.data()), data_.size()};
+    }
+
+    // Consume the message now rather than at destruction
+    void release() noexcept {
+        if (handle_ != 0) {
+            umsbb_release_message(std::exchange(handle_, 0), ticket_);
+        }
+    }
+
+private:
+    template <typename, typename> friend class Bus;
+    ReadGuard(uint32_t handle, std::span<const std::byte> data, uint64_t ticket) noexcept
+        : handle_(handle), data_(data), ticket_(ticket) {}
+
+    uint32_t handle_{0};
+    std::span<const std::byte> data_;
+    uint64_t ticket_{0};
+};
+
+// Room reserved in the ring to build a message in place. Destroying it
+// without commit() cancels it; until either, readers of its segment wait.
+class WriteReservation {
+public:
+    WriteReservation() noexcept = default;
+    WriteReservation(WriteReservation&& other) noexcept
+        : handle_(std::exchange(other.handle_, 0)), data_(other.data_), ticket_(other.ticket_) {}
+    WriteReservation& operator=(WriteReservation&& other) noexcept {
+        if (this != &other) {
+            cancel();
+            handle_ = std::exchange(other.handle_, 0);
+            data_ = other.data_;
+            ticket_ = other.ticket_;
+        }
+        return *this;
+    }
+    WriteReservation(const WriteReservation&) = delete;
+    WriteReservation& operator=(const WriteReservation&) = delete;
+    ~WriteReservation() { cancel(); }
+
+    explicit operator bool() const noexcept { return handle_ != 0; }
+    std::span<std::byte> data() const noexcept { return data_; }
+
+    // Publish the first `size` bytes written (all of them by default)
+    bool commit(size_t size) noexcept {
+        if (handle_ == 0 || size == 0 || size > data_.size()) {
+            return false;
+        }
+        return umsbb_commit_message(std::exchange(handle_, 0), ticket_, static_cast<uint32_t>(size)) ==
+               static_cast<int>(ErrorCode::SUCCESS);
+    }
+    bool commit() noexcept { return commit(data_.size()); }
+
+    void cancel() noexcept {
+        if (handle_ != 0) {
+            umsbb_cancel_message(std::exchange(handle_, 0), ticket_);
+        }
+    }
+
+private:
+    template <typename, typename> friend class Bus;
+    WriteReservation(uint32_t handle, std::span<std::byte> data, uint64_t ticket) noexcept
+        : handle_(handle), data_(data), ticket_(ticket) {}
+
+    uint32_t handle_{0};
+    std::span<std::byte> data_;
+    uint64_t ticket_{0};
+};
+
+template <typename ProducerPolicy = MultiProducer, typename ConsumerPolicy = MultiConsumer>
+class Bus {
+public:
+    explicit Bus(uint32_t size_mb = 16) : handle_(umsbb_create_buffer(size_mb)) {
+        if (handle_ == 0) {
+            throw UMSBBException("Failed to create buffer", ErrorCode::MEMORY_ALLOCATION);
+        }
+    }
+
+    ~Bus() {
+        if (handle_ != 0) {
+            umsbb_destroy_buffer(handle_);
+        }
+    }
+
+    // Outstanding guards and reservations must not outlive the bus
+    Bus(Bus&& other) noexcept : handle_(std::exchange(other.handle_, 0)) {}
+    Bus& operator=(Bus&& other) noexcept {
+        if (this != &other) {
+            if (handle_ != 0) {
+                umsbb_destroy_buffer(handle_);
+            }
+            handle_ = std::exchange(other.handle_, 0);
+        }
+        return *this;
+    }
+    Bus(const Bus&) = delete;
+    Bus& operator=(const Bus&) = delete;
+
+    // Copy `data` into the ring; false when it is full or the size is out of range
+    bool try_write(std::span<const std::byte> data) noexcept {
+        if (data.size() > UMSBB_MAX_MESSAGE_SIZE ||
+            umsbb_write_message(handle_, data.data(), static_cast<uint32_t>(data.size())) !=
+                static_cast<int>(ErrorCode::SUCCESS)) {
+            return false;
+        }
+        sent_.add(data.size());
+        return true;
+    }
+    bool try_write(std::span<const uint8_t> data) noexcept { return try_write(std::as_bytes(data)); }
+    bool try_write(std::string_view data) noexcept {
+        return try_write(std::span<const std::byte>(reinterpret_cast<const std::byte*>(data.data()), data.size()));
+    }
+
+    // Reserve `size` bytes to fill in place; an empty reservation when full
+    WriteReservation reserve(size_t size) noexcept {
+        if (size == 0 || size > UMSBB_MAX_MESSAGE_SIZE) {
+            return {};
+        }
+        uint64_t ticket = 0;
+        void* data = umsbb_reserve_message(handle_, static_cast<uint32_t>(size), &ticket);
+        if (data == nullptr) {
+            return {};
+        }
+        sent_.add(size);
+        return WriteReservation(handle_, std::span<std::byte>(static_cast<std::byte*>(data), size), ticket);
+    }
+
+    // Borrow the next message; an empty guard when there is none
+    ReadGuard try_read() noexcept {
+        const void* data = nullptr;
+        uint32_t size = 0;
+        uint64_t ticket = 0;
+        if (umsbb_peek_message(handle_, &data, &size, &ticket) != static_cast<int>(ErrorCode::SUCCESS)) {
+            return {};
+        }
+        received_.add(size);
+        return ReadGuard(handle_, std::span<const std::byte>(static_cast<const std::byte*>(data), size), ticket);
+    }
+
+    uint32_t handle() const noexcept { return handle_; }
+    uint32_t pending() const noexcept { return umsbb_get_pending_messages(handle_); }
+    bool empty() const noexcept { return pending() == 0; }
+
+    // What this object wrote (or reserved) and borrowed, as opposed to the
+    // core's totals for the whole buffer
+    uint64_t messages_sent() const noexcept { return sent_.messages(); }
+    uint64_t messages_received() const noexcept { return received_.messages(); }
+    uint64_t bytes_sent() const noexcept { return sent_.bytes(); }
+    uint64_t bytes_received() const noexcept { return received_.bytes(); }
+
+private:
+    uint32_t handle_;
+    detail::Tally<detail::is_concurrent<ProducerPolicy>::value> sent_;
+    detail::Tally<detail::is_concurrent<ConsumerPolicy>::value> received_;
+};
+
+// Fixed-size records of T, built in the ring and copied out on receive
+template <typename T, typename ProducerPolicy = MultiProducer, typename ConsumerPolicy = MultiConsumer>
+class Channel {
+    static_assert(std::is_trivially_copyable_v<T>, "Channel<T> moves T as raw bytes");
+    // Payloads start on a cache line, which bounds what can be built in place
+    static_assert(alignof(T) <= UMSBB_CACHE_LINE_SIZE, "Channel<T> cannot align T in the ring");
+
+public:
+    explicit Channel(uint32_t size_mb = 16) : bus_(size_mb) {}
+
+    bool try_send(const T& value) noexcept { return try_emplace(value); }
+
+    // Construct the value in its ring slot
+    template <typename... Args>
+    bool try_emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+        WriteReservation slot = bus_.reserve(sizeof(T));
+        if (!slot) {
+            return false;
+        }
+        ::new (static_cast<void*>(slot.data().data())) T(std::forward<Args>(args)...);
+        return slot.commit();
+    }
+
+    // The next value, or nothing when the channel is empty. A message that
+    // is not a T was written around the channel and is consumed and reported.
+    std::optional<T> try_receive() {
+        ReadGuard guard = bus_.try_read();
+        if (!guard) {
+            return std::nullopt;
+        }
+        if (guard.size() != sizeof(T)) {
+            guard.release();
+            throw UMSBBException("Message is not a channel record", ErrorCode::CORRUPTED_DATA);
+        }
+        std::array<std::byte, sizeof(T)> raw;
+        std::memcpy(raw.data(), guard.data().data(), sizeof(T));
+        return std::bit_cast<T>(raw);
+    }
+
+    Bus<ProducerPolicy, ConsumerPolicy>& bus() noexcept { return bus_; }
+    bool empty() const noexcept { return bus_.empty(); }
+
+private:
+    Bus<ProducerPolicy, ConsumerPolicy> bus_;
+};
+
+} // namespace umsbb
+
+#endif // UMSBB_CPP_CHANNEL_HPP
@@ -12,6 +12,10 @@
 #include <mutex>
 #include <stdexcept>
 #include <cstdint>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
 
 #ifdef EMSCRIPTEN
 #include <emscripten.h>
@@ -20,6 +20,12 @@ declare namespace UMSBB {
         averageMessageSize?: number;
     }
 
+    /** Passed to a worker (postMessage, workerData); shares, never copies */
+    interface SharedBufferHandle {
+        type: 'umsbb-shared-buffer';
+        buffer: SharedArrayBuffer;
+    }
+
     interface PerformanceTestResult {
         messagesProcessed: number;
         duration: number;
@@ -41,7 +47,10 @@ export declare class UMSBBError extends Error {
  */
 export declare class UMSBBBuffer {
     static readonly SUCCESS: 0;
+    static readonly ERROR_INVALID_PARAMS: -1;
+    static readonly ERROR_BUFFER_FULL: -2;
     static readonly ERROR_BUFFER_EMPTY: -3;
+    static readonly HANDLE_TYPE: 'umsbb-shared-buffer';
     
     readonly sizeMB: number;
     readonly isInitialized: boolean;
@@ -54,11 +63,41 @@ export declare class UMSBBBuffer {
      */
     constructor(sizeMB?: number, numSegments?: number);
 
+    /**
+     * Use a buffer another thread created, from its handle()
+     */
+    static attach(handle: UMSBB.SharedBufferHandle): UMSBBBuffer;
+
     /**
      * Initialize the buffer and WebAssembly module
      */
     initialize(): Promise<void>;
 
+    /**
+     * Handle for workers; throws in mock mode (no SharedArrayBuffer)
+     */
+    handle(): UMSBB.SharedBufferHandle;
+
+    /**
+     * Synchronous write; ERROR_BUFFER_FULL when the ring has no room
+     */
+    writeSync(data: string | ArrayBuffer | ArrayBufferView | object): number;
+
+    /**
+     * Synchronous read; null when empty
+     */
+    readSync(): string | Uint8Array | object | null;
+
+    /**
+     * Block the calling worker until a message arrives; null on timeout
+     */
+    readBlocking(timeoutMs?: number): string | Uint8Array | object | null;
+
+    /**
+     * Resolve with the next message without blocking; null on timeout
+     */
+    readWait(timeoutMs?: number): Promise<string | Uint8Array | object | null>;
+
     /**
      * Write data to the buffer
      * @param data Data to write (string, ArrayBuffer, or Uint8Array)
@@ -96,6 +135,56 @@ export declare function createBuffer(sizeMB?: number, numSegments?: number): Pro
  */
 export declare function performanceTest(messageCount?: number, sizeMB?: number): Promise<void>;
 
+export interface LoadCoreOptions {
+    /** Load the shared-memory build (umsbb_core_mt*) */
+    threads?: boolean;
+    /** Force the SIMD128 build on or off; detected when omitted */
+    simd?: boolean;
+    /** Directories searched in order; default ./, ../dist/, ../../dist/ */
+    paths?: string[];
+}
+
+/**
+ * Load the compiled core: the SIMD128 build where the runtime supports it,
+ * the scalar build otherwise. Resolves to the Emscripten module.
+ */
+export declare function loadCore(options?: LoadCoreOptions): Promise<any & { umsbbBuild: string }>;
+
+/** True when the runtime validates WASM SIMD128 code */
+export declare function detectWasmSimd(): boolean;
+
+/** File stem of a core build, e.g. "umsbb_core_mt_simd" */
+export declare function coreBuildName(options?: { threads?: boolean; simd?: boolean }): string;
+
+export interface CoreBatchOptions {
+    /** Bytes in each staging region, write and read (default 1 MB) */
+    capacityBytes?: number;
+    /** Most messages per call (default 4096) */
+    maxMessages?: number;
+}
+
+export interface CoreBatchRead {
+    count: number;
+    /** 0, or the core's error code when nothing was read */
+    status: number;
+    /** Read staging region; message i is bytes.subarray(offsets[i], offsets[i] + lengths[i]) */
+    bytes: Uint8Array;
+    lengths: Uint32Array;
+    offsets: Uint32Array;
+}
+
+/**
+ * Many messages per call into a loaded core, through staging regions in
+ * linear memory. Views returned by readBatch hold until the next call.
+ */
+export declare class UMSBBCoreBatch {
+    constructor(core: any, handle: number, options?: CoreBatchOptions);
+    /** Messages the core took from the front, or a negative error code */
+    writeBatch(messages: ArrayLike<string | ArrayBuffer | ArrayBufferView>): number;
+    readBatch(maxMessages?: number): CoreBatchRead;
+    destroy(): void;
+}
+
 // Global exports for browser environment
 declare global {
     interface Window {
@@ -103,5 +192,9 @@ declare global {
         UMSBBError: typeof UMSBBError;
         createBuffer: typeof createBuffer;
         performanceTest: typeof performanceTest;
+        loadCore: typeof loadCore;
+        detectWasmSimd: typeof detectWasmSimd;
+        coreBuildName: typeof coreBuildName;
+        UMSBBCoreBatch: typeof UMSBBCoreBatch;
     }
 }
\ No newline at end of file
@@ -16,52 +16,502 @@ class UMSBBError extends Error {
     }
 }
 
+// Shared ring over a SharedArrayBuffer. Every worker holding the same
+// SharedArrayBuffer sees the same messages; postMessage of a handle shares
+// the memory instead of copying it. Writers and readers take one lock word,
+// and a consumer with nothing to read sleeps on the sequence word, which each
+// write bumps and notifies.
+const RING_LOCK = 0;        // 0 free, 1 held, 2 held with waiters
+const RING_SEQUENCE = 1;
+const RING_HEAD = 2;        // Next write offset in the data area
+const RING_TAIL = 3;        // Next read offset
+const RING_USED = 4;        // Bytes between tail and head
+const RING_CAPACITY = 5;
+const RING_PENDING = 6;
+const RING_TOTAL_MESSAGES = 7;
+const RING_TOTAL_BYTES_LO = 8;
+const RING_TOTAL_BYTES_HI = 9;
+const RING_HEADER_BYTES = 64;
+const FRAME_HEADER_BYTES = 8; // Length word, kind word
+
+const KIND_BYTES = 0;
+const KIND_STRING = 1;
+const KIND_JSON = 2;
+
+// Atomics.wait throws on a browser's main thread; spin there instead
+const CAN_BLOCK = (() => {
+    if (typeof SharedArrayBuffer === 'undefined') return false;
+    try {
+        Atomics.wait(new Int32Array(new SharedArrayBuffer(4)), 0, 1, 0);
+        return true;
+    } catch (error) {
+        return false;
+    }
+})();
+
+const textEncoder = new TextEncoder();
+const textDecoder = new TextDecoder();
+
+class UMSBBSharedRing {
+    constructor(sharedBuffer) {
+        this.sharedBuffer = sharedBuffer;
+        this.header = new Int32Array(sharedBuffer, 0, RING_HEADER_BYTES / 4);
+        this.capacity = Atomics.load(this.header, RING_CAPACITY);
+        this.data = new Uint8Array(sharedBuffer, RING_HEADER_BYTES, this.capacity);
+        this.words = new Int32Array(sharedBuffer, RING_HEADER_BYTES, this.capacity / 4);
+    }
+
+    static create(capacityBytes) {
+        const capacity = Math.max(1024, capacityBytes & ~3);
+        const ring = new SharedArrayBuffer(RING_HEADER_BYTES + capacity);
+        Atomics.store(new Int32Array(ring, 0, RING_HEADER_BYTES / 4), RING_CAPACITY, capacity);
+        return new UMSBBSharedRing(ring);
+    }
+
+    lock() {
+        const h = this.header;
+        if (Atomics.compareExchange(h, RING_LOCK, 0, 1) === 0) return;
+        let state = Atomics.exchange(h, RING_LOCK, 2);
+        while (state !== 0) {
+            if (CAN_BLOCK) Atomics.wait(h, RING_LOCK, 2);
+            state = Atomics.exchange(h, RING_LOCK, 2);
+        }
+    }
+
+    unlock() {
+        if (Atomics.exchange(this.header, RING_LOCK, 0) === 2) Atomics.notify(this.header, RING_LOCK, 1);
+    }
+
+    copyIn(offset, bytes) {
+        const first = Math.min(bytes.length, this.capacity - offset);
+        this.data.set(bytes.subarray(0, first), offset);
+        if (first < bytes.length) this.data.set(bytes.subarray(first), 0);
+    }
+
+    copyOut(offset, length) {
+        const out = new Uint8Array(length);
+        const first = Math.min(length, this.capacity - offset);
+        out.set(this.data.subarray(offset, offset + first));
+        if (first < length) out.set(this.data.subarray(0, length - first), first);
+        return out;
+    }
+
+    // False when the ring has no room; the message is not queued
+    tryWrite(bytes, kind) {
+        const frame = FRAME_HEADER_BYTES + ((bytes.length + 3) & ~3);
+        if (frame > this.capacity) {
+            throw new UMSBBError(`Message of ${bytes.length} bytes exceeds the ring`, UMSBBBuffer.ERROR_INVALID_PARAMS);
+        }
+        const h = this.header;
+        this.lock();
+        if (h[RING_USED] + frame > this.capacity) {
+            this.unlock();
+            return false;
+        }
+        const head = h[RING_HEAD];
+        this.words[head >> 2] = bytes.length;
+        this.words[((head + 4) % this.capacity) >> 2] = kind;
+        this.copyIn((head + FRAME_HEADER_BYTES) % this.capacity, bytes);
+        h[RING_HEAD] = (head + frame) % this.capacity;
+        h[RING_USED] += frame;
+        h[RING_TOTAL_MESSAGES]++;
+        const low = (h[RING_TOTAL_BYTES_LO] >>> 0) + bytes.length;
+        h[RING_TOTAL_BYTES_LO] = low | 0;
+        if (low > 0xffffffff) h[RING_TOTAL_BYTES_HI]++;
+        Atomics.add(h, RING_PENDING, 1);
+        this.unlock();
+
+        Atomics.add(h, RING_SEQUENCE, 1);
+        Atomics.notify(h, RING_SEQUENCE);
+        return true;
+    }
+
+    // { bytes, kind } or null when empty
+    tryRead() {
+        const h = this.header;
+        if (Atomics.load(h, RING_PENDING) === 0) return null;
+        this.lock();
+        if (h[RING_USED] === 0) {
+            this.unlock();
+            return null;
+        }
+        const tail = h[RING_TAIL];
+        const length = this.words[tail >> 2];
+        const kind = this.words[((tail + 4) % this.capacity) >> 2];
+        const bytes = this.copyOut((tail + FRAME_HEADER_BYTES) % this.capacity, length);
+        const frame = FRAME_HEADER_BYTES + ((length + 3) & ~3);
+        h[RING_TAIL] = (tail + frame) % this.capacity;
+        h[RING_USED] -= frame;
+        Atomics.sub(h, RING_PENDING, 1);
+        this.unlock();
+        return { bytes, kind };
+    }
+
+    // Block until a message is pending or the timeout passes; workers only
+    waitSync(timeoutMs) {
+        const h = this.header;
+        const deadline = Date.now() + timeoutMs;
+        for (;;) {
+            const seen = Atomics.load(h, RING_SEQUENCE);
+            if (Atomics.load(h, RING_PENDING) > 0) return true;
+            const remaining = deadline - Date.now();
+            if (remaining <= 0 || !CAN_BLOCK) return false;
+            Atomics.wait(h, RING_SEQUENCE, seen, remaining);
+        }
+    }
+
+    // Resolve once a message is pending or the timeout passes, without
+    // blocking the thread; polls where Atomics.waitAsync is missing
+    async waitAsync(timeoutMs) {
+        const h = this.header;
+        const deadline = Date.now() + timeoutMs;
+        for (;;) {
+            const seen = Atomics.load(h, RING_SEQUENCE);
+            if (Atomics.load(h, RING_PENDING) > 0) return true;
+            const remaining = deadline - Date.now();
+            if (remaining <= 0) return false;
+            if (typeof Atomics.waitAsync === 'function') {
+                const result = Atomics.waitAsync(h, RING_SEQUENCE, seen, remaining);
+                if (result.async) {
+                    // The timer also keeps Node's event loop alive meanwhile
+                    let timer;
+                    const expiry = new Promise(resolve => { timer = setTimeout(resolve, Math.min(remaining, 0x7fffffff)); });
+                    await Promise.race([result.value, expiry]);
+                    clearTimeout(timer);
+                }
+            } else {
+                await new Promise(resolve => setTimeout(resolve, Math.min(remaining, 1)));
+            }
+        }
+    }
+
+    stats() {
+        const h = this.header;
+        this.lock();
+        const totalMessages = h[RING_TOTAL_MESSAGES] >>> 0;
+        const totalBytes = (h[RING_TOTAL_BYTES_HI] >>> 0) * 0x100000000 + (h[RING_TOTAL_BYTES_LO] >>> 0);
+        const usedBytes = h[RING_USED];
+        this.unlock();
+        return { totalMessages, totalBytes, usedBytes, pendingMessages: Atomics.load(h, RING_PENDING) };
+    }
+}
+
+function encodeMessage(data) {
+    if (typeof data === 'string') return { bytes: textEncoder.encode(data), kind: KIND_STRING };
+    if (data instanceof Uint8Array) return { bytes: data, kind: KIND_BYTES };
+    if (data instanceof ArrayBuffer) return { bytes: new Uint8Array(data), kind: KIND_BYTES };
+    if (ArrayBuffer.isView(data)) {
+        return { bytes: new Uint8Array(data.buffer, data.byteOffset, data.byteLength), kind: KIND_BYTES };
+    }
+    return { bytes: textEncoder.encode(JSON.stringify(data)), kind: KIND_JSON };
+}
+
+function decodeMessage(message) {
+    if (message.kind === KIND_STRING) return textDecoder.decode(message.bytes);
+    if (message.kind === KIND_JSON) return JSON.parse(textDecoder.decode(message.bytes));
+    return message.bytes;
+}
+
 class UMSBBBuffer {
     static SUCCESS = 0;
+    static ERROR_INVALID_PARAMS = -1;
+    static ERROR_BUFFER_FULL = -2;
     static ERROR_BUFFER_EMPTY = -3;
+    static HANDLE_TYPE = 'umsbb-shared-buffer';
 
     constructor(sizeMB = 16) {
         this.sizeMB = sizeMB;
         this.isInitialized = false;
         this.useMockMode = false;
+        this.ring = null;
         this.mockData = { messages: [], totalWritten: 0 };
     }
 
+    // A buffer over the ring another thread created; `handle` is what its
+    // handle() returned, received through postMessage or workerData
+    static attach(handle) {
+        if (!handle || handle.type !== UMSBBBuffer.HANDLE_TYPE || !(handle.buffer instanceof SharedArrayBuffer)) {
+            throw new UMSBBError('Not a UMSBB shared buffer handle', UMSBBBuffer.ERROR_INVALID_PARAMS);
+        }
+        const buffer = new UMSBBBuffer(handle.buffer.byteLength / (1024 * 1024));
+        buffer.ring = new UMSBBSharedRing(handle.buffer);
+        buffer.isInitialized = true;
+        return buffer;
+    }
+
     async initialize() {
         if (this.isInitialized) return;
-        console.log('Initializing UMSBB buffer in mock mode');
-        this.useMockMode = true;
+        if (typeof SharedArrayBuffer !== 'undefined') {
+            this.ring = UMSBBSharedRing.create(this.sizeMB * 1024 * 1024);
+        } else {
+            // Pages without cross-origin isolation have no SharedArrayBuffer
+            console.log('Initializing UMSBB buffer in mock mode');
+            this.useMockMode = true;
+        }
         this.isInitialized = true;
     }
 
+    // Something to postMessage to a worker; the memory is shared, not copied
+    handle() {
+        if (!this.ring) {
+            throw new UMSBBError('Mock-mode buffers cannot be shared', UMSBBBuffer.ERROR_INVALID_PARAMS);
+        }
+        return { type: UMSBBBuffer.HANDLE_TYPE, buffer: this.ring.sharedBuffer };
+    }
+
+    // Synchronous forms for workers' hot loops; need an initialized buffer
+    writeSync(data) {
+        if (this.useMockMode) {
+            this.mockData.messages.push(data);
+            this.mockData.totalWritten++;
+            return UMSBBBuffer.SUCCESS;
+        }
+        const message = encodeMessage(data);
+        return this.ring.tryWrite(message.bytes, message.kind) ? UMSBBBuffer.SUCCESS : UMSBBBuffer.ERROR_BUFFER_FULL;
+    }
+
+    readSync() {
+        if (this.useMockMode) {
+            return this.mockData.messages.length === 0 ? null : this.mockData.messages.shift();
+        }
+        const message = this.ring.tryRead();
+        return message ? decodeMessage(message) : null;
+    }
+
+    // Block the calling worker until a message arrives or `timeoutMs` passes
+    readBlocking(timeoutMs = Infinity) {
+        for (;;) {
+            const message = this.readSync();
+            if (message !== null || this.useMockMode || !this.ring.waitSync(timeoutMs)) return message;
+        }
+    }
+
     async write(data) {
         if (!this.isInitialized) await this.initialize();
-        this.mockData.messages.push(data);
-        this.mockData.totalWritten++;
-        return 0;
+        return this.writeSync(data);
     }
 
     async read() {
         if (!this.isInitialized) await this.initialize();
-        if (this.mockData.messages.length === 0) return null;
-        return this.mockData.messages.shift();
+        return this.readSync();
+    }
+
+    // Resolve with the next message, or null after `timeoutMs`
+    async readWait(timeoutMs = Infinity) {
+        if (!this.isInitialized) await this.initialize();
+        const deadline = Date.now() + timeoutMs;
+        for (;;) {
+            const message = this.readSync();
+            if (message !== null || this.useMockMode) return message;
+            if (!(await this.ring.waitAsync(deadline - Date.now()))) return null;
+        }
     }
 
     async getStats() {
         if (!this.isInitialized) await this.initialize();
+        if (this.useMockMode) {
+            return {
+                totalMessages: this.mockData.totalWritten,
+                pendingMessages: this.mockData.messages.length,
+                useMockMode: this.useMockMode
+            };
+        }
+        const stats = this.ring.stats();
         return {
-            totalMessages: this.mockData.totalWritten,
-            pendingMessages: this.mockData.messages.length,
-            useMockMode: this.useMockMode
+            totalMessages: stats.totalMessages,
+            pendingMessages: stats.pendingMessages,
+            useMockMode: false,
+            totalBytes: stats.totalBytes,
+            averageMessageSize: stats.totalMessages ? stats.totalBytes / stats.totalMessages : 0
         };
     }
 
     async close() {
+        // Other holders of the handle keep the memory alive
+        this.ring = null;
         this.isInitialized = false;
         console.log('Buffer closed');
     }
 }
 
+// Smallest module using a v128 instruction (i8x16.splat, i8x16.popcnt):
+// it validates only where the runtime supports WASM SIMD128
+const WASM_SIMD_PROBE = new Uint8Array([
+    0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0,
+    10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11
+]);
+
+const CORE_SEARCH_PATHS = ['./', '../dist/', '../../dist/'];
+
+function detectWasmSimd() {
+    try {
+        return typeof WebAssembly === 'object' && WebAssembly.validate(WASM_SIMD_PROBE);
+    } catch (error) {
+        return false;
+    }
+}
+
+// File stem of a core build, as build_wasm_simple.sh / build_core.py name them
+function coreBuildName({ threads = false, simd = false } = {}) {
+    return 'umsbb_core' + (threads ? '_mt' : '') + (simd ? '_simd' : '');
+}
+
+async function loadCoreFactory(directory, stem, exportName) {
+    if (typeof window === 'undefined' && typeof importScripts === 'undefined') {
+        const path = require('path');
+        const base = path.resolve(__dirname, directory);
+        const factory = require(path.join(base, stem + '.js'));
+        return { factory, locate: (file) => path.join(base, file) };
+    }
+    const url = directory + stem + '.js';
+    if (typeof importScripts === 'function') {
+        importScripts(url);
+    } else {
+        await new Promise((resolve, reject) => {
+            const script = document.createElement('script');
+            script.src = url;
+            script.onload = resolve;
+            script.onerror = () => reject(new UMSBBError('Cannot load ' + url));
+            document.head.appendChild(script);
+        });
+    }
+    return { factory: globalThis[exportName], locate: (file) => directory + file };
+}
+
+// Load the compiled core: the SIMD128 build where the runtime supports it,
+// the scalar build otherwise, or when no SIMD build was shipped. Resolves to
+// the Emscripten module; `umsbbBuild` names the build that loaded.
+async function loadCore(options = {}) {
+    const threads = Boolean(options.threads);
+    const simd = options.simd === undefined ? detectWasmSimd() : Boolean(options.simd);
+    const paths = options.paths || CORE_SEARCH_PATHS;
+    const exportName = threads ? 'UMSBBCoreMT' : 'UMSBBCore';
+    const stems = simd ? [coreBuildName({ threads, simd: true }), coreBuildName({ threads })]
+                       : [coreBuildName({ threads })];
+
+    let lastError = null;
+    for (const stem of stems) {
+        for (const directory of paths) {
+            try {
+                const { factory, locate } = await loadCoreFactory(directory, stem, exportName);
+                if (typeof factory !== 'function') continue;
+                const core = await factory({ locateFile: locate });
+                core.umsbbBuild = stem;
+                return core;
+            } catch (error) {
+                lastError = error;
+            }
+        }
+    }
+    throw new UMSBBError('No UMSBB core build found' + (lastError ? ': ' + lastError.message : ''));
+}
+
+// Batches messages across the JS/wasm boundary for a loaded core (see
+// loadCore): writeBatch packs many messages into one staging region in
+// linear memory and makes a single _umsbb_write_batch call, and readBatch
+// drains into another with one _umsbb_read_batch call and hands back views
+// into it. Strings are encoded straight into the heap; nothing is allocated
+// or decoded per message.
+class UMSBBCoreBatch {
+    constructor(core, handle, { capacityBytes = 1024 * 1024, maxMessages = 4096 } = {}) {
+        this.core = core;
+        this.handle = handle;
+        this.capacityBytes = capacityBytes;
+        this.maxMessages = maxMessages;
+        this.writeData = core._umsbb_malloc(capacityBytes);
+        this.writeLengths = core._umsbb_malloc(maxMessages * 4);
+        this.readData = core._umsbb_malloc(capacityBytes);
+        this.readLengths = core._umsbb_malloc(maxMessages * 4);
+        this.offsets = new Uint32Array(maxMessages);
+        this.heapBuffer = null;
+        if (!this.writeData || !this.writeLengths || !this.readData || !this.readLengths) {
+            this.destroy();
+            throw new UMSBBError('Cannot allocate batch staging memory', UMSBBBuffer.ERROR_INVALID_PARAMS);
+        }
+    }
+
+    // Memory growth swaps the heap's ArrayBuffer and detaches views over the
+    // old one, so views are rebuilt whenever it changes
+    refreshViews() {
+        const heap = this.core.HEAPU8;
+        if (heap.buffer === this.heapBuffer) return;
+        this.heapBuffer = heap.buffer;
+        this.writeBytes = heap.subarray(this.writeData, this.writeData + this.capacityBytes);
+        this.writeLengthView = new Uint32Array(heap.buffer, this.writeLengths, this.maxMessages);
+        this.readBytes = heap.subarray(this.readData, this.readData + this.capacityBytes);
+        this.readLengthView = new Uint32Array(heap.buffer, this.readLengths, this.maxMessages);
+    }
+
+    // Write strings, ArrayBuffers or ArrayBuffer views in one call. Returns
+    // how many the core took, from the front, or a negative error code when
+    // it took none; messages past a full staging region or a full buffer are
+    // left for the caller to resubmit.
+    writeBatch(messages) {
+        this.refreshViews();
+        const bytes = this.writeBytes;
+        const lengths = this.writeLengthView;
+        const limit = Math.min(messages.length, this.maxMessages);
+        let used = 0;
+        let count = 0;
+        for (; count < limit; count++) {
+            const data = messages[count];
+            let size;
+            if (typeof data === 'string') {
+                // A short encode means the rest of the region was too small
+                const { read, written } = textEncoder.encodeInto(data, bytes.subarray(used));
+                if (read < data.length) break;
+                size = written;
+            } else {
+                const view = data instanceof Uint8Array ? data
+                    : ArrayBuffer.isView(data) ? new Uint8Array(data.buffer, data.byteOffset, data.byteLength)
+                    : new Uint8Array(data);
+                if (view.byteLength > this.capacityBytes - used) break;
+                bytes.set(view, used);
+                size = view.byteLength;
+            }
+            lengths[count] = size;
+            used += size;
+        }
+        if (count === 0) {
+            return messages.length === 0 ? 0 : UMSBBBuffer.ERROR_INVALID_PARAMS;
+        }
+        return this.core._umsbb_write_batch(this.handle, this.writeData, this.writeLengths, count);
+    }
+
+    // Read up to `maxMessages` in one call. Message i is
+    // bytes.subarray(offsets[i], offsets[i] + lengths[i]); the views are
+    // reused and hold only until the next readBatch. `status` is the core's
+    // error code when nothing was read (ERROR_BUFFER_EMPTY when idle).
+    readBatch(maxMessages = this.maxMessages) {
+        this.refreshViews();
+        const result = this.core._umsbb_read_batch(this.handle, this.readData, this.capacityBytes,
+                                                   this.readLengths, Math.min(maxMessages, this.maxMessages));
+        const count = result > 0 ? result : 0;
+        const lengths = this.readLengthView;
+        const offsets = this.offsets;
+        let offset = 0;
+        for (let i = 0; i < count; i++) {
+            offsets[i] = offset;
+            offset += lengths[i];
+        }
+        return {
+            count,
+            status: result > 0 ? UMSBBBuffer.SUCCESS : result,
+            bytes: this.readBytes,
+            lengths: lengths.subarray(0, count),
+            offsets: offsets.subarray(0, count)
+        };
+    }
+
+    destroy() {
+        for (const pointer of [this.writeData, this.writeLengths, this.readData, this.readLengths]) {
+            if (pointer) this.core._umsbb_free(pointer);
+        }
+        this.writeData = this.writeLengths = this.readData = this.readLengths = 0;
+        this.heapBuffer = null;
+    }
+}
+
 async function createBuffer(sizeMB = 16) {
     const buffer = new UMSBBBuffer(sizeMB);
     await buffer.initialize();
@@ -98,10 +548,18 @@ async function performanceTest(messageCount = 100) {
 
 // Exports
 if (typeof module !== 'undefined' && module.exports) {
-    module.exports = { UMSBBBuffer, UMSBBError, createBuffer, performanceTest };
+    module.exports = {
+        UMSBBBuffer, UMSBBSharedRing, UMSBBError, createBuffer, performanceTest,
+        loadCore, detectWasmSimd, coreBuildName, UMSBBCoreBatch
+    };
 } else if (typeof window !== 'undefined') {
     window.UMSBBBuffer = UMSBBBuffer;
+    window.UMSBBSharedRing = UMSBBSharedRing;
     window.UMSBBError = UMSBBError;
     window.createBuffer = createBuffer;
     window.performanceTest = performanceTest;
+    window.loadCore = loadCore;
+    window.detectWasmSimd = detectWasmSimd;
+    window.coreBuildName = coreBuildName;
+    window.UMSBBCoreBatch = UMSBBCoreBatch;
 }
\ No newline at end of file
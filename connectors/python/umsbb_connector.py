@@ -1,12 +1,16 @@
 # Python Connector for UMSBB WebAssembly Core
 # Direct memory binding without API overhead
 
+import array
 import ctypes
 import pathlib
 import threading
-from typing import Optional, Tuple, Any
+from itertools import accumulate
+from typing import Optional, Tuple, Any, Iterable, Iterator
 from dataclasses import dataclass
 
+MAX_MESSAGE_SIZE = 65536  # Core limit per message
+
 @dataclass
 class UMSBBStats:
     total_messages: int
@@ -18,6 +22,84 @@ class UMSBBError(Exception):
     """UMSBB-specific errors"""
     pass
 
+def _address(obj) -> int:
+    """Address behind a pointer argument, for the mock library"""
+    if isinstance(obj, int):
+        return obj
+    if isinstance(obj, bytes):
+        return ctypes.cast(obj, ctypes.c_void_p).value
+    if hasattr(obj, '_obj'):  # byref()
+        return ctypes.addressof(obj._obj)
+    return ctypes.addressof(obj)
+
+def _pointer_to(data):
+    """Something ctypes passes as a pointer to `data`'s bytes, without a copy
+    unless `data` is a read-only view"""
+    if isinstance(data, bytes):
+        return data
+    view = memoryview(data)
+    if view.readonly:
+        return bytes(view)
+    return (ctypes.c_char * view.nbytes).from_buffer(view)
+
+@dataclass
+class UMSBBBatch:
+    """Messages from one read_batch call, packed in `data`. The views are
+    reused and hold only until the next read_batch."""
+    count: int
+    data: memoryview
+    lengths: memoryview
+    offsets: memoryview
+
+    def __len__(self) -> int:
+        return self.count
+
+    def __getitem__(self, index: int) -> memoryview:
+        if not -self.count <= index < self.count:
+            raise IndexError("batch index out of range")
+        start = self.offsets[index]
+        return self.data[start:start + self.lengths[index]]
+
+    def __iter__(self) -> Iterator[memoryview]:
+        data = self.data
+        for start, length in zip(self.offsets, self.lengths):
+            yield data[start:start + length]
+
+class UMSBBReservation:
+    """Room for one message inside the ring. Fill `view`, then commit() it;
+    as a context manager it commits on exit, or cancels on an exception.
+    Until then the message holds back readers of its segment."""
+
+    def __init__(self, buffer: 'UMSBBBuffer', ticket: int, view: memoryview):
+        self._buffer = buffer
+        self._ticket = ticket
+        self.view = view
+
+    def commit(self, size: Optional[int] = None) -> None:
+        """Publish the first `size` bytes of the view (all of it by default)"""
+        size = self.view.nbytes if size is None else size
+        self._finish(self._buffer._lib.umsbb_commit_message, size)
+
+    def cancel(self) -> None:
+        self._finish(self._buffer._lib.umsbb_cancel_message)
+
+    def _finish(self, call, *args) -> None:
+        if self.view is None:
+            raise UMSBBError("Reservation already committed or cancelled")
+        self.view.release()
+        self.view = None
+        with self._buffer._lock:
+            result = call(self._buffer._handle, self._ticket, *args)
+        if result != UMSBBBuffer.SUCCESS:
+            raise UMSBBError(f"Reservation failed: {self._buffer._error_text(result)}")
+
+    def __enter__(self) -> 'UMSBBReservation':
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        if self.view is not None:
+            self.cancel() if exc_type else self.commit()
+
 class UMSBBBuffer:
     """Python connector for UMSBB WebAssembly core"""
     
@@ -29,6 +111,7 @@ class UMSBBBuffer:
     ERROR_INVALID_HANDLE = -4
     ERROR_MEMORY_ALLOCATION = -5
     ERROR_CORRUPTED_DATA = -6
+    ERROR_INVALID_SIZE = -8
     
     _error_messages = {
         ERROR_INVALID_PARAMS: "Invalid parameters",
@@ -36,20 +119,43 @@ class UMSBBBuffer:
         ERROR_BUFFER_EMPTY: "Buffer is empty",
         ERROR_INVALID_HANDLE: "Invalid buffer handle",
         ERROR_MEMORY_ALLOCATION: "Memory allocation failed",
-        ERROR_CORRUPTED_DATA: "Corrupted data detected"
+        ERROR_CORRUPTED_DATA: "Corrupted data detected",
+        ERROR_INVALID_SIZE: "Message larger than the target"
     }
     
-    def __init__(self, size_mb: int = 16):
+    def __init__(self, size_mb: int = 16, batch_bytes: int = 1024 * 1024, batch_messages: int = 1024):
         """
         Initialize UMSBB buffer
         
         Args:
             size_mb: Buffer size in megabytes (1-64)
+            batch_bytes: Staging space for read_batch / write_batch
+            batch_messages: Most messages per batch call
         """
         self._lib = None
         self._handle = 0
         self._lock = threading.RLock()
         
+        # Scratch reused by every call, so the hot paths allocate nothing
+        # beyond what they return
+        self._read_buffer = ctypes.create_string_buffer(MAX_MESSAGE_SIZE)
+        self._actual_size = ctypes.c_uint32()
+        self._actual_size_ref = ctypes.byref(self._actual_size)
+        self._ticket = ctypes.c_uint64()
+        self._ticket_ref = ctypes.byref(self._ticket)
+        self._batch_bytes = batch_bytes
+        self._batch_messages = batch_messages
+        self._batch_data = bytearray(batch_bytes)
+        self._batch_data_ptr = (ctypes.c_char * batch_bytes).from_buffer(self._batch_data)
+        self._batch_view = memoryview(self._batch_data)
+        self._batch_lengths = array.array('I', bytes(4 * batch_messages))
+        self._batch_offsets = array.array('I', bytes(4 * batch_messages))
+        self._batch_lengths_ptr = self._batch_lengths.buffer_info()[0]
+        self._write_data = bytearray(batch_bytes)
+        self._write_data_ptr = (ctypes.c_char * batch_bytes).from_buffer(self._write_data)
+        self._write_lengths = array.array('I', bytes(4 * batch_messages))
+        self._write_lengths_ptr = self._write_lengths.buffer_info()[0]
+        
         # Load WebAssembly module
         self._load_wasm_module()
         
@@ -96,6 +202,7 @@ class UMSBBBuffer:
             def __init__(self):
                 self._handles = {}
                 self._next_handle = 1
+                self._next_ticket = 1
                 
             def umsbb_create_buffer(self, size_mb):
                 handle = self._next_handle
@@ -117,7 +224,7 @@ class UMSBBBuffer:
                     return UMSBBBuffer.ERROR_BUFFER_FULL
                 
                 # Copy data
-                data = ctypes.string_at(data_ptr, size)
+                data = ctypes.string_at(_address(data_ptr), size)
                 self._handles[handle]['messages'].append(data)
                 self._handles[handle]['total_messages'] += 1
                 self._handles[handle]['total_bytes'] += size
@@ -130,14 +237,58 @@ class UMSBBBuffer:
                 if not self._handles[handle]['messages']:
                     return UMSBBBuffer.ERROR_BUFFER_EMPTY
                 
+                if len(self._handles[handle]['messages'][0]) > buffer_size:
+                    return UMSBBBuffer.ERROR_INVALID_SIZE
                 message = self._handles[handle]['messages'].pop(0)
-                if len(message) > buffer_size:
-                    return UMSBBBuffer.ERROR_INVALID_PARAMS
                 
-                ctypes.memmove(buffer_ptr, message, len(message))
-                ctypes.c_uint32.from_address(actual_size_ptr).value = len(message)
+                ctypes.memmove(_address(buffer_ptr), message, len(message))
+                ctypes.c_uint32.from_address(_address(actual_size_ptr)).value = len(message)
                 return UMSBBBuffer.SUCCESS
             
+            def umsbb_write_batch(self, handle, data_ptr, lengths_ptr, count):
+                lengths = (ctypes.c_uint32 * count).from_address(_address(lengths_ptr))
+                address = _address(data_ptr)
+                for written, size in enumerate(lengths):
+                    result = self.umsbb_write_message(handle, address, size)
+                    if result != UMSBBBuffer.SUCCESS:
+                        return written or result
+                    address += size
+                return count
+            
+            def umsbb_read_batch(self, handle, buffer_ptr, capacity, lengths_ptr, max_messages):
+                lengths = (ctypes.c_uint32 * max_messages).from_address(_address(lengths_ptr))
+                address, used, taken = _address(buffer_ptr), 0, 0
+                result = UMSBBBuffer.ERROR_BUFFER_EMPTY
+                actual = ctypes.c_uint32()
+                while taken < max_messages:
+                    result = self.umsbb_read_message(handle, address + used, capacity - used, ctypes.byref(actual))
+                    if result != UMSBBBuffer.SUCCESS:
+                        break
+                    lengths[taken] = actual.value
+                    used += actual.value
+                    taken += 1
+                return taken or result
+            
+            def umsbb_reserve_message(self, handle, size, ticket_ptr):
+                if handle not in self._handles:
+                    return None
+                space = ctypes.create_string_buffer(size)
+                ticket = self._next_ticket
+                self._next_ticket += 1
+                self._handles[handle].setdefault('reservations', {})[ticket] = space
+                ctypes.c_uint64.from_address(_address(ticket_ptr)).value = ticket
+                return ctypes.addressof(space)
+            
+            def umsbb_commit_message(self, handle, ticket, size):
+                space = self._handles.get(handle, {}).get('reservations', {}).pop(ticket, None)
+                if space is None or not 0 < size <= len(space):
+                    return UMSBBBuffer.ERROR_INVALID_PARAMS
+                return self.umsbb_write_message(handle, ctypes.addressof(space), size)
+            
+            def umsbb_cancel_message(self, handle, ticket):
+                space = self._handles.get(handle, {}).get('reservations', {}).pop(ticket, None)
+                return UMSBBBuffer.ERROR_INVALID_PARAMS if space is None else UMSBBBuffer.SUCCESS
+            
             def umsbb_get_total_messages(self, handle):
                 return self._handles.get(handle, {}).get('total_messages', 0)
             
@@ -157,7 +308,7 @@ class UMSBBBuffer:
     
     def _configure_function_signatures(self):
         """Configure ctypes function signatures"""
-        if hasattr(self._lib, 'argtypes'):  # Real ctypes library
+        if isinstance(self._lib, ctypes.CDLL):  # Real ctypes library
             # umsbb_create_buffer
             self._lib.umsbb_create_buffer.argtypes = [ctypes.c_uint32]
             self._lib.umsbb_create_buffer.restype = ctypes.c_uint32
@@ -179,30 +330,48 @@ class UMSBBBuffer:
             
             self._lib.umsbb_get_pending_messages.argtypes = [ctypes.c_uint32]
             self._lib.umsbb_get_pending_messages.restype = ctypes.c_uint32
+            
+            # Batches and in-place writes
+            self._lib.umsbb_write_batch.argtypes = [ctypes.c_uint32, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_uint32]
+            self._lib.umsbb_write_batch.restype = ctypes.c_int
+            
+            self._lib.umsbb_read_batch.argtypes = [ctypes.c_uint32, ctypes.c_void_p, ctypes.c_uint32, ctypes.c_void_p, ctypes.c_uint32]
+            self._lib.umsbb_read_batch.restype = ctypes.c_int
+            
+            self._lib.umsbb_reserve_message.argtypes = [ctypes.c_uint32, ctypes.c_uint32, ctypes.POINTER(ctypes.c_uint64)]
+            self._lib.umsbb_reserve_message.restype = ctypes.c_void_p
+            
+            self._lib.umsbb_commit_message.argtypes = [ctypes.c_uint32, ctypes.c_uint64, ctypes.c_uint32]
+            self._lib.umsbb_commit_message.restype = ctypes.c_int
+            
+            self._lib.umsbb_cancel_message.argtypes = [ctypes.c_uint32, ctypes.c_uint64]
+            self._lib.umsbb_cancel_message.restype = ctypes.c_int
+            
+            self._lib.umsbb_destroy_buffer.argtypes = [ctypes.c_uint32]
+            self._lib.umsbb_destroy_buffer.restype = ctypes.c_int
     
-    def write(self, data: bytes) -> None:
+    def _error_text(self, result: int) -> str:
+        return self._error_messages.get(result, f"Unknown error: {result}")
+    
+    def write(self, data) -> None:
         """
         Write message to buffer
         
         Args:
-            data: Message data as bytes
+            data: Message data as bytes, bytearray or memoryview
             
         Raises:
             UMSBBError: If write operation fails
         """
+        size = len(data) if isinstance(data, bytes) else memoryview(data).nbytes
+        if size > MAX_MESSAGE_SIZE:
+            raise ValueError("Message too large (max 64KB)")
+        
         with self._lock:
-            if not isinstance(data, (bytes, bytearray)):
-                raise TypeError("Data must be bytes or bytearray")
-            
-            if len(data) > 65536:  # 64KB max message size
-                raise ValueError("Message too large (max 64KB)")
-            
-            data_ptr = ctypes.cast(data, ctypes.c_void_p)
-            result = self._lib.umsbb_write_message(self._handle, data_ptr, len(data))
-            
-            if result != self.SUCCESS:
-                error_msg = self._error_messages.get(result, f"Unknown error: {result}")
-                raise UMSBBError(f"Write failed: {error_msg}")
+            result = self._lib.umsbb_write_message(self._handle, _pointer_to(data), size)
+        
+        if result != self.SUCCESS:
+            raise UMSBBError(f"Write failed: {self._error_text(result)}")
     
     def read(self, timeout_ms: int = 0) -> Optional[bytes]:
         """
@@ -218,23 +387,121 @@ class UMSBBBuffer:
             UMSBBError: If read operation fails
         """
         with self._lock:
-            buffer = ctypes.create_string_buffer(65536)  # 64KB buffer
-            actual_size = ctypes.c_uint32()
-            
             result = self._lib.umsbb_read_message(
                 self._handle, 
-                buffer, 
-                65536, 
-                ctypes.byref(actual_size)
+                self._read_buffer, 
+                MAX_MESSAGE_SIZE, 
+                self._actual_size_ref
             )
             
             if result == self.ERROR_BUFFER_EMPTY:
                 return None
             elif result != self.SUCCESS:
-                error_msg = self._error_messages.get(result, f"Unknown error: {result}")
-                raise UMSBBError(f"Read failed: {error_msg}")
+                raise UMSBBError(f"Read failed: {self._error_text(result)}")
+            
+            return ctypes.string_at(self._read_buffer, self._actual_size.value)
+    
+    def read_into(self, target) -> Optional[int]:
+        """
+        Read the next message into a writable buffer (bytearray, memoryview,
+        mmap, numpy array...) without an intermediate copy
+        
+        Returns:
+            Bytes written to `target`, or None if empty
             
-            return buffer.raw[:actual_size.value]
+        Raises:
+            UMSBBError: If the message does not fit or the read fails
+        """
+        view = memoryview(target)
+        if view.readonly:
+            raise TypeError("Target must be writable")
+        destination = (ctypes.c_char * view.nbytes).from_buffer(view)
+        
+        with self._lock:
+            result = self._lib.umsbb_read_message(self._handle, destination, view.nbytes, self._actual_size_ref)
+            if result == self.ERROR_BUFFER_EMPTY:
+                return None
+            elif result != self.SUCCESS:
+                raise UMSBBError(f"Read failed: {self._error_text(result)}")
+            return self._actual_size.value
+    
+    def read_batch(self, max_messages: Optional[int] = None) -> UMSBBBatch:
+        """
+        Read up to `max_messages` in one native call into staging space
+        allocated once. The batch's views are reused by the next call; copy
+        anything kept longer.
+        
+        Returns:
+            The batch; empty when the buffer is
+        """
+        limit = self._batch_messages if max_messages is None else min(max_messages, self._batch_messages)
+        with self._lock:
+            result = self._lib.umsbb_read_batch(self._handle, self._batch_data_ptr, self._batch_bytes,
+                                                self._batch_lengths_ptr, limit)
+            if result < 0 and result != self.ERROR_BUFFER_EMPTY:
+                raise UMSBBError(f"Read failed: {self._error_text(result)}")
+            
+            count = max(result, 0)
+            if count:
+                self._batch_offsets[0:count] = array.array('I', accumulate(self._batch_lengths[0:count - 1], initial=0))
+            return UMSBBBatch(count, self._batch_view,
+                              memoryview(self._batch_lengths)[:count],
+                              memoryview(self._batch_offsets)[:count])
+    
+    def write_batch(self, messages: Iterable) -> int:
+        """
+        Write messages in one native call. Stops early when the staging
+        space or the buffer fills.
+        
+        Returns:
+            How many messages from the front were written
+            
+        Raises:
+            UMSBBError: If none could be written for a reason other than a
+            full buffer
+        """
+        with self._lock:
+            data, lengths = self._write_data, self._write_lengths
+            used = count = 0
+            for message in messages:
+                size = len(message) if isinstance(message, bytes) else memoryview(message).nbytes
+                if count == self._batch_messages or used + size > self._batch_bytes:
+                    break
+                data[used:used + size] = message
+                lengths[count] = size
+                used += size
+                count += 1
+            if count == 0:
+                return 0
+            
+            result = self._lib.umsbb_write_batch(self._handle, self._write_data_ptr, self._write_lengths_ptr, count)
+            if result == self.ERROR_BUFFER_FULL:
+                return 0
+            if result < 0:
+                raise UMSBBError(f"Write failed: {self._error_text(result)}")
+            return result
+    
+    def reserve(self, size: int) -> UMSBBReservation:
+        """
+        Reserve room for a message of up to `size` bytes and return a
+        writable view into the ring, so a producer builds it in place:
+        
+            with buffer.reserve(256) as slot:
+                n = encode_into(slot.view)
+                slot.commit(n)
+        
+        Raises:
+            UMSBBError: If the buffer is full
+        """
+        if not 0 < size <= MAX_MESSAGE_SIZE:
+            raise ValueError("Reservation size must be between 1 byte and 64KB")
+        
+        with self._lock:
+            address = self._lib.umsbb_reserve_message(self._handle, size, self._ticket_ref)
+            if not address:
+                raise UMSBBError(f"Reserve failed: {self._error_text(self.ERROR_BUFFER_FULL)}")
+            view = memoryview((ctypes.c_char * size).from_address(address)).cast('B')
+            return UMSBBReservation(self, self._ticket.value, view)
     
     def get_stats(self) -> UMSBBStats:
         """Get buffer statistics"""
@@ -68,7 +68,7 @@ double benchmark_operation(UniversalMultiSegmentedBiBufferBus* bus, char* data,
         size_t received_size;
         void* received_data = umsbb_drain_from(bus, i % bus->segment_count, &received_size);
         if (received_data) {
-            free(received_data);
+            umsbb_message_release(received_data);
         }
     }
     
@@ -213,7 +213,7 @@ int main() {
             if (received) {
                 printf("  Data integrity: %s\n", 
                        (received_size == gpu_test_size) ? "VERIFIED" : "CORRUPTED");
-                free(received);
+                umsbb_message_release(received);
             }
             
             free(gpu_data);
@@ -248,7 +248,7 @@ int main() {
             void* received = umsbb_drain_from(bus, i % bus->segment_count, &received_size);
             if (received) {
                 drained_count++;
-                free(received);
+                umsbb_message_release(received);
             }
         }
         
@@ -273,7 +273,7 @@ int main() {
     printf("Bus configuration:\n");
     printf("  Segments: %u\n", bus->segment_count);
     printf("  GPU enabled: %s\n", bus->gpu_enabled ? "Yes" : "No");
-    printf("  Total operations: %llu\n", (unsigned long long)bus->total_operations);
+    printf("  Total operations: %llu\n", (unsigned long long)atomic_load_size(&bus->total_operations));
     printf("  Final load factor: %.3f\n", umsbb_get_load_factor(bus));
     
     if (gpu_initialized) {
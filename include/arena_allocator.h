@@ -1,13 +1,53 @@
 #pragma once
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include "portable_atomic.h"
+
+/*
+Arena Allocator
+
+Per-thread bump allocation from chunked blocks. Every thread that allocates
+from an arena gets its own block chain, so the fast path is a pointer bump
+with no shared writes. Allocations are released in the order their thread
+made them (the natural order of a lane); each release advances that thread's
+release cursor, and a full block is recycled as soon as the cursor has passed
+its last allocation. In steady state no heap calls are made.
+*/
+
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+#define ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define ARENA_ALIGNMENT 16      // Alignment of arena_alloc results
+
+/* Back blocks with huge pages where the OS allows it (falls back silently). */
+#define ARENA_FLAG_HUGE_PAGES 0x1u
+
+typedef struct ArenaThread ArenaThread;
 
 typedef struct {
-    uint8_t* memory;
-    size_t capacity;
-    size_t offset;
+    size_t capacity;        // Upper bound on bytes held in blocks (0 = unbounded)
+    size_t blockSize;       // Bytes per regular block
+    uint32_t flags;
+    size_t id;              // Distinguishes arenas reusing the same address
+    atomic_size_t reserved; // Bytes currently held in blocks
+    atomic_size_t threads;  // Head of the ArenaThread list (pointer bits)
 } ArenaAllocator;
 
 void arena_init(ArenaAllocator* arena, size_t cap);
+bool arena_init_ex(ArenaAllocator* arena, size_t cap, size_t blockSize, uint32_t flags);
+
+/* ARENA_ALIGNMENT-aligned memory from the calling thread's block, or NULL at capacity. */
 void* arena_alloc(ArenaAllocator* arena, size_t size);
-void arena_reset(ArenaAllocator* arena);
\ No newline at end of file
+/* `align` must be a power of two. */
+void* arena_alloc_aligned(ArenaAllocator* arena, size_t size, size_t align);
+
+/*
+ * Mark an allocation as consumed; may be called from any thread. Releases of
+ * one producer thread's allocations must happen in allocation order.
+ */
+void arena_release(void* ptr);
+
+/* Recycle every block at once; only while no allocation is in use. */
+void arena_reset(ArenaAllocator* arena);
+void arena_destroy(ArenaAllocator* arena);
+size_t arena_reserved(ArenaAllocator* arena);
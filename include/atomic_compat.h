@@ -63,10 +63,16 @@
         // Additional type definitions for compatibility
         typedef _Atomic(uint32_t) atomic_uint32_t;
         typedef _Atomic(uint64_t) atomic_uint64_t;
+        #ifndef UMSBB_ATOMIC
+        #define UMSBB_ATOMIC(T) _Atomic(T)
+        #endif
     #else
         // Fallback to GCC builtins
         #define _Atomic(T) volatile T
         #define _Alignas(x) __attribute__((aligned(x)))
+        #ifndef UMSBB_ATOMIC
+        #define UMSBB_ATOMIC(T) volatile T
+        #endif
         
         typedef volatile int atomic_int;
         typedef volatile unsigned int atomic_uint;
@@ -103,6 +109,9 @@
     #warning "Unknown compiler, using basic volatile operations (not thread-safe)"
     #define _Atomic(T) volatile T
     #define _Alignas(x) 
+    #ifndef UMSBB_ATOMIC
+    #define UMSBB_ATOMIC(T) volatile T
+    #endif
     
     typedef volatile int atomic_int;
     typedef volatile unsigned int atomic_uint;
@@ -0,0 +1,113 @@
+/*
+ * Universal Multi-Segmented Bi-Buffer Bus (UMSBB) - Batch Kernels
+ *
+ * Copyright (c) 2025 Kushagra Dubey
+ * Licensed under the MIT License - see LICENSE file for details.
+ *
+ * Per-record work run over a whole packed batch, so the GPU pipeline and
+ * its host fallback share one implementation and produce identical results:
+ *
+ * - Integrity: each record is checked against the checksum its producer
+ *   recorded, under that record's policy (checksum_engine, which already
+ *   dispatches to SSE4.2/AVX2/ARMv8 CRC).
+ * - Transforms: kernels registered by id and chained per pipeline. A kernel
+ *   rewrites its record in place, may shorten it (*length) and may drop it
+ *   by returning false. Built in:
+ *     BSWAP16/32/64  reverse the bytes of every whole 16/32/64-bit word
+ *                    (trailing bytes stay put); SSSE3/AVX2 where available
+ *     FILTER         keep records whose byte at `offset` masked by `mask`
+ *                    equals `value` (batch_filter_t); shorter ones are dropped
+ *     PROJECT        keep `length` bytes from `offset` (batch_projection_t)
+ *
+ * The registry is process-wide. Register user kernels at startup, before
+ * the pipelines that name them are started: a pipeline resolves its chain
+ * once, when it starts.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "checksum_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BATCH_KERNEL_MAX_ID 64
+#define BATCH_KERNEL_MAX_CHAIN 4
+
+typedef enum {
+    BATCH_KERNEL_NONE = 0,
+    BATCH_KERNEL_BSWAP16 = 1,
+    BATCH_KERNEL_BSWAP32 = 2,
+    BATCH_KERNEL_BSWAP64 = 3,
+    BATCH_KERNEL_FILTER = 4,
+    BATCH_KERNEL_PROJECT = 5,
+    BATCH_KERNEL_FIRST_USER = 16
+} batch_kernel_id_t;
+
+typedef enum {
+    BATCH_RECORD_OK = 0,
+    BATCH_RECORD_CORRUPT = 1,       // Failed its checksum; never transformed
+    BATCH_RECORD_FILTERED = 2       // Dropped by a kernel
+} batch_record_status_t;
+
+/* Process one record in place; false drops it. `params` is the chain step's. */
+typedef bool (*batch_kernel_fn)(const void* params, uint8_t* data, uint32_t* length, uint32_t lane);
+
+typedef struct {
+    uint32_t id;
+    const void* params;             // Must outlive the pipelines using the step
+} batch_kernel_step_t;
+
+typedef struct {
+    uint32_t offset;
+    uint8_t mask;
+    uint8_t value;
+} batch_filter_t;
+
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+} batch_projection_t;
+
+/* Claim a user id (BATCH_KERNEL_FIRST_USER..BATCH_KERNEL_MAX_ID-1); false if
+ * it is out of range or taken. Not thread-safe. */
+bool batch_kernel_register(uint32_t id, batch_kernel_fn fn);
+void batch_kernel_unregister(uint32_t id);
+/* NULL for an id nothing is registered under. */
+batch_kernel_fn batch_kernel_lookup(uint32_t id);
+
+/* A chain with each step's kernel looked up; resolve once, run often. */
+typedef struct {
+    batch_kernel_fn fns[BATCH_KERNEL_MAX_CHAIN];
+    const void* params[BATCH_KERNEL_MAX_CHAIN];
+    uint32_t steps;
+} batch_kernel_chain_t;
+
+/* False if there are too many steps or one names an unregistered id. */
+bool batch_kernel_resolve(batch_kernel_chain_t* chain, const batch_kernel_step_t* steps, uint32_t count);
+
+/* Verify each record of a packed batch, then run the chain over the intact
+ * ones. policies/checksums may be NULL (nothing to verify). Records are
+ * data + offsets[i], lengths[i] bytes; lengths shrink as kernels shorten
+ * them. status[i] receives a batch_record_status_t; returns the records
+ * left BATCH_RECORD_OK. */
+uint32_t batch_kernels_process(const batch_kernel_chain_t* chain, uint8_t* data, const uint64_t* offsets,
+                               uint32_t* lengths, const uint32_t* lanes, const uint8_t* policies,
+                               const uint32_t* checksums, uint8_t* status, uint32_t count);
+
+/* Byte swaps as used by the built-in kernels, for callers outside a batch. */
+void batch_bswap16(uint8_t* data, size_t size);
+void batch_bswap32(uint8_t* data, size_t size);
+void batch_bswap64(uint8_t* data, size_t size);
+
+/* Run the scalar byte swaps only, to cross-check the vector paths. */
+void batch_kernels_force_scalar(bool scalar);
+/* "scalar", "ssse3" or "avx2": what the byte swaps run on, for diagnostics. */
+const char* batch_kernels_impl_name(void);
+
+#ifdef __cplusplus
+}
+#endif
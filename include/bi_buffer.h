@@ -8,6 +8,7 @@
 #pragma once
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #define SOMA_ALIGNMENT 64
 
@@ -24,32 +25,163 @@
 #  define SOMA_ALIGNED_TYPE(type, bytes) _Alignas(bytes) type
 #endif
 
+#if defined(_MSC_VER)
+#  define SOMA_THREAD_LOCAL __declspec(thread)
+#else
+#  define SOMA_THREAD_LOCAL _Thread_local
+#endif
+
 /* Message State Machine: FREE → READY → CONSUMING → FEEDBACK */
 typedef enum {
     MSG_STATE_FREE = 0,      // Available for new message
     MSG_STATE_READY = 1,     // Message written, ready to consume
     MSG_STATE_CONSUMING = 2, // Being processed
-    MSG_STATE_FEEDBACK = 3   // Processing complete, ready for feedback
+    MSG_STATE_FEEDBACK = 3,  // Processing complete, ready for feedback
+    MSG_STATE_PADDING = 4,   // Skip marker: rest of the ring is unused, wrap to 0
+    MSG_STATE_SKIP = 5       // Unused frame (cancelled or trimmed claim), `length` gives its extent
 } MessageState;
 
+/*
+ * Inline frame header. Every record in regionA is laid out as
+ * [BiBufferFrame][payload bytes][pad to BI_BUFFER_FRAME_ALIGN], so producers
+ * write the payload exactly once and consumers read it in place.
+ *
+ * The ring is circular: capacity is a power of two, the indices grow
+ * monotonically and are masked on access. A frame that does not fit before
+ * the end of regionA is preceded by a MSG_STATE_PADDING frame covering the
+ * tail, and is placed at offset 0 instead.
+ */
 typedef struct {
-        void* regionA;      // Primary buffer
-        void* regionB;      // Secondary buffer  
-        void* regionC;      // Feedback/metadata region
-        size_t capacity;
+    uint16_t state;     // MessageState of this record
+    uint16_t flags;     // Producer-defined bits (checksum policy in the low bits)
+    uint32_t length;    // Payload bytes following the header
+    uint32_t sequence;  // Bus-level sequence number
+    uint32_t checksum;  // Payload checksum, filled in by the producer
+} BiBufferFrame;
+
+#define BI_BUFFER_FRAME_ALIGN 16
+#define BI_BUFFER_FRAME_SIZE(len) \
+    ((sizeof(BiBufferFrame) + (size_t)(len) + (BI_BUFFER_FRAME_ALIGN - 1)) & ~(size_t)(BI_BUFFER_FRAME_ALIGN - 1))
+
+#define BI_BUFFER_MIN_CAPACITY 256
 
+/*
+ * Producer model of a buffer.
+ * SINGLE: one producer; commits publish commitIndex in order.
+ * MPSC:   many producers reserve with a CAS on writeIndex and may commit out
+ *         of order; each frame's start granule in regionC carries its
+ *         MessageState and the consumer stops at the first frame that has
+ *         not been committed yet.
+ * SPSC:   one producer, one consumer. Each side keeps a private copy of the
+ *         other side's index on its own cache line and only reloads it when
+ *         the ring looks full (producer) or empty (consumer).
+ */
+typedef enum {
+    BI_BUFFER_MODE_SINGLE = 0,
+    BI_BUFFER_MODE_MPSC = 1,
+    BI_BUFFER_MODE_SPSC = 2
+} BiBufferMode;
+
+/* Header of the record whose payload starts at `payload`. */
+static inline BiBufferFrame* bi_buffer_frame(void* payload) {
+    return (BiBufferFrame*)((uint8_t*)payload - sizeof(BiBufferFrame));
+}
+
+/*
+ * One generation of ring storage. A buffer starts with a single region;
+ * bi_buffer_resize installs a successor which the producer switches to at
+ * its next claim (a frame boundary). The old region is sealed at the
+ * switch index, the consumer drains it up to the seal, jumps to the
+ * successor's base and frees the old storage. Indices stay monotonic
+ * across generations, so readIndex/commitIndex never move backwards.
+ *
+ * A stalled MPSC producer may still read a slot's geometry while a later
+ * resize reuses it, so regionA and the geometry are atomics written relaxed
+ * and published by the release on `pending`/`produce`.
+ */
+typedef struct {
+        atomic_voidptr regionA;     // Primary buffer
+        void* regionB;              // Secondary buffer
+        void* regionC;              // Feedback/metadata region (per-granule frame state in MPSC mode)
+        atomic_size_t capacity;     // Power of two
+        atomic_size_t mask;         // capacity - 1
+        atomic_size_t base;         // First ring index stored in this region
+        atomic_size_t sealIndex;    // Index where producers moved on, BI_BUFFER_UNSEALED while live
+        atomic_size_t next;         // Slot of the successor region
+        atomic_size_t inUse;        // Slot is owned by the buffer (0 = free for bi_buffer_resize)
+} BiBufferRegion;
+
+#define BI_BUFFER_MAX_REGIONS 4
+#define BI_BUFFER_UNSEALED SIZE_MAX
+
+typedef struct {
+        BiBufferRegion regions[BI_BUFFER_MAX_REGIONS];
+        BiBufferMode mode;
+
+        // Producer-owned cache line
         SOMA_ALIGNED_TYPE(atomic_size_t, SOMA_ALIGNMENT) writeIndex;
+        size_t cachedReadIndex;     // Producer's copy of readIndex (SPSC)
+        atomic_size_t produce;      // Slot of the region producers write into
+        atomic_size_t pending;      // Slot + 1 of a region waiting for the producer, 0 if none
+
+        // Consumer-owned cache line
         SOMA_ALIGNED_TYPE(atomic_size_t, SOMA_ALIGNMENT) readIndex;
+        size_t cachedCommitIndex;   // Consumer's copy of commitIndex (SPSC)
+        size_t consume;             // Slot of the region holding readIndex
+
         SOMA_ALIGNED_TYPE(atomic_size_t, SOMA_ALIGNMENT) commitIndex;  // Track committed messages
         SOMA_ALIGNED_TYPE(atomic_size_t, SOMA_ALIGNMENT) feedbackIndex; // Track feedback processed
 } BiBuffer;
 
+/* Capacity is rounded up to a power of two (at least BI_BUFFER_MIN_CAPACITY). */
 void bi_buffer_init(BiBuffer* buf, size_t cap);
+void bi_buffer_init_mode(BiBuffer* buf, size_t cap, BiBufferMode mode);
+/* Heap buffer on its own cache lines (NULL on failure); release with bi_buffer_free. */
+BiBuffer* bi_buffer_create(size_t cap, BiBufferMode mode);
+void bi_buffer_free(BiBuffer* buf);
+/* Change the producer model; fails (returns false) unless the buffer is empty. */
+bool bi_buffer_set_mode(BiBuffer* buf, BiBufferMode mode);
+
+/* Reserve a frame for `size` payload bytes; returns the payload pointer or NULL. */
 void* bi_buffer_claim(BiBuffer* buf, size_t size);
+/* Publish a frame previously returned by bi_buffer_claim with `size` payload
+ * bytes, at most the size claimed; consumers pass over the unused rest. */
 void bi_buffer_commit(BiBuffer* buf, void* ptr, size_t size);
+/* Give up a claimed frame without publishing it; consumers pass over it. */
+void bi_buffer_cancel(BiBuffer* buf, void* ptr);
+/* Payload of the oldest committed frame (length in *size), or NULL if empty. */
 void* bi_buffer_read(BiBuffer* buf, size_t* size);
+/* Retire the frame returned by the last bi_buffer_read. */
 void bi_buffer_release(BiBuffer* buf);
-void bi_buffer_resize(BiBuffer* buf, size_t newCap);
+
+/*
+ * Batch consumption. Start a cursor at bi_buffer_read_cursor(), call
+ * bi_buffer_peek repeatedly to walk committed frames in place (the cursor
+ * moves past each one), then retire everything before the cursor with a
+ * single bi_buffer_release_to.
+ */
+size_t bi_buffer_read_cursor(BiBuffer* buf);
+void* bi_buffer_peek(BiBuffer* buf, size_t* cursor, size_t* size);
+void bi_buffer_release_to(BiBuffer* buf, size_t cursor);
+/* Cursor just past the frame whose payload is `payload` (a peeked frame). */
+size_t bi_buffer_cursor_after(BiBuffer* buf, const void* payload);
+
+/*
+ * Lossless online resize. Allocates a region of `newCap` (rounded like
+ * bi_buffer_init) that producers move to at their next claim; frames already
+ * in the ring stay readable and the old storage is freed once the consumer
+ * has drained it. Safe to call from any thread while traffic flows. Fails if
+ * allocation fails or a previous resize has not been taken up yet.
+ */
+bool bi_buffer_resize(BiBuffer* buf, size_t newCap);
+/* Capacity of the region producers are currently writing. */
+size_t bi_buffer_capacity(BiBuffer* buf);
+/* Capacity producers are moving to: that of a resize not taken up yet, else
+ * bi_buffer_capacity. */
+size_t bi_buffer_target_capacity(BiBuffer* buf);
+/* Bytes between the consumer and the producers, claims and padding included:
+ * a load signal for heuristics, not an exact count. */
+size_t bi_buffer_backlog(BiBuffer* buf);
 void bi_buffer_destroy(BiBuffer* buf);
 
 /* State machine operations */
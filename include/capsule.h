@@ -4,7 +4,7 @@
 
 typedef struct {
     uint32_t sequence;
-    uint64_t timestamp;
+    uint64_t timestamp;     // umsbb_clock_coarse_ns() at wrap
     uint32_t checksum;
 } CapsuleHeader;
 
@@ -0,0 +1,73 @@
+/*
+ * Universal Multi-Segmented Bi-Buffer Bus (UMSBB) - Checksum Engine
+ *
+ * Copyright (c) 2025 Kushagra Dubey
+ * Licensed under the MIT License - see LICENSE file for details.
+ *
+ * One checksum implementation shared by the capsule layer, the complete core
+ * and the WebAssembly core.
+ *
+ * - STRONG: CRC32C (Castagnoli). Uses the SSE4.2 crc32 instruction on x86 and
+ *   the ARMv8 CRC extension on AArch64, with a slicing-by-8 table fallback.
+ * - FAST:   a 64-bit stripe hash in the style of xxHash3 (8 x 64-bit lanes,
+ *   32x32->64 multiply-accumulate per 64-byte stripe), folded to 32 bits for
+ *   message headers. Vectorised for SSE2, AVX2 and WASM SIMD128; every path
+ *   produces bit-identical results so producers and consumers may run on
+ *   different CPUs.
+ * - NONE:   checksums are neither computed nor verified.
+ *
+ * The best implementation is picked once at runtime from the CPU features.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    CHECKSUM_POLICY_NONE = 0,
+    CHECKSUM_POLICY_FAST = 1,
+    CHECKSUM_POLICY_STRONG = 2
+} checksum_policy_t;
+
+#define CHECKSUM_POLICY_DEFAULT CHECKSUM_POLICY_FAST
+#define CHECKSUM_POLICY_MASK 0x3u
+
+typedef enum {
+    CHECKSUM_IMPL_SCALAR = 0,
+    CHECKSUM_IMPL_SSE2,
+    CHECKSUM_IMPL_SSE42,
+    CHECKSUM_IMPL_AVX2,
+    CHECKSUM_IMPL_ARMV8_CRC,
+    CHECKSUM_IMPL_WASM_SIMD128
+} checksum_impl_t;
+
+/* CRC32C of `data`. */
+uint32_t checksum_crc32c(const void* data, size_t size);
+
+/* 64-bit fast hash of `data`. */
+uint64_t checksum_fast64(const void* data, size_t size);
+
+/* 32-bit header checksum under `policy` (0 for CHECKSUM_POLICY_NONE). */
+uint32_t checksum_compute(checksum_policy_t policy, const void* data, size_t size);
+
+/* True if `expected` matches `data` under `policy`; always true for NONE. */
+bool checksum_verify(checksum_policy_t policy, const void* data, size_t size, uint32_t expected);
+
+/* Implementations selected by runtime dispatch (for diagnostics). */
+checksum_impl_t checksum_crc32c_impl(void);
+checksum_impl_t checksum_fast_impl(void);
+const char* checksum_impl_name(checksum_impl_t impl);
+
+/* Pin an implementation, e.g. SCALAR to cross-check the vector paths.
+ * SCALAR resets both families; other values replace only the family they
+ * belong to. Returns false if this CPU/build cannot run `impl`. */
+bool checksum_force_impl(checksum_impl_t impl);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+CPU Topology
+
+Which logical CPUs share a physical core, and which NUMA node each belongs
+to, read from sysfs on Linux and GetLogicalProcessorInformationEx on
+Windows. Elsewhere every online CPU is reported as its own core on node 0.
+
+cpu_topology_spread orders CPUs for placing threads: every physical core of
+node 0, then of node 1, and so on, and only then the second hyperthread of
+each core. Threads placed in that order share neither a core nor, as long as
+a node has room, a memory controller.
+*/
+
+#define CPU_TOPOLOGY_MAX_CPUS 256
+
+typedef struct {
+    uint32_t cpu;           // OS CPU number (group * 64 + index on Windows)
+    uint32_t core;          // Physical core, dense from 0
+    uint32_t node;          // NUMA node
+    uint32_t smt_index;     // 0 for the first hyperthread of its core
+} cpu_topology_cpu_t;
+
+typedef struct {
+    uint32_t cpu_count;
+    uint32_t core_count;
+    uint32_t node_count;
+    cpu_topology_cpu_t cpus[CPU_TOPOLOGY_MAX_CPUS];   // Ascending cpu number
+} cpu_topology_t;
+
+/* Fill `topology`; false only if not even the CPU count is available. */
+bool cpu_topology_discover(cpu_topology_t* topology);
+/* Entry for OS CPU `cpu`, or NULL if it is not online. */
+const cpu_topology_cpu_t* cpu_topology_find(const cpu_topology_t* topology, uint32_t cpu);
+/* Write min(count, cpu_count) OS CPU numbers in placement order; returns how many. */
+uint32_t cpu_topology_spread(const cpu_topology_t* topology, uint32_t* cpus, uint32_t count);
+
+/* Prefer NUMA node `node` for the pages of [ptr, ptr + size), moving pages
+ * already touched. Linux only (mbind); false elsewhere or on failure. */
+bool cpu_topology_bind_memory(void* ptr, size_t size, uint32_t node);
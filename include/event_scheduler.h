@@ -1,5 +1,6 @@
 #pragma once
 #include "portable_atomic.h"
+#include <stdint.h>
 #include <stdbool.h>
 
 /*
@@ -10,14 +11,50 @@ Avoids busy polling. Consumers wake only when signaled.
 Usage:
 - Producers call event_signal() after commit
 - Consumers call event_check() before drain
-- If true → drain and event_clear()
+- Once every lane looks empty: event_clear(), look again, then event_wait();
+  a commit that raced the clear is either seen by the second look or wakes
+  the wait
+
+event_wait spins for an adaptive number of iterations (growing while spinning
+pays off, shrinking while it does not), then parks on a futex (Linux),
+WaitOnAddress (Windows 8+) or Atomics.wait (Emscripten pthreads). Only the
+first event_signal after a clear does any work beyond a load, and it issues a
+wake syscall only if a consumer is parked. event_fd() exposes an eventfd that
+is readable while the event is signaled, for registration in epoll loops.
 */
 
+#define EVENT_WAIT_FOREVER UINT64_MAX
+#define EVENT_SPIN_MIN 64
+#define EVENT_SPIN_MAX 16384
+
 typedef struct {
-    atomic_bool signal;
+    atomic_u32 signal;      // 1 from the first signal until the next clear
+    atomic_u32 epoch;       // Futex word; bumped when parked waiters are woken
+    atomic_u32 waiters;     // Consumers parked or about to park
+    atomic_u32 spinLimit;   // Current spin budget of event_wait
+    atomic_u32 fd;          // eventfd + 1, or 0 until event_fd() is called
 } EventScheduler;
 
 void event_init(EventScheduler* e);
+void event_destroy(EventScheduler* e);
 void event_signal(EventScheduler* e);
+/* event_signal for callers that already issued a full fence after their commit. */
+void event_notify(EventScheduler* e);
 bool event_check(EventScheduler* e);
-void event_clear(EventScheduler* e);
\ No newline at end of file
+void event_clear(EventScheduler* e);
+
+/* Block until signaled; true once signaled, false after `timeoutNs` (0 polls). */
+bool event_wait(EventScheduler* e, uint64_t timeoutNs);
+
+/* File descriptor readable while signaled, or -1 where eventfd is unavailable. */
+int event_fd(EventScheduler* e);
+
+/*
+ * The address-wait primitives behind event_wait, for other eventcounts: park
+ * while *word == expected (at most timeoutNs, may return early), and wake
+ * every thread parked on word.
+ */
+void event_park_address(atomic_u32* word, uint32_t expected, uint64_t timeoutNs);
+void event_wake_address(atomic_u32* word);
+/* Monotonic nanoseconds; umsbb_clock_ns. */
+uint64_t event_now_ns(void);
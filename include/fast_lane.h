@@ -3,6 +3,10 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include "atomic_compat.h"
+#include "portable_atomic.h"
+#include "latency_histogram.h"
+#include "metrics_registry.h"
+#include "lane_codec.h"
 
 /*
 Fast Lane System - High-throughput dedicated lanes with priority routing
@@ -13,7 +17,63 @@ Features:
 - Priority queues with preemption
 - Cache-line optimized structures
 - NUMA-aware memory allocation
+
+Each lane is a bounded MPMC queue (Vyukov): every slot carries a sequence
+number that says whose turn it is. A producer owns slot `pos` once its
+sequence equals pos and publishes it by storing pos + 1; a consumer owns it
+once the sequence is pos + 1 and hands it back by storing pos + capacity.
+Producers and consumers only contend on their own cursor, and a consumer
+never sees a slot before the length and payload written into it.
+
+Slots are stamped when published, and each lane records submit-to-drain
+latency into a per-thread latency histogram that fast_lane_get_metrics merges.
+*/
+
+#define FAST_LANE_SLOT_HEADER 32        // fast_lane_slot_t rounded to 16, payload follows
+#define FAST_LANE_DEFAULT_SPINS 1024    // Retry budget of fast_lane_submit
+
+/*
+Lane storage is reserved as address space and committed page by page as
+messages first reach it, so an idle bus costs almost no memory regardless of
+its lane sizes. Flags per lane:
 */
+#define FAST_LANE_FLAG_HUGE_PAGES 0x1u  // Explicit huge pages if reserved, else transparent ones
+#define FAST_LANE_FLAG_PREFAULT 0x2u    // Commit every page at init (latency-critical lanes)
+/* Slots carry a descriptor instead of the payload. The payload is copied into
+ * a size-classed message pool block, and the drain hands that block over
+ * without a second copy. The ring is a few bytes per slot and slot_size only
+ * caps the message size. */
+#define FAST_LANE_FLAG_INDIRECT 0x4u
+#define FAST_LANE_INDIRECT_MAX (16u * 1024 * 1024)  // Default message cap of indirect lanes
+/* Payloads of at least compress_min bytes are compressed on submit when the
+ * lane codec finds it worthwhile (see lane_codec.h) and decoded by the drain
+ * that takes them, so consumers always get the original bytes. Meant for
+ * bulk and streaming lanes carrying JSON or telemetry; the codec backs off
+ * on its own for payloads that do not shrink. */
+#define FAST_LANE_FLAG_COMPRESS 0x8u
+
+/* Payload of an indirect slot. */
+typedef struct {
+    void* payload;              // message_pool block holding `length` bytes
+} fast_lane_descriptor_t;
+
+/* Geometry of one lane; capacity is rounded up to a power of two, and a zero
+ * capacity or slot size disables the lane. */
+typedef struct {
+    uint32_t capacity;          // Slots
+    size_t slot_size;           // Largest payload per slot (per message if indirect)
+    uint32_t flags;
+    uint32_t compress_min;      // FAST_LANE_FLAG_COMPRESS threshold, 0 = LANE_CODEC_MIN_SIZE
+} fast_lane_config_t;
+
+/* Header at the start of every slot. */
+typedef struct {
+    atomic_size_t sequence;     // Turn counter, see above
+    uint32_t length;            // Bytes stored
+    uint32_t priority;
+    uint64_t enqueued_ns;       // umsbb_clock_ns() at publish
+    uint32_t original;          // Decoded length if the payload is compressed, else 0
+} fast_lane_slot_t;
 
 typedef enum {
     LANE_EXPRESS = 0,    // Ultra-low latency, small messages
@@ -24,36 +84,54 @@ typedef enum {
 } lane_type_t;
 
 typedef struct {
-    _Alignas(64) atomic_uint64_t head;
-    _Alignas(64) atomic_uint64_t tail;
-    _Alignas(64) atomic_uint32_t message_count;
+    _Alignas(64) atomic_size_t head;        // Next position producers claim
+    _Alignas(64) atomic_size_t tail;        // Next position consumers claim
     _Alignas(64) atomic_uint64_t bytes_transferred;
     
     lane_type_t type;
     uint32_t priority;
-    uint32_t capacity;
+    uint32_t capacity;          // Slots, a power of two
     bool gpu_preferred;
     double latency_target_us;  // Target latency in microseconds
     
     void* ring_buffer;
-    size_t slot_size;
+    size_t mapped_size;         // Bytes reserved for ring_buffer
+    size_t slot_size;           // Largest payload a slot accepts
+    size_t slot_stride;         // Header plus payload, cache-line rounded
+    uint32_t flags;             // FAST_LANE_FLAG_*
+    lane_codec_t codec;         // Disabled (min_size 0) without FAST_LANE_FLAG_COMPRESS
     
     // Performance metrics
-    uint64_t total_messages;
-    uint64_t total_bytes;
-    double avg_latency_us;
-    double max_latency_us;
-    uint64_t congestion_events;
+    LatencyHistogram* latency;              // Submit to drain, every message
+    atomic_size_t congestion_events;        // Producer waits over twice the latency target
+    uint64_t metrics_messages;              // Totals at the previous metrics call
+    uint64_t metrics_bytes;
+    uint64_t metrics_timestamp_us;
 } fast_lane_t;
 
+#define FAST_LANE_QUANTUM 4096         // Bytes per unit of lane weight and scheduling round
+#define FAST_LANE_PRIORITY_BURST 32     // Priority messages in a row before other lanes get a turn
+
+/* One message returned by fast_lane_drain_scheduled. */
+typedef struct {
+    void* data;                 // message_pool block, release with message_pool_release
+    size_t size;
+    uint32_t priority;
+    lane_type_t lane;
+} fast_lane_message_t;
+
 typedef struct {
     fast_lane_t lanes[LANE_COUNT];
     uint32_t active_lanes;
     atomic_uint32_t global_sequence;
     
-    // Load balancing
-    atomic_uint32_t round_robin_counter;
-    uint32_t lane_weights[LANE_COUNT];
+    // Load balancing: fast_lane_drain_scheduled state (owned by its one caller)
+    atomic_uint32_t round_robin_counter;        // Lane whose round-robin turn is next
+    uint32_t lane_weights[LANE_COUNT];          // Quanta per round; 0 = deadline picks only
+    int64_t lane_deficit[LANE_COUNT];           // Bytes a lane may still drain this round
+    uint64_t lane_last_served_us[LANE_COUNT];
+    uint32_t priority_streak;
+    bool turn_open;                             // The current lane's round was cut short by `max`
     
     // Performance monitoring
     uint64_t total_throughput_mbps;
@@ -63,27 +141,64 @@ typedef struct {
 } fast_lane_manager_t;
 
 // Performance metrics structure (declare before API prototypes)
+// Rates cover the time since the previous metrics call on the same lane
 struct lane_metrics {
     uint64_t messages_per_second;
     uint64_t bytes_per_second;
     double avg_latency_us;
+    double p50_latency_us;
     double p99_latency_us;
+    double p999_latency_us;
+    double max_latency_us;
     uint32_t congestion_level;
     double utilization_percent;
+    LatencySummary latency;             // Submit-to-drain distribution in nanoseconds
 };
 
 // Fast Lane API
+/* Express 1024 x 256 B and priority 512 x 1 KB (prefaulted); bulk 8192 and
+ * streaming 16384 indirect slots for messages up to FAST_LANE_INDIRECT_MAX. */
+void fast_lane_default_config(fast_lane_config_t config[LANE_COUNT]);
 bool fast_lane_init(fast_lane_manager_t* manager);
+/* NULL config means fast_lane_default_config. */
+bool fast_lane_init_ex(fast_lane_manager_t* manager, const fast_lane_config_t config[LANE_COUNT]);
 void fast_lane_destroy(fast_lane_manager_t* manager);
 
-// Lane selection based on message characteristics
-
+// Lane selection based on message characteristics: fixed size and priority
+// cutoffs. lane_router.h starts from these and adapts them to lane load.
 lane_type_t fast_lane_select_optimal(size_t message_size, uint32_t priority, bool latency_critical);
 
-// High-performance message operations
+// High-performance message operations; safe from any number of producer and
+// consumer threads. try_* make one attempt, *_spin retry up to max_spins
+// times while the lane is full (submit) or empty (drain).
+bool fast_lane_try_submit(fast_lane_manager_t* manager, lane_type_t lane, const void* data, size_t size, uint32_t priority);
+bool fast_lane_submit_spin(fast_lane_manager_t* manager, lane_type_t lane, const void* data, size_t size,
+                           uint32_t priority, uint32_t max_spins);
+// fast_lane_submit_spin with FAST_LANE_DEFAULT_SPINS
 bool fast_lane_submit(fast_lane_manager_t* manager, lane_type_t lane, const void* data, size_t size, uint32_t priority);
+// Results come from the message pool; release them with message_pool_release.
+// fast_lane_drain is fast_lane_try_drain. `priority` may be NULL.
+void* fast_lane_try_drain(fast_lane_manager_t* manager, lane_type_t lane, size_t* size, uint32_t* priority);
+void* fast_lane_drain_spin(fast_lane_manager_t* manager, lane_type_t lane, size_t* size, uint32_t* priority,
+                           uint32_t max_spins);
 void* fast_lane_drain(fast_lane_manager_t* manager, lane_type_t lane, size_t* size, uint32_t* priority);
 
+/* Fill `out` with up to `max` messages across all lanes and return the count.
+ * LANE_PRIORITY is drained first, FAST_LANE_PRIORITY_BURST at a time while
+ * other lanes wait; then every lane that has not been served within its
+ * latency_target_us gets a message; the rest of the batch is shared by
+ * deficit round robin, lane_weights[i] * FAST_LANE_QUANTUM bytes per round.
+ * Only one thread may call this per manager (plain drains may run alongside). */
+size_t fast_lane_drain_scheduled(fast_lane_manager_t* manager, fast_lane_message_t* out, size_t max);
+
 // Performance monitoring
+// Latencies since init; the interval variant reports those since its previous
+// call on the lane. Metrics calls for one lane must not run concurrently.
 void fast_lane_get_metrics(fast_lane_manager_t* manager, lane_type_t lane, struct lane_metrics* metrics);
+void fast_lane_get_interval_metrics(fast_lane_manager_t* manager, lane_type_t lane, struct lane_metrics* metrics);
 double fast_lane_get_system_throughput(fast_lane_manager_t* manager);
+// Compression counters of a FAST_LANE_FLAG_COMPRESS lane (zeroes otherwise)
+void fast_lane_get_codec_stats(fast_lane_manager_t* manager, lane_type_t lane, lane_codec_stats_t* stats);
+// Export each lane's counters and latency histogram, labelled lane="..." after
+// `labels`; remove them with metrics_registry_remove(registry, manager, sizeof(*manager))
+bool fast_lane_register_metrics(fast_lane_manager_t* manager, MetricsRegistry* registry, const char* labels);
@@ -3,6 +3,9 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include "atomic_compat.h"
+#include "timer_wheel.h"
+#include "message_log.h"
+#include "metrics_registry.h"
 
 /*
 Zero Fault Tolerance System - Comprehensive fault detection, recovery, and prevention
@@ -13,8 +16,40 @@ Features:
 - Health monitoring and diagnostics
 - Graceful degradation under failure
 - Self-healing capabilities
+
+Health accounting is sharded: each thread counts into one of
+FAULT_TOLERANCE_SHARDS cache-line-aligned shards (picked once per thread), so
+fault_tolerance_update_component_health and fault_tolerance_report_fault only
+touch lines their own thread writes. Readers sum the shards into a snapshot
+(fault_tolerance_get_component_health), and component and system health are
+derived from snapshots on read. A component's consecutive failures are its
+longest run in any one shard since that shard's last success.
+
+Faults go to an MPSC ring of `capacity` slots that overwrites the oldest
+entries. A reporter claims its slot with a CAS and publishes it with a
+sequence stamp; readers copy a slot and keep the copy only if the stamp did
+not move. Fault ids start at 1 and map straight to their slot.
+
+Each component's heartbeat deadline sits on a timer wheel, armed by its first
+update and after each miss. Updates only stamp the shard; when a deadline
+comes up, fault_tolerance_check_heartbeats re-arms it from the latest stamp,
+or counts a miss, so its cost follows the deadlines due rather than the
+number of updates or components.
+
+Message persistence goes to one process-wide message_log (the persist and
+recover calls take no manager), opened by fault_tolerance_enable_persistence
+and closed with the manager. Replay hands each logged record in range to the
+manager's replay handler: lanes in parallel, each lane's messages in the
+order they were logged, so the handler must accept concurrent calls for
+different lanes.
 */
 
+#define FAULT_TOLERANCE_HEARTBEAT_US 5000000ull
+#define FAULT_TOLERANCE_HEARTBEAT_TICK_NS 10000000ull       // 10 ms
+#define FAULT_TOLERANCE_MAX_COMPONENTS 64
+#define FAULT_TOLERANCE_SHARDS 16
+#define FAULT_TOLERANCE_CACHE_LINE 64
+
 typedef enum {
     FAULT_TYPE_NONE = 0,
     FAULT_TYPE_CORRUPTION = 1,      // Data corruption detected
@@ -56,21 +91,25 @@ typedef struct {
     uint64_t recovery_time_us;
 } fault_record_t;
 
+struct fault_slot;
+struct fault_shard;
+struct fault_component;
+
 typedef struct {
-    fault_record_t* records;
+    // Fault ring: newest faults overwrite the oldest
+    struct fault_slot* slots;
     uint32_t capacity;
-    atomic_uint32_t head;
-    atomic_uint32_t tail;
-    atomic_uint32_t active_faults;
+    atomic_uint64_t head;           // Faults reported; the last fault id
+    atomic_uint64_t dropped;        // Slot still being written a lap later
     
-    // Health monitoring
-    atomic_uint64_t total_faults;
-    atomic_uint64_t recovered_faults;
-    atomic_uint64_t unrecoverable_faults;
+    // Sharded health accounting, summed on read
+    struct fault_shard* shards;
+    void* shard_block;              // Allocation the aligned shards live in
+    struct fault_component* components;
+    atomic_uint64_t registered;     // Bit per component seen
     
-    // Performance impact tracking
-    uint64_t total_recovery_time_us;
-    uint32_t degraded_components;
+    // Derived on read
+    atomic_uint32_t degraded_components;
     double system_health_score;  // 0.0 to 1.0
     
     // Configuration
@@ -78,17 +117,28 @@ typedef struct {
     uint32_t fault_escalation_threshold;
     bool auto_recovery_enabled;
     bool persistent_logging_enabled;
+    
+    // Heartbeat deadlines
+    timer_wheel_t heartbeats;
+    atomic_uint32_t heartbeat_lock;
+    uint64_t heartbeat_timeout_us;
+    uint64_t heartbeat_misses;
+    
+    // Replay target for logged messages
+    message_log_replay_fn replay_handler;
+    void* replay_context;
 } fault_tolerance_manager_t;
 
+/* Snapshot of one component, summed over the shards. */
 typedef struct {
     uint32_t component_id;
-    atomic_uint64_t operations_count;
-    atomic_uint64_t success_count;
-    atomic_uint64_t failure_count;
-    atomic_uint64_t last_heartbeat_us;
+    uint64_t operations_count;
+    uint64_t success_count;
+    uint64_t failure_count;
+    uint64_t last_heartbeat_us;
     
     // Performance metrics
-    double avg_response_time_us;
+    double avg_response_time_us;    // Mean over every update
     double max_response_time_us;
     uint32_t consecutive_failures;
     
@@ -107,6 +157,10 @@ void fault_tolerance_destroy(fault_tolerance_manager_t* manager);
 uint64_t fault_tolerance_report_fault(fault_tolerance_manager_t* manager, fault_type_t type, 
                                       uint32_t component_id, const char* description);
 bool fault_tolerance_is_component_healthy(fault_tolerance_manager_t* manager, uint32_t component_id);
+/* Copy of fault `fault_id` while it is still in the ring and not mid-write. */
+bool fault_tolerance_get_fault(fault_tolerance_manager_t* manager, uint64_t fault_id, fault_record_t* record);
+/* Reported faults not yet recovered. */
+uint64_t fault_tolerance_active_faults(fault_tolerance_manager_t* manager);
 
 // Recovery management
 recovery_action_t fault_tolerance_determine_recovery_action(fault_tolerance_manager_t* manager, 
@@ -117,11 +171,29 @@ bool fault_tolerance_execute_recovery(fault_tolerance_manager_t* manager, uint64
 // Health monitoring
 void fault_tolerance_update_component_health(fault_tolerance_manager_t* manager, uint32_t component_id, 
                                              bool operation_success, uint64_t response_time_us);
+/* false for an unknown or out-of-range component. */
+bool fault_tolerance_get_component_health(fault_tolerance_manager_t* manager, uint32_t component_id,
+                                          component_health_t* health);
 double fault_tolerance_get_system_health(fault_tolerance_manager_t* manager);
+/* Mark components whose heartbeat is overdue unhealthy; returns how many
+ * deadlines passed since the previous call. */
+uint32_t fault_tolerance_check_heartbeats(fault_tolerance_manager_t* manager);
 
 // Message persistence for zero-loss guarantee
+/* Open the message log in `directory` (config may be NULL for defaults). */
+bool fault_tolerance_enable_persistence(fault_tolerance_manager_t* manager, const char* directory,
+                                        const message_log_config_t* config);
+void fault_tolerance_set_lane_durability(fault_tolerance_manager_t* manager, uint32_t lane,
+                                         message_log_durability_t durability);
+void fault_tolerance_set_replay_handler(fault_tolerance_manager_t* manager, message_log_replay_fn handler, void* context);
+/* Log a message under lane 0; false if no log is open or it refused the record. */
 bool fault_tolerance_persist_message(uint64_t sequence, const void* data, size_t size);
+/* Log a message with its lane's durability. */
+bool fault_tolerance_persist_lane_message(uint32_t lane, uint64_t sequence, const void* data, size_t size);
+/* malloc'd copy of a logged message (free() it), or NULL. */
 void* fault_tolerance_recover_message(uint64_t sequence, size_t* size);
+/* Replay logged messages from_sequence..to_sequence into the replay handler;
+ * false without a log or if a record no longer reads back intact. */
 bool fault_tolerance_replay_messages(fault_tolerance_manager_t* manager, uint64_t from_sequence, uint64_t to_sequence);
 
 // Graceful degradation
@@ -139,9 +211,13 @@ struct fault_tolerance_metrics {
     double avg_recovery_time_us;
     double system_health_score;
     uint32_t degraded_components;
+    uint64_t faults_dropped;
     uint64_t messages_persisted;
     uint64_t messages_recovered;
 };
 
 void fault_tolerance_get_metrics(fault_tolerance_manager_t* manager, struct fault_tolerance_metrics* metrics);
+// Export fault counts from the shards as they stand; owner is the manager
+bool fault_tolerance_register_metrics(fault_tolerance_manager_t* manager, MetricsRegistry* registry,
+                                      const char* labels);
 void fault_tolerance_generate_health_report(fault_tolerance_manager_t* manager, char* report, size_t report_size);
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include "atomic_compat.h"
+#include "latency_histogram.h"
+#include "metrics_registry.h"
+#include "timer_wheel.h"
 
 /*
 Feedback Handshake System - Reliable delivery with acknowledgment-based flow control
@@ -13,8 +16,42 @@ Features:
 - Sequence-based ordering
 - Congestion control via feedback
 - Zero-loss guarantee with persistent retry
+- Cumulative and selective ACKs, coalesced on the consumer side
+
+Sequences start at 1; 0 means the send failed. Entries leave the window
+(tail) once they and every earlier entry are acknowledged or given up on.
+
+A FEEDBACK_TYPE_SACK message acknowledges every in-flight entry of its
+producer/consumer pair up to `sequence` (0 for none), plus sack_base + i for
+each bit i set in `sack_bitmap`, so one message stands in for a contiguous
+run and up to 64 more. The consumer builds them with a
+handshake_ack_coalescer_t, which emits one after every max_messages receipts
+or once the oldest unacknowledged receipt is max_delay_us old, whichever
+comes first. Pairs sharing a manager see each other's sequences as gaps;
+their receipts still go out 64 sequences to a SACK, through the bitmap.
+
+Every in-flight entry has one timer on a millisecond timer wheel: its ACK
+deadline while pending, its resend time while scheduled for retry. A retry
+waits retry_backoff_ms doubled per earlier retry (capped at
+HANDSHAKE_MAX_BACKOFF_SHIFT doublings), jittered down by up to half so
+retries of a burst do not resend in lockstep. handshake_process_timeouts and
+handshake_retry_failed_messages both advance the wheel, so their cost
+follows the timers that come due rather than the size of the window.
+
+Retransmit store: each send copies its payload once into a refcounted
+message_pool block that the entry holds until it is acknowledged or given
+up on, so the caller need not keep one. When a retry comes due the payload
+is handed to the resend callback set with handshake_set_retransmit; a
+callback that returns false is tried again after another backoff, without
+using up a retry. Retained bytes are capped by the budget: a send that
+would exceed it is refused (returns 0) instead of being tracked without its
+payload. A budget of 0 keeps no payloads and retries only reset the entry.
 */
 
+#define HANDSHAKE_TICK_NS 1000000ull            // Timer wheel resolution
+#define HANDSHAKE_MAX_BACKOFF_SHIFT 10
+#define HANDSHAKE_RETAIN_BUDGET (8u * 1024 * 1024)   // Default retransmit store cap
+
 typedef enum {
     HANDSHAKE_STATE_PENDING = 0,    // Waiting for ACK
     HANDSHAKE_STATE_ACKED = 1,      // Successfully acknowledged
@@ -28,7 +65,8 @@ typedef enum {
     FEEDBACK_TYPE_NACK = 1,         // Negative acknowledgment
     FEEDBACK_TYPE_BUSY = 2,         // Consumer busy, retry later
     FEEDBACK_TYPE_OVERFLOW = 3,     // Buffer overflow
-    FEEDBACK_TYPE_READY = 4         // Ready for next message
+    FEEDBACK_TYPE_READY = 4,        // Ready for next message
+    FEEDBACK_TYPE_SACK = 5          // Cumulative ACK up to sequence, plus sack_bitmap
 } feedback_type_t;
 
 typedef struct {
@@ -48,8 +86,13 @@ typedef struct {
     uint64_t sent_timestamp_us;
     uint64_t ack_timestamp_us;
     uint32_t timeout_ms;
+    timer_wheel_timer_t timer;      // ACK deadline, or resend time while RETRY
+    const void* payload;            // Retained copy, NULL without a retransmit store
 } handshake_entry_t;
 
+/* Put a retried entry's payload back on the wire; false to try again later. */
+typedef bool (*handshake_resend_fn)(void* context, const handshake_entry_t* entry, const void* payload);
+
 typedef struct {
     handshake_entry_t* entries;
     uint32_t capacity;
@@ -63,13 +106,29 @@ typedef struct {
     uint32_t retry_backoff_ms;
     bool zero_loss_mode;
     
+    timer_wheel_t timers;
+    uint64_t jitter_state;
+    uint32_t resends_due;              // Retries resent since the last retry call
+    
+    // Retransmit store
+    handshake_resend_fn resend;
+    void* resend_context;
+    size_t retain_budget;
+    size_t retained_bytes;
+    uint64_t resends;
+    uint64_t resend_failures;
+    uint64_t budget_rejections;
+    
     // Performance metrics
     uint64_t total_messages;
     uint64_t successful_acks;
     uint64_t failed_deliveries;
     uint64_t timeouts;
     uint64_t retries;
-    double avg_ack_latency_us;
+    LatencyHistogram* ack_latency;     // Send (or last retry) to ACK
+    uint64_t metrics_messages;         // Totals at the previous metrics call
+    uint64_t metrics_acks;
+    uint64_t metrics_timestamp_us;
 } handshake_manager_t;
 
 typedef struct {
@@ -79,9 +138,24 @@ typedef struct {
     uint32_t consumer_id;
     uint64_t timestamp_us;
     uint32_t error_code;
+    uint64_t sack_base;             // SACK only: bit i of sack_bitmap acknowledges sack_base + i
+    uint64_t sack_bitmap;
     char error_message[64];
 } feedback_message_t;
 
+// Consumer-side ACK coalescing for one producer/consumer pair
+typedef struct {
+    uint32_t producer_id;
+    uint32_t consumer_id;
+    uint64_t cumulative;            // Every sequence up to here was received
+    uint64_t sack_base;             // Received sequences past a gap: bit i is sack_base + i
+    uint64_t sack_bitmap;
+    uint32_t unacked;               // Receipts since the last emitted ACK
+    uint64_t first_unacked_us;
+    uint32_t max_messages;
+    uint32_t max_delay_us;
+} handshake_ack_coalescer_t;
+
 // Performance metrics struct must be visible before prototypes
 struct handshake_metrics {
     uint64_t messages_per_second;
@@ -92,6 +166,7 @@ struct handshake_metrics {
     uint32_t pending_messages;
     uint32_t retry_rate;
     uint64_t total_timeouts;
+    LatencySummary ack_latency;
 };
 
 // Handshake API
@@ -102,20 +177,52 @@ void handshake_destroy(handshake_manager_t* manager);
 uint64_t handshake_send_message(handshake_manager_t* manager, uint32_t producer_id, uint32_t consumer_id, 
                                 const void* data, size_t size);
 bool handshake_process_feedback(handshake_manager_t* manager, const feedback_message_t* feedback);
+/* Apply `count` feedback messages with one clock read and one window
+ * update; returns how many matched an entry. */
+uint32_t handshake_process_feedback_batch(handshake_manager_t* manager, const feedback_message_t* feedback,
+                                          uint32_t count);
 
 // Timeout and retry management
+/* Fire the timers due by now: expired ACK deadlines schedule a retry or fail
+ * the entry, elapsed backoffs put the entry back in flight. */
 void handshake_process_timeouts(handshake_manager_t* manager);
+/* As handshake_process_timeouts; true if any entry was resent since the
+ * previous call. */
 bool handshake_retry_failed_messages(handshake_manager_t* manager);
 
+// Retransmit store
+/* Cap retained payload bytes at `budget` (0 stops retaining new sends) and
+ * set the callback that resends them; `resend` may be NULL. */
+void handshake_set_retransmit(handshake_manager_t* manager, size_t budget, handshake_resend_fn resend, void* context);
+/* The retained payload of an in-flight entry, or NULL. Borrowed: retain it
+ * to keep it past the entry's ACK. */
+const void* handshake_get_payload(handshake_manager_t* manager, uint64_t sequence, size_t* size);
+void handshake_payload_retain(const void* payload);
+void handshake_payload_release(const void* payload);
+
 // Consumer feedback generation
 feedback_message_t handshake_create_ack(uint64_t sequence, uint32_t producer_id, uint32_t consumer_id);
 feedback_message_t handshake_create_nack(uint64_t sequence, uint32_t producer_id, uint32_t consumer_id, 
                                          uint32_t error_code, const char* error_message);
 feedback_message_t handshake_create_ready(uint32_t producer_id, uint32_t consumer_id);
+feedback_message_t handshake_create_sack(uint64_t cumulative, uint64_t sack_base, uint64_t sack_bitmap,
+                                         uint32_t producer_id, uint32_t consumer_id);
+
+// Consumer-side coalescing
+void handshake_coalescer_init(handshake_ack_coalescer_t* coalescer, uint32_t producer_id, uint32_t consumer_id,
+                              uint32_t max_messages, uint32_t max_delay_us);
+/* Record a received sequence; true with *ack filled when an ACK is due,
+ * or when the sequence does not fit the bitmap, which is then sent and
+ * restarted at it. */
+bool handshake_coalescer_receive(handshake_ack_coalescer_t* coalescer, uint64_t sequence, feedback_message_t* ack);
+/* Due by time (or `force` and anything unacknowledged): fill *ack. */
+bool handshake_coalescer_poll(handshake_ack_coalescer_t* coalescer, bool force, feedback_message_t* ack);
 
 // Flow control
 bool handshake_can_send_more(handshake_manager_t* manager, uint32_t producer_id);
 uint32_t handshake_get_pending_count(handshake_manager_t* manager, uint32_t producer_id);
 
 // Performance monitoring
-void handshake_get_metrics(handshake_manager_t* manager, struct handshake_metrics* metrics);
\ No newline at end of file
+void handshake_get_metrics(handshake_manager_t* manager, struct handshake_metrics* metrics);
+// Export the delivery counters and ACK latency; owner is the manager
+bool handshake_register_metrics(handshake_manager_t* manager, MetricsRegistry* registry, const char* labels);
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include "portable_atomic.h"
 
 /*
 Feedback Stream
@@ -15,6 +17,12 @@ Triggers:
 - Throttled → FEEDBACK_THROTTLED
 - Skipped → FEEDBACK_SKIPPED
 - Idle → FEEDBACK_IDLE
+
+Each lane owns an overwrite-oldest ring, so producers and consumers of
+different lanes never touch the same telemetry cache lines and a slow reader
+never blocks the bus. Routine events (OK, GPU/CPU executed, idle) are sampled
+by message sequence; exceptional events (corrupted, throttled, skipped) are
+always recorded. Readers follow a lane with a FeedbackCursor.
 */
 
 typedef enum {
@@ -31,14 +39,64 @@ typedef struct {
     uint32_t sequence;
     FeedbackType type;
     const char* note;
-    uint64_t timestamp;
+    uint64_t timestamp;     // Monotonic nanoseconds (coarse clock), see feedback_now
 } FeedbackEntry;
 
+#define FEEDBACK_RING_CAPACITY 256          // Entries kept per lane (power of two)
+#define FEEDBACK_DEFAULT_SAMPLE_EVERY 64    // Keep every 64th routine event
+
+/* Entries are copied in and out of a slot a word at a time, as atomics. */
+#define FEEDBACK_ENTRY_WORDS ((sizeof(FeedbackEntry) + sizeof(size_t) - 1) / sizeof(size_t))
+
+/*
+ * A slot's stamp only moves forward: the writer of entry `pos` claims it with
+ * a CAS from the completed stamp of `pos - FEEDBACK_RING_CAPACITY`, so writers
+ * a lap apart take turns on a slot instead of racing on it.
+ */
+typedef struct {
+    atomic_size_t stamp;    // 2*pos+1 while writing, 2*pos+2 once entry `pos` is complete
+    atomic_size_t words[FEEDBACK_ENTRY_WORDS];
+} FeedbackSlot;
+
+typedef struct {
+    atomic_size_t head;         // Entries ever pushed to this lane
+    atomic_size_t idleSequence; // Bus sequence + 1 at the last recorded IDLE
+    FeedbackSlot slots[FEEDBACK_RING_CAPACITY];
+} FeedbackRing;
+
 typedef struct {
-    FeedbackEntry entries[128];
-    size_t count;
+    FeedbackRing** lanes;   // laneCount slots; NULL until the lane is enabled
+    size_t laneCount;
+    uint32_t sampleEvery;   // 1 = every routine event, N = every Nth, 0 = exceptional events only
 } FeedbackStream;
 
-void feedback_push(FeedbackStream* stream, FeedbackEntry entry);
-void feedback_render(const FeedbackStream* stream);
-void feedback_clear(FeedbackStream* stream);
\ No newline at end of file
+typedef struct {
+    size_t position;        // Next entry to read
+    size_t dropped;         // Entries overwritten before this cursor reached them
+} FeedbackCursor;
+
+bool feedback_init(FeedbackStream* stream, size_t laneCount);
+/* Slot table for `maxLanes` with no rings yet; enable lanes as they come online. */
+bool feedback_init_sparse(FeedbackStream* stream, size_t maxLanes);
+bool feedback_enable_lane(FeedbackStream* stream, size_t lane);
+void feedback_destroy(FeedbackStream* stream);
+void feedback_set_sampling(FeedbackStream* stream, uint32_t sampleEvery);
+
+// Cheap pre-check so callers skip building entries that would be sampled out
+bool feedback_should_record(FeedbackStream* stream, size_t lane, FeedbackType type, uint32_t sequence);
+
+// Records unconditionally (timestamp filled in here); use feedback_should_record first
+void feedback_push(FeedbackStream* stream, size_t lane, FeedbackEntry entry);
+
+// Cursor starting at the oldest entry still retained by `lane`
+void feedback_cursor_init(FeedbackStream* stream, size_t lane, FeedbackCursor* cursor);
+
+// Copies up to `max` entries after `cursor` and advances it; returns the count
+size_t feedback_read(FeedbackStream* stream, size_t lane, FeedbackCursor* cursor,
+                     FeedbackEntry* out, size_t max);
+
+void feedback_render(FeedbackStream* stream);
+void feedback_clear(FeedbackStream* stream);
+
+// Monotonic coarse clock in nanoseconds, cheap enough for per-event use
+uint64_t feedback_now(void);
@@ -5,10 +5,23 @@
 
 typedef struct {
     size_t threshold;
+    double ratio;       // If > 0, threshold is this fraction of each buffer's current capacity
+    double lowRatio;    // Throttled producers resume once usage is back to this fraction of the threshold
+    double batchRatio;  // Credit returned to producers in grants of this fraction of the threshold
 } FlowControl;
 
+#define FLOW_CONTROL_LOW_RATIO 0.625    // 80% -> 50% of capacity with the bus default
+#define FLOW_CONTROL_BATCH_RATIO 0.0625
+
 /* Initialize the flow control with a capacity threshold. */
 void flow_control_init(FlowControl* ctrl, size_t threshold);
+/* Throttle at a fraction of capacity, so the mark follows buffers that are resized. */
+void flow_control_init_ratio(FlowControl* ctrl, double ratio);
+
+/* Override the default hysteresis of a control. */
+void flow_control_set_hysteresis(FlowControl* ctrl, double lowRatio, double batchRatio);
+/* High / low marks and grant size for a credit gate guarding `capacity` bytes. */
+void flow_control_marks(const FlowControl* ctrl, size_t capacity, size_t* high, size_t* low, size_t* batch);
 
 /* Return true if the buffer should be throttled according to the control. */
 bool flow_should_throttle(BiBuffer* buf, FlowControl* ctrl);
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include "umsbb_clock.h"
+#include "batch_kernels.h"
 #include <time.h>
 
 #ifdef _WIN32
@@ -65,6 +67,10 @@ extern "C" {
 #define MAX_GPU_STREAMS 32
 #define GPU_BATCH_SIZE 65536
 #define GPU_MEMORY_POOL_SIZE (1ULL << 30)  // 1GB GPU memory pool
+#define GPU_PIPELINE_DEPTH 2            // Staging buffers per stream: one filling, one in flight
+#define GPU_PIPELINE_STAGING_BYTES (1u << 20)  // Pinned staging buffer per stage
+#define GPU_PIPELINE_AUTO_LANE UINT32_MAX      // Let the processing kernel pick the lane
+#define GPU_PIPELINE_FLUSH_TIMEOUT_US 1000     // Default age at which a partly filled stage goes
 
 // GPU processing types
 typedef enum {
@@ -93,6 +99,8 @@ typedef struct {
     uint64_t last_update_time;
 } gpu_stream_t;
 
+struct gpu_pipeline;
+
 // GPU accelerated ring buffer
 typedef struct {
     // Host-side ring buffer
@@ -138,6 +146,9 @@ typedef struct {
     volatile bool gpu_initialized;
     volatile bool processing_active;
     
+    // Staged pipeline, once gpu_pipeline_start has run
+    struct gpu_pipeline* pipeline;
+    
 } gpu_accelerated_buffer_t;
 
 // GPU batch processing structure
@@ -146,6 +157,10 @@ typedef struct {
     uint64_t* offsets;
     uint32_t* lengths;
     uint32_t* lane_ids;
+    uint64_t* tags;             // Pipeline batches: the tag each message was submitted with
+    uint8_t* policies;          // Pipeline batches: checksum_policy_t each message is verified under
+    uint32_t* checksums;        // Pipeline batches: the checksum it was submitted with
+    uint8_t* status;            // Pipeline batches: batch_record_status_t once processed
     uint32_t count;
     uint64_t total_size;
     uint64_t batch_id;
@@ -167,6 +182,77 @@ typedef struct {
     double pcie_bandwidth_utilization;
 } gpu_performance_metrics_t;
 
+// Staged pipeline
+//
+// Producers append messages to a pinned staging buffer of one of the
+// pipeline's streams, so many small messages share one transfer and one
+// kernel launch. A stage is submitted to its stream once it is full, is
+// flushed, or its first message is flush_timeout_us old. The stream copies
+// it to the device and runs the processing kernel on it while producers
+// fill the stream's other stage; with several streams, copies and kernels
+// of different batches overlap too. Each stage ends with an event, and once
+// it has fired the batch is retired: its results are handed to the result
+// callback message by message (or to the completion callback as a batch, or
+// without either are written to the host ring buffer) and the stage is
+// refilled. A producer that finds its stream's next stage still in flight
+// waits for that event and retires the batch itself.
+//
+// The kernel picks lanes, verifies the checksums messages were submitted
+// with and runs the kernel chain (batch_kernels.h) and then the transform
+// over the intact ones. On CUDA the per-message stages run in stream order
+// after the lane kernel, with the same code as the host path, so results
+// are identical either way. The completion callback sees every message
+// with its status; the result callback and the host ring only the intact.
+//
+// Without CUDA each stream is a worker thread that runs its stages in
+// submission order, and with a flush timeout also flushes and retires its
+// stream's batches when it falls idle; on CUDA streams stale stages wait
+// for gpu_pipeline_poll. POSIX only; gpu_pipeline_start fails elsewhere.
+
+// Callbacks run one batch at a time, from the thread retiring it
+// (gpu_pipeline_poll/drain, a stream's worker, or a producer waiting for a
+// stage). batch->data and its arrays are reused once they return, and they
+// must not submit to the pipeline themselves. Batches of one stream arrive
+// in submission order; batch_id gives the order across streams.
+typedef void (*gpu_completion_fn)(void* context, const gpu_batch_t* batch);
+typedef void (*gpu_result_fn)(void* context, uint64_t tag, const void* data, size_t size, uint32_t lane_id);
+
+// A message that failed its checksum (BATCH_RECORD_CORRUPT) or was dropped
+// by a kernel (BATCH_RECORD_FILTERED); it gets no result
+typedef void (*gpu_reject_fn)(void* context, uint64_t tag, uint32_t lane_id, batch_record_status_t status);
+
+// Applied in place to every message the kernel chain kept, after it; on
+// CUDA it runs as a stream-ordered host function and must not call the
+// CUDA API
+typedef void (*gpu_transform_fn)(void* context, uint8_t* data, uint32_t length, uint32_t lane_id);
+
+typedef struct {
+    uint32_t num_streams;               // Streams to spread batches over (4)
+    size_t staging_bytes;               // Bytes per stage (GPU_PIPELINE_STAGING_BYTES)
+    uint32_t batch_messages;            // Messages per stage; 0: staging_bytes / 64, at most GPU_BATCH_SIZE
+    uint32_t flush_timeout_us;          // 0: stages wait for more messages or a flush (GPU_PIPELINE_FLUSH_TIMEOUT_US)
+    batch_kernel_step_t kernels[BATCH_KERNEL_MAX_CHAIN]; // Run in order over every intact message
+    uint32_t num_kernels;
+    gpu_transform_fn transform;         // NULL: lane selection and the kernel chain only
+    void* transform_context;
+    gpu_result_fn on_result;            // Per message; takes precedence over on_complete
+    gpu_reject_fn on_reject;            // Per corrupt or filtered message; may be NULL
+    gpu_completion_fn on_complete;      // NULL (and no on_result): write messages to the host ring buffer
+    void* context;
+} gpu_pipeline_config_t;
+
+typedef struct {
+    uint64_t batches_submitted;
+    uint64_t batches_completed;
+    uint64_t messages_completed;
+    uint64_t bytes_completed;
+    uint64_t producer_stalls;           // Appends that waited for a stage in flight
+    uint64_t timeout_flushes;           // Stages submitted partly filled by the flush timeout
+    uint64_t messages_corrupt;          // Failed their checksum in the kernel
+    uint64_t messages_filtered;         // Dropped by the kernel chain
+    uint32_t max_in_flight;             // Most batches submitted but not yet retired
+} gpu_pipeline_stats_t;
+
 // Function declarations
 
 // GPU initialization and cleanup
@@ -195,6 +281,30 @@ int gpu_buffer_write_accelerated(gpu_accelerated_buffer_t* buffer, const void* d
 int gpu_buffer_read_accelerated(gpu_accelerated_buffer_t* buffer, void* data, size_t max_size, size_t* actual_size);
 int gpu_buffer_bulk_transfer(gpu_accelerated_buffer_t* buffer, const void* data, size_t size, uint32_t num_parallel_streams);
 
+// Staged pipeline; gpu_buffer_write_accelerated and
+// gpu_execute_parallel_processing submit through it once it is started
+void gpu_pipeline_default_config(gpu_pipeline_config_t* config);
+int gpu_pipeline_start(gpu_accelerated_buffer_t* buffer, const gpu_pipeline_config_t* config);
+// Copy one message into a stage; fails if it is larger than a stage
+int gpu_pipeline_submit(gpu_accelerated_buffer_t* buffer, const void* data, size_t size, uint32_t lane_id);
+// As gpu_pipeline_submit, with a tag handed back with the message's result
+int gpu_pipeline_submit_tagged(gpu_accelerated_buffer_t* buffer, const void* data, size_t size, uint32_t lane_id,
+                               uint64_t tag);
+// As gpu_pipeline_submit_tagged, for a message the kernel verifies against
+// `checksum` under `policy` before the chain runs on it
+int gpu_pipeline_submit_checked(gpu_accelerated_buffer_t* buffer, const void* data, size_t size, uint32_t lane_id,
+                                uint64_t tag, checksum_policy_t policy, uint32_t checksum);
+// Submit every partly filled stage
+int gpu_pipeline_flush(gpu_accelerated_buffer_t* buffer);
+// Submit stages past the flush timeout and retire the batches whose events
+// have fired; returns how many were retired
+uint32_t gpu_pipeline_poll(gpu_accelerated_buffer_t* buffer);
+// Flush, then wait for and retire every batch
+int gpu_pipeline_drain(gpu_accelerated_buffer_t* buffer);
+// Drain, then release the stages and stop the streams' workers
+void gpu_pipeline_stop(gpu_accelerated_buffer_t* buffer);
+void gpu_pipeline_get_stats(gpu_accelerated_buffer_t* buffer, gpu_pipeline_stats_t* stats);
+
 // Performance monitoring
 void gpu_update_performance_metrics(gpu_accelerated_buffer_t* buffer, gpu_performance_metrics_t* metrics);
 double gpu_calculate_throughput(gpu_accelerated_buffer_t* buffer);
@@ -218,16 +328,7 @@ int opencl_finish_queues(gpu_accelerated_buffer_t* buffer);
 
 // Utility functions
 static inline uint64_t gpu_get_timestamp_ns(void) {
-#ifdef _WIN32
-    LARGE_INTEGER freq, counter;
-    QueryPerformanceFrequency(&freq);
-    QueryPerformanceCounter(&counter);
-    return (uint64_t)((counter.QuadPart * 1000000000ULL) / freq.QuadPart);
-#else
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
-#endif
+    return umsbb_clock_ns();
 }
 
 static inline bool gpu_is_power_of_two(uint64_t value) {
@@ -257,6 +358,14 @@ static inline void gpu_atomic_add_uint64(volatile uint64_t* target, uint64_t val
 #endif
 }
 
+static inline uint64_t gpu_atomic_load_uint64(const volatile uint64_t* target) {
+#if defined(_WIN32) && !defined(__MINGW32__)
+    return (uint64_t)_InterlockedCompareExchange64((volatile LONG64*)target, 0, 0);
+#else
+    return __atomic_load_n(target, __ATOMIC_RELAXED);
+#endif
+}
+
 static inline void gpu_atomic_store_double(volatile double* target, double value) {
     union { double d; uint64_t u; } cast;
     cast.d = value;
@@ -3,11 +3,66 @@
 #define HIGH_WATER_MARK_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+Credit-based backpressure with hysteresis.
+
+The gate starts with `high` bytes of credit. Producers spend credit before
+they claim buffer space (hwm_try_acquire / hwm_acquire_wait) and the consumer
+hands it back as it releases messages (hwm_release). Returned credit is
+granted to producers in batches of at least `batch` bytes, so producers and
+the consumer do not bounce the credit word once per message.
+
+Once a producer runs out of credit the gate is throttled: further credit is
+held back until the consumer has drained outstanding bytes down to `low`, and
+is then granted in one piece. Producers therefore resume with a full
+`high - low` window instead of trickling back one message at a time.
+Blocked producers park in hwm_acquire_wait and are woken by that grant.
+
+A producer holding any credit may overdraw it by one message, so messages
+larger than `high` still pass once the consumer catches up.
+
+Any number of producers; hwm_release and the legacy hwm_pop belong to a
+single consumer.
+*/
 
 typedef struct HighWaterMark HighWaterMark;
 
+typedef struct {
+    size_t high;            // Outstanding bytes that exhaust the credit
+    size_t low;             // Outstanding bytes at which a throttled gate reopens
+    size_t batch;           // Smallest grant while not throttled
+    size_t outstanding;     // Bytes acquired and not yet released
+    bool throttled;
+    uint64_t throttleEvents;    // Times the gate closed
+    uint64_t rejected;          // Acquires refused for lack of credit
+    uint64_t waits;             // Times a producer parked waiting for credit
+    uint64_t grants;            // Credit handed back to producers
+} HighWaterMarkStats;
+
+/* Gate with marks at capacity, capacity / 2 and capacity / 16. */
 HighWaterMark* hwm_create(size_t capacity);
+HighWaterMark* hwm_create_marks(size_t high, size_t low, size_t batch);
 void hwm_destroy(HighWaterMark* h);
+
+/* Producer: take n bytes of credit, false (and throttled) if none is left. */
+bool hwm_try_acquire(HighWaterMark* h, size_t n);
+/* Producer: hwm_try_acquire, parking up to timeoutNs (EVENT_WAIT_FOREVER) for a grant. */
+bool hwm_acquire_wait(HighWaterMark* h, size_t n, uint64_t timeoutNs);
+/* Producer: return credit that was acquired but not used. */
+void hwm_refund(HighWaterMark* h, size_t n);
+/* Consumer: n bytes left the buffer. */
+void hwm_release(HighWaterMark* h, size_t n);
+
+/* Move the marks, e.g. after the guarded buffer was resized. */
+void hwm_set_marks(HighWaterMark* h, size_t high, size_t low, size_t batch);
+bool hwm_is_throttled(const HighWaterMark* h);
+void hwm_get_stats(const HighWaterMark* h, HighWaterMarkStats* out);
+
+/* Legacy counter interface: push charges unconditionally and reports whether
+ * the gate is still within its high mark; pop is hwm_release. */
 int hwm_push(HighWaterMark* h, size_t n);
 void hwm_pop(HighWaterMark* h, size_t n);
 int hwm_is_overflow(const HighWaterMark* h);
@@ -0,0 +1,86 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "portable_atomic.h"
+
+/*
+Lane Codec
+
+Byte-oriented LZ77 compression for the payloads of a fast lane, in an
+LZ4-style block format: each sequence is a token (literal count in the high
+nibble, match length - 4 in the low one, 15 meaning "more bytes follow"),
+the literals, and a 16-bit little-endian back-reference. The last sequence
+has literals only. It trades ratio for speed: one hash probe per position
+and no entropy coding, which is enough for JSON and columnar telemetry.
+
+Compression uses a per-thread context (a 4096-entry hash table and a
+scratch buffer), created on first use and reused for every message after.
+As with the latency histogram, a thread that starts on the thread-local
+address of an exited one continues its context, so thread churn does not
+grow memory.
+
+lane_codec_encode is adaptive. Payloads below min_size are never tried. A
+compression that saves less than min_saving percent is a miss, and so is
+any compression while the lane's average speed is below min_speed: the lane
+then stores the next 16 eligible payloads as they are, doubling up to 1024
+on further misses, before it probes again. One hit resets the backoff.
+
+The speed is a moving average over attempts that starts well above the
+floor, so one compression stretched by preemption or a page fault does not
+count against the lane; it takes a run of slow ones.
+*/
+
+#define LANE_CODEC_MIN_SIZE 1024            // Default smallest payload worth a try
+#define LANE_CODEC_MIN_SAVING 12            // Default percent a compression must save
+#define LANE_CODEC_MIN_BYTES_PER_US 100     // Default min_speed: slower compression is not worth its CPU
+#define LANE_CODEC_MAX_BACKOFF 1024
+
+typedef struct {
+    size_t attempts;            // Payloads compressed
+    size_t compressed;          // ... and stored compressed
+    size_t skipped;             // Eligible payloads stored raw during a backoff
+    size_t bytes_in;            // Of the compressed payloads, before
+    size_t bytes_out;           // ... and after
+    size_t failures;            // Compressed payloads that failed to decode
+} lane_codec_stats_t;
+
+typedef struct {
+    uint32_t min_size;          // 0 disables the codec
+    uint32_t min_saving;        // Percent
+    uint32_t min_speed;         // Bytes per microsecond the average must keep, 0 = no speed rule
+    atomic_size_t speed;        // Moving average of bytes per microsecond
+    atomic_size_t skip;         // Eligible payloads left to store raw
+    atomic_size_t backoff;      // Length of the next skip run after a miss
+    atomic_size_t attempts;
+    atomic_size_t compressed;
+    atomic_size_t skipped;
+    atomic_size_t bytes_in;
+    atomic_size_t bytes_out;
+    atomic_size_t failures;
+} lane_codec_t;
+
+/* min_size 0 disables it; min_saving 0 means LANE_CODEC_MIN_SAVING. The
+ * speed floor starts at LANE_CODEC_MIN_BYTES_PER_US. */
+void lane_codec_init(lane_codec_t* codec, uint32_t min_size, uint32_t min_saving);
+/* Change the speed floor; 0 judges compressions by their saving alone. Call
+ * before the codec is shared. */
+void lane_codec_set_min_speed(lane_codec_t* codec, uint32_t bytes_per_us);
+
+/*
+ * Compressed form of `data` if this payload is worth it: returns the calling
+ * thread's scratch buffer (valid until its next encode) and sets *out_size,
+ * or NULL to store the payload as it is.
+ */
+const void* lane_codec_encode(lane_codec_t* codec, const void* data, size_t size, size_t* out_size);
+/* Decode `size` bytes into exactly `original` bytes at dst; false if corrupt.
+ * A failure is counted when `codec` is not NULL. */
+bool lane_codec_decode(lane_codec_t* codec, const void* src, size_t size, void* dst, size_t original);
+
+void lane_codec_get_stats(const lane_codec_t* codec, lane_codec_stats_t* out);
+
+/* The block format on its own: compress into dst, returning the compressed
+ * size, or 0 if it would not fit in `capacity` bytes. */
+size_t lane_codec_compress(const void* src, size_t size, void* dst, size_t capacity);
+/* Largest compressed size of `size` bytes. */
+size_t lane_codec_bound(size_t size);
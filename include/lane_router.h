@@ -0,0 +1,74 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "fast_lane.h"
+
+/*
+Lane Router
+
+Learned fast lane routing. Messages are grouped into size classes (up to
+256 B, then factors of four up to 256 KB, then everything larger), and each
+class has two published routes: one for latency-critical messages and one
+for the rest. Picking a lane is a class computation and one load.
+
+lane_router_update is the learning step, meant for a housekeeping thread
+every few milliseconds. For each lane it estimates how long a message
+submitted now would take to be drained:
+
+    cost = p99 of the window + depth * (window / messages drained in it)
+
+scaled up by the share of submits that hit congestion (waits over twice
+the lane's latency target) and by the caller's per-lane weight. The p99
+is that of the messages drained since the previous update, read from the
+lane's latency histogram without disturbing latency_histogram_interval.
+A lane whose consumer drained nothing while messages waited is charged
+the whole window. The costs are smoothed between updates.
+
+Latency-critical messages take the cheapest lane their class fits,
+LANE_PRIORITY excepted: that lane is kept for priority traffic. Other
+messages stay on their throughput lane (LANE_STREAMING below 4 KB,
+LANE_BULK above) unless the other throughput lane costs less than half
+as much. A route only moves to a lane costing at most
+LANE_ROUTER_HYSTERESIS percent of its current one, so routes do not
+flap between lanes that cost about the same.
+
+Before the first update the routes are those of fast_lane_select_optimal.
+Selection is safe from any thread; updates must not run concurrently.
+*/
+
+#define LANE_ROUTER_CLASSES 7
+#define LANE_ROUTER_PRIORITY 3          // Priority from which messages take LANE_PRIORITY
+#define LANE_ROUTER_BOUNDS 24           // Latency histogram bounds, 256 ns doubling to ~2 s
+#define LANE_ROUTER_MIN_SAMPLES 16      // With fewer drained messages the p99 is the latency target
+#define LANE_ROUTER_HYSTERESIS 75       // Percent
+#define LANE_ROUTER_WEIGHT_DEFAULT 100  // Percent; 0 keeps a lane out of learned routes
+
+typedef struct {
+    /* [class][critical]: lane_type_t in the low 8 bits, the route's cost in
+     * microseconds above them. */
+    atomic_size_t routes[LANE_ROUTER_CLASSES][2];
+    lane_type_t largest;                // Lane with the largest slots, for oversized messages
+
+    // Owned by the updating thread
+    double cost_us[LANE_COUNT];         // Smoothed; the lane's latency target before any update
+    uint64_t below[LANE_COUNT][LANE_ROUTER_BOUNDS];    // Histogram counts at the previous update
+    uint64_t drained[LANE_COUNT];
+    uint64_t submitted[LANE_COUNT];
+    uint64_t congestion[LANE_COUNT];
+    uint64_t updated_ns;
+    uint64_t updates;
+} lane_router_t;
+
+void lane_router_init(lane_router_t* router, const fast_lane_manager_t* manager);
+/* One learning step over `manager`'s lanes. `weights` are percent per lane
+ * (NULL = LANE_ROUTER_WEIGHT_DEFAULT for all); returns the routes that moved. */
+size_t lane_router_update(lane_router_t* router, fast_lane_manager_t* manager, const uint32_t weights[LANE_COUNT]);
+
+/* The route for a message of `size` bytes. A non-critical message whose
+ * timeout_ms (0 = none) is shorter than its route's cost takes the critical
+ * route. Messages larger than the route's slots go to the largest lane. */
+lane_type_t lane_router_select(lane_router_t* router, const fast_lane_manager_t* manager,
+                               size_t size, bool latency_critical, double timeout_ms);
+/* Smoothed cost of `lane` in microseconds as of the last update. */
+double lane_router_cost(const lane_router_t* router, lane_type_t lane);
@@ -63,7 +63,8 @@ bool register_language_runtime(language_type_t lang, const language_runtime_t* r
 bool unregister_language_runtime(language_type_t lang);
 language_runtime_t* get_language_runtime(language_type_t lang);
 
-// Universal data conversion
+// Universal data conversion; payloads use the language's registered allocator,
+// or the message pool (see umsbb_message_release) when it has none
 universal_data_t* create_universal_data(void* data, size_t size, uint32_t type_id, language_type_t lang);
 bool convert_data_for_language(const universal_data_t* src, universal_data_t* dst, language_type_t target_lang);
 void free_universal_data(universal_data_t* data);
@@ -80,6 +81,19 @@ void* umsbb_create_direct(size_t buffer_size, uint32_t segment_count, language_t
 bool umsbb_submit_direct(void* bus_handle, const universal_data_t* data);
 universal_data_t* umsbb_drain_direct(void* bus_handle, language_type_t target_lang);
 void umsbb_destroy_direct(void* bus_handle);
+// Drop the bindings' hold on a bus that is being freed; umsbb_free calls it
+void language_bindings_forget_bus(void* bus_handle);
+
+// Allocation-free variants for bindings that manage their own memory.
+// umsbb_send_direct submits straight from the caller's bytes. umsbb_take_direct
+// returns the pooled drained copy, freed with umsbb_message_release.
+// umsbb_view_direct leaves the message in its ring slot until
+// umsbb_release_direct(lane); until then every view returns that same
+// message, so hold one view per bus at a time.
+bool umsbb_send_direct(void* bus_handle, uint32_t type_id, const void* data, size_t size);
+void* umsbb_take_direct(void* bus_handle, size_t* size, uint32_t* type_id);
+bool umsbb_view_direct(void* bus_handle, const void** data, size_t* size, size_t* lane);
+void umsbb_release_direct(void* bus_handle, size_t lane);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,61 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+Latency Histogram
+
+Log-linear (HDR-style) histogram of nanosecond latencies. Values below
+2 * LATENCY_HISTOGRAM_SUB_COUNT are counted exactly; above that every power
+of two is split into LATENCY_HISTOGRAM_SUB_COUNT equal buckets, so a reported
+value is never more than 1 / LATENCY_HISTOGRAM_SUB_COUNT (about 1.6 %) above
+the recorded one. Values from 2^LATENCY_HISTOGRAM_MAX_BITS ns (about 18 min)
+up land in the last bucket.
+
+Every recording thread gets its own shard, created on first use, and only
+ever writes to it: recording is a bucket increment with no shared writes.
+Readers merge the shards on the fly. latency_histogram_interval additionally
+keeps the merged counts of its previous call, so periodic reporters get the
+distribution of just the last period; it must not be called concurrently
+with itself on the same histogram.
+*/
+
+#define LATENCY_HISTOGRAM_SUB_BITS 6
+#define LATENCY_HISTOGRAM_SUB_COUNT (1u << LATENCY_HISTOGRAM_SUB_BITS)
+#define LATENCY_HISTOGRAM_MAX_BITS 40
+#define LATENCY_HISTOGRAM_BUCKETS ((LATENCY_HISTOGRAM_MAX_BITS - LATENCY_HISTOGRAM_SUB_BITS + 1) * LATENCY_HISTOGRAM_SUB_COUNT)
+
+typedef struct LatencyHistogram LatencyHistogram;
+
+/* Derived from the buckets alone: percentiles and maxNs are the highest value
+ * of their bucket, minNs the lowest, and meanNs uses bucket midpoints. */
+typedef struct {
+    uint64_t count;
+    uint64_t minNs;
+    uint64_t maxNs;
+    double meanNs;
+    uint64_t p50Ns;
+    uint64_t p90Ns;
+    uint64_t p99Ns;
+    uint64_t p999Ns;
+} LatencySummary;
+
+LatencyHistogram* latency_histogram_create(void);
+void latency_histogram_destroy(LatencyHistogram* h);
+
+/* Any thread; a NULL histogram ignores the sample. */
+void latency_histogram_record(LatencyHistogram* h, uint64_t ns);
+
+/* Everything recorded so far. A NULL histogram reads as empty. */
+void latency_histogram_summary(const LatencyHistogram* h, LatencySummary* out);
+/* Value at quantile q (0..1) of everything recorded so far, 0 if empty. */
+uint64_t latency_histogram_percentile(const LatencyHistogram* h, double q);
+/* Everything recorded since the previous interval call (or creation). */
+void latency_histogram_interval(LatencyHistogram* h, LatencySummary* out);
+/* Samples at or below each of `bounds` (count ascending ns values; a bucket
+ * falls under the first bound its highest value does not exceed) into
+ * below[], cumulative, plus the total and the bucket-midpoint sum. Merges
+ * shard by shard without allocating, for exporters. NULL reads as empty. */
+void latency_histogram_cumulative(const LatencyHistogram* h, const uint64_t* bounds, size_t count,
+                                  uint64_t* below, uint64_t* total, double* sumNs);
@@ -0,0 +1,127 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+Message Log
+
+Durable, append-only log of bus messages in a directory of segment files
+(%020llu.wal, numbered from 1; a segment rolls over past segment_bytes and
+every open starts a new one). Producers serialise records into a staging
+buffer under a short lock; a dedicated log thread writes each batch with
+aligned pwrites (O_DIRECT where the filesystem allows it, buffered
+otherwise) and commits it with one fdatasync, however many records it
+holds.
+
+Record layout (native byte order, padded to MESSAGE_LOG_ALIGN):
+    uint32 magic | uint32 size | uint64 sequence | uint32 lane | uint32 crc
+followed by `size` payload bytes. crc is the CRC32C (checksum_engine) of the
+header with the payload's own CRC32C in the crc field, so one check covers
+both.
+
+Each segment, once sealed (rolled over, or its log closed), gets a sparse
+index beside it (%020llu.idx): the length of its intact records and one
+point per MESSAGE_LOG_INDEX_STRIDE bytes giving the offset of the chunk's
+first record and the lowest and highest sequence in the chunk. Sequences
+need not be logged in order; a seek binary-searches the running maximum of
+the chunks ahead of each point and skips chunks whose range misses.
+
+message_log_open maps existing segments read-only. A segment with a valid
+index is taken as is, without reading its records; one without (the tail
+left by a crash) is scanned up to its first record that fails its CRC,
+which marks everything after it invalid, and is then indexed so the next
+open is instant. Records of mapped segments are CRC-checked as they are
+read or replayed.
+
+Durability is set per lane:
+- ASYNC: message_log_append returns at once; written records are synced at
+  least every sync_interval_ms.
+- BATCHED: returns at once; the batch holding the record is synced as soon
+  as it is written.
+- SYNC: returns once the record is on stable storage. Concurrent SYNC
+  appenders share one fdatasync.
+
+POSIX only; message_log_open returns NULL elsewhere.
+*/
+
+#define MESSAGE_LOG_MAGIC 0x474F4C55u                   // "ULOG"
+#define MESSAGE_LOG_ALIGN 8
+#define MESSAGE_LOG_BLOCK 4096                          // O_DIRECT write alignment
+#define MESSAGE_LOG_IO_BUFFER (2u * 1024 * 1024)
+#define MESSAGE_LOG_MAX_RECORD (1u * 1024 * 1024)       // Largest payload
+#define MESSAGE_LOG_MAX_PENDING (64u * 1024 * 1024)     // Staged bytes before appenders wait
+#define MESSAGE_LOG_MAX_LANES 256
+#define MESSAGE_LOG_INDEX_MAGIC 0x58444955u             // "UIDX"
+#define MESSAGE_LOG_INDEX_STRIDE (64u * 1024)           // Segment bytes per index point
+
+typedef enum {
+    MESSAGE_LOG_ASYNC = 0,
+    MESSAGE_LOG_BATCHED = 1,
+    MESSAGE_LOG_SYNC = 2
+} message_log_durability_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint64_t sequence;
+    uint32_t lane;
+    uint32_t crc;
+} message_log_record_t;
+
+typedef struct {
+    uint64_t segment_bytes;                 // Roll to a new segment past this (64 MB)
+    uint32_t sync_interval_ms;              // ASYNC commit interval (10 ms)
+    message_log_durability_t durability;    // Lanes not set explicitly
+    bool direct_io;                         // Try O_DIRECT (true)
+} message_log_config_t;
+
+typedef struct MessageLog MessageLog;
+
+struct message_log_stats {
+    uint64_t records_appended;
+    uint64_t records_recovered;     // Found intact by message_log_open
+    uint64_t segments_indexed;      // Recovered from their index without a scan
+    uint64_t torn_segments;         // Recovered segments cut short by a torn or corrupt record
+    uint64_t bytes_written;         // Including block padding rewritten at batch tails
+    uint64_t batches;
+    uint64_t syncs;
+    uint64_t segments;              // Segments opened for writing
+    bool direct_io;                 // O_DIRECT in use for the current segment
+    bool failed;                    // A write or sync failed; appends are refused
+};
+
+/* Called for each replayed record, in log order (per lane when parallel). */
+typedef void (*message_log_replay_fn)(void* context, uint32_t lane, uint64_t sequence, const void* data, size_t size);
+
+void message_log_default_config(message_log_config_t* config);
+/* Open (creating if needed) the log in `directory`, indexing the records of
+ * existing segments; `config` may be NULL for the defaults. */
+MessageLog* message_log_open(const char* directory, const message_log_config_t* config);
+/* Flushes and syncs everything appended, then stops the log thread. */
+void message_log_close(MessageLog* log);
+
+void message_log_set_lane_durability(MessageLog* log, uint32_t lane, message_log_durability_t durability);
+/* Append a record and honour the lane's durability; returns its log position
+ * (for message_log_wait_durable), or 0 if it was refused. */
+uint64_t message_log_append(MessageLog* log, uint32_t lane, uint64_t sequence, const void* data, size_t size);
+/* Block until everything up to `position` is synced; false if the log failed. */
+bool message_log_wait_durable(MessageLog* log, uint64_t position);
+/* Sync everything appended so far. */
+bool message_log_flush(MessageLog* log);
+
+/* malloc'd copy of the latest record for `sequence` (free() it), or NULL. */
+void* message_log_read(MessageLog* log, uint64_t sequence, size_t* size, uint32_t* lane);
+/* Replay the records with from <= sequence <= to, counting them in
+ * *delivered (may be NULL); false if one no longer reads back intact, which
+ * ends the replay. A sequence logged twice replays its latest record. */
+bool message_log_replay(MessageLog* log, uint64_t from, uint64_t to, message_log_replay_fn callback, void* context,
+                        uint64_t* delivered);
+
+/* As message_log_replay, with each lane's records delivered in log order by
+ * one of `threads` workers (0: one per CPU); different lanes are delivered
+ * concurrently. A lane stops at its first record that fails to read back. */
+bool message_log_replay_parallel(MessageLog* log, uint64_t from, uint64_t to, message_log_replay_fn callback,
+                                 void* context, uint32_t threads, uint64_t* delivered);
+
+void message_log_get_stats(MessageLog* log, struct message_log_stats* stats);
@@ -0,0 +1,38 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+Message Pool
+
+Process-wide, size-classed allocator for the buffers that drain paths hand to
+callers. Requests are rounded up to a power-of-two class between
+MESSAGE_POOL_MIN_SIZE and MESSAGE_POOL_MAX_SIZE; each thread caches freed
+blocks per class and exchanges them with a shared depot in batches, so a
+steady drain/release loop makes no heap calls even when the releasing thread
+is not the one that drained. Larger requests fall through to malloc.
+
+Blocks may be released from any thread. A thread's cached blocks go back to
+the depot when it exits.
+*/
+
+#define MESSAGE_POOL_MIN_SIZE 64
+#define MESSAGE_POOL_MAX_SIZE (64 * 1024)
+#define MESSAGE_POOL_CLASS_COUNT 11     // 64 B ... 64 KB
+#define MESSAGE_POOL_BATCH 32           // Blocks moved between a thread cache and the depot at once
+#define MESSAGE_POOL_ALIGNMENT 16       // Alignment of message_pool_alloc results
+
+/* At least `size` bytes (0 is allowed), or NULL if the heap is exhausted. */
+void* message_pool_alloc(size_t size);
+void message_pool_release(void* ptr);
+
+/* Usable bytes behind a pooled pointer (the class size for pooled blocks). */
+size_t message_pool_capacity(const void* ptr);
+
+/* Hand the calling thread's cached blocks back to the shared depot now
+ * rather than at thread exit. */
+void message_pool_thread_flush(void);
+
+/* Size-classed blocks ever obtained from the heap; flat in steady state. */
+size_t message_pool_heap_allocations(void);
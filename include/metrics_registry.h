@@ -0,0 +1,85 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "latency_histogram.h"
+
+/*
+Metrics Registry
+
+One place to export every subsystem's counters in the Prometheus text
+format (version 0.0.4). Subsystems register what they already keep, once:
+a pointer to a counter word, a read callback for derived values, or a
+LatencyHistogram. A render reads each source with a relaxed load, or the
+histogram's shards directly. Nothing on the data path is locked, reset or
+written, so any number of scrapers can render alongside producers.
+
+Series sharing a name form one family: HELP and TYPE are written once and
+its series stay together whatever order they were registered in. Labels
+are given without braces, `lane="express",bus="main"`, and must already be
+escaped. Registering a series that exists (same name and labels) is a
+no-op, so a subsystem can register again after it grows. Histograms are
+exported in seconds over METRICS_HISTOGRAM_BOUNDS fixed buckets.
+
+Every series records an owner address. Before an owner is freed, remove
+what it registered with metrics_registry_remove; passing the size of an
+enclosing object also removes its embedded subsystems.
+
+Rendering writes into a caller-owned MetricsText that is reused from one
+scrape to the next, so a steady scrape allocates nothing.
+*/
+
+#define METRICS_NAME_MAX 96
+#define METRICS_LABELS_MAX 128
+#define METRICS_HISTOGRAM_BOUNDS 13     // 1 us to 1 s in 1-5-10 steps, plus +Inf
+
+typedef struct MetricsRegistry MetricsRegistry;
+
+typedef enum {
+    METRIC_COUNTER = 0,
+    METRIC_GAUGE = 1,
+    METRIC_HISTOGRAM = 2
+} MetricType;
+
+/* What a value pointer points at; read with a relaxed atomic load. */
+typedef enum {
+    METRIC_U32 = 0,             // uint32_t, atomic_uint32_t, atomic_u32
+    METRIC_U64 = 1,             // uint64_t, atomic_uint64_t
+    METRIC_SIZE = 2,            // size_t, atomic_size_t
+    METRIC_DOUBLE = 3
+} MetricWidth;
+
+/* A derived value, computed at render time. Must not modify state. */
+typedef double (*MetricReadFn)(const void* context);
+
+/* Reusable render output; zero-initialise, free with metrics_text_free. */
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} MetricsText;
+
+MetricsRegistry* metrics_registry_create(void);
+void metrics_registry_destroy(MetricsRegistry* registry);
+
+/* Export the word at `value`. `help` must outlive the series (a literal).
+ * False for an invalid name, a name registered with another type, or OOM. */
+bool metrics_registry_add(MetricsRegistry* registry, const void* owner, MetricType type, const char* name,
+                          const char* help, const char* labels, MetricWidth width, const volatile void* value);
+bool metrics_registry_add_fn(MetricsRegistry* registry, const void* owner, MetricType type, const char* name,
+                             const char* help, const char* labels, MetricReadFn fn, const void* context);
+/* A histogram family `name` with _bucket, _sum and _count series. */
+bool metrics_registry_add_histogram(MetricsRegistry* registry, const void* owner, const char* name,
+                                    const char* help, const char* labels, const LatencyHistogram* histogram);
+
+/* Drop every series whose owner lies in [owner, owner + size); size 0
+ * matches `owner` exactly. Returns how many went. */
+size_t metrics_registry_remove(MetricsRegistry* registry, const void* owner, size_t size);
+size_t metrics_registry_count(MetricsRegistry* registry);
+
+/* `base` and key="value" joined into one label set in `out`; returns out. */
+const char* metrics_labels(char* out, size_t size, const char* base, const char* key, const char* value);
+
+/* Render every series into `out`, replacing what it held. False on OOM. */
+bool metrics_registry_render(MetricsRegistry* registry, MetricsText* out);
+void metrics_text_free(MetricsText* text);
@@ -0,0 +1,72 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "twin_lane.h"
+
+/*
+Network Transport
+
+Bridges a twin lane to the same lane on a peer host over a connected stream
+socket (TCP, or anything with stream semantics). A transport thread gathers
+committed TX frames in place into one sendmsg per batch, so the only copy on
+the way out is the kernel's, and parses received frames into the lane's RX
+ring; payloads of NET_TRANSPORT_DIRECT_BYTES or more are read from the
+socket straight into claimed RX space.
+
+Flow control is the lane's own: every batch of delivered frames is answered
+with one cumulative FEEDBACK_TYPE_ACK frame (the feedback_handshake type
+codes), which the sending side feeds to twin_lane_update_flow_control. When
+the RX ring is full the transport stops reading, so the stream's own window
+pushes back on the peer. The peer's TX ring capacity must not exceed this
+side's RX ring capacity.
+
+Wire format, network byte order, payload follows data frames only:
+    uint32 size | uint32 sequence | uint16 kind | uint16 feedback (type)
+
+POSIX only; net_transport_create returns NULL elsewhere. When idle the
+thread spins briefly and then sleeps in poll() on the socket, so a send that
+arrives during a sleep may wait up to NET_TRANSPORT_IDLE_MS to go out.
+*/
+
+#define NET_TRANSPORT_HEADER 12
+#define NET_TRANSPORT_BATCH 64                      // TX frames per sendmsg
+#define NET_TRANSPORT_RECV_BUFFER (256 * 1024)
+#define NET_TRANSPORT_DIRECT_BYTES (16 * 1024)      // Payloads read straight into the RX ring
+#define NET_TRANSPORT_SPIN_NS 200000ull            // Busy wait after the last activity
+#define NET_TRANSPORT_IDLE_MS 1
+
+typedef enum {
+    NET_FRAME_DATA = 0,
+    NET_FRAME_FEEDBACK = 1
+} net_frame_kind_t;
+
+typedef struct NetTransport NetTransport;
+
+struct net_transport_stats {
+    uint64_t frames_sent;
+    uint64_t frames_received;
+    uint64_t bytes_sent;            // Payload bytes
+    uint64_t bytes_received;
+    uint64_t send_calls;            // sendmsg calls that moved data
+    uint64_t recv_calls;
+    uint64_t acks_sent;
+    uint64_t acks_received;
+    uint64_t direct_frames;         // Received without staging
+};
+
+/* Bridge `lane_id` over `socket_fd`, which the transport takes over (made
+ * non-blocking, closed on destroy). Nothing moves until net_transport_start
+ * or net_transport_poll. */
+NetTransport* net_transport_create(twin_lane_manager_t* manager, uint32_t lane_id, int socket_fd);
+/* Run the transport on its own thread. */
+bool net_transport_start(NetTransport* transport);
+/* One send and receive pass on the calling thread, for callers that drive
+ * the transport themselves; returns whether anything moved. */
+bool net_transport_poll(NetTransport* transport);
+/* False once the peer closed the stream or it failed. */
+bool net_transport_is_open(NetTransport* transport);
+void net_transport_get_stats(NetTransport* transport, struct net_transport_stats* stats);
+/* Stops the thread and closes the socket. A bulk frame caught half-read keeps
+ * its RX space claimed, so the lane should not take further deliveries. */
+void net_transport_destroy(NetTransport* transport);
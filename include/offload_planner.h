@@ -0,0 +1,109 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "atomic_compat.h"
+
+/*
+Offload Planner
+
+Decides per message whether an operation runs on the CPU or is offloaded to
+the GPU. Each path's cost is modelled as fixed + perByte * size nanoseconds,
+fitted to the observed costs: every completed operation updates a running
+average of its size and cost in a log2 size bucket, and the line is a least
+squares fit over the buckets weighted by relative error, so small and large
+messages count alike and a size the bus stops seeing keeps its last
+estimate. offload_planner_calibrate seeds every bucket from a startup
+micro-benchmark; until then (or without GPU samples) the planner falls back
+to OFFLOAD_PLANNER_DEFAULT_CROSSOVER.
+
+The GPU path is charged the mean cost of the GPU operations still in flight
+ahead of it, so a busy device loses work to the CPU. Every
+OFFLOAD_PLANNER_EXPLORE_EVERY decisions a message within a factor of four of
+the crossover takes the other path, which keeps both models current.
+
+Each operation type has its own models and crossover. Any thread; a short
+spinlock guards each planner.
+*/
+
+#define OFFLOAD_PLANNER_BUCKETS 48                          // log2 size buckets
+#define OFFLOAD_PLANNER_ALPHA 0.125                         // Weight of a new sample in its bucket
+#define OFFLOAD_PLANNER_DEFAULT_CROSSOVER (1024 * 1024)     // Before any GPU samples
+#define OFFLOAD_PLANNER_EXPLORE_EVERY 64
+#define OFFLOAD_PLANNER_CALIBRATION_MIN (4 * 1024)
+#define OFFLOAD_PLANNER_CALIBRATION_MAX (16 * 1024 * 1024)
+#define OFFLOAD_PLANNER_CALIBRATION_RUNS 3                  // The fastest run counts
+
+typedef enum {
+    OFFLOAD_OP_SUBMIT = 0,      // Copy a message into its lane
+    OFFLOAD_OP_DRAIN = 1,       // Copy a drained message out
+    OFFLOAD_OP_COUNT
+} OffloadOp;
+
+typedef enum {
+    OFFLOAD_PATH_CPU = 0,
+    OFFLOAD_PATH_GPU = 1
+} OffloadPath;
+
+typedef struct {
+    double bytes;               // Running averages of the bucket's samples
+    double ns;
+    uint32_t samples;
+} OffloadBucket;
+
+typedef struct {
+    OffloadBucket buckets[OFFLOAD_PLANNER_BUCKETS];
+    double fixedNs;
+    double nsPerByte;
+    uint64_t samples;
+    bool fitted;                // Samples at two or more sizes
+} OffloadModel;
+
+typedef struct {
+    OffloadModel path[2];       // By OffloadPath
+    double gpuMeanNs;           // Running average of GPU operation cost
+    size_t crossover;
+    uint32_t gpuInFlight;
+    uint64_t decisions;
+    uint64_t explored;
+} OffloadOpState;
+
+typedef struct {
+    OffloadOpState ops[OFFLOAD_OP_COUNT];
+    bool gpuAvailable;
+    atomic_uint32_t lock;
+} OffloadPlanner;
+
+typedef struct {
+    double cpuFixedNs;
+    double cpuNsPerByte;
+    double gpuFixedNs;
+    double gpuNsPerByte;
+    size_t crossover;           // Smallest size the GPU wins with nothing in flight; SIZE_MAX: never
+    uint64_t cpuSamples;
+    uint64_t gpuSamples;
+    uint64_t explored;          // Decisions that took the other path on purpose
+    uint32_t gpuInFlight;
+} OffloadStats;
+
+// Run one operation of `size` bytes from src into dst; false if the path failed
+typedef bool (*OffloadRunFn)(void* context, void* dst, const void* src, size_t size);
+
+void offload_planner_init(OffloadPlanner* planner, bool gpuAvailable);
+void offload_planner_set_gpu(OffloadPlanner* planner, bool gpuAvailable);
+
+// Time both paths at sizes from OFFLOAD_PLANNER_CALIBRATION_MIN up to
+// maxBytes (x4 steps) and seed every operation's models with the results.
+// False if the GPU path fails, which disables offloading.
+bool offload_planner_calibrate(OffloadPlanner* planner, OffloadRunFn cpu, OffloadRunFn gpu, void* context,
+                               size_t maxBytes);
+
+// Pick a path; a GPU pick counts as in flight until its completion is reported
+OffloadPath offload_planner_choose(OffloadPlanner* planner, OffloadOp op, size_t size);
+// Report how long an operation took; for the GPU, ok=false (it fell back)
+// only ends the in-flight count
+void offload_planner_complete(OffloadPlanner* planner, OffloadOp op, OffloadPath path, size_t size, uint64_t ns,
+                              bool ok);
+
+size_t offload_planner_crossover(OffloadPlanner* planner, OffloadOp op);
+void offload_planner_stats(OffloadPlanner* planner, OffloadOp op, OffloadStats* out);
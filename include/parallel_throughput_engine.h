@@ -1,5 +1,8 @@
 #pragma once
 #include "atomic_compat.h"
+#include "event_scheduler.h"
+#include "cpu_topology.h"
+#include "latency_histogram.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -28,28 +31,169 @@ Features:
 #define UMSBB_RING_BUFFER_SIZE 4096
 #endif
 
-// Thread-safe work queue entry
+#ifndef UMSBB_DEQUE_SIZE
+#define UMSBB_DEQUE_SIZE 1024           // Per-worker deque slots (power of 2)
+#endif
+
+// How workers find work (parallel_engine_t.load_balance_strategy)
+typedef enum {
+    PARALLEL_BALANCE_ROUND_ROBIN = 0,   // Each worker drains only its home lane queue
+    PARALLEL_BALANCE_WORK_STEALING = 1, // Per-worker deques, idle workers steal
+    PARALLEL_BALANCE_ADAPTIVE = 2       // Currently the same as work-stealing
+} parallel_balance_t;
+
+#ifndef UMSBB_IDLE_SPIN_YIELD
+#define UMSBB_IDLE_SPIN_YIELD 1024      // Spinning workers yield every this many empty passes
+#endif
+
+#ifndef UMSBB_PARK_TIMEOUT_NS
+#define UMSBB_PARK_TIMEOUT_NS 2000000ull // Parked workers re-scan for stealable work this often
+#endif
+
+#ifndef UMSBB_IDLE_SLEEP_US
+#define UMSBB_IDLE_SLEEP_US 500         // Sleep of a batching worker that found nothing
+#endif
+
+/*
+What a worker does when it finds no work (parallel_engine_t.idle_policy).
+parallel_set_strategy picks one per throughput strategy:
+  LATENCY_OPTIMIZED   -> SPIN   (pause in a loop, a core per worker)
+  BALANCED, ADAPTIVE  -> PARK   (event_wait's adaptive spin, then a futex)
+  BANDWIDTH_OPTIMIZED -> SLEEP  (let work pile up, then take it in batches)
+Submits wake one parked worker, preferring the lane's home worker; a worker
+that takes a batch wakes another to steal from it.
+*/
+typedef enum {
+    PARALLEL_IDLE_SPIN = 0,
+    PARALLEL_IDLE_PARK = 1,
+    PARALLEL_IDLE_SLEEP = 2
+} parallel_idle_t;
+
+#ifndef UMSBB_AUTOSCALE_INTERVAL_MS
+#define UMSBB_AUTOSCALE_INTERVAL_MS 50  // Default sample period of the scaling controller
+#endif
+
+/*
+Load-following worker count (parallel_enable_autoscale). A controller thread
+samples the engine every sample_interval_ms and moves the worker count:
+  up    when queued tasks per worker exceed queue_high, the p99 of submit to
+        handler-done latency exceeds p99_high_ns, or the workers were busy
+        more than busy_high_percent of the period; by one worker, or double
+        when the queue is four times over its mark
+  down  by one when every signal is at or below its low mark
+Between the marks nothing changes, and after a change the controller waits
+cooldown_ms before the next one. Signals whose high mark is 0 are ignored.
+*/
+typedef struct {
+    uint32_t min_workers;
+    uint32_t max_workers;
+    uint32_t queue_high;            // Queued tasks per worker
+    uint32_t queue_low;
+    uint64_t p99_high_ns;
+    uint64_t p99_low_ns;
+    uint32_t busy_high_percent;     // Time spent running batches, per worker
+    uint32_t busy_low_percent;
+    uint32_t sample_interval_ms;    // 0: UMSBB_AUTOSCALE_INTERVAL_MS
+    uint32_t cooldown_ms;
+} parallel_autoscale_t;
+
+// What one controller sample saw (parallel_sample_load)
 typedef struct {
+    uint32_t workers;
+    uint32_t queue_depth;           // Lane queues and worker deques
+    uint64_t p99_ns;                // Tasks finished since the previous sample
+    uint32_t busy_percent;
+} parallel_load_sample_t;
+
+// Work item status values
+#define PARALLEL_STATUS_PENDING 0
+#define PARALLEL_STATUS_PROCESSING 1
+#define PARALLEL_STATUS_COMPLETE 2
+#define PARALLEL_STATUS_ERROR 3
+
+// parallel_work_item_t.flags
+#define PARALLEL_ITEM_OWNED 1u          // data is an engine copy, released after the handler
+
+// Thread-safe work queue entry
+typedef struct parallel_work_item {
     uint64_t message_id;
     uint32_t lane_id;
     uint32_t priority;
     uint32_t size;
     void* data;
-    uint64_t timestamp;
+    uint64_t timestamp;             // umsbb_clock_ns() at submit
     uint32_t language_id;
     atomic_uint32_t status; // 0=pending, 1=processing, 2=complete, 3=error
+    uint32_t flags;
+    struct parallel_work_item* origin; // Submitter's item, told the final status
 } parallel_work_item_t;
 
-// Lock-free ring buffer for work distribution
+/*
+Consumer handler for one lane. Workers call it with up to batch_size items of
+that lane at a time, all with status PROCESSING; a handler marks failures
+with PARALLEL_STATUS_ERROR and leaves the rest, which complete. Item data is
+valid only during the call. Register before parallel_engine_start or while
+the lane is quiet; lanes without a handler just count their items.
+*/
+typedef void (*parallel_handler_fn)(parallel_work_item_t* items, uint32_t count, void* ctx);
+
 typedef struct {
-    UMSBB_ATOMIC(uint64_t) head;
-    UMSBB_ATOMIC(uint64_t) tail;
+    parallel_handler_fn fn;
+    void* ctx;
+} parallel_handler_t;
+
+/*
+What lane queues and deques carry: half a cache line, with no atomics. The
+lane is kept because deques mix lanes. Copied submits own `data` and have no
+origin; zero-copy batch items point back at the submitter's item.
+*/
+typedef struct {
+    void* data;
+    struct parallel_work_item* origin;
+    uint64_t timestamp;             // umsbb_clock_ns() at submit
+    uint32_t size;
+    uint16_t priority;              // Saturated to 16 bits
+    uint8_t lane_id;
+    uint8_t language_id;
+} parallel_task_t;
+
+/*
+Lock-free MPMC ring buffer for work distribution. Each side reserves a run of
+slots with one CAS on its reserve cursor, fills or copies the run, and then
+publishes it with one store once every earlier run on that side has been
+published, so a batch of N costs two shared-cursor updates, not 2N.
+*/
+typedef struct {
+    UMSBB_ATOMIC(uint64_t) head;            // Slots before head are free again
+    char head_padding[56];
+    UMSBB_ATOMIC(uint64_t) tail;            // Slots before tail are readable
+    char tail_padding[56];
+    UMSBB_ATOMIC(uint64_t) reserve_tail;    // Claimed by producers
+    char reserve_tail_padding[56];
+    UMSBB_ATOMIC(uint64_t) reserve_head;    // Claimed by consumers
     uint32_t capacity;
     uint32_t mask; // capacity - 1 (must be power of 2)
-    parallel_work_item_t* items;
+    parallel_task_t* items;
     char padding[64]; // Cache line alignment
 } parallel_ring_buffer_t;
 
+/*
+Chase-Lev work-stealing deque. The owning worker pushes and pops at the
+bottom without contention; other workers steal from the top with one CAS per
+item. Fixed capacity: a push into a full deque fails and the owner runs the
+item itself.
+*/
+typedef struct {
+    UMSBB_ATOMIC(int64_t) top;          // Next item thieves take
+    char top_padding[56];
+    UMSBB_ATOMIC(int64_t) bottom;       // Next free slot, owner only
+    uint32_t mask;
+    parallel_task_t* items;
+    char padding[40];
+} parallel_deque_t;
+
+struct parallel_engine;
+
 // Worker thread context
 typedef struct {
     uint32_t thread_id;
@@ -58,17 +202,32 @@ typedef struct {
     UMSBB_ATOMIC(uint64_t) messages_processed;
     UMSBB_ATOMIC(uint64_t) bytes_processed;
     UMSBB_ATOMIC(uint64_t) total_latency_ns;
-    parallel_ring_buffer_t* work_queue;
+    UMSBB_ATOMIC(uint64_t) steals;          // Successful steal operations
+    UMSBB_ATOMIC(uint64_t) items_stolen;    // Items taken from peers or foreign lanes
+    UMSBB_ATOMIC(uint64_t) idle_rounds;     // Passes that found no work anywhere
+    UMSBB_ATOMIC(uint64_t) parks;           // Times the worker went to sleep on `wake`
+    UMSBB_ATOMIC(uint64_t) busy_ns;         // Time spent running batches
+    UMSBB_ATOMIC(bool) retiring;            // Drain the deque, then exit
+    parallel_ring_buffer_t* work_queue;     // Home lane queue
+    parallel_deque_t deque;
+    parallel_task_t* staging;               // Bulk pops and the batch being run
+    parallel_work_item_t* batch;            // Items handed to one handler call
+    EventScheduler wake;                    // Signaled to unpark the worker
+    struct parallel_engine* engine;
+    uint32_t rng;                           // Victim selection
+    uint32_t numa_node;                     // Node of cpu_core once placed
+    bool pinned;                            // cpu_core is applied to the thread
     void* thread_handle;
     char padding[32]; // Cache line alignment
 } parallel_worker_t;
 
 // Parallel processing engine
-typedef struct {
-    uint32_t num_workers;
+typedef struct parallel_engine {
+    UMSBB_ATOMIC(uint32_t) num_workers;     // Live workers, slots 0..num_workers-1
     uint32_t num_lanes;
     parallel_worker_t workers[UMSBB_MAX_WORKER_THREADS];
     parallel_ring_buffer_t lane_queues[4]; // One per lane type
+    parallel_handler_t handlers[4];
     
     // Performance metrics
     UMSBB_ATOMIC(uint64_t) total_messages;
@@ -79,13 +238,27 @@ typedef struct {
     // Load balancing
     UMSBB_ATOMIC(uint32_t) round_robin_counter;
     uint32_t load_balance_strategy; // 0=round-robin, 1=work-stealing, 2=adaptive
+    uint32_t idle_policy;           // parallel_idle_t
+    UMSBB_ATOMIC(uint32_t) parked_workers; // Bit per parked worker
     
     // System configuration
     bool numa_aware;
     bool cpu_affinity_enabled;
+    cpu_topology_t* topology;       // Discovered on first use
     uint32_t batch_size;
     uint32_t prefetch_distance;
     
+    // Live scaling
+    bool running;                   // Between start and stop
+    UMSBB_ATOMIC(uint32_t) resize_lock;
+    LatencyHistogram* latency;      // Submit to handler done, per task
+    uint64_t sample_ns;             // Baseline of the previous parallel_sample_load
+    uint64_t sample_busy_ns;
+    parallel_autoscale_t autoscale;
+    UMSBB_ATOMIC(bool) autoscaling;
+    EventScheduler autoscale_wake;
+    void* autoscale_thread;
+    
     char padding[64]; // Cache line alignment
 } parallel_engine_t;
 
@@ -107,6 +280,23 @@ typedef struct {
     double cpu_utilization;
     uint32_t cache_hit_rate;
     uint32_t numa_misses;
+
+    // Work distribution
+    uint32_t worker_count;
+    uint64_t steals;
+    uint64_t items_stolen;
+    uint64_t idle_rounds;
+    uint64_t parks;
+    struct {
+        uint64_t messages_processed;
+        uint64_t steals;
+        uint64_t items_stolen;
+        uint64_t idle_rounds;
+        uint64_t parks;
+        uint32_t cpu_core;
+        uint32_t numa_node;
+        bool pinned;
+    } workers[UMSBB_MAX_WORKER_THREADS];
 } performance_profile_t;
 
 // API Functions
@@ -121,55 +311,70 @@ int parallel_engine_stop(parallel_engine_t* engine);
 void parallel_engine_destroy(parallel_engine_t* engine);
 
 // Work submission
+/* Copies `data`; the caller's buffer is free once this returns. */
 int parallel_submit_work(parallel_engine_t* engine, uint32_t lane_id, 
                         const void* data, uint32_t size, uint32_t priority, uint32_t language_id);
+/* Zero-copy: each item's data must stay valid, and the items array in place,
+ * until that item's status turns COMPLETE or ERROR. Returns the number
+ * queued, or -1. */
 int parallel_submit_batch(parallel_engine_t* engine, uint32_t lane_id,
                          parallel_work_item_t* items, uint32_t count);
 
+// Consumers
+int parallel_register_handler(parallel_engine_t* engine, uint32_t lane_id, parallel_handler_fn fn, void* ctx);
+
 // Performance monitoring
 int parallel_get_performance(parallel_engine_t* engine, performance_profile_t* profile);
 double parallel_get_instantaneous_throughput_mbps(parallel_engine_t* engine);
 uint32_t parallel_get_queue_depth(parallel_engine_t* engine, uint32_t lane_id);
 
 // Dynamic tuning
+/* Resize the worker pool; on a running engine new workers start at once and
+ * retired ones (the highest numbered) finish the tasks in their deques
+ * before their threads are joined. Profiles cover live workers only. */
 int parallel_adjust_workers(parallel_engine_t* engine, uint32_t new_count);
 int parallel_set_strategy(parallel_engine_t* engine, throughput_strategy_t strategy);
+int parallel_set_load_balance(parallel_engine_t* engine, parallel_balance_t strategy);
+int parallel_set_idle_policy(parallel_engine_t* engine, parallel_idle_t policy);
 int parallel_tune_batch_size(parallel_engine_t* engine, uint32_t new_size);
 
+// Load-following scaling
+/* Start (or re-configure) the scaling controller thread; stopped by
+ * parallel_disable_autoscale, parallel_engine_stop or destroy. */
+int parallel_enable_autoscale(parallel_engine_t* engine, const parallel_autoscale_t* policy);
+void parallel_disable_autoscale(parallel_engine_t* engine);
+/* Load since the previous call. Intervals are shared, so only one caller
+ * (the controller, when enabled) should sample. */
+int parallel_sample_load(parallel_engine_t* engine, parallel_load_sample_t* sample);
+/* Worker count the policy wants for a sample, within min and max. */
+uint32_t parallel_autoscale_target(const parallel_autoscale_t* policy, const parallel_load_sample_t* sample);
+
 // NUMA and CPU affinity
+/* Pin every worker not pinned explicitly, in cpu_topology_spread order
+ * (physical cores node by node, then hyperthreads), move each worker's deque
+ * and home lane queue to its node, and prefer same-node victims when
+ * stealing. Takes effect immediately on running workers. */
 int parallel_enable_numa_awareness(parallel_engine_t* engine);
+/* Pin one worker to an online CPU; -1 if the CPU is unknown or the platform
+ * refused. Applied at start for workers not yet running. */
 int parallel_set_cpu_affinity(parallel_engine_t* engine, uint32_t worker_id, uint32_t cpu_core);
 
+// Ring operations. Bulk calls move as many tasks as fit (push) or are
+// queued (pop), up to `count`, and return how many.
+uint32_t parallel_ring_buffer_push_bulk(parallel_ring_buffer_t* ring, const parallel_task_t* tasks, uint32_t count);
+uint32_t parallel_ring_buffer_pop_bulk(parallel_ring_buffer_t* ring, parallel_task_t* tasks, uint32_t count);
+
 #ifdef __cplusplus
 }
 #endif
 
 // Inline performance-critical functions
-static inline bool parallel_ring_buffer_push(parallel_ring_buffer_t* ring, parallel_work_item_t* item) {
-    uint64_t tail = atomic_load(&ring->tail);
-    uint64_t next_tail = tail + 1;
-    uint64_t head = atomic_load(&ring->head);
-    
-    if (next_tail - head > ring->capacity) {
-        return false; // Ring buffer full
-    }
-    
-    ring->items[tail & ring->mask] = *item;
-    atomic_store(&ring->tail, next_tail);
-    return true;
+static inline bool parallel_ring_buffer_push(parallel_ring_buffer_t* ring, const parallel_task_t* task) {
+    return parallel_ring_buffer_push_bulk(ring, task, 1) == 1;
 }
 
-static inline bool parallel_ring_buffer_pop(parallel_ring_buffer_t* ring, parallel_work_item_t* item) {
-    uint64_t head = atomic_load(&ring->head);
-    uint64_t tail = atomic_load(&ring->tail);
-    
-    if (head == tail) {
-        return false; // Ring buffer empty
-    }
-    
-    *item = ring->items[head & ring->mask];
-    atomic_store(&ring->head, head + 1);
-    return true;
+static inline bool parallel_ring_buffer_pop(parallel_ring_buffer_t* ring, parallel_task_t* task) {
+    return parallel_ring_buffer_pop_bulk(ring, task, 1) == 1;
 }
 
 // Performance macros
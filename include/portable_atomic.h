@@ -1,5 +1,6 @@
 #pragma once
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 /* Portable, minimal atomic helpers used by universal-multi-segmented-bi-buffer-bus.
@@ -14,6 +15,9 @@
 
 typedef volatile size_t atomic_size_t;
 typedef volatile char atomic_bool;
+typedef volatile unsigned char atomic_uchar;
+typedef volatile uint32_t atomic_u32;
+typedef void* volatile atomic_voidptr;
 
 static inline void atomic_init_bool(atomic_bool* p, bool v) { *p = v ? 1 : 0; }
 static inline void atomic_store_bool(atomic_bool* p, bool v) { *p = v ? 1 : 0; }
@@ -28,12 +32,69 @@ static inline size_t atomic_fetch_add_size(atomic_size_t* p, size_t v) {
     return (size_t)InterlockedExchangeAdd((volatile LONG*)p, (LONG)v);
 #endif
 }
+static inline bool atomic_cas_size(atomic_size_t* p, size_t* expected, size_t desired) {
+#if defined(_M_X64) || defined(_M_ARM64)
+    size_t prev = (size_t)InterlockedCompareExchange64((volatile LONGLONG*)p, (LONGLONG)desired, (LONGLONG)*expected);
+#else
+    size_t prev = (size_t)InterlockedCompareExchange((volatile LONG*)p, (LONG)desired, (LONG)*expected);
+#endif
+    if (prev == *expected) return true;
+    *expected = prev;
+    return false;
+}
+static inline size_t atomic_fetch_or_size(atomic_size_t* p, size_t v) {
+#if defined(_M_X64) || defined(_M_ARM64)
+    return (size_t)InterlockedOr64((volatile LONGLONG*)p, (LONGLONG)v);
+#else
+    return (size_t)InterlockedOr((volatile LONG*)p, (LONG)v);
+#endif
+}
+static inline size_t atomic_fetch_and_size(atomic_size_t* p, size_t v) {
+#if defined(_M_X64) || defined(_M_ARM64)
+    return (size_t)InterlockedAnd64((volatile LONGLONG*)p, (LONGLONG)v);
+#else
+    return (size_t)InterlockedAnd((volatile LONG*)p, (LONG)v);
+#endif
+}
+
+/* MSVC volatile accesses already carry acquire/release semantics. */
+static inline size_t atomic_load_size_relaxed(atomic_size_t* p) { return *p; }
+static inline size_t atomic_load_size_acquire(atomic_size_t* p) { return *p; }
+static inline void atomic_store_size_release(atomic_size_t* p, size_t v) { *p = v; }
+static inline void atomic_store_size_relaxed(atomic_size_t* p, size_t v) { *p = v; }
+static inline size_t atomic_fetch_add_size_relaxed(atomic_size_t* p, size_t v) { return atomic_fetch_add_size(p, v); }
+static inline unsigned char atomic_load_uchar(atomic_uchar* p) { return *p; }
+static inline void atomic_store_uchar(atomic_uchar* p, unsigned char v) { *p = v; }
+static inline void* atomic_load_ptr_relaxed(atomic_voidptr* p) { return *p; }
+static inline void* atomic_load_ptr_acquire(atomic_voidptr* p) { return *p; }
+static inline void atomic_store_ptr_relaxed(atomic_voidptr* p, void* v) { *p = v; }
+static inline void atomic_store_ptr_release(atomic_voidptr* p, void* v) { *p = v; }
+static inline void atomic_fence_acquire(void) { MemoryBarrier(); }
+static inline void atomic_fence_release(void) { MemoryBarrier(); }
+static inline void atomic_fence_seq_cst(void) { MemoryBarrier(); }
+
+/* 32-bit words for futex-style waits. */
+static inline uint32_t atomic_load_u32(atomic_u32* p) { return *p; }
+static inline void atomic_store_u32(atomic_u32* p, uint32_t v) { InterlockedExchange((volatile LONG*)p, (LONG)v); }
+static inline uint32_t atomic_fetch_add_u32(atomic_u32* p, uint32_t v) {
+    return (uint32_t)InterlockedExchangeAdd((volatile LONG*)p, (LONG)v);
+}
+static inline uint32_t atomic_exchange_u32(atomic_u32* p, uint32_t v) {
+    return (uint32_t)InterlockedExchange((volatile LONG*)p, (LONG)v);
+}
+static inline bool atomic_cas_u32(atomic_u32* p, uint32_t* expected, uint32_t desired) {
+    uint32_t prev = (uint32_t)InterlockedCompareExchange((volatile LONG*)p, (LONG)desired, (LONG)*expected);
+    if (prev == *expected) return true;
+    *expected = prev;
+    return false;
+}
 
 #else
 #  include <stdatomic.h>
 
 typedef _Atomic size_t atomic_size_t;
 typedef _Atomic _Bool atomic_bool;
+typedef _Atomic(void*) atomic_voidptr;
 
 static inline void atomic_init_bool(atomic_bool* p, bool v) { atomic_init(p, v); }
 static inline void atomic_store_bool(atomic_bool* p, bool v) { atomic_store(p, v); }
@@ -42,5 +103,36 @@ static inline bool atomic_load_bool(atomic_bool* p) { return atomic_load(p); }
 static inline size_t atomic_load_size(atomic_size_t* p) { return atomic_load(p); }
 static inline void atomic_store_size(atomic_size_t* p, size_t v) { atomic_store(p, v); }
 static inline size_t atomic_fetch_add_size(atomic_size_t* p, size_t v) { return atomic_fetch_add(p, v); }
+static inline bool atomic_cas_size(atomic_size_t* p, size_t* expected, size_t desired) {
+    return atomic_compare_exchange_weak(p, expected, desired);
+}
+static inline size_t atomic_fetch_or_size(atomic_size_t* p, size_t v) { return atomic_fetch_or(p, v); }
+static inline size_t atomic_fetch_and_size(atomic_size_t* p, size_t v) { return atomic_fetch_and(p, v); }
+
+/* Ordered variants for the ring fast paths. */
+static inline size_t atomic_load_size_relaxed(atomic_size_t* p) { return atomic_load_explicit(p, memory_order_relaxed); }
+static inline size_t atomic_load_size_acquire(atomic_size_t* p) { return atomic_load_explicit(p, memory_order_acquire); }
+static inline void atomic_store_size_release(atomic_size_t* p, size_t v) { atomic_store_explicit(p, v, memory_order_release); }
+static inline void atomic_store_size_relaxed(atomic_size_t* p, size_t v) { atomic_store_explicit(p, v, memory_order_relaxed); }
+static inline size_t atomic_fetch_add_size_relaxed(atomic_size_t* p, size_t v) { return atomic_fetch_add_explicit(p, v, memory_order_relaxed); }
+static inline unsigned char atomic_load_uchar(atomic_uchar* p) { return atomic_load_explicit(p, memory_order_acquire); }
+static inline void atomic_store_uchar(atomic_uchar* p, unsigned char v) { atomic_store_explicit(p, v, memory_order_release); }
+static inline void* atomic_load_ptr_relaxed(atomic_voidptr* p) { return atomic_load_explicit(p, memory_order_relaxed); }
+static inline void* atomic_load_ptr_acquire(atomic_voidptr* p) { return atomic_load_explicit(p, memory_order_acquire); }
+static inline void atomic_store_ptr_relaxed(atomic_voidptr* p, void* v) { atomic_store_explicit(p, v, memory_order_relaxed); }
+static inline void atomic_store_ptr_release(atomic_voidptr* p, void* v) { atomic_store_explicit(p, v, memory_order_release); }
+static inline void atomic_fence_acquire(void) { atomic_thread_fence(memory_order_acquire); }
+static inline void atomic_fence_release(void) { atomic_thread_fence(memory_order_release); }
+static inline void atomic_fence_seq_cst(void) { atomic_thread_fence(memory_order_seq_cst); }
+
+/* 32-bit words for futex-style waits. */
+typedef _Atomic uint32_t atomic_u32;
+static inline uint32_t atomic_load_u32(atomic_u32* p) { return atomic_load(p); }
+static inline void atomic_store_u32(atomic_u32* p, uint32_t v) { atomic_store(p, v); }
+static inline uint32_t atomic_fetch_add_u32(atomic_u32* p, uint32_t v) { return atomic_fetch_add(p, v); }
+static inline uint32_t atomic_exchange_u32(atomic_u32* p, uint32_t v) { return atomic_exchange(p, v); }
+static inline bool atomic_cas_u32(atomic_u32* p, uint32_t* expected, uint32_t desired) {
+    return atomic_compare_exchange_strong(p, expected, desired);
+}
 
 #endif
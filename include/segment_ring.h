@@ -1,15 +1,79 @@
 #pragma once
 #include <stddef.h>
+#include <stdbool.h>
 #include "bi_buffer.h"
 
-#define MAX_AGENTS 16
+#define SEGMENT_RING_MAX_LANES 1024
+#define MAX_AGENTS SEGMENT_RING_MAX_LANES   // Historical name of the lane limit
+#define SEGMENT_RING_WORD_BITS (sizeof(size_t) * 8)
+#define SEGMENT_RING_READY_WORDS (SEGMENT_RING_MAX_LANES / SEGMENT_RING_WORD_BITS)
+#define SEGMENT_RING_NONE ((size_t)-1)
+
+/*
+ * How producers pick a lane when they do not name one.
+ * ROUND_ROBIN: each thread cycles through the active lanes from its own
+ *              starting point, so producers never share a cursor.
+ * AFFINITY:    each thread sticks to one lane chosen from its thread-local
+ *              token; with no more producer threads than lanes every
+ *              producer owns its lane (which may then be switched to
+ *              BI_BUFFER_MODE_SPSC) and per-producer order is preserved
+ *              for free.
+ * Lanes are created BI_BUFFER_MODE_MPSC, which is valid under either.
+ */
+typedef enum {
+    SEGMENT_ROUTING_ROUND_ROBIN = 0,
+    SEGMENT_ROUTING_AFFINITY = 1
+} SegmentRouting;
+
+/*
+ * Lanes [0, activeCount) receive new traffic; lanes [activeCount, laneCount)
+ * have been retired but keep their storage and are still drained, so a
+ * producer that picked a lane just before it was removed never loses its
+ * message. Adding a lane revives a retired one before creating a new one.
+ * Each lane is a separate cache-aligned allocation; the slot table is sized
+ * for SEGMENT_RING_MAX_LANES up front so it never moves under readers.
+ */
+/*
+ * One bit per lane that may hold committed messages, plus one summary bit per
+ * word. Producers set a lane's bit on commit (a plain load once it is set);
+ * the lane's consumer clears it when it drains the lane empty and re-checks
+ * the lane afterwards, so a bit can be stale-set but never stale-clear.
+ */
+typedef struct {
+    atomic_size_t summary;
+    atomic_size_t words[SEGMENT_RING_READY_WORDS];
+} SegmentReadyMap;
 
 typedef struct {
-    BiBuffer buffers[MAX_AGENTS];
-    size_t activeCount;
-    size_t currentIndex;
+    BiBuffer** buffers;     // SEGMENT_RING_MAX_LANES slots, [0, laneCount) populated
+    size_t activeCount;     // Lanes accepting submissions
+    size_t laneCount;       // Lanes initialised (active plus retired)
+    size_t bufferCap;       // Capacity given to lanes created later
+    size_t currentIndex;    // Consumer-side round-robin position
+    SegmentRouting routing;
+    SegmentReadyMap* ready; // Separate allocation, off the lines written per drain
 } SegmentRing;
 
-void segment_ring_init(SegmentRing* ring, size_t agentCount, size_t bufferCap);
+bool segment_ring_init(SegmentRing* ring, size_t agentCount, size_t bufferCap);
+/* Lane the calling thread should submit to; touches only thread-local state. */
+size_t segment_ring_pick(SegmentRing* ring);
 BiBuffer* segment_ring_next(SegmentRing* ring);
-void segment_ring_reset(SegmentRing* ring);
\ No newline at end of file
+void segment_ring_reset(SegmentRing* ring);
+void segment_ring_set_routing(SegmentRing* ring, SegmentRouting routing);
+
+/* Online scaling; both fail at the SEGMENT_RING_MAX_LANES / one-lane limits. */
+bool segment_ring_add_lane(SegmentRing* ring);
+bool segment_ring_remove_lane(SegmentRing* ring);
+void segment_ring_destroy(SegmentRing* ring);
+
+/* Producer side, after committing to `lane`; includes the full fence the
+ * ready-bit handshake needs, so loads that follow are ordered after the commit. */
+void segment_ring_mark_ready(SegmentRing* ring, size_t lane);
+/* Consumer side, after releasing from `lane`: clears its bit if the lane is
+ * now empty. Returns whether the lane still holds messages. */
+bool segment_ring_mark_drained(SegmentRing* ring, size_t lane);
+/* First lane at or after `from` (wrapping) whose bit is set, or SEGMENT_RING_NONE. */
+size_t segment_ring_next_ready(SegmentRing* ring, size_t from);
+/* Whether any lane holds messages; verifies set bits and clears stale ones,
+ * so only the lanes' consumer may call it. */
+bool segment_ring_has_ready(SegmentRing* ring);
@@ -0,0 +1,56 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+Shared Memory Segment
+
+A named region that several processes map at the same time: shm_open + mmap
+on POSIX, a named file mapping on Windows (not available on WASM). The
+segment starts with a versioned header and a small directory of named
+allocations; everything after it is handed out by shm_segment_alloc in
+SHM_SEGMENT_ALIGNMENT units and never freed. Each process maps the segment at
+its own address, so data placed in it must refer to other data by offset
+(shm_segment_offset / shm_segment_pointer), never by pointer.
+
+Atomics placed in the segment must be lock-free, which every 32-bit and, on
+64-bit targets, every 64-bit atomic in this library is.
+
+shm_segment_wait / shm_segment_wake block and wake on a 32-bit word in the
+segment across processes: a futex on Linux; elsewhere the waiter polls with
+short sleeps.
+*/
+
+#define SHM_SEGMENT_MAGIC 0x42534D55u       // "UMSB"
+#define SHM_SEGMENT_VERSION 1
+#define SHM_SEGMENT_NAME_MAX 48             // Including the terminator
+#define SHM_SEGMENT_MAX_ENTRIES 64
+#define SHM_SEGMENT_ALIGNMENT 64
+
+typedef struct ShmSegment ShmSegment;
+
+/* Create and map a new segment of at least `size` usable bytes. Fails (NULL)
+ * if the name is taken. The creator removes the name when it closes. */
+ShmSegment* shm_segment_create(const char* name, size_t size);
+/* Map an existing segment; NULL if it does not exist, is not finished being
+ * created, or was laid out by an incompatible version. */
+ShmSegment* shm_segment_open(const char* name);
+void shm_segment_close(ShmSegment* segment);
+
+/* Zeroed, SHM_SEGMENT_ALIGNMENT-aligned storage published under `name` for
+ * shm_segment_find; NULL when the segment or its directory is full. Safe from
+ * any process; names are expected to be unique. */
+void* shm_segment_alloc(ShmSegment* segment, const char* name, size_t size);
+/* Storage published under `name` (its size in *size if given), or NULL. */
+void* shm_segment_find(ShmSegment* segment, const char* name, size_t* size);
+
+uint64_t shm_segment_offset(const ShmSegment* segment, const void* ptr);
+void* shm_segment_pointer(const ShmSegment* segment, uint64_t offset);
+size_t shm_segment_size(const ShmSegment* segment);
+
+/* Sleep while the 32-bit word at `word` reads `expected`, for at most
+ * timeout_ns. May return early; callers re-check their condition. */
+void shm_segment_wait(void* word, uint32_t expected, uint64_t timeout_ns);
+/* Wake every process waiting on `word`. */
+void shm_segment_wake(void* word);
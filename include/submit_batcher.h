@@ -0,0 +1,137 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bi_buffer.h"
+#include "adaptive_batch.h"
+
+/*
+Submit Batcher
+
+Producer-side coalescing for one ring lane, in the spirit of Nagle's
+algorithm. Small submits are copied into a staging area owned by the
+calling thread and committed to the lane as one multi-record frame once
+the stage holds `target` messages, would outgrow max_bytes, or its oldest
+message has waited max_delay_ns. A chatty producer then pays for a claim,
+a commit and a wake-up once per batch instead of once per message.
+
+A batched frame is a regular BiBufferFrame with SUBMIT_BATCH_FRAME_FLAG
+set. Its checksum covers the whole payload, laid out as
+
+    [SubmitBatchHeader][SubmitRecord][bytes][pad to 16] ...
+
+so record payloads keep the 16-byte alignment of ring frames. The bus
+unpacks these frames in every drain path, and each record keeps a
+sequence number of its own.
+
+`target` is an AdaptiveBatch between 1 and max_records that only the
+consumer moves. Each time it retires a frame it reports the lane's
+backlog and, for a batched frame, how long the frame waited in the ring.
+Falling behind, or frames that wait as long as the deadline, grow the
+batch, and a consumer that keeps up shrinks it again. At a target of 1,
+submits skip the stage and cost nothing extra. Producers only read the
+published target.
+
+Deadlines are enforced by the producer's next submit, and by consumers
+that find the lane empty or wait for it. Stages of threads that have
+exited are flushed the same way. Whoever commits a stage holds its lock,
+and an owner that finds its stage empty claims only after the flusher's
+commit. So even on an SPSC lane, the ring sees one producer at a time.
+*/
+
+#define SUBMIT_BATCH_FRAME_FLAG 0x4u        // BiBufferFrame.flags bit above CHECKSUM_POLICY_MASK
+#define SUBMIT_BATCH_RECORD_ALIGN 16
+#define SUBMIT_BATCH_CACHE_WAYS 8           // Stages a thread finds without a list walk
+
+typedef struct {
+    uint32_t count;             // Records in the frame
+    uint32_t reserved;
+    uint64_t committed_ns;      // umsbb_clock_ns at commit, for the drain latency
+} SubmitBatchHeader;
+
+typedef struct {
+    uint32_t length;            // Payload bytes following the record header
+    uint32_t offset;            // Of this header from the start of the frame payload
+    uint32_t index;             // Position in the frame; the sequence is the frame's + index
+    uint32_t reserved;
+} SubmitRecord;
+
+#define SUBMIT_BATCH_RECORD_SIZE(len) \
+    ((sizeof(SubmitRecord) + (size_t)(len) + (SUBMIT_BATCH_RECORD_ALIGN - 1)) & ~(size_t)(SUBMIT_BATCH_RECORD_ALIGN - 1))
+
+typedef struct {
+    uint32_t max_records;       // Largest batch; 0 or 1 turns batching off
+    uint32_t max_bytes;         // Largest frame payload, header included
+    uint32_t max_record;        // Larger messages are committed on their own
+    uint64_t max_delay_ns;      // Longest a staged message waits for its batch
+} SubmitBatchConfig;
+
+typedef struct {
+    size_t frames;              // Batched frames committed
+    size_t records;             // ... and the messages in them
+    size_t deadline_flushes;    // Frames committed by a consumer because their deadline passed
+    size_t target;              // Current batch size
+} SubmitBatchStats;
+
+typedef enum {
+    SUBMIT_BATCH_STAGED = 0,    // Taken; it reaches the lane with its batch
+    SUBMIT_BATCH_DIRECT = 1,    // Not batched: commit it yourself, the caller's stage has gone first
+    SUBMIT_BATCH_REFUSED = 2    // The lane refused the staged batch, so this message was not taken
+} SubmitBatchResult;
+
+/* Commits `size` bytes of a batched frame holding `count` records to `lane`. */
+typedef bool (*submit_batch_commit_fn)(void* context, size_t lane, const void* frame, size_t size, uint32_t count);
+
+typedef struct SubmitBatchStage SubmitBatchStage;
+
+typedef struct {
+    size_t lane;
+    uint64_t id;                        // Tells cached stages apart when an address is reused
+    submit_batch_commit_fn commit;
+    void* context;
+
+    atomic_size_t max_records;
+    atomic_size_t max_bytes;
+    atomic_size_t max_record;
+    atomic_size_t max_delay_ns;
+    atomic_size_t target;               // batch.current as producers see it
+    atomic_size_t stages;               // SubmitBatchStage list, one per producer thread
+    atomic_size_t staged;               // Stages holding messages
+
+    atomic_size_t frames;
+    atomic_size_t records;
+    atomic_size_t deadline_flushes;
+
+    // Consumer-owned
+    AdaptiveBatch batch;
+    uint32_t offset;                    // Next record of the head frame, 0 before its first
+} SubmitBatcher;
+
+void submit_batch_default_config(SubmitBatchConfig* config);
+
+/* NULL on allocation failure. The limits are clamped so a record always fits a frame. */
+SubmitBatcher* submit_batcher_create(size_t lane, const SubmitBatchConfig* config,
+                                     submit_batch_commit_fn commit, void* context);
+/* Frees the stages; messages still staged are dropped. */
+void submit_batcher_destroy(SubmitBatcher* batcher);
+/* New limits, any thread. max_records 0 stops staging without flushing. */
+void submit_batcher_configure(SubmitBatcher* batcher, const SubmitBatchConfig* config);
+
+SubmitBatchResult submit_batcher_submit(SubmitBatcher* batcher, const void* msg, size_t size);
+/* Commit the calling thread's stage, so a message it sends another way
+ * keeps its order. False if the lane refused it. */
+bool submit_batcher_flush_own(SubmitBatcher* batcher);
+/* Commit every stage, or only those past their deadline; returns frames committed. */
+size_t submit_batcher_flush(SubmitBatcher* batcher, bool expired_only);
+
+/* Consumer feedback when a frame is retired: bytes behind the consumer,
+ * ring capacity and how long a batched frame waited (0 for others). */
+void submit_batcher_observe(SubmitBatcher* batcher, size_t backlog, size_t capacity, uint64_t latency_ns);
+void submit_batcher_get_stats(SubmitBatcher* batcher, SubmitBatchStats* out);
+
+/* Whether `size` payload bytes are a well-formed batched frame. */
+bool submit_batch_frame_valid(const void* payload, size_t size);
+
+static inline const SubmitRecord* submit_batch_record(const void* payload, size_t offset) {
+    return (const SubmitRecord*)((const uint8_t*)payload + offset);
+}
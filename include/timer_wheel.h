@@ -0,0 +1,58 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+Timer Wheel
+
+Hierarchical hashed timing wheel for deadlines that are mostly cancelled
+before they fire (ACK timeouts, heartbeats). Level 0 has one slot per tick;
+each level above covers TIMER_WHEEL_SLOTS times the span of the one below,
+and its slot is re-hashed one level down when the level below wraps. Arming
+and cancelling are O(1) list operations on a timer embedded in the caller's
+own record; advancing costs O(1) per elapsed tick plus O(1) per timer moved
+or fired, independent of how many timers are armed.
+
+Deadlines are rounded up to whole ticks, so a timer fires at the first
+timer_wheel_advance at or past its deadline, never early. Deadlines past
+the top level's span wait there and are re-hashed until they come in range.
+Not thread-safe: a wheel and its timers belong to one owner at a time. The
+slot heads point at themselves, so a wheel must not be copied or moved once
+initialised.
+*/
+
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4                            // 2^24 ticks: 4.6 hours at 1 ms
+
+/* The record a timer is embedded in, as with offsetof. */
+#define TIMER_WHEEL_ENTRY(timer, type, member) ((type*)((char*)(timer) - offsetof(type, member)))
+
+typedef struct timer_wheel_timer {
+    struct timer_wheel_timer* next;     // NULL while not armed
+    struct timer_wheel_timer* prev;
+    uint64_t expires;                   // Tick
+} timer_wheel_timer_t;
+
+typedef void (*timer_wheel_callback_t)(timer_wheel_timer_t* timer, void* context);
+
+typedef struct {
+    timer_wheel_timer_t slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];  // List heads
+    uint64_t tick_ns;
+    uint64_t origin_ns;
+    uint64_t now;                       // Last tick processed
+    uint32_t armed;
+} timer_wheel_t;
+
+/* `tick_ns` is the resolution; `now_ns` any clock reading, usually umsbb_clock_ns. */
+void timer_wheel_init(timer_wheel_t* wheel, uint64_t tick_ns, uint64_t now_ns);
+/* Arm, or re-arm, `timer` to fire at `deadline_ns`; a deadline already past
+ * fires on the next advance. */
+void timer_wheel_arm(timer_wheel_t* wheel, timer_wheel_timer_t* timer, uint64_t deadline_ns);
+/* No-op if the timer is not armed. */
+void timer_wheel_cancel(timer_wheel_t* wheel, timer_wheel_timer_t* timer);
+static inline bool timer_wheel_armed(const timer_wheel_timer_t* timer) { return timer->next != NULL; }
+/* Fire every timer due by `now_ns`, in tick order; returns how many fired.
+ * The callback may arm or cancel any timer, including the one it is given. */
+uint32_t timer_wheel_advance(timer_wheel_t* wheel, uint64_t now_ns, timer_wheel_callback_t callback, void* context);
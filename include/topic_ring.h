@@ -0,0 +1,101 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bi_buffer.h"
+#include "checksum_engine.h"
+
+/*
+Topic Ring
+
+Multicast publish/subscribe over one BiBuffer: a publisher writes a message
+once, framed and checksummed as on a bus lane, and every subscriber walks
+the same frames in place with a cursor of its own (a disruptor-style
+multicast ring). Nothing is copied per subscriber. Space is reclaimed up to
+the slowest subscriber's cursor, so with TOPIC_SLOW_BLOCK subscribers a
+full topic refuses publishes until the slowest one catches up.
+
+A TOPIC_SLOW_DROP subscriber does not hold publishers back between
+batches: when a publish finds the topic full, the DROP subscribers at the
+slowest cursor are moved to the newest committed message and the messages
+they skip are counted in their stats. A batch that is being read is never
+overrun, so its messages stay intact until topic_ring_release.
+
+Any number of threads may publish. Each subscriber id is polled by one
+thread at a time. Publishing to a topic without subscribers is a no-op
+that succeeds, and a new subscriber sees what is published after it joins.
+Space is reclaimed under a short lock by the subscriber that was gating it
+when it releases (skipped if the lock is busy) and by a publish that finds
+the topic full.
+*/
+
+#define TOPIC_RING_MAX_SUBSCRIBERS 32
+#define TOPIC_RING_NO_SUBSCRIBER UINT32_MAX
+
+typedef enum {
+    TOPIC_SLOW_BLOCK = 0,   // Gate reclamation; publishers see a full topic
+    TOPIC_SLOW_DROP = 1     // Skipped ahead when it would stall publishers
+} TopicSlowPolicy;
+
+typedef struct {
+    const void* data;
+    size_t size;
+    uint32_t sequence;
+} TopicMessage;
+
+typedef struct {
+    size_t delivered;       // Messages handed out by topic_ring_read
+    size_t dropped;         // Messages skipped by overruns (DROP only)
+    size_t overruns;        // Times the subscriber was moved ahead
+    size_t corrupted;       // Frames skipped for a checksum mismatch
+    size_t lag;             // Ring bytes published but not yet released
+} TopicSubscriberStats;
+
+typedef struct {
+    SOMA_ALIGNED_TYPE(atomic_size_t, SOMA_ALIGNMENT) cursor;   // Frames before this are done with
+    atomic_size_t state;        // 0 free, 1 joining, 2 active
+    atomic_size_t delivered;
+    atomic_size_t dropped;
+    atomic_size_t overruns;
+    atomic_size_t corrupted;
+    TopicSlowPolicy policy;
+    // Owned by the polling thread
+    size_t held;                // Cursor the outstanding batch started at
+    size_t next;                // Cursor after it
+    size_t batch;               // Messages in it
+    size_t skipped;             // Corrupt frames in it
+} TopicSubscriber;
+
+typedef struct {
+    BiBuffer* buffer;                   // MPSC: publishers claim with a CAS
+    atomic_size_t sequence;
+    atomic_size_t subscribers;          // Active count
+    atomic_size_t reclaiming;           // Try-lock around bi_buffer_release_to
+    atomic_size_t published;
+    atomic_size_t refused;              // Publishes that found the topic full
+    TopicSubscriber slots[TOPIC_RING_MAX_SUBSCRIBERS];
+} TopicRing;
+
+/* NULL on failure; capacity is rounded like bi_buffer_init. */
+TopicRing* topic_ring_create(size_t capacity);
+/* No subscriber may be reading. */
+void topic_ring_destroy(TopicRing* topic);
+
+/* Subscriber id, or TOPIC_RING_NO_SUBSCRIBER when all slots are taken. */
+uint32_t topic_ring_subscribe(TopicRing* topic, TopicSlowPolicy policy);
+/* Leave the topic; its outstanding batch, if any, is released. */
+void topic_ring_unsubscribe(TopicRing* topic, uint32_t subscriber);
+
+/* Write `size` bytes once for every subscriber; false if the topic is full. */
+bool topic_ring_publish(TopicRing* topic, const void* data, size_t size, checksum_policy_t policy);
+
+/*
+ * Up to `max` unread messages of `subscriber`, in place and in publish
+ * order. They stay valid until topic_ring_release; reading again without
+ * releasing returns the same messages.
+ */
+size_t topic_ring_read(TopicRing* topic, uint32_t subscriber, TopicMessage* out, size_t max);
+/* Done with the last batch read; false if none is outstanding. */
+bool topic_ring_release(TopicRing* topic, uint32_t subscriber);
+
+bool topic_ring_subscriber_stats(TopicRing* topic, uint32_t subscriber, TopicSubscriberStats* out);
@@ -1,7 +1,10 @@
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "atomic_compat.h"
+#include "latency_histogram.h"
+#include "shm_segment.h"
 
 /*
 Twin Lane System - Bi-directional communication with dedicated send/receive lanes
@@ -20,11 +23,43 @@ typedef enum {
     TWIN_DIRECTION_COUNT = 2
 } twin_direction_t;
 
+/*
+Each direction is a byte ring of length-prefixed records. Positions are
+monotonic byte counts; a record never straddles the end of the buffer, a
+padding record fills the gap instead. Writers reserve space with a CAS on
+`reserve`, copy, then publish in reservation order by advancing `head`, so
+any number of threads may write. Readers take records between `tail` and
+`head`.
+
+The positions and the data of a ring live in one block: private memory for
+ordinary lanes, or a ShmSegment for lanes shared with another process
+(twin_lane_create_shared / twin_lane_attach_shared), where one side's TX
+ring is the other side's RX ring and no copy or transport sits between them.
+*/
+#define TWIN_LANE_RECORD_HEADER 8       // uint32 size, uint32 sequence
+#define TWIN_LANE_RECORD_ALIGN 8
+#define TWIN_LANE_MIN_CAPACITY 64
+#define TWIN_LANE_MAX_WINDOW 256        // Upper bound on unacknowledged TX messages
+
 typedef struct {
-    _Alignas(64) atomic_uint64_t tx_head;
-    _Alignas(64) atomic_uint64_t tx_tail;
-    _Alignas(64) atomic_uint64_t rx_head;
-    _Alignas(64) atomic_uint64_t rx_tail;
+    _Alignas(64) atomic_uint64_t head;      // Committed; readable up to here
+    _Alignas(64) atomic_uint64_t reserve;   // Handed out to writers
+    _Alignas(64) atomic_uint64_t tail;      // Consumed; writable up to tail + capacity
+    _Alignas(64) atomic_uint32_t doorbell;  // Bumped on publish while a reader waits
+    atomic_uint32_t waiters;
+    uint64_t capacity;
+} twin_ring_shared_t;                       // Ring data follows it
+
+typedef struct {
+    twin_ring_shared_t* shared;
+    char* data;
+    size_t capacity;                        // Power of two, 0 once the lane is destroyed
+    bool owned;                             // False when the block is in a ShmSegment
+} twin_ring_t;
+
+typedef struct {
+    twin_ring_t tx;
+    twin_ring_t rx;
     
     // Synchronization between TX and RX
     _Alignas(64) atomic_uint64_t sync_sequence;
@@ -34,25 +69,30 @@ typedef struct {
     uint32_t peer_node_id;
     bool symmetric_bandwidth;
     
-    // Separate ring buffers for each direction
-    void* tx_ring;
-    void* rx_ring;
-    size_t tx_capacity;
-    size_t rx_capacity;
-    
     // Performance metrics per direction
     uint64_t tx_messages;
     uint64_t rx_messages;
     uint64_t tx_bytes;
     uint64_t rx_bytes;
-    double tx_latency_us;
-    double rx_latency_us;
+    LatencyHistogram* tx_latency;      // Per send / receive call
+    LatencyHistogram* rx_latency;
+    uint64_t metrics_tx_messages;      // Totals at the previous metrics call
+    uint64_t metrics_rx_messages;
+    uint64_t metrics_tx_bytes;
+    uint64_t metrics_rx_bytes;
+    uint64_t metrics_timestamp_us;
+    uint64_t last_ack_us;
     
-    // Flow control state
-    uint32_t tx_window_size;
-    uint32_t rx_window_size;
+    // Flow control state: messages sent but not yet acknowledged count
+    // against tx_window_size
+    atomic_uint32_t tx_window_size;
     atomic_uint32_t tx_inflight;
-    atomic_uint32_t rx_inflight;
+    
+    // Cumulative acknowledgement: send n carried tx_sent_sequences[n % TWIN_LANE_MAX_WINDOW],
+    // and sends [0, tx_acked) have been acknowledged
+    _Alignas(64) atomic_uint64_t tx_sent;
+    atomic_uint64_t tx_acked;
+    uint32_t tx_sent_sequences[TWIN_LANE_MAX_WINDOW];
 } twin_lane_t;
 
 typedef struct {
@@ -74,23 +114,74 @@ typedef struct {
     double system_duplex_efficiency;
 } twin_lane_manager_t;
 
+struct duplex_metrics;
+
 // Twin Lane API
 bool twin_lane_init(twin_lane_manager_t* manager, uint32_t max_lanes);
 void twin_lane_destroy(twin_lane_manager_t* manager);
 
 // Lane management
 uint32_t twin_lane_create(twin_lane_manager_t* manager, uint32_t peer_node_id, size_t tx_capacity, size_t rx_capacity);
+// Lane whose rings live in `segment` under `name`, for a peer in another
+// process to attach to with the same name; its TX ring is the attacher's RX
+// ring and the other way round. The segment must outlive the lane on both
+// sides. Flow control and metrics stay per process.
+uint32_t twin_lane_create_shared(twin_lane_manager_t* manager, ShmSegment* segment, const char* name,
+                                 uint32_t peer_node_id, size_t tx_capacity, size_t rx_capacity);
+uint32_t twin_lane_attach_shared(twin_lane_manager_t* manager, ShmSegment* segment, const char* name,
+                                 uint32_t peer_node_id);
 bool twin_lane_destroy_lane(twin_lane_manager_t* manager, uint32_t lane_id);
 
-// Bi-directional communication
+// Bi-directional communication; both are safe from any number of threads.
+// Sends fail when the TX window is full or the TX ring has no room for the
+// message; a message can be at most capacity - TWIN_LANE_RECORD_HEADER bytes
 bool twin_lane_send(twin_lane_manager_t* manager, uint32_t lane_id, const void* data, size_t size, uint32_t sequence);
+// Result comes from the message pool; release it with message_pool_release
 void* twin_lane_receive(twin_lane_manager_t* manager, uint32_t lane_id, size_t* size, uint32_t* sequence);
 
-// Flow control
+// Transport side. twin_lane_drain_tx hands up to max_frames committed TX
+// frames to `fn` in send order, in place; the bytes are valid for the call
+// only and are released in one step once the batch is done. Returning false
+// from `fn` leaves that frame for the next drain. One drainer per lane at a
+// time. twin_lane_deliver places a frame that arrived from the peer into the
+// RX ring for twin_lane_receive.
+typedef bool (*twin_lane_frame_fn)(void* context, const void* data, size_t size, uint32_t sequence);
+size_t twin_lane_drain_tx(twin_lane_manager_t* manager, uint32_t lane_id, twin_lane_frame_fn fn, void* context, size_t max_frames);
+bool twin_lane_deliver(twin_lane_manager_t* manager, uint32_t lane_id, const void* data, size_t size, uint32_t sequence);
+
+// Batch TX access for transports that keep frames in place across a call
+// (a writev that may complete partially): start a cursor at
+// twin_lane_tx_cursor, walk committed frames with twin_lane_peek_tx (the
+// cursor moves past each), and free everything before a cursor with
+// twin_lane_release_tx. Frames stay valid until released.
+uint64_t twin_lane_tx_cursor(twin_lane_manager_t* manager, uint32_t lane_id);
+const void* twin_lane_peek_tx(twin_lane_manager_t* manager, uint32_t lane_id, uint64_t* cursor, size_t* size, uint32_t* sequence);
+void twin_lane_release_tx(twin_lane_manager_t* manager, uint32_t lane_id, uint64_t cursor);
+
+// Deliver in place: claim RX space for a frame of `size` bytes, fill the
+// returned payload (say, straight from a socket), then commit. Later RX
+// writers wait for the commit, so keep the gap short.
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    uint32_t sequence;
+} twin_lane_claim_t;
+void* twin_lane_claim_rx(twin_lane_manager_t* manager, uint32_t lane_id, size_t size, uint32_t sequence, twin_lane_claim_t* claim);
+void twin_lane_commit_rx(twin_lane_manager_t* manager, uint32_t lane_id, const twin_lane_claim_t* claim);
+
+// Block until the lane's RX ring has a record to receive (TWIN_DIRECTION_RX)
+// or its TX ring one to drain (TWIN_DIRECTION_TX), for at most timeout_ns.
+// Wakeups cross processes for shared lanes. Returns whether one is there.
+bool twin_lane_wait(twin_lane_manager_t* manager, uint32_t lane_id, twin_direction_t direction, uint64_t timeout_ns);
+
+// Flow control. An ACK is cumulative: it credits every unacknowledged send,
+// oldest first, whose sequence is at or before ack_sequence (serial-number
+// order), stopping at the first that is later. Returns the number credited.
 bool twin_lane_can_send(twin_lane_manager_t* manager, uint32_t lane_id);
-void twin_lane_update_flow_control(twin_lane_manager_t* manager, uint32_t lane_id, uint32_t ack_sequence);
+uint32_t twin_lane_update_flow_control(twin_lane_manager_t* manager, uint32_t lane_id, uint32_t ack_sequence);
 
-// Performance monitoring
+// Performance monitoring; rates cover the time since the previous call on the
+// same lane, latencies everything since the lane was created
 void twin_lane_get_duplex_metrics(twin_lane_manager_t* manager, uint32_t lane_id, struct duplex_metrics* metrics);
 
 struct duplex_metrics {
@@ -98,9 +189,11 @@ struct duplex_metrics {
     uint64_t rx_messages_per_second;
     uint64_t tx_bytes_per_second;
     uint64_t rx_bytes_per_second;
-    double tx_latency_us;
+    double tx_latency_us;           // Means of tx_latency / rx_latency
     double rx_latency_us;
     double duplex_efficiency;
     uint32_t tx_congestion_level;
     uint32_t rx_congestion_level;
+    LatencySummary tx_latency;
+    LatencySummary rx_latency;
 };
\ No newline at end of file
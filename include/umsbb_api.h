@@ -90,6 +90,72 @@ int umsbb_write_message(umsbb_handle_t handle, const void* data, uint32_t size);
  */
 int umsbb_read_message(umsbb_handle_t handle, void* buffer, uint32_t buffer_size, uint32_t* actual_size);
 
+/**
+ * Write messages packed back to back in one region
+ * @param handle Buffer handle
+ * @param data Message bytes, lengths[0] bytes of the first followed by the next
+ * @param lengths Size of each message
+ * @param count Number of messages
+ * @return Messages written, or an error code when none was
+ */
+int umsbb_write_batch(umsbb_handle_t handle, const void* data, const uint32_t* lengths, uint32_t count);
+
+/**
+ * Read messages into one region, packed back to back
+ * @param handle Buffer handle
+ * @param buffer Output region
+ * @param buffer_capacity Output region size
+ * @param lengths Receives the size of each message read
+ * @param max_messages Capacity of lengths
+ * @return Messages read, or an error code when none was
+ */
+int umsbb_read_batch(umsbb_handle_t handle, void* buffer, uint32_t buffer_capacity,
+                     uint32_t* lengths, uint32_t max_messages);
+
+/**
+ * Reserve room in the buffer to build a message in place
+ * @param handle Buffer handle
+ * @param size Most bytes the message will hold
+ * @param ticket Receives the reservation, for commit or cancel
+ * @return Where to write the payload, or NULL when the buffer is full
+ */
+void* umsbb_reserve_message(umsbb_handle_t handle, uint32_t size, uint64_t* ticket);
+
+/**
+ * Publish a reserved message
+ * @param handle Buffer handle
+ * @param ticket Reservation from umsbb_reserve_message
+ * @param size Bytes written, at most the size reserved
+ * @return Error code
+ */
+int umsbb_commit_message(umsbb_handle_t handle, uint64_t ticket, uint32_t size);
+
+/**
+ * Give up a reservation without publishing it
+ * @param handle Buffer handle
+ * @param ticket Reservation from umsbb_reserve_message
+ * @return Error code
+ */
+int umsbb_cancel_message(umsbb_handle_t handle, uint64_t ticket);
+
+/**
+ * Borrow the next message in place; its segment stays claimed until release
+ * @param handle Buffer handle
+ * @param data Receives the payload address
+ * @param size Receives the payload size
+ * @param ticket Receives the loan, for umsbb_release_message
+ * @return Error code
+ */
+int umsbb_peek_message(umsbb_handle_t handle, const void** data, uint32_t* size, uint64_t* ticket);
+
+/**
+ * Consume a borrowed message and release its segment
+ * @param handle Buffer handle
+ * @param ticket Loan from umsbb_peek_message
+ * @return Error code
+ */
+int umsbb_release_message(umsbb_handle_t handle, uint64_t ticket);
+
 /**
  * Destroy a buffer and free resources
  * @param handle Buffer handle
@@ -97,6 +163,14 @@ int umsbb_read_message(umsbb_handle_t handle, void* buffer, uint32_t buffer_size
  */
 int umsbb_destroy_buffer(umsbb_handle_t handle);
 
+/**
+ * Set the checksum policy for messages written from now on
+ * @param handle Buffer handle
+ * @param policy 0 = none, 1 = fast 64-bit hash (default), 2 = CRC32C
+ * @return Error code
+ */
+int umsbb_set_checksum_policy(umsbb_handle_t handle, uint32_t policy);
+
 // =============================================================================
 // STATISTICS FUNCTIONS
 // =============================================================================
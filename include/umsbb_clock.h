@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+
+/*
+Clock
+
+One monotonic nanosecond timeline for every module. umsbb_clock_ns reads the
+CPU's invariant counter (rdtsc on x86, cntvct_el0 on AArch64) and scales it
+with a multiply and a shift; the scale is calibrated against the OS monotonic
+clock on first use (a few milliseconds, or call umsbb_clock_init up front)
+and refined once a second of counter time has passed, without a step. Where
+no usable counter exists it falls back to the OS clock (clock_gettime,
+QueryPerformanceCounter with a cached frequency, or emscripten_get_now on
+WASM), so values are always on the OS monotonic timeline.
+
+umsbb_clock_coarse_ns is for fields that only need millisecond-ish accuracy
+(record stamps, heartbeats, cooldowns): it returns the kernel's tick-cached
+clock where one exists and may trail umsbb_clock_ns by up to a tick.
+*/
+
+#define UMSBB_CLOCK_CALIBRATION_NS 5000000ull   // Initial calibration window
+
+/* Calibrate now; safe from any thread and idempotent. */
+void umsbb_clock_init(void);
+
+uint64_t umsbb_clock_ns(void);
+uint64_t umsbb_clock_us(void);
+uint64_t umsbb_clock_coarse_ns(void);
+
+/* The OS monotonic clock the fast path is calibrated against. */
+uint64_t umsbb_clock_os_ns(void);
+/* "tsc", "cntvct", "emscripten", "qpc" or "monotonic". */
+const char* umsbb_clock_source(void);
@@ -0,0 +1,153 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+Hot-Path Tracing
+
+Trace points along a message's way through the rings and lanes (submit,
+claim, commit, signal, drain, release, plus the handshake's ACK / timeout /
+retry and the parallel engine's batches, parks and steals). They are
+compiled out entirely unless UMSBB_ENABLE_TRACING is defined: UMSBB_TRACE
+then expands to nothing and its arguments are not evaluated.
+
+With tracing compiled in, a point costs one relaxed load while tracing is
+off. Once on, each point hashes its key (a per-message value such as the
+frame offset or sequence, so every stage of a sampled message is kept or
+dropped together) and records 1 in umsbb_trace_set_sampling's `one_in`
+messages: a clock read (umsbb_clock_ns, the invariant TSC where there is
+one) and a 24-byte store into the calling thread's ring. Rings are
+UMSBB_TRACE_RING_RECORDS long, single-writer and never block; when a ring
+wraps, its oldest records are overwritten. As in the latency histogram, a
+thread that starts on the thread-local address of an exited one continues
+its ring, so thread churn does not grow memory.
+
+umsbb_trace_collect and umsbb_trace_dump_chrome may run while threads keep
+recording: each ring is read between two loads of its head and records
+overwritten meanwhile are dropped. The dump is Chrome trace event JSON,
+which chrome://tracing and https://ui.perfetto.dev open directly.
+
+UMSBB_TRACE_USDT adds a USDT probe (umsbb:trace, arguments module, event,
+lane, key) at every point, firing whether or not the message is sampled;
+UMSBB_TRACE_ETW on Windows logs each sampled record as a TraceLogging event
+of the "UMSBB" provider.
+*/
+
+#ifndef UMSBB_TRACE_RING_RECORDS
+#define UMSBB_TRACE_RING_RECORDS 16384u       // Per thread; a power of two
+#endif
+
+typedef enum {
+    UMSBB_TRACE_BI_BUFFER = 0,
+    UMSBB_TRACE_FAST_LANE,
+    UMSBB_TRACE_TWIN_TX,
+    UMSBB_TRACE_TWIN_RX,
+    UMSBB_TRACE_PARALLEL,
+    UMSBB_TRACE_HANDSHAKE,
+    UMSBB_TRACE_MODULE_COUNT
+} umsbb_trace_module_t;
+
+typedef enum {
+    UMSBB_TRACE_SUBMIT = 0,     // Handed to the module
+    UMSBB_TRACE_CLAIM,          // Space reserved
+    UMSBB_TRACE_COMMIT,         // Published to consumers
+    UMSBB_TRACE_SIGNAL,         // Consumer woken or notified
+    UMSBB_TRACE_DRAIN,          // Seen by a consumer
+    UMSBB_TRACE_RELEASE,        // Space handed back, or processing finished
+    UMSBB_TRACE_ACK,
+    UMSBB_TRACE_TIMEOUT,
+    UMSBB_TRACE_RETRY,
+    UMSBB_TRACE_FAIL,
+    UMSBB_TRACE_BATCH_BEGIN,
+    UMSBB_TRACE_BATCH_END,
+    UMSBB_TRACE_STEAL,
+    UMSBB_TRACE_PARK,
+    UMSBB_TRACE_WAKE,
+    UMSBB_TRACE_EVENT_COUNT
+} umsbb_trace_event_t;
+
+typedef struct {
+    uint64_t ns;        // umsbb_clock_ns
+    uint64_t seq;       // The point's key: frame offset, sequence or timestamp
+    uint32_t lane;
+    uint8_t module;     // umsbb_trace_module_t
+    uint8_t event;      // umsbb_trace_event_t
+    uint16_t reserved;
+} umsbb_trace_record_t;
+
+/* Sampling: 0 turns tracing off (the default), 1 records every message and
+ * N about one message in N. */
+void umsbb_trace_set_sampling(uint32_t one_in);
+uint32_t umsbb_trace_get_sampling(void);
+
+/* Record unconditionally into the calling thread's ring. */
+void umsbb_trace_record(umsbb_trace_module_t module, umsbb_trace_event_t event, uint32_t lane, uint64_t seq);
+
+/* Visit every retained record, ring by ring and oldest first within a ring.
+ * `thread` numbers the rings in the order threads first recorded. Returns
+ * how many records were visited. */
+typedef void (*umsbb_trace_visit_fn)(uint32_t thread, const umsbb_trace_record_t* record, void* context);
+size_t umsbb_trace_collect(umsbb_trace_visit_fn visit, void* context);
+
+/* Write the retained records to `path` as Chrome trace JSON. */
+bool umsbb_trace_dump_chrome(const char* path);
+
+/* Drop everything recorded so far; rings stay allocated. */
+void umsbb_trace_reset(void);
+
+const char* umsbb_trace_module_name(umsbb_trace_module_t module);
+const char* umsbb_trace_event_name(umsbb_trace_event_t event);
+
+#if defined(_MSC_VER) && !defined(__clang__)
+typedef volatile uint64_t umsbb_trace_threshold_t;
+#  define UMSBB_TRACE_LOAD_THRESHOLD() (umsbb_trace_threshold)
+#else
+#  include <stdatomic.h>
+typedef _Atomic uint64_t umsbb_trace_threshold_t;
+#  define UMSBB_TRACE_LOAD_THRESHOLD() atomic_load_explicit(&umsbb_trace_threshold, memory_order_relaxed)
+#endif
+
+/* A key is sampled when the top half of its Fibonacci hash is below this:
+ * 0 is off and 2^32 samples everything. */
+extern umsbb_trace_threshold_t umsbb_trace_threshold;
+
+#ifdef UMSBB_ENABLE_TRACING
+
+static inline bool umsbb_trace_sampled(uint64_t key) {
+    uint64_t threshold = UMSBB_TRACE_LOAD_THRESHOLD();
+    return threshold != 0 && ((key * 0x9E3779B97F4A7C15ull) >> 32) < threshold;
+}
+
+#if defined(UMSBB_TRACE_USDT) && defined(__has_include)
+#  if __has_include(<sys/sdt.h>)
+#    include <sys/sdt.h>
+#    define UMSBB_TRACE_PROBE(module, event, lane, key) DTRACE_PROBE4(umsbb, trace, module, event, lane, key)
+#  endif
+#endif
+#ifndef UMSBB_TRACE_PROBE
+#  define UMSBB_TRACE_PROBE(module, event, lane, key) ((void)0)
+#endif
+
+/* A per-message point, recorded when `key` is sampled. */
+#define UMSBB_TRACE(module, event, lane, key) do {                              \
+        uint64_t umsbb_trace_key_ = (uint64_t)(key);                            \
+        UMSBB_TRACE_PROBE((int)(module), (int)(event), (uint32_t)(lane), umsbb_trace_key_); \
+        if (umsbb_trace_sampled(umsbb_trace_key_)) {                            \
+            umsbb_trace_record((module), (event), (uint32_t)(lane), umsbb_trace_key_); \
+        }                                                                       \
+    } while (0)
+
+/* A rare point (timeouts, parks), recorded whenever tracing is on. */
+#define UMSBB_TRACE_ALWAYS(module, event, lane, key) do {                       \
+        uint64_t umsbb_trace_key_ = (uint64_t)(key);                            \
+        UMSBB_TRACE_PROBE((int)(module), (int)(event), (uint32_t)(lane), umsbb_trace_key_); \
+        if (UMSBB_TRACE_LOAD_THRESHOLD() != 0) {                                \
+            umsbb_trace_record((module), (event), (uint32_t)(lane), umsbb_trace_key_); \
+        }                                                                       \
+    } while (0)
+
+#else
+#  define UMSBB_TRACE(module, event, lane, key) ((void)0)
+#  define UMSBB_TRACE_ALWAYS(module, event, lane, key) ((void)0)
+#endif
@@ -1,20 +1,27 @@
 #pragma once
 #include "bi_buffer.h"
-#include "arena_allocator.h"
+#include "message_pool.h"
 #include "capsule.h"
 #include "feedback_stream.h"
 #include "adaptive_batch.h"
 #include "segment_ring.h"
 #include "gpu_delegate.h"
+#include "offload_planner.h"
+#include "gpu_accelerated_buffer.h"
 #include "flow_control.h"
+#include "high_water_mark.h"
 #include "event_scheduler.h"
 #include "fast_lane.h"
+#include "lane_router.h"
 #include "twin_lane.h"
 #include "feedback_handshake.h"
 #include "fault_tolerance.h"
 #include "language_bindings.h"
 #include "parallel_throughput_engine.h"
+#include "topic_ring.h"
+#include "submit_batcher.h"
 #include "atomic_compat.h"
+#include "checksum_engine.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -46,14 +53,90 @@ Architecture:
 #define UMSBB_API_LEVEL 3  // 0=minimal, 1=basic, 2=standard, 3=full
 #endif
 
+/*
+Feature selection. Each subsystem is compiled in only when its flag is 1:
+without it the bus struct has no field for it and the submit and drain
+paths skip it, so API level 0 is the bare ring lanes (claim, copy,
+checksum, commit, notify) and level 1 adds telemetry, credit and the GPU
+offload. The defaults follow UMSBB_API_LEVEL; any flag may be set on its
+own. The struct layout depends on these flags, so the library and its
+users must be built with the same ones (umsbb_features_match checks).
+*/
+#ifndef UMSBB_ENABLE_FEEDBACK           // Per-lane FeedbackStream telemetry
+#define UMSBB_ENABLE_FEEDBACK (UMSBB_API_LEVEL >= 1)
+#endif
+
+#ifndef UMSBB_ENABLE_FLOW_CONTROL       // Per-lane high-water mark credit
+#define UMSBB_ENABLE_FLOW_CONTROL (UMSBB_API_LEVEL >= 1)
+#endif
+
+#ifndef UMSBB_ENABLE_GPU                // Offload planner for copies
+#define UMSBB_ENABLE_GPU (UMSBB_API_LEVEL >= 1)
+#endif
+
+#ifndef UMSBB_ENABLE_BATCHING           // Producer-side submit batching per lane
+#define UMSBB_ENABLE_BATCHING (UMSBB_API_LEVEL >= 1)
+#endif
+
+#ifndef UMSBB_ENABLE_FAST_LANES
+#define UMSBB_ENABLE_FAST_LANES (UMSBB_API_LEVEL >= 2)
+#endif
+
+#ifndef UMSBB_ENABLE_TWIN_LANES
+#define UMSBB_ENABLE_TWIN_LANES (UMSBB_API_LEVEL >= 2)
+#endif
+
+#ifndef UMSBB_ENABLE_PARALLEL
+#define UMSBB_ENABLE_PARALLEL (UMSBB_API_LEVEL >= 2)
+#endif
+
+#ifndef UMSBB_ENABLE_RELIABILITY        // Feedback handshake and fault tolerance
+#define UMSBB_ENABLE_RELIABILITY (UMSBB_API_LEVEL >= 3 && UMSBB_ENABLE_TWIN_LANES)
+#endif
+
 #ifndef UMSBB_ENABLE_WASM
-#define UMSBB_ENABLE_WASM 1
+#define UMSBB_ENABLE_WASM (UMSBB_API_LEVEL >= 2)
 #endif
 
 #ifndef UMSBB_ENABLE_MULTILANG
-#define UMSBB_ENABLE_MULTILANG 1
+#define UMSBB_ENABLE_MULTILANG (UMSBB_API_LEVEL >= 2)
+#endif
+
+#ifndef UMSBB_ENABLE_TOPICS             // Multicast publish/subscribe
+#define UMSBB_ENABLE_TOPICS (UMSBB_API_LEVEL >= 2)
+#endif
+#ifndef UMSBB_MAX_TOPICS
+#define UMSBB_MAX_TOPICS 64
 #endif
 
+#define UMSBB_FEATURE_FEEDBACK      0x001u
+#define UMSBB_FEATURE_FLOW_CONTROL  0x002u
+#define UMSBB_FEATURE_GPU           0x004u
+// 0x008u was the bus arena; left unused so a build that still has it
+// does not match one without
+#define UMSBB_FEATURE_FAST_LANES    0x010u
+#define UMSBB_FEATURE_TWIN_LANES    0x020u
+#define UMSBB_FEATURE_PARALLEL      0x040u
+#define UMSBB_FEATURE_RELIABILITY   0x080u
+#define UMSBB_FEATURE_WASM          0x100u
+#define UMSBB_FEATURE_MULTILANG     0x200u
+#define UMSBB_FEATURE_TOPICS        0x400u
+#define UMSBB_FEATURE_BATCHING      0x800u
+
+// The features this translation unit was compiled with
+#define UMSBB_FEATURES                                              \
+    ((UMSBB_ENABLE_FEEDBACK ? UMSBB_FEATURE_FEEDBACK : 0u) |         \
+     (UMSBB_ENABLE_FLOW_CONTROL ? UMSBB_FEATURE_FLOW_CONTROL : 0u) | \
+     (UMSBB_ENABLE_GPU ? UMSBB_FEATURE_GPU : 0u) |                   \
+     (UMSBB_ENABLE_FAST_LANES ? UMSBB_FEATURE_FAST_LANES : 0u) |     \
+     (UMSBB_ENABLE_TWIN_LANES ? UMSBB_FEATURE_TWIN_LANES : 0u) |     \
+     (UMSBB_ENABLE_PARALLEL ? UMSBB_FEATURE_PARALLEL : 0u) |         \
+     (UMSBB_ENABLE_RELIABILITY ? UMSBB_FEATURE_RELIABILITY : 0u) |   \
+     (UMSBB_ENABLE_WASM ? UMSBB_FEATURE_WASM : 0u) |                 \
+     (UMSBB_ENABLE_MULTILANG ? UMSBB_FEATURE_MULTILANG : 0u) |       \
+     (UMSBB_ENABLE_TOPICS ? UMSBB_FEATURE_TOPICS : 0u) |             \
+     (UMSBB_ENABLE_BATCHING ? UMSBB_FEATURE_BATCHING : 0u))
+
 // WebAssembly language binding types
 typedef enum {
     WASM_LANG_JAVASCRIPT = 0,
@@ -91,25 +174,68 @@ typedef struct {
     char language_hint[16];  // Optional language-specific metadata
 } multilang_message_t;
 
+#if UMSBB_ENABLE_FAST_LANES && UMSBB_ENABLE_GPU
+// Coalesced results a full fast lane refused, oldest first, until a drain
+// makes room for them
+typedef struct {
+    struct umsbb_spilled_result* head;
+    struct umsbb_spilled_result* tail;
+    atomic_size_t count;        // Read without the lock to skip an empty spill
+    atomic_u32 lock;
+} umsbb_gpu_spill;
+
+// A ring lane message umsbb_drain_to_gpu moved, after the kernels, with the
+// ring lane and sequence it was committed under. `data` is only valid for
+// the call; see gpu_result_fn for the thread it runs on.
+typedef void (*umsbb_gpu_result_fn)(void* context, size_t lane, uint32_t sequence, const void* data, size_t size);
+#endif
+
 typedef struct {
     SegmentRing ring;
-    ArenaAllocator arena;
+    EventScheduler scheduler;
+#if UMSBB_ENABLE_FEEDBACK
     FeedbackStream feedback;
-    AdaptiveBatch batch;
+#endif
+#if UMSBB_ENABLE_FLOW_CONTROL
     FlowControl flow;
-    EventScheduler scheduler;
+    HighWaterMark** credit;     // Per-lane producer credit, SEGMENT_RING_MAX_LANES slots
+#endif
+#if UMSBB_ENABLE_BATCHING
+    atomic_size_t* batchers;    // SubmitBatcher* per lane, SEGMENT_RING_MAX_LANES slots, see umsbb_configure_batching
+#endif
+#if UMSBB_ENABLE_GPU
+    bool gpu_enabled;
+    OffloadPlanner offload;            // CPU or GPU for each copy while gpu_enabled
+#endif
     
     // V3.0 Enhanced Systems
+#if UMSBB_ENABLE_FAST_LANES
     fast_lane_manager_t fast_lanes;
+#  if UMSBB_ENABLE_GPU
+    gpu_accelerated_buffer_t* gpu_coalescer;   // BULK/STREAMING submits, see umsbb_enable_gpu_coalescing
+    umsbb_gpu_spill gpu_spill[LANE_COUNT];     // Used for BULK and STREAMING only
+    umsbb_gpu_result_fn gpu_result;            // Ring lane results, see umsbb_set_gpu_result_handler
+    void* gpu_result_context;
+#  endif
+#endif
+#if UMSBB_ENABLE_TWIN_LANES
     twin_lane_manager_t twin_lanes;
+#endif
+#if UMSBB_ENABLE_TOPICS
+    atomic_size_t topics[UMSBB_MAX_TOPICS];     // TopicRing*, created on first subscribe
+#endif
+#if UMSBB_ENABLE_RELIABILITY
     handshake_manager_t handshake;
     fault_tolerance_manager_t fault_tolerance;
+#endif
     
+#if UMSBB_ENABLE_PARALLEL
     // V3.1 Parallel Processing Engine
     parallel_engine_t parallel_engine;
     bool parallel_processing_enabled;
     uint32_t worker_thread_count;
     throughput_strategy_t current_strategy;
+#endif
     
 #if UMSBB_ENABLE_MULTILANG
     // Multi-language support
@@ -117,10 +243,13 @@ typedef struct {
     uint32_t active_languages;
     uint64_t language_performance_stats[WASM_LANG_COUNT];
     
-    // Priority lane routing tables
-    lane_type_t lang_to_lane_map[WASM_LANG_COUNT][WASM_LANG_COUNT];
-    uint32_t lane_priority_weights[LANE_COUNT];
-    double lane_performance_history[LANE_COUNT];
+    // Priority lane routing tables, see umsbb_select_priority_lane
+    atomic_uchar lang_to_lane_map[WASM_LANG_COUNT][WASM_LANG_COUNT];  // Pinned lane_type_t, LANE_COUNT = learned
+    uint32_t lane_priority_weights[LANE_COUNT];     // Percent of each lane's cost; 0 keeps it out of learned routes
+    double lane_performance_history[LANE_COUNT];    // Smoothed cost in us as of the last optimization
+#  if UMSBB_ENABLE_FAST_LANES
+    lane_router_t router;
+#  endif
 #endif
 
 #if UMSBB_ENABLE_WASM
@@ -131,11 +260,10 @@ typedef struct {
     void* wasm_memory_base;
 #endif
     
-    size_t sequence;
+    atomic_size_t sequence;
+    checksum_policy_t checksum_policy; // Applied to frames committed from now on
     uint32_t segment_count;
-    bool gpu_enabled;
-    double load_factor;
-    uint64_t total_operations;
+    atomic_size_t total_operations;    // Messages through the bus, behind umsbb_get_load_factor
     
     // Performance metrics
     uint64_t messages_per_second;
@@ -149,17 +277,99 @@ typedef struct {
     bool optional_features_enabled;
 } UniversalMultiSegmentedBiBufferBus;
 
+// Zero-copy producer reservation: data points straight into the lane's ring
+typedef struct {
+    void* data;
+    size_t size;
+    size_t lane;
+    uint32_t sequence;
+} umsbb_reservation;
+
+// In-place view of a committed message, valid until it is released
+typedef struct {
+    const void* data;
+    size_t size;
+    uint32_t sequence;
+} umsbb_msg_view;
+
+struct system_metrics;
+
 // ============================================================================
 // CORE API FUNCTIONS (API Level 0+) - Always Available
 // ============================================================================
 
 UniversalMultiSegmentedBiBufferBus* umsbb_init(size_t bufCap, uint32_t segmentCount);
+// umsbb_init with per-bus fast lane geometry (NULL = fast_lane_default_config)
+UniversalMultiSegmentedBiBufferBus* umsbb_init_with_lanes(size_t bufCap, uint32_t segmentCount,
+                                                          const fast_lane_config_t lanes[LANE_COUNT]);
 void umsbb_free(UniversalMultiSegmentedBiBufferBus* bus);
 
+// UMSBB_FEATURES of the library build; a caller built with other flags
+// would see a different struct layout
+uint32_t umsbb_feature_mask(void);
+static inline bool umsbb_features_match(void) {
+    return umsbb_feature_mask() == UMSBB_FEATURES;
+}
+
 // Basic message operations
 bool umsbb_submit_to(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, const char* msg, size_t size);
 void* umsbb_drain_from(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, size_t* size);
 
+// Return a buffer from umsbb_drain_from, the fast/twin lane drains or a
+// universal_data_t payload to the message pool (any thread, NULL is ignored)
+void umsbb_message_release(void* msg);
+
+// Zero-copy message operations: write once into the ring, read in place
+umsbb_reservation umsbb_reserve(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, size_t size);
+bool umsbb_commit(UniversalMultiSegmentedBiBufferBus* bus, umsbb_reservation* handle);
+// Commit only the first `length` bytes (at most the reserved size), or give
+// the reservation up; readers pass over the unused space either way
+bool umsbb_commit_length(UniversalMultiSegmentedBiBufferBus* bus, umsbb_reservation* handle, size_t length);
+bool umsbb_cancel(UniversalMultiSegmentedBiBufferBus* bus, umsbb_reservation* handle);
+bool umsbb_drain_view(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, umsbb_msg_view* view);
+void umsbb_release_view(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex);
+
+// Batched zero-copy drain: up to `max` in-place views from one lane, retired
+// together by umsbb_release_batch with a single index store
+size_t umsbb_drain_batch(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex,
+                         umsbb_msg_view* out, size_t max);
+void umsbb_release_batch(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex,
+                         const umsbb_msg_view* views, size_t count);
+
+// Block until a message is committed or `timeoutNs` passes (EVENT_WAIT_FOREVER
+// waits indefinitely, 0 polls); true if data may be ready. With several
+// consumers another one may take the message first.
+bool umsbb_wait(UniversalMultiSegmentedBiBufferBus* bus, uint64_t timeoutNs);
+// Readable while the bus has undrained messages, for epoll/poll loops;
+// -1 where eventfd is unavailable
+int umsbb_event_fd(UniversalMultiSegmentedBiBufferBus* bus);
+
+// Backpressure: each lane admits producers against a byte credit (80% of its
+// capacity by default). Exhausted credit throttles the lane until the consumer
+// has drained it to the low mark (50%); umsbb_submit_to then fails fast while
+// umsbb_submit_wait parks for up to `timeoutNs` instead of retrying. Without
+// UMSBB_ENABLE_FLOW_CONTROL only a full ring refuses a message, and
+// umsbb_submit_wait retries the claim, yielding, until the timeout.
+bool umsbb_submit_wait(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, const char* msg, size_t size,
+                       uint64_t timeoutNs);
+#if UMSBB_ENABLE_FLOW_CONTROL
+bool umsbb_get_backpressure_stats(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, HighWaterMarkStats* out);
+#endif
+
+// Select the producer model of a lane. Lanes start BI_BUFFER_MODE_MPSC;
+// BI_BUFFER_MODE_SPSC is only for a lane with one producer thread (e.g.
+// SEGMENT_ROUTING_AFFINITY with no more producers than lanes). Fails
+// unless the lane is empty
+bool umsbb_configure_lane_mode(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, BiBufferMode mode);
+
+// How umsbb_submit picks a lane; SEGMENT_ROUTING_AFFINITY pins each producer
+// thread to one lane so its messages stay in order
+bool umsbb_configure_segment_routing(UniversalMultiSegmentedBiBufferBus* bus, SegmentRouting routing);
+
+// Choose how committed frames are checksummed (default CHECKSUM_POLICY_FAST).
+// Each frame records its own policy, so this is safe with traffic in flight
+bool umsbb_configure_checksum(UniversalMultiSegmentedBiBufferBus* bus, checksum_policy_t policy);
+
 #if UMSBB_API_LEVEL >= 1
 // ============================================================================
 // BASIC API FUNCTIONS (API Level 1+) - Standard Operations
@@ -167,11 +377,41 @@ void* umsbb_drain_from(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex
 
 void umsbb_submit(UniversalMultiSegmentedBiBufferBus* bus, const char* msg, size_t size);
 void umsbb_drain(UniversalMultiSegmentedBiBufferBus* bus);
-FeedbackEntry* umsbb_get_feedback(UniversalMultiSegmentedBiBufferBus* bus, size_t* count);
+double umsbb_get_load_factor(UniversalMultiSegmentedBiBufferBus* bus);
+#endif
+
+#if UMSBB_ENABLE_FEEDBACK
+// Per-lane feedback telemetry, read incrementally through a cursor
+void umsbb_feedback_cursor(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, FeedbackCursor* cursor);
+size_t umsbb_read_feedback(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, FeedbackCursor* cursor,
+                           FeedbackEntry* out, size_t max);
+// Keep every Nth routine event (1 = all, 0 = exceptional events only)
+void umsbb_configure_feedback_sampling(UniversalMultiSegmentedBiBufferBus* bus, uint32_t sampleEvery);
+#endif
 
+#if UMSBB_ENABLE_BATCHING
+// Producer-side batching for a ring lane (config NULL: submit_batch_default_config,
+// max_records 0 turns it off again and commits what is staged). Small
+// umsbb_submit_to calls are staged per thread and reach the lane as one
+// frame of up to max_records messages, or after max_delay_ns; the batch
+// size follows the consumer's lag, so a consumer that keeps up sees no
+// batching. Every drain path unpacks the frames, message by message, with
+// sequences in submit order. The deadline holds while the consumer polls the
+// lane or waits in umsbb_wait. umsbb_reserve and umsbb_submit_wait commit the
+// caller's staged messages first.
+bool umsbb_configure_batching(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex,
+                              const SubmitBatchConfig* config);
+// Commit every staged message of the lane now; returns the frames committed
+size_t umsbb_flush_batches(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex);
+bool umsbb_get_batching_stats(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, SubmitBatchStats* out);
+#endif
+
+#if UMSBB_ENABLE_GPU
 // Basic configuration
 bool umsbb_configure_gpu(UniversalMultiSegmentedBiBufferBus* bus, bool enable);
-double umsbb_get_load_factor(UniversalMultiSegmentedBiBufferBus* bus);
+// Cost models and crossover size the offload planner uses for `op`; enabling
+// the GPU recalibrates them
+bool umsbb_get_offload_stats(UniversalMultiSegmentedBiBufferBus* bus, OffloadOp op, OffloadStats* out);
 #endif
 
 #if UMSBB_API_LEVEL >= 2
@@ -181,14 +421,55 @@ double umsbb_get_load_factor(UniversalMultiSegmentedBiBufferBus* bus);
 
 // Auto-scaling and optimization
 uint32_t umsbb_get_optimal_segments(UniversalMultiSegmentedBiBufferBus* bus);
+// Adds or retires lanes online (up to SEGMENT_RING_MAX_LANES); queued messages are never dropped
 bool umsbb_scale_segments(UniversalMultiSegmentedBiBufferBus* bus, uint32_t newCount);
+// Lossless live resize of one lane's ring, see bi_buffer_resize
+bool umsbb_resize_lane(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, size_t newCap);
+#endif
 
+#if UMSBB_ENABLE_FAST_LANES
 // V3.0 Fast Lane API
 bool umsbb_fast_lane_submit(UniversalMultiSegmentedBiBufferBus* bus, lane_type_t lane, 
                            const void* data, size_t size, uint32_t priority);
 void* umsbb_fast_lane_drain(UniversalMultiSegmentedBiBufferBus* bus, lane_type_t lane, 
                            size_t* size, uint32_t* priority);
 
+#  if UMSBB_ENABLE_GPU
+// Pack BULK and STREAMING fast lane submits into GPU batches (config NULL:
+// gpu_pipeline_default_config; its callbacks are replaced by the bus's).
+// A batch goes once it is full or flush_timeout_us after its first message;
+// config->kernels and then config->transform are applied to every message,
+// on the GPU where there is one, and each result is then submitted to its
+// lane with its priority. Messages a kernel drops are not. A result that
+// finds its lane full waits in a spill, which the lane's drains and
+// umsbb_poll_gpu_coalescing move in ahead of newer results, so none is
+// lost. Order is kept within a batch only. Messages larger than a stage are
+// refused. Not while fast lane submits are in flight.
+bool umsbb_enable_gpu_coalescing(UniversalMultiSegmentedBiBufferBus* bus, const gpu_pipeline_config_t* config);
+// Move spilled results into lanes with room, then flush batches past their
+// timeout and deliver the finished ones, as a drain of an empty coalesced
+// lane does; returns the batches delivered
+uint32_t umsbb_poll_gpu_coalescing(UniversalMultiSegmentedBiBufferBus* bus);
+// Move up to `max` messages of a ring lane into the coalescer without
+// checking them on this core: the kernel verifies each against its
+// producer's checksum, and the intact ones go to the result handler, or
+// without one reach fast lane LANE_BULK with priority 0 and no label, not
+// their ring lane, whose next move would send them back to the GPU. A
+// corrupt one is reported as FEEDBACK_CORRUPTED on
+// the ring lane, as umsbb_drain_from would. A message larger than a stage
+// stops the move and is left for umsbb_drain_from. One consumer per lane,
+// as for umsbb_drain_batch; returns the messages moved.
+size_t umsbb_drain_to_gpu(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, size_t max);
+// Hand the messages umsbb_drain_to_gpu moves to `handler` with their ring
+// lane and sequence instead of putting them on LANE_BULK (NULL: LANE_BULK
+// again). Only while coalescing is disabled; false otherwise.
+bool umsbb_set_gpu_result_handler(UniversalMultiSegmentedBiBufferBus* bus, umsbb_gpu_result_fn handler, void* context);
+// Deliver everything still being coalesced, then submit directly again
+void umsbb_disable_gpu_coalescing(UniversalMultiSegmentedBiBufferBus* bus);
+#  endif
+#endif
+
+#if UMSBB_ENABLE_TWIN_LANES
 // V3.0 Twin Lane API  
 uint32_t umsbb_twin_lane_create(UniversalMultiSegmentedBiBufferBus* bus, uint32_t peer_node_id, 
                                size_t tx_capacity, size_t rx_capacity);
@@ -198,25 +479,66 @@ void* umsbb_twin_lane_receive(UniversalMultiSegmentedBiBufferBus* bus, uint32_t
                              size_t* size, uint32_t* sequence);
 #endif
 
-#if UMSBB_API_LEVEL >= 3
+#if UMSBB_ENABLE_TOPICS
+// Topics: publish once, read by every subscriber in place (see topic_ring.h).
+// Topic ids are 0..UMSBB_MAX_TOPICS-1. A topic is created with `capacity`
+// ring bytes (0 = the lane capacity), or by its first subscriber with the
+// lane capacity; publishing to a topic nobody subscribed to succeeds and
+// does nothing. Frames carry the bus checksum policy and each subscriber
+// verifies them as it reads.
+bool umsbb_topic_create(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, size_t capacity);
+uint32_t umsbb_subscribe(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, TopicSlowPolicy policy);
+void umsbb_unsubscribe(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, uint32_t subscriber);
+bool umsbb_publish(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, const void* data, size_t size);
+size_t umsbb_topic_read(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, uint32_t subscriber,
+                        TopicMessage* out, size_t max);
+bool umsbb_topic_release(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, uint32_t subscriber);
+bool umsbb_topic_stats(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, uint32_t subscriber,
+                       TopicSubscriberStats* out);
+#endif
+
+#if UMSBB_ENABLE_RELIABILITY
 // ============================================================================
-// FULL API FUNCTIONS (API Level 3+) - Complete Feature Set
+// RELIABILITY API (API Level 3+) - Handshake and Fault Tolerance
 // ============================================================================
 
 // V3.0 Reliable Delivery API
+/* Send on twin lane `consumer_id` and track it until ACKed; the bus keeps a
+ * copy (within HANDSHAKE_RETAIN_BUDGET) and resends it from
+ * umsbb_process_acknowledgments after a NACK or timeout. 0 if refused. */
 uint64_t umsbb_send_reliable(UniversalMultiSegmentedBiBufferBus* bus, uint32_t producer_id, 
                             uint32_t consumer_id, const void* data, size_t size);
 bool umsbb_send_feedback(UniversalMultiSegmentedBiBufferBus* bus, const feedback_message_t* feedback);
+/* Several ACK/SACK/NACK messages in one pass; returns how many matched. */
+uint32_t umsbb_send_feedback_batch(UniversalMultiSegmentedBiBufferBus* bus, const feedback_message_t* feedback,
+                                   uint32_t count);
 bool umsbb_process_acknowledgments(UniversalMultiSegmentedBiBufferBus* bus);
+/* Log reliable sends to a write-ahead log in `directory` before they go out
+ * (config may be NULL); fault_tolerance_replay_messages then resends logged
+ * messages on their original lanes. */
+bool umsbb_enable_persistence(UniversalMultiSegmentedBiBufferBus* bus, const char* directory,
+                              const message_log_config_t* config);
+void umsbb_set_lane_durability(UniversalMultiSegmentedBiBufferBus* bus, uint32_t lane,
+                               message_log_durability_t durability);
 
 // V3.0 Fault Tolerance API
 bool umsbb_is_component_healthy(UniversalMultiSegmentedBiBufferBus* bus, uint32_t component_id);
 uint64_t umsbb_report_fault(UniversalMultiSegmentedBiBufferBus* bus, fault_type_t type, 
                            uint32_t component_id, const char* description);
 double umsbb_get_system_health(UniversalMultiSegmentedBiBufferBus* bus);
+#endif
+
+#if UMSBB_API_LEVEL >= 3
+// ============================================================================
+// FULL API FUNCTIONS (API Level 3+) - Complete Feature Set
+// ============================================================================
 
 // Performance monitoring
 void umsbb_get_performance_metrics(UniversalMultiSegmentedBiBufferBus* bus, struct system_metrics* metrics);
+// Export the bus, its segments, fast lanes, handshake and fault counters into
+// `registry` under `labels` (may be NULL). Call again after adding segments;
+// before umsbb_free, metrics_registry_remove(registry, bus, sizeof(*bus)).
+bool umsbb_register_metrics(UniversalMultiSegmentedBiBufferBus* bus, MetricsRegistry* registry, const char* labels);
 #endif
 
 #if UMSBB_ENABLE_MULTILANG
@@ -229,9 +551,15 @@ bool umsbb_init_multilang(UniversalMultiSegmentedBiBufferBus* bus);
 bool umsbb_register_language(UniversalMultiSegmentedBiBufferBus* bus, wasm_language_t lang, 
                             const language_runtime_t* runtime);
 
-// Priority-based lane selection
+// Priority-based lane selection. A language pair pinned with
+// umsbb_configure_lane_routing goes to its lane while the message fits;
+// otherwise priority LANE_ROUTER_PRIORITY and up takes LANE_PRIORITY, and
+// everything else the route lane_router.h learned for its size class. A
+// message that is not latency_critical but has a timeout_ms shorter than
+// its route's cost takes the latency-critical route. A table lookup; any thread.
 lane_type_t umsbb_select_priority_lane(UniversalMultiSegmentedBiBufferBus* bus, 
                                       const lane_selection_criteria_t* criteria);
+// preferred_lane LANE_COUNT unpins the pair; false for a disabled lane
 bool umsbb_configure_lane_routing(UniversalMultiSegmentedBiBufferBus* bus, 
                                  wasm_language_t source, wasm_language_t target, 
                                  lane_type_t preferred_lane);
@@ -244,6 +572,10 @@ multilang_message_t* umsbb_drain_multilang(UniversalMultiSegmentedBiBufferBus* b
 
 // Language performance optimization
 double umsbb_get_language_performance(UniversalMultiSegmentedBiBufferBus* bus, wasm_language_t lang);
+// Re-learn the routes from the fast lanes' depth, p99 and congestion since the
+// previous call (lane_router_update with lane_priority_weights) and refresh
+// lane_performance_history. Every few milliseconds from one housekeeping
+// thread; false without fast lanes.
 bool umsbb_optimize_language_routing(UniversalMultiSegmentedBiBufferBus* bus);
 
 // Direct FFI bindings (zero-copy, no marshalling)
@@ -346,10 +678,14 @@ struct system_metrics {
 #endif
 };
 
+#if UMSBB_ENABLE_PARALLEL
 // V3.1 Parallel Processing API functions
 bool umsbb_enable_parallel_processing(UniversalMultiSegmentedBiBufferBus* bus, uint32_t worker_count, 
                                      throughput_strategy_t strategy);
 void umsbb_disable_parallel_processing(UniversalMultiSegmentedBiBufferBus* bus);
+/* Consumer for a parallel lane (see parallel_handler_fn); after enabling. */
+bool umsbb_register_parallel_handler(UniversalMultiSegmentedBiBufferBus* bus, uint32_t lane_id,
+                                     parallel_handler_fn fn, void* ctx);
 bool umsbb_submit_parallel(UniversalMultiSegmentedBiBufferBus* bus, uint32_t lane_id,
                           const void* data, uint32_t size, uint32_t priority, uint32_t language_id);
 bool umsbb_submit_batch_parallel(UniversalMultiSegmentedBiBufferBus* bus, 
@@ -357,8 +693,11 @@ bool umsbb_submit_batch_parallel(UniversalMultiSegmentedBiBufferBus* bus,
 performance_profile_t umsbb_get_parallel_performance(UniversalMultiSegmentedBiBufferBus* bus);
 double umsbb_get_peak_throughput_mbps(UniversalMultiSegmentedBiBufferBus* bus);
 uint32_t umsbb_get_active_workers(UniversalMultiSegmentedBiBufferBus* bus);
+/* Let the worker count follow load (see parallel_autoscale_t); after enabling. */
+bool umsbb_enable_auto_scaling(UniversalMultiSegmentedBiBufferBus* bus, const parallel_autoscale_t* policy);
 bool umsbb_tune_parallel_performance(UniversalMultiSegmentedBiBufferBus* bus, 
                                     uint32_t new_worker_count, uint32_t new_batch_size);
+#endif
 
 // ============================================================================
 // WEBASSEMBLY EXPORTED FUNCTIONS (for Emscripten builds)
@@ -437,6 +776,10 @@ Module._umsbb_wasm_free(bus);
 #warning "Multi-language features require API_LEVEL >= 2 for optimal performance"
 #endif
 
+#if UMSBB_ENABLE_RELIABILITY && !UMSBB_ENABLE_TWIN_LANES
+#error "UMSBB_ENABLE_RELIABILITY sends and resends on twin lanes: it needs UMSBB_ENABLE_TWIN_LANES"
+#endif
+
 #if UMSBB_ENABLE_WASM && !defined(__EMSCRIPTEN__)
 #warning "WASM features enabled but not building with Emscripten"
 #endif
\ No newline at end of file
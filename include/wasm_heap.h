@@ -0,0 +1,69 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "portable_atomic.h"
+
+/*
+WASM Heap
+
+A TLSF allocator (two-level segregated free lists) for the wasm core's
+buffers and rings. Blocks are found through two bitmaps in constant time,
+freed blocks merge with free neighbours at once, and every free returns its
+memory for reuse, so create/destroy cycles run in a fixed footprint.
+
+When no free block fits, the heap takes another region from the system:
+sbrk under Emscripten, which grows linear memory with memory.grow and keeps
+the C library's own heap out of the way, and malloc elsewhere. Regions that
+land back to back merge into one, so a long-lived heap does not fragment at
+region boundaries. Linear memory cannot shrink; freed regions stay with the
+heap for reuse.
+
+Nothing is zeroed: callers that need zeroed memory clear it themselves.
+A zero-initialised WasmHeap is ready to use. Calls are serialised by a lock
+word that sleeps with emscripten_futex_wait in -pthread builds.
+*/
+
+#define WASM_HEAP_ALIGN (2 * sizeof(void*))     // Alignment of every allocation
+#define WASM_HEAP_DEFAULT_GROW (1024 * 1024)    // Smallest region taken from the system
+#define WASM_HEAP_SL_LOG2 4                     // 16 second-level lists per power of two
+#define WASM_HEAP_SL_COUNT (1 << WASM_HEAP_SL_LOG2)
+#define WASM_HEAP_FL_COUNT 26                   // Free blocks up to 4 GB
+
+typedef struct WasmHeapBlock WasmHeapBlock;
+typedef struct WasmHeapRegion WasmHeapRegion;
+
+typedef struct {
+    atomic_u32 lock;                // 0 free, 1 held, 2 held with waiters
+    size_t growStep;                // 0 = WASM_HEAP_DEFAULT_GROW
+    uint32_t flBitmap;
+    uint32_t slBitmap[WASM_HEAP_FL_COUNT];
+    WasmHeapBlock* free[WASM_HEAP_FL_COUNT][WASM_HEAP_SL_COUNT];
+    WasmHeapRegion* regions;        // For destroy; merged regions are not listed
+    WasmHeapBlock* tail;            // Sentinel closing the newest region
+    size_t reserved;                // Bytes taken from the system
+    size_t inUse;                   // Payload bytes handed out
+    size_t allocations;
+} WasmHeap;
+
+typedef struct {
+    size_t reservedBytes;
+    size_t inUseBytes;
+    size_t freeBytes;
+    size_t largestFree;             // Largest single allocation possible without growing
+    size_t allocations;
+    size_t freeBlocks;
+    size_t regions;
+} WasmHeapStats;
+
+void wasm_heap_init(WasmHeap* heap, size_t growStep);
+/* Return malloc'd regions; sbrk'd memory stays with the process. */
+void wasm_heap_destroy(WasmHeap* heap);
+
+/* WASM_HEAP_ALIGN-aligned, uninitialised; NULL when the system refuses to grow. */
+void* wasm_heap_alloc(WasmHeap* heap, size_t size);
+void wasm_heap_free(WasmHeap* heap, void* ptr);
+/* Bytes usable at `ptr`, at least what was asked for. */
+size_t wasm_heap_usable_size(const void* ptr);
+
+void wasm_heap_get_stats(WasmHeap* heap, WasmHeapStats* stats);
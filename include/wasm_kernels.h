@@ -0,0 +1,43 @@
+/*
+ * Universal Multi-Segmented Bi-Buffer Bus (UMSBB) - WASM Kernels
+ *
+ * Copyright (c) 2025 Kushagra Dubey
+ * Licensed under the MIT License - see LICENSE file for details.
+ *
+ * The inner loops of the WebAssembly cores, vectorised for WASM SIMD128:
+ *
+ * - Copy:  message payloads into and out of the rings, 64 bytes per step
+ *          with v128 loads and stores.
+ * - Scans: which segments hold messages, and which holds the least, over
+ *          counters the core has gathered into one array.
+ *
+ * Wasm has no runtime feature test from inside a module, so the path is
+ * chosen when compiling: -msimd128 builds the vector kernels, any other
+ * build (and every native one) the scalar fallbacks. Both produce identical
+ * results. The checksum engine follows the same switch.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* memcpy for non-overlapping ranges. */
+void wasm_copy_bytes(void* dst, const void* src, size_t size);
+
+/* Bit i set when words[i] is nonzero; count <= 32. */
+uint32_t wasm_nonzero_mask(const uint32_t* words, uint32_t count);
+
+/* Index of the smallest of values[0..count), the lowest on ties; 0 when
+ * count is 0. */
+uint32_t wasm_min_index(const uint32_t* values, uint32_t count);
+
+/* "wasm-simd128" or "scalar". */
+const char* wasm_kernels_impl_name(void);
+
+#ifdef __cplusplus
+}
+#endif
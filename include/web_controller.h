@@ -2,6 +2,8 @@
 #define WEB_CONTROLLER_H
 
 #include "gpu_accelerated_buffer.h"
+#include "portable_atomic.h"
+#include "metrics_registry.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -9,32 +11,159 @@
 extern "C" {
 #endif
 
-#define MAX_CLIENTS 100
-#define WEB_BUFFER_SIZE 65536
+/*
+Web Controller
+
+Monitoring endpoint: the dashboard, /api/status and /api/metrics over HTTP,
+a Prometheus scrape at /metrics, and metrics pushed to WebSocket subscribers.
+/metrics renders the MetricsRegistry given to web_server_set_metrics_registry
+into one buffer the server keeps across scrapes.
+
+One event loop thread serves every connection with non-blocking sockets:
+edge-triggered epoll on Linux, kqueue on the BSDs and macOS, and poll()
+(WSAPoll on Windows) elsewhere, so the number of connections is bounded by
+max_clients rather than FD_SETSIZE. Connections own no buffers until they
+need them: request and output buffers start at WEB_INITIAL_BUFFER bytes and
+grow on demand, a request to at most WEB_BUFFER_SIZE. Output a peer has not
+taken yet is queued and sent as the socket drains; a subscriber with more
+than WEB_MAX_PENDING_BYTES queued misses broadcasts until it catches up,
+so one slow dashboard never holds up the others.
+
+Run the loop on the calling thread with web_server_start, or on a thread of
+its own with web_server_start_thread.
+
+Metrics streams. A plain upgrade gets the JSON of /api/metrics as a text
+frame every WEB_BROADCAST_INTERVAL_MS in which it changed, which is what
+the dashboard uses.
+Upgrading with a query subscribes to the binary stream instead:
+
+    GET /ws?format=binary&interval_ms=50&fields=total_messages,throughput_gbps
+
+interval_ms defaults to WEB_BROADCAST_INTERVAL_MS (at least
+WEB_METRICS_MIN_INTERVAL_MS); fields, named as in /api/metrics or
+web_metric_name, default to all of them. Subscribers asking for the same
+interval and fields share one web_metrics_stream_t: the loop takes one
+web_metrics_snapshot per tick and encodes one binary frame per due stream
+holding only the fields that changed since that stream's last frame, then
+queues the same bytes to every member. Nothing is sent while nothing
+changes. Little-endian payload:
+
+    u8  version (WEB_METRICS_VERSION)
+    u8  flags (WEB_METRICS_KEYFRAME: every subscribed field is present)
+    u16 entry count
+    u32 sequence, per stream
+    u64 timestamp, ms
+    per entry: u8 field (web_metric_field_t), u64 value (an IEEE double's
+    bits for web_metric_is_real fields)
+
+A stream sends a keyframe first, whenever a subscriber joins it and after
+a member missed a frame to backpressure, so applying frames in order
+always reconstructs the current values. Rates and gauges from
+gpu_update_performance_metrics move every WEB_CACHE_INTERVAL_MS at most;
+counters such as total_messages move at the stream's own rate.
+*/
+
+#define MAX_CLIENTS 4096                    // Default max_clients
+#define WEB_BUFFER_SIZE 65536               // Largest request accepted
+#define WEB_INITIAL_BUFFER 1024             // First allocation of a connection buffer
+#define WEB_MAX_PENDING_BYTES (1u << 20)    // Queued output past which broadcasts skip a subscriber
+#define WEB_BROADCAST_INTERVAL_MS 500
+#define WEB_CACHE_INTERVAL_MS 100
+#define WEB_SERVER_CPU_AUTO (-1)            // web_server_start_thread: the CPU bus workers take last
+#define WEB_SERVER_CPU_NONE (-2)            // web_server_start_thread: leave the thread unpinned
+#define WEB_METRICS_MIN_INTERVAL_MS 10
+#define WEB_MAX_METRIC_STREAMS 16           // Distinct interval/field combinations served at once
+#define WEB_METRICS_VERSION 1
+#define WEB_METRICS_KEYFRAME 0x01
+#define WEB_METRICS_HEADER_SIZE 16
+#define WEB_METRICS_ENTRY_SIZE 9
+#define WEB_METRICS_FRAME_MAX (WEB_METRICS_HEADER_SIZE + WEB_METRIC_COUNT * WEB_METRICS_ENTRY_SIZE)
 #define DEFAULT_WEB_PORT 8080
 #define WEBSOCKET_MAGIC "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
 
+// Fields of the binary metrics stream; ids are part of the wire format
+typedef enum {
+    WEB_METRIC_THROUGHPUT_GBPS = 0,
+    WEB_METRIC_MESSAGES_PER_SECOND = 1,
+    WEB_METRIC_GPU_UTILIZATION = 2,
+    WEB_METRIC_ACTIVE_STREAMS = 3,
+    WEB_METRIC_TOTAL_GPU_MEMORY_USED = 4,
+    WEB_METRIC_MEMORY_BANDWIDTH_UTILIZATION = 5,
+    WEB_METRIC_CUDA_KERNEL_LAUNCHES = 6,
+    WEB_METRIC_AVERAGE_KERNEL_TIME_MS = 7,
+    WEB_METRIC_TOTAL_MESSAGES = 8,
+    WEB_METRIC_TOTAL_BYTES = 9,
+    WEB_METRIC_ACTIVE_CLIENTS = 10,
+    WEB_METRIC_BROADCASTS_SKIPPED = 11,
+    WEB_METRIC_COUNT
+} web_metric_field_t;
+
+#define WEB_METRIC_ALL ((1u << WEB_METRIC_COUNT) - 1)
+
+// Every field at one instant, as wire values
+typedef struct {
+    uint64_t values[WEB_METRIC_COUNT];
+    uint64_t timestamp_ms;
+} web_metrics_snapshot_t;
+
+// Subscribers sharing an interval and field set, and what they were last sent
+typedef struct {
+    uint32_t fields;                // Mask of 1 << web_metric_field_t
+    uint32_t interval_ms;
+    uint32_t subscribers;           // Free slot at 0
+    uint32_t sequence;
+    bool keyframe_pending;
+    uint64_t next_due;
+    uint64_t last[WEB_METRIC_COUNT];
+} web_metrics_stream_t;
+
 // Web client structure
 typedef struct {
     int socket_fd;
     bool is_websocket;
     bool is_active;
+    bool closing;                   // Close once the queued output is sent
     uint64_t last_activity;
-    char buffer[WEB_BUFFER_SIZE];
+    char* buffer;                   // Request bytes received so far
     size_t buffer_length;
+    size_t buffer_capacity;
+    char* output;                   // Queued bytes from output_sent on
+    size_t output_length;
+    size_t output_sent;
+    size_t output_capacity;
     uint32_t client_id;
+    uint32_t next_free;             // Free slot list, while inactive
+    int32_t metrics_stream;         // WebSocket: index into metric_streams, -1 for JSON
 } web_client_t;
 
 // Web server structure
 typedef struct {
     int server_socket;
     uint16_t port;
-    bool is_running;
-    web_client_t clients[MAX_CLIENTS];
+    atomic_bool is_running;
+    web_client_t* clients;          // client_capacity slots, grown on demand up to max_clients
+    uint32_t client_capacity;
+    uint32_t max_clients;
+    uint32_t free_client;           // First free slot, UINT32_MAX if none
     uint32_t active_clients;
     
+    // Event loop
+    int poll_fd;                    // epoll or kqueue instance; -1 with poll()
+    int wake_fds[2];                // web_server_stop wakes the loop through this pipe
+    void* poll_set;                 // poll() backend: struct pollfd per watched socket
+    uint32_t poll_capacity;
+    void* thread;                   // Set while web_server_start_thread's thread runs
+    uint64_t last_broadcast;
+    uint64_t broadcasts_skipped;    // Subscriber frames dropped for a full output queue
+    uint32_t json_subscribers;
+    bool json_refresh;              // A JSON subscriber joined; send even if unchanged
+    gpu_performance_metrics_t json_sent;
+    web_metrics_stream_t metric_streams[WEB_MAX_METRIC_STREAMS];
+    
     // Reference to GPU buffer for monitoring
     gpu_accelerated_buffer_t* gpu_buffer;
+    MetricsRegistry* registry;      // Served at /metrics; NULL answers 404
+    MetricsText metrics_text;       // Scrape output, reused
     
     // Performance data cache
     gpu_performance_metrics_t last_metrics;
@@ -67,13 +196,22 @@ typedef enum {
 
 // Web server lifecycle
 int web_server_init(web_server_t* server, uint16_t port, gpu_accelerated_buffer_t* gpu_buffer);
+// Run the event loop on the calling thread until web_server_stop
 int web_server_start(web_server_t* server);
+// Run it on a new thread, pinned to `cpu` or per WEB_SERVER_CPU_AUTO/NONE
+int web_server_start_thread(web_server_t* server, int cpu);
+// Serve `registry` at /metrics and export the server's own counters into it.
+// Call before starting the loop; cleanup removes the server's series.
+bool web_server_set_metrics_registry(web_server_t* server, MetricsRegistry* registry);
+// Ask the loop to return; joins the thread web_server_start_thread made
 void web_server_stop(web_server_t* server);
 void web_server_cleanup(web_server_t* server);
 
 // Client management
+// Accept every pending connection; returns how many
 int web_accept_client(web_server_t* server);
 void web_disconnect_client(web_server_t* server, uint32_t client_id);
+// Read what the client sent and answer complete requests; < 0 to disconnect
 int web_handle_client_request(web_server_t* server, uint32_t client_id);
 
 // HTTP handling
@@ -102,8 +240,17 @@ int json_add_boolean(json_response_t* response, const char* key, bool value);
 int json_finalize(json_response_t* response);
 
 // Real-time data broadcasting
+// Send JSON and binary metrics frames that are due
 int web_broadcast_metrics(web_server_t* server);
 int web_update_performance_cache(web_server_t* server);
+void web_metrics_snapshot(web_server_t* server, web_metrics_snapshot_t* snapshot);
+// Encode the fields of `stream` that differ from what it last sent (all of them
+// for a keyframe) and remember them; returns the payload size, 0 if unchanged
+size_t web_metrics_encode(web_metrics_stream_t* stream, const web_metrics_snapshot_t* snapshot,
+                          uint8_t* out, size_t capacity);
+// The /api/metrics key of a field, and whether its value is a double
+const char* web_metric_name(web_metric_field_t field);
+bool web_metric_is_real(web_metric_field_t field);
 
 // Utility functions
 const char* web_get_mime_type(const char* path);
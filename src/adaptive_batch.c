@@ -8,10 +8,11 @@ void batch_init(AdaptiveBatch* batch, size_t min, size_t max, size_t step) {
 }
 
 size_t batch_next(AdaptiveBatch* batch, size_t feedbackScore) {
-    if (feedbackScore > 80 && batch->current + batch->step <= batch->max) {
-        batch->current += batch->step;
-    } else if (feedbackScore < 30 && batch->current > batch->min + batch->step) {
-        batch->current -= batch->step;
+    // Steps stop at the bounds instead of short of them
+    if (feedbackScore > 80) {
+        batch->current = batch->current + batch->step < batch->max ? batch->current + batch->step : batch->max;
+    } else if (feedbackScore < 30) {
+        batch->current = batch->current > batch->min + batch->step ? batch->current - batch->step : batch->min;
     }
     return batch->current;
 }
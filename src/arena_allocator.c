@@ -1,20 +1,309 @@
 #include "arena_allocator.h"
+#include "bi_buffer.h"
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32)
+#  include <windows.h>
+#elif defined(__linux__)
+#  include <sys/mman.h>
+#endif
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;        // Bytes including this header
+    size_t start;       // Thread cursor at the first data byte
+    size_t end;         // Thread cursor after the last allocation (set when sealed)
+    bool mapped;        // Came from the page allocator rather than malloc
+    bool oversized;     // Dedicated to one large allocation; freed instead of reused
+} ArenaBlock;
+
+struct ArenaThread {
+    atomic_size_t releaseCursor;        // Advanced by consumers
+    uint8_t pad[SOMA_ALIGNMENT];        // Keep consumer writes off the owner's line
+    ArenaAllocator* arena;
+    ArenaThread* next;
+    const void* owner;                  // Address of a thread-local of the owning thread
+    ArenaBlock* current;
+    uint8_t* bump;
+    uint8_t* limit;
+    ArenaBlock* sealedHead;             // Full blocks, oldest first
+    ArenaBlock* sealedTail;
+    ArenaBlock* freeBlocks;
+};
+
+/* Stored just before every allocation so release needs no lookup. */
+typedef struct {
+    ArenaThread* owner;
+    size_t end;         // Owner cursor just past this allocation
+} ArenaHeader;
+
+#define ARENA_ROUND(x, a) (((x) + ((a) - 1)) & ~(size_t)((a) - 1))
+#define ARENA_HEADER_SIZE ARENA_ROUND(sizeof(ArenaHeader), ARENA_ALIGNMENT)
+#define ARENA_BLOCK_HEADER_SIZE ARENA_ROUND(sizeof(ArenaBlock), SOMA_ALIGNMENT)
+
+static atomic_size_t arena_next_id;
+static SOMA_THREAD_LOCAL size_t arena_cached_id;
+static SOMA_THREAD_LOCAL ArenaThread* arena_cached_thread;
+
+static inline uint8_t* arena_block_data(ArenaBlock* block) {
+    return (uint8_t*)block + ARENA_BLOCK_HEADER_SIZE;
+}
+
+/* Wrap-safe `a <= b` for thread cursors. */
+static inline bool arena_cursor_reached(size_t a, size_t b) {
+    return (size_t)(b - a) <= (SIZE_MAX >> 1);
+}
+
+static ArenaBlock* arena_map_block(ArenaAllocator* arena, size_t size, bool* mapped) {
+    *mapped = false;
+    if (arena->flags & ARENA_FLAG_HUGE_PAGES) {
+#if defined(__linux__)
+        size_t rounded = ARENA_ROUND(size, ARENA_HUGE_PAGE_SIZE);
+        void* p = MAP_FAILED;
+#  if defined(MAP_HUGETLB)
+        p = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#  endif
+        if (p == MAP_FAILED) {
+            // No reserved huge pages: ask for transparent ones instead
+            p = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#  if defined(MADV_HUGEPAGE)
+            if (p != MAP_FAILED) madvise(p, rounded, MADV_HUGEPAGE);
+#  endif
+        }
+        if (p != MAP_FAILED) {
+            *mapped = true;
+            return (ArenaBlock*)p;
+        }
+#elif defined(_WIN32)
+        // Large pages need SeLockMemoryPrivilege; without it this just fails
+        SIZE_T large = GetLargePageMinimum();
+        if (large) {
+            void* p = VirtualAlloc(NULL, ARENA_ROUND(size, (size_t)large),
+                                   MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (p) {
+                *mapped = true;
+                return (ArenaBlock*)p;
+            }
+        }
+#endif
+    }
+    return (ArenaBlock*)malloc(size);
+}
+
+static void arena_unmap_block(ArenaBlock* block) {
+    if (!block->mapped) {
+        free(block);
+        return;
+    }
+#if defined(__linux__)
+    munmap(block, ARENA_ROUND(block->size, ARENA_HUGE_PAGE_SIZE));
+#elif defined(_WIN32)
+    VirtualFree(block, 0, MEM_RELEASE);
+#endif
+}
+
+static void arena_free_block(ArenaAllocator* arena, ArenaBlock* block) {
+    size_t size = block->size;
+    arena_unmap_block(block);
+    atomic_fetch_add_size(&arena->reserved, (size_t)0 - size);
+}
+
 void arena_init(ArenaAllocator* arena, size_t cap) {
-    arena->memory = malloc(cap);
+    arena_init_ex(arena, cap, ARENA_DEFAULT_BLOCK_SIZE, 0);
+}
+
+bool arena_init_ex(ArenaAllocator* arena, size_t cap, size_t blockSize, uint32_t flags) {
+    if (blockSize < 4096) blockSize = 4096;
+    if (cap && blockSize > cap) blockSize = cap < 4096 ? 4096 : cap;
     arena->capacity = cap;
-    arena->offset = 0;
+    arena->blockSize = blockSize;
+    arena->flags = flags;
+    arena->id = atomic_fetch_add_size(&arena_next_id, 1) + 1;
+    atomic_store_size(&arena->reserved, 0);
+    atomic_store_size(&arena->threads, 0);
+    return true;
+}
+
+/* The calling thread's state for `arena`, created on first use. */
+static ArenaThread* arena_thread(ArenaAllocator* arena) {
+    if (arena_cached_id == arena->id) return arena_cached_thread;
+
+    // A thread-local's address identifies this thread; a new thread that
+    // lands on the address of an exited one simply adopts its blocks
+    const void* self = &arena_cached_id;
+    ArenaThread* t = (ArenaThread*)(uintptr_t)atomic_load_size_acquire(&arena->threads);
+    for (; t; t = t->next) {
+        if (t->owner == self) break;
+    }
+    if (!t) {
+        t = calloc(1, sizeof(ArenaThread));
+        if (!t) return NULL;
+        t->arena = arena;
+        t->owner = self;
+        atomic_store_size(&t->releaseCursor, 0);
+        size_t head = atomic_load_size(&arena->threads);
+        do {
+            t->next = (ArenaThread*)(uintptr_t)head;
+        } while (!atomic_cas_size(&arena->threads, &head, (size_t)(uintptr_t)t));
+    }
+    arena_cached_id = arena->id;
+    arena_cached_thread = t;
+    return t;
+}
+
+/* Seal the current block and switch to a recycled or new one with room for `need` bytes. */
+static bool arena_next_block(ArenaAllocator* arena, ArenaThread* t, size_t need) {
+    size_t cursor = 0;
+    if (t->current) {
+        ArenaBlock* full = t->current;
+        cursor = full->start + (size_t)(t->bump - arena_block_data(full));
+        full->end = cursor;
+        full->next = NULL;
+        if (t->sealedTail) t->sealedTail->next = full;
+        else t->sealedHead = full;
+        t->sealedTail = full;
+        t->current = NULL;
+    } else {
+        cursor = atomic_load_size_acquire(&t->releaseCursor);
+        if (t->sealedTail && !arena_cursor_reached(t->sealedTail->end, cursor)) cursor = t->sealedTail->end;
+    }
+
+    // Everything the consumers have moved past can be reused
+    size_t released = atomic_load_size_acquire(&t->releaseCursor);
+    while (t->sealedHead && arena_cursor_reached(t->sealedHead->end, released)) {
+        ArenaBlock* block = t->sealedHead;
+        t->sealedHead = block->next;
+        if (!t->sealedHead) t->sealedTail = NULL;
+        if (block->oversized) {
+            arena_free_block(arena, block);
+        } else {
+            block->next = t->freeBlocks;
+            t->freeBlocks = block;
+        }
+    }
+
+    ArenaBlock* block = NULL;
+    size_t regular = arena->blockSize - ARENA_BLOCK_HEADER_SIZE;
+    if (need <= regular && t->freeBlocks) {
+        block = t->freeBlocks;
+        t->freeBlocks = block->next;
+    } else {
+        bool oversized = need > regular;
+        size_t size = oversized ? ARENA_ROUND(need + ARENA_BLOCK_HEADER_SIZE, 4096) : arena->blockSize;
+        size_t reserved = atomic_fetch_add_size(&arena->reserved, size);
+        if (arena->capacity && reserved + size > arena->capacity) {
+            atomic_fetch_add_size(&arena->reserved, (size_t)0 - size);
+            return false;
+        }
+        bool mapped;
+        block = arena_map_block(arena, size, &mapped);
+        if (!block) {
+            atomic_fetch_add_size(&arena->reserved, (size_t)0 - size);
+            return false;
+        }
+        block->size = size;
+        block->mapped = mapped;
+        block->oversized = oversized;
+    }
+
+    block->next = NULL;
+    block->start = cursor;
+    block->end = cursor;
+    t->current = block;
+    t->bump = arena_block_data(block);
+    t->limit = (uint8_t*)block + block->size;
+    return true;
+}
+
+void* arena_alloc_aligned(ArenaAllocator* arena, size_t size, size_t align) {
+    if (!arena) return NULL;
+    if (align < ARENA_ALIGNMENT) align = ARENA_ALIGNMENT;
+    ArenaThread* t = arena_thread(arena);
+    if (!t) return NULL;
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (t->current) {
+            uintptr_t payload = ARENA_ROUND((uintptr_t)t->bump + ARENA_HEADER_SIZE, align);
+            if (payload + size <= (uintptr_t)t->limit && payload + size >= payload) {
+                uint8_t* end = (uint8_t*)(payload + size);
+                ArenaHeader* header = (ArenaHeader*)(payload - ARENA_HEADER_SIZE);
+                header->owner = t;
+                header->end = t->current->start + (size_t)(end - arena_block_data(t->current));
+                t->bump = end;
+                return (void*)payload;
+            }
+        }
+        if (!arena_next_block(arena, t, size + ARENA_HEADER_SIZE + align)) return NULL;
+    }
+    return NULL;
 }
 
 void* arena_alloc(ArenaAllocator* arena, size_t size) {
-    if (arena->offset + size > arena->capacity) return NULL;
-    void* ptr = arena->memory + arena->offset;
-    arena->offset += size;
-    return ptr;
+    return arena_alloc_aligned(arena, size, ARENA_ALIGNMENT);
+}
+
+void arena_release(void* ptr) {
+    if (!ptr) return;
+    ArenaHeader* header = (ArenaHeader*)((uint8_t*)ptr - ARENA_HEADER_SIZE);
+    ArenaThread* t = header->owner;
+
+    // Monotonic max, so concurrent consumers of one producer cannot move it back
+    size_t cursor = atomic_load_size_relaxed(&t->releaseCursor);
+    while (!arena_cursor_reached(header->end, cursor)) {
+        if (atomic_cas_size(&t->releaseCursor, &cursor, header->end)) break;
+    }
+}
+
+static void arena_thread_blocks(ArenaAllocator* arena, ArenaThread* t, bool keep) {
+    if (keep) {
+        // Treat everything handed out so far as released
+        size_t cursor = atomic_load_size(&t->releaseCursor);
+        if (t->current) cursor = t->current->start + (size_t)(t->bump - arena_block_data(t->current));
+        else if (t->sealedTail) cursor = t->sealedTail->end;
+        atomic_store_size(&t->releaseCursor, cursor);
+    }
+    ArenaBlock* lists[3] = { t->current, t->sealedHead, keep ? NULL : t->freeBlocks };
+    if (t->current) t->current->next = NULL;
+    for (int i = 0; i < 3; ++i) {
+        ArenaBlock* block = lists[i];
+        while (block) {
+            ArenaBlock* next = block->next;
+            if (keep && !block->oversized) {
+                block->next = t->freeBlocks;
+                t->freeBlocks = block;
+            } else {
+                arena_free_block(arena, block);
+            }
+            block = next;
+        }
+    }
+    t->current = NULL;
+    t->sealedHead = NULL;
+    t->sealedTail = NULL;
+    t->bump = NULL;
+    t->limit = NULL;
+    if (!keep) t->freeBlocks = NULL;
 }
 
 void arena_reset(ArenaAllocator* arena) {
-    arena->offset = 0;
-}
\ No newline at end of file
+    ArenaThread* t = (ArenaThread*)(uintptr_t)atomic_load_size_acquire(&arena->threads);
+    for (; t; t = t->next) arena_thread_blocks(arena, t, true);
+}
+
+void arena_destroy(ArenaAllocator* arena) {
+    ArenaThread* t = (ArenaThread*)(uintptr_t)atomic_load_size_acquire(&arena->threads);
+    while (t) {
+        ArenaThread* next = t->next;
+        arena_thread_blocks(arena, t, false);
+        free(t);
+        t = next;
+    }
+    atomic_store_size(&arena->threads, 0);
+    // Stale thread-local caches no longer match
+    arena->id = 0;
+}
+
+size_t arena_reserved(ArenaAllocator* arena) {
+    return atomic_load_size(&arena->reserved);
+}
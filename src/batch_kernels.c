@@ -0,0 +1,241 @@
+#include "batch_kernels.h"
+#include "portable_atomic.h"
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#  define BATCH_X86 1
+#  include <immintrin.h>
+#  define BATCH_TARGET(t) __attribute__((target(t)))
+#endif
+
+#if defined(_MSC_VER)
+#  include <stdlib.h>
+#  define BATCH_BSWAP16(v) _byteswap_ushort(v)
+#  define BATCH_BSWAP32(v) _byteswap_ulong(v)
+#  define BATCH_BSWAP64(v) _byteswap_uint64(v)
+#else
+#  define BATCH_BSWAP16(v) __builtin_bswap16(v)
+#  define BATCH_BSWAP32(v) __builtin_bswap32(v)
+#  define BATCH_BSWAP64(v) __builtin_bswap64(v)
+#endif
+
+typedef void (*bswap_fn)(uint8_t* data, size_t words, size_t width);
+
+/* ---- Byte swaps ---- */
+
+static void bswap_scalar(uint8_t* p, size_t words, size_t width) {
+    for (size_t i = 0; i < words; i++, p += width) {
+        if (width == 2) {
+            uint16_t v;
+            memcpy(&v, p, 2);
+            v = BATCH_BSWAP16(v);
+            memcpy(p, &v, 2);
+        } else if (width == 4) {
+            uint32_t v;
+            memcpy(&v, p, 4);
+            v = BATCH_BSWAP32(v);
+            memcpy(p, &v, 4);
+        } else {
+            uint64_t v;
+            memcpy(&v, p, 8);
+            v = BATCH_BSWAP64(v);
+            memcpy(p, &v, 8);
+        }
+    }
+}
+
+#if defined(BATCH_X86)
+/* pshufb control reversing each `width`-byte word of a 16-byte block */
+static __m128i bswap_mask(size_t width) {
+    uint8_t control[16];
+    for (size_t i = 0; i < 16; i++) control[i] = (uint8_t)((i / width) * width + (width - 1 - i % width));
+    __m128i mask;
+    memcpy(&mask, control, sizeof(mask));
+    return mask;
+}
+
+BATCH_TARGET("ssse3")
+static void bswap_ssse3(uint8_t* p, size_t words, size_t width) {
+    const __m128i mask = bswap_mask(width);
+    size_t blocks = words * width / 16;
+    for (size_t i = 0; i < blocks; i++, p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        _mm_storeu_si128((__m128i*)p, _mm_shuffle_epi8(v, mask));
+    }
+    bswap_scalar(p, words - blocks * 16 / width, width);
+}
+
+BATCH_TARGET("avx2")
+static void bswap_avx2(uint8_t* p, size_t words, size_t width) {
+    // vpshufb works per 128-bit half, which suits words that never straddle one
+    const __m128i half = bswap_mask(width);
+    const __m256i mask = _mm256_broadcastsi128_si256(half);
+    size_t blocks = words * width / 32;
+    for (size_t i = 0; i < blocks; i++, p += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        _mm256_storeu_si256((__m256i*)p, _mm256_shuffle_epi8(v, mask));
+    }
+    bswap_scalar(p, words - blocks * 32 / width, width);
+}
+#endif
+
+static bswap_fn bswap_impl_fn = bswap_scalar;
+static const char* bswap_impl_label = "scalar";
+static atomic_size_t bswap_ready;
+
+static void bswap_select(void) {
+#if defined(BATCH_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        bswap_impl_fn = bswap_avx2;
+        bswap_impl_label = "avx2";
+    } else if (__builtin_cpu_supports("ssse3")) {
+        bswap_impl_fn = bswap_ssse3;
+        bswap_impl_label = "ssse3";
+    }
+#endif
+}
+
+/* Selection is idempotent, so racing first callers just do it twice. */
+static inline void bswap_ensure_ready(void) {
+    if (atomic_load_size_acquire(&bswap_ready)) return;
+    bswap_select();
+    atomic_store_size_release(&bswap_ready, 1);
+}
+
+void batch_bswap16(uint8_t* data, size_t size) {
+    bswap_ensure_ready();
+    bswap_impl_fn(data, size / 2, 2);
+}
+
+void batch_bswap32(uint8_t* data, size_t size) {
+    bswap_ensure_ready();
+    bswap_impl_fn(data, size / 4, 4);
+}
+
+void batch_bswap64(uint8_t* data, size_t size) {
+    bswap_ensure_ready();
+    bswap_impl_fn(data, size / 8, 8);
+}
+
+void batch_kernels_force_scalar(bool scalar) {
+    bswap_ensure_ready();
+    if (scalar) {
+        bswap_impl_fn = bswap_scalar;
+        bswap_impl_label = "scalar";
+    } else {
+        bswap_select();
+    }
+}
+
+const char* batch_kernels_impl_name(void) {
+    bswap_ensure_ready();
+    return bswap_impl_label;
+}
+
+/* ---- Built-in kernels ---- */
+
+static bool kernel_bswap16(const void* params, uint8_t* data, uint32_t* length, uint32_t lane) {
+    (void)params;
+    (void)lane;
+    batch_bswap16(data, *length);
+    return true;
+}
+
+static bool kernel_bswap32(const void* params, uint8_t* data, uint32_t* length, uint32_t lane) {
+    (void)params;
+    (void)lane;
+    batch_bswap32(data, *length);
+    return true;
+}
+
+static bool kernel_bswap64(const void* params, uint8_t* data, uint32_t* length, uint32_t lane) {
+    (void)params;
+    (void)lane;
+    batch_bswap64(data, *length);
+    return true;
+}
+
+static bool kernel_filter(const void* params, uint8_t* data, uint32_t* length, uint32_t lane) {
+    (void)lane;
+    const batch_filter_t* filter = (const batch_filter_t*)params;
+    return filter && filter->offset < *length && (data[filter->offset] & filter->mask) == filter->value;
+}
+
+static bool kernel_project(const void* params, uint8_t* data, uint32_t* length, uint32_t lane) {
+    (void)lane;
+    const batch_projection_t* projection = (const batch_projection_t*)params;
+    if (!projection || projection->offset >= *length) {
+        *length = 0;
+        return true;
+    }
+    uint32_t kept = *length - projection->offset;
+    if (kept > projection->length) kept = projection->length;
+    memmove(data, data + projection->offset, kept);
+    *length = kept;
+    return true;
+}
+
+static batch_kernel_fn batch_registry[BATCH_KERNEL_MAX_ID] = {
+    [BATCH_KERNEL_BSWAP16] = kernel_bswap16,
+    [BATCH_KERNEL_BSWAP32] = kernel_bswap32,
+    [BATCH_KERNEL_BSWAP64] = kernel_bswap64,
+    [BATCH_KERNEL_FILTER] = kernel_filter,
+    [BATCH_KERNEL_PROJECT] = kernel_project,
+};
+
+/* ---- Registry ---- */
+
+bool batch_kernel_register(uint32_t id, batch_kernel_fn fn) {
+    if (!fn || id < BATCH_KERNEL_FIRST_USER || id >= BATCH_KERNEL_MAX_ID || batch_registry[id]) return false;
+    batch_registry[id] = fn;
+    return true;
+}
+
+void batch_kernel_unregister(uint32_t id) {
+    if (id >= BATCH_KERNEL_FIRST_USER && id < BATCH_KERNEL_MAX_ID) batch_registry[id] = NULL;
+}
+
+batch_kernel_fn batch_kernel_lookup(uint32_t id) {
+    return id < BATCH_KERNEL_MAX_ID ? batch_registry[id] : NULL;
+}
+
+bool batch_kernel_resolve(batch_kernel_chain_t* chain, const batch_kernel_step_t* steps, uint32_t count) {
+    if (!chain || count > BATCH_KERNEL_MAX_CHAIN || (count && !steps)) return false;
+    memset(chain, 0, sizeof(*chain));
+    for (uint32_t i = 0; i < count; i++) {
+        batch_kernel_fn fn = batch_kernel_lookup(steps[i].id);
+        if (!fn) return false;
+        chain->fns[i] = fn;
+        chain->params[i] = steps[i].params;
+    }
+    chain->steps = count;
+    return true;
+}
+
+/* ---- Batches ---- */
+
+uint32_t batch_kernels_process(const batch_kernel_chain_t* chain, uint8_t* data, const uint64_t* offsets,
+                               uint32_t* lengths, const uint32_t* lanes, const uint8_t* policies,
+                               const uint32_t* checksums, uint8_t* status, uint32_t count) {
+    uint32_t intact = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t* record = data + offsets[i];
+        if (policies && checksums &&
+            !checksum_verify((checksum_policy_t)policies[i], record, lengths[i], checksums[i])) {
+            status[i] = BATCH_RECORD_CORRUPT;
+            continue;
+        }
+
+        status[i] = BATCH_RECORD_OK;
+        uint32_t steps = chain ? chain->steps : 0;
+        for (uint32_t s = 0; s < steps; s++) {
+            if (!chain->fns[s](chain->params[s], record, &lengths[i], lanes ? lanes[i] : 0)) {
+                status[i] = BATCH_RECORD_FILTERED;
+                break;
+            }
+        }
+        if (status[i] == BATCH_RECORD_OK) intact++;
+    }
+    return intact;
+}
@@ -1,6 +1,6 @@
 #include "bi_buffer.h"
 #include "portable_atomic.h"
-#include "capsule.h"
+#include "umsbb_trace.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -20,122 +20,685 @@
 #  define soma_aligned_free(ptr) free(ptr)
 #endif
 
-void bi_buffer_init(BiBuffer* buf, size_t cap) {
-    buf->capacity = cap;
-    buf->regionA = soma_aligned_alloc(SOMA_ALIGNMENT, cap);
-    buf->regionB = soma_aligned_alloc(SOMA_ALIGNMENT, cap);
-    buf->regionC = soma_aligned_alloc(SOMA_ALIGNMENT, cap / 4); // Metadata region (smaller)
+/*
+ * Low bit of writeIndex while an MPSC producer switches regions. Indices are
+ * multiples of BI_BUFFER_FRAME_ALIGN, so it is otherwise always clear and a
+ * parked writeIndex makes every concurrent reservation CAS fail.
+ */
+#define BI_BUFFER_SWITCHING ((size_t)1)
+/* Indices skipped between a seal and the successor's base, so writeIndex
+ * never returns to a value a stalled MPSC producer may still hold. */
+#define BI_BUFFER_REGION_GAP BI_BUFFER_FRAME_ALIGN
+
+/* Trace points name a ring by its address and a frame by its offset, which
+ * every stage from claim to release can work out cheaply. */
+#define BI_BUFFER_TRACE(buf, event, offset) \
+    UMSBB_TRACE(UMSBB_TRACE_BI_BUFFER, event, (uintptr_t)(buf) >> 6, offset)
+
+static size_t bi_buffer_round_capacity(size_t cap) {
+    size_t rounded = BI_BUFFER_MIN_CAPACITY;
+    while (rounded < cap) rounded <<= 1;
+    return rounded;
+}
+
+/* Wrap-safe `a < b` for monotonic ring indices. */
+static inline bool bi_buffer_before(size_t a, size_t b) {
+    return (size_t)(b - a - 1) < (SIZE_MAX >> 1);
+}
+
+/* Geometry of a region slot. Relaxed loads suffice: the slot was published
+ * with a release on `pending`/`produce`, and a producer reading a slot that is
+ * being reused only feeds a reservation CAS that then fails. */
+static inline size_t bi_buffer_region_capacity(BiBufferRegion* r) {
+    return atomic_load_size_relaxed(&r->capacity);
+}
+
+static inline size_t bi_buffer_region_mask(BiBufferRegion* r) {
+    return atomic_load_size_relaxed(&r->mask);
+}
+
+static inline size_t bi_buffer_region_base(BiBufferRegion* r) {
+    return atomic_load_size_relaxed(&r->base);
+}
+
+static inline uint8_t* bi_buffer_region_storage(BiBufferRegion* r) {
+    return atomic_load_ptr_relaxed(&r->regionA);
+}
+
+static inline BiBufferFrame* bi_buffer_frame_at(BiBufferRegion* r, size_t index) {
+    return (BiBufferFrame*)(bi_buffer_region_storage(r) + (index & bi_buffer_region_mask(r)));
+}
+
+/*
+ * Bytes a frame of `frameSize` consumes when written at `writeIndex`: the
+ * frame itself plus, if it would straddle the end of the ring, the padding
+ * that skips the tail. Returns 0 if the frame can never fit.
+ */
+static size_t bi_buffer_span(BiBufferRegion* r, size_t writeIndex, size_t frameSize) {
+    size_t capacity = bi_buffer_region_capacity(r);
+    if (frameSize > capacity) return 0;
+    size_t tail = capacity - (writeIndex & (capacity - 1));
+    return (frameSize <= tail) ? frameSize : tail + frameSize;
+}
+
+/* Bytes of `r` in use up to `writeIndex`; a region the consumer has not reached yet fills from its base. */
+static inline size_t bi_buffer_used(BiBufferRegion* r, size_t writeIndex, size_t readIndex) {
+    size_t base = bi_buffer_region_base(r);
+    return writeIndex - (bi_buffer_before(readIndex, base) ? base : readIndex);
+}
+
+/* MPSC commit flag for the frame starting at `index` (one byte per granule). */
+static inline atomic_uchar* bi_buffer_slot_state(BiBufferRegion* r, size_t index) {
+    return (atomic_uchar*)r->regionC + ((index & bi_buffer_region_mask(r)) / BI_BUFFER_FRAME_ALIGN);
+}
+
+static void bi_buffer_region_free(BiBufferRegion* r) {
+    // Geometry is left in place: a stalled MPSC producer may still read it
+    // (atomically, even after a resize reuses the slot), and its reservation
+    // CAS fails because writeIndex has moved on
+    void* storage = bi_buffer_region_storage(r);
+    atomic_store_ptr_relaxed(&r->regionA, NULL);
+    if (storage) soma_aligned_free(storage);
+    if (r->regionB) soma_aligned_free(r->regionB);
+    if (r->regionC) soma_aligned_free(r->regionC);
+    r->regionB = NULL;
+    r->regionC = NULL;
+}
+
+static bool bi_buffer_region_alloc(BiBufferRegion* r, size_t cap, size_t base) {
+    size_t capacity = bi_buffer_round_capacity(cap);
+    atomic_store_size_relaxed(&r->capacity, capacity);
+    atomic_store_size_relaxed(&r->mask, capacity - 1);
+    atomic_store_size_relaxed(&r->base, base);
+    r->regionB = soma_aligned_alloc(SOMA_ALIGNMENT, capacity);
+    r->regionC = soma_aligned_alloc(SOMA_ALIGNMENT, capacity / 4); // Metadata region (smaller)
+    // Stored last: bi_buffer_region_of trusts the capacity of a slot whose storage it sees
+    atomic_store_ptr_release(&r->regionA, soma_aligned_alloc(SOMA_ALIGNMENT, capacity));
+    if (!bi_buffer_region_storage(r) || !r->regionB || !r->regionC) {
+        bi_buffer_region_free(r);
+        return false;
+    }
+    atomic_store_size(&r->sealIndex, BI_BUFFER_UNSEALED);
+    atomic_store_size(&r->next, 0);
+
+    // Initialize all message states to FREE
+    memset(r->regionC, MSG_STATE_FREE, capacity / 4);
+    return true;
+}
+
+static inline bool bi_buffer_region_holds(BiBufferRegion* r, const void* frame) {
+    const uint8_t* start = atomic_load_ptr_acquire(&r->regionA);
+    return start && (const uint8_t*)frame >= start && (const uint8_t*)frame < start + bi_buffer_region_capacity(r);
+}
+
+/*
+ * Region containing `frame` (claimed, not yet released). Almost always the
+ * producer region; otherwise one that was sealed after the claim. Slots that
+ * are free or being reallocated never contain a live frame, so seeing them
+ * mid-update can only miss.
+ */
+static BiBufferRegion* bi_buffer_region_of(BiBuffer* buf, const void* frame) {
+    BiBufferRegion* r = &buf->regions[atomic_load_size_relaxed(&buf->produce)];
+    if (bi_buffer_region_holds(r, frame)) return r;
+    for (size_t i = 0; i < BI_BUFFER_MAX_REGIONS; ++i) {
+        if (bi_buffer_region_holds(&buf->regions[i], frame)) return &buf->regions[i];
+    }
+    return r;
+}
+
+static void bi_buffer_reset(BiBuffer* buf, size_t cap, BiBufferMode mode) {
+    for (size_t i = 0; i < BI_BUFFER_MAX_REGIONS; ++i) {
+        BiBufferRegion* r = &buf->regions[i];
+        atomic_store_size(&r->capacity, 0);
+        atomic_store_size(&r->mask, 0);
+        atomic_store_size(&r->base, 0);
+        atomic_store_ptr_relaxed(&r->regionA, NULL);
+        r->regionB = NULL;
+        r->regionC = NULL;
+        atomic_store_size(&r->sealIndex, BI_BUFFER_UNSEALED);
+        atomic_store_size(&r->next, 0);
+        atomic_store_size(&r->inUse, 0);
+    }
+    buf->mode = mode;
+    bi_buffer_region_alloc(&buf->regions[0], cap, 0);
+    atomic_store_size(&buf->regions[0].inUse, 1);
+    atomic_store_size(&buf->produce, 0);
+    atomic_store_size(&buf->pending, 0);
+    buf->consume = 0;
+
     atomic_store_size(&buf->writeIndex, 0);
     atomic_store_size(&buf->readIndex, 0);
     atomic_store_size(&buf->commitIndex, 0);
     atomic_store_size(&buf->feedbackIndex, 0);
-    
-    // Initialize all message states to FREE
-    memset(buf->regionC, MSG_STATE_FREE, cap / 4);
+    buf->cachedReadIndex = 0;
+    buf->cachedCommitIndex = 0;
 }
 
-void* bi_buffer_claim(BiBuffer* buf, size_t size) {
-    size_t writeIndex = atomic_load_size(&buf->writeIndex);
-    size_t readIndex = atomic_load_size(&buf->readIndex);
-    
-    // Check if we have space (leave some buffer to prevent wrap issues)
-    if (writeIndex + size > buf->capacity || 
-        (writeIndex >= readIndex && writeIndex + size > buf->capacity) ||
-        (writeIndex < readIndex && writeIndex + size > readIndex)) {
+void bi_buffer_init(BiBuffer* buf, size_t cap) {
+    bi_buffer_reset(buf, cap, BI_BUFFER_MODE_SINGLE);
+}
+
+void bi_buffer_init_mode(BiBuffer* buf, size_t cap, BiBufferMode mode) {
+    bi_buffer_reset(buf, cap, mode);
+}
+
+BiBuffer* bi_buffer_create(size_t cap, BiBufferMode mode) {
+    // Rounded to the alignment so aligned_alloc accepts the size
+    size_t bytes = (sizeof(BiBuffer) + SOMA_ALIGNMENT - 1) & ~(size_t)(SOMA_ALIGNMENT - 1);
+    BiBuffer* buf = soma_aligned_alloc(SOMA_ALIGNMENT, bytes);
+    if (!buf) return NULL;
+    bi_buffer_reset(buf, cap, mode);
+    if (!bi_buffer_region_storage(&buf->regions[0])) {
+        soma_aligned_free(buf);
         return NULL;
     }
-    
-    // Set state to READY (claiming the space)
-    bi_buffer_set_message_state(buf, writeIndex, MSG_STATE_READY);
-    return (uint8_t*)buf->regionA + writeIndex;
+    return buf;
 }
 
-void bi_buffer_commit(BiBuffer* buf, void* ptr, size_t size) {
+void bi_buffer_free(BiBuffer* buf) {
+    if (!buf) return;
+    bi_buffer_destroy(buf);
+    soma_aligned_free(buf);
+}
+
+bool bi_buffer_set_mode(BiBuffer* buf, BiBufferMode mode) {
+    // Switching the producer model is only safe while the buffer is idle
     size_t writeIndex = atomic_load_size(&buf->writeIndex);
-    atomic_fetch_add_size(&buf->writeIndex, size);
-    atomic_store_size(&buf->commitIndex, writeIndex + size);
-    
-    // Transition state: READY → CONSUMING (ready for consumption)
-    bi_buffer_set_message_state(buf, writeIndex, MSG_STATE_CONSUMING);
+    if (writeIndex != atomic_load_size(&buf->readIndex)) return false;
+    if (atomic_load_size(&buf->pending) != 0) return false;
+    atomic_store_size(&buf->commitIndex, writeIndex);
+    buf->cachedReadIndex = writeIndex;
+    buf->cachedCommitIndex = writeIndex;
+    buf->mode = mode;
+    return true;
 }
 
-void* bi_buffer_read(BiBuffer* buf, size_t* size) {
+/* Lay out the (optional) padding and the frame header of a reserved span. */
+static void* bi_buffer_place(BiBuffer* buf, BiBufferRegion* r, size_t writeIndex,
+                             size_t span, size_t frameSize, size_t size) {
+    if (span != frameSize) {
+        // Not enough room before the end: mark the tail as padding and wrap
+        BiBufferFrame* pad = bi_buffer_frame_at(r, writeIndex);
+        pad->length = (uint32_t)(span - frameSize - sizeof(BiBufferFrame));
+        pad->state = MSG_STATE_PADDING;
+        pad->flags = 0;
+        if (buf->mode == BI_BUFFER_MODE_MPSC) {
+            atomic_store_uchar(bi_buffer_slot_state(r, writeIndex), MSG_STATE_PADDING);
+        }
+        writeIndex += span - frameSize;
+    }
+
+    // Frame stays FREE while the producer fills it in place
+    BiBufferFrame* frame = bi_buffer_frame_at(r, writeIndex);
+    frame->state = MSG_STATE_FREE;
+    frame->flags = 0;
+    frame->length = (uint32_t)size;
+    frame->sequence = 0;
+    frame->checksum = 0;
+    BI_BUFFER_TRACE(buf, UMSBB_TRACE_CLAIM, writeIndex & bi_buffer_region_mask(r));
+    return (uint8_t*)frame + sizeof(BiBufferFrame);
+}
+
+/*
+ * Producer half of a resize, run at a claim so the switch lands on a frame
+ * boundary: seal the current region at writeIndex and continue in the
+ * pending one from writeIndex + BI_BUFFER_REGION_GAP. In MPSC mode one
+ * producer wins `pending` and parks writeIndex first.
+ */
+static void bi_buffer_switch_region(BiBuffer* buf) {
+    size_t pending = atomic_load_size_acquire(&buf->pending);
+    if (pending == 0) return;
+
+    size_t writeIndex;
+    if (buf->mode == BI_BUFFER_MODE_MPSC) {
+        if (!atomic_cas_size(&buf->pending, &pending, 0)) return;
+        writeIndex = atomic_load_size(&buf->writeIndex);
+        while (!atomic_cas_size(&buf->writeIndex, &writeIndex, writeIndex | BI_BUFFER_SWITCHING)) {}
+    } else {
+        atomic_store_size(&buf->pending, 0);
+        writeIndex = atomic_load_size_relaxed(&buf->writeIndex);
+    }
+
+    BiBufferRegion* old = &buf->regions[atomic_load_size_relaxed(&buf->produce)];
+    BiBufferRegion* next = &buf->regions[pending - 1];
+    size_t base = writeIndex + BI_BUFFER_REGION_GAP;
+    atomic_store_size_relaxed(&next->base, base);
+
+    // The consumer follows `next` once it reaches the seal
+    atomic_store_size(&old->next, pending - 1);
+    atomic_store_size_release(&old->sealIndex, writeIndex);
+    atomic_store_size_release(&buf->produce, pending - 1);
+
+    if (buf->mode == BI_BUFFER_MODE_MPSC) {
+        atomic_store_size_release(&buf->writeIndex, base);
+        return;
+    }
+    // Nothing is claimed between commits, so the gap counts as committed;
+    // publishing it after the seal lets the consumer see the seal first
+    atomic_store_size_release(&buf->writeIndex, base);
+    atomic_store_size_release(&buf->commitIndex, base);
+}
+
+static void* bi_buffer_claim_mpsc(BiBuffer* buf, size_t frameSize, size_t size) {
+    // Reserve [writeIndex, writeIndex + span) with a CAS so concurrent
+    // producers never receive overlapping frames
+    size_t writeIndex = atomic_load_size_acquire(&buf->writeIndex);
+    for (;;) {
+        if (writeIndex & BI_BUFFER_SWITCHING) {
+            // Another producer is a few stores away from finishing a switch
+            writeIndex = atomic_load_size_acquire(&buf->writeIndex);
+            continue;
+        }
+        BiBufferRegion* r = &buf->regions[atomic_load_size_acquire(&buf->produce)];
+        if (bi_buffer_before(writeIndex, bi_buffer_region_base(r))) {
+            // writeIndex predates the region we just loaded
+            writeIndex = atomic_load_size_acquire(&buf->writeIndex);
+            continue;
+        }
+
+        size_t readIndex = atomic_load_size_acquire(&buf->readIndex);
+        size_t span = bi_buffer_span(r, writeIndex, frameSize);
+        if (span == 0 || bi_buffer_used(r, writeIndex, readIndex) + span > bi_buffer_region_capacity(r)) {
+            // Only report full for a current snapshot, not one a switch made stale
+            size_t current = atomic_load_size_acquire(&buf->writeIndex);
+            if (current == writeIndex) return NULL;
+            writeIndex = current;
+            continue;
+        }
+        if (atomic_cas_size(&buf->writeIndex, &writeIndex, writeIndex + span)) {
+            return bi_buffer_place(buf, r, writeIndex, span, frameSize, size);
+        }
+    }
+}
+
+void* bi_buffer_claim(BiBuffer* buf, size_t size) {
+    if (size > UINT32_MAX) return NULL;
+    if (atomic_load_size_relaxed(&buf->pending) != 0) bi_buffer_switch_region(buf);
+
+    size_t frameSize = BI_BUFFER_FRAME_SIZE(size);
+    if (buf->mode == BI_BUFFER_MODE_MPSC) return bi_buffer_claim_mpsc(buf, frameSize, size);
+
+    BiBufferRegion* r = &buf->regions[atomic_load_size_relaxed(&buf->produce)];
+    size_t writeIndex = atomic_load_size_relaxed(&buf->writeIndex);
+    size_t span = bi_buffer_span(r, writeIndex, frameSize);
+    if (span == 0) return NULL;
+
+    if (buf->mode == BI_BUFFER_MODE_SPSC) {
+        // Trust the cached readIndex unless the ring looks full
+        if (bi_buffer_used(r, writeIndex, buf->cachedReadIndex) + span > bi_buffer_region_capacity(r)) {
+            buf->cachedReadIndex = atomic_load_size_acquire(&buf->readIndex);
+            if (bi_buffer_used(r, writeIndex, buf->cachedReadIndex) + span > bi_buffer_region_capacity(r)) {
+                return NULL;
+            }
+        }
+    } else {
+        size_t readIndex = atomic_load_size(&buf->readIndex);
+        if (bi_buffer_used(r, writeIndex, readIndex) + span > bi_buffer_region_capacity(r)) {
+            return NULL;
+        }
+    }
+
+    return bi_buffer_place(buf, r, writeIndex, span, frameSize, size);
+}
+
+/* Mark `span` bytes at `offset` of `r` as a frame consumers pass over (MPSC). */
+static void bi_buffer_publish_skip(BiBufferRegion* r, size_t offset, size_t span) {
+    BiBufferFrame* skip = bi_buffer_frame_at(r, offset);
+    skip->length = (uint32_t)(span - sizeof(BiBufferFrame));
+    skip->flags = 0;
+    skip->state = MSG_STATE_SKIP;
+    atomic_store_uchar(bi_buffer_slot_state(r, offset), MSG_STATE_SKIP);
+}
+
+void bi_buffer_commit(BiBuffer* buf, void* ptr, size_t size) {
+    BiBufferFrame* frame = bi_buffer_frame(ptr);
+    size_t claimed = BI_BUFFER_FRAME_SIZE(frame->length);
+    frame->length = (uint32_t)size;
+
+    // Transition state: FREE → READY (ready for consumption)
+    frame->state = MSG_STATE_READY;
+
+    if (buf->mode == BI_BUFFER_MODE_MPSC) {
+        // Out-of-order commit: publish this frame only; writeIndex already moved.
+        // The frame may sit in a region another producer has since sealed.
+        BiBufferRegion* r = bi_buffer_region_of(buf, frame);
+        size_t offset = (size_t)((uint8_t*)frame - bi_buffer_region_storage(r));
+        // The reservation keeps its extent: a shorter frame leaves a skip
+        // behind it, published first so the consumer never waits on it
+        size_t used = BI_BUFFER_FRAME_SIZE(size);
+        if (used < claimed) bi_buffer_publish_skip(r, offset + used, claimed - used);
+        atomic_store_uchar(bi_buffer_slot_state(r, offset), MSG_STATE_READY);
+        BI_BUFFER_TRACE(buf, UMSBB_TRACE_COMMIT, offset);
+        return;
+    }
+
+    // Distance from the current write position, including any wrap padding
+    BiBufferRegion* r = &buf->regions[atomic_load_size_relaxed(&buf->produce)];
+    size_t offset = (size_t)((uint8_t*)frame - bi_buffer_region_storage(r));
+    size_t writeIndex = atomic_load_size_relaxed(&buf->writeIndex);
+    size_t mask = bi_buffer_region_mask(r);
+    size_t next = writeIndex + ((offset - (writeIndex & mask)) & mask)
+                + BI_BUFFER_FRAME_SIZE(size);
+    BI_BUFFER_TRACE(buf, UMSBB_TRACE_COMMIT, offset);
+    if (buf->mode == BI_BUFFER_MODE_SPSC) {
+        atomic_store_size_release(&buf->writeIndex, next);
+        atomic_store_size_release(&buf->commitIndex, next);
+        return;
+    }
+    atomic_store_size(&buf->writeIndex, next);
+    atomic_store_size(&buf->commitIndex, next);
+}
+
+void bi_buffer_cancel(BiBuffer* buf, void* ptr) {
+    // A single-producer claim moves no index, so the next claim reuses it
+    if (buf->mode != BI_BUFFER_MODE_MPSC) return;
+
+    BiBufferFrame* frame = bi_buffer_frame(ptr);
+    BiBufferRegion* r = bi_buffer_region_of(buf, frame);
+    size_t offset = (size_t)((uint8_t*)frame - bi_buffer_region_storage(r));
+    bi_buffer_publish_skip(r, offset, BI_BUFFER_FRAME_SIZE(frame->length));
+}
+
+/*
+ * Consumer reached the seal of its region: every frame in it has been
+ * released and no producer can reserve there again, so free the storage
+ * and continue at the successor's base. Returns the new readIndex.
+ */
+static size_t bi_buffer_retire_region(BiBuffer* buf) {
+    BiBufferRegion* old = &buf->regions[buf->consume];
+    size_t next = atomic_load_size(&old->next);
+    bi_buffer_region_free(old);
+    atomic_store_size_release(&old->inUse, 0);
+    buf->consume = next;
+
+    size_t readIndex = bi_buffer_region_base(&buf->regions[next]);
+    atomic_store_size_release(&buf->readIndex, readIndex);
+    return readIndex;
+}
+
+/* Region holding `*index`, stepping the index over any seal it sits on. */
+static BiBufferRegion* bi_buffer_locate(BiBuffer* buf, size_t* index) {
+    BiBufferRegion* r = &buf->regions[buf->consume];
+    for (;;) {
+        size_t seal = atomic_load_size_acquire(&r->sealIndex);
+        if (seal == BI_BUFFER_UNSEALED || bi_buffer_before(*index, seal)) return r;
+        BiBufferRegion* next = &buf->regions[atomic_load_size(&r->next)];
+        if (*index == seal) *index = bi_buffer_region_base(next);
+        r = next;
+    }
+}
+
+static void* bi_buffer_read_mpsc(BiBuffer* buf, size_t* size) {
     size_t readIndex = atomic_load_size(&buf->readIndex);
-    size_t commitIndex = atomic_load_size(&buf->commitIndex);
-    
-    if (readIndex >= commitIndex) return NULL;
+    BiBufferRegion* r = &buf->regions[buf->consume];
+    unsigned char state;
+    for (;;) {
+        if (readIndex == atomic_load_size_acquire(&r->sealIndex)) {
+            readIndex = bi_buffer_retire_region(buf);
+            r = &buf->regions[buf->consume];
+        }
+        state = atomic_load_uchar(bi_buffer_slot_state(r, readIndex));
+        if (state != MSG_STATE_PADDING && state != MSG_STATE_SKIP) break;
+
+        // Pass over the unused tail or an abandoned/trimmed reservation
+        atomic_store_uchar(bi_buffer_slot_state(r, readIndex), MSG_STATE_FREE);
+        readIndex += (state == MSG_STATE_PADDING)
+            ? bi_buffer_region_capacity(r) - (readIndex & bi_buffer_region_mask(r))
+            : BI_BUFFER_FRAME_SIZE(bi_buffer_frame_at(r, readIndex)->length);
+        atomic_store_size_release(&buf->readIndex, readIndex);
+    }
+
+    // Reserved-but-uncommitted frames stay FREE here, so the consumer only
+    // ever advances across a contiguous run of committed frames
+    if (state != MSG_STATE_READY) return NULL;
+
+    BiBufferFrame* frame = bi_buffer_frame_at(r, readIndex);
+    *size = frame->length;
+    BI_BUFFER_TRACE(buf, UMSBB_TRACE_DRAIN, readIndex & bi_buffer_region_mask(r));
+    return (uint8_t*)frame + sizeof(BiBufferFrame);
+}
+
+void* bi_buffer_read(BiBuffer* buf, size_t* size) {
+    if (buf->mode == BI_BUFFER_MODE_MPSC) return bi_buffer_read_mpsc(buf, size);
+
+    size_t readIndex;
+    size_t commitIndex;
+    if (buf->mode == BI_BUFFER_MODE_SPSC) {
+        // Trust the cached commitIndex unless the ring looks empty
+        readIndex = atomic_load_size_relaxed(&buf->readIndex);
+        if (readIndex == buf->cachedCommitIndex) {
+            buf->cachedCommitIndex = atomic_load_size_acquire(&buf->commitIndex);
+        }
+        commitIndex = buf->cachedCommitIndex;
+    } else {
+        readIndex = atomic_load_size(&buf->readIndex);
+        commitIndex = atomic_load_size(&buf->commitIndex);
+    }
     
-    // Check if message is in CONSUMING state (ready to read)
-    MessageState state = bi_buffer_get_message_state(buf, readIndex);
-    if (state != MSG_STATE_CONSUMING) return NULL;
+    if (readIndex == commitIndex) return NULL;
+
+    // The seal is published before commitIndex moves past it
+    BiBufferRegion* r = &buf->regions[buf->consume];
+    if (readIndex == atomic_load_size_acquire(&r->sealIndex)) {
+        readIndex = bi_buffer_retire_region(buf);
+        r = &buf->regions[buf->consume];
+        if (readIndex == commitIndex) return NULL;
+    }
     
-    // For message-based reading, return the next complete message
-    size_t availableBytes = commitIndex - readIndex;
-    if (availableBytes < sizeof(MessageCapsule)) return NULL;
+    BiBufferFrame* frame = bi_buffer_frame_at(r, readIndex);
+    if (frame->state == MSG_STATE_PADDING) {
+        // Skip the unused tail; the next frame starts at offset 0
+        readIndex += bi_buffer_region_capacity(r) - (readIndex & bi_buffer_region_mask(r));
+        atomic_store_size_release(&buf->readIndex, readIndex);
+        if (readIndex == commitIndex) return NULL;
+        frame = bi_buffer_frame_at(r, readIndex);
+    }
+    if (frame->state != MSG_STATE_READY && frame->state != MSG_STATE_CONSUMING) return NULL;
     
-    *size = sizeof(MessageCapsule);
-    return (uint8_t*)buf->regionA + readIndex;
+    *size = frame->length;
+    BI_BUFFER_TRACE(buf, UMSBB_TRACE_DRAIN, readIndex & bi_buffer_region_mask(r));
+    return (uint8_t*)frame + sizeof(BiBufferFrame);
 }
 
 void bi_buffer_release(BiBuffer* buf) {
-    size_t readIndex = atomic_load_size(&buf->readIndex);
+    size_t readIndex = atomic_load_size_relaxed(&buf->readIndex);
+    BiBufferRegion* r = &buf->regions[buf->consume];
+    BiBufferFrame* frame = bi_buffer_frame_at(r, readIndex);
     
-    // Transition: CONSUMING → FEEDBACK
-    bi_buffer_set_message_state(buf, readIndex, MSG_STATE_FEEDBACK);
-    atomic_store_size(&buf->readIndex, readIndex + sizeof(MessageCapsule));
-    
-    // After feedback is processed, transition back to FREE for recycling
+    // Transition: CONSUMING → FEEDBACK → FREE for recycling
+    frame->state = MSG_STATE_FEEDBACK;
+    size_t frameSize = BI_BUFFER_FRAME_SIZE(frame->length);
+    frame->state = MSG_STATE_FREE;
+    if (buf->mode == BI_BUFFER_MODE_MPSC) {
+        atomic_store_uchar(bi_buffer_slot_state(r, readIndex), MSG_STATE_FREE);
+    }
+    BI_BUFFER_TRACE(buf, UMSBB_TRACE_RELEASE, readIndex & bi_buffer_region_mask(r));
+    atomic_store_size_release(&buf->readIndex, readIndex + frameSize);
     bi_buffer_advance_feedback(buf);
-    bi_buffer_set_message_state(buf, readIndex, MSG_STATE_FREE);
 }
 
-void bi_buffer_resize(BiBuffer* buf, size_t newCap) {
-    soma_aligned_free(buf->regionA);
-    soma_aligned_free(buf->regionB);
-    soma_aligned_free(buf->regionC);
-    buf->capacity = newCap;
-    buf->regionA = soma_aligned_alloc(SOMA_ALIGNMENT, newCap);
-    buf->regionB = soma_aligned_alloc(SOMA_ALIGNMENT, newCap);
-    buf->regionC = soma_aligned_alloc(SOMA_ALIGNMENT, newCap / 4);
-    atomic_store_size(&buf->writeIndex, 0);
-    atomic_store_size(&buf->readIndex, 0);
-    atomic_store_size(&buf->commitIndex, 0);
-    atomic_store_size(&buf->feedbackIndex, 0);
-    memset(buf->regionC, MSG_STATE_FREE, newCap / 4);
+size_t bi_buffer_read_cursor(BiBuffer* buf) {
+    return atomic_load_size_relaxed(&buf->readIndex);
+}
+
+/* True if the frame (or padding) starting at `index` in `r` has been published. */
+static bool bi_buffer_committed(BiBuffer* buf, BiBufferRegion* r, size_t index) {
+    switch (buf->mode) {
+    case BI_BUFFER_MODE_MPSC:
+        // A full lap ahead aliases the unreleased frame at readIndex
+        if (bi_buffer_used(r, index, atomic_load_size_relaxed(&buf->readIndex)) >= bi_buffer_region_capacity(r)) return false;
+        return atomic_load_uchar(bi_buffer_slot_state(r, index)) != MSG_STATE_FREE;
+    case BI_BUFFER_MODE_SPSC:
+        if (index == buf->cachedCommitIndex) {
+            buf->cachedCommitIndex = atomic_load_size_acquire(&buf->commitIndex);
+        }
+        return index != buf->cachedCommitIndex;
+    default:
+        return index != atomic_load_size(&buf->commitIndex);
+    }
+}
+
+/* Region of the committed frame at `*index` (moved over a seal if needed), or NULL. */
+static BiBufferRegion* bi_buffer_locate_committed(BiBuffer* buf, size_t* index) {
+    // Single-producer modes publish the seal before commitIndex passes it,
+    // so commitIndex has to be checked before the seal is looked at
+    if (buf->mode != BI_BUFFER_MODE_MPSC && !bi_buffer_committed(buf, NULL, *index)) return NULL;
+
+    size_t start = *index;
+    BiBufferRegion* r = bi_buffer_locate(buf, index);
+    if ((buf->mode == BI_BUFFER_MODE_MPSC || *index != start) && !bi_buffer_committed(buf, r, *index)) {
+        return NULL;
+    }
+    return r;
+}
+
+void* bi_buffer_peek(BiBuffer* buf, size_t* cursor, size_t* size) {
+    size_t index = *cursor;
+    BiBufferRegion* r = bi_buffer_locate_committed(buf, &index);
+    *cursor = index;
+    if (!r) return NULL;
+
+    BiBufferFrame* frame = bi_buffer_frame_at(r, index);
+    while (frame->state == MSG_STATE_PADDING || frame->state == MSG_STATE_SKIP) {
+        // bi_buffer_release_to frees what the cursor passes over
+        index += (frame->state == MSG_STATE_PADDING)
+            ? bi_buffer_region_capacity(r) - (index & bi_buffer_region_mask(r))
+            : BI_BUFFER_FRAME_SIZE(frame->length);
+        *cursor = index;
+        if (!bi_buffer_committed(buf, r, index)) return NULL;
+        frame = bi_buffer_frame_at(r, index);
+    }
+
+    *size = frame->length;
+    *cursor = index + BI_BUFFER_FRAME_SIZE(frame->length);
+    BI_BUFFER_TRACE(buf, UMSBB_TRACE_DRAIN, index & bi_buffer_region_mask(r));
+    return (uint8_t*)frame + sizeof(BiBufferFrame);
+}
+
+void bi_buffer_release_to(BiBuffer* buf, size_t cursor) {
+    size_t readIndex = atomic_load_size_relaxed(&buf->readIndex);
+    if (cursor == readIndex) return;
+
+    BiBufferRegion* r = &buf->regions[buf->consume];
+    // One record for the batch, keyed by its first frame
+    BI_BUFFER_TRACE(buf, UMSBB_TRACE_RELEASE, readIndex & bi_buffer_region_mask(r));
+    while (readIndex != cursor) {
+        size_t seal = atomic_load_size_acquire(&r->sealIndex);
+        if (readIndex == seal) {
+            // The batch crossed into the next region
+            readIndex = bi_buffer_retire_region(buf);
+            r = &buf->regions[buf->consume];
+            continue;
+        }
+        if (buf->mode != BI_BUFFER_MODE_MPSC) {
+            // No per-frame flags: jump to the cursor or to this region's seal
+            readIndex = (seal == BI_BUFFER_UNSEALED || !bi_buffer_before(seal, cursor)) ? cursor : seal;
+            continue;
+        }
+
+        // Clear the per-frame commit flags so the slots can be reused
+        BiBufferFrame* frame = bi_buffer_frame_at(r, readIndex);
+        atomic_store_uchar(bi_buffer_slot_state(r, readIndex), MSG_STATE_FREE);
+        readIndex += (frame->state == MSG_STATE_PADDING)
+            ? bi_buffer_region_capacity(r) - (readIndex & bi_buffer_region_mask(r))
+            : BI_BUFFER_FRAME_SIZE(frame->length);
+        frame->state = MSG_STATE_FREE;
+    }
+
+    atomic_store_size_release(&buf->readIndex, cursor);
+    bi_buffer_advance_feedback(buf);
+}
+
+size_t bi_buffer_cursor_after(BiBuffer* buf, const void* payload) {
+    BiBufferFrame* frame = bi_buffer_frame((void*)payload);
+    BiBufferRegion* r = bi_buffer_region_of(buf, frame);
+
+    // Every unreleased frame of `r` lies within one capacity of this index
+    size_t readIndex = atomic_load_size_relaxed(&buf->readIndex);
+    size_t base = bi_buffer_region_base(r);
+    size_t mask = bi_buffer_region_mask(r);
+    size_t low = bi_buffer_before(readIndex, base) ? base : readIndex;
+    size_t offset = (size_t)((uint8_t*)frame - bi_buffer_region_storage(r));
+    return low + ((offset - (low & mask)) & mask) + BI_BUFFER_FRAME_SIZE(frame->length);
+}
+
+bool bi_buffer_resize(BiBuffer* buf, size_t newCap) {
+    if (atomic_load_size(&buf->pending) != 0) return false;
+
+    for (size_t i = 0; i < BI_BUFFER_MAX_REGIONS; ++i) {
+        BiBufferRegion* r = &buf->regions[i];
+        size_t expected = 0;
+        if (atomic_load_size_acquire(&r->inUse) != 0) continue;
+        if (!atomic_cas_size(&r->inUse, &expected, 1)) continue;
+
+        if (!bi_buffer_region_alloc(r, newCap, 0)) {
+            atomic_store_size_release(&r->inUse, 0);
+            return false;
+        }
+        // Producers pick the region up at their next claim
+        expected = 0;
+        while (!atomic_cas_size(&buf->pending, &expected, i + 1)) {
+            if (expected != 0) {
+                // Lost to a concurrent resize
+                bi_buffer_region_free(r);
+                atomic_store_size_release(&r->inUse, 0);
+                return false;
+            }
+        }
+        return true;
+    }
+    // Every slot still holds a region the consumer has not drained
+    return false;
+}
+
+size_t bi_buffer_capacity(BiBuffer* buf) {
+    return bi_buffer_region_capacity(&buf->regions[atomic_load_size_acquire(&buf->produce)]);
+}
+
+size_t bi_buffer_target_capacity(BiBuffer* buf) {
+    size_t pending = atomic_load_size_acquire(&buf->pending);
+    return pending ? bi_buffer_region_capacity(&buf->regions[pending - 1]) : bi_buffer_capacity(buf);
+}
+
+size_t bi_buffer_backlog(BiBuffer* buf) {
+    size_t writeIndex = atomic_load_size_relaxed(&buf->writeIndex) & ~BI_BUFFER_SWITCHING;
+    size_t readIndex = atomic_load_size_relaxed(&buf->readIndex);
+    return writeIndex > readIndex ? writeIndex - readIndex : 0;
 }
 
 void bi_buffer_destroy(BiBuffer* buf) {
     if (!buf) return;
-    if (buf->regionA) soma_aligned_free(buf->regionA);
-    if (buf->regionB) soma_aligned_free(buf->regionB);
-    if (buf->regionC) soma_aligned_free(buf->regionC);
-    buf->regionA = NULL;
-    buf->regionB = NULL;
-    buf->regionC = NULL;
-    buf->capacity = 0;
+    for (size_t i = 0; i < BI_BUFFER_MAX_REGIONS; ++i) {
+        bi_buffer_region_free(&buf->regions[i]);
+        atomic_store_size(&buf->regions[i].capacity, 0);
+        atomic_store_size(&buf->regions[i].mask, 0);
+        atomic_store_size(&buf->regions[i].inUse, 0);
+    }
+    atomic_store_size(&buf->pending, 0);
 }
 
 /* State machine operations */
 MessageState bi_buffer_get_message_state(BiBuffer* buf, size_t offset) {
-    size_t stateIndex = offset / sizeof(MessageCapsule);
-    if (stateIndex >= buf->capacity / 4) return MSG_STATE_FREE;
-    return ((MessageState*)buf->regionC)[stateIndex];
+    BiBufferRegion* r = &buf->regions[buf->consume];
+    if (!bi_buffer_region_storage(r)) return MSG_STATE_FREE;
+    return (MessageState)bi_buffer_frame_at(r, offset)->state;
 }
 
 void bi_buffer_set_message_state(BiBuffer* buf, size_t offset, MessageState state) {
-    size_t stateIndex = offset / sizeof(MessageCapsule);
-    if (stateIndex < buf->capacity / 4) {
-        ((MessageState*)buf->regionC)[stateIndex] = state;
+    BiBufferRegion* r = &buf->regions[buf->consume];
+    if (bi_buffer_region_storage(r)) {
+        bi_buffer_frame_at(r, offset)->state = state;
     }
 }
 
 bool bi_buffer_can_claim(BiBuffer* buf, size_t size) {
-    size_t writeIndex = atomic_load_size(&buf->writeIndex);
-    return (writeIndex + size <= buf->capacity);
+    BiBufferRegion* r = &buf->regions[atomic_load_size_acquire(&buf->produce)];
+    size_t writeIndex = atomic_load_size(&buf->writeIndex) & ~BI_BUFFER_SWITCHING;
+    size_t readIndex = atomic_load_size(&buf->readIndex);
+    size_t span = bi_buffer_span(r, writeIndex, BI_BUFFER_FRAME_SIZE(size));
+    return span != 0 && bi_buffer_used(r, writeIndex, readIndex) + span <= bi_buffer_region_capacity(r);
 }
 
 void bi_buffer_advance_feedback(BiBuffer* buf) {
-    size_t readIndex = atomic_load_size(&buf->readIndex);
-    bi_buffer_set_message_state(buf, readIndex, MSG_STATE_FEEDBACK);
-    atomic_store_size(&buf->feedbackIndex, readIndex + sizeof(MessageCapsule));
-}
\ No newline at end of file
+    atomic_store_size(&buf->feedbackIndex, atomic_load_size(&buf->readIndex));
+}
@@ -1,16 +1,15 @@
 #include "capsule.h"
+#include "checksum_engine.h"
+#include "umsbb_clock.h"
 #include <string.h>
-#include <time.h>
 
 uint32_t capsule_checksum(const char* data, size_t size) {
-    uint32_t sum = 0;
-    for (size_t i = 0; i < size; ++i) sum += (uint8_t)data[i];
-    return sum;
+    return checksum_compute(CHECKSUM_POLICY_FAST, data, size);
 }
 
 void capsule_wrap(MessageCapsule* cap, uint32_t seq, const char* msg, size_t size) {
     cap->header.sequence = seq;
-    cap->header.timestamp = (uint64_t)time(NULL);
+    cap->header.timestamp = umsbb_clock_coarse_ns();
     cap->header.checksum = capsule_checksum(msg, size);
 
     cap->payload = (char*)msg;
@@ -0,0 +1,516 @@
+#include "checksum_engine.h"
+#include "portable_atomic.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#  define CHECKSUM_X86 1
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  endif
+#  include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#  define CHECKSUM_ARM64 1
+#  include <arm_acle.h>
+#  if defined(__linux__) && !defined(__ARM_FEATURE_CRC32)
+#    include <sys/auxv.h>
+#    ifndef HWCAP_CRC32
+#      define HWCAP_CRC32 (1 << 7)
+#    endif
+#  endif
+#endif
+
+#if defined(__wasm_simd128__)
+#  include <wasm_simd128.h>
+#endif
+
+/* Target attributes so one binary can carry every x86 path. */
+#if defined(CHECKSUM_X86) && (defined(__GNUC__) || defined(__clang__))
+#  define CHECKSUM_TARGET(t) __attribute__((target(t)))
+#  define CHECKSUM_HAVE_SSE42 1
+#  define CHECKSUM_HAVE_AVX2 1
+#  if defined(__SSE2__)
+#    define CHECKSUM_HAVE_SSE2 1
+#  endif
+#elif defined(CHECKSUM_X86) && defined(_MSC_VER)
+#  define CHECKSUM_TARGET(t)
+#  define CHECKSUM_HAVE_SSE42 1
+#  define CHECKSUM_HAVE_AVX2 1
+#  if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define CHECKSUM_HAVE_SSE2 1
+#  endif
+#else
+#  define CHECKSUM_TARGET(t)
+#endif
+
+/* ---- Loads and constants ---- */
+
+static inline uint64_t checksum_read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+#define PRIME32_1 0x9E3779B1u
+#define PRIME32_2 0x85EBCA77u
+#define PRIME32_3 0xC2B2AE3Du
+#define PRIME64_1 0x9E3779B185EBCA87ull
+#define PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define PRIME64_3 0x165667B19E3779F9ull
+#define PRIME64_4 0x85EBCA77C2B2AE63ull
+#define PRIME64_5 0x27D4EB2F165667C5ull
+
+#define FAST_LANES 8
+#define FAST_STRIPE 64
+#define FAST_STRIPES_PER_BLOCK 16
+
+/* Each stripe in a block uses the secret shifted by one lane, as in XXH3. */
+static const uint64_t fast_secret[FAST_LANES + FAST_STRIPES_PER_BLOCK] = {
+    0xBE4BA423396CFEB8ull, 0x1CAD21F72C81017Cull, 0xDB979083E96DD4DEull, 0x1F67B3B7A4A44072ull,
+    0x78E5C0CC4EE679CBull, 0x2172FFCC7DD05A82ull, 0x8E2443F7744608B8ull, 0x4C263A81E69035E0ull,
+    0xCB00C391BB52283Cull, 0xA32E531B8B65D088ull, 0x4EF90DA297486471ull, 0xD8ACDEA946EF1938ull,
+    0x3F349CE33F76FAA8ull, 0x1D4F0BC7C7BBDCF9ull, 0x3159B4CD4BE0518Aull, 0x647378D9C97E9FC8ull,
+    0xC3EBD33483ACC5EAull, 0xEB6313FAFFA081C5ull, 0x49DAF0B751DD0D17ull, 0x9E68D429265516D3ull,
+    0xFCA1477D58BE162Bull, 0xCE31D07AD1B8F88Full, 0x280416958F3ACB45ull, 0x7E404BBBCAFBD7AFull
+};
+
+static const uint64_t fast_init[FAST_LANES] = {
+    PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1
+};
+
+/* ---- CRC32C ---- */
+
+#define CRC32C_POLY 0x82F63B78u
+
+static uint32_t crc32c_table[8][256];
+
+static void crc32c_build_table(void) {
+    for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k) c = (c >> 1) ^ (CRC32C_POLY & (0u - (c & 1u)));
+        crc32c_table[0][n] = c;
+    }
+    for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = crc32c_table[0][n];
+        for (int t = 1; t < 8; ++t) {
+            c = crc32c_table[0][c & 0xFF] ^ (c >> 8);
+            crc32c_table[t][n] = c;
+        }
+    }
+}
+
+/* Slicing-by-8: eight table lookups per 64-bit word. */
+static uint32_t crc32c_scalar(uint32_t crc, const uint8_t* p, size_t size) {
+    while (size >= 8) {
+        uint64_t word = checksum_read64(p) ^ crc;
+        crc = crc32c_table[7][word & 0xFF] ^
+              crc32c_table[6][(word >> 8) & 0xFF] ^
+              crc32c_table[5][(word >> 16) & 0xFF] ^
+              crc32c_table[4][(word >> 24) & 0xFF] ^
+              crc32c_table[3][(word >> 32) & 0xFF] ^
+              crc32c_table[2][(word >> 40) & 0xFF] ^
+              crc32c_table[1][(word >> 48) & 0xFF] ^
+              crc32c_table[0][word >> 56];
+        p += 8;
+        size -= 8;
+    }
+    while (size--) crc = crc32c_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#if defined(CHECKSUM_HAVE_SSE42)
+CHECKSUM_TARGET("sse4.2")
+static uint32_t crc32c_sse42(uint32_t crc, const uint8_t* p, size_t size) {
+#if defined(__x86_64__) || defined(_M_X64)
+    uint64_t c = crc;
+    while (size >= 8) {
+        c = _mm_crc32_u64(c, checksum_read64(p));
+        p += 8;
+        size -= 8;
+    }
+    crc = (uint32_t)c;
+#endif
+    while (size >= 4) {
+        uint32_t word;
+        memcpy(&word, p, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+        p += 4;
+        size -= 4;
+    }
+    while (size--) crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+#endif
+
+#if defined(CHECKSUM_ARM64)
+#  if !defined(__ARM_FEATURE_CRC32)
+__attribute__((target("+crc")))
+#  endif
+static uint32_t crc32c_armv8(uint32_t crc, const uint8_t* p, size_t size) {
+    while (size >= 8) {
+        crc = __crc32cd(crc, checksum_read64(p));
+        p += 8;
+        size -= 8;
+    }
+    while (size--) crc = __crc32cb(crc, *p++);
+    return crc;
+}
+#endif
+
+/* ---- Fast 64-bit stripe hash ---- */
+
+/* Consumes every whole stripe in `data`, scrambling after each full block.
+ * Returns the number of stripes processed; all variants must agree bit for bit. */
+typedef size_t (*fast_stripes_fn)(uint64_t* acc, const uint8_t* data, size_t stripes);
+
+static inline void fast_accumulate_scalar(uint64_t* acc, const uint8_t* p, const uint64_t* secret) {
+    for (int i = 0; i < FAST_LANES; ++i) {
+        uint64_t d = checksum_read64(p + 8 * i);
+        uint64_t dk = d ^ secret[i];
+        acc[i ^ 1] += d;
+        acc[i] += (dk & 0xFFFFFFFFull) * (dk >> 32);
+    }
+}
+
+static inline void fast_scramble_scalar(uint64_t* acc) {
+    const uint64_t* secret = fast_secret + FAST_STRIPES_PER_BLOCK;
+    for (int i = 0; i < FAST_LANES; ++i) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= secret[i];
+        acc[i] = a * PRIME32_1;
+    }
+}
+
+static size_t fast_stripes_scalar(uint64_t* acc, const uint8_t* p, size_t stripes) {
+    for (size_t s = 0; s < stripes; ++s) {
+        size_t inBlock = s % FAST_STRIPES_PER_BLOCK;
+        fast_accumulate_scalar(acc, p + s * FAST_STRIPE, fast_secret + inBlock);
+        if (inBlock == FAST_STRIPES_PER_BLOCK - 1) fast_scramble_scalar(acc);
+    }
+    return stripes;
+}
+
+#if defined(CHECKSUM_HAVE_SSE2)
+CHECKSUM_TARGET("sse2")
+static size_t fast_stripes_sse2(uint64_t* acc, const uint8_t* p, size_t stripes) {
+    __m128i a[4];
+    for (int i = 0; i < 4; ++i) a[i] = _mm_loadu_si128((const __m128i*)(acc + 2 * i));
+    const __m128i prime = _mm_set1_epi32((int)PRIME32_1);
+
+    for (size_t s = 0; s < stripes; ++s) {
+        size_t inBlock = s % FAST_STRIPES_PER_BLOCK;
+        const uint8_t* stripe = p + s * FAST_STRIPE;
+        for (int i = 0; i < 4; ++i) {
+            __m128i d = _mm_loadu_si128((const __m128i*)(stripe + 16 * i));
+            __m128i k = _mm_loadu_si128((const __m128i*)(fast_secret + inBlock + 2 * i));
+            __m128i dk = _mm_xor_si128(d, k);
+            __m128i hi = _mm_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1));
+            __m128i product = _mm_mul_epu32(dk, hi);
+            __m128i swapped = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+            a[i] = _mm_add_epi64(a[i], _mm_add_epi64(product, swapped));
+        }
+        if (inBlock == FAST_STRIPES_PER_BLOCK - 1) {
+            for (int i = 0; i < 4; ++i) {
+                __m128i k = _mm_loadu_si128((const __m128i*)(fast_secret + FAST_STRIPES_PER_BLOCK + 2 * i));
+                __m128i x = _mm_xor_si128(_mm_xor_si128(a[i], _mm_srli_epi64(a[i], 47)), k);
+                __m128i lo = _mm_mul_epu32(x, prime);
+                __m128i hi = _mm_mul_epu32(_mm_srli_epi64(x, 32), prime);
+                a[i] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+            }
+        }
+    }
+    for (int i = 0; i < 4; ++i) _mm_storeu_si128((__m128i*)(acc + 2 * i), a[i]);
+    return stripes;
+}
+#endif
+
+#if defined(CHECKSUM_HAVE_AVX2)
+CHECKSUM_TARGET("avx2")
+static size_t fast_stripes_avx2(uint64_t* acc, const uint8_t* p, size_t stripes) {
+    __m256i a[2];
+    for (int i = 0; i < 2; ++i) a[i] = _mm256_loadu_si256((const __m256i*)(acc + 4 * i));
+    const __m256i prime = _mm256_set1_epi32((int)PRIME32_1);
+
+    for (size_t s = 0; s < stripes; ++s) {
+        size_t inBlock = s % FAST_STRIPES_PER_BLOCK;
+        const uint8_t* stripe = p + s * FAST_STRIPE;
+        for (int i = 0; i < 2; ++i) {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(stripe + 32 * i));
+            __m256i k = _mm256_loadu_si256((const __m256i*)(fast_secret + inBlock + 4 * i));
+            __m256i dk = _mm256_xor_si256(d, k);
+            __m256i hi = _mm256_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1));
+            __m256i product = _mm256_mul_epu32(dk, hi);
+            __m256i swapped = _mm256_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+            a[i] = _mm256_add_epi64(a[i], _mm256_add_epi64(product, swapped));
+        }
+        if (inBlock == FAST_STRIPES_PER_BLOCK - 1) {
+            for (int i = 0; i < 2; ++i) {
+                __m256i k = _mm256_loadu_si256((const __m256i*)(fast_secret + FAST_STRIPES_PER_BLOCK + 4 * i));
+                __m256i x = _mm256_xor_si256(_mm256_xor_si256(a[i], _mm256_srli_epi64(a[i], 47)), k);
+                __m256i lo = _mm256_mul_epu32(x, prime);
+                __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), prime);
+                a[i] = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+            }
+        }
+    }
+    for (int i = 0; i < 2; ++i) _mm256_storeu_si256((__m256i*)(acc + 4 * i), a[i]);
+    return stripes;
+}
+#endif
+
+#if defined(__wasm_simd128__)
+static size_t fast_stripes_wasm(uint64_t* acc, const uint8_t* p, size_t stripes) {
+    v128_t a[4];
+    for (int i = 0; i < 4; ++i) a[i] = wasm_v128_load(acc + 2 * i);
+    const v128_t low32 = wasm_i64x2_splat(0xFFFFFFFFll);
+    const v128_t prime = wasm_i64x2_splat((int64_t)PRIME32_1);
+
+    for (size_t s = 0; s < stripes; ++s) {
+        size_t inBlock = s % FAST_STRIPES_PER_BLOCK;
+        const uint8_t* stripe = p + s * FAST_STRIPE;
+        for (int i = 0; i < 4; ++i) {
+            v128_t d = wasm_v128_load(stripe + 16 * i);
+            v128_t dk = wasm_v128_xor(d, wasm_v128_load(fast_secret + inBlock + 2 * i));
+            v128_t product = wasm_i64x2_mul(wasm_v128_and(dk, low32), wasm_u64x2_shr(dk, 32));
+            v128_t swapped = wasm_i64x2_shuffle(d, d, 1, 0);
+            a[i] = wasm_i64x2_add(a[i], wasm_i64x2_add(product, swapped));
+        }
+        if (inBlock == FAST_STRIPES_PER_BLOCK - 1) {
+            for (int i = 0; i < 4; ++i) {
+                v128_t k = wasm_v128_load(fast_secret + FAST_STRIPES_PER_BLOCK + 2 * i);
+                v128_t x = wasm_v128_xor(wasm_v128_xor(a[i], wasm_u64x2_shr(a[i], 47)), k);
+                a[i] = wasm_i64x2_mul(x, prime);
+            }
+        }
+    }
+    for (int i = 0; i < 4; ++i) wasm_v128_store(acc + 2 * i, a[i]);
+    return stripes;
+}
+#endif
+
+/* ---- Runtime dispatch ---- */
+
+typedef uint32_t (*crc32c_fn)(uint32_t crc, const uint8_t* p, size_t size);
+
+static crc32c_fn crc32c_impl_fn = crc32c_scalar;
+static fast_stripes_fn fast_impl_fn = fast_stripes_scalar;
+static checksum_impl_t crc32c_impl_id = CHECKSUM_IMPL_SCALAR;
+static checksum_impl_t fast_impl_id = CHECKSUM_IMPL_SCALAR;
+static atomic_size_t checksum_ready;
+#if defined(CHECKSUM_ARM64)
+static bool checksum_arm_crc;
+#endif
+
+#if defined(CHECKSUM_X86)
+static void checksum_cpu_features(bool* sse42, bool* avx2) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    *sse42 = (info[2] & (1 << 20)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    *avx2 = false;
+    if (osxsave && maxLeaf >= 7 && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        *avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    *sse42 = __builtin_cpu_supports("sse4.2");
+    *avx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+static void checksum_select(void) {
+    crc32c_build_table();
+
+#if defined(CHECKSUM_X86)
+    bool sse42 = false, avx2 = false;
+    checksum_cpu_features(&sse42, &avx2);
+#  if defined(CHECKSUM_HAVE_SSE42)
+    if (sse42) {
+        crc32c_impl_fn = crc32c_sse42;
+        crc32c_impl_id = CHECKSUM_IMPL_SSE42;
+    }
+#  endif
+#  if defined(CHECKSUM_HAVE_SSE2)
+    fast_impl_fn = fast_stripes_sse2;
+    fast_impl_id = CHECKSUM_IMPL_SSE2;
+#  endif
+#  if defined(CHECKSUM_HAVE_AVX2)
+    if (avx2) {
+        fast_impl_fn = fast_stripes_avx2;
+        fast_impl_id = CHECKSUM_IMPL_AVX2;
+    }
+#  endif
+#endif
+
+#if defined(CHECKSUM_ARM64)
+#  if defined(__ARM_FEATURE_CRC32)
+    bool crc = true;
+#  elif defined(__linux__)
+    bool crc = (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#  else
+    bool crc = false;
+#  endif
+    checksum_arm_crc = crc;
+    if (crc) {
+        crc32c_impl_fn = crc32c_armv8;
+        crc32c_impl_id = CHECKSUM_IMPL_ARMV8_CRC;
+    }
+#endif
+
+#if defined(__wasm_simd128__)
+    fast_impl_fn = fast_stripes_wasm;
+    fast_impl_id = CHECKSUM_IMPL_WASM_SIMD128;
+#endif
+}
+
+static bool checksum_x86_feature(checksum_impl_t impl) {
+#if defined(CHECKSUM_X86)
+    bool sse42 = false, avx2 = false;
+    checksum_cpu_features(&sse42, &avx2);
+    return impl == CHECKSUM_IMPL_SSE42 ? sse42 : impl == CHECKSUM_IMPL_AVX2 ? avx2 : false;
+#else
+    (void)impl;
+    return false;
+#endif
+}
+
+/* Selection is idempotent, so racing first callers just do it twice. */
+static inline void checksum_ensure_ready(void) {
+    if (atomic_load_size_acquire(&checksum_ready)) return;
+    checksum_select();
+    atomic_store_size_release(&checksum_ready, 1);
+}
+
+/* ---- Public API ---- */
+
+uint32_t checksum_crc32c(const void* data, size_t size) {
+    checksum_ensure_ready();
+    return ~crc32c_impl_fn(~0u, (const uint8_t*)data, size);
+}
+
+static inline uint64_t fast_merge(uint64_t h, uint64_t lane) {
+    lane *= PRIME64_2;
+    lane = (lane << 31) | (lane >> 33);
+    h ^= lane * PRIME64_1;
+    return ((h << 27) | (h >> 37)) * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t checksum_fast64(const void* data, size_t size) {
+    checksum_ensure_ready();
+    const uint8_t* p = (const uint8_t*)data;
+    uint64_t acc[FAST_LANES];
+    memcpy(acc, fast_init, sizeof(acc));
+
+    size_t stripes = size / FAST_STRIPE;
+    if (stripes) fast_impl_fn(acc, p, stripes);
+
+    // Zero-padded final stripe; the length in the seed keeps padding unambiguous
+    size_t tail = size % FAST_STRIPE;
+    if (tail) {
+        uint8_t last[FAST_STRIPE] = {0};
+        memcpy(last, p + stripes * FAST_STRIPE, tail);
+        fast_accumulate_scalar(acc, last, fast_secret + stripes % FAST_STRIPES_PER_BLOCK);
+    }
+
+    uint64_t h = (uint64_t)size * PRIME64_1;
+    for (int i = 0; i < FAST_LANES; ++i) h = fast_merge(h, acc[i]);
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ull;
+    h ^= h >> 32;
+    return h;
+}
+
+uint32_t checksum_compute(checksum_policy_t policy, const void* data, size_t size) {
+    switch (policy) {
+        case CHECKSUM_POLICY_STRONG: return checksum_crc32c(data, size);
+        case CHECKSUM_POLICY_FAST: {
+            uint64_t h = checksum_fast64(data, size);
+            return (uint32_t)(h ^ (h >> 32));
+        }
+        default: return 0;
+    }
+}
+
+bool checksum_verify(checksum_policy_t policy, const void* data, size_t size, uint32_t expected) {
+    if (policy == CHECKSUM_POLICY_NONE) return true;
+    return checksum_compute(policy, data, size) == expected;
+}
+
+checksum_impl_t checksum_crc32c_impl(void) {
+    checksum_ensure_ready();
+    return crc32c_impl_id;
+}
+
+checksum_impl_t checksum_fast_impl(void) {
+    checksum_ensure_ready();
+    return fast_impl_id;
+}
+
+bool checksum_force_impl(checksum_impl_t impl) {
+    checksum_ensure_ready();
+    switch (impl) {
+        case CHECKSUM_IMPL_SCALAR:
+            crc32c_impl_fn = crc32c_scalar;
+            crc32c_impl_id = CHECKSUM_IMPL_SCALAR;
+            fast_impl_fn = fast_stripes_scalar;
+            fast_impl_id = CHECKSUM_IMPL_SCALAR;
+            return true;
+#if defined(CHECKSUM_HAVE_SSE2)
+        case CHECKSUM_IMPL_SSE2:
+            fast_impl_fn = fast_stripes_sse2;
+            fast_impl_id = impl;
+            return true;
+#endif
+#if defined(CHECKSUM_HAVE_SSE42)
+        case CHECKSUM_IMPL_SSE42:
+            if (!checksum_x86_feature(impl)) return false;
+            crc32c_impl_fn = crc32c_sse42;
+            crc32c_impl_id = impl;
+            return true;
+#endif
+#if defined(CHECKSUM_HAVE_AVX2)
+        case CHECKSUM_IMPL_AVX2:
+            if (!checksum_x86_feature(impl)) return false;
+            fast_impl_fn = fast_stripes_avx2;
+            fast_impl_id = impl;
+            return true;
+#endif
+#if defined(CHECKSUM_ARM64)
+        case CHECKSUM_IMPL_ARMV8_CRC:
+            if (!checksum_arm_crc) return false;
+            crc32c_impl_fn = crc32c_armv8;
+            crc32c_impl_id = impl;
+            return true;
+#endif
+#if defined(__wasm_simd128__)
+        case CHECKSUM_IMPL_WASM_SIMD128:
+            fast_impl_fn = fast_stripes_wasm;
+            fast_impl_id = impl;
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* checksum_impl_name(checksum_impl_t impl) {
+    switch (impl) {
+        case CHECKSUM_IMPL_SCALAR: return "scalar";
+        case CHECKSUM_IMPL_SSE2: return "sse2";
+        case CHECKSUM_IMPL_SSE42: return "sse4.2";
+        case CHECKSUM_IMPL_AVX2: return "avx2";
+        case CHECKSUM_IMPL_ARMV8_CRC: return "armv8-crc";
+        case CHECKSUM_IMPL_WASM_SIMD128: return "wasm-simd128";
+        default: return "unknown";
+    }
+}
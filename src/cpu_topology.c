@@ -0,0 +1,257 @@
+#include "cpu_topology.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#elif defined(__linux__) && !defined(__EMSCRIPTEN__)
+#  include <dirent.h>
+#  include <linux/mempolicy.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#  define CPU_TOPOLOGY_SYSFS 1
+#else
+#  include <unistd.h>
+#endif
+
+static void cpu_topology_flat(cpu_topology_t* topology, uint32_t count) {
+    if (count == 0) count = 1;
+    if (count > CPU_TOPOLOGY_MAX_CPUS) count = CPU_TOPOLOGY_MAX_CPUS;
+    for (uint32_t i = 0; i < count; ++i) {
+        cpu_topology_cpu_t* cpu = &topology->cpus[i];
+        cpu->cpu = i;
+        cpu->core = i;
+        cpu->node = 0;
+        cpu->smt_index = 0;
+    }
+    topology->cpu_count = count;
+    topology->core_count = count;
+    topology->node_count = 1;
+}
+
+#if defined(CPU_TOPOLOGY_SYSFS)
+static bool read_text(const char* path, char* text, size_t size) {
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+    size_t length = fread(text, 1, size - 1, file);
+    fclose(file);
+    text[length] = '\0';
+    return length > 0;
+}
+
+static long read_number(const char* path, long fallback) {
+    char text[32];
+    return read_text(path, text, sizeof(text)) ? strtol(text, NULL, 10) : fallback;
+}
+
+/* Mark the CPUs of a sysfs list such as "0-3,8,10-11". */
+static void parse_cpu_list(const char* text, bool* cpus) {
+    const char* p = text;
+    while (*p) {
+        char* end;
+        unsigned long first = strtoul(p, &end, 10);
+        if (end == p) break;
+        unsigned long last = first;
+        if (*end == '-') {
+            p = end + 1;
+            last = strtoul(p, &end, 10);
+        }
+        for (unsigned long cpu = first; cpu <= last && cpu < CPU_TOPOLOGY_MAX_CPUS; ++cpu) cpus[cpu] = true;
+        p = *end == ',' ? end + 1 : end;
+        if (*end != ',') break;
+    }
+}
+
+static bool discover_sysfs(cpu_topology_t* topology) {
+    char text[4096];
+    bool online[CPU_TOPOLOGY_MAX_CPUS] = { false };
+    if (!read_text("/sys/devices/system/cpu/online", text, sizeof(text))) return false;
+    parse_cpu_list(text, online);
+
+    uint32_t node_of[CPU_TOPOLOGY_MAX_CPUS] = { 0 };
+    DIR* nodes = opendir("/sys/devices/system/node");
+    if (nodes) {
+        struct dirent* entry;
+        while ((entry = readdir(nodes))) {
+            unsigned node;
+            char tail;
+            if (sscanf(entry->d_name, "node%u%c", &node, &tail) != 1) continue;
+            char path[96];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+            bool members[CPU_TOPOLOGY_MAX_CPUS] = { false };
+            if (!read_text(path, text, sizeof(text))) continue;
+            parse_cpu_list(text, members);
+            for (uint32_t cpu = 0; cpu < CPU_TOPOLOGY_MAX_CPUS; ++cpu) {
+                if (members[cpu]) node_of[cpu] = node;
+            }
+        }
+        closedir(nodes);
+    }
+
+    long package[CPU_TOPOLOGY_MAX_CPUS];
+    long core_id[CPU_TOPOLOGY_MAX_CPUS];
+    uint32_t count = 0;
+    topology->core_count = 0;
+    topology->node_count = 1;
+    for (uint32_t cpu = 0; cpu < CPU_TOPOLOGY_MAX_CPUS; ++cpu) {
+        if (!online[cpu]) continue;
+        char path[96];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu);
+        package[count] = read_number(path, 0);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", cpu);
+        core_id[count] = read_number(path, (long)cpu);
+
+        cpu_topology_cpu_t* entry = &topology->cpus[count];
+        entry->cpu = cpu;
+        entry->node = node_of[cpu];
+        entry->smt_index = 0;
+        entry->core = UINT32_MAX;
+        // Hyperthreads share package and core id; earlier siblings number the core
+        for (uint32_t j = 0; j < count; ++j) {
+            if (package[j] == package[count] && core_id[j] == core_id[count]) {
+                entry->core = topology->cpus[j].core;
+                entry->smt_index++;
+            }
+        }
+        if (entry->core == UINT32_MAX) entry->core = topology->core_count++;
+        if (entry->node + 1 > topology->node_count) topology->node_count = entry->node + 1;
+        count++;
+    }
+    topology->cpu_count = count;
+    return count > 0;
+}
+#endif
+
+#if defined(_WIN32)
+static bool discover_windows(cpu_topology_t* topology) {
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, NULL, &length);
+    char* buffer = (char*)malloc(length);
+    if (!buffer) return false;
+    if (!GetLogicalProcessorInformationEx(RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer, &length)) {
+        free(buffer);
+        return false;
+    }
+
+    uint32_t node_of[CPU_TOPOLOGY_MAX_CPUS] = { 0 };
+    uint32_t core_of[CPU_TOPOLOGY_MAX_CPUS];
+    uint32_t smt_of[CPU_TOPOLOGY_MAX_CPUS];
+    bool present[CPU_TOPOLOGY_MAX_CPUS] = { false };
+    topology->core_count = 0;
+    topology->node_count = 1;
+
+    // Nodes first: entries come in no particular order
+    for (DWORD offset = 0; offset < length;) {
+        PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)(buffer + offset);
+        if (info->Relationship == RelationNumaNode) {
+            GROUP_AFFINITY* mask = &info->NumaNode.GroupMask;
+            for (uint32_t bit = 0; bit < 64; ++bit) {
+                uint32_t cpu = (uint32_t)mask->Group * 64 + bit;
+                if ((mask->Mask >> bit) & 1 && cpu < CPU_TOPOLOGY_MAX_CPUS) node_of[cpu] = info->NumaNode.NodeNumber;
+            }
+            if (info->NumaNode.NodeNumber + 1 > topology->node_count) topology->node_count = info->NumaNode.NodeNumber + 1;
+        }
+        offset += info->Size;
+    }
+    for (DWORD offset = 0; offset < length;) {
+        PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)(buffer + offset);
+        if (info->Relationship == RelationProcessorCore) {
+            uint32_t core = topology->core_count++;
+            uint32_t smt = 0;
+            for (WORD g = 0; g < info->Processor.GroupCount; ++g) {
+                GROUP_AFFINITY* mask = &info->Processor.GroupMask[g];
+                for (uint32_t bit = 0; bit < 64; ++bit) {
+                    uint32_t cpu = (uint32_t)mask->Group * 64 + bit;
+                    if (!((mask->Mask >> bit) & 1) || cpu >= CPU_TOPOLOGY_MAX_CPUS) continue;
+                    present[cpu] = true;
+                    core_of[cpu] = core;
+                    smt_of[cpu] = smt++;
+                }
+            }
+        }
+        offset += info->Size;
+    }
+    free(buffer);
+
+    uint32_t count = 0;
+    for (uint32_t cpu = 0; cpu < CPU_TOPOLOGY_MAX_CPUS; ++cpu) {
+        if (!present[cpu]) continue;
+        cpu_topology_cpu_t* entry = &topology->cpus[count++];
+        entry->cpu = cpu;
+        entry->core = core_of[cpu];
+        entry->node = node_of[cpu];
+        entry->smt_index = smt_of[cpu];
+    }
+    topology->cpu_count = count;
+    return count > 0;
+}
+#endif
+
+bool cpu_topology_discover(cpu_topology_t* topology) {
+    if (!topology) return false;
+    memset(topology, 0, sizeof(*topology));
+#if defined(CPU_TOPOLOGY_SYSFS)
+    if (discover_sysfs(topology)) return true;
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#elif defined(_WIN32)
+    if (discover_windows(topology)) return true;
+    long count = (long)GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+#elif defined(__EMSCRIPTEN__)
+    long count = 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    cpu_topology_flat(topology, count > 0 ? (uint32_t)count : 1);
+    return true;
+}
+
+const cpu_topology_cpu_t* cpu_topology_find(const cpu_topology_t* topology, uint32_t cpu) {
+    if (!topology) return NULL;
+    for (uint32_t i = 0; i < topology->cpu_count; ++i) {
+        if (topology->cpus[i].cpu == cpu) return &topology->cpus[i];
+    }
+    return NULL;
+}
+
+static bool spread_before(const cpu_topology_cpu_t* a, const cpu_topology_cpu_t* b) {
+    if (a->smt_index != b->smt_index) return a->smt_index < b->smt_index;
+    if (a->node != b->node) return a->node < b->node;
+    if (a->core != b->core) return a->core < b->core;
+    return a->cpu < b->cpu;
+}
+
+uint32_t cpu_topology_spread(const cpu_topology_t* topology, uint32_t* cpus, uint32_t count) {
+    if (!topology || !cpus) return 0;
+    const cpu_topology_cpu_t* order[CPU_TOPOLOGY_MAX_CPUS];
+    uint32_t total = topology->cpu_count;
+    for (uint32_t i = 0; i < total; ++i) {
+        const cpu_topology_cpu_t* entry = &topology->cpus[i];
+        uint32_t j = i;
+        for (; j > 0 && spread_before(entry, order[j - 1]); --j) order[j] = order[j - 1];
+        order[j] = entry;
+    }
+    if (count > total) count = total;
+    for (uint32_t i = 0; i < count; ++i) cpus[i] = order[i]->cpu;
+    return count;
+}
+
+bool cpu_topology_bind_memory(void* ptr, size_t size, uint32_t node) {
+#if defined(CPU_TOPOLOGY_SYSFS)
+    if (!ptr || size == 0 || node >= 1024) return false;
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) page = 4096;
+    uintptr_t start = (uintptr_t)ptr & ~((uintptr_t)page - 1);
+    uintptr_t end = ((uintptr_t)ptr + size + (uintptr_t)page - 1) & ~((uintptr_t)page - 1);
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))] = { 0 };
+    mask[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+    // Raw syscall: no libnuma dependency
+    return syscall(SYS_mbind, (void*)start, (unsigned long)(end - start), MPOL_PREFERRED,
+                   mask, (unsigned long)(sizeof(mask) * 8), MPOL_MF_MOVE) == 0;
+#else
+    (void)ptr;
+    (void)size;
+    (void)node;
+    return false;
+#endif
+}
@@ -1,18 +1,193 @@
 #include "event_scheduler.h"
 #include "portable_atomic.h"
+#include "umsbb_clock.h"
+#include <limits.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#elif defined(__EMSCRIPTEN__)
+#  include <emscripten/threading.h>
+#  include <math.h>
+#elif defined(__linux__)
+#  include <linux/futex.h>
+#  include <sys/eventfd.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+uint64_t event_now_ns(void) {
+    return umsbb_clock_ns();
+}
+
+static inline void event_cpu_relax(void) {
+#if defined(_MSC_VER)
+    YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+void event_park_address(atomic_u32* word, uint32_t expected, uint64_t timeoutNs) {
+#if defined(_WIN32)
+    DWORD ms = INFINITE;
+    if (timeoutNs != EVENT_WAIT_FOREVER) {
+        uint64_t rounded = (timeoutNs + 999999) / 1000000;
+        ms = rounded >= INFINITE ? INFINITE - 1 : (DWORD)rounded;
+    }
+    WaitOnAddress((volatile VOID*)word, &expected, sizeof(expected), ms);
+#elif defined(__EMSCRIPTEN__) && defined(__EMSCRIPTEN_PTHREADS__)
+    double ms = timeoutNs == EVENT_WAIT_FOREVER ? INFINITY : (double)timeoutNs / 1e6;
+    emscripten_futex_wait((volatile void*)word, expected, ms);
+#elif defined(__linux__)
+    struct timespec ts;
+    struct timespec* tsp = NULL;
+    if (timeoutNs != EVENT_WAIT_FOREVER) {
+        ts.tv_sec = (time_t)(timeoutNs / 1000000000ull);
+        ts.tv_nsec = (long)(timeoutNs % 1000000000ull);
+        tsp = &ts;
+    }
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT_PRIVATE, expected, tsp, NULL, 0);
+#else
+    // No address wait on this platform: nap in short slices
+    if (atomic_load_u32(word) != expected) return;
+    uint64_t slice = timeoutNs < 50000 ? timeoutNs : 50000;
+    struct timespec ts = { 0, (long)slice };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+void event_wake_address(atomic_u32* word) {
+#if defined(_WIN32)
+    WakeByAddressAll((PVOID)word);
+#elif defined(__EMSCRIPTEN__) && defined(__EMSCRIPTEN_PTHREADS__)
+    emscripten_futex_wake((volatile void*)word, INT_MAX);
+#elif defined(__linux__)
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)word;
+#endif
+}
+
+static void event_fd_notify(EventScheduler* e) {
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+    uint32_t fd = atomic_load_u32(&e->fd);
+    if (fd) eventfd_write((int)fd - 1, 1);
+#else
+    (void)e;
+#endif
+}
 
 void event_init(EventScheduler* e) {
-    atomic_init_bool(&e->signal, false);
+    atomic_store_u32(&e->signal, 0);
+    atomic_store_u32(&e->epoch, 0);
+    atomic_store_u32(&e->waiters, 0);
+    atomic_store_u32(&e->spinLimit, EVENT_SPIN_MIN);
+    atomic_store_u32(&e->fd, 0);
+}
+
+void event_destroy(EventScheduler* e) {
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+    uint32_t fd = atomic_exchange_u32(&e->fd, 0);
+    if (fd) close((int)fd - 1);
+#else
+    (void)e;
+#endif
 }
 
 void event_signal(EventScheduler* e) {
-    atomic_store_bool(&e->signal, true);
+    // Order the caller's commit before reading the flag; pairs with the
+    // store in event_clear so a consumer re-checking after a clear sees it
+    atomic_fence_seq_cst();
+    event_notify(e);
+}
+
+void event_notify(EventScheduler* e) {
+    if (atomic_load_u32(&e->signal)) return;
+    if (atomic_exchange_u32(&e->signal, 1)) return;
+
+    // First signal since the last clear
+    event_fd_notify(e);
+    if (atomic_load_u32(&e->waiters)) {
+        atomic_fetch_add_u32(&e->epoch, 1);
+        event_wake_address(&e->epoch);
+    }
 }
 
 bool event_check(EventScheduler* e) {
-    return atomic_load_bool(&e->signal);
+    return atomic_load_u32(&e->signal) != 0;
 }
 
 void event_clear(EventScheduler* e) {
-    atomic_store_bool(&e->signal, false);
-}
\ No newline at end of file
+    if (!atomic_load_u32(&e->signal)) return;
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+    // Drain the eventfd before the flag: a signal landing in between sets
+    // the flag again and leaves the fd readable
+    uint32_t fd = atomic_load_u32(&e->fd);
+    if (fd) {
+        eventfd_t value;
+        eventfd_read((int)fd - 1, &value);
+    }
+#endif
+    atomic_store_u32(&e->signal, 0);
+}
+
+bool event_wait(EventScheduler* e, uint64_t timeoutNs) {
+    if (event_check(e)) return true;
+    if (timeoutNs == 0) return false;
+
+    uint64_t start = event_now_ns();
+    uint32_t limit = atomic_load_u32(&e->spinLimit);
+    for (uint32_t i = 0; i < limit; ++i) {
+        if (event_check(e)) {
+            if (limit < EVENT_SPIN_MAX) atomic_store_u32(&e->spinLimit, limit * 2);
+            return true;
+        }
+        event_cpu_relax();
+    }
+    if (limit > EVENT_SPIN_MIN) atomic_store_u32(&e->spinLimit, limit / 2);
+
+    for (;;) {
+        uint64_t remaining = EVENT_WAIT_FOREVER;
+        if (timeoutNs != EVENT_WAIT_FOREVER) {
+            uint64_t elapsed = event_now_ns() - start;
+            if (elapsed >= timeoutNs) return event_check(e);
+            remaining = timeoutNs - elapsed;
+        }
+
+        // Announce before the final check; event_signal reads waiters after
+        // setting the flag, so one of the two always sees the other
+        uint32_t epoch = atomic_load_u32(&e->epoch);
+        atomic_fetch_add_u32(&e->waiters, 1);
+        if (event_check(e)) {
+            atomic_fetch_add_u32(&e->waiters, (uint32_t)-1);
+            return true;
+        }
+        event_park_address(&e->epoch, epoch, remaining);
+        atomic_fetch_add_u32(&e->waiters, (uint32_t)-1);
+        if (event_check(e)) return true;
+    }
+}
+
+int event_fd(EventScheduler* e) {
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+    uint32_t current = atomic_load_u32(&e->fd);
+    if (current) return (int)current - 1;
+
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) return -1;
+    uint32_t expected = 0;
+    if (!atomic_cas_u32(&e->fd, &expected, (uint32_t)fd + 1)) {
+        close(fd);
+        return (int)expected - 1;
+    }
+    // A signal that landed before the fd was installed did not notify it
+    if (event_check(e)) eventfd_write(fd, 1);
+    return fd;
+#else
+    (void)e;
+    return -1;
+#endif
+}
@@ -6,39 +6,152 @@
  */
 
 #include "fast_lane.h"
+#include "message_pool.h"
+#include "umsbb_clock.h"
+#include "umsbb_trace.h"
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 #ifdef _WIN32
     #include <windows.h>
-    static uint64_t get_timestamp_us() {
-        LARGE_INTEGER frequency, counter;
-        QueryPerformanceFrequency(&frequency);
-        QueryPerformanceCounter(&counter);
-        return (counter.QuadPart * 1000000ULL) / frequency.QuadPart;
+#endif
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #define FAST_LANE_HAVE_MMAP 1
+#endif
+
+_Static_assert(sizeof(fast_lane_slot_t) <= FAST_LANE_SLOT_HEADER, "slot header fits before the payload");
+
+#define FAST_LANE_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define FAST_LANE_ROUND(x, a) (((x) + ((a) - 1)) & ~(size_t)((a) - 1))
+
+static inline void fast_lane_cpu_relax(void) {
+#if defined(_MSC_VER)
+    YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static inline fast_lane_slot_t* fast_lane_slot(fast_lane_t* lane, size_t index) {
+    return (fast_lane_slot_t*)((char*)lane->ring_buffer + index * lane->slot_stride);
+}
+
+/*
+ * Slot i starts with turn i. Storing turns biased by -i makes that initial
+ * state all zeroes, so fresh mappings need no initialisation pass and stay
+ * uncommitted until a message first lands in them.
+ */
+static inline size_t fast_lane_turn(fast_lane_slot_t* slot, size_t index) {
+    return atomic_load_size_acquire(&slot->sequence) + index;
+}
+
+static inline void fast_lane_pass(fast_lane_slot_t* slot, size_t index, size_t turn) {
+    atomic_store_size_release(&slot->sequence, turn - index);
+}
+
+static fast_lane_slot_t* fast_lane_take(fast_lane_t* lane, size_t* taken);
+
+// Reserve zeroed, lazily committed storage for a lane
+static void* fast_lane_map(size_t size, uint32_t flags, size_t* mapped) {
+#if defined(FAST_LANE_HAVE_MMAP)
+    void* p = MAP_FAILED;
+#  if defined(MAP_HUGETLB)
+    if ((flags & FAST_LANE_FLAG_HUGE_PAGES) && size >= FAST_LANE_HUGE_PAGE_SIZE) {
+        size_t rounded = FAST_LANE_ROUND(size, FAST_LANE_HUGE_PAGE_SIZE);
+        p = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) size = rounded;
     }
-    
-    static int posix_memalign(void **memptr, size_t alignment, size_t size) {
-        *memptr = _aligned_malloc(size, alignment);
-        return (*memptr == NULL) ? ENOMEM : 0;
+#  endif
+    if (p == MAP_FAILED) {
+        int extra = 0;
+#  if defined(MAP_NORESERVE)
+        extra |= MAP_NORESERVE;     // Address space only; pages are committed on first touch
+#  endif
+        p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra, -1, 0);
+        if (p == MAP_FAILED) return NULL;
+#  if defined(MADV_HUGEPAGE)
+        // No reserved huge pages: ask for transparent ones instead
+        if (flags & FAST_LANE_FLAG_HUGE_PAGES) madvise(p, size, MADV_HUGEPAGE);
+#  endif
     }
-    
-    #define free_aligned(ptr) _aligned_free(ptr)
-#else
-    #include <sys/time.h>
-    static uint64_t get_timestamp_us() {
-        struct timeval tv;
-        gettimeofday(&tv, NULL);
-        return tv.tv_sec * 1000000ULL + tv.tv_usec;
+    *mapped = size;
+    return p;
+#elif defined(_WIN32)
+    // Committed pages are only backed once touched; large pages need
+    // SeLockMemoryPrivilege and fall back silently
+    void* p = NULL;
+    SIZE_T large = GetLargePageMinimum();
+    if ((flags & FAST_LANE_FLAG_HUGE_PAGES) && large && size >= large) {
+        size_t rounded = FAST_LANE_ROUND(size, (size_t)large);
+        p = VirtualAlloc(NULL, rounded, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (p) size = rounded;
     }
-    
-    #define free_aligned(ptr) free(ptr)
+    if (!p) p = VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (p) *mapped = size;
+    return p;
+#else
+    (void)flags;
+    void* p = calloc(1, size);
+    if (p) *mapped = size;
+    return p;
+#endif
+}
+
+static void fast_lane_unmap(void* p, size_t size) {
+    if (!p) return;
+#if defined(FAST_LANE_HAVE_MMAP)
+    munmap(p, size);
+#elif defined(_WIN32)
+    (void)size;
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    (void)size;
+    free(p);
 #endif
+}
+
+// Commit every page up front so the first messages do not take page faults
+static void fast_lane_prefault(void* p, size_t size) {
+#if defined(FAST_LANE_HAVE_MMAP) && defined(MADV_POPULATE_WRITE)
+    if (madvise(p, size, MADV_POPULATE_WRITE) == 0) return;
+#endif
+#if defined(FAST_LANE_HAVE_MMAP)
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+#else
+    size_t page = 4096;
+#endif
+    volatile char* bytes = (volatile char*)p;
+    for (size_t off = 0; off < size; off += page) bytes[off] = 0;
+}
+
+void fast_lane_default_config(fast_lane_config_t config[LANE_COUNT]) {
+    // Express and priority lanes are small and latency critical: prefault them
+    config[LANE_EXPRESS] = (fast_lane_config_t){ 1024, 256, FAST_LANE_FLAG_PREFAULT, 0 };
+    config[LANE_PRIORITY] = (fast_lane_config_t){ 512, 1024, FAST_LANE_FLAG_PREFAULT, 0 };
+    // Bulk and streaming carry descriptors; payloads live in the message pool
+    config[LANE_BULK] = (fast_lane_config_t){ 8192, FAST_LANE_INDIRECT_MAX, FAST_LANE_FLAG_INDIRECT, 0 };
+    config[LANE_STREAMING] = (fast_lane_config_t){ 16384, FAST_LANE_INDIRECT_MAX, FAST_LANE_FLAG_INDIRECT, 0 };
+}
 
 bool fast_lane_init(fast_lane_manager_t* manager) {
+    return fast_lane_init_ex(manager, NULL);
+}
+
+bool fast_lane_init_ex(fast_lane_manager_t* manager, const fast_lane_config_t config[LANE_COUNT]) {
     if (!manager) return false;
     
+    fast_lane_config_t defaults[LANE_COUNT];
+    if (!config) {
+        fast_lane_default_config(defaults);
+        config = defaults;
+    }
+    
     memset(manager, 0, sizeof(fast_lane_manager_t));
     
     // Initialize each lane type with optimized configurations
@@ -48,53 +161,63 @@ bool fast_lane_init(fast_lane_manager_t* manager) {
         
         switch (lane->type) {
             case LANE_EXPRESS:
-                lane->capacity = 1024;           // Small ring for low latency
-                lane->slot_size = 256;           // Small messages
                 lane->priority = 3;              // Highest priority
                 lane->latency_target_us = 1.0;   // 1 microsecond target
                 lane->gpu_preferred = false;     // CPU for speed
                 break;
                 
             case LANE_BULK:
-                lane->capacity = 8192;           // Large ring for throughput
-                lane->slot_size = 64 * 1024;     // 64KB messages
                 lane->priority = 1;              // Lower priority
                 lane->latency_target_us = 100.0; // 100 microsecond target
                 lane->gpu_preferred = true;      // GPU for large data
                 break;
                 
             case LANE_PRIORITY:
-                lane->capacity = 512;            // Medium ring
-                lane->slot_size = 1024;          // Medium messages
                 lane->priority = 4;              // Maximum priority
                 lane->latency_target_us = 0.5;   // 0.5 microsecond target
                 lane->gpu_preferred = false;     // CPU for reliability
                 break;
                 
             case LANE_STREAMING:
-                lane->capacity = 16384;          // Largest ring
-                lane->slot_size = 4096;          // 4KB streaming chunks
                 lane->priority = 2;              // Medium priority
                 lane->latency_target_us = 50.0;  // 50 microsecond target
                 lane->gpu_preferred = true;      // GPU for parallel processing
                 break;
         }
         
-        // Allocate cache-aligned ring buffer
-        size_t ring_size = lane->capacity * lane->slot_size;
-        if (posix_memalign(&lane->ring_buffer, 64, ring_size) != 0) {
-            // Cleanup previously allocated lanes
-            for (int j = 0; j < i; j++) {
-                free_aligned(manager->lanes[j].ring_buffer);
-            }
+        atomic_store_size(&lane->head, 0);
+        atomic_store_size(&lane->tail, 0);
+        atomic_store_size(&lane->congestion_events, 0);
+        atomic_store(&lane->bytes_transferred, 0);
+        
+        // A zero capacity or slot size leaves the lane disabled
+        if (config[i].capacity == 0 || config[i].slot_size == 0) continue;
+        
+        uint32_t capacity = 1;
+        while (capacity < config[i].capacity && capacity < (1u << 31)) capacity <<= 1;
+        lane->capacity = capacity;
+        lane->slot_size = config[i].slot_size;
+        lane->flags = config[i].flags;
+        if (lane->flags & FAST_LANE_FLAG_COMPRESS) {
+            lane_codec_init(&lane->codec, config[i].compress_min ? config[i].compress_min : LANE_CODEC_MIN_SIZE, 0);
+        }
+        if (lane->slot_size > UINT32_MAX) lane->slot_size = UINT32_MAX;   // Slot headers hold 32-bit lengths
+        size_t carried = (lane->flags & FAST_LANE_FLAG_INDIRECT) ? sizeof(fast_lane_descriptor_t) : lane->slot_size;
+        lane->slot_stride = FAST_LANE_ROUND(FAST_LANE_SLOT_HEADER + carried, 64);
+        
+        size_t ring_size = (size_t)lane->capacity * lane->slot_stride;
+        lane->ring_buffer = fast_lane_map(ring_size, lane->flags, &lane->mapped_size);
+        if (!lane->ring_buffer) {
+            fast_lane_destroy(manager);
             return false;
         }
+        if (lane->flags & FAST_LANE_FLAG_PREFAULT) fast_lane_prefault(lane->ring_buffer, lane->mapped_size);
         
-        memset(lane->ring_buffer, 0, ring_size);
-        atomic_store(&lane->head, 0);
-        atomic_store(&lane->tail, 0);
-        atomic_store(&lane->message_count, 0);
-        atomic_store(&lane->bytes_transferred, 0);
+        lane->latency = latency_histogram_create();
+        if (!lane->latency) {
+            fast_lane_destroy(manager);
+            return false;
+        }
     }
     
     manager->active_lanes = LANE_COUNT;
@@ -114,9 +237,20 @@ void fast_lane_destroy(fast_lane_manager_t* manager) {
     if (!manager) return;
     
     for (int i = 0; i < LANE_COUNT; i++) {
-        if (manager->lanes[i].ring_buffer) {
-            free_aligned(manager->lanes[i].ring_buffer);
+        fast_lane_t* lane = &manager->lanes[i];
+        if (lane->ring_buffer && (lane->flags & FAST_LANE_FLAG_INDIRECT)) {
+            // Undrained descriptors own their pooled payloads
+            size_t pos;
+            fast_lane_slot_t* slot;
+            while ((slot = fast_lane_take(lane, &pos)) != NULL) {
+                fast_lane_descriptor_t descriptor;
+                memcpy(&descriptor, (char*)slot + FAST_LANE_SLOT_HEADER, sizeof(descriptor));
+                message_pool_release(descriptor.payload);
+                fast_lane_pass(slot, pos & (lane->capacity - 1), pos + lane->capacity);
+            }
         }
+        fast_lane_unmap(manager->lanes[i].ring_buffer, manager->lanes[i].mapped_size);
+        latency_histogram_destroy(lane->latency);
     }
     
     memset(manager, 0, sizeof(fast_lane_manager_t));
@@ -142,152 +276,378 @@ lane_type_t fast_lane_select_optimal(size_t message_size, uint32_t priority, boo
     return LANE_STREAMING;
 }
 
-bool fast_lane_submit(fast_lane_manager_t* manager, lane_type_t lane_type, const void* data, size_t size, uint32_t priority) {
-    if (!manager || !data || size == 0 || lane_type >= LANE_COUNT) return false;
-    
-    fast_lane_t* lane = &manager->lanes[lane_type];
-    
-    // Check if message fits in slot
-    if (size > lane->slot_size) {
-        return false;
+// Claim the slot at head once its turn has come; false if the lane is full.
+// `claimed` is the position tried last either way.
+static fast_lane_slot_t* fast_lane_claim(fast_lane_t* lane, size_t* claimed) {
+    size_t mask = lane->capacity - 1;
+    size_t pos = atomic_load_size_relaxed(&lane->head);
+    for (;;) {
+        *claimed = pos;
+        fast_lane_slot_t* slot = fast_lane_slot(lane, pos & mask);
+        ptrdiff_t diff = (ptrdiff_t)(fast_lane_turn(slot, pos & mask) - pos);
+        if (diff == 0) {
+            if (atomic_cas_size(&lane->head, &pos, pos + 1)) {
+                UMSBB_TRACE(UMSBB_TRACE_FAST_LANE, UMSBB_TRACE_CLAIM, lane->type, pos);
+                return slot;
+            }
+        } else if (diff < 0) {
+            return NULL; // A consumer has not handed the slot back yet
+        } else {
+            pos = atomic_load_size_relaxed(&lane->head);
+        }
     }
-    
-    uint64_t start_time = get_timestamp_us();
-    
-    // Get next slot with atomic increment
-    uint64_t slot_index = atomic_fetch_add(&lane->head, 1) % lane->capacity;
-    
-    // Calculate slot address
-    char* slot_addr = (char*)lane->ring_buffer + (slot_index * lane->slot_size);
-    
-    // Wait for slot to be available (busy wait for ultra-low latency)
-    uint64_t expected_tail = atomic_load(&lane->tail);
-    while ((slot_index - expected_tail) >= lane->capacity) {
-        // Slot not available, check if we should yield
-        if (get_timestamp_us() - start_time > lane->latency_target_us * 2) {
-            return false; // Timeout
+}
+
+// Take the slot at tail once it is published; false if the lane is empty.
+// `taken` is the position tried last either way.
+static fast_lane_slot_t* fast_lane_take(fast_lane_t* lane, size_t* taken) {
+    size_t mask = lane->capacity - 1;
+    size_t pos = atomic_load_size_relaxed(&lane->tail);
+    for (;;) {
+        *taken = pos;
+        fast_lane_slot_t* slot = fast_lane_slot(lane, pos & mask);
+        ptrdiff_t diff = (ptrdiff_t)(fast_lane_turn(slot, pos & mask) - (pos + 1));
+        if (diff == 0) {
+            if (atomic_cas_size(&lane->tail, &pos, pos + 1)) {
+                UMSBB_TRACE(UMSBB_TRACE_FAST_LANE, UMSBB_TRACE_DRAIN, lane->type, pos);
+                return slot;
+            }
+        } else if (diff < 0) {
+            return NULL; // Empty, or the producer is still writing
+        } else {
+            pos = atomic_load_size_relaxed(&lane->tail);
         }
-        expected_tail = atomic_load(&lane->tail);
     }
-    
-    // Copy message data to slot
-    memcpy(slot_addr, data, size);
-    
-    // Update metrics
-    atomic_fetch_add(&lane->message_count, 1);
-    atomic_fetch_add(&lane->bytes_transferred, size);
-    lane->total_messages++;
-    lane->total_bytes += size;
-    
-    // Update latency tracking
-    uint64_t end_time = get_timestamp_us();
-    double latency = (double)(end_time - start_time);
-    
-    // Simple moving average for latency
-    if (lane->avg_latency_us == 0.0) {
-        lane->avg_latency_us = latency;
+}
+
+static bool fast_lane_accepts(fast_lane_manager_t* manager, lane_type_t lane_type, const void* data, size_t size) {
+    // Disabled lanes have no storage and a zero slot size
+    return manager && data && size > 0 && lane_type < LANE_COUNT && size <= manager->lanes[lane_type].slot_size;
+}
+
+// Indirect lanes copy the payload into a pooled block before claiming a slot,
+// so a full lane costs the producer nothing but the copy it would make anyway
+static const void* fast_lane_stage(fast_lane_t* lane, const void* data, size_t size) {
+    if (!(lane->flags & FAST_LANE_FLAG_INDIRECT)) return data;
+    void* block = message_pool_alloc(size);
+    if (block) memcpy(block, data, size);
+    return block;
+}
+
+static void fast_lane_unstage(fast_lane_t* lane, const void* staged) {
+    if (lane->flags & FAST_LANE_FLAG_INDIRECT) message_pool_release((void*)staged);
+}
+
+// Compressed payload in the calling thread's codec scratch, or `data` as is
+static const void* fast_lane_encode(fast_lane_t* lane, const void* data, size_t size,
+                                    size_t* stored, uint32_t* original) {
+    *stored = size;
+    *original = 0;
+    const void* packed = lane_codec_encode(&lane->codec, data, size, stored);
+    if (!packed) return data;
+    *original = (uint32_t)size;
+    return packed;
+}
+
+static void fast_lane_publish(fast_lane_t* lane, fast_lane_slot_t* slot, size_t pos,
+                              const void* data, size_t size, uint32_t original, uint32_t priority) {
+    if (lane->flags & FAST_LANE_FLAG_INDIRECT) {
+        fast_lane_descriptor_t descriptor = { (void*)data };
+        memcpy((char*)slot + FAST_LANE_SLOT_HEADER, &descriptor, sizeof(descriptor));
     } else {
-        lane->avg_latency_us = (lane->avg_latency_us * 0.9) + (latency * 0.1);
+        memcpy((char*)slot + FAST_LANE_SLOT_HEADER, data, size);
     }
-    
-    if (latency > lane->max_latency_us) {
-        lane->max_latency_us = latency;
+    slot->length = (uint32_t)size;
+    slot->priority = priority;
+    slot->enqueued_ns = umsbb_clock_ns();
+    slot->original = original;
+    fast_lane_pass(slot, pos & (lane->capacity - 1), pos + 1);
+    UMSBB_TRACE(UMSBB_TRACE_FAST_LANE, UMSBB_TRACE_COMMIT, lane->type, pos);
+    atomic_fetch_add(&lane->bytes_transferred, original ? original : size);
+}
+
+// Waits are rare and already part of the message's submit-to-drain latency;
+// only count the ones that blow the lane's target
+static void fast_lane_record_wait(fast_lane_t* lane, double latency) {
+    if (latency > lane->latency_target_us * 2) atomic_fetch_add_size(&lane->congestion_events, 1);
+}
+
+bool fast_lane_try_submit(fast_lane_manager_t* manager, lane_type_t lane_type, const void* data, size_t size, uint32_t priority) {
+    if (!fast_lane_accepts(manager, lane_type, data, size)) return false;
+    fast_lane_t* lane = &manager->lanes[lane_type];
+    size_t stored;
+    uint32_t original;
+    const void* payload = fast_lane_encode(lane, data, size, &stored, &original);
+    const void* staged = fast_lane_stage(lane, payload, stored);
+    if (!staged) return false;
+
+    size_t pos;
+    fast_lane_slot_t* slot = fast_lane_claim(lane, &pos);
+    if (!slot) {
+        fast_lane_unstage(lane, staged);
+        return false;
     }
-    
-    // Check for congestion
-    if (latency > lane->latency_target_us * 2) {
-        lane->congestion_events++;
+    fast_lane_publish(lane, slot, pos, staged, stored, original, priority);
+    return true;
+}
+
+bool fast_lane_submit_spin(fast_lane_manager_t* manager, lane_type_t lane_type, const void* data, size_t size,
+                           uint32_t priority, uint32_t max_spins) {
+    if (!fast_lane_accepts(manager, lane_type, data, size)) return false;
+    fast_lane_t* lane = &manager->lanes[lane_type];
+    size_t stored;
+    uint32_t original;
+    const void* payload = fast_lane_encode(lane, data, size, &stored, &original);
+    const void* staged = fast_lane_stage(lane, payload, stored);
+    if (!staged) return false;
+
+    size_t pos;
+    fast_lane_slot_t* slot = fast_lane_claim(lane, &pos);
+    if (!slot) {
+        // Only a full lane pays for timestamps
+        uint64_t start_time = umsbb_clock_us();
+        for (uint32_t spin = 0; !slot && spin < max_spins; ++spin) {
+            fast_lane_cpu_relax();
+            slot = fast_lane_claim(lane, &pos);
+        }
+        fast_lane_record_wait(lane, (double)(umsbb_clock_us() - start_time));
+        if (!slot) {
+            fast_lane_unstage(lane, staged);
+            return false;
+        }
     }
-    
+    fast_lane_publish(lane, slot, pos, staged, stored, original, priority);
     return true;
 }
 
-void* fast_lane_drain(fast_lane_manager_t* manager, lane_type_t lane_type, size_t* size, uint32_t* priority) {
+bool fast_lane_submit(fast_lane_manager_t* manager, lane_type_t lane_type, const void* data, size_t size, uint32_t priority) {
+    return fast_lane_submit_spin(manager, lane_type, data, size, priority, FAST_LANE_DEFAULT_SPINS);
+}
+
+static void* fast_lane_consume(fast_lane_t* lane, fast_lane_slot_t* slot, size_t pos, size_t* size, uint32_t* priority) {
+    size_t length = slot->length;
+    void* block = NULL;
+    const void* stored = (char*)slot + FAST_LANE_SLOT_HEADER;
+    if (lane->flags & FAST_LANE_FLAG_INDIRECT) {
+        fast_lane_descriptor_t descriptor;
+        memcpy(&descriptor, stored, sizeof(descriptor));
+        block = descriptor.payload;
+        stored = block;
+    }
+
+    void* result;
+    if (slot->original) {
+        // Decoded here, straight into the buffer handed to the consumer
+        size_t original = slot->original;
+        result = message_pool_alloc(original);
+        if (result && !lane_codec_decode(&lane->codec, stored, length, result, original)) {
+            message_pool_release(result);
+            result = NULL;
+        }
+        message_pool_release(block);
+        length = original;
+    } else if (block) {
+        // The staged block already is a pooled buffer: hand it over as is
+        result = block;
+    } else {
+        // Pooled return buffer, released with umsbb_message_release
+        result = message_pool_alloc(length);
+        if (result) memcpy(result, stored, length);
+    }
+    if (result) {
+        *size = length;
+        if (priority) *priority = slot->priority;
+    }
+    latency_histogram_record(lane->latency, umsbb_clock_ns() - slot->enqueued_ns);
+    // The slot is handed back either way; without memory the message is lost
+    fast_lane_pass(slot, pos & (lane->capacity - 1), pos + lane->capacity);
+    UMSBB_TRACE(UMSBB_TRACE_FAST_LANE, UMSBB_TRACE_RELEASE, lane->type, pos);
+    return result;
+}
+
+void* fast_lane_try_drain(fast_lane_manager_t* manager, lane_type_t lane_type, size_t* size, uint32_t* priority) {
     if (!manager || !size || lane_type >= LANE_COUNT) return NULL;
-    
+    *size = 0;
     fast_lane_t* lane = &manager->lanes[lane_type];
-    
-    uint64_t current_tail = atomic_load(&lane->tail);
-    uint64_t current_head = atomic_load(&lane->head);
-    
-    // Check if messages are available
-    if (current_tail >= current_head) {
-        *size = 0;
-        return NULL;
+    if (!lane->ring_buffer) return NULL;
+
+    size_t pos;
+    fast_lane_slot_t* slot = fast_lane_take(lane, &pos);
+    return slot ? fast_lane_consume(lane, slot, pos, size, priority) : NULL;
+}
+
+void* fast_lane_drain_spin(fast_lane_manager_t* manager, lane_type_t lane_type, size_t* size, uint32_t* priority,
+                           uint32_t max_spins) {
+    if (!manager || !size || lane_type >= LANE_COUNT) return NULL;
+    *size = 0;
+    fast_lane_t* lane = &manager->lanes[lane_type];
+    if (!lane->ring_buffer) return NULL;
+
+    size_t pos;
+    fast_lane_slot_t* slot = fast_lane_take(lane, &pos);
+    for (uint32_t spin = 0; !slot && spin < max_spins; ++spin) {
+        fast_lane_cpu_relax();
+        slot = fast_lane_take(lane, &pos);
     }
-    
-    uint64_t start_time = get_timestamp_us();
-    
-    // Get slot address
-    uint64_t slot_index = current_tail % lane->capacity;
-    char* slot_addr = (char*)lane->ring_buffer + (slot_index * lane->slot_size);
-    
-    // Determine message size (first 4 bytes store size)
-    uint32_t message_size = *(uint32_t*)slot_addr;
-    if (message_size == 0 || message_size > lane->slot_size - sizeof(uint32_t)) {
-        // Invalid message size, skip this slot
-        atomic_fetch_add(&lane->tail, 1);
-        *size = 0;
-        return NULL;
+    return slot ? fast_lane_consume(lane, slot, pos, size, priority) : NULL;
+}
+
+void* fast_lane_drain(fast_lane_manager_t* manager, lane_type_t lane_type, size_t* size, uint32_t* priority) {
+    return fast_lane_try_drain(manager, lane_type, size, priority);
+}
+
+static inline bool fast_lane_has_pending(fast_lane_t* lane) {
+    return lane->ring_buffer && atomic_load_size_relaxed(&lane->head) != atomic_load_size_relaxed(&lane->tail);
+}
+
+// One message from `lane` into `out`; returns the bytes it costs the lane
+static size_t fast_lane_pop(fast_lane_manager_t* manager, lane_type_t lane_type, fast_lane_message_t* out, uint64_t now) {
+    out->data = fast_lane_try_drain(manager, lane_type, &out->size, &out->priority);
+    if (!out->data) return 0;
+    out->lane = lane_type;
+    manager->lane_last_served_us[lane_type] = now;
+    return FAST_LANE_SLOT_HEADER + out->size;
+}
+
+size_t fast_lane_drain_scheduled(fast_lane_manager_t* manager, fast_lane_message_t* out, size_t max) {
+    if (!manager || !out || max == 0) return 0;
+    uint64_t now = umsbb_clock_us();
+    size_t count = 0;
+
+    // Priority preemption, bounded so a flood cannot starve the other lanes
+    bool others_waiting = false;
+    for (int i = 0; i < LANE_COUNT; i++) {
+        if (i != LANE_PRIORITY && fast_lane_has_pending(&manager->lanes[i])) others_waiting = true;
     }
-    
-    // Allocate return buffer
-    void* result = malloc(message_size);
-    if (!result) {
-        *size = 0;
-        return NULL;
+    while (count < max && (!others_waiting || manager->priority_streak < FAST_LANE_PRIORITY_BURST)) {
+        if (!fast_lane_pop(manager, LANE_PRIORITY, &out[count], now)) break;
+        count++;
+        manager->priority_streak++;
     }
-    
-    // Copy message data (skip size prefix)
-    memcpy(result, slot_addr + sizeof(uint32_t), message_size);
-    *size = message_size;
-    
-    // Advance tail pointer
-    atomic_fetch_add(&lane->tail, 1);
-    atomic_fetch_sub(&lane->message_count, 1);
-    
-    // Update performance metrics
-    uint64_t end_time = get_timestamp_us();
-    double drain_latency = (double)(end_time - start_time);
-    
-    // Update system metrics
-    manager->active_consumers++;
-    
-    return result;
+    if (!others_waiting || count < max) manager->priority_streak = 0;
+    if (!others_waiting) return count;
+
+    // Overdue lanes get one message each, tightest latency target first
+    lane_type_t order[LANE_COUNT] = { LANE_EXPRESS, LANE_STREAMING, LANE_BULK, LANE_PRIORITY };
+    for (int k = 0; k < LANE_COUNT - 1; k++) {
+        for (int j = k + 1; j < LANE_COUNT; j++) {
+            if (manager->lanes[order[j]].latency_target_us < manager->lanes[order[k]].latency_target_us) {
+                lane_type_t t = order[k];
+                order[k] = order[j];
+                order[j] = t;
+            }
+        }
+    }
+    for (int k = 0; k < LANE_COUNT && count < max; k++) {
+        fast_lane_t* lane = &manager->lanes[order[k]];
+        if (order[k] == LANE_PRIORITY || !fast_lane_has_pending(lane)) continue;
+        if ((double)(now - manager->lane_last_served_us[order[k]]) < lane->latency_target_us) continue;
+        size_t cost = fast_lane_pop(manager, order[k], &out[count], now);
+        if (cost) {
+            manager->lane_deficit[order[k]] -= (int64_t)cost;
+            count++;
+        }
+    }
+
+    // Deficit round robin for the rest of the batch; a lane may overdraw its
+    // deficit by one message, which is paid back from its next quantum
+    uint32_t idle_visits = 0;
+    bool forgiven = false;
+    uint32_t cursor = atomic_load(&manager->round_robin_counter) % LANE_COUNT;
+    while (count < max) {
+        if (idle_visits == LANE_COUNT) {
+            // Every lane with data is paying off a large message: with no
+            // competitor left to be fair to, forgive the debt once
+            if (forgiven) break;
+            for (int i = 0; i < LANE_COUNT; i++) {
+                if (manager->lane_deficit[i] < 0) manager->lane_deficit[i] = 0;
+            }
+            forgiven = true;
+            idle_visits = 0;
+        }
+        fast_lane_t* lane = &manager->lanes[cursor];
+        bool served = false;
+        if (!fast_lane_has_pending(lane)) {
+            manager->lane_deficit[cursor] = 0;
+        } else {
+            if (!manager->turn_open) {
+                manager->lane_deficit[cursor] += (int64_t)manager->lane_weights[cursor] * FAST_LANE_QUANTUM;
+            }
+            manager->turn_open = false;
+            while (manager->lane_deficit[cursor] > 0 && count < max) {
+                size_t cost = fast_lane_pop(manager, (lane_type_t)cursor, &out[count], now);
+                if (!cost) {
+                    manager->lane_deficit[cursor] = 0;
+                    break;
+                }
+                manager->lane_deficit[cursor] -= (int64_t)cost;
+                count++;
+                served = true;
+            }
+            if (count == max && manager->lane_deficit[cursor] > 0 && fast_lane_has_pending(lane)) {
+                // Resume this lane's turn on the next call
+                manager->turn_open = true;
+                break;
+            }
+        }
+        idle_visits = served ? 0 : idle_visits + 1;
+        cursor = (cursor + 1) % LANE_COUNT;
+    }
+    atomic_store(&manager->round_robin_counter, cursor);
+    return count;
 }
 
-void fast_lane_get_metrics(fast_lane_manager_t* manager, lane_type_t lane_type, struct lane_metrics* metrics) {
+static void fast_lane_fill_metrics(fast_lane_manager_t* manager, lane_type_t lane_type,
+                                  struct lane_metrics* metrics, bool interval) {
     if (!manager || !metrics || lane_type >= LANE_COUNT) return;
     
     fast_lane_t* lane = &manager->lanes[lane_type];
+    memset(metrics, 0, sizeof(struct lane_metrics));
     
-    // Calculate rates (simplified - real implementation would use sliding windows)
-    static uint64_t last_messages = 0;
-    static uint64_t last_bytes = 0;
-    static uint64_t last_timestamp = 0;
+    // Rates since this lane's previous metrics call
+    uint64_t current_time = umsbb_clock_us();
+    uint64_t time_diff = current_time - lane->metrics_timestamp_us;
     
-    uint64_t current_time = get_timestamp_us();
-    uint64_t time_diff = current_time - last_timestamp;
+    uint64_t total_messages = atomic_load_size(&lane->head);
+    uint64_t total_bytes = atomic_load(&lane->bytes_transferred);
     
     if (time_diff > 0) {
-        uint64_t message_diff = lane->total_messages - last_messages;
-        uint64_t byte_diff = lane->total_bytes - last_bytes;
+        uint64_t message_diff = total_messages - lane->metrics_messages;
+        uint64_t byte_diff = total_bytes - lane->metrics_bytes;
         
         metrics->messages_per_second = (message_diff * 1000000) / time_diff;
         metrics->bytes_per_second = (byte_diff * 1000000) / time_diff;
         
-        last_messages = lane->total_messages;
-        last_bytes = lane->total_bytes;
-        last_timestamp = current_time;
+        lane->metrics_messages = total_messages;
+        lane->metrics_bytes = total_bytes;
+        lane->metrics_timestamp_us = current_time;
     }
     
-    metrics->avg_latency_us = lane->avg_latency_us;
-    metrics->p99_latency_us = lane->max_latency_us * 0.99; // Simplified P99
-    metrics->congestion_level = (uint32_t)(lane->congestion_events % 100);
+    if (interval) {
+        latency_histogram_interval(lane->latency, &metrics->latency);
+    } else {
+        latency_histogram_summary(lane->latency, &metrics->latency);
+    }
+    metrics->avg_latency_us = metrics->latency.meanNs / 1000.0;
+    metrics->p50_latency_us = (double)metrics->latency.p50Ns / 1000.0;
+    metrics->p99_latency_us = (double)metrics->latency.p99Ns / 1000.0;
+    metrics->p999_latency_us = (double)metrics->latency.p999Ns / 1000.0;
+    metrics->max_latency_us = (double)metrics->latency.maxNs / 1000.0;
+    metrics->congestion_level = (uint32_t)(atomic_load_size(&lane->congestion_events) % 100);
     
     // Calculate utilization
-    uint32_t current_count = atomic_load(&lane->message_count);
-    metrics->utilization_percent = ((double)current_count / lane->capacity) * 100.0;
+    // Tail first: it can pass a head loaded earlier, never a later one
+    size_t drained = atomic_load_size(&lane->tail);
+    size_t current_count = atomic_load_size(&lane->head) - drained;
+    metrics->utilization_percent = lane->capacity ? ((double)current_count / lane->capacity) * 100.0 : 0.0;
+}
+
+void fast_lane_get_metrics(fast_lane_manager_t* manager, lane_type_t lane_type, struct lane_metrics* metrics) {
+    fast_lane_fill_metrics(manager, lane_type, metrics, false);
+}
+
+void fast_lane_get_interval_metrics(fast_lane_manager_t* manager, lane_type_t lane_type, struct lane_metrics* metrics) {
+    fast_lane_fill_metrics(manager, lane_type, metrics, true);
 }
 
 double fast_lane_get_system_throughput(fast_lane_manager_t* manager) {
@@ -300,4 +660,47 @@ double fast_lane_get_system_throughput(fast_lane_manager_t* manager) {
     
     // Convert to Mbps (simplified calculation)
     return (double)total_bytes / (1024.0 * 1024.0);
-}
\ No newline at end of file
+}
+
+void fast_lane_get_codec_stats(fast_lane_manager_t* manager, lane_type_t lane_type, lane_codec_stats_t* stats) {
+    if (!stats) return;
+    if (!manager || lane_type >= LANE_COUNT) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    lane_codec_get_stats(&manager->lanes[lane_type].codec, stats);
+}
+
+bool fast_lane_register_metrics(fast_lane_manager_t* manager, MetricsRegistry* registry, const char* labels) {
+    if (!manager || !registry) return false;
+    static const char* names[LANE_COUNT] = { "express", "bulk", "priority", "streaming" };
+    bool ok = true;
+    for (int i = 0; i < LANE_COUNT; i++) {
+        fast_lane_t* lane = &manager->lanes[i];
+        if (!lane->ring_buffer) continue;
+        char lane_labels[METRICS_LABELS_MAX];
+        metrics_labels(lane_labels, sizeof(lane_labels), labels, "lane", names[i]);
+        ok &= metrics_registry_add(registry, lane, METRIC_COUNTER, "umsbb_lane_submitted_total",
+                                   "Messages producers claimed a lane slot for", lane_labels, METRIC_SIZE, &lane->head);
+        ok &= metrics_registry_add(registry, lane, METRIC_COUNTER, "umsbb_lane_drained_total",
+                                   "Messages consumers took from the lane", lane_labels, METRIC_SIZE, &lane->tail);
+        ok &= metrics_registry_add(registry, lane, METRIC_COUNTER, "umsbb_lane_bytes_total",
+                                   "Payload bytes through the lane", lane_labels, METRIC_U64, &lane->bytes_transferred);
+        ok &= metrics_registry_add(registry, lane, METRIC_COUNTER, "umsbb_lane_congestion_events_total",
+                                   "Producer waits over twice the lane latency target", lane_labels, METRIC_SIZE,
+                                   &lane->congestion_events);
+        if (lane->codec.min_size) {
+            ok &= metrics_registry_add(registry, lane, METRIC_COUNTER, "umsbb_lane_codec_in_bytes_total",
+                                       "Payload bytes compressed on submit", lane_labels, METRIC_SIZE,
+                                       &lane->codec.bytes_in);
+            ok &= metrics_registry_add(registry, lane, METRIC_COUNTER, "umsbb_lane_codec_out_bytes_total",
+                                       "Bytes those payloads were stored in", lane_labels, METRIC_SIZE,
+                                       &lane->codec.bytes_out);
+        }
+        if (lane->latency) {
+            ok &= metrics_registry_add_histogram(registry, lane, "umsbb_lane_latency_seconds",
+                                                 "Submit to drain latency", lane_labels, lane->latency);
+        }
+    }
+    return ok;
+}
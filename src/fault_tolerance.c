@@ -1,45 +1,101 @@
 #include "fault_tolerance.h"
+#include "umsbb_clock.h"
+#include "bi_buffer.h"
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <stdio.h>
 
-#ifdef _WIN32
-    #include <windows.h>
-    static uint64_t get_timestamp_us() {
-        LARGE_INTEGER frequency, counter;
-        QueryPerformanceFrequency(&frequency);
-        QueryPerformanceCounter(&counter);
-        return (counter.QuadPart * 1000000ULL) / frequency.QuadPart;
+// One component's counters within a shard
+typedef struct {
+    atomic_uint64_t successes;
+    atomic_uint64_t failures;
+    atomic_uint64_t response_us;        // Summed over every update
+    atomic_uint64_t response_max_us;
+    atomic_uint64_t streak;             // Failures since this shard last saw a success
+    atomic_uint64_t heartbeat_us;
+} shard_counters_t;
+
+struct fault_shard {
+    shard_counters_t components[FAULT_TOLERANCE_MAX_COMPONENTS];
+    atomic_uint64_t recovered;
+    atomic_uint64_t unrecoverable;
+    atomic_uint64_t recovery_time_us;
+};
+
+// Read on the data path, written only by recovery and the heartbeat check
+struct fault_component {
+    atomic_uint32_t heartbeat_armed;
+    atomic_uint32_t isolated;
+    uint32_t component_id;
+    timer_wheel_timer_t heartbeat_timer;    // Under heartbeat_lock
+};
+
+// state: 2 * id while fault `id` is published, 2 * id + 1 while it is written
+struct fault_slot {
+    atomic_uint64_t state;
+    fault_record_t record;
+};
+
+#define FAULT_SHARD_STRIDE \
+    ((sizeof(struct fault_shard) + FAULT_TOLERANCE_CACHE_LINE - 1) & ~(size_t)(FAULT_TOLERANCE_CACHE_LINE - 1))
+
+static MessageLog* message_log = NULL;
+static atomic_uint64_t messages_persisted;
+static atomic_uint64_t messages_recovered;
+
+static atomic_uint32_t fault_next_shard;
+static SOMA_THREAD_LOCAL uint32_t fault_thread_shard;  // Shard + 1, 0 until first use
+
+static inline struct fault_shard* shard_at(const fault_tolerance_manager_t* manager, uint32_t index) {
+    return (struct fault_shard*)((char*)manager->shards + (size_t)index * FAULT_SHARD_STRIDE);
+}
+
+static inline struct fault_shard* thread_shard(const fault_tolerance_manager_t* manager) {
+    if (fault_thread_shard == 0) {
+        fault_thread_shard = atomic_fetch_add(&fault_next_shard, 1) % FAULT_TOLERANCE_SHARDS + 1;
     }
-#else
-    #include <sys/time.h>
-    static uint64_t get_timestamp_us() {
-        struct timeval tv;
-        gettimeofday(&tv, NULL);
-        return tv.tv_sec * 1000000ULL + tv.tv_usec;
+    return shard_at(manager, fault_thread_shard - 1);
+}
+
+// First sight of a component: one CAS, then only loads
+static void register_component(fault_tolerance_manager_t* manager, uint32_t component_id) {
+    uint64_t bit = 1ull << component_id;
+    for (;;) {
+        uint64_t registered = atomic_load(&manager->registered);
+        if (registered & bit) return;
+        if (atomic_compare_exchange_weak(&manager->registered, &registered, registered | bit)) return;
+    }
+}
+
+static void heartbeat_lock(fault_tolerance_manager_t* manager) {
+    for (;;) {
+        uint32_t expected = 0;
+        if (atomic_load(&manager->heartbeat_lock) == 0 &&
+            atomic_compare_exchange_weak(&manager->heartbeat_lock, &expected, 1)) {
+            return;
+        }
     }
-#endif
+}
 
-static component_health_t* components = NULL;
-static uint32_t max_components = 0;
-static uint32_t component_count = 0;
+static inline void heartbeat_unlock(fault_tolerance_manager_t* manager) {
+    atomic_store(&manager->heartbeat_lock, 0);
+}
 
 bool fault_tolerance_init(fault_tolerance_manager_t* manager, uint32_t capacity) {
     if (!manager || capacity == 0) return false;
     
     memset(manager, 0, sizeof(fault_tolerance_manager_t));
     
-    manager->records = calloc(capacity, sizeof(fault_record_t));
-    if (!manager->records) return false;
+    manager->slots = calloc(capacity, sizeof(struct fault_slot));
+    if (!manager->slots) return false;
     
     manager->capacity = capacity;
     atomic_store(&manager->head, 0);
-    atomic_store(&manager->tail, 0);
-    atomic_store(&manager->active_faults, 0);
-    atomic_store(&manager->total_faults, 0);
-    atomic_store(&manager->recovered_faults, 0);
-    atomic_store(&manager->unrecoverable_faults, 0);
+    atomic_store(&manager->dropped, 0);
+    atomic_store(&manager->registered, 0);
+    atomic_store(&manager->degraded_components, 0);
+    atomic_store(&manager->heartbeat_lock, 0);
     
     // Default configuration
     manager->max_retry_attempts = 3;
@@ -47,14 +103,22 @@ bool fault_tolerance_init(fault_tolerance_manager_t* manager, uint32_t capacity)
     manager->auto_recovery_enabled = true;
     manager->persistent_logging_enabled = true;
     manager->system_health_score = 1.0;
-    
-    // Initialize component health tracking
-    max_components = 64; // Support up to 64 components
-    components = calloc(max_components, sizeof(component_health_t));
-    if (!components) {
-        free(manager->records);
+    manager->heartbeat_timeout_us = FAULT_TOLERANCE_HEARTBEAT_US;
+    timer_wheel_init(&manager->heartbeats, FAULT_TOLERANCE_HEARTBEAT_TICK_NS, umsbb_clock_ns());
+    
+    // Shards on their own cache lines; calloc zeroes every counter
+    manager->shard_block = calloc(1, FAULT_SHARD_STRIDE * FAULT_TOLERANCE_SHARDS + FAULT_TOLERANCE_CACHE_LINE);
+    manager->components = calloc(FAULT_TOLERANCE_MAX_COMPONENTS, sizeof(struct fault_component));
+    if (!manager->shard_block || !manager->components) {
+        free(manager->shard_block);
+        free(manager->components);
+        free(manager->slots);
         return false;
     }
+    uintptr_t aligned = ((uintptr_t)manager->shard_block + FAULT_TOLERANCE_CACHE_LINE - 1) &
+                        ~(uintptr_t)(FAULT_TOLERANCE_CACHE_LINE - 1);
+    manager->shards = (struct fault_shard*)aligned;
+    for (uint32_t i = 0; i < FAULT_TOLERANCE_MAX_COMPONENTS; i++) manager->components[i].component_id = i;
     
     return true;
 }
@@ -62,103 +126,102 @@ bool fault_tolerance_init(fault_tolerance_manager_t* manager, uint32_t capacity)
 void fault_tolerance_destroy(fault_tolerance_manager_t* manager) {
     if (!manager) return;
     
-    if (manager->records) {
-        free(manager->records);
-    }
+    free(manager->slots);
+    free(manager->shard_block);
+    free(manager->components);
     
-    if (components) {
-        free(components);
-        components = NULL;
-    }
+    message_log_close(message_log);
+    message_log = NULL;
     
     memset(manager, 0, sizeof(fault_tolerance_manager_t));
 }
 
+// Claim fault `id`'s slot for writing: from empty or an older fault when
+// publishing it, from the published fault itself when updating it
+static bool slot_claim(struct fault_slot* slot, uint64_t id, bool update) {
+    for (;;) {
+        uint64_t state = atomic_load(&slot->state);
+        bool claimable = update ? state == 2 * id : (state & 1) == 0 && state < 2 * id;
+        if (!claimable) return false;
+        if (atomic_compare_exchange_weak(&slot->state, &state, 2 * id + 1)) return true;
+    }
+}
+
+static inline struct fault_slot* slot_of(const fault_tolerance_manager_t* manager, uint64_t id) {
+    return &manager->slots[(id - 1) % manager->capacity];
+}
+
+static bool apply_recovery(fault_tolerance_manager_t* manager, fault_record_t* record, recovery_action_t action);
+
 uint64_t fault_tolerance_report_fault(fault_tolerance_manager_t* manager, fault_type_t type, 
                                       uint32_t component_id, const char* description) {
     if (!manager) return 0;
     
-    uint32_t current_head = atomic_load(&manager->head);
-    uint32_t index = current_head % manager->capacity;
-    fault_record_t* record = &manager->records[index];
-    
-    uint64_t fault_id = atomic_fetch_add(&manager->total_faults, 1);
-    
-    // Initialize fault record
-    record->fault_id = fault_id;
-    record->type = type;
-    record->timestamp_us = get_timestamp_us();
-    record->component_id = component_id;
-    record->retry_count = 0;
-    record->action_taken = RECOVERY_ACTION_NONE;
-    record->recovery_successful = false;
-    record->recovery_time_us = 0;
+    fault_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.fault_id = atomic_fetch_add(&manager->head, 1) + 1;
+    record.type = type;
+    record.timestamp_us = umsbb_clock_coarse_ns() / 1000;
+    record.component_id = component_id;
+    record.action_taken = RECOVERY_ACTION_NONE;
     
     // Set severity based on fault type
     switch (type) {
         case FAULT_TYPE_CORRUPTION:
         case FAULT_TYPE_DEADLOCK:
-            record->severity = 3; // Critical
+            record.severity = 3; // Critical
             break;
         case FAULT_TYPE_TIMEOUT:
         case FAULT_TYPE_OVERFLOW:
         case FAULT_TYPE_GPU:
-            record->severity = 2; // Error
+            record.severity = 2; // Error
             break;
         case FAULT_TYPE_UNDERFLOW:
         case FAULT_TYPE_MEMORY:
-            record->severity = 1; // Warning
+            record.severity = 1; // Warning
             break;
         default:
-            record->severity = 0; // Info
+            record.severity = 0; // Info
             break;
     }
     
     if (description) {
-        strncpy(record->description, description, sizeof(record->description) - 1);
-        record->description[sizeof(record->description) - 1] = '\0';
+        strncpy(record.description, description, sizeof(record.description) - 1);
     }
     
-    atomic_fetch_add(&manager->head, 1);
-    atomic_fetch_add(&manager->active_faults, 1);
-    
-    // Update component health
-    if (component_id < max_components) {
-        component_health_t* comp = &components[component_id];
-        comp->component_id = component_id;
-        comp->consecutive_failures++;
-        atomic_fetch_add(&comp->failure_count, 1);
-        
-        // Update health score
-        uint64_t total_ops = atomic_load(&comp->operations_count);
-        uint64_t failures = atomic_load(&comp->failure_count);
-        
-        if (total_ops > 0) {
-            comp->health_score = 1.0 - ((double)failures / total_ops);
-        }
-        
-        // Mark as unhealthy if too many consecutive failures
-        if (comp->consecutive_failures >= 5) {
-            comp->is_healthy = false;
-            comp->is_degraded = true;
-        }
+    // Count the failure against the component in this thread's shard
+    if (component_id < FAULT_TOLERANCE_MAX_COMPONENTS) {
+        register_component(manager, component_id);
+        shard_counters_t* counters = &thread_shard(manager)->components[component_id];
+        atomic_fetch_add(&counters->failures, 1);
+        atomic_fetch_add(&counters->streak, 1);
     }
     
-    // Trigger automatic recovery if enabled
+    // Recover before publishing, so readers only ever see the finished record
     if (manager->auto_recovery_enabled) {
-        recovery_action_t action = fault_tolerance_determine_recovery_action(manager, record);
-        fault_tolerance_execute_recovery(manager, fault_id, action);
+        apply_recovery(manager, &record, fault_tolerance_determine_recovery_action(manager, &record));
     }
     
-    // Update system health score
-    uint64_t total_faults = atomic_load(&manager->total_faults);
-    uint64_t recovered_faults = atomic_load(&manager->recovered_faults);
-    
-    if (total_faults > 0) {
-        manager->system_health_score = (double)recovered_faults / total_faults;
+    struct fault_slot* slot = slot_of(manager, record.fault_id);
+    if (slot_claim(slot, record.fault_id, false)) {
+        slot->record = record;
+        atomic_store(&slot->state, 2 * record.fault_id);
+    } else {
+        atomic_fetch_add(&manager->dropped, 1);
     }
     
-    return fault_id;
+    return record.fault_id;
+}
+
+bool fault_tolerance_get_fault(fault_tolerance_manager_t* manager, uint64_t fault_id, fault_record_t* record) {
+    if (!manager || !record || fault_id == 0) return false;
+    
+    struct fault_slot* slot = slot_of(manager, fault_id);
+    if (atomic_load(&slot->state) != 2 * fault_id) return false;
+    *record = slot->record;
+    atomic_thread_fence(memory_order_acquire);
+    // The copy is good only if nobody claimed the slot meanwhile
+    return atomic_load(&slot->state) == 2 * fault_id;
 }
 
 recovery_action_t fault_tolerance_determine_recovery_action(fault_tolerance_manager_t* manager, 
@@ -201,24 +264,12 @@ recovery_action_t fault_tolerance_determine_recovery_action(fault_tolerance_mana
     }
 }
 
-bool fault_tolerance_execute_recovery(fault_tolerance_manager_t* manager, uint64_t fault_id, 
-                                       recovery_action_t action) {
-    if (!manager || action == RECOVERY_ACTION_NONE) return false;
+static bool apply_recovery(fault_tolerance_manager_t* manager, fault_record_t* record, recovery_action_t action) {
+    if (action == RECOVERY_ACTION_NONE) return false;
     
-    uint64_t start_time = get_timestamp_us();
+    uint64_t start_time = umsbb_clock_us();
     bool recovery_successful = false;
     
-    // Find the fault record
-    fault_record_t* record = NULL;
-    for (uint32_t i = 0; i < manager->capacity; i++) {
-        if (manager->records[i].fault_id == fault_id) {
-            record = &manager->records[i];
-            break;
-        }
-    }
-    
-    if (!record) return false;
-    
     record->action_taken = action;
     record->retry_count++;
     
@@ -234,23 +285,22 @@ bool fault_tolerance_execute_recovery(fault_tolerance_manager_t* manager, uint64
             break;
             
         case RECOVERY_ACTION_RESET:
-            // Reset component state
-            if (record->component_id < max_components) {
-                component_health_t* comp = &components[record->component_id];
-                comp->consecutive_failures = 0;
-                comp->is_healthy = true;
-                comp->is_degraded = false;
+            // Reset component state: its failure runs end in every shard
+            if (record->component_id < FAULT_TOLERANCE_MAX_COMPONENTS) {
+                for (uint32_t i = 0; i < FAULT_TOLERANCE_SHARDS; i++) {
+                    atomic_store(&shard_at(manager, i)->components[record->component_id].streak, 0);
+                }
+                atomic_store(&manager->components[record->component_id].isolated, 0);
                 recovery_successful = true;
             }
             break;
             
         case RECOVERY_ACTION_ISOLATE:
             // Isolate faulty component
-            if (record->component_id < max_components) {
-                component_health_t* comp = &components[record->component_id];
-                comp->is_isolated = true;
-                comp->is_healthy = false;
-                manager->degraded_components++;
+            if (record->component_id < FAULT_TOLERANCE_MAX_COMPONENTS) {
+                if (atomic_exchange(&manager->components[record->component_id].isolated, 1) == 0) {
+                    atomic_fetch_add(&manager->degraded_components, 1);
+                }
                 recovery_successful = true;
             }
             break;
@@ -265,78 +315,176 @@ bool fault_tolerance_execute_recovery(fault_tolerance_manager_t* manager, uint64
             break;
     }
     
-    uint64_t end_time = get_timestamp_us();
+    uint64_t end_time = umsbb_clock_us();
     record->recovery_time_us = end_time - start_time;
     record->recovery_successful = recovery_successful;
     
-    manager->total_recovery_time_us += record->recovery_time_us;
-    
+    struct fault_shard* shard = thread_shard(manager);
+    atomic_fetch_add(&shard->recovery_time_us, record->recovery_time_us);
     if (recovery_successful) {
-        atomic_fetch_add(&manager->recovered_faults, 1);
-        atomic_fetch_sub(&manager->active_faults, 1);
+        atomic_fetch_add(&shard->recovered, 1);
     } else {
-        atomic_fetch_add(&manager->unrecoverable_faults, 1);
+        atomic_fetch_add(&shard->unrecoverable, 1);
     }
     
     return recovery_successful;
 }
 
-bool fault_tolerance_is_component_healthy(fault_tolerance_manager_t* manager, uint32_t component_id) {
-    if (!manager || component_id >= max_components) return false;
-    
-    component_health_t* comp = &components[component_id];
-    
-    // Check heartbeat freshness
-    uint64_t current_time = get_timestamp_us();
-    uint64_t last_heartbeat = atomic_load(&comp->last_heartbeat_us);
+bool fault_tolerance_execute_recovery(fault_tolerance_manager_t* manager, uint64_t fault_id, 
+                                       recovery_action_t action) {
+    if (!manager || fault_id == 0 || action == RECOVERY_ACTION_NONE) return false;
+    
+    // The fault must still be in the ring; holding its slot keeps reporters out
+    struct fault_slot* slot = slot_of(manager, fault_id);
+    if (!slot_claim(slot, fault_id, true)) return false;
+    bool recovered = apply_recovery(manager, &slot->record, action);
+    atomic_store(&slot->state, 2 * fault_id);
+    return recovered;
+}
+
+static uint64_t sum_recovered(const fault_tolerance_manager_t* manager) {
+    uint64_t recovered = 0;
+    for (uint32_t i = 0; i < FAULT_TOLERANCE_SHARDS; i++) recovered += atomic_load(&shard_at(manager, i)->recovered);
+    return recovered;
+}
+
+uint64_t fault_tolerance_active_faults(fault_tolerance_manager_t* manager) {
+    if (!manager) return 0;
     
-    if (current_time - last_heartbeat > 5000000) { // 5 seconds
-        comp->is_healthy = false;
-        return false;
+    uint64_t total = atomic_load(&manager->head);
+    uint64_t recovered = sum_recovered(manager);
+    return total > recovered ? total - recovered : 0;
+}
+
+static inline uint64_t max_u64(uint64_t a, uint64_t b) {
+    return a > b ? a : b;
+}
+
+// Sum a component over the shards; health follows from the sums
+static void component_snapshot(const fault_tolerance_manager_t* manager, uint32_t component_id, uint64_t now_us,
+                               component_health_t* health) {
+    uint64_t successes = 0, failures = 0, response = 0, response_max = 0, streak = 0, heartbeat = 0;
+    for (uint32_t i = 0; i < FAULT_TOLERANCE_SHARDS; i++) {
+        const shard_counters_t* counters = &shard_at(manager, i)->components[component_id];
+        successes += atomic_load(&counters->successes);
+        failures += atomic_load(&counters->failures);
+        response += atomic_load(&counters->response_us);
+        response_max = max_u64(response_max, atomic_load(&counters->response_max_us));
+        streak = max_u64(streak, atomic_load(&counters->streak));
+        heartbeat = max_u64(heartbeat, atomic_load(&counters->heartbeat_us));
     }
     
-    return comp->is_healthy && !comp->is_isolated;
+    memset(health, 0, sizeof(*health));
+    uint64_t operations = successes + failures;
+    health->component_id = component_id;
+    health->operations_count = operations;
+    health->success_count = successes;
+    health->failure_count = failures;
+    health->last_heartbeat_us = heartbeat;
+    health->avg_response_time_us = operations ? (double)response / operations : 0.0;
+    health->max_response_time_us = (double)response_max;
+    health->consecutive_failures = (uint32_t)streak;
+    health->is_isolated = atomic_load(&manager->components[component_id].isolated) != 0;
+    health->health_score = operations ? (double)successes / operations : 1.0;
+    
+    bool fresh = heartbeat != 0 && (now_us <= heartbeat || now_us - heartbeat <= manager->heartbeat_timeout_us);
+    health->is_healthy = fresh && !health->is_isolated && health->health_score > 0.95 && streak < 3;
+    health->is_degraded = (health->health_score < 0.95 && health->health_score > 0.7) || streak >= 5;
+}
+
+bool fault_tolerance_get_component_health(fault_tolerance_manager_t* manager, uint32_t component_id,
+                                          component_health_t* health) {
+    if (!manager || !health || component_id >= FAULT_TOLERANCE_MAX_COMPONENTS) return false;
+    if (!(atomic_load(&manager->registered) & (1ull << component_id))) return false;
+    
+    component_snapshot(manager, component_id, umsbb_clock_us(), health);
+    return true;
+}
+
+bool fault_tolerance_is_component_healthy(fault_tolerance_manager_t* manager, uint32_t component_id) {
+    component_health_t health;
+    return fault_tolerance_get_component_health(manager, component_id, &health) && health.is_healthy;
 }
 
 void fault_tolerance_update_component_health(fault_tolerance_manager_t* manager, uint32_t component_id, 
                                              bool operation_success, uint64_t response_time_us) {
-    if (!manager || component_id >= max_components) return;
+    if (!manager || component_id >= FAULT_TOLERANCE_MAX_COMPONENTS) return;
     
-    component_health_t* comp = &components[component_id];
+    register_component(manager, component_id);
+    shard_counters_t* counters = &thread_shard(manager)->components[component_id];
     
     // Update operation counters
-    atomic_fetch_add(&comp->operations_count, 1);
     if (operation_success) {
-        atomic_fetch_add(&comp->success_count, 1);
-        comp->consecutive_failures = 0;
+        atomic_fetch_add(&counters->successes, 1);
+        if (atomic_load(&counters->streak) != 0) atomic_store(&counters->streak, 0);
     } else {
-        atomic_fetch_add(&comp->failure_count, 1);
-        comp->consecutive_failures++;
+        atomic_fetch_add(&counters->failures, 1);
+        atomic_fetch_add(&counters->streak, 1);
     }
     
     // Update response time metrics
-    if (comp->avg_response_time_us == 0.0) {
-        comp->avg_response_time_us = (double)response_time_us;
-    } else {
-        comp->avg_response_time_us = (comp->avg_response_time_us * 0.9) + (response_time_us * 0.1);
+    if (response_time_us) {
+        atomic_fetch_add(&counters->response_us, response_time_us);
+        for (;;) {
+            uint64_t highest = atomic_load(&counters->response_max_us);
+            if (response_time_us <= highest ||
+                atomic_compare_exchange_weak(&counters->response_max_us, &highest, response_time_us)) {
+                break;
+            }
+        }
     }
     
-    if (response_time_us > comp->max_response_time_us) {
-        comp->max_response_time_us = (double)response_time_us;
+    // Stamp the heartbeat; the wheel only needs touching to arm a fresh deadline
+    uint64_t now_us = umsbb_clock_coarse_ns() / 1000;
+    atomic_store(&counters->heartbeat_us, now_us);
+    struct fault_component* component = &manager->components[component_id];
+    if (atomic_load(&component->heartbeat_armed) == 0) {
+        heartbeat_lock(manager);
+        if (atomic_load(&component->heartbeat_armed) == 0) {
+            timer_wheel_arm(&manager->heartbeats, &component->heartbeat_timer,
+                            (now_us + manager->heartbeat_timeout_us) * 1000);
+            atomic_store(&component->heartbeat_armed, 1);
+        }
+        heartbeat_unlock(manager);
     }
-    
-    // Update heartbeat
-    atomic_store(&comp->last_heartbeat_us, get_timestamp_us());
-    
-    // Update health status
-    uint64_t total_ops = atomic_load(&comp->operations_count);
-    uint64_t success_ops = atomic_load(&comp->success_count);
-    
-    if (total_ops > 0) {
-        comp->health_score = (double)success_ops / total_ops;
-        comp->is_healthy = (comp->health_score > 0.95) && (comp->consecutive_failures < 3);
-        comp->is_degraded = (comp->health_score < 0.95) && (comp->health_score > 0.7);
+}
+
+typedef struct {
+    fault_tolerance_manager_t* manager;
+    uint64_t now_us;
+    uint32_t misses;
+} heartbeat_pass_t;
+
+static void on_heartbeat_due(timer_wheel_timer_t* timer, void* context) {
+    heartbeat_pass_t* pass = (heartbeat_pass_t*)context;
+    fault_tolerance_manager_t* manager = pass->manager;
+    struct fault_component* component = TIMER_WHEEL_ENTRY(timer, struct fault_component, heartbeat_timer);
+    
+    uint64_t heartbeat = 0;
+    for (uint32_t i = 0; i < FAULT_TOLERANCE_SHARDS; i++) {
+        heartbeat = max_u64(heartbeat, atomic_load(&shard_at(manager, i)->components[component->component_id].heartbeat_us));
+    }
+    uint64_t deadline_us = heartbeat + manager->heartbeat_timeout_us;
+    if (deadline_us > pass->now_us) {
+        // Updated since it was armed: wait for the deadline that stamp set
+        timer_wheel_arm(&manager->heartbeats, timer, deadline_us * 1000);
+        return;
     }
+    // Overdue; the next update arms it again
+    atomic_store(&component->heartbeat_armed, 0);
+    manager->heartbeat_misses++;
+    pass->misses++;
+}
+
+uint32_t fault_tolerance_check_heartbeats(fault_tolerance_manager_t* manager) {
+    if (!manager) return 0;
+    
+    uint64_t now_ns = umsbb_clock_ns();
+    heartbeat_pass_t pass = { manager, now_ns / 1000, 0 };
+    heartbeat_lock(manager);
+    timer_wheel_advance(&manager->heartbeats, now_ns, on_heartbeat_due, &pass);
+    heartbeat_unlock(manager);
+    return pass.misses;
 }
 
 double fault_tolerance_get_system_health(fault_tolerance_manager_t* manager) {
@@ -345,21 +493,25 @@ double fault_tolerance_get_system_health(fault_tolerance_manager_t* manager) {
     // Calculate system health based on component health and fault rates
     double total_health = 0.0;
     uint32_t healthy_components = 0;
-    
-    for (uint32_t i = 0; i < component_count; i++) {
-        component_health_t* comp = &components[i];
-        if (comp->component_id != 0) { // Valid component
-            total_health += comp->health_score;
-            if (comp->is_healthy) healthy_components++;
-        }
+    uint32_t component_count = 0;
+    uint64_t registered = atomic_load(&manager->registered);
+    uint64_t now_us = umsbb_clock_us();
+    
+    for (uint32_t i = 0; i < FAULT_TOLERANCE_MAX_COMPONENTS; i++) {
+        if (!(registered & (1ull << i))) continue;
+        component_health_t health;
+        component_snapshot(manager, i, now_us, &health);
+        total_health += health.health_score;
+        if (health.is_healthy) healthy_components++;
+        component_count++;
     }
     
     double component_health_avg = (component_count > 0) ? (total_health / component_count) : 1.0;
     double component_availability = (component_count > 0) ? ((double)healthy_components / component_count) : 1.0;
     
     // Factor in fault recovery rate
-    uint64_t total_faults = atomic_load(&manager->total_faults);
-    uint64_t recovered_faults = atomic_load(&manager->recovered_faults);
+    uint64_t total_faults = atomic_load(&manager->head);
+    uint64_t recovered_faults = sum_recovered(manager);
     double recovery_rate = (total_faults > 0) ? ((double)recovered_faults / total_faults) : 1.0;
     
     // Weighted system health score
@@ -375,14 +527,14 @@ void fault_tolerance_get_metrics(fault_tolerance_manager_t* manager, struct faul
     
     memset(metrics, 0, sizeof(struct fault_tolerance_metrics));
     
-    metrics->total_faults = atomic_load(&manager->total_faults);
-    metrics->active_faults = atomic_load(&manager->active_faults);
+    metrics->total_faults = atomic_load(&manager->head);
+    metrics->active_faults = fault_tolerance_active_faults(manager);
     
     // Calculate fault rate (simplified)
     static uint64_t last_faults = 0;
     static uint64_t last_timestamp = 0;
     
-    uint64_t current_time = get_timestamp_us();
+    uint64_t current_time = umsbb_clock_us();
     uint64_t time_diff = current_time - last_timestamp;
     
     if (time_diff > 0) {
@@ -394,40 +546,115 @@ void fault_tolerance_get_metrics(fault_tolerance_manager_t* manager, struct faul
     }
     
     // Calculate recovery success rate
-    uint64_t recovered = atomic_load(&manager->recovered_faults);
+    uint64_t recovered = sum_recovered(manager);
     if (metrics->total_faults > 0) {
         metrics->recovery_success_rate = ((double)recovered / metrics->total_faults) * 100.0;
     }
     
     // Calculate average recovery time
+    uint64_t recovery_time_us = 0;
+    for (uint32_t i = 0; i < FAULT_TOLERANCE_SHARDS; i++) {
+        recovery_time_us += atomic_load(&shard_at(manager, i)->recovery_time_us);
+    }
     if (recovered > 0) {
-        metrics->avg_recovery_time_us = (double)manager->total_recovery_time_us / recovered;
+        metrics->avg_recovery_time_us = (double)recovery_time_us / recovered;
     }
     
     metrics->system_health_score = fault_tolerance_get_system_health(manager);
-    metrics->degraded_components = manager->degraded_components;
+    metrics->degraded_components = atomic_load(&manager->degraded_components);
+    metrics->faults_dropped = atomic_load(&manager->dropped);
+    
+    metrics->messages_persisted = atomic_load(&messages_persisted);
+    metrics->messages_recovered = atomic_load(&messages_recovered);
+}
+
+// Message persistence through the process-wide message log
+bool fault_tolerance_enable_persistence(fault_tolerance_manager_t* manager, const char* directory,
+                                        const message_log_config_t* config) {
+    if (!manager || !directory || !manager->persistent_logging_enabled) return false;
+    
+    message_log_close(message_log);
+    message_log = message_log_open(directory, config);
+    return message_log != NULL;
+}
+
+void fault_tolerance_set_lane_durability(fault_tolerance_manager_t* manager, uint32_t lane,
+                                         message_log_durability_t durability) {
+    if (!manager) return;
+    
+    message_log_set_lane_durability(message_log, lane, durability);
+}
+
+void fault_tolerance_set_replay_handler(fault_tolerance_manager_t* manager, message_log_replay_fn handler, void* context) {
+    if (!manager) return;
     
-    // Note: Message persistence metrics would be tracked separately
-    metrics->messages_persisted = 0; // Placeholder
-    metrics->messages_recovered = 0; // Placeholder
+    manager->replay_handler = handler;
+    manager->replay_context = context;
 }
 
-// Message persistence functions (simplified implementations)
 bool fault_tolerance_persist_message(uint64_t sequence, const void* data, size_t size) {
-    // In a real implementation, this would write to persistent storage
-    // For now, just return success
+    return fault_tolerance_persist_lane_message(0, sequence, data, size);
+}
+
+bool fault_tolerance_persist_lane_message(uint32_t lane, uint64_t sequence, const void* data, size_t size) {
+    if (!message_log || message_log_append(message_log, lane, sequence, data, size) == 0) return false;
+    
+    atomic_fetch_add(&messages_persisted, 1);
     return true;
 }
 
 void* fault_tolerance_recover_message(uint64_t sequence, size_t* size) {
-    // In a real implementation, this would read from persistent storage
-    // For now, return NULL (message not found)
-    *size = 0;
-    return NULL;
+    if (size) *size = 0;
+    void* data = message_log_read(message_log, sequence, size, NULL);
+    if (data) atomic_fetch_add(&messages_recovered, 1);
+    return data;
+}
+
+static void ignore_replayed(void* context, uint32_t lane, uint64_t sequence, const void* data, size_t size) {
+    (void)context;
+    (void)lane;
+    (void)sequence;
+    (void)data;
+    (void)size;
 }
 
 bool fault_tolerance_replay_messages(fault_tolerance_manager_t* manager, uint64_t from_sequence, uint64_t to_sequence) {
-    // In a real implementation, this would replay messages from persistent storage
-    // For now, just return success
-    return true;
-}
\ No newline at end of file
+    if (!manager || !message_log) return false;
+    
+    // Without a handler the replay still proves every record reads back intact
+    message_log_replay_fn handler = manager->replay_handler ? manager->replay_handler : ignore_replayed;
+    uint64_t delivered = 0;
+    bool intact = message_log_replay_parallel(message_log, from_sequence, to_sequence, handler,
+                                              manager->replay_context, 0, &delivered);
+    atomic_fetch_add(&messages_recovered, delivered);
+    return intact;
+}
+
+static double metric_faults_recovered(const void* context) {
+    return (double)sum_recovered((const fault_tolerance_manager_t*)context);
+}
+
+static double metric_faults_active(const void* context) {
+    const fault_tolerance_manager_t* manager = (const fault_tolerance_manager_t*)context;
+    uint64_t total = atomic_load(&manager->head);
+    uint64_t recovered = sum_recovered(manager);
+    return total > recovered ? (double)(total - recovered) : 0.0;
+}
+
+bool fault_tolerance_register_metrics(fault_tolerance_manager_t* manager, MetricsRegistry* registry,
+                                      const char* labels) {
+    if (!manager || !registry) return false;
+    bool ok = true;
+    ok &= metrics_registry_add(registry, manager, METRIC_COUNTER, "umsbb_faults_total",
+                               "Faults reported", labels, METRIC_U64, &manager->head);
+    ok &= metrics_registry_add(registry, manager, METRIC_COUNTER, "umsbb_faults_dropped_total",
+                               "Fault reports dropped while their ring slot was still being written", labels, METRIC_U64,
+                               &manager->dropped);
+    ok &= metrics_registry_add_fn(registry, manager, METRIC_COUNTER, "umsbb_faults_recovered_total",
+                                  "Faults recovered", labels, metric_faults_recovered, manager);
+    ok &= metrics_registry_add_fn(registry, manager, METRIC_GAUGE, "umsbb_faults_active",
+                                  "Faults reported and not yet recovered", labels, metric_faults_active, manager);
+    ok &= metrics_registry_add(registry, manager, METRIC_GAUGE, "umsbb_degraded_components",
+                               "Components currently degraded", labels, METRIC_U32, &manager->degraded_components);
+    return ok;
+}
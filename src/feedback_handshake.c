@@ -1,25 +1,11 @@
 #include "feedback_handshake.h"
+#include "umsbb_clock.h"
+#include "umsbb_trace.h"
+#include "message_pool.h"
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-#ifdef _WIN32
-    #include <windows.h>
-    static uint64_t get_timestamp_us() {
-        LARGE_INTEGER frequency, counter;
-        QueryPerformanceFrequency(&frequency);
-        QueryPerformanceCounter(&counter);
-        return (counter.QuadPart * 1000000ULL) / frequency.QuadPart;
-    }
-#else
-    #include <sys/time.h>
-    static uint64_t get_timestamp_us() {
-        struct timeval tv;
-        gettimeofday(&tv, NULL);
-        return tv.tv_sec * 1000000ULL + tv.tv_usec;
-    }
-#endif
-
 static uint32_t calculate_hash(const void* data, size_t size) {
     // Simple FNV-1a hash for message integrity
     const uint8_t* bytes = (const uint8_t*)data;
@@ -33,6 +19,42 @@ static uint32_t calculate_hash(const void* data, size_t size) {
     return hash;
 }
 
+// Refcount ahead of the retained bytes; 16 bytes keeps the payload pool-aligned
+typedef struct {
+    UMSBB_ATOMIC(uint32_t) refs;
+    uint32_t reserved[3];
+} payload_header_t;
+
+static inline payload_header_t* payload_header(const void* payload) {
+    return (payload_header_t*)((char*)payload - sizeof(payload_header_t));
+}
+
+static const void* payload_copy(const void* data, size_t size) {
+    payload_header_t* header = (payload_header_t*)message_pool_alloc(sizeof(payload_header_t) + size);
+    if (!header) return NULL;
+    atomic_store(&header->refs, 1);
+    memcpy(header + 1, data, size);
+    return header + 1;
+}
+
+void handshake_payload_retain(const void* payload) {
+    if (payload) atomic_fetch_add(&payload_header(payload)->refs, 1);
+}
+
+void handshake_payload_release(const void* payload) {
+    if (!payload) return;
+    payload_header_t* header = payload_header(payload);
+    if (atomic_fetch_sub(&header->refs, 1) == 1) message_pool_release(header);
+}
+
+// The entry is settled: give up its hold on the payload
+static void drop_payload(handshake_manager_t* manager, handshake_entry_t* entry) {
+    if (!entry->payload) return;
+    manager->retained_bytes -= entry->message_size;
+    handshake_payload_release(entry->payload);
+    entry->payload = NULL;
+}
+
 bool handshake_init(handshake_manager_t* manager, uint32_t capacity) {
     if (!manager || capacity == 0) return false;
     
@@ -41,9 +63,16 @@ bool handshake_init(handshake_manager_t* manager, uint32_t capacity) {
     manager->entries = calloc(capacity, sizeof(handshake_entry_t));
     if (!manager->entries) return false;
     
+    manager->ack_latency = latency_histogram_create();
+    if (!manager->ack_latency) {
+        free(manager->entries);
+        manager->entries = NULL;
+        return false;
+    }
+    
     manager->capacity = capacity;
-    atomic_store(&manager->head, 0);
-    atomic_store(&manager->tail, 0);
+    atomic_store(&manager->head, 1);
+    atomic_store(&manager->tail, 1);
     atomic_store(&manager->pending_count, 0);
     
     // Default configuration
@@ -51,6 +80,11 @@ bool handshake_init(handshake_manager_t* manager, uint32_t capacity) {
     manager->max_retries = 3;
     manager->retry_backoff_ms = 100;     // 100ms backoff
     manager->zero_loss_mode = true;      // Enable zero-loss by default
+    manager->retain_budget = HANDSHAKE_RETAIN_BUDGET;
+    
+    uint64_t now_us = umsbb_clock_us();
+    timer_wheel_init(&manager->timers, HANDSHAKE_TICK_NS, now_us * 1000);
+    manager->jitter_state = (now_us ^ (uint64_t)(uintptr_t)manager) | 1;
     
     return true;
 }
@@ -59,8 +93,10 @@ void handshake_destroy(handshake_manager_t* manager) {
     if (!manager) return;
     
     if (manager->entries) {
+        for (uint32_t i = 0; i < manager->capacity; i++) drop_payload(manager, &manager->entries[i]);
         free(manager->entries);
     }
+    latency_histogram_destroy(manager->ack_latency);
     
     memset(manager, 0, sizeof(handshake_manager_t));
 }
@@ -73,10 +109,21 @@ uint64_t handshake_send_message(handshake_manager_t* manager, uint32_t producer_
     uint32_t current_tail = atomic_load(&manager->tail);
     
     // Check if queue is full
-    if ((current_head + 1) % manager->capacity == current_tail) {
+    if (current_head - current_tail >= manager->capacity) {
         return 0; // Queue full
     }
     
+    const void* payload = NULL;
+    if (manager->retain_budget > 0) {
+        if (manager->retained_bytes + size > manager->retain_budget) {
+            manager->budget_rejections++;
+            return 0; // Retransmit store full
+        }
+        payload = payload_copy(data, size);
+        if (!payload) return 0;
+        manager->retained_bytes += size;
+    }
+    
     uint64_t sequence = atomic_fetch_add(&manager->head, 1);
     uint32_t index = sequence % manager->capacity;
     handshake_entry_t* entry = &manager->entries[index];
@@ -85,7 +132,7 @@ uint64_t handshake_send_message(handshake_manager_t* manager, uint32_t producer_
     entry->sequence = sequence;
     entry->producer_id = producer_id;
     entry->consumer_id = consumer_id;
-    entry->timestamp_us = get_timestamp_us();
+    entry->timestamp_us = umsbb_clock_us();
     entry->state = HANDSHAKE_STATE_PENDING;
     entry->retry_count = 0;
     entry->message_size = size;
@@ -93,155 +140,273 @@ uint64_t handshake_send_message(handshake_manager_t* manager, uint32_t producer_
     entry->sent_timestamp_us = entry->timestamp_us;
     entry->ack_timestamp_us = 0;
     entry->timeout_ms = manager->default_timeout_ms;
+    entry->payload = payload;
+    timer_wheel_arm(&manager->timers, &entry->timer, (entry->sent_timestamp_us + entry->timeout_ms * 1000ull) * 1000);
     
     // Increment pending count
     atomic_fetch_add(&manager->pending_count, 1);
     manager->total_messages++;
+    UMSBB_TRACE(UMSBB_TRACE_HANDSHAKE, UMSBB_TRACE_SUBMIT, consumer_id, sequence);
     
     return sequence;
 }
 
-bool handshake_process_feedback(handshake_manager_t* manager, const feedback_message_t* feedback) {
-    if (!manager || !feedback) return false;
+static inline bool entry_in_flight(const handshake_entry_t* entry) {
+    return entry->state == HANDSHAKE_STATE_PENDING || entry->state == HANDSHAKE_STATE_RETRY;
+}
+
+// The in-flight entry for `sequence`, or NULL if it left the window or
+// belongs to another producer/consumer pair
+static handshake_entry_t* find_entry(handshake_manager_t* manager, uint64_t sequence,
+                                     uint32_t producer_id, uint32_t consumer_id) {
+    uint32_t tail = atomic_load(&manager->tail);
+    uint32_t head = atomic_load(&manager->head);
+    if ((uint32_t)sequence - tail >= head - tail) return NULL;
+    handshake_entry_t* entry = &manager->entries[sequence % manager->capacity];
+    if (entry->sequence != sequence || entry->producer_id != producer_id || entry->consumer_id != consumer_id) {
+        return NULL;
+    }
+    return entry;
+}
+
+// Resend after retry_backoff_ms << (retry_count - 1), less up to half of it
+static void schedule_retry(handshake_manager_t* manager, handshake_entry_t* entry, uint64_t now) {
+    uint32_t shift = entry->retry_count > 0 ? entry->retry_count - 1 : 0;
+    if (shift > HANDSHAKE_MAX_BACKOFF_SHIFT) shift = HANDSHAKE_MAX_BACKOFF_SHIFT;
+    uint64_t backoff_us = ((uint64_t)manager->retry_backoff_ms * 1000) << shift;
+    
+    // xorshift64: jitter only needs to decorrelate, not be unpredictable
+    uint64_t x = manager->jitter_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    manager->jitter_state = x;
+    backoff_us -= x % (backoff_us / 2 + 1);
+    
+    entry->state = HANDSHAKE_STATE_RETRY;
+    timer_wheel_arm(&manager->timers, &entry->timer, (now + backoff_us) * 1000);
+}
+
+// Out of retries: the entry leaves the in-flight set as `state`
+static void fail_entry(handshake_manager_t* manager, handshake_entry_t* entry, handshake_state_t state) {
+    entry->state = state;
+    UMSBB_TRACE_ALWAYS(UMSBB_TRACE_HANDSHAKE, UMSBB_TRACE_FAIL, entry->consumer_id, entry->sequence);
+    timer_wheel_cancel(&manager->timers, &entry->timer);
+    drop_payload(manager, entry);
+    manager->failed_deliveries++;
+    atomic_fetch_sub(&manager->pending_count, 1);
+}
+
+static void ack_entry(handshake_manager_t* manager, handshake_entry_t* entry, uint64_t now) {
+    timer_wheel_cancel(&manager->timers, &entry->timer);
+    drop_payload(manager, entry);
+    entry->ack_timestamp_us = now;
+    entry->state = HANDSHAKE_STATE_ACKED;
+    manager->successful_acks++;
+    UMSBB_TRACE(UMSBB_TRACE_HANDSHAKE, UMSBB_TRACE_ACK, entry->consumer_id, entry->sequence);
+    
+    // Calculate and update latency metrics
+    latency_histogram_record(manager->ack_latency, (now - entry->sent_timestamp_us) * 1000);
+    
+    // Decrement pending count
+    atomic_fetch_sub(&manager->pending_count, 1);
+}
+
+// Every in-flight entry of the pair up to the cumulative point, then the bitmap
+static bool apply_sack(handshake_manager_t* manager, const feedback_message_t* feedback, uint64_t now) {
+    bool matched = false;
+    uint32_t tail = atomic_load(&manager->tail);
+    uint32_t span = atomic_load(&manager->head) - tail;
+    uint32_t covered = (uint32_t)feedback->sequence + 1 - tail;
+    if (covered > span) covered = covered > 1u << 31 ? 0 : span; // Behind the window, or past its head
+    for (uint32_t sequence = tail; sequence != tail + covered; sequence++) {
+        handshake_entry_t* entry = &manager->entries[sequence % manager->capacity];
+        if (entry->producer_id != feedback->producer_id || entry->consumer_id != feedback->consumer_id) continue;
+        matched = true;
+        if (entry_in_flight(entry)) ack_entry(manager, entry, now);
+    }
+    for (uint32_t bit = 0; bit < 64; bit++) {
+        if (!(feedback->sack_bitmap >> bit & 1)) continue;
+        uint64_t sequence = feedback->sack_base + bit;
+        handshake_entry_t* entry = find_entry(manager, sequence, feedback->producer_id, feedback->consumer_id);
+        if (!entry) continue;
+        matched = true;
+        if (entry_in_flight(entry)) ack_entry(manager, entry, now);
+    }
+    return matched;
+}
+
+static bool apply_feedback(handshake_manager_t* manager, const feedback_message_t* feedback, uint64_t now) {
+    if (feedback->type == FEEDBACK_TYPE_SACK) return apply_sack(manager, feedback, now);
+    if (feedback->type == FEEDBACK_TYPE_READY) return true; // Proactive flow control, no entry
     
     // Find the handshake entry by sequence
-    uint32_t index = feedback->sequence % manager->capacity;
-    handshake_entry_t* entry = &manager->entries[index];
-    
-    // Verify this is the correct entry
-    if (entry->sequence != feedback->sequence || 
-        entry->producer_id != feedback->producer_id ||
-        entry->consumer_id != feedback->consumer_id) {
+    handshake_entry_t* entry = find_entry(manager, feedback->sequence, feedback->producer_id, feedback->consumer_id);
+    if (!entry) {
         return false; // Entry mismatch
     }
-    
-    uint64_t current_time = get_timestamp_us();
-    entry->ack_timestamp_us = current_time;
+    // Late duplicates of a settled entry change nothing
+    if (!entry_in_flight(entry)) return true;
     
     switch (feedback->type) {
         case FEEDBACK_TYPE_ACK:
-            entry->state = HANDSHAKE_STATE_ACKED;
-            manager->successful_acks++;
-            
-            // Calculate and update latency metrics
-            double ack_latency = (double)(current_time - entry->sent_timestamp_us);
-            if (manager->avg_ack_latency_us == 0.0) {
-                manager->avg_ack_latency_us = ack_latency;
-            } else {
-                manager->avg_ack_latency_us = (manager->avg_ack_latency_us * 0.9) + (ack_latency * 0.1);
-            }
-            
-            // Decrement pending count
-            atomic_fetch_sub(&manager->pending_count, 1);
+            ack_entry(manager, entry, now);
             break;
             
         case FEEDBACK_TYPE_NACK:
-            entry->state = HANDSHAKE_STATE_NACKED;
+            entry->ack_timestamp_us = now;
             if (manager->zero_loss_mode && entry->retry_count < manager->max_retries) {
-                entry->state = HANDSHAKE_STATE_RETRY;
                 entry->retry_count++;
                 manager->retries++;
+                schedule_retry(manager, entry, now);
             } else {
-                manager->failed_deliveries++;
-                atomic_fetch_sub(&manager->pending_count, 1);
+                fail_entry(manager, entry, HANDSHAKE_STATE_NACKED);
             }
             break;
             
         case FEEDBACK_TYPE_BUSY:
             // Consumer is busy, schedule retry
+            entry->ack_timestamp_us = now;
             if (entry->retry_count < manager->max_retries) {
-                entry->state = HANDSHAKE_STATE_RETRY;
                 entry->retry_count++;
                 entry->timeout_ms += manager->retry_backoff_ms; // Increase timeout
                 manager->retries++;
+                schedule_retry(manager, entry, now);
             } else {
-                entry->state = HANDSHAKE_STATE_NACKED;
-                manager->failed_deliveries++;
-                atomic_fetch_sub(&manager->pending_count, 1);
+                fail_entry(manager, entry, HANDSHAKE_STATE_NACKED);
             }
             break;
             
         case FEEDBACK_TYPE_OVERFLOW:
             // Buffer overflow, schedule retry with longer timeout
+            entry->ack_timestamp_us = now;
             if (entry->retry_count < manager->max_retries) {
-                entry->state = HANDSHAKE_STATE_RETRY;
                 entry->retry_count++;
                 entry->timeout_ms *= 2; // Exponential backoff
                 manager->retries++;
+                schedule_retry(manager, entry, now);
             } else {
-                entry->state = HANDSHAKE_STATE_NACKED;
-                manager->failed_deliveries++;
-                atomic_fetch_sub(&manager->pending_count, 1);
+                fail_entry(manager, entry, HANDSHAKE_STATE_NACKED);
             }
             break;
             
-        case FEEDBACK_TYPE_READY:
-            // Consumer is ready for next message (proactive flow control)
-            // This doesn't change the current entry state but signals readiness
+        default:
             break;
     }
     
     return true;
 }
 
-void handshake_process_timeouts(handshake_manager_t* manager) {
-    if (!manager) return;
-    
-    uint64_t current_time = get_timestamp_us();
-    uint32_t current_tail = atomic_load(&manager->tail);
-    uint32_t current_head = atomic_load(&manager->head);
+// Move the tail past settled entries so their slots can be reused
+static void retire_settled(handshake_manager_t* manager) {
+    uint32_t tail = atomic_load(&manager->tail);
+    uint32_t head = atomic_load(&manager->head);
+    while (tail != head && !entry_in_flight(&manager->entries[tail % manager->capacity])) tail++;
+    atomic_store(&manager->tail, tail);
+}
+
+bool handshake_process_feedback(handshake_manager_t* manager, const feedback_message_t* feedback) {
+    if (!manager || !feedback) return false;
     
-    // Process entries from tail to head
-    for (uint32_t i = current_tail; i < current_head; i++) {
-        uint32_t index = i % manager->capacity;
-        handshake_entry_t* entry = &manager->entries[index];
-        
-        if (entry->state != HANDSHAKE_STATE_PENDING) continue;
-        
-        // Check if timeout occurred
-        uint64_t elapsed_us = current_time - entry->sent_timestamp_us;
-        if (elapsed_us > (entry->timeout_ms * 1000)) {
-            entry->state = HANDSHAKE_STATE_TIMEOUT;
-            manager->timeouts++;
-            
-            if (manager->zero_loss_mode && entry->retry_count < manager->max_retries) {
-                entry->state = HANDSHAKE_STATE_RETRY;
-                entry->retry_count++;
-                entry->timeout_ms *= 2; // Exponential backoff
-                manager->retries++;
-            } else {
-                manager->failed_deliveries++;
-                atomic_fetch_sub(&manager->pending_count, 1);
+    bool matched = apply_feedback(manager, feedback, umsbb_clock_us());
+    retire_settled(manager);
+    return matched;
+}
+
+uint32_t handshake_process_feedback_batch(handshake_manager_t* manager, const feedback_message_t* feedback,
+                                          uint32_t count) {
+    if (!manager || !feedback) return 0;
+    
+    uint64_t now = umsbb_clock_us();
+    uint32_t matched = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        matched += apply_feedback(manager, &feedback[i], now);
+    }
+    retire_settled(manager);
+    return matched;
+}
+
+typedef struct {
+    handshake_manager_t* manager;
+    uint64_t now;
+} handshake_timer_pass_t;
+
+static void on_entry_timer(timer_wheel_timer_t* timer, void* context) {
+    handshake_timer_pass_t* pass = (handshake_timer_pass_t*)context;
+    handshake_manager_t* manager = pass->manager;
+    handshake_entry_t* entry = TIMER_WHEEL_ENTRY(timer, handshake_entry_t, timer);
+    
+    if (entry->state == HANDSHAKE_STATE_RETRY) {
+        if (manager->resend && entry->payload) {
+            if (!manager->resend(manager->resend_context, entry, entry->payload)) {
+                manager->resend_failures++;
+                schedule_retry(manager, entry, pass->now);
+                return;
             }
+            manager->resends++;
         }
+        // Backoff elapsed: back in flight with a fresh ACK deadline
+        UMSBB_TRACE_ALWAYS(UMSBB_TRACE_HANDSHAKE, UMSBB_TRACE_RETRY, entry->consumer_id, entry->sequence);
+        entry->state = HANDSHAKE_STATE_PENDING;
+        entry->sent_timestamp_us = pass->now;
+        entry->ack_timestamp_us = 0;
+        timer_wheel_arm(&manager->timers, &entry->timer, (pass->now + entry->timeout_ms * 1000ull) * 1000);
+        manager->resends_due++;
+        return;
     }
+    if (entry->state != HANDSHAKE_STATE_PENDING) return;
+    
+    // ACK deadline missed
+    manager->timeouts++;
+    UMSBB_TRACE_ALWAYS(UMSBB_TRACE_HANDSHAKE, UMSBB_TRACE_TIMEOUT, entry->consumer_id, entry->sequence);
+    if (manager->zero_loss_mode && entry->retry_count < manager->max_retries) {
+        entry->retry_count++;
+        entry->timeout_ms *= 2; // Exponential backoff
+        manager->retries++;
+        schedule_retry(manager, entry, pass->now);
+    } else {
+        fail_entry(manager, entry, HANDSHAKE_STATE_TIMEOUT);
+    }
+}
+
+static void advance_timers(handshake_manager_t* manager) {
+    handshake_timer_pass_t pass = { manager, umsbb_clock_us() };
+    timer_wheel_advance(&manager->timers, pass.now * 1000, on_entry_timer, &pass);
+    retire_settled(manager);
+}
+
+void handshake_process_timeouts(handshake_manager_t* manager) {
+    if (!manager) return;
+    
+    advance_timers(manager);
 }
 
 bool handshake_retry_failed_messages(handshake_manager_t* manager) {
     if (!manager) return false;
     
-    uint32_t retries_processed = 0;
-    uint32_t current_tail = atomic_load(&manager->tail);
-    uint32_t current_head = atomic_load(&manager->head);
-    
-    // Process entries marked for retry
-    for (uint32_t i = current_tail; i < current_head; i++) {
-        uint32_t index = i % manager->capacity;
-        handshake_entry_t* entry = &manager->entries[index];
-        
-        if (entry->state == HANDSHAKE_STATE_RETRY) {
-            // Reset entry for retry
-            entry->state = HANDSHAKE_STATE_PENDING;
-            entry->sent_timestamp_us = get_timestamp_us();
-            entry->ack_timestamp_us = 0;
-            retries_processed++;
-            
-            // Limit retries per call to prevent blocking
-            if (retries_processed >= 10) break;
-        }
-    }
+    advance_timers(manager);
+    bool resent = manager->resends_due > 0;
+    manager->resends_due = 0;
+    return resent;
+}
+
+void handshake_set_retransmit(handshake_manager_t* manager, size_t budget, handshake_resend_fn resend, void* context) {
+    if (!manager) return;
     
-    return retries_processed > 0;
+    manager->retain_budget = budget;
+    manager->resend = resend;
+    manager->resend_context = context;
+}
+
+const void* handshake_get_payload(handshake_manager_t* manager, uint64_t sequence, size_t* size) {
+    if (!manager) return NULL;
+    
+    uint32_t tail = atomic_load(&manager->tail);
+    if ((uint32_t)sequence - tail >= atomic_load(&manager->head) - tail) return NULL;
+    handshake_entry_t* entry = &manager->entries[sequence % manager->capacity];
+    if (entry->sequence != sequence || !entry->payload) return NULL;
+    if (size) *size = entry->message_size;
+    return entry->payload;
 }
 
 feedback_message_t handshake_create_ack(uint64_t sequence, uint32_t producer_id, uint32_t consumer_id) {
@@ -250,7 +415,7 @@ feedback_message_t handshake_create_ack(uint64_t sequence, uint32_t producer_id,
     feedback.type = FEEDBACK_TYPE_ACK;
     feedback.producer_id = producer_id;
     feedback.consumer_id = consumer_id;
-    feedback.timestamp_us = get_timestamp_us();
+    feedback.timestamp_us = umsbb_clock_coarse_ns() / 1000;
     feedback.error_code = 0;
     strcpy(feedback.error_message, "OK");
     return feedback;
@@ -263,7 +428,7 @@ feedback_message_t handshake_create_nack(uint64_t sequence, uint32_t producer_id
     feedback.type = FEEDBACK_TYPE_NACK;
     feedback.producer_id = producer_id;
     feedback.consumer_id = consumer_id;
-    feedback.timestamp_us = get_timestamp_us();
+    feedback.timestamp_us = umsbb_clock_coarse_ns() / 1000;
     feedback.error_code = error_code;
     
     if (error_message) {
@@ -280,12 +445,107 @@ feedback_message_t handshake_create_ready(uint32_t producer_id, uint32_t consume
     feedback.type = FEEDBACK_TYPE_READY;
     feedback.producer_id = producer_id;
     feedback.consumer_id = consumer_id;
-    feedback.timestamp_us = get_timestamp_us();
+    feedback.timestamp_us = umsbb_clock_coarse_ns() / 1000;
     feedback.error_code = 0;
     strcpy(feedback.error_message, "READY");
     return feedback;
 }
 
+feedback_message_t handshake_create_sack(uint64_t cumulative, uint64_t sack_base, uint64_t sack_bitmap,
+                                         uint32_t producer_id, uint32_t consumer_id) {
+    feedback_message_t feedback = {0};
+    feedback.sequence = cumulative;
+    feedback.type = FEEDBACK_TYPE_SACK;
+    feedback.producer_id = producer_id;
+    feedback.consumer_id = consumer_id;
+    feedback.timestamp_us = umsbb_clock_coarse_ns() / 1000;
+    feedback.sack_base = sack_base;
+    feedback.sack_bitmap = sack_bitmap;
+    return feedback;
+}
+
+void handshake_coalescer_init(handshake_ack_coalescer_t* coalescer, uint32_t producer_id, uint32_t consumer_id,
+                              uint32_t max_messages, uint32_t max_delay_us) {
+    if (!coalescer) return;
+    
+    memset(coalescer, 0, sizeof(*coalescer));
+    coalescer->producer_id = producer_id;
+    coalescer->consumer_id = consumer_id;
+    coalescer->max_messages = max_messages ? max_messages : 1;
+    coalescer->max_delay_us = max_delay_us;
+}
+
+static void coalescer_emit(handshake_ack_coalescer_t* coalescer, feedback_message_t* ack) {
+    *ack = handshake_create_sack(coalescer->cumulative, coalescer->sack_base, coalescer->sack_bitmap,
+                                 coalescer->producer_id, coalescer->consumer_id);
+    coalescer->unacked = 0;
+}
+
+// Pull bitmap bits that became contiguous into the cumulative point
+static void coalescer_fold(handshake_ack_coalescer_t* coalescer) {
+    while (coalescer->sack_bitmap && coalescer->sack_base <= coalescer->cumulative + 1) {
+        uint64_t covered = coalescer->cumulative + 1 - coalescer->sack_base;
+        if (covered >= 64) {
+            coalescer->sack_bitmap = 0;
+            break;
+        }
+        coalescer->sack_bitmap >>= covered;
+        coalescer->sack_base += covered;
+        if (!(coalescer->sack_bitmap & 1)) break;
+        coalescer->sack_bitmap >>= 1;
+        coalescer->sack_base++;
+        coalescer->cumulative++;
+    }
+}
+
+bool handshake_coalescer_receive(handshake_ack_coalescer_t* coalescer, uint64_t sequence, feedback_message_t* ack) {
+    if (!coalescer || !ack || sequence == 0) return false;
+    
+    uint64_t now = umsbb_clock_coarse_ns() / 1000;
+    bool due = false;
+    if (sequence == coalescer->cumulative + 1) {
+        coalescer->cumulative++;
+        coalescer_fold(coalescer);
+    } else if (sequence > coalescer->cumulative) {
+        if (!coalescer->sack_bitmap) coalescer->sack_base = sequence;
+        if (sequence < coalescer->sack_base) {
+            // Reordered below the bitmap: move its base down if the top still fits
+            uint64_t shift = coalescer->sack_base - sequence;
+            if (shift < 64 && !(coalescer->sack_bitmap >> (64 - shift))) {
+                coalescer->sack_bitmap <<= shift;
+                coalescer->sack_base = sequence;
+            }
+        }
+        if (sequence < coalescer->sack_base || sequence - coalescer->sack_base >= 64) {
+            // Outside the bitmap: send what it holds and restart it here
+            coalescer_emit(coalescer, ack);
+            coalescer->sack_base = sequence;
+            coalescer->sack_bitmap = 0;
+            due = true;
+        }
+        coalescer->sack_bitmap |= 1ull << (sequence - coalescer->sack_base);
+    }
+    // Duplicates count too: their sender is waiting for an ACK
+    if (coalescer->unacked++ == 0) coalescer->first_unacked_us = now;
+    if (due) return true;
+    
+    if (coalescer->unacked >= coalescer->max_messages ||
+        now - coalescer->first_unacked_us >= coalescer->max_delay_us) {
+        coalescer_emit(coalescer, ack);
+        return true;
+    }
+    return false;
+}
+
+bool handshake_coalescer_poll(handshake_ack_coalescer_t* coalescer, bool force, feedback_message_t* ack) {
+    if (!coalescer || !ack || coalescer->unacked == 0) return false;
+    
+    uint64_t now = umsbb_clock_coarse_ns() / 1000;
+    if (!force && now - coalescer->first_unacked_us < coalescer->max_delay_us) return false;
+    coalescer_emit(coalescer, ack);
+    return true;
+}
+
 bool handshake_can_send_more(handshake_manager_t* manager, uint32_t producer_id) {
     if (!manager) return false;
     
@@ -308,24 +568,20 @@ void handshake_get_metrics(handshake_manager_t* manager, struct handshake_metric
     
     memset(metrics, 0, sizeof(struct handshake_metrics));
     
-    // Calculate rates (simplified)
-    static uint64_t last_messages = 0;
-    static uint64_t last_acks = 0;
-    static uint64_t last_timestamp = 0;
-    
-    uint64_t current_time = get_timestamp_us();
-    uint64_t time_diff = current_time - last_timestamp;
+    // Rates since the previous metrics call
+    uint64_t current_time = umsbb_clock_us();
+    uint64_t time_diff = current_time - manager->metrics_timestamp_us;
     
     if (time_diff > 0) {
-        uint64_t message_diff = manager->total_messages - last_messages;
-        uint64_t ack_diff = manager->successful_acks - last_acks;
+        uint64_t message_diff = manager->total_messages - manager->metrics_messages;
+        uint64_t ack_diff = manager->successful_acks - manager->metrics_acks;
         
         metrics->messages_per_second = (message_diff * 1000000) / time_diff;
         metrics->acks_per_second = (ack_diff * 1000000) / time_diff;
         
-        last_messages = manager->total_messages;
-        last_acks = manager->successful_acks;
-        last_timestamp = current_time;
+        manager->metrics_messages = manager->total_messages;
+        manager->metrics_acks = manager->successful_acks;
+        manager->metrics_timestamp_us = current_time;
     }
     
     // Calculate delivery success rate
@@ -334,8 +590,9 @@ void handshake_get_metrics(handshake_manager_t* manager, struct handshake_metric
             ((double)manager->successful_acks / manager->total_messages) * 100.0;
     }
     
-    metrics->avg_ack_latency_us = manager->avg_ack_latency_us;
-    metrics->p99_ack_latency_us = manager->avg_ack_latency_us * 1.5; // Simplified P99
+    latency_histogram_summary(manager->ack_latency, &metrics->ack_latency);
+    metrics->avg_ack_latency_us = metrics->ack_latency.meanNs / 1000.0;
+    metrics->p99_ack_latency_us = (double)metrics->ack_latency.p99Ns / 1000.0;
     metrics->pending_messages = atomic_load(&manager->pending_count);
     
     // Calculate retry rate
@@ -344,4 +601,28 @@ void handshake_get_metrics(handshake_manager_t* manager, struct handshake_metric
     }
     
     metrics->total_timeouts = manager->timeouts;
-}
\ No newline at end of file
+}
+
+bool handshake_register_metrics(handshake_manager_t* manager, MetricsRegistry* registry, const char* labels) {
+    if (!manager || !registry) return false;
+    bool ok = true;
+    ok &= metrics_registry_add(registry, manager, METRIC_COUNTER, "umsbb_handshake_messages_total",
+                               "Reliable messages sent", labels, METRIC_U64, &manager->total_messages);
+    ok &= metrics_registry_add(registry, manager, METRIC_COUNTER, "umsbb_handshake_acks_total",
+                               "Reliable messages acknowledged", labels, METRIC_U64, &manager->successful_acks);
+    ok &= metrics_registry_add(registry, manager, METRIC_COUNTER, "umsbb_handshake_failed_deliveries_total",
+                               "Reliable messages given up on", labels, METRIC_U64, &manager->failed_deliveries);
+    ok &= metrics_registry_add(registry, manager, METRIC_COUNTER, "umsbb_handshake_timeouts_total",
+                               "ACK timeouts", labels, METRIC_U64, &manager->timeouts);
+    ok &= metrics_registry_add(registry, manager, METRIC_COUNTER, "umsbb_handshake_retries_total",
+                               "Retries after a NACK or timeout", labels, METRIC_U64, &manager->retries);
+    ok &= metrics_registry_add(registry, manager, METRIC_COUNTER, "umsbb_handshake_resends_total",
+                               "Payloads resent", labels, METRIC_U64, &manager->resends);
+    ok &= metrics_registry_add(registry, manager, METRIC_GAUGE, "umsbb_handshake_pending",
+                               "Messages awaiting an ACK", labels, METRIC_U32, &manager->pending_count);
+    if (manager->ack_latency) {
+        ok &= metrics_registry_add_histogram(registry, manager, "umsbb_handshake_ack_latency_seconds",
+                                             "Send (or last retry) to ACK latency", labels, manager->ack_latency);
+    }
+    return ok;
+}
@@ -1,28 +1,206 @@
 #include "feedback_stream.h"
+#include "umsbb_clock.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-void feedback_push(FeedbackStream* stream, FeedbackEntry entry) {
-    if (stream->count < 128) {
-        stream->entries[stream->count++] = entry;
+#if defined(_WIN32)
+#  include <windows.h>
+#  define feedback_yield() SwitchToThread()
+#else
+#  include <sched.h>
+#  define feedback_yield() sched_yield()
+#endif
+
+#define FEEDBACK_RING_MASK (FEEDBACK_RING_CAPACITY - 1)
+
+uint64_t feedback_now(void) {
+    return umsbb_clock_coarse_ns();
+}
+
+bool feedback_init_sparse(FeedbackStream* stream, size_t maxLanes) {
+    stream->lanes = NULL;
+    stream->laneCount = 0;
+    stream->sampleEvery = FEEDBACK_DEFAULT_SAMPLE_EVERY;
+    if (maxLanes == 0) return true;
+
+    stream->lanes = calloc(maxLanes, sizeof(FeedbackRing*));
+    if (!stream->lanes) return false;
+    stream->laneCount = maxLanes;
+    return true;
+}
+
+bool feedback_enable_lane(FeedbackStream* stream, size_t lane) {
+    if (lane >= stream->laneCount) return false;
+    if (stream->lanes[lane]) return true;
+
+    FeedbackRing* ring = calloc(1, sizeof(FeedbackRing));
+    if (!ring) return false;
+    // Zeroed stamps and head are an empty ring; publish it fully formed
+    atomic_fence_release();
+    stream->lanes[lane] = ring;
+    return true;
+}
+
+bool feedback_init(FeedbackStream* stream, size_t laneCount) {
+    if (!feedback_init_sparse(stream, laneCount)) return false;
+    for (size_t lane = 0; lane < laneCount; ++lane) {
+        if (!feedback_enable_lane(stream, lane)) {
+            feedback_destroy(stream);
+            return false;
+        }
+    }
+    return true;
+}
+
+void feedback_destroy(FeedbackStream* stream) {
+    for (size_t lane = 0; lane < stream->laneCount; ++lane) {
+        free(stream->lanes[lane]);
     }
+    free(stream->lanes);
+    stream->lanes = NULL;
+    stream->laneCount = 0;
+}
+
+void feedback_set_sampling(FeedbackStream* stream, uint32_t sampleEvery) {
+    stream->sampleEvery = sampleEvery;
+}
+
+static inline bool feedback_is_routine(FeedbackType type) {
+    return type == FEEDBACK_OK || type == FEEDBACK_GPU_EXECUTED ||
+           type == FEEDBACK_CPU_EXECUTED || type == FEEDBACK_IDLE;
 }
 
-void feedback_render(const FeedbackStream* stream) {
-    for (size_t i = 0; i < stream->count; ++i) {
-    const FeedbackEntry* e = &stream->entries[i];
-        const char* typeStr =
-            (e->type == FEEDBACK_OK) ? "OK" :
-            (e->type == FEEDBACK_CORRUPTED) ? "CORRUPTED" :
-            (e->type == FEEDBACK_GPU_EXECUTED) ? "GPU" :
-            (e->type == FEEDBACK_CPU_EXECUTED) ? "CPU" :
-            (e->type == FEEDBACK_THROTTLED) ? "THROTTLED" :
-            (e->type == FEEDBACK_SKIPPED) ? "SKIPPED" :
-            (e->type == FEEDBACK_IDLE) ? "IDLE" : "UNKNOWN";
+bool feedback_should_record(FeedbackStream* stream, size_t lane, FeedbackType type, uint32_t sequence) {
+    if (lane >= stream->laneCount || !stream->lanes[lane]) return false;
+    if (!feedback_is_routine(type)) return true;
 
-    printf("Capsule %u [%s]: %s @ %llu\n", e->sequence, typeStr, e->note, (unsigned long long)e->timestamp);
+    uint32_t every = stream->sampleEvery;
+    if (every == 0) return false;
+
+    if (type == FEEDBACK_IDLE) {
+        // One IDLE per idle period: only when traffic happened since the last one
+        FeedbackRing* ring = stream->lanes[lane];
+        size_t marker = (size_t)sequence + 1;
+        if (atomic_load_size_relaxed(&ring->idleSequence) == marker) return false;
+        atomic_store_size_release(&ring->idleSequence, marker);
+        return true;
+    }
+    return sequence % every == 0;
+}
+
+void feedback_push(FeedbackStream* stream, size_t lane, FeedbackEntry entry) {
+    if (lane >= stream->laneCount || !stream->lanes[lane]) return;
+    FeedbackRing* ring = stream->lanes[lane];
+
+    entry.timestamp = feedback_now();
+    size_t words[FEEDBACK_ENTRY_WORDS] = { 0 };
+    memcpy(words, &entry, sizeof(entry));
+
+    size_t pos = atomic_fetch_add_size(&ring->head, 1);
+    FeedbackSlot* slot = &ring->slots[pos & FEEDBACK_RING_MASK];
+
+    // Per-slot seqlock. The writer a lap behind may not have finished (or
+    // started) yet; wait for its stamp rather than writing under it
+    size_t previous = pos >= FEEDBACK_RING_CAPACITY ? 2 * (pos - FEEDBACK_RING_CAPACITY) + 2 : 0;
+    size_t expected = previous;
+    while (!atomic_cas_size(&slot->stamp, &expected, 2 * pos + 1)) {
+        // Past our turn, or the ring was cleared under us: the entry is gone
+        if (expected > previous || atomic_load_size_relaxed(&ring->head) <= pos) return;
+        expected = previous;
+        feedback_yield();
+    }
+    atomic_fence_release();
+    for (size_t i = 0; i < FEEDBACK_ENTRY_WORDS; ++i) {
+        atomic_store_size_relaxed(&slot->words[i], words[i]);
+    }
+    atomic_store_size_release(&slot->stamp, 2 * pos + 2);
+}
+
+void feedback_cursor_init(FeedbackStream* stream, size_t lane, FeedbackCursor* cursor) {
+    cursor->position = 0;
+    cursor->dropped = 0;
+    if (lane >= stream->laneCount || !stream->lanes[lane]) return;
+
+    size_t head = atomic_load_size_acquire(&stream->lanes[lane]->head);
+    cursor->position = head > FEEDBACK_RING_CAPACITY ? head - FEEDBACK_RING_CAPACITY : 0;
+}
+
+size_t feedback_read(FeedbackStream* stream, size_t lane, FeedbackCursor* cursor,
+                     FeedbackEntry* out, size_t max) {
+    if (lane >= stream->laneCount || !stream->lanes[lane] || !out) return 0;
+    FeedbackRing* ring = stream->lanes[lane];
+
+    size_t count = 0;
+    while (count < max) {
+        size_t head = atomic_load_size_acquire(&ring->head);
+        if (cursor->position >= head) break;
+
+        // Lapped by writers: skip what has been overwritten
+        if (head - cursor->position > FEEDBACK_RING_CAPACITY) {
+            size_t oldest = head - FEEDBACK_RING_CAPACITY;
+            cursor->dropped += oldest - cursor->position;
+            cursor->position = oldest;
+        }
+
+        FeedbackSlot* slot = &ring->slots[cursor->position & FEEDBACK_RING_MASK];
+        size_t expected = 2 * cursor->position + 2;
+        size_t before = atomic_load_size_acquire(&slot->stamp);
+        if (before < expected) break; // Reserved but not yet written
+
+        size_t words[FEEDBACK_ENTRY_WORDS];
+        for (size_t i = 0; i < FEEDBACK_ENTRY_WORDS; ++i) {
+            words[i] = atomic_load_size_relaxed(&slot->words[i]);
+        }
+        atomic_fence_acquire();
+        if (before != expected || atomic_load_size_relaxed(&slot->stamp) != expected) {
+            // Overwritten while we looked; the lap check above resyncs
+            cursor->dropped++;
+            cursor->position++;
+            continue;
+        }
+
+        memcpy(&out[count++], words, sizeof(FeedbackEntry));
+        cursor->position++;
+    }
+    return count;
+}
+
+static const char* feedback_type_name(FeedbackType type) {
+    return (type == FEEDBACK_OK) ? "OK" :
+           (type == FEEDBACK_CORRUPTED) ? "CORRUPTED" :
+           (type == FEEDBACK_GPU_EXECUTED) ? "GPU" :
+           (type == FEEDBACK_CPU_EXECUTED) ? "CPU" :
+           (type == FEEDBACK_THROTTLED) ? "THROTTLED" :
+           (type == FEEDBACK_SKIPPED) ? "SKIPPED" :
+           (type == FEEDBACK_IDLE) ? "IDLE" : "UNKNOWN";
+}
+
+void feedback_render(FeedbackStream* stream) {
+    FeedbackEntry entries[32];
+    for (size_t lane = 0; lane < stream->laneCount; ++lane) {
+        if (!stream->lanes[lane]) continue;
+        FeedbackCursor cursor;
+        feedback_cursor_init(stream, lane, &cursor);
+        size_t n;
+        while ((n = feedback_read(stream, lane, &cursor, entries, 32)) > 0) {
+            for (size_t i = 0; i < n; ++i) {
+                const FeedbackEntry* e = &entries[i];
+                printf("Lane %zu capsule %u [%s]: %s @ %llu\n", lane, e->sequence,
+                       feedback_type_name(e->type), e->note, (unsigned long long)e->timestamp);
+            }
+        }
     }
 }
 
 void feedback_clear(FeedbackStream* stream) {
-    stream->count = 0;
-}
\ No newline at end of file
+    for (size_t lane = 0; lane < stream->laneCount; ++lane) {
+        FeedbackRing* ring = stream->lanes[lane];
+        if (!ring) continue;
+        atomic_store_size(&ring->head, 0);
+        atomic_store_size(&ring->idleSequence, 0);
+        for (size_t i = 0; i < FEEDBACK_RING_CAPACITY; ++i) {
+            atomic_store_size(&ring->slots[i].stamp, 0);
+        }
+    }
+}
@@ -4,13 +4,56 @@
 void flow_control_init(FlowControl* ctrl, size_t threshold) {
     if (!ctrl) return;
     ctrl->threshold = threshold;
+    ctrl->ratio = 0.0;
+    ctrl->lowRatio = FLOW_CONTROL_LOW_RATIO;
+    ctrl->batchRatio = FLOW_CONTROL_BATCH_RATIO;
+}
+
+void flow_control_init_ratio(FlowControl* ctrl, double ratio) {
+    if (!ctrl) return;
+    ctrl->threshold = 0;
+    ctrl->ratio = ratio;
+    ctrl->lowRatio = FLOW_CONTROL_LOW_RATIO;
+    ctrl->batchRatio = FLOW_CONTROL_BATCH_RATIO;
+}
+
+void flow_control_set_hysteresis(FlowControl* ctrl, double lowRatio, double batchRatio) {
+    if (!ctrl) return;
+    ctrl->lowRatio = lowRatio < 0.0 ? 0.0 : (lowRatio > 1.0 ? 1.0 : lowRatio);
+    ctrl->batchRatio = batchRatio < 0.0 ? 0.0 : batchRatio;
+}
+
+void flow_control_marks(const FlowControl* ctrl, size_t capacity, size_t* high, size_t* low, size_t* batch) {
+    size_t h = capacity;
+    double lowRatio = FLOW_CONTROL_LOW_RATIO, batchRatio = FLOW_CONTROL_BATCH_RATIO;
+    if (ctrl) {
+        h = ctrl->ratio > 0.0 ? (size_t)((double)capacity * ctrl->ratio) : ctrl->threshold;
+        lowRatio = ctrl->lowRatio;
+        batchRatio = ctrl->batchRatio;
+    }
+    size_t b = (size_t)((double)h * batchRatio);
+    if (high) *high = h;
+    if (low) *low = (size_t)((double)h * lowRatio);
+    if (batch) *batch = b ? b : 1;
 }
 
 bool flow_should_throttle(BiBuffer* buf, FlowControl* ctrl) {
     if (!buf || !ctrl) return false;
+    size_t threshold = ctrl->threshold;
+    if (ctrl->ratio > 0.0) threshold = (size_t)((double)bi_buffer_capacity(buf) * ctrl->ratio);
     /* Use atomic read of the write index to estimate size. */
     size_t write = atomic_load_size(&buf->writeIndex);
-    size_t read = atomic_load_size(&buf->readIndex);
+    size_t read;
+    if (buf->mode == BI_BUFFER_MODE_SPSC) {
+        /* Called from the producer: the cached read index over-estimates
+         * usage, so only touch the consumer's cache line when it matters. */
+        read = buf->cachedReadIndex;
+        if (write - read > threshold) {
+            read = buf->cachedReadIndex = atomic_load_size_acquire(&buf->readIndex);
+        }
+    } else {
+        read = atomic_load_size(&buf->readIndex);
+    }
     size_t used = (write >= read) ? (write - read) : 0;
-    return used > ctrl->threshold;
+    return used > threshold;
 }
\ No newline at end of file
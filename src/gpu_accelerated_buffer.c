@@ -10,6 +10,7 @@
 #else
 #include <unistd.h>
 #include <pthread.h>
+#include <errno.h>
 #include <sys/time.h>
 #endif
 
@@ -245,6 +246,10 @@ int gpu_prepare_batch(gpu_accelerated_buffer_t* buffer, const void* data, size_t
     batch->timestamp = gpu_get_timestamp_ns();
     
     // Allocate auxiliary arrays
+    batch->tags = NULL;
+    batch->policies = NULL;
+    batch->checksums = NULL;
+    batch->status = NULL;
     batch->offsets = (uint64_t*)malloc(batch->count * sizeof(uint64_t));
     batch->lengths = (uint32_t*)malloc(batch->count * sizeof(uint32_t));
     batch->lane_ids = (uint32_t*)malloc(batch->count * sizeof(uint32_t));
@@ -276,6 +281,16 @@ int gpu_prepare_batch(gpu_accelerated_buffer_t* buffer, const void* data, size_t
 int gpu_execute_parallel_processing(gpu_accelerated_buffer_t* buffer, gpu_batch_t* batch) {
     if (!buffer || !batch) return -1;
     
+    // Staged: the messages are copied into stages and counted as they retire
+    if (buffer->pipeline) {
+        for (uint32_t i = 0; i < batch->count; i++) {
+            if (gpu_pipeline_submit(buffer, batch->data + batch->offsets[i], batch->lengths[i], batch->lane_ids[i]) != 0) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+    
     switch (buffer->gpu_type) {
 #ifdef ENABLE_CUDA
         case GPU_PROCESSING_CUDA:
@@ -325,12 +340,33 @@ int gpu_execute_parallel_processing(gpu_accelerated_buffer_t* buffer, gpu_batch_
     return 0;
 }
 
+// Copy into the host ring buffer at head, wrapping around its end
+static void gpu_ring_write(gpu_accelerated_buffer_t* buffer, const void* data, size_t size) {
+    uint64_t current_head = buffer->head;
+    uint64_t new_head = (current_head + size) & buffer->mask;
+    
+    if (current_head + size <= buffer->capacity) {
+        memcpy(buffer->host_buffer + current_head, data, size);
+    } else {
+        // Handle wrap-around
+        size_t first_part = buffer->capacity - current_head;
+        memcpy(buffer->host_buffer + current_head, data, first_part);
+        memcpy(buffer->host_buffer, (const uint8_t*)data + first_part, size - first_part);
+    }
+    
+    buffer->head = new_head;
+}
+
 // High-level write operation with GPU acceleration
 int gpu_buffer_write_accelerated(gpu_accelerated_buffer_t* buffer, const void* data, size_t size, uint32_t lane_id) {
     if (!buffer || !data || size == 0 || !buffer->processing_active) {
         return -1;
     }
     
+    if (buffer->pipeline) {
+        return gpu_pipeline_submit(buffer, data, size, lane_id);
+    }
+    
     // For large writes, use batch processing
     if (size >= 4096 && buffer->gpu_type != GPU_PROCESSING_DISABLED) {
         gpu_batch_t batch;
@@ -350,25 +386,648 @@ int gpu_buffer_write_accelerated(gpu_accelerated_buffer_t* buffer, const void* d
     }
     
     // Fallback to direct memory copy
-    uint64_t current_head = buffer->head;
-    uint64_t new_head = (current_head + size) & buffer->mask;
+    gpu_ring_write(buffer, data, size);
+    gpu_atomic_add_uint64(&buffer->total_messages, 1);
+    gpu_atomic_add_uint64(&buffer->total_bytes, size);
     
-    if (current_head + size <= buffer->capacity) {
-        memcpy(buffer->host_buffer + current_head, data, size);
+    return 0;
+}
+
+// Processing kernel: pick a lane for every message submitted without one
+static void gpu_classify_batch(gpu_batch_t* batch) {
+    for (uint32_t i = 0; i < batch->count; i++) {
+        if (batch->lane_ids[i] == GPU_PIPELINE_AUTO_LANE) {
+            batch->lane_ids[i] = gpu_hash_lane_selection(batch->data + batch->offsets[i], batch->lengths[i]);
+        }
+    }
+}
+
+void gpu_pipeline_default_config(gpu_pipeline_config_t* config) {
+    if (!config) return;
+    memset(config, 0, sizeof(*config));
+    config->num_streams = 4;
+    config->staging_bytes = GPU_PIPELINE_STAGING_BYTES;
+    config->flush_timeout_us = GPU_PIPELINE_FLUSH_TIMEOUT_US;
+}
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+
+struct pipeline_stream;
+
+typedef struct {
+    gpu_memory_block_t* staging;        // Pinned; batch.data is its host side
+    gpu_batch_t batch;
+    uint64_t first_ns;                  // When the first message was appended
+    bool on_host;                       // Device submission failed; already processed
+    struct pipeline_stream* stream;
+#ifdef ENABLE_CUDA
+    cudaEvent_t event;                  // Recorded after the kernel
+#endif
+} pipeline_stage_t;
+
+// Stages are filled, submitted and retired in turn: the fill stage is
+// stages[submitted % GPU_PIPELINE_DEPTH] while submitted - retired is below
+// the depth, and every stage from retired to submitted is in flight.
+typedef struct pipeline_stream {
+    struct gpu_pipeline* pipeline;
+    uint32_t index;
+    pthread_mutex_t fill_lock;          // Appending to the fill stage; submitted
+    pthread_mutex_t queue_lock;         // submitted, executed, stopping
+    pthread_cond_t wake;                // Worker: a stage was submitted, or stop
+    pthread_cond_t done;                // Waiters: the worker finished a stage
+    pthread_t worker;
+    bool has_worker;
+    bool stopping;
+    uint64_t submitted;
+    uint64_t executed;                  // By the worker (host streams)
+    uint64_t retired;                   // Under the completion lock, read by producers
+    pipeline_stage_t stages[GPU_PIPELINE_DEPTH];
+} pipeline_stream_t;
+
+struct gpu_pipeline {
+    gpu_accelerated_buffer_t* buffer;
+    pipeline_stream_t* streams;
+    uint32_t num_streams;
+    uint32_t max_messages;              // Per stage
+    size_t staging_bytes;
+    uint64_t flush_timeout_ns;
+    batch_kernel_chain_t chain;
+    gpu_transform_fn transform;
+    void* transform_context;
+    gpu_result_fn on_result;
+    gpu_reject_fn on_reject;
+    gpu_completion_fn on_complete;
+    void* context;
+    bool device;                        // Stages run on CUDA streams
+    pthread_mutex_t complete_lock;      // One retirement at a time
+    volatile uint32_t cursor;           // Stream producers try first
+    volatile uint64_t next_batch;
+    volatile uint32_t in_flight;
+    volatile uint32_t max_in_flight;
+    volatile uint64_t batches_submitted;
+    volatile uint64_t batches_completed;
+    volatile uint64_t messages_completed;
+    volatile uint64_t bytes_completed;
+    volatile uint64_t producer_stalls;
+    volatile uint64_t timeout_flushes;
+    volatile uint64_t messages_corrupt;
+    volatile uint64_t messages_filtered;
+};
+
+// Per-message stages of the kernel: verify, kernel chain, transform
+static void pipeline_process(const struct gpu_pipeline* pipeline, gpu_batch_t* batch) {
+    batch_kernels_process(&pipeline->chain, batch->data, batch->offsets, batch->lengths, batch->lane_ids,
+                          batch->policies, batch->checksums, batch->status, batch->count);
+    if (!pipeline->transform) return;
+    for (uint32_t i = 0; i < batch->count; i++) {
+        if (batch->status[i] != BATCH_RECORD_OK) continue;
+        pipeline->transform(pipeline->transform_context, batch->data + batch->offsets[i], batch->lengths[i],
+                            batch->lane_ids[i]);
+    }
+}
+
+// The processing kernel as run on the host
+static void pipeline_kernel(const struct gpu_pipeline* pipeline, gpu_batch_t* batch) {
+    gpu_classify_batch(batch);
+    pipeline_process(pipeline, batch);
+}
+
+#ifdef ENABLE_CUDA
+static void CUDART_CB pipeline_host_process(void* stage) {
+    pipeline_stage_t* staged = (pipeline_stage_t*)stage;
+    pipeline_process(staged->stream->pipeline, &staged->batch);
+}
+#endif
+
+static uint32_t pipeline_retire(struct gpu_pipeline* pipeline, pipeline_stream_t* stream);
+static uint32_t pipeline_tick(struct gpu_pipeline* pipeline, pipeline_stream_t* stream, uint64_t now);
+
+// A host stream: run each submitted stage in order. With a flush timeout
+// it also retires its finished batches whenever it runs out of work, and
+// flushes a stale fill stage each timeout it spends idle.
+static void* pipeline_worker(void* arg) {
+    pipeline_stream_t* stream = (pipeline_stream_t*)arg;
+    struct gpu_pipeline* pipeline = stream->pipeline;
+    pthread_mutex_lock(&stream->queue_lock);
+    for (;;) {
+        while (stream->executed == stream->submitted && !stream->stopping) {
+            if (pipeline->flush_timeout_ns == 0) {
+                pthread_cond_wait(&stream->wake, &stream->queue_lock);
+                continue;
+            }
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            uint64_t nsec = (uint64_t)deadline.tv_nsec + pipeline->flush_timeout_ns;
+            deadline.tv_sec += (time_t)(nsec / 1000000000ull);
+            deadline.tv_nsec = (long)(nsec % 1000000000ull);
+            if (pthread_cond_timedwait(&stream->wake, &stream->queue_lock, &deadline) == ETIMEDOUT) {
+                pthread_mutex_unlock(&stream->queue_lock);
+                pipeline_tick(pipeline, stream, gpu_get_timestamp_ns());
+                pthread_mutex_lock(&stream->queue_lock);
+            }
+        }
+        if (stream->executed == stream->submitted) break;
+        
+        pipeline_stage_t* stage = &stream->stages[stream->executed % GPU_PIPELINE_DEPTH];
+        pthread_mutex_unlock(&stream->queue_lock);
+        if (!stage->on_host) {
+            pipeline_kernel(pipeline, &stage->batch);
+        }
+        pthread_mutex_lock(&stream->queue_lock);
+        stream->executed++;
+        pthread_cond_broadcast(&stream->done);
+        
+        if (pipeline->flush_timeout_ns && stream->executed == stream->submitted && !stream->stopping) {
+            pthread_mutex_unlock(&stream->queue_lock);
+            pipeline_retire(pipeline, stream);
+            pthread_mutex_lock(&stream->queue_lock);
+        }
+    }
+    pthread_mutex_unlock(&stream->queue_lock);
+    return NULL;
+}
+
+// Has the event of in-flight stage `seq` fired?
+static bool pipeline_stage_ready(pipeline_stream_t* stream, uint64_t seq) {
+    pthread_mutex_lock(&stream->queue_lock);
+    bool ready = seq < stream->submitted;
+    if (ready && stream->has_worker) {
+        ready = stream->executed > seq;
+    }
+    pthread_mutex_unlock(&stream->queue_lock);
+    
+#ifdef ENABLE_CUDA
+    pipeline_stage_t* stage = &stream->stages[seq % GPU_PIPELINE_DEPTH];
+    if (ready && !stream->has_worker && !stage->on_host) {
+        ready = cudaEventQuery(stage->event) == cudaSuccess;
+    }
+#endif
+    return ready;
+}
+
+static void pipeline_wait_stage(pipeline_stream_t* stream, uint64_t seq) {
+    if (stream->has_worker) {
+        pthread_mutex_lock(&stream->queue_lock);
+        while (stream->executed <= seq) {
+            pthread_cond_wait(&stream->done, &stream->queue_lock);
+        }
+        pthread_mutex_unlock(&stream->queue_lock);
+        return;
+    }
+    
+#ifdef ENABLE_CUDA
+    pipeline_stage_t* stage = &stream->stages[seq % GPU_PIPELINE_DEPTH];
+    if (!stage->on_host) {
+        cudaEventSynchronize(stage->event);
+    }
+#endif
+}
+
+static void pipeline_deliver(struct gpu_pipeline* pipeline, pipeline_stream_t* stream, pipeline_stage_t* stage) {
+    gpu_accelerated_buffer_t* buffer = pipeline->buffer;
+    gpu_batch_t* batch = &stage->batch;
+    
+    uint64_t corrupt = 0, filtered = 0;
+    for (uint32_t i = 0; i < batch->count; i++) {
+        if (batch->status[i] == BATCH_RECORD_OK) continue;
+        if (batch->status[i] == BATCH_RECORD_CORRUPT) {
+            corrupt++;
+        } else {
+            filtered++;
+        }
+        if (pipeline->on_reject) {
+            pipeline->on_reject(pipeline->context, batch->tags[i], batch->lane_ids[i],
+                                (batch_record_status_t)batch->status[i]);
+        }
+    }
+    
+    if (pipeline->on_result) {
+        for (uint32_t i = 0; i < batch->count; i++) {
+            if (batch->status[i] != BATCH_RECORD_OK) continue;
+            pipeline->on_result(pipeline->context, batch->tags[i], batch->data + batch->offsets[i], batch->lengths[i],
+                                batch->lane_ids[i]);
+        }
+    } else if (pipeline->on_complete) {
+        pipeline->on_complete(pipeline->context, batch);
     } else {
-        // Handle wrap-around
-        size_t first_part = buffer->capacity - current_head;
-        memcpy(buffer->host_buffer + current_head, data, first_part);
-        memcpy(buffer->host_buffer, (const uint8_t*)data + first_part, size - first_part);
+        for (uint32_t i = 0; i < batch->count; i++) {
+            if (batch->status[i] != BATCH_RECORD_OK) continue;
+            gpu_ring_write(buffer, batch->data + batch->offsets[i], batch->lengths[i]);
+        }
     }
+    if (corrupt) gpu_atomic_add_uint64(&pipeline->messages_corrupt, corrupt);
+    if (filtered) gpu_atomic_add_uint64(&pipeline->messages_filtered, filtered);
     
-    buffer->head = new_head;
-    gpu_atomic_add_uint64(&buffer->total_messages, 1);
-    gpu_atomic_add_uint64(&buffer->total_bytes, size);
+    gpu_atomic_add_uint64(&buffer->total_messages, batch->count);
+    gpu_atomic_add_uint64(&buffer->total_bytes, batch->total_size);
+    gpu_atomic_add_uint64(&buffer->gpu_operations_count, 1);
+    gpu_atomic_add_uint64(&pipeline->batches_completed, 1);
+    gpu_atomic_add_uint64(&pipeline->messages_completed, batch->count);
+    gpu_atomic_add_uint64(&pipeline->bytes_completed, batch->total_size);
+    __atomic_sub_fetch(&pipeline->in_flight, 1, __ATOMIC_RELAXED);
     
+    // Submission to retirement
+    gpu_stream_t* gpu_stream = &buffer->gpu_streams[stream->index];
+    uint64_t now = gpu_get_timestamp_ns();
+    gpu_stream->messages_processed += batch->count;
+    if (now > batch->timestamp) {
+        gpu_stream->throughput_gbps = (batch->total_size * 8.0) / (double)(now - batch->timestamp);
+    }
+    gpu_stream->last_update_time = now;
+}
+
+// Deliver the stream's finished batches in order and free their stages
+static uint32_t pipeline_retire(struct gpu_pipeline* pipeline, pipeline_stream_t* stream) {
+    uint32_t retired = 0;
+    pthread_mutex_lock(&pipeline->complete_lock);
+    for (;;) {
+        uint64_t seq = stream->retired;
+        if (!pipeline_stage_ready(stream, seq)) break;
+        
+        pipeline_stage_t* stage = &stream->stages[seq % GPU_PIPELINE_DEPTH];
+        pipeline_deliver(pipeline, stream, stage);
+        stage->batch.count = 0;
+        stage->batch.total_size = 0;
+        stage->on_host = false;
+        __atomic_store_n(&stream->retired, seq + 1, __ATOMIC_RELEASE);
+        retired++;
+    }
+    
+    pthread_mutex_lock(&stream->queue_lock);
+    pipeline->buffer->gpu_streams[stream->index].is_active = stream->retired < stream->submitted;
+    pthread_mutex_unlock(&stream->queue_lock);
+    pthread_mutex_unlock(&pipeline->complete_lock);
+    return retired;
+}
+
+// The stage producers may append to, once its previous batch has retired;
+// fill_lock held
+static pipeline_stage_t* pipeline_fill_stage(struct gpu_pipeline* pipeline, pipeline_stream_t* stream) {
+    uint64_t retired = __atomic_load_n(&stream->retired, __ATOMIC_ACQUIRE);
+    if (stream->submitted - retired >= GPU_PIPELINE_DEPTH) {
+        gpu_atomic_add_uint64(&pipeline->producer_stalls, 1);
+        pipeline_wait_stage(stream, retired);
+        pipeline_retire(pipeline, stream);
+    }
+    return &stream->stages[stream->submitted % GPU_PIPELINE_DEPTH];
+}
+
+// Hand the fill stage to its stream: upload, kernel, event; fill_lock held
+static void pipeline_submit_stage(struct gpu_pipeline* pipeline, pipeline_stream_t* stream) {
+    pipeline_stage_t* stage = &stream->stages[stream->submitted % GPU_PIPELINE_DEPTH];
+    stage->batch.batch_id = __atomic_fetch_add(&pipeline->next_batch, 1, __ATOMIC_RELAXED);
+    stage->batch.timestamp = gpu_get_timestamp_ns();
+    
+#ifdef ENABLE_CUDA
+    if (pipeline->device) {
+        gpu_accelerated_buffer_t* buffer = pipeline->buffer;
+        cudaStream_t cuda_stream = buffer->cuda_streams[stream->index];
+        if (cudaMemcpyAsync(stage->staging->device_ptr, stage->staging->host_ptr, stage->batch.total_size,
+                            cudaMemcpyHostToDevice, cuda_stream) != cudaSuccess ||
+            cuda_launch_processing_kernel(buffer, &stage->batch, stream->index) != 0 ||
+            cudaLaunchHostFunc(cuda_stream, pipeline_host_process, stage) != cudaSuccess ||
+            cudaEventRecord(stage->event, cuda_stream) != cudaSuccess) {
+            // Still deliver the batch, processed here
+            cudaStreamSynchronize(cuda_stream);
+            pipeline_kernel(pipeline, &stage->batch);
+            stage->on_host = true;
+        }
+    }
+#endif
+    
+    pthread_mutex_lock(&stream->queue_lock);
+    stream->submitted++;
+    pipeline->buffer->gpu_streams[stream->index].is_active = true;
+    pthread_cond_signal(&stream->wake);
+    pthread_mutex_unlock(&stream->queue_lock);
+    
+    gpu_atomic_add_uint64(&pipeline->batches_submitted, 1);
+    uint32_t in_flight = __atomic_add_fetch(&pipeline->in_flight, 1, __ATOMIC_RELAXED);
+    uint32_t seen = __atomic_load_n(&pipeline->max_in_flight, __ATOMIC_RELAXED);
+    while (in_flight > seen &&
+           !__atomic_compare_exchange_n(&pipeline->max_in_flight, &seen, in_flight, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// Submit the fill stage if it has waited out the flush timeout (unless a
+// producer holds it), then retire what has finished
+static uint32_t pipeline_tick(struct gpu_pipeline* pipeline, pipeline_stream_t* stream, uint64_t now) {
+    if (pipeline->flush_timeout_ns && pthread_mutex_trylock(&stream->fill_lock) == 0) {
+        uint64_t retired = __atomic_load_n(&stream->retired, __ATOMIC_ACQUIRE);
+        pipeline_stage_t* stage = &stream->stages[stream->submitted % GPU_PIPELINE_DEPTH];
+        if (stream->submitted - retired < GPU_PIPELINE_DEPTH && stage->batch.count > 0 &&
+            now - stage->first_ns >= pipeline->flush_timeout_ns) {
+            pipeline_submit_stage(pipeline, stream);
+            gpu_atomic_add_uint64(&pipeline->timeout_flushes, 1);
+        }
+        pthread_mutex_unlock(&stream->fill_lock);
+    }
+    return pipeline_retire(pipeline, stream);
+}
+
+// Lock the first free stream from the cursor, or wait for the cursor's
+static pipeline_stream_t* pipeline_lock_stream(struct gpu_pipeline* pipeline) {
+    uint32_t first = __atomic_load_n(&pipeline->cursor, __ATOMIC_RELAXED);
+    for (uint32_t i = 0; i < pipeline->num_streams; i++) {
+        pipeline_stream_t* stream = &pipeline->streams[(first + i) % pipeline->num_streams];
+        if (pthread_mutex_trylock(&stream->fill_lock) == 0) {
+            return stream;
+        }
+    }
+    pipeline_stream_t* stream = &pipeline->streams[first % pipeline->num_streams];
+    pthread_mutex_lock(&stream->fill_lock);
+    return stream;
+}
+
+static void pipeline_destroy(struct gpu_pipeline* pipeline) {
+    for (uint32_t i = 0; i < pipeline->num_streams; i++) {
+        pipeline_stream_t* stream = &pipeline->streams[i];
+        if (stream->has_worker) {
+            pthread_mutex_lock(&stream->queue_lock);
+            stream->stopping = true;
+            pthread_cond_signal(&stream->wake);
+            pthread_mutex_unlock(&stream->queue_lock);
+            pthread_join(stream->worker, NULL);
+        }
+        
+        for (uint32_t j = 0; j < GPU_PIPELINE_DEPTH; j++) {
+            pipeline_stage_t* stage = &stream->stages[j];
+#ifdef ENABLE_CUDA
+            if (stage->event) cudaEventDestroy(stage->event);
+#endif
+            if (stage->staging) gpu_free_pinned_memory(stage->staging);
+            free(stage->batch.offsets);
+            free(stage->batch.lengths);
+            free(stage->batch.lane_ids);
+            free(stage->batch.tags);
+            free(stage->batch.policies);
+            free(stage->batch.checksums);
+            free(stage->batch.status);
+        }
+        pthread_cond_destroy(&stream->done);
+        pthread_cond_destroy(&stream->wake);
+        pthread_mutex_destroy(&stream->queue_lock);
+        pthread_mutex_destroy(&stream->fill_lock);
+    }
+    pthread_mutex_destroy(&pipeline->complete_lock);
+    free(pipeline->streams);
+    free(pipeline);
+}
+
+int gpu_pipeline_start(gpu_accelerated_buffer_t* buffer, const gpu_pipeline_config_t* config) {
+    gpu_pipeline_config_t defaults;
+    if (!config) {
+        gpu_pipeline_default_config(&defaults);
+        config = &defaults;
+    }
+    if (!buffer || !buffer->gpu_initialized || buffer->pipeline || config->num_streams == 0 ||
+        config->num_streams > MAX_GPU_STREAMS || config->staging_bytes == 0 || config->staging_bytes > UINT32_MAX) {
+        return -1;
+    }
+    batch_kernel_chain_t chain;
+    if (!batch_kernel_resolve(&chain, config->kernels, config->num_kernels)) {
+        return -1;
+    }
+    
+    // Streams made by gpu_buffer_init for a device are reused
+    if (!buffer->gpu_streams && gpu_create_streams(buffer, config->num_streams) != 0) {
+        return -1;
+    }
+    
+    struct gpu_pipeline* pipeline = (struct gpu_pipeline*)calloc(1, sizeof(struct gpu_pipeline));
+    if (!pipeline) return -1;
+    pipeline->num_streams = (config->num_streams < buffer->num_streams) ? config->num_streams : buffer->num_streams;
+    pipeline->streams = (pipeline_stream_t*)calloc(pipeline->num_streams, sizeof(pipeline_stream_t));
+    if (!pipeline->streams) {
+        free(pipeline);
+        return -1;
+    }
+    
+    pipeline->buffer = buffer;
+    pipeline->staging_bytes = config->staging_bytes;
+    pipeline->flush_timeout_ns = (uint64_t)config->flush_timeout_us * 1000;
+    pipeline->chain = chain;
+    pipeline->transform = config->transform;
+    pipeline->transform_context = config->transform_context;
+    pipeline->on_result = config->on_result;
+    pipeline->on_reject = config->on_reject;
+    pipeline->on_complete = config->on_complete;
+    pipeline->context = config->context;
+    size_t max_messages = config->batch_messages ? config->batch_messages : config->staging_bytes / 64;
+    pipeline->max_messages = (uint32_t)((max_messages == 0) ? 1 : (max_messages > GPU_BATCH_SIZE) ? GPU_BATCH_SIZE : max_messages);
+#ifdef ENABLE_CUDA
+    pipeline->device = buffer->cuda_streams != NULL;
+#endif
+    pthread_mutex_init(&pipeline->complete_lock, NULL);
+    for (uint32_t i = 0; i < pipeline->num_streams; i++) {
+        pipeline_stream_t* stream = &pipeline->streams[i];
+        stream->pipeline = pipeline;
+        stream->index = i;
+        pthread_mutex_init(&stream->fill_lock, NULL);
+        pthread_mutex_init(&stream->queue_lock, NULL);
+        pthread_cond_init(&stream->wake, NULL);
+        pthread_cond_init(&stream->done, NULL);
+    }
+    
+    bool ok = true;
+    for (uint32_t i = 0; i < pipeline->num_streams && ok; i++) {
+        pipeline_stream_t* stream = &pipeline->streams[i];
+        for (uint32_t j = 0; j < GPU_PIPELINE_DEPTH && ok; j++) {
+            pipeline_stage_t* stage = &stream->stages[j];
+            stage->staging = gpu_allocate_pinned_memory(config->staging_bytes);
+            stage->batch.offsets = (uint64_t*)malloc(pipeline->max_messages * sizeof(uint64_t));
+            stage->batch.lengths = (uint32_t*)malloc(pipeline->max_messages * sizeof(uint32_t));
+            stage->batch.lane_ids = (uint32_t*)malloc(pipeline->max_messages * sizeof(uint32_t));
+            stage->batch.tags = (uint64_t*)malloc(pipeline->max_messages * sizeof(uint64_t));
+            stage->batch.policies = (uint8_t*)malloc(pipeline->max_messages);
+            stage->batch.checksums = (uint32_t*)malloc(pipeline->max_messages * sizeof(uint32_t));
+            stage->batch.status = (uint8_t*)malloc(pipeline->max_messages);
+            stage->stream = stream;
+            ok = stage->staging && stage->staging->host_ptr && (!pipeline->device || stage->staging->device_ptr) &&
+                 stage->batch.offsets && stage->batch.lengths && stage->batch.lane_ids && stage->batch.tags &&
+                 stage->batch.policies && stage->batch.checksums && stage->batch.status;
+            if (ok) {
+                stage->batch.data = (uint8_t*)stage->staging->host_ptr;
+            }
+#ifdef ENABLE_CUDA
+            if (ok && pipeline->device) {
+                ok = cudaEventCreateWithFlags(&stage->event, cudaEventDisableTiming) == cudaSuccess;
+            }
+#endif
+        }
+        if (ok && !pipeline->device) {
+            ok = pthread_create(&stream->worker, NULL, pipeline_worker, stream) == 0;
+            stream->has_worker = ok;
+        }
+    }
+    if (!ok) {
+        pipeline_destroy(pipeline);
+        return -1;
+    }
+    
+    buffer->pipeline = pipeline;
     return 0;
 }
 
+int gpu_pipeline_submit(gpu_accelerated_buffer_t* buffer, const void* data, size_t size, uint32_t lane_id) {
+    return gpu_pipeline_submit_tagged(buffer, data, size, lane_id, 0);
+}
+
+int gpu_pipeline_submit_tagged(gpu_accelerated_buffer_t* buffer, const void* data, size_t size, uint32_t lane_id,
+                               uint64_t tag) {
+    return gpu_pipeline_submit_checked(buffer, data, size, lane_id, tag, CHECKSUM_POLICY_NONE, 0);
+}
+
+int gpu_pipeline_submit_checked(gpu_accelerated_buffer_t* buffer, const void* data, size_t size, uint32_t lane_id,
+                                uint64_t tag, checksum_policy_t policy, uint32_t checksum) {
+    struct gpu_pipeline* pipeline = buffer ? buffer->pipeline : NULL;
+    if (!pipeline || !data || size == 0 || size > pipeline->staging_bytes ||
+        (!pipeline->on_result && !pipeline->on_complete && size > buffer->capacity)) {
+        return -1;
+    }
+    
+    for (;;) {
+        pipeline_stream_t* stream = pipeline_lock_stream(pipeline);
+        pipeline_stage_t* stage = pipeline_fill_stage(pipeline, stream);
+        gpu_batch_t* batch = &stage->batch;
+        
+        // Full: send it on its way and move producers to the next stream
+        if (batch->count == pipeline->max_messages || batch->total_size + size > pipeline->staging_bytes) {
+            pipeline_submit_stage(pipeline, stream);
+            __atomic_fetch_add(&pipeline->cursor, 1, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&stream->fill_lock);
+            continue;
+        }
+        
+        if (batch->count == 0) {
+            stage->first_ns = gpu_get_timestamp_ns();
+        }
+        memcpy(batch->data + batch->total_size, data, size);
+        batch->offsets[batch->count] = batch->total_size;
+        batch->lengths[batch->count] = (uint32_t)size;
+        batch->lane_ids[batch->count] = lane_id;
+        batch->tags[batch->count] = tag;
+        batch->policies[batch->count] = (uint8_t)policy;
+        batch->checksums[batch->count] = checksum;
+        batch->count++;
+        batch->total_size += size;
+        pthread_mutex_unlock(&stream->fill_lock);
+        return 0;
+    }
+}
+
+int gpu_pipeline_flush(gpu_accelerated_buffer_t* buffer) {
+    struct gpu_pipeline* pipeline = buffer ? buffer->pipeline : NULL;
+    if (!pipeline) return -1;
+    
+    for (uint32_t i = 0; i < pipeline->num_streams; i++) {
+        pipeline_stream_t* stream = &pipeline->streams[i];
+        pthread_mutex_lock(&stream->fill_lock);
+        // With every stage in flight there is nothing being filled
+        uint64_t retired = __atomic_load_n(&stream->retired, __ATOMIC_ACQUIRE);
+        if (stream->submitted - retired < GPU_PIPELINE_DEPTH &&
+            stream->stages[stream->submitted % GPU_PIPELINE_DEPTH].batch.count > 0) {
+            pipeline_submit_stage(pipeline, stream);
+        }
+        pthread_mutex_unlock(&stream->fill_lock);
+    }
+    return 0;
+}
+
+uint32_t gpu_pipeline_poll(gpu_accelerated_buffer_t* buffer) {
+    struct gpu_pipeline* pipeline = buffer ? buffer->pipeline : NULL;
+    if (!pipeline) return 0;
+    
+    uint32_t retired = 0;
+    uint64_t now = gpu_get_timestamp_ns();
+    for (uint32_t i = 0; i < pipeline->num_streams; i++) {
+        retired += pipeline_tick(pipeline, &pipeline->streams[i], now);
+    }
+    return retired;
+}
+
+int gpu_pipeline_drain(gpu_accelerated_buffer_t* buffer) {
+    if (gpu_pipeline_flush(buffer) != 0) return -1;
+    
+    struct gpu_pipeline* pipeline = buffer->pipeline;
+    for (uint32_t i = 0; i < pipeline->num_streams; i++) {
+        pipeline_stream_t* stream = &pipeline->streams[i];
+        for (;;) {
+            pthread_mutex_lock(&stream->queue_lock);
+            uint64_t seq = __atomic_load_n(&stream->retired, __ATOMIC_ACQUIRE);
+            bool pending = seq < stream->submitted;
+            pthread_mutex_unlock(&stream->queue_lock);
+            if (!pending) break;
+            
+            pipeline_wait_stage(stream, seq);
+            pipeline_retire(pipeline, stream);
+        }
+    }
+    return 0;
+}
+
+void gpu_pipeline_stop(gpu_accelerated_buffer_t* buffer) {
+    if (!buffer || !buffer->pipeline) return;
+    
+    gpu_pipeline_drain(buffer);
+    pipeline_destroy(buffer->pipeline);
+    buffer->pipeline = NULL;
+}
+
+void gpu_pipeline_get_stats(gpu_accelerated_buffer_t* buffer, gpu_pipeline_stats_t* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    struct gpu_pipeline* pipeline = buffer ? buffer->pipeline : NULL;
+    if (!pipeline) return;
+    
+    stats->batches_submitted = __atomic_load_n(&pipeline->batches_submitted, __ATOMIC_RELAXED);
+    stats->batches_completed = __atomic_load_n(&pipeline->batches_completed, __ATOMIC_RELAXED);
+    stats->messages_completed = __atomic_load_n(&pipeline->messages_completed, __ATOMIC_RELAXED);
+    stats->bytes_completed = __atomic_load_n(&pipeline->bytes_completed, __ATOMIC_RELAXED);
+    stats->producer_stalls = __atomic_load_n(&pipeline->producer_stalls, __ATOMIC_RELAXED);
+    stats->timeout_flushes = __atomic_load_n(&pipeline->timeout_flushes, __ATOMIC_RELAXED);
+    stats->messages_corrupt = __atomic_load_n(&pipeline->messages_corrupt, __ATOMIC_RELAXED);
+    stats->messages_filtered = __atomic_load_n(&pipeline->messages_filtered, __ATOMIC_RELAXED);
+    stats->max_in_flight = __atomic_load_n(&pipeline->max_in_flight, __ATOMIC_RELAXED);
+}
+
+#else
+
+int gpu_pipeline_start(gpu_accelerated_buffer_t* buffer, const gpu_pipeline_config_t* config) {
+    (void)buffer; (void)config;
+    return -1;
+}
+
+int gpu_pipeline_submit(gpu_accelerated_buffer_t* buffer, const void* data, size_t size, uint32_t lane_id) {
+    (void)buffer; (void)data; (void)size; (void)lane_id;
+    return -1;
+}
+
+int gpu_pipeline_submit_tagged(gpu_accelerated_buffer_t* buffer, const void* data, size_t size, uint32_t lane_id,
+                               uint64_t tag) {
+    (void)buffer; (void)data; (void)size; (void)lane_id; (void)tag;
+    return -1;
+}
+
+int gpu_pipeline_submit_checked(gpu_accelerated_buffer_t* buffer, const void* data, size_t size, uint32_t lane_id,
+                                uint64_t tag, checksum_policy_t policy, uint32_t checksum) {
+    (void)buffer; (void)data; (void)size; (void)lane_id; (void)tag; (void)policy; (void)checksum;
+    return -1;
+}
+
+int gpu_pipeline_flush(gpu_accelerated_buffer_t* buffer) { (void)buffer; return -1; }
+uint32_t gpu_pipeline_poll(gpu_accelerated_buffer_t* buffer) { (void)buffer; return 0; }
+int gpu_pipeline_drain(gpu_accelerated_buffer_t* buffer) { (void)buffer; return -1; }
+void gpu_pipeline_stop(gpu_accelerated_buffer_t* buffer) { (void)buffer; }
+
+void gpu_pipeline_get_stats(gpu_accelerated_buffer_t* buffer, gpu_pipeline_stats_t* stats) {
+    (void)buffer;
+    if (stats) memset(stats, 0, sizeof(*stats));
+}
+
+#endif
+
 // Performance monitoring
 void gpu_update_performance_metrics(gpu_accelerated_buffer_t* buffer, gpu_performance_metrics_t* metrics) {
     if (!buffer || !metrics) return;
@@ -388,8 +1047,10 @@ void gpu_update_performance_metrics(gpu_accelerated_buffer_t* buffer, gpu_perfor
     static uint64_t last_total_messages = 0;
     static uint64_t last_total_bytes = 0;
     
-    uint64_t messages_delta = buffer->total_messages - last_total_messages;
-    uint64_t bytes_delta = buffer->total_bytes - last_total_bytes;
+    uint64_t total_messages = gpu_atomic_load_uint64(&buffer->total_messages);
+    uint64_t total_bytes = gpu_atomic_load_uint64(&buffer->total_bytes);
+    uint64_t messages_delta = total_messages - last_total_messages;
+    uint64_t bytes_delta = total_bytes - last_total_bytes;
     
     metrics->messages_per_second = (uint64_t)(messages_delta / time_delta_seconds);
     metrics->throughput_gbps = (bytes_delta * 8.0) / (time_delta_seconds * 1e9);
@@ -410,8 +1071,8 @@ void gpu_update_performance_metrics(gpu_accelerated_buffer_t* buffer, gpu_perfor
     }
     
     last_update_time = current_time;
-    last_total_messages = buffer->total_messages;
-    last_total_bytes = buffer->total_bytes;
+    last_total_messages = total_messages;
+    last_total_bytes = total_bytes;
 }
 
 double gpu_calculate_throughput(gpu_accelerated_buffer_t* buffer) {
@@ -422,6 +1083,7 @@ double gpu_calculate_throughput(gpu_accelerated_buffer_t* buffer) {
 void gpu_buffer_cleanup(gpu_accelerated_buffer_t* buffer) {
     if (!buffer) return;
     
+    gpu_pipeline_stop(buffer);
     buffer->processing_active = false;
     
     // Free host buffer
@@ -486,21 +1148,56 @@ void gpu_destroy_streams(gpu_accelerated_buffer_t* buffer) {
     buffer->num_streams = 0;
 }
 
-// Stub implementations for CUDA functions (to be compiled with nvcc)
+// CUDA streams and events for the staged pipeline
 #ifdef ENABLE_CUDA
 int cuda_initialize_device(gpu_accelerated_buffer_t* buffer) {
-    // Implementation would go here
-    return 0;
+    if (!buffer) return -1;
+    return (cudaSetDevice(0) == cudaSuccess) ? 0 : -1;
 }
 
 int cuda_create_streams(gpu_accelerated_buffer_t* buffer, uint32_t num_streams) {
-    // Implementation would go here
+    buffer->cuda_streams = (cudaStream_t*)calloc(num_streams, sizeof(cudaStream_t));
+    buffer->events = (cudaEvent_t*)calloc(num_streams, sizeof(cudaEvent_t));
+    if (!buffer->cuda_streams || !buffer->events) {
+        free(buffer->cuda_streams);
+        free(buffer->events);
+        buffer->cuda_streams = NULL;
+        buffer->events = NULL;
+        return -1;
+    }
+    
+    // Non-blocking, so copies and kernels never serialise behind the legacy stream
+    for (uint32_t i = 0; i < num_streams; i++) {
+        if (cudaStreamCreateWithFlags(&buffer->cuda_streams[i], cudaStreamNonBlocking) != cudaSuccess ||
+            cudaEventCreateWithFlags(&buffer->events[i], cudaEventDisableTiming) != cudaSuccess) {
+            return -1;
+        }
+    }
     return 0;
 }
 
+static void CUDART_CB cuda_host_classify(void* batch) {
+    gpu_classify_batch((gpu_batch_t*)batch);
+}
+
 int cuda_launch_processing_kernel(gpu_accelerated_buffer_t* buffer, gpu_batch_t* batch, uint32_t stream_id) {
-    // Implementation would go here
-    return 0;
+    if (!buffer || !batch || !buffer->cuda_streams || stream_id >= buffer->num_streams) return -1;
+    
+    // Lane selection runs in stream order on the pinned host copy of the
+    // batch, after its upload; a device kernel needs an nvcc-built unit
+    return (cudaLaunchHostFunc(buffer->cuda_streams[stream_id], cuda_host_classify, batch) == cudaSuccess) ? 0 : -1;
+}
+
+int cuda_synchronize_streams(gpu_accelerated_buffer_t* buffer) {
+    if (!buffer || !buffer->cuda_streams) return -1;
+    
+    int result = 0;
+    for (uint32_t i = 0; i < buffer->num_streams; i++) {
+        if (cudaStreamSynchronize(buffer->cuda_streams[i]) != cudaSuccess) {
+            result = -1;
+        }
+    }
+    return result;
 }
 #endif
 
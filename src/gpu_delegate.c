@@ -123,10 +123,8 @@ bool gpu_parallel_copy(void* dst, const void* src, size_t size, size_t num_threa
         
         cudaMemcpy(gpu_src, src, size, cudaMemcpyHostToDevice);
         
-        // Launch parallel copy kernel
-        dim3 block(256);
-        dim3 grid((size + block.x - 1) / block.x);
-        // gpu_memcpy_kernel<<<grid, block>>>(gpu_dst, gpu_src, size);
+        // Device-side copy; the kernel launch needs an nvcc-built unit
+        cudaMemcpy(gpu_dst, gpu_src, size, cudaMemcpyDeviceToDevice);
         
         cudaMemcpy(dst, gpu_dst, size, cudaMemcpyDeviceToHost);
         
@@ -1,10 +1,188 @@
 /* high_water_mark.c */
 #include "../include/high_water_mark.h"
+#include "../include/event_scheduler.h"
+#include "../include/umsbb_clock.h"
+#include "../include/portable_atomic.h"
+#include "../include/bi_buffer.h"
 #include <stdlib.h>
 
-struct HighWaterMark { size_t capacity; size_t current; };
-HighWaterMark* hwm_create(size_t capacity){ HighWaterMark* h = (HighWaterMark*)malloc(sizeof(HighWaterMark)); if(!h) return NULL; h->capacity = capacity; h->current = 0; return h; }
-void hwm_destroy(HighWaterMark* h){ free(h); }
-int hwm_push(HighWaterMark* h, size_t n){ if(!h) return 0; h->current += n; return h->current <= h->capacity; }
-void hwm_pop(HighWaterMark* h, size_t n){ if(!h) return; if(h->current > n) h->current -= n; else h->current = 0; }
-int hwm_is_overflow(const HighWaterMark* h){ return h? (h->current > h->capacity) : 0; }
+/* Producers hammer the credit word; the consumer's running tally lives on its
+ * own line and only meets them when a grant is due. */
+struct HighWaterMark {
+    atomic_size_t credits;          // Signed: may be overdrawn by one message
+    atomic_u32 grantEpoch;          // Futex word, bumped by grants that find waiters
+    atomic_u32 waiters;
+    atomic_u32 throttled;
+    atomic_size_t rejected;
+    atomic_size_t throttleEvents;
+    atomic_size_t waits;
+    uint8_t pad0[SOMA_ALIGNMENT];
+
+    atomic_size_t pending;          // Released but not yet granted
+    atomic_size_t grants;
+    atomic_size_t high;
+    atomic_size_t low;
+    atomic_size_t batch;
+    uint8_t pad1[SOMA_ALIGNMENT];
+};
+
+static inline ptrdiff_t hwm_signed(size_t v) { return (ptrdiff_t)v; }
+
+static ptrdiff_t hwm_outstanding(HighWaterMark* h) {
+    return hwm_signed(atomic_load_size(&h->high) - atomic_load_size(&h->credits)
+                      - atomic_load_size_relaxed(&h->pending));
+}
+
+static void hwm_wake(HighWaterMark* h) {
+    // The credit update was a full RMW; a producer that announced itself
+    // before it re-checked the credit either saw it or is seen here
+    if (atomic_load_u32(&h->waiters)) {
+        atomic_fetch_add_u32(&h->grantEpoch, 1);
+        event_wake_address(&h->grantEpoch);
+    }
+}
+
+static bool hwm_take(HighWaterMark* h, size_t n) {
+    size_t c = atomic_load_size(&h->credits);
+    for (;;) {
+        if (hwm_signed(c) <= 0) return false;
+        if (atomic_cas_size(&h->credits, &c, c - n)) return true;
+    }
+}
+
+static void hwm_close(HighWaterMark* h) {
+    atomic_fetch_add_size(&h->rejected, 1);
+    if (atomic_load_u32(&h->throttled)) return;
+    uint32_t expected = 0;
+    if (atomic_cas_u32(&h->throttled, &expected, 1)) atomic_fetch_add_size(&h->throttleEvents, 1);
+}
+
+static void hwm_grant(HighWaterMark* h) {
+    size_t amount = atomic_load_size(&h->pending);
+    while (amount && !atomic_cas_size(&h->pending, &amount, 0)) {}
+    if (!amount) return;
+
+    atomic_fetch_add_size(&h->credits, amount);
+    if (atomic_load_u32(&h->throttled)) atomic_store_u32(&h->throttled, 0);
+    atomic_fetch_add_size(&h->grants, 1);
+    hwm_wake(h);
+}
+
+HighWaterMark* hwm_create(size_t capacity) {
+    return hwm_create_marks(capacity, capacity / 2, capacity / 16);
+}
+
+HighWaterMark* hwm_create_marks(size_t high, size_t low, size_t batch) {
+    HighWaterMark* h = (HighWaterMark*)calloc(1, sizeof(HighWaterMark));
+    if (!h) return NULL;
+    atomic_store_size(&h->credits, 0);
+    atomic_store_size(&h->high, 0);
+    hwm_set_marks(h, high, low, batch);
+    return h;
+}
+
+void hwm_destroy(HighWaterMark* h) { free(h); }
+
+bool hwm_try_acquire(HighWaterMark* h, size_t n) {
+    if (!h) return true;
+    if (hwm_take(h, n)) return true;
+    hwm_close(h);
+    return false;
+}
+
+bool hwm_acquire_wait(HighWaterMark* h, size_t n, uint64_t timeoutNs) {
+    if (hwm_try_acquire(h, n)) return true;
+    if (timeoutNs == 0) return false;
+
+    atomic_fetch_add_size(&h->waits, 1);
+    uint64_t start = umsbb_clock_ns();
+    for (;;) {
+        uint64_t remaining = EVENT_WAIT_FOREVER;
+        if (timeoutNs != EVENT_WAIT_FOREVER) {
+            uint64_t elapsed = umsbb_clock_ns() - start;
+            if (elapsed >= timeoutNs) return hwm_take(h, n);
+            remaining = timeoutNs - elapsed;
+        }
+
+        uint32_t epoch = atomic_load_u32(&h->grantEpoch);
+        atomic_fetch_add_u32(&h->waiters, 1);
+        if (hwm_take(h, n)) {
+            atomic_fetch_add_u32(&h->waiters, (uint32_t)-1);
+            return true;
+        }
+        event_park_address(&h->grantEpoch, epoch, remaining);
+        atomic_fetch_add_u32(&h->waiters, (uint32_t)-1);
+        if (hwm_take(h, n)) return true;
+    }
+}
+
+void hwm_refund(HighWaterMark* h, size_t n) {
+    if (!h || !n) return;
+    atomic_fetch_add_size(&h->credits, n);
+    hwm_wake(h);
+}
+
+void hwm_release(HighWaterMark* h, size_t n) {
+    if (!h || !n) return;
+    size_t pending = atomic_fetch_add_size(&h->pending, n) + n;
+
+    // While producers still hold credit, top them up a batch at a time.
+    // Once the credit is gone (or a producer was refused), hold it back
+    // until the backlog is down to the low mark: every message charged
+    // against the exhausted credit is released through here, so the grant
+    // that reopens the gate cannot be missed.
+    bool closed = atomic_load_u32(&h->throttled) || hwm_signed(atomic_load_size(&h->credits)) <= 0;
+    if (closed) {
+        if (hwm_outstanding(h) <= hwm_signed(atomic_load_size_relaxed(&h->low))) hwm_grant(h);
+    } else if (pending >= atomic_load_size_relaxed(&h->batch)) {
+        hwm_grant(h);
+    }
+}
+
+void hwm_set_marks(HighWaterMark* h, size_t high, size_t low, size_t batch) {
+    if (!h) return;
+    if (low > high) low = high;
+    if (batch == 0) batch = 1;
+    if (batch > high - low && high > low) batch = high - low;
+    atomic_store_size(&h->low, low);
+    atomic_store_size(&h->batch, batch);
+
+    size_t old = atomic_load_size(&h->high);
+    while (!atomic_cas_size(&h->high, &old, high)) {}
+    // A larger window is credit the producers may use right away
+    atomic_fetch_add_size(&h->credits, high - old);
+    if (high > old) hwm_wake(h);
+}
+
+bool hwm_is_throttled(const HighWaterMark* h) {
+    return h && atomic_load_u32(&((HighWaterMark*)h)->throttled) != 0;
+}
+
+void hwm_get_stats(const HighWaterMark* hc, HighWaterMarkStats* out) {
+    if (!out) return;
+    *out = (HighWaterMarkStats){0};
+    if (!hc) return;
+    HighWaterMark* h = (HighWaterMark*)hc;
+    ptrdiff_t outstanding = hwm_outstanding(h);
+    out->high = atomic_load_size(&h->high);
+    out->low = atomic_load_size(&h->low);
+    out->batch = atomic_load_size(&h->batch);
+    out->outstanding = outstanding > 0 ? (size_t)outstanding : 0;
+    out->throttled = atomic_load_u32(&h->throttled) != 0;
+    out->throttleEvents = atomic_load_size(&h->throttleEvents);
+    out->rejected = atomic_load_size(&h->rejected);
+    out->waits = atomic_load_size(&h->waits);
+    out->grants = atomic_load_size(&h->grants);
+}
+
+int hwm_push(HighWaterMark* h, size_t n) {
+    if (!h) return 0;
+    atomic_fetch_add_size(&h->credits, (size_t)0 - n);
+    return !hwm_is_overflow(h);
+}
+
+void hwm_pop(HighWaterMark* h, size_t n) { hwm_release(h, n); }
+
+int hwm_is_overflow(const HighWaterMark* h) {
+    return h ? hwm_outstanding((HighWaterMark*)h) > hwm_signed(atomic_load_size(&((HighWaterMark*)h)->high)) : 0;
+}
@@ -0,0 +1,305 @@
+#include "lane_codec.h"
+#include "bi_buffer.h"
+#include "umsbb_clock.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define LANE_CODEC_HASH_BITS 12
+#define LANE_CODEC_HASH_SIZE (1u << LANE_CODEC_HASH_BITS)
+#define LANE_CODEC_MIN_MATCH 4
+#define LANE_CODEC_TAIL 5                   // The last bytes are always literals
+#define LANE_CODEC_MAX_OFFSET 65535
+#define LANE_CODEC_MAX_INPUT ((size_t)1 << 30)
+#define LANE_CODEC_FIRST_BACKOFF 16
+#define LANE_CODEC_SPEED_WEIGHT 8           // Each attempt moves the average speed 1/8 of the way
+#define LANE_CODEC_SPEED_HEADROOM 4         // The average starts at this multiple of the floor
+
+typedef struct LaneCodecContext {
+    uint32_t table[LANE_CODEC_HASH_SIZE];  // Input position + base of the latest 4-byte hash
+    uint32_t base;                          // Entries below this are from earlier inputs
+    uint8_t* scratch;                       // Output of lane_codec_encode
+    size_t scratch_size;
+    struct LaneCodecContext* next;
+    const void* owner;                      // Address of a thread-local of the owning thread
+} LaneCodecContext;
+
+static atomic_size_t lane_codec_contexts;  // LaneCodecContext list, pushed to by first-time encoders
+static SOMA_THREAD_LOCAL LaneCodecContext* lane_codec_context;
+
+/* The calling thread's context, created on first use. */
+static LaneCodecContext* lane_codec_acquire_context(void) {
+    if (lane_codec_context) return lane_codec_context;
+
+    // As in the arena allocator, a thread-local's address identifies this
+    // thread; a new thread on the address of an exited one continues its context
+    const void* self = &lane_codec_context;
+    LaneCodecContext* ctx = (LaneCodecContext*)(uintptr_t)atomic_load_size_acquire(&lane_codec_contexts);
+    for (; ctx; ctx = ctx->next) {
+        if (ctx->owner == self) break;
+    }
+    if (!ctx) {
+        ctx = (LaneCodecContext*)calloc(1, sizeof(LaneCodecContext));
+        if (!ctx) return NULL;
+        ctx->owner = self;
+        ctx->base = 1;
+        size_t head = atomic_load_size(&lane_codec_contexts);
+        do {
+            ctx->next = (LaneCodecContext*)(uintptr_t)head;
+        } while (!atomic_cas_size(&lane_codec_contexts, &head, (size_t)(uintptr_t)ctx));
+    }
+    lane_codec_context = ctx;
+    return ctx;
+}
+
+static inline uint32_t lane_codec_read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t lane_codec_hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LANE_CODEC_HASH_BITS);
+}
+
+static inline uint8_t* lane_codec_put_length(uint8_t* op, size_t rest) {
+    while (rest >= 255) {
+        *op++ = 255;
+        rest -= 255;
+    }
+    *op++ = (uint8_t)rest;
+    return op;
+}
+
+/* One sequence; match_len 0 ends the block. False if it does not fit. */
+static bool lane_codec_emit(uint8_t** out, const uint8_t* end, const uint8_t* literals, size_t literal_len,
+                            size_t offset, size_t match_len) {
+    uint8_t* op = *out;
+    size_t need = 1 + literal_len / 255 + 1 + literal_len;
+    if (match_len) need += 2 + (match_len - LANE_CODEC_MIN_MATCH) / 255 + 1;
+    if ((size_t)(end - op) < need) return false;
+
+    uint8_t* token = op++;
+    *token = (uint8_t)((literal_len >= 15 ? 15 : literal_len) << 4);
+    if (literal_len >= 15) op = lane_codec_put_length(op, literal_len - 15);
+    memcpy(op, literals, literal_len);
+    op += literal_len;
+
+    if (match_len) {
+        *op++ = (uint8_t)(offset & 0xFF);
+        *op++ = (uint8_t)(offset >> 8);
+        size_t rest = match_len - LANE_CODEC_MIN_MATCH;
+        *token |= (uint8_t)(rest >= 15 ? 15 : rest);
+        if (rest >= 15) op = lane_codec_put_length(op, rest - 15);
+    }
+    *out = op;
+    return true;
+}
+
+static size_t lane_codec_compress_with(LaneCodecContext* ctx, const uint8_t* src, size_t size,
+                                       uint8_t* dst, size_t capacity) {
+    if (size > LANE_CODEC_MAX_INPUT) return 0;
+
+    // Rebasing instead of clearing: older entries fall below the new base
+    if (ctx->base > UINT32_MAX - (uint32_t)size - 1) {
+        memset(ctx->table, 0, sizeof(ctx->table));
+        ctx->base = 1;
+    }
+    uint32_t base = ctx->base;
+    ctx->base += (uint32_t)size + 1;
+
+    uint8_t* op = dst;
+    const uint8_t* end = dst + capacity;
+    size_t anchor = 0, ip = 0;
+    if (size > LANE_CODEC_TAIL + LANE_CODEC_MIN_MATCH) {
+        size_t limit = size - LANE_CODEC_TAIL;
+        while (ip + LANE_CODEC_MIN_MATCH <= limit) {
+            uint32_t v = lane_codec_read32(src + ip);
+            uint32_t h = lane_codec_hash(v);
+            uint32_t entry = ctx->table[h];
+            ctx->table[h] = base + (uint32_t)ip;
+
+            if (entry >= base) {
+                size_t ref = entry - base;
+                if (ip - ref <= LANE_CODEC_MAX_OFFSET && lane_codec_read32(src + ref) == v) {
+                    size_t len = LANE_CODEC_MIN_MATCH;
+                    while (ip + len < limit && src[ref + len] == src[ip + len]) len++;
+                    while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                        ip--;
+                        ref--;
+                        len++;
+                    }
+                    if (!lane_codec_emit(&op, end, src + anchor, ip - anchor, ip - ref, len)) return 0;
+                    ip += len;
+                    anchor = ip;
+                    continue;
+                }
+            }
+            // Step faster through stretches without matches
+            ip += 1 + ((ip - anchor) >> 6);
+        }
+    }
+    if (!lane_codec_emit(&op, end, src + anchor, size - anchor, 0, 0)) return 0;
+    return (size_t)(op - dst);
+}
+
+size_t lane_codec_bound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+size_t lane_codec_compress(const void* src, size_t size, void* dst, size_t capacity) {
+    LaneCodecContext* ctx = lane_codec_acquire_context();
+    if (!ctx || !src || !dst) return 0;
+    return lane_codec_compress_with(ctx, (const uint8_t*)src, size, (uint8_t*)dst, capacity);
+}
+
+static bool lane_codec_get_length(const uint8_t** in, const uint8_t* end, size_t* length) {
+    const uint8_t* ip = *in;
+    uint8_t b;
+    do {
+        if (ip >= end) return false;
+        b = *ip++;
+        *length += b;
+    } while (b == 255);
+    *in = ip;
+    return true;
+}
+
+static bool lane_codec_decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t original) {
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + size;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + original;
+
+    for (;;) {
+        if (ip >= iend) return false;
+        unsigned token = *ip++;
+
+        size_t literals = token >> 4;
+        if (literals == 15 && !lane_codec_get_length(&ip, iend, &literals)) return false;
+        if ((size_t)(iend - ip) < literals || (size_t)(oend - op) < literals) return false;
+        memcpy(op, ip, literals);
+        op += literals;
+        ip += literals;
+        if (ip == iend) return op == oend;
+
+        if (iend - ip < 2) return false;
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return false;
+
+        size_t len = token & 15;
+        if (len == 15 && !lane_codec_get_length(&ip, iend, &len)) return false;
+        len += LANE_CODEC_MIN_MATCH;
+        if ((size_t)(oend - op) < len) return false;
+
+        const uint8_t* ref = op - offset;
+        if (offset >= len) {
+            memcpy(op, ref, len);
+        } else {
+            // Overlapping: the match repeats its last `offset` bytes
+            for (size_t i = 0; i < len; i++) op[i] = ref[i];
+        }
+        op += len;
+    }
+}
+
+void lane_codec_init(lane_codec_t* codec, uint32_t min_size, uint32_t min_saving) {
+    if (!codec) return;
+    codec->min_size = min_size;
+    codec->min_saving = (min_saving == 0 || min_saving >= 100) ? LANE_CODEC_MIN_SAVING : min_saving;
+    lane_codec_set_min_speed(codec, LANE_CODEC_MIN_BYTES_PER_US);
+    atomic_store_size(&codec->skip, 0);
+    atomic_store_size(&codec->backoff, 0);
+    atomic_store_size(&codec->attempts, 0);
+    atomic_store_size(&codec->compressed, 0);
+    atomic_store_size(&codec->skipped, 0);
+    atomic_store_size(&codec->bytes_in, 0);
+    atomic_store_size(&codec->bytes_out, 0);
+    atomic_store_size(&codec->failures, 0);
+}
+
+void lane_codec_set_min_speed(lane_codec_t* codec, uint32_t bytes_per_us) {
+    if (!codec) return;
+    codec->min_speed = bytes_per_us;
+    atomic_store_size(&codec->speed, (size_t)bytes_per_us * LANE_CODEC_SPEED_HEADROOM);
+}
+
+/* Fold one attempt into the lane's average speed; true if the average has
+ * fallen below the floor. Updates from racing producers may be lost, which
+ * only slows the average down. */
+static bool lane_codec_slow(lane_codec_t* codec, size_t size, uint64_t elapsed) {
+    if (codec->min_speed == 0) return false;
+    size_t sample = (size_t)((uint64_t)size * 1000 / (elapsed ? elapsed : 1));
+    size_t speed = atomic_load_size_relaxed(&codec->speed);
+    speed = speed - speed / LANE_CODEC_SPEED_WEIGHT + sample / LANE_CODEC_SPEED_WEIGHT;
+    atomic_store_size_relaxed(&codec->speed, speed);
+    return speed < codec->min_speed;
+}
+
+/* Store the next payloads raw for a while, longer after each miss. */
+static void lane_codec_miss(lane_codec_t* codec) {
+    size_t backoff = atomic_load_size_relaxed(&codec->backoff);
+    backoff = backoff ? backoff * 2 : LANE_CODEC_FIRST_BACKOFF;
+    if (backoff > LANE_CODEC_MAX_BACKOFF) backoff = LANE_CODEC_MAX_BACKOFF;
+    atomic_store_size_relaxed(&codec->backoff, backoff);
+    atomic_store_size_relaxed(&codec->skip, backoff);
+}
+
+const void* lane_codec_encode(lane_codec_t* codec, const void* data, size_t size, size_t* out_size) {
+    if (!codec || codec->min_size == 0 || size < codec->min_size || size > LANE_CODEC_MAX_INPUT) return NULL;
+
+    // Counting down across producers is approximate, which is all it needs
+    size_t skip = atomic_load_size_relaxed(&codec->skip);
+    if (skip) {
+        atomic_store_size_relaxed(&codec->skip, skip - 1);
+        atomic_fetch_add_size(&codec->skipped, 1);
+        return NULL;
+    }
+
+    LaneCodecContext* ctx = lane_codec_acquire_context();
+    if (!ctx) return NULL;
+    // Anything larger than this saves too little to keep
+    size_t keep = size - size * codec->min_saving / 100;
+    if (ctx->scratch_size < keep) {
+        uint8_t* grown = (uint8_t*)realloc(ctx->scratch, keep);
+        if (!grown) return NULL;
+        ctx->scratch = grown;
+        ctx->scratch_size = keep;
+    }
+
+    uint64_t start = umsbb_clock_ns();
+    size_t n = lane_codec_compress_with(ctx, (const uint8_t*)data, size, ctx->scratch, keep);
+    uint64_t elapsed = umsbb_clock_ns() - start;
+    atomic_fetch_add_size(&codec->attempts, 1);
+
+    bool slow = lane_codec_slow(codec, size, elapsed);
+    if (n == 0 || slow) lane_codec_miss(codec);
+    else atomic_store_size_relaxed(&codec->backoff, 0);
+    if (n == 0) return NULL;
+
+    // Already paid for: a slow compression that saved enough is still used
+    atomic_fetch_add_size(&codec->compressed, 1);
+    atomic_fetch_add_size(&codec->bytes_in, size);
+    atomic_fetch_add_size(&codec->bytes_out, n);
+    *out_size = n;
+    return ctx->scratch;
+}
+
+bool lane_codec_decode(lane_codec_t* codec, const void* src, size_t size, void* dst, size_t original) {
+    bool ok = src && dst && lane_codec_decompress((const uint8_t*)src, size, (uint8_t*)dst, original);
+    if (!ok && codec) atomic_fetch_add_size(&codec->failures, 1);
+    return ok;
+}
+
+void lane_codec_get_stats(const lane_codec_t* codec, lane_codec_stats_t* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!codec) return;
+    lane_codec_t* c = (lane_codec_t*)codec;
+    out->attempts = atomic_load_size_relaxed(&c->attempts);
+    out->compressed = atomic_load_size_relaxed(&c->compressed);
+    out->skipped = atomic_load_size_relaxed(&c->skipped);
+    out->bytes_in = atomic_load_size_relaxed(&c->bytes_in);
+    out->bytes_out = atomic_load_size_relaxed(&c->bytes_out);
+    out->failures = atomic_load_size_relaxed(&c->failures);
+}
@@ -0,0 +1,177 @@
+#include "lane_router.h"
+#include "umsbb_clock.h"
+#include <string.h>
+
+#define LANE_ROUTER_LANE_MASK 0xFFu
+#define LANE_ROUTER_LAST (LANE_ROUTER_CLASSES - 1)
+#define LANE_ROUTER_MAX_COST (SIZE_MAX >> 8)
+#define LANE_ROUTER_CONGESTION_SCALE 4.0   // Cost factor when every submit hit congestion, plus one
+
+#define LANE_ROUTER_BOUND(b) ((uint64_t)256 << (b))
+static const uint64_t lane_router_bounds[LANE_ROUTER_BOUNDS] = {
+    LANE_ROUTER_BOUND(0), LANE_ROUTER_BOUND(1), LANE_ROUTER_BOUND(2), LANE_ROUTER_BOUND(3),
+    LANE_ROUTER_BOUND(4), LANE_ROUTER_BOUND(5), LANE_ROUTER_BOUND(6), LANE_ROUTER_BOUND(7),
+    LANE_ROUTER_BOUND(8), LANE_ROUTER_BOUND(9), LANE_ROUTER_BOUND(10), LANE_ROUTER_BOUND(11),
+    LANE_ROUTER_BOUND(12), LANE_ROUTER_BOUND(13), LANE_ROUTER_BOUND(14), LANE_ROUTER_BOUND(15),
+    LANE_ROUTER_BOUND(16), LANE_ROUTER_BOUND(17), LANE_ROUTER_BOUND(18), LANE_ROUTER_BOUND(19),
+    LANE_ROUTER_BOUND(20), LANE_ROUTER_BOUND(21), LANE_ROUTER_BOUND(22), LANE_ROUTER_BOUND(23)
+};
+
+/* 0 up to 256 B, then one class per factor of four up to 256 KB. */
+static inline size_t lane_router_class(size_t size) {
+    if (size <= 256) return 0;
+    uint64_t v = (uint64_t)size - 1;
+#if defined(__GNUC__) || defined(__clang__)
+    unsigned log = 63u - (unsigned)__builtin_clzll(v);
+#else
+    unsigned log = 0;
+    while (v >>= 1) log++;
+#endif
+    size_t c = (log - 6) / 2;
+    return c < LANE_ROUTER_LAST ? c : LANE_ROUTER_LAST;
+}
+
+// Whether `lane` takes every message of class `c`
+static bool lane_router_fits(const fast_lane_manager_t* manager, lane_type_t lane, size_t c) {
+    const fast_lane_t* l = &manager->lanes[lane];
+    size_t largest = c < LANE_ROUTER_LAST ? (size_t)256 << (2 * c) : ((size_t)256 << (2 * (LANE_ROUTER_LAST - 1))) + 1;
+    return l->capacity && l->slot_size >= largest;
+}
+
+static inline lane_type_t lane_router_home(size_t c) {
+    return c <= 2 ? LANE_STREAMING : LANE_BULK;
+}
+
+static inline size_t lane_router_entry(lane_type_t lane, double cost_us) {
+    size_t cost = cost_us < (double)LANE_ROUTER_MAX_COST ? (size_t)(cost_us + 0.5) : LANE_ROUTER_MAX_COST;
+    return (cost << 8) | (size_t)lane;
+}
+
+void lane_router_init(lane_router_t* router, const fast_lane_manager_t* manager) {
+    if (!router || !manager) return;
+    memset(router, 0, sizeof(*router));
+
+    router->largest = LANE_STREAMING;
+    size_t largest = 0;
+    for (int i = 0; i < LANE_COUNT; i++) {
+        const fast_lane_t* lane = &manager->lanes[i];
+        router->cost_us[i] = lane->latency_target_us;
+        if (lane->capacity && lane->slot_size > largest) {
+            largest = lane->slot_size;
+            router->largest = (lane_type_t)i;
+        }
+    }
+
+    // fast_lane_select_optimal's routes, wherever the lanes take them
+    for (size_t c = 0; c < LANE_ROUTER_CLASSES; c++) {
+        lane_type_t home = lane_router_fits(manager, lane_router_home(c), c) ? lane_router_home(c) : router->largest;
+        lane_type_t critical = c == 0 && lane_router_fits(manager, LANE_EXPRESS, 0) ? LANE_EXPRESS : home;
+        atomic_store_size(&router->routes[c][0], lane_router_entry(home, router->cost_us[home]));
+        atomic_store_size(&router->routes[c][1], lane_router_entry(critical, router->cost_us[critical]));
+    }
+    router->updated_ns = umsbb_clock_ns();
+}
+
+// One window's cost estimate of `lane`, and the counters for the next
+static double lane_router_sample(lane_router_t* router, fast_lane_t* lane, size_t i, double window_us) {
+    const uint64_t* bounds = lane_router_bounds;
+    uint64_t below[LANE_ROUTER_BOUNDS];
+    uint64_t total = 0;
+    double sum = 0.0;
+    latency_histogram_cumulative(lane->latency, bounds, LANE_ROUTER_BOUNDS, below, &total, &sum);
+
+    uint64_t drained = total - router->drained[i];
+    double p99_us = lane->latency_target_us;
+    if (drained >= LANE_ROUTER_MIN_SAMPLES) {
+        uint64_t need = drained - drained / 100;
+        p99_us = (double)bounds[LANE_ROUTER_BOUNDS - 1] * 2 / 1000.0;
+        for (size_t b = 0; b < LANE_ROUTER_BOUNDS; b++) {
+            if (below[b] - router->below[i][b] >= need) {
+                p99_us = (double)bounds[b] / 1000.0;
+                break;
+            }
+        }
+    }
+    memcpy(router->below[i], below, sizeof(below));
+    router->drained[i] = total;
+
+    // Tail first: it can pass a head loaded earlier, never a later one
+    size_t tail = atomic_load_size(&lane->tail);
+    size_t head = atomic_load_size(&lane->head);
+    size_t depth = head - tail;
+    double wait_us = 0.0;
+    if (depth && drained) wait_us = (double)depth * window_us / (double)drained;
+    else if (depth) wait_us = window_us;
+
+    uint64_t submitted = head - router->submitted[i];
+    size_t events = atomic_load_size(&lane->congestion_events);
+    uint64_t congestion = events - router->congestion[i];
+    router->submitted[i] = head;
+    router->congestion[i] = events;
+    double congested = submitted ? (double)(congestion < submitted ? congestion : submitted) / (double)submitted : 0.0;
+
+    return (p99_us + wait_us) * (1.0 + LANE_ROUTER_CONGESTION_SCALE * congested);
+}
+
+size_t lane_router_update(lane_router_t* router, fast_lane_manager_t* manager, const uint32_t weights[LANE_COUNT]) {
+    if (!router || !manager) return 0;
+    uint64_t now = umsbb_clock_ns();
+    double window_us = (double)(now - router->updated_ns) / 1000.0;
+    router->updated_ns = now;
+    router->updates++;
+
+    double cost[LANE_COUNT];
+    for (size_t i = 0; i < LANE_COUNT; i++) {
+        fast_lane_t* lane = &manager->lanes[i];
+        cost[i] = -1.0;
+        if (!lane->capacity) continue;
+        router->cost_us[i] = (router->cost_us[i] + lane_router_sample(router, lane, i, window_us)) / 2;
+        uint32_t weight = weights ? weights[i] : LANE_ROUTER_WEIGHT_DEFAULT;
+        cost[i] = weight ? router->cost_us[i] * weight / 100.0 : -1.0;
+    }
+
+    size_t moved = 0;
+    for (size_t c = 0; c < LANE_ROUTER_CLASSES; c++) {
+        for (int critical = 0; critical < 2; critical++) {
+            // What a message of this class would pay on each lane it may take
+            double price[LANE_COUNT];
+            for (size_t i = 0; i < LANE_COUNT; i++) {
+                lane_type_t lane = (lane_type_t)i;
+                bool allowed = critical ? lane != LANE_PRIORITY : (lane == LANE_STREAMING || lane == LANE_BULK);
+                price[i] = -1.0;
+                if (!allowed || !lane_router_fits(manager, lane, c) || cost[i] < 0) continue;
+                price[i] = !critical && lane != lane_router_home(c) ? cost[i] * 2 : cost[i];
+            }
+
+            size_t entry = atomic_load_size_relaxed(&router->routes[c][critical]);
+            lane_type_t current = (lane_type_t)(entry & LANE_ROUTER_LANE_MASK);
+            lane_type_t best = LANE_COUNT;
+            for (size_t i = 0; i < LANE_COUNT; i++) {
+                if (price[i] >= 0 && (best == LANE_COUNT || price[i] < price[best])) best = (lane_type_t)i;
+            }
+            if (best == LANE_COUNT) {
+                best = router->largest;
+            } else if (price[current] >= 0 && price[best] * 100 > price[current] * LANE_ROUTER_HYSTERESIS) {
+                best = current;
+            }
+            if (best != current) moved++;
+            atomic_store_size_relaxed(&router->routes[c][critical], lane_router_entry(best, router->cost_us[best]));
+        }
+    }
+    return moved;
+}
+
+lane_type_t lane_router_select(lane_router_t* router, const fast_lane_manager_t* manager,
+                               size_t size, bool latency_critical, double timeout_ms) {
+    size_t c = lane_router_class(size);
+    size_t entry = atomic_load_size_relaxed(&router->routes[c][latency_critical]);
+    if (!latency_critical && timeout_ms > 0 && (double)(entry >> 8) > timeout_ms * 1000.0) {
+        entry = atomic_load_size_relaxed(&router->routes[c][1]);
+    }
+    lane_type_t lane = (lane_type_t)(entry & LANE_ROUTER_LANE_MASK);
+    return size <= manager->lanes[lane].slot_size ? lane : router->largest;
+}
+
+double lane_router_cost(const lane_router_t* router, lane_type_t lane) {
+    return router && lane < LANE_COUNT ? router->cost_us[lane] : 0.0;
+}
@@ -1,27 +1,62 @@
 #include "language_bindings.h"
 #include "universal_multi_segmented_bi_buffer_bus.h"
 #include "gpu_delegate.h"
+#include "message_pool.h"
+#include "umsbb_clock.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <pthread.h>
 #include <time.h>
 
+#if defined(_WIN32)
+#  include <windows.h>
+#  define bindings_yield() SwitchToThread()
+#else
+#  include <sched.h>
+#  define bindings_yield() sched_yield()
+#endif
+
 // Global state
 static language_runtime_t registered_runtimes[16];
 static bool runtime_initialized[16] = {false};
-static scaling_config_t current_scaling_config = {0};
-static pthread_mutex_t scaling_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Scaling configuration, one atomic per field so readers never lock; a
+// reader racing configure_auto_scaling may mix old and new fields
+static struct {
+    UMSBB_ATOMIC(uint32_t) min_producers;
+    UMSBB_ATOMIC(uint32_t) max_producers;
+    UMSBB_ATOMIC(uint32_t) min_consumers;
+    UMSBB_ATOMIC(uint32_t) max_consumers;
+    UMSBB_ATOMIC(uint32_t) scale_threshold_percent;
+    UMSBB_ATOMIC(uint32_t) scale_cooldown_ms;
+    UMSBB_ATOMIC(bool) gpu_preferred;
+    UMSBB_ATOMIC(bool) auto_balance_load;
+} current_scaling_config;
 
 // Performance monitoring
 static struct {
-    uint32_t active_producers;
-    uint32_t active_consumers;
-    uint64_t total_operations;
-    uint64_t gpu_operations;
-    double avg_latency_us;
-    time_t last_scale_time;
-} performance_stats = {0};
+    UMSBB_ATOMIC(uint32_t) active_producers;
+    UMSBB_ATOMIC(uint32_t) active_consumers;
+    UMSBB_ATOMIC(uint64_t) total_operations;
+    UMSBB_ATOMIC(uint64_t) gpu_operations;
+    UMSBB_ATOMIC(uint64_t) last_scale_ms;
+} performance_stats;
+
+// Bus whose parallel workers follow the scaling configuration. Held under
+// scaled_bus_busy from load to last use, so umsbb_free (through
+// language_bindings_forget_bus) never frees it under the evaluator
+typedef UniversalMultiSegmentedBiBufferBus* bus_handle_t;
+static UMSBB_ATOMIC(bus_handle_t) scaled_bus;
+static UMSBB_ATOMIC(bool) scaled_bus_busy;
+
+static UniversalMultiSegmentedBiBufferBus* scaled_bus_lock(void) {
+    while (atomic_exchange(&scaled_bus_busy, true)) bindings_yield();
+    return atomic_load(&scaled_bus);
+}
+
+static void scaled_bus_unlock(void) {
+    atomic_store(&scaled_bus_busy, false);
+}
 
 // Language runtime registration
 bool register_language_runtime(language_type_t lang, const language_runtime_t* runtime) {
@@ -48,28 +83,41 @@ language_runtime_t* get_language_runtime(language_type_t lang) {
 }
 
 // Universal data management
-universal_data_t* create_universal_data(void* data, size_t size, uint32_t type_id, language_type_t lang) {
-    universal_data_t* udata = malloc(sizeof(universal_data_t));
-    if (!udata) return NULL;
-    
-    // Try to use language-specific allocator if available
+// Payloads come from the language allocator when one is registered,
+// otherwise from the message pool; free_universal_data mirrors this choice
+static void* universal_data_alloc(language_type_t lang, size_t size) {
     language_runtime_t* runtime = get_language_runtime(lang);
-    if (runtime && runtime->allocator) {
-        udata->data = runtime->allocator(size);
+    if (runtime && runtime->allocator) return runtime->allocator(size);
+    return message_pool_alloc(size);
+}
+
+static void universal_data_release(language_type_t lang, void* data) {
+    language_runtime_t* runtime = get_language_runtime(lang);
+    if (runtime && runtime->deallocator) {
+        runtime->deallocator(data);
     } else {
-        udata->data = malloc(size);
+        message_pool_release(data);
     }
-    
-    if (!udata->data) {
-        free(udata);
-        return NULL;
-    }
-    
-    memcpy(udata->data, data, size);
+}
+
+static universal_data_t* universal_data_wrap(void* payload, size_t size, uint32_t type_id, language_type_t lang) {
+    universal_data_t* udata = message_pool_alloc(sizeof(universal_data_t));
+    if (!udata) return NULL;
+
+    udata->data = payload;
     udata->size = size;
     udata->type_id = type_id;
     udata->source_lang = lang;
-    
+    return udata;
+}
+
+universal_data_t* create_universal_data(void* data, size_t size, uint32_t type_id, language_type_t lang) {
+    void* payload = universal_data_alloc(lang, size);
+    if (!payload) return NULL;
+    memcpy(payload, data, size);
+
+    universal_data_t* udata = universal_data_wrap(payload, size, type_id, lang);
+    if (!udata) universal_data_release(lang, payload);
     return udata;
 }
 
@@ -78,9 +126,11 @@ bool convert_data_for_language(const universal_data_t* src, universal_data_t* ds
     
     language_runtime_t* target_runtime = get_language_runtime(target_lang);
     if (!target_runtime) {
-        // Direct copy if no runtime registered
+        // Direct copy if no runtime registered; owned by the target so
+        // free_universal_data returns it to the pool
         memcpy(dst, src, sizeof(universal_data_t));
-        dst->data = malloc(src->size);
+        dst->source_lang = target_lang;
+        dst->data = message_pool_alloc(src->size);
         if (!dst->data) return false;
         memcpy(dst->data, src->data, src->size);
         return true;
@@ -91,22 +141,13 @@ bool convert_data_for_language(const universal_data_t* src, universal_data_t* ds
     dst->type_id = src->type_id;
     dst->source_lang = target_lang;
     
-    if (target_runtime->allocator) {
-        dst->data = target_runtime->allocator(src->size);
-    } else {
-        dst->data = malloc(src->size);
-    }
-    
+    dst->data = universal_data_alloc(target_lang, src->size);
     if (!dst->data) return false;
     memcpy(dst->data, src->data, src->size);
     
     // Validate if validator available
     if (target_runtime->data_validator && !target_runtime->data_validator(dst)) {
-        if (target_runtime->deallocator) {
-            target_runtime->deallocator(dst->data);
-        } else {
-            free(dst->data);
-        }
+        universal_data_release(target_lang, dst->data);
         return false;
     }
     
@@ -115,105 +156,166 @@ bool convert_data_for_language(const universal_data_t* src, universal_data_t* ds
 
 void free_universal_data(universal_data_t* data) {
     if (!data) return;
-    
-    language_runtime_t* runtime = get_language_runtime(data->source_lang);
-    if (runtime && runtime->deallocator) {
-        runtime->deallocator(data->data);
-    } else {
-        free(data->data);
-    }
-    
-    free(data);
+
+    universal_data_release(data->source_lang, data->data);
+    message_pool_release(data);
 }
 
 // Auto-scaling implementation
+#if UMSBB_ENABLE_PARALLEL
+// Consumers are parallel workers: the threshold is the busy share above
+// which one is added, half of it the share below which one is retired, and
+// the latency marks match the producer ones below
+static parallel_autoscale_t scaling_policy(const scaling_config_t* config) {
+    parallel_autoscale_t policy;
+    memset(&policy, 0, sizeof(policy));
+    policy.min_workers = config->min_consumers ? config->min_consumers : 1;
+    policy.max_workers = config->max_consumers < UMSBB_MAX_WORKER_THREADS ? config->max_consumers : UMSBB_MAX_WORKER_THREADS;
+    if (policy.max_workers < policy.min_workers) policy.max_workers = policy.min_workers;
+    policy.queue_high = UMSBB_BATCH_SIZE;
+    policy.queue_low = UMSBB_BATCH_SIZE / 8;
+    policy.p99_high_ns = 100000;
+    policy.p99_low_ns = 10000;
+    policy.busy_high_percent = config->scale_threshold_percent ? config->scale_threshold_percent : 80;
+    policy.busy_low_percent = policy.busy_high_percent / 2;
+    policy.cooldown_ms = config->scale_cooldown_ms;
+    return policy;
+}
+#endif
+
+// Parallel workers of a bus following the configuration, 0 without any
+static uint32_t scaled_workers(UniversalMultiSegmentedBiBufferBus* bus) {
+#if UMSBB_ENABLE_PARALLEL
+    return bus && bus->parallel_processing_enabled ? umsbb_get_active_workers(bus) : 0;
+#else
+    (void)bus;
+    return 0;
+#endif
+}
+
+// Hand the bus's workers to the scaling controller; called under scaled_bus_lock
+static bool attach_scaling(UniversalMultiSegmentedBiBufferBus* bus, const scaling_config_t* config) {
+#if UMSBB_ENABLE_PARALLEL
+    parallel_autoscale_t policy = scaling_policy(config);
+    if (!bus->parallel_processing_enabled &&
+        !umsbb_enable_parallel_processing(bus, policy.min_workers, THROUGHPUT_STRATEGY_BALANCED)) {
+        return false;
+    }
+    if (!umsbb_enable_auto_scaling(bus, &policy)) return false;
+    atomic_store(&scaled_bus, bus);
+    return true;
+#else
+    (void)bus;
+    (void)config;
+    return false; // Built without the parallel engine
+#endif
+}
+
 bool configure_auto_scaling(const scaling_config_t* config) {
     if (!config) return false;
     
-    pthread_mutex_lock(&scaling_mutex);
-    memcpy(&current_scaling_config, config, sizeof(scaling_config_t));
+    atomic_store(&current_scaling_config.min_producers, config->min_producers);
+    atomic_store(&current_scaling_config.max_producers, config->max_producers);
+    atomic_store(&current_scaling_config.min_consumers, config->min_consumers);
+    atomic_store(&current_scaling_config.max_consumers, config->max_consumers);
+    atomic_store(&current_scaling_config.scale_threshold_percent, config->scale_threshold_percent);
+    atomic_store(&current_scaling_config.scale_cooldown_ms, config->scale_cooldown_ms);
+    atomic_store(&current_scaling_config.gpu_preferred, config->gpu_preferred);
+    atomic_store(&current_scaling_config.auto_balance_load, config->auto_balance_load);
     
     printf("[AutoScale] Configured: producers %u-%u, consumers %u-%u, threshold %u%%\n",
            config->min_producers, config->max_producers,
            config->min_consumers, config->max_consumers,
            config->scale_threshold_percent);
     
-    pthread_mutex_unlock(&scaling_mutex);
+    // A bus already following the configuration picks up the new one
+    UniversalMultiSegmentedBiBufferBus* bus = scaled_bus_lock();
+    if (bus && config->max_consumers > 0) attach_scaling(bus, config);
+    scaled_bus_unlock();
     return true;
 }
 
 scaling_config_t get_scaling_config() {
-    pthread_mutex_lock(&scaling_mutex);
-    scaling_config_t config = current_scaling_config;
-    pthread_mutex_unlock(&scaling_mutex);
+    scaling_config_t config;
+    config.min_producers = atomic_load(&current_scaling_config.min_producers);
+    config.max_producers = atomic_load(&current_scaling_config.max_producers);
+    config.min_consumers = atomic_load(&current_scaling_config.min_consumers);
+    config.max_consumers = atomic_load(&current_scaling_config.max_consumers);
+    config.scale_threshold_percent = atomic_load(&current_scaling_config.scale_threshold_percent);
+    config.scale_cooldown_ms = atomic_load(&current_scaling_config.scale_cooldown_ms);
+    config.gpu_preferred = atomic_load(&current_scaling_config.gpu_preferred);
+    config.auto_balance_load = atomic_load(&current_scaling_config.auto_balance_load);
     return config;
 }
 
 void trigger_scale_evaluation() {
-    pthread_mutex_lock(&scaling_mutex);
-    
-    time_t now = time(NULL);
-    if (now - performance_stats.last_scale_time < current_scaling_config.scale_cooldown_ms / 1000) {
-        pthread_mutex_unlock(&scaling_mutex);
+    uint64_t now = umsbb_clock_coarse_ns() / 1000000;
+    uint64_t last = atomic_load(&performance_stats.last_scale_ms);
+    if (now - last < atomic_load(&current_scaling_config.scale_cooldown_ms)) {
         return; // Too soon to scale again
     }
-    
-    // Calculate load metrics
-    double gpu_ratio = performance_stats.total_operations > 0 ? 
-                      (double)performance_stats.gpu_operations / performance_stats.total_operations : 0.0;
-    
-    // Scale producers based on latency
-    if (performance_stats.avg_latency_us > 100.0 && 
-        performance_stats.active_producers < current_scaling_config.max_producers) {
-        performance_stats.active_producers++;
-        printf("[AutoScale] Scaled up producers to %u (latency: %.2f μs)\n", 
-               performance_stats.active_producers, performance_stats.avg_latency_us);
-    } else if (performance_stats.avg_latency_us < 10.0 && 
-               performance_stats.active_producers > current_scaling_config.min_producers) {
-        performance_stats.active_producers--;
-        printf("[AutoScale] Scaled down producers to %u (latency: %.2f μs)\n", 
-               performance_stats.active_producers, performance_stats.avg_latency_us);
+    // One caller per cooldown period evaluates; the rest return at once
+    if (!atomic_compare_exchange_strong(&performance_stats.last_scale_ms, &last, now)) return;
+    
+    scaling_config_t config = get_scaling_config();
+    uint64_t total = atomic_load(&performance_stats.total_operations);
+    double gpu_ratio = total > 0 ? (double)atomic_load(&performance_stats.gpu_operations) / total : 0.0;
+    
+    // Scale producers on the consumers' latency, as seen by the controller
+    UniversalMultiSegmentedBiBufferBus* bus = scaled_bus_lock();
+    double latency_us = 0.0;
+#if UMSBB_ENABLE_PARALLEL
+    if (bus && bus->parallel_processing_enabled) {
+        latency_us = latency_histogram_percentile(bus->parallel_engine.latency, 0.99) / 1000.0;
     }
-    
-    // Scale consumers based on throughput
-    uint32_t target_consumers = performance_stats.active_producers;
-    if (current_scaling_config.gpu_preferred && gpu_available()) {
-        target_consumers = (target_consumers + 1) / 2; // Fewer consumers needed with GPU
+#endif
+    uint32_t workers = scaled_workers(bus);
+    scaled_bus_unlock();
+
+    uint32_t producers = atomic_load(&performance_stats.active_producers);
+    if (latency_us > 100.0 && producers < config.max_producers) {
+        producers++;
+        printf("[AutoScale] Scaled up producers to %u (latency: %.2f μs)\n", producers, latency_us);
+    } else if (latency_us < 10.0 && producers > config.min_producers) {
+        producers--;
+        printf("[AutoScale] Scaled down producers to %u (latency: %.2f μs)\n", producers, latency_us);
+    }
+    atomic_store(&performance_stats.active_producers, producers);
+    
+    // Consumers: the live worker count when a bus follows the configuration,
+    // otherwise the estimate from producers
+    uint32_t target_consumers = workers;
+    if (target_consumers == 0) {
+        target_consumers = producers;
+        if (config.gpu_preferred && gpu_available()) {
+            target_consumers = (target_consumers + 1) / 2; // Fewer consumers needed with GPU
+        }
+        target_consumers = (target_consumers < config.min_consumers) ? config.min_consumers : target_consumers;
+        target_consumers = (target_consumers > config.max_consumers) ? config.max_consumers : target_consumers;
     }
     
-    target_consumers = (target_consumers < current_scaling_config.min_consumers) ? 
-                      current_scaling_config.min_consumers : target_consumers;
-    target_consumers = (target_consumers > current_scaling_config.max_consumers) ? 
-                      current_scaling_config.max_consumers : target_consumers;
-    
-    if (target_consumers != performance_stats.active_consumers) {
-        performance_stats.active_consumers = target_consumers;
+    if (atomic_exchange(&performance_stats.active_consumers, target_consumers) != target_consumers) {
         printf("[AutoScale] Adjusted consumers to %u (GPU ratio: %.2f)\n", 
                target_consumers, gpu_ratio);
     }
-    
-    performance_stats.last_scale_time = now;
-    pthread_mutex_unlock(&scaling_mutex);
 }
 
 uint32_t get_optimal_producer_count() {
-    pthread_mutex_lock(&scaling_mutex);
-    uint32_t count = performance_stats.active_producers;
-    pthread_mutex_unlock(&scaling_mutex);
+    uint32_t count = atomic_load(&performance_stats.active_producers);
     return count > 0 ? count : 1;
 }
 
 uint32_t get_optimal_consumer_count() {
-    pthread_mutex_lock(&scaling_mutex);
-    uint32_t count = performance_stats.active_consumers;
-    pthread_mutex_unlock(&scaling_mutex);
+    uint32_t count = scaled_workers(scaled_bus_lock());
+    scaled_bus_unlock();
+    if (count == 0) count = atomic_load(&performance_stats.active_consumers);
     return count > 0 ? count : 1;
 }
 
 // Direct language bindings (no API wrapper)
 void* umsbb_create_direct(size_t buffer_size, uint32_t segment_count, language_type_t lang) {
     // Initialize GPU if configured for GPU preference
-    if (current_scaling_config.gpu_preferred) {
+    if (atomic_load(&current_scaling_config.gpu_preferred)) {
         initialize_gpu();
     }
     
@@ -226,6 +328,15 @@ void* umsbb_create_direct(size_t buffer_size, uint32_t segment_count, language_t
     UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(buffer_size, optimal_segments);
     if (!bus) return NULL;
     
+    // With consumers configured, parallel workers follow the load
+    scaling_config_t config = get_scaling_config();
+    if (config.max_consumers > 0) {
+        scaled_bus_lock();
+        bool attached = attach_scaling(bus, &config);
+        scaled_bus_unlock();
+        if (!attached) printf("[Direct] Auto-scaling unavailable, workers stay fixed\n");
+    }
+    
     printf("[Direct] Created bus for %s with %u segments (%zu bytes each)\n",
            lang < 16 && runtime_initialized[lang] ? registered_runtimes[lang].lang_name : "Unknown",
            optimal_segments, buffer_size);
@@ -234,25 +345,30 @@ void* umsbb_create_direct(size_t buffer_size, uint32_t segment_count, language_t
 }
 
 bool umsbb_submit_direct(void* bus_handle, const universal_data_t* data) {
-    if (!bus_handle || !data) return false;
+    if (!data) return false;
+    return umsbb_send_direct(bus_handle, data->type_id, data->data, data->size);
+}
+
+bool umsbb_send_direct(void* bus_handle, uint32_t type_id, const void* data, size_t size) {
+    if (!bus_handle || (!data && size)) return false;
     
     UniversalMultiSegmentedBiBufferBus* bus = (UniversalMultiSegmentedBiBufferBus*)bus_handle;
     
     // Try GPU execution for large data
     bool gpu_used = false;
-    if (current_scaling_config.gpu_preferred && data->size > 1024 * 1024) {
-        gpu_used = try_gpu_execute(data->data, data->size);
+    if (atomic_load(&current_scaling_config.gpu_preferred) && size > 1024 * 1024) {
+        gpu_used = try_gpu_execute((void*)data, size);
         if (gpu_used) {
-            performance_stats.gpu_operations++;
+            atomic_fetch_add(&performance_stats.gpu_operations, 1);
         }
     }
     
-    // Submit to appropriate segment
-    uint32_t segment_id = data->type_id % bus->segment_count;
-    bool result = umsbb_submit_to(bus, segment_id, data->data, data->size);
+    // Submit to appropriate segment, copying once from the caller into the ring
+    uint32_t segment_id = type_id % bus->segment_count;
+    bool result = umsbb_submit_to(bus, segment_id, (const char*)data, size);
     
     if (result) {
-        performance_stats.total_operations++;
+        atomic_fetch_add(&performance_stats.total_operations, 1);
         // Update performance stats for auto-scaling
         trigger_scale_evaluation();
     }
@@ -260,33 +376,87 @@ bool umsbb_submit_direct(void* bus_handle, const universal_data_t* data) {
     return result;
 }
 
-universal_data_t* umsbb_drain_direct(void* bus_handle, language_type_t target_lang) {
-    if (!bus_handle) return NULL;
+void* umsbb_take_direct(void* bus_handle, size_t* size, uint32_t* type_id) {
+    if (!bus_handle || !size) return NULL;
     
     UniversalMultiSegmentedBiBufferBus* bus = (UniversalMultiSegmentedBiBufferBus*)bus_handle;
     
-    // Try draining from multiple segments
-    for (uint32_t i = 0; i < bus->segment_count; i++) {
-        size_t size;
-        void* data = umsbb_drain_from(bus, i, &size);
-        if (data && size > 0) {
-            // Create universal data structure
-            universal_data_t* udata = create_universal_data(data, size, i, target_lang);
-            free(data); // Free original data
-            
-            performance_stats.total_operations++;
-            return udata;
+    // Visit only lanes the ready map flags instead of probing every segment
+    size_t lane = segment_ring_next_ready(&bus->ring, 0);
+    for (size_t visited = 0; lane != SEGMENT_RING_NONE && visited < bus->ring.laneCount; ++visited) {
+        void* data = umsbb_drain_from(bus, lane, size);
+        if (!data || *size == 0) {
+            message_pool_release(data);
+            lane = segment_ring_next_ready(&bus->ring, lane + 1);
+            continue;
         }
+
+        if (type_id) *type_id = (uint32_t)lane;
+        atomic_fetch_add(&performance_stats.total_operations, 1);
+        return data;
     }
     
     return NULL;
 }
 
+universal_data_t* umsbb_drain_direct(void* bus_handle, language_type_t target_lang) {
+    size_t size;
+    uint32_t lane;
+    void* data = umsbb_take_direct(bus_handle, &size, &lane);
+    if (!data) return NULL;
+
+    // The drained buffer is already pooled; adopt it unless the target
+    // language brings its own allocator
+    language_runtime_t* runtime = get_language_runtime(target_lang);
+    universal_data_t* udata;
+    if (runtime && runtime->allocator) {
+        udata = create_universal_data(data, size, lane, target_lang);
+        message_pool_release(data);
+    } else {
+        udata = universal_data_wrap(data, size, lane, target_lang);
+        if (!udata) message_pool_release(data);
+    }
+    return udata;
+}
+
+bool umsbb_view_direct(void* bus_handle, const void** data, size_t* size, size_t* lane) {
+    if (!bus_handle || !data || !size || !lane) return false;
+    
+    UniversalMultiSegmentedBiBufferBus* bus = (UniversalMultiSegmentedBiBufferBus*)bus_handle;
+    
+    // Same lane walk as umsbb_take_direct, but the message stays in its slot
+    size_t next = segment_ring_next_ready(&bus->ring, 0);
+    for (size_t visited = 0; next != SEGMENT_RING_NONE && visited < bus->ring.laneCount; ++visited) {
+        umsbb_msg_view view;
+        if (umsbb_drain_view(bus, next, &view)) {
+            *data = view.data;
+            *size = view.size;
+            *lane = next;
+            return true;
+        }
+        next = segment_ring_next_ready(&bus->ring, next + 1);
+    }
+    
+    return false;
+}
+
+void umsbb_release_direct(void* bus_handle, size_t lane) {
+    if (!bus_handle) return;
+    umsbb_release_view((UniversalMultiSegmentedBiBufferBus*)bus_handle, lane);
+    atomic_fetch_add(&performance_stats.total_operations, 1);
+}
+
+void language_bindings_forget_bus(void* bus_handle) {
+    if (!bus_handle) return;
+    // Waits out an evaluation still using the bus
+    if (scaled_bus_lock() == bus_handle) atomic_store(&scaled_bus, NULL);
+    scaled_bus_unlock();
+}
+
 void umsbb_destroy_direct(void* bus_handle) {
     if (!bus_handle) return;
     
-    UniversalMultiSegmentedBiBufferBus* bus = (UniversalMultiSegmentedBiBufferBus*)bus_handle;
-    umsbb_free(bus);
+    umsbb_free((UniversalMultiSegmentedBiBufferBus*)bus_handle);
     
     printf("[Direct] Bus destroyed\n");
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "latency_histogram.h"
+#include "portable_atomic.h"
+#include "bi_buffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+#define LATENCY_HISTOGRAM_CACHE 8       // Histograms a thread records into without a lookup
+
+typedef struct LatencyShard {
+    atomic_size_t counts[LATENCY_HISTOGRAM_BUCKETS];    // Written by the owner only
+    struct LatencyShard* next;
+    const void* owner;                  // Address of a thread-local of the owning thread
+} LatencyShard;
+
+struct LatencyHistogram {
+    size_t id;
+    atomic_size_t shards;               // LatencyShard list, pushed to by first-time recorders
+    size_t* baseline;                   // Merged counts at the previous interval call
+};
+
+typedef struct {
+    size_t id;
+    LatencyShard* shard;
+} LatencyCacheEntry;
+
+static atomic_size_t latency_next_id;
+static SOMA_THREAD_LOCAL LatencyCacheEntry latency_cached[LATENCY_HISTOGRAM_CACHE];
+
+static inline unsigned latency_log2(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63u - (unsigned)__builtin_clzll(v);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return (unsigned)index;
+#else
+    unsigned log = 0;
+    while (v >>= 1) log++;
+    return log;
+#endif
+}
+
+static inline size_t latency_bucket(uint64_t ns) {
+    const uint64_t limit = (uint64_t)1 << LATENCY_HISTOGRAM_MAX_BITS;
+    if (ns >= limit) ns = limit - 1;
+    if (ns < 2 * LATENCY_HISTOGRAM_SUB_COUNT) return (size_t)ns;
+    unsigned shift = latency_log2(ns) - LATENCY_HISTOGRAM_SUB_BITS;
+    return (size_t)shift * LATENCY_HISTOGRAM_SUB_COUNT + (size_t)(ns >> shift);
+}
+
+static inline uint64_t latency_bucket_lowest(size_t index) {
+    if (index < 2 * LATENCY_HISTOGRAM_SUB_COUNT) return index;
+    unsigned shift = (unsigned)(index / LATENCY_HISTOGRAM_SUB_COUNT) - 1;
+    return (uint64_t)(index - (size_t)shift * LATENCY_HISTOGRAM_SUB_COUNT) << shift;
+}
+
+static inline uint64_t latency_bucket_highest(size_t index) {
+    if (index < 2 * LATENCY_HISTOGRAM_SUB_COUNT) return index;
+    unsigned shift = (unsigned)(index / LATENCY_HISTOGRAM_SUB_COUNT) - 1;
+    return latency_bucket_lowest(index) + ((uint64_t)1 << shift) - 1;
+}
+
+LatencyHistogram* latency_histogram_create(void) {
+    LatencyHistogram* h = (LatencyHistogram*)calloc(1, sizeof(LatencyHistogram));
+    if (!h) return NULL;
+    h->id = atomic_fetch_add_size(&latency_next_id, 1) + 1;
+    atomic_store_size(&h->shards, 0);
+    return h;
+}
+
+void latency_histogram_destroy(LatencyHistogram* h) {
+    if (!h) return;
+    LatencyShard* shard = (LatencyShard*)(uintptr_t)atomic_load_size(&h->shards);
+    while (shard) {
+        LatencyShard* next = shard->next;
+        free(shard);
+        shard = next;
+    }
+    free(h->baseline);
+    free(h);
+}
+
+/* The calling thread's shard of `h`, created on first use. */
+static LatencyShard* latency_shard(LatencyHistogram* h) {
+    LatencyCacheEntry* entry = &latency_cached[h->id % LATENCY_HISTOGRAM_CACHE];
+    if (entry->id == h->id) return entry->shard;
+
+    // As in the arena allocator, a thread-local's address identifies this
+    // thread; a new thread on the address of an exited one continues its shard
+    const void* self = latency_cached;
+    LatencyShard* shard = (LatencyShard*)(uintptr_t)atomic_load_size_acquire(&h->shards);
+    for (; shard; shard = shard->next) {
+        if (shard->owner == self) break;
+    }
+    if (!shard) {
+        shard = (LatencyShard*)calloc(1, sizeof(LatencyShard));
+        if (!shard) return NULL;
+        shard->owner = self;
+        size_t head = atomic_load_size(&h->shards);
+        do {
+            shard->next = (LatencyShard*)(uintptr_t)head;
+        } while (!atomic_cas_size(&h->shards, &head, (size_t)(uintptr_t)shard));
+    }
+    entry->id = h->id;
+    entry->shard = shard;
+    return shard;
+}
+
+void latency_histogram_record(LatencyHistogram* h, uint64_t ns) {
+    if (!h) return;
+    LatencyShard* shard = latency_shard(h);
+    if (!shard) return;
+    // Single writer: a plain increment, kept atomic only for the readers
+    atomic_size_t* count = &shard->counts[latency_bucket(ns)];
+    atomic_store_size_relaxed(count, atomic_load_size_relaxed(count) + 1);
+}
+
+/* Sum every shard into counts. */
+static void latency_merge(const LatencyHistogram* h, size_t* counts) {
+    memset(counts, 0, sizeof(size_t) * LATENCY_HISTOGRAM_BUCKETS);
+    LatencyShard* shard = (LatencyShard*)(uintptr_t)atomic_load_size_acquire(&((LatencyHistogram*)h)->shards);
+    for (; shard; shard = shard->next) {
+        for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; ++i) {
+            counts[i] += atomic_load_size_relaxed(&shard->counts[i]);
+        }
+    }
+}
+
+static uint64_t latency_rank(uint64_t total, double q) {
+    if (q <= 0.0) return 1;
+    if (q >= 1.0) return total;
+    uint64_t rank = (uint64_t)(q * (double)total);
+    if ((double)rank < q * (double)total) rank++;
+    return rank ? rank : 1;
+}
+
+static void latency_describe(const size_t* counts, LatencySummary* out) {
+    *out = (LatencySummary){0};
+    uint64_t total = 0;
+    double weighted = 0.0;
+    size_t first = LATENCY_HISTOGRAM_BUCKETS, last = 0;
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; ++i) {
+        if (!counts[i]) continue;
+        if (first == LATENCY_HISTOGRAM_BUCKETS) first = i;
+        last = i;
+        total += counts[i];
+        uint64_t lowest = latency_bucket_lowest(i);
+        weighted += (double)counts[i] * ((double)lowest + (double)(latency_bucket_highest(i) - lowest) / 2.0);
+    }
+    if (!total) return;
+
+    out->count = total;
+    out->minNs = latency_bucket_lowest(first);
+    out->maxNs = latency_bucket_highest(last);
+    out->meanNs = weighted / (double)total;
+
+    const double quantiles[4] = { 0.5, 0.9, 0.99, 0.999 };
+    uint64_t* targets[4] = { &out->p50Ns, &out->p90Ns, &out->p99Ns, &out->p999Ns };
+    uint64_t seen = 0;
+    int next = 0;
+    for (size_t i = first; i <= last && next < 4; ++i) {
+        seen += counts[i];
+        while (next < 4 && seen >= latency_rank(total, quantiles[next])) {
+            *targets[next++] = latency_bucket_highest(i);
+        }
+    }
+}
+
+void latency_histogram_summary(const LatencyHistogram* h, LatencySummary* out) {
+    if (!out) return;
+    *out = (LatencySummary){0};
+    if (!h) return;
+    size_t* counts = (size_t*)malloc(sizeof(size_t) * LATENCY_HISTOGRAM_BUCKETS);
+    if (!counts) return;
+    latency_merge(h, counts);
+    latency_describe(counts, out);
+    free(counts);
+}
+
+uint64_t latency_histogram_percentile(const LatencyHistogram* h, double q) {
+    if (!h) return 0;
+    size_t* counts = (size_t*)malloc(sizeof(size_t) * LATENCY_HISTOGRAM_BUCKETS);
+    if (!counts) return 0;
+    latency_merge(h, counts);
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; ++i) total += counts[i];
+    uint64_t value = 0;
+    if (total) {
+        uint64_t rank = latency_rank(total, q), seen = 0;
+        for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                value = latency_bucket_highest(i);
+                break;
+            }
+        }
+    }
+    free(counts);
+    return value;
+}
+
+void latency_histogram_interval(LatencyHistogram* h, LatencySummary* out) {
+    if (!out) return;
+    *out = (LatencySummary){0};
+    if (!h) return;
+    if (!h->baseline) {
+        h->baseline = (size_t*)calloc(LATENCY_HISTOGRAM_BUCKETS, sizeof(size_t));
+        if (!h->baseline) return;
+    }
+    size_t* counts = (size_t*)malloc(sizeof(size_t) * LATENCY_HISTOGRAM_BUCKETS);
+    if (!counts) return;
+    latency_merge(h, counts);
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; ++i) {
+        size_t current = counts[i];
+        counts[i] = current - h->baseline[i];
+        h->baseline[i] = current;
+    }
+    latency_describe(counts, out);
+    free(counts);
+}
+
+void latency_histogram_cumulative(const LatencyHistogram* h, const uint64_t* bounds, size_t count,
+                                  uint64_t* below, uint64_t* total, double* sumNs) {
+    if (below) memset(below, 0, sizeof(uint64_t) * count);
+    uint64_t samples = 0;
+    double weighted = 0.0;
+    if (h) {
+        LatencyShard* shard = (LatencyShard*)(uintptr_t)atomic_load_size_acquire(&((LatencyHistogram*)h)->shards);
+        for (; shard; shard = shard->next) {
+            size_t bound = 0;
+            for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; ++i) {
+                size_t n = atomic_load_size_relaxed(&shard->counts[i]);
+                if (!n) continue;
+                uint64_t lowest = latency_bucket_lowest(i), highest = latency_bucket_highest(i);
+                while (bound < count && highest > bounds[bound]) bound++;
+                if (below && bound < count) below[bound] += n;
+                samples += n;
+                weighted += (double)n * ((double)lowest + (double)(highest - lowest) / 2.0);
+            }
+        }
+    }
+    for (size_t i = 1; below && i < count; ++i) below[i] += below[i - 1];
+    if (total) *total = samples;
+    if (sumNs) *sumNs = weighted;
+}
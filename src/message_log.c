@@ -0,0 +1,1195 @@
+#include "message_log.h"
+#include "checksum_engine.h"
+#include "umsbb_clock.h"
+#include "atomic_compat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#  include <dirent.h>
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <pthread.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <time.h>
+#  include <unistd.h>
+#  define MESSAGE_LOG_POSIX 1
+#endif
+#if defined(__APPLE__)
+#  define fdatasync fsync
+#endif
+
+#define MESSAGE_LOG_PATH_MAX 512
+#define MESSAGE_LOG_REPLAY_THREADS 64
+
+void message_log_default_config(message_log_config_t* config) {
+    if (!config) return;
+    config->segment_bytes = 64ull * 1024 * 1024;
+    config->sync_interval_ms = 10;
+    config->durability = MESSAGE_LOG_BATCHED;
+    config->direct_io = true;
+}
+
+#if defined(MESSAGE_LOG_POSIX)
+
+typedef struct {
+    uint64_t sequence;
+    uint64_t segment;
+    uint64_t offset;            // Record header within its segment
+    uint64_t end;               // Log position just past the record
+    uint32_t size;
+    uint32_t lane;
+} log_entry_t;
+
+typedef struct {
+    uint64_t offset;            // First record of the chunk
+    uint64_t min_sequence;
+    uint64_t max_sequence;
+} index_point_t;
+
+// Index file header, followed by `points` index points
+typedef struct {
+    uint32_t magic;
+    uint32_t points;
+    uint64_t length;            // The intact records end here
+    uint64_t records;
+    uint32_t stride;
+    uint32_t crc;               // Over the header and the points, as for records
+} index_header_t;
+
+// A segment's sparse index, built as its records are written or scanned
+typedef struct {
+    index_point_t* points;
+    uint32_t count;
+    uint32_t capacity;
+    uint64_t records;
+    uint64_t length;
+    bool failed;                // Out of memory: the segment stays unindexed
+} index_builder_t;
+
+// A segment found by message_log_open, mapped read-only
+typedef struct {
+    uint64_t number;
+    const char* map;
+    size_t map_length;
+    uint64_t length;            // The intact records end here
+    uint64_t records;
+    index_point_t* points;
+    uint64_t* before;           // Highest sequence in the chunks ahead of each point
+    uint32_t point_count;
+    uint64_t min_sequence;
+    uint64_t max_sequence;
+} sealed_segment_t;
+
+struct MessageLog {
+    char directory[MESSAGE_LOG_PATH_MAX];
+    message_log_config_t config;
+    uint8_t durability[MESSAGE_LOG_MAX_LANES];
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;        // Log thread: records staged, or stop
+    pthread_cond_t progress;    // Appenders and readers: staging drained, written or durable moved
+    pthread_t thread;
+    bool stop;
+    bool failed;
+    bool sync_wanted;           // A BATCHED or SYNC record is staged
+
+    // Serialised records not yet taken by the log thread
+    char* staged;
+    size_t staged_length;
+    size_t staged_capacity;
+    // Log positions: bytes of records appended since open, written and synced
+    uint64_t appended;
+    uint64_t written;
+    uint64_t durable;
+    uint64_t place_segment;     // Where the next appended record lands
+    uint64_t place_offset;
+
+    // Every record, with an open-addressed sequence -> entry map (entry + 1)
+    log_entry_t* entries;
+    size_t entry_count;
+    size_t entry_capacity;
+    uint32_t* slots;
+    size_t slot_count;
+
+    // Segments found by message_log_open, by number; fixed once open
+    sealed_segment_t* sealed;
+    size_t sealed_count;
+
+    // Log thread only
+    char* batch;
+    size_t batch_capacity;
+    int fd;
+    uint64_t segment;
+    bool direct;
+    char* io;                   // Aligned; holds [io_base, io_base + io_fill) of the segment
+    uint64_t io_base;
+    size_t io_fill;
+    uint64_t last_sync_ns;
+    uint64_t io_bytes;
+    uint64_t io_segments;
+    index_builder_t index;      // Of the segment being written
+
+    struct message_log_stats stats;     // Under lock
+};
+
+static inline size_t record_length(size_t size) {
+    return (sizeof(message_log_record_t) + size + MESSAGE_LOG_ALIGN - 1) & ~(size_t)(MESSAGE_LOG_ALIGN - 1);
+}
+
+// The header CRC covers the payload through its own CRC in the crc field,
+// so neither side needs the two contiguous
+static uint32_t record_crc(const message_log_record_t* header, const void* payload) {
+    message_log_record_t copy = *header;
+    copy.crc = checksum_crc32c(payload, header->size);
+    return checksum_crc32c(&copy, sizeof(copy));
+}
+
+// Both the appenders and the log thread roll segments by this one rule
+static void place_record(const MessageLog* log, uint64_t* segment, uint64_t* offset, size_t length) {
+    if (*offset > 0 && *offset + length > log->config.segment_bytes) {
+        (*segment)++;
+        *offset = 0;
+    }
+}
+
+static void segment_path(const MessageLog* log, uint64_t segment, char* path, size_t size) {
+    snprintf(path, size, "%s/%020llu.wal", log->directory, (unsigned long long)segment);
+}
+
+static void index_path(const MessageLog* log, uint64_t segment, char* path, size_t size) {
+    snprintf(path, size, "%s/%020llu.idx", log->directory, (unsigned long long)segment);
+}
+
+static void timed_wait(pthread_cond_t* cond, pthread_mutex_t* lock, uint64_t timeout_ns) {
+    struct timespec deadline;
+#if defined(__linux__)
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+#else
+    clock_gettime(CLOCK_REALTIME, &deadline);
+#endif
+    uint64_t ns = (uint64_t)deadline.tv_nsec + timeout_ns;
+    deadline.tv_sec += (time_t)(ns / 1000000000ull);
+    deadline.tv_nsec = (long)(ns % 1000000000ull);
+    pthread_cond_timedwait(cond, lock, &deadline);
+}
+
+// ---- Index ----------------------------------------------------------------
+
+static inline size_t slot_of(uint64_t sequence, size_t slot_count) {
+    return (size_t)((sequence * 0x9E3779B97F4A7C15ull) >> 32) & (slot_count - 1);
+}
+
+static bool index_grow(MessageLog* log) {
+    size_t count = log->slot_count ? log->slot_count * 2 : 1024;
+    uint32_t* slots = (uint32_t*)calloc(count, sizeof(uint32_t));
+    if (!slots) return false;
+    for (size_t i = 0; i < log->slot_count; i++) {
+        uint32_t entry = log->slots[i];
+        if (!entry) continue;
+        size_t slot = slot_of(log->entries[entry - 1].sequence, count);
+        while (slots[slot]) slot = (slot + 1) & (count - 1);
+        slots[slot] = entry;
+    }
+    free(log->slots);
+    log->slots = slots;
+    log->slot_count = count;
+    return true;
+}
+
+static const log_entry_t* index_find(const MessageLog* log, uint64_t sequence) {
+    if (!log->slot_count) return NULL;
+    for (size_t slot = slot_of(sequence, log->slot_count);; slot = (slot + 1) & (log->slot_count - 1)) {
+        uint32_t entry = log->slots[slot];
+        if (!entry) return NULL;
+        if (log->entries[entry - 1].sequence == sequence) return &log->entries[entry - 1];
+    }
+}
+
+static bool index_add(MessageLog* log, const log_entry_t* entry) {
+    if (log->entry_count == log->entry_capacity) {
+        size_t capacity = log->entry_capacity ? log->entry_capacity * 2 : 1024;
+        if (capacity > UINT32_MAX - 1) return false;
+        log_entry_t* entries = (log_entry_t*)realloc(log->entries, capacity * sizeof(log_entry_t));
+        if (!entries) return false;
+        log->entries = entries;
+        log->entry_capacity = capacity;
+    }
+    if ((log->entry_count + 1) * 2 > log->slot_count && !index_grow(log)) return false;
+
+    log->entries[log->entry_count++] = *entry;
+    size_t slot = slot_of(entry->sequence, log->slot_count);
+    for (;; slot = (slot + 1) & (log->slot_count - 1)) {
+        uint32_t existing = log->slots[slot];
+        // A sequence logged again points at its latest record
+        if (!existing || log->entries[existing - 1].sequence == entry->sequence) break;
+    }
+    log->slots[slot] = (uint32_t)log->entry_count;
+    return true;
+}
+
+// ---- Sparse segment index -------------------------------------------------
+
+static void builder_add(index_builder_t* builder, uint64_t offset, size_t length, uint64_t sequence) {
+    if (builder->failed) return;
+    index_point_t* point = builder->count ? &builder->points[builder->count - 1] : NULL;
+    if (!point || offset >= point->offset + MESSAGE_LOG_INDEX_STRIDE) {
+        if (builder->count == builder->capacity) {
+            uint32_t capacity = builder->capacity ? builder->capacity * 2 : 64;
+            index_point_t* points = (index_point_t*)realloc(builder->points, capacity * sizeof(index_point_t));
+            if (!points) {
+                builder->failed = true;
+                return;
+            }
+            builder->points = points;
+            builder->capacity = capacity;
+        }
+        point = &builder->points[builder->count++];
+        point->offset = offset;
+        point->min_sequence = sequence;
+        point->max_sequence = sequence;
+    } else {
+        if (sequence < point->min_sequence) point->min_sequence = sequence;
+        if (sequence > point->max_sequence) point->max_sequence = sequence;
+    }
+    builder->records++;
+    builder->length = offset + length;
+}
+
+static void builder_reset(index_builder_t* builder) {
+    free(builder->points);
+    memset(builder, 0, sizeof(*builder));
+}
+
+static uint32_t index_crc(const index_header_t* header, const index_point_t* points) {
+    index_header_t copy = *header;
+    copy.crc = header->points ? checksum_crc32c(points, header->points * sizeof(index_point_t)) : 0;
+    return checksum_crc32c(&copy, sizeof(copy));
+}
+
+// Written only once the segment's records are synced; an index lost in a
+// crash costs a rescan, never a record
+static bool index_write(const MessageLog* log, uint64_t segment, const index_builder_t* builder) {
+    if (builder->failed) return false;
+    char path[MESSAGE_LOG_PATH_MAX + 32];
+    char temporary[MESSAGE_LOG_PATH_MAX + 36];
+    index_path(log, segment, path, sizeof(path));
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+
+    index_header_t header = { MESSAGE_LOG_INDEX_MAGIC, builder->count, builder->length, builder->records,
+                              MESSAGE_LOG_INDEX_STRIDE, 0 };
+    header.crc = index_crc(&header, builder->points);
+    FILE* file = fopen(temporary, "wb");
+    if (!file) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (builder->count == 0 || fwrite(builder->points, sizeof(index_point_t), builder->count, file) == builder->count);
+    ok &= fclose(file) == 0;
+    // The rename swaps the whole index in at once
+    if (ok) ok = rename(temporary, path) == 0;
+    if (!ok) unlink(temporary);
+    return ok;
+}
+
+static bool index_load(const MessageLog* log, sealed_segment_t* segment) {
+    char path[MESSAGE_LOG_PATH_MAX + 32];
+    index_path(log, segment->number, path, sizeof(path));
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    index_header_t header;
+    index_point_t* points = NULL;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == MESSAGE_LOG_INDEX_MAGIC &&
+              header.length <= segment->map_length && header.points <= header.records &&
+              (header.points == 0) == (header.records == 0);
+    if (ok && header.points) {
+        points = (index_point_t*)malloc(header.points * sizeof(index_point_t));
+        ok = points && fread(points, sizeof(index_point_t), header.points, file) == header.points;
+    }
+    fclose(file);
+    if (!ok || index_crc(&header, points) != header.crc) {
+        free(points);
+        return false;
+    }
+    segment->length = header.length;
+    segment->records = header.records;
+    segment->points = points;
+    segment->point_count = header.points;
+    return true;
+}
+
+// The running maximum makes the index binary-searchable even when sequences
+// were logged out of order
+static bool sealed_prepare(sealed_segment_t* segment) {
+    segment->before = (uint64_t*)malloc(segment->point_count * sizeof(uint64_t));
+    if (!segment->before) return false;
+    uint64_t highest = 0, lowest = UINT64_MAX;
+    for (uint32_t i = 0; i < segment->point_count; i++) {
+        segment->before[i] = highest;
+        if (segment->points[i].max_sequence > highest) highest = segment->points[i].max_sequence;
+        if (segment->points[i].min_sequence < lowest) lowest = segment->points[i].min_sequence;
+    }
+    segment->min_sequence = lowest;
+    segment->max_sequence = highest;
+    return true;
+}
+
+// Last point whose chunks ahead hold only sequences below `from`
+static uint32_t sealed_seek(const sealed_segment_t* segment, uint64_t from) {
+    uint32_t low = 0, high = segment->point_count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (segment->before[middle] < from) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low ? low - 1 : 0;
+}
+
+typedef bool (*sealed_visit_fn)(void* context, const sealed_segment_t* segment, const message_log_record_t* header,
+                                uint64_t offset);
+
+// Visit the records with from <= sequence <= to, in log order; false if a
+// chunk visited is damaged or the visitor stops
+static bool sealed_scan(const sealed_segment_t* segment, uint64_t from, uint64_t to, sealed_visit_fn visit,
+                        void* context) {
+    if (to < segment->min_sequence || from > segment->max_sequence) return true;
+    for (uint32_t i = sealed_seek(segment, from); i < segment->point_count; i++) {
+        const index_point_t* point = &segment->points[i];
+        if (point->min_sequence > to || point->max_sequence < from) continue;
+        uint64_t end = i + 1 < segment->point_count ? segment->points[i + 1].offset : segment->length;
+        for (uint64_t p = point->offset; p < end;) {
+            const message_log_record_t* header = (const message_log_record_t*)(segment->map + p);
+            if (p + sizeof(*header) > segment->length || header->magic != MESSAGE_LOG_MAGIC ||
+                header->size > MESSAGE_LOG_MAX_RECORD || p + record_length(header->size) > segment->length) {
+                return false;
+            }
+            if (header->sequence >= from && header->sequence <= to && !visit(context, segment, header, p)) return false;
+            p += record_length(header->size);
+        }
+    }
+    return true;
+}
+
+static void sealed_release(MessageLog* log) {
+    for (size_t i = 0; i < log->sealed_count; i++) {
+        munmap((void*)log->sealed[i].map, log->sealed[i].map_length);
+        free(log->sealed[i].points);
+        free(log->sealed[i].before);
+    }
+    free(log->sealed);
+    log->sealed = NULL;
+    log->sealed_count = 0;
+}
+
+// ---- Writing (log thread) -------------------------------------------------
+
+static bool sync_directory(const MessageLog* log) {
+    int fd = open(log->directory, O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+static bool segment_open(MessageLog* log, uint64_t segment) {
+    char path[MESSAGE_LOG_PATH_MAX + 32];
+    segment_path(log, segment, path, sizeof(path));
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    log->fd = -1;
+    log->direct = false;
+#if defined(O_DIRECT)
+    if (log->config.direct_io) {
+        log->fd = open(path, flags | O_DIRECT, 0644);
+        log->direct = log->fd >= 0;
+    }
+#endif
+    if (log->fd < 0) log->fd = open(path, flags, 0644);
+    if (log->fd < 0) return false;
+    log->segment = segment;
+    log->io_base = 0;
+    log->io_fill = 0;
+    log->io_segments++;
+    // The new file's name must survive a crash along with its records
+    return sync_directory(log);
+}
+
+static bool io_write(MessageLog* log, size_t length) {
+    for (size_t done = 0; done < length;) {
+        ssize_t n = pwrite(log->fd, log->io + done, length - done, (off_t)(log->io_base + done));
+        if (n < 0 && errno == EINTR) continue;
+#if defined(O_DIRECT)
+        if (n < 0 && errno == EINVAL && log->direct) {
+            // Opened with O_DIRECT but the filesystem refuses it: go buffered
+            int flags = fcntl(log->fd, F_GETFL);
+            if (flags < 0 || fcntl(log->fd, F_SETFL, flags & ~O_DIRECT) < 0) return false;
+            log->direct = false;
+            continue;
+        }
+#endif
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    log->io_bytes += length;
+    return true;
+}
+
+// Write the buffer out in whole blocks, zero-padding the last; the partial
+// block stays buffered and is written again, extended, by the next commit
+static bool io_commit(MessageLog* log) {
+    size_t padded = (log->io_fill + MESSAGE_LOG_BLOCK - 1) & ~(size_t)(MESSAGE_LOG_BLOCK - 1);
+    if (padded == 0) return true;
+    memset(log->io + log->io_fill, 0, padded - log->io_fill);
+    if (!io_write(log, padded)) return false;
+    size_t full = log->io_fill & ~(size_t)(MESSAGE_LOG_BLOCK - 1);
+    memmove(log->io, log->io + full, log->io_fill - full);
+    log->io_base += full;
+    log->io_fill -= full;
+    return true;
+}
+
+static bool segment_roll(MessageLog* log) {
+    bool ok = io_commit(log) && fdatasync(log->fd) == 0;
+    close(log->fd);
+    if (ok) index_write(log, log->segment, &log->index);
+    builder_reset(&log->index);
+    return ok && segment_open(log, log->segment + 1);
+}
+
+static bool write_batch(MessageLog* log, const char* batch, size_t length) {
+    for (size_t p = 0; p < length;) {
+        const message_log_record_t* header = (const message_log_record_t*)(batch + p);
+        size_t size = record_length(header->size);
+        uint64_t segment = log->segment;
+        uint64_t offset = log->io_base + log->io_fill;
+        place_record(log, &segment, &offset, size);
+        if (segment != log->segment && !segment_roll(log)) return false;
+        if (log->io_fill + size > MESSAGE_LOG_IO_BUFFER && !io_commit(log)) return false;
+        builder_add(&log->index, log->io_base + log->io_fill, size, header->sequence);
+        memcpy(log->io + log->io_fill, batch + p, size);
+        log->io_fill += size;
+        p += size;
+    }
+    return io_commit(log);
+}
+
+static void* log_main(void* arg) {
+    MessageLog* log = (MessageLog*)arg;
+    uint64_t interval_ns = (uint64_t)log->config.sync_interval_ms * 1000000ull;
+
+    pthread_mutex_lock(&log->lock);
+    for (;;) {
+        while (!log->stop && log->staged_length == 0) {
+            if (log->written == log->durable) {
+                pthread_cond_wait(&log->work, &log->lock);
+                continue;
+            }
+            // Only ASYNC records are unsynced here: wait out their interval
+            uint64_t waited = umsbb_clock_ns() - log->last_sync_ns;
+            if (waited >= interval_ns) break;
+            timed_wait(&log->work, &log->lock, interval_ns - waited);
+        }
+        if (log->failed || (log->stop && log->staged_length == 0 && log->written == log->durable)) break;
+
+        // Swap buffers: appenders refill the other one while this batch is written
+        char* batch = log->staged;
+        size_t length = log->staged_length;
+        log->staged = log->batch;
+        log->batch = batch;
+        size_t capacity = log->staged_capacity;
+        log->staged_capacity = log->batch_capacity;
+        log->batch_capacity = capacity;
+        log->staged_length = 0;
+        uint64_t end = log->appended;
+        bool sync = log->sync_wanted || log->stop;
+        log->sync_wanted = false;
+        pthread_cond_broadcast(&log->progress);
+        pthread_mutex_unlock(&log->lock);
+
+        bool ok = write_batch(log, batch, length);
+        uint64_t now = umsbb_clock_ns();
+        sync |= now - log->last_sync_ns >= interval_ns;
+        if (ok && sync) {
+            ok = fdatasync(log->fd) == 0;
+            log->last_sync_ns = now;
+        }
+
+        pthread_mutex_lock(&log->lock);
+        log->failed |= !ok;
+        log->written = end;
+        if (ok && sync) {
+            log->durable = end;
+            log->stats.syncs++;
+        }
+        log->stats.batches += length > 0;
+        log->stats.bytes_written = log->io_bytes;
+        log->stats.segments = log->io_segments;
+        log->stats.direct_io = log->direct;
+        log->stats.failed = log->failed;
+        pthread_cond_broadcast(&log->progress);
+    }
+    pthread_cond_broadcast(&log->progress);
+    pthread_mutex_unlock(&log->lock);
+    return NULL;
+}
+
+// ---- Recovery -------------------------------------------------------------
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Index a segment that has no index: its records up to the first that
+// fails its CRC. Everything past that point is invalid and stays unindexed
+static bool scan_segment(MessageLog* log, sealed_segment_t* segment) {
+    index_builder_t builder = { 0 };
+    const char* data = segment->map;
+    size_t size = segment->map_length;
+    madvise((void*)data, size, MADV_SEQUENTIAL);
+    size_t p = 0;
+    while (p + sizeof(message_log_record_t) <= size) {
+        const message_log_record_t* header = (const message_log_record_t*)(data + p);
+        if (header->magic != MESSAGE_LOG_MAGIC || header->size > MESSAGE_LOG_MAX_RECORD) break;
+        size_t length = record_length(header->size);
+        if (p + length > size || record_crc(header, header + 1) != header->crc) break; // Torn tail
+        builder_add(&builder, p, length, header->sequence);
+        p += length;
+    }
+    if (builder.failed) {
+        builder_reset(&builder);
+        return false;
+    }
+    // A clean tail is only block padding
+    for (size_t q = p; q < size; q++) {
+        if (data[q]) {
+            log->stats.torn_segments++;
+            break;
+        }
+    }
+    index_write(log, segment->number, &builder);
+    segment->length = builder.length;
+    segment->records = builder.records;
+    segment->points = builder.points;
+    segment->point_count = builder.count;
+    return true;
+}
+
+static bool recover_segment(MessageLog* log, uint64_t number) {
+    char path[MESSAGE_LOG_PATH_MAX + 32];
+    segment_path(log, number, path, sizeof(path));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    sealed_segment_t segment = { .number = number, .map_length = (size_t)info.st_size };
+    if (segment.map_length == 0) {
+        close(fd); // Opened but never written
+        return true;
+    }
+    void* map = mmap(NULL, segment.map_length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+    segment.map = (const char*)map;
+
+    bool ok = true;
+    if (index_load(log, &segment)) {
+        log->stats.segments_indexed++;
+    } else {
+        ok = scan_segment(log, &segment);
+    }
+    if (ok && segment.records > 0) {
+        sealed_segment_t* sealed = (sealed_segment_t*)realloc(log->sealed, (log->sealed_count + 1) * sizeof(sealed_segment_t));
+        ok = sealed && sealed_prepare(&segment);
+        if (sealed) log->sealed = sealed;
+        if (ok) {
+            madvise(map, segment.map_length, MADV_RANDOM);
+            log->sealed[log->sealed_count++] = segment;
+            log->stats.records_recovered += segment.records;
+            return true;
+        }
+    }
+    munmap(map, segment.map_length);
+    free(segment.points);
+    free(segment.before);
+    return ok;
+}
+
+static bool recover(MessageLog* log) {
+    DIR* dir = opendir(log->directory);
+    if (!dir) return false;
+    uint64_t* segments = NULL;
+    size_t count = 0, capacity = 0;
+    struct dirent* item;
+    while ((item = readdir(dir))) {
+        unsigned long long number;
+        char tail;
+        if (strlen(item->d_name) != 24 || sscanf(item->d_name, "%llu.wa%c", &number, &tail) != 2 || tail != 'l') continue;
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            uint64_t* grown = (uint64_t*)realloc(segments, capacity * sizeof(uint64_t));
+            if (!grown) break;
+            segments = grown;
+        }
+        segments[count++] = number;
+    }
+    closedir(dir);
+
+    if (count) qsort(segments, count, sizeof(uint64_t), compare_u64);
+    bool ok = true;
+    for (size_t i = 0; i < count && ok; i++) ok = recover_segment(log, segments[i]);
+    log->place_segment = count ? segments[count - 1] + 1 : 1;
+    free(segments);
+    return ok;
+}
+
+// ---- Public API -----------------------------------------------------------
+
+MessageLog* message_log_open(const char* directory, const message_log_config_t* config) {
+    if (!directory || strlen(directory) >= MESSAGE_LOG_PATH_MAX) return NULL;
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) return NULL;
+
+    MessageLog* log = (MessageLog*)calloc(1, sizeof(MessageLog));
+    if (!log) return NULL;
+    strcpy(log->directory, directory);
+    if (config) {
+        log->config = *config;
+    } else {
+        message_log_default_config(&log->config);
+    }
+    if (log->config.segment_bytes == 0) log->config.segment_bytes = 64ull * 1024 * 1024;
+    memset(log->durability, log->config.durability, sizeof(log->durability));
+    log->fd = -1;
+
+    if (posix_memalign((void**)&log->io, MESSAGE_LOG_BLOCK, MESSAGE_LOG_IO_BUFFER) != 0) {
+        free(log);
+        return NULL;
+    }
+    if (!recover(log) || !segment_open(log, log->place_segment)) {
+        if (log->fd >= 0) close(log->fd);
+        free(log->entries);
+        free(log->slots);
+        free(log->io);
+        sealed_release(log);
+        free(log);
+        return NULL;
+    }
+    log->last_sync_ns = umsbb_clock_ns();
+    log->stats.segments = log->io_segments;
+    log->stats.direct_io = log->direct;
+
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+#if defined(__linux__)
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+#endif
+    pthread_cond_init(&log->work, &attributes);
+    pthread_condattr_destroy(&attributes);
+    pthread_cond_init(&log->progress, NULL);
+    if (pthread_create(&log->thread, NULL, log_main, log) != 0) {
+        pthread_cond_destroy(&log->work);
+        pthread_cond_destroy(&log->progress);
+        pthread_mutex_destroy(&log->lock);
+        close(log->fd);
+        free(log->entries);
+        free(log->slots);
+        free(log->io);
+        sealed_release(log);
+        free(log);
+        return NULL;
+    }
+    return log;
+}
+
+void message_log_close(MessageLog* log) {
+    if (!log) return;
+
+    pthread_mutex_lock(&log->lock);
+    log->stop = true;
+    pthread_cond_signal(&log->work);
+    pthread_mutex_unlock(&log->lock);
+    pthread_join(log->thread, NULL);
+
+    // Everything is synced: index the last segment so the next open need not scan it
+    close(log->fd);
+    if (!log->failed) index_write(log, log->segment, &log->index);
+    builder_reset(&log->index);
+    pthread_cond_destroy(&log->work);
+    pthread_cond_destroy(&log->progress);
+    pthread_mutex_destroy(&log->lock);
+    free(log->staged);
+    free(log->batch);
+    free(log->entries);
+    free(log->slots);
+    free(log->io);
+    sealed_release(log);
+    free(log);
+}
+
+void message_log_set_lane_durability(MessageLog* log, uint32_t lane, message_log_durability_t durability) {
+    if (!log || lane >= MESSAGE_LOG_MAX_LANES) return;
+    pthread_mutex_lock(&log->lock);
+    log->durability[lane] = (uint8_t)durability;
+    pthread_mutex_unlock(&log->lock);
+}
+
+uint64_t message_log_append(MessageLog* log, uint32_t lane, uint64_t sequence, const void* data, size_t size) {
+    if (!log || (!data && size) || size > MESSAGE_LOG_MAX_RECORD) return 0;
+
+    message_log_record_t header = { MESSAGE_LOG_MAGIC, (uint32_t)size, sequence, lane, 0 };
+    header.crc = record_crc(&header, data);
+    size_t length = record_length(size);
+
+    pthread_mutex_lock(&log->lock);
+    // Backpressure: the log thread is this far behind
+    while (!log->failed && log->staged_length > 0 && log->staged_length + length > MESSAGE_LOG_MAX_PENDING) {
+        pthread_cond_wait(&log->progress, &log->lock);
+    }
+    if (log->failed) {
+        pthread_mutex_unlock(&log->lock);
+        return 0;
+    }
+    if (log->staged_length + length > log->staged_capacity) {
+        size_t capacity = log->staged_capacity ? log->staged_capacity : 64 * 1024;
+        while (capacity < log->staged_length + length) capacity *= 2;
+        char* staged = (char*)realloc(log->staged, capacity);
+        if (!staged) {
+            pthread_mutex_unlock(&log->lock);
+            return 0;
+        }
+        log->staged = staged;
+        log->staged_capacity = capacity;
+    }
+
+    place_record(log, &log->place_segment, &log->place_offset, length);
+    log_entry_t entry = { sequence, log->place_segment, log->place_offset, log->appended + length,
+                          (uint32_t)size, lane };
+    if (!index_add(log, &entry)) {
+        pthread_mutex_unlock(&log->lock);
+        return 0;
+    }
+    char* record = log->staged + log->staged_length;
+    memcpy(record, &header, sizeof(header));
+    if (size) memcpy(record + sizeof(header), data, size);
+    memset(record + sizeof(header) + size, 0, length - sizeof(header) - size);
+
+    bool wake = log->staged_length == 0;
+    log->staged_length += length;
+    log->place_offset += length;
+    log->appended += length;
+    log->stats.records_appended++;
+    uint64_t position = log->appended;
+
+    message_log_durability_t durability = lane < MESSAGE_LOG_MAX_LANES
+        ? (message_log_durability_t)log->durability[lane] : log->config.durability;
+    if (durability != MESSAGE_LOG_ASYNC && !log->sync_wanted) {
+        log->sync_wanted = true;
+        wake = true;
+    }
+    if (wake) pthread_cond_signal(&log->work);
+    if (durability == MESSAGE_LOG_SYNC) {
+        while (!log->failed && log->durable < position) pthread_cond_wait(&log->progress, &log->lock);
+        if (log->failed) position = 0;
+    }
+    pthread_mutex_unlock(&log->lock);
+    return position;
+}
+
+bool message_log_wait_durable(MessageLog* log, uint64_t position) {
+    if (!log) return false;
+
+    pthread_mutex_lock(&log->lock);
+    if (log->durable < position && !log->sync_wanted) {
+        log->sync_wanted = true;
+        pthread_cond_signal(&log->work);
+    }
+    while (!log->failed && log->durable < position) pthread_cond_wait(&log->progress, &log->lock);
+    bool ok = log->durable >= position;
+    pthread_mutex_unlock(&log->lock);
+    return ok;
+}
+
+bool message_log_flush(MessageLog* log) {
+    if (!log) return false;
+
+    pthread_mutex_lock(&log->lock);
+    uint64_t position = log->appended;
+    pthread_mutex_unlock(&log->lock);
+    return message_log_wait_durable(log, position);
+}
+
+// Read one record through `fd`, opened on `segment` (-1 to open it); true
+// and a malloc'd payload if it is intact
+static bool read_record(MessageLog* log, const log_entry_t* entry, int* fd, uint64_t* fd_segment, void** payload) {
+    if (*fd < 0 || *fd_segment != entry->segment) {
+        if (*fd >= 0) close(*fd);
+        char path[MESSAGE_LOG_PATH_MAX + 32];
+        segment_path(log, entry->segment, path, sizeof(path));
+        *fd = open(path, O_RDONLY);
+        *fd_segment = entry->segment;
+        if (*fd < 0) return false;
+    }
+    message_log_record_t header;
+    char* data = (char*)malloc(entry->size ? entry->size : 1);
+    if (!data) return false;
+    bool ok = pread(*fd, &header, sizeof(header), (off_t)entry->offset) == (ssize_t)sizeof(header) &&
+              header.magic == MESSAGE_LOG_MAGIC && header.size == entry->size &&
+              pread(*fd, data, entry->size, (off_t)(entry->offset + sizeof(header))) == (ssize_t)entry->size &&
+              record_crc(&header, data) == header.crc;
+    if (!ok) {
+        free(data);
+        return false;
+    }
+    *payload = data;
+    return true;
+}
+
+// Records are read from their segment files: wait until `position` is written
+static void wait_written(MessageLog* log, uint64_t position) {
+    while (!log->failed && log->written < position) pthread_cond_wait(&log->progress, &log->lock);
+}
+
+static bool keep_latest(void* context, const sealed_segment_t* segment, const message_log_record_t* header,
+                        uint64_t offset) {
+    (void)segment;
+    (void)offset;
+    *(const message_log_record_t**)context = header;
+    return true;
+}
+
+void* message_log_read(MessageLog* log, uint64_t sequence, size_t* size, uint32_t* lane) {
+    if (!log) return NULL;
+
+    pthread_mutex_lock(&log->lock);
+    const log_entry_t* found = index_find(log, sequence);
+    log_entry_t entry;
+    if (found) {
+        entry = *found;
+        wait_written(log, entry.end);
+    }
+    bool readable = found && log->written >= entry.end;
+    pthread_mutex_unlock(&log->lock);
+
+    if (!found) {
+        // Not appended since open: the newest mapped segment holding it
+        for (size_t i = log->sealed_count; i-- > 0;) {
+            const message_log_record_t* header = NULL;
+            sealed_scan(&log->sealed[i], sequence, sequence, keep_latest, &header);
+            if (!header) continue;
+            if (record_crc(header, header + 1) != header->crc) return NULL;
+            void* payload = malloc(header->size ? header->size : 1);
+            if (!payload) return NULL;
+            memcpy(payload, header + 1, header->size);
+            if (size) *size = header->size;
+            if (lane) *lane = header->lane;
+            return payload;
+        }
+        return NULL;
+    }
+    if (!readable) return NULL;
+
+    int fd = -1;
+    uint64_t fd_segment = 0;
+    void* payload = NULL;
+    bool ok = read_record(log, &entry, &fd, &fd_segment, &payload);
+    if (fd >= 0) close(fd);
+    if (!ok) return NULL;
+    if (size) *size = entry.size;
+    if (lane) *lane = entry.lane;
+    return payload;
+}
+
+// ---- Replay ---------------------------------------------------------------
+
+typedef struct {
+    log_entry_t entry;
+    const sealed_segment_t* sealed;     // NULL: appended since open, read from its file
+} replay_item_t;
+
+typedef struct {
+    replay_item_t* items;
+    size_t count;
+    size_t capacity;
+} replay_list_t;
+
+static bool replay_push(replay_list_t* list, const replay_item_t* item) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 256;
+        replay_item_t* items = (replay_item_t*)realloc(list->items, capacity * sizeof(replay_item_t));
+        if (!items) return false;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = *item;
+    return true;
+}
+
+static bool collect_sealed(void* context, const sealed_segment_t* segment, const message_log_record_t* header,
+                           uint64_t offset) {
+    replay_item_t item = { { header->sequence, segment->number, offset, 0, header->size, header->lane }, segment };
+    return replay_push((replay_list_t*)context, &item);
+}
+
+static int compare_log_order(const replay_item_t* a, const replay_item_t* b) {
+    if (a->entry.segment != b->entry.segment) return a->entry.segment < b->entry.segment ? -1 : 1;
+    return a->entry.offset < b->entry.offset ? -1 : a->entry.offset > b->entry.offset;
+}
+
+static int compare_position(const void* a, const void* b) {
+    return compare_log_order((const replay_item_t*)a, (const replay_item_t*)b);
+}
+
+static int compare_sequence(const void* a, const void* b) {
+    const replay_item_t* x = (const replay_item_t*)a;
+    const replay_item_t* y = (const replay_item_t*)b;
+    if (x->entry.sequence != y->entry.sequence) return x->entry.sequence < y->entry.sequence ? -1 : 1;
+    return compare_log_order(x, y);
+}
+
+static int compare_lane(const void* a, const void* b) {
+    const replay_item_t* x = (const replay_item_t*)a;
+    const replay_item_t* y = (const replay_item_t*)b;
+    if (x->entry.lane != y->entry.lane) return x->entry.lane < y->entry.lane ? -1 : 1;
+    return compare_log_order(x, y);
+}
+
+// Snapshot the latest record of each sequence in [from, to], in log order;
+// *intact is false if part of the range could not be collected
+static replay_item_t* replay_collect(MessageLog* log, uint64_t from, uint64_t to, size_t* count, bool* intact) {
+    replay_list_t list = { NULL, 0, 0 };
+    bool ok = true;
+    for (size_t i = 0; ok && i < log->sealed_count; i++) {
+        ok = sealed_scan(&log->sealed[i], from, to, collect_sealed, &list);
+    }
+
+    // Later appends are not replayed
+    pthread_mutex_lock(&log->lock);
+    uint64_t last = 0;
+    for (size_t i = 0; ok && i < log->entry_count; i++) {
+        const log_entry_t* entry = &log->entries[i];
+        if (entry->sequence < from || entry->sequence > to) continue;
+        replay_item_t item = { *entry, NULL };
+        ok = replay_push(&list, &item);
+        last = entry->end;
+    }
+    wait_written(log, last);
+    ok = ok && log->written >= last;
+    pthread_mutex_unlock(&log->lock);
+
+    if (list.count > 1) {
+        qsort(list.items, list.count, sizeof(replay_item_t), compare_sequence);
+        size_t kept = 0;
+        for (size_t i = 0; i < list.count; i++) {
+            // A sequence logged again replays its latest record
+            if (i + 1 < list.count && list.items[i + 1].entry.sequence == list.items[i].entry.sequence) continue;
+            list.items[kept++] = list.items[i];
+        }
+        list.count = kept;
+        qsort(list.items, list.count, sizeof(replay_item_t), compare_position);
+    }
+    *count = list.count;
+    *intact = ok;
+    return list.items;
+}
+
+typedef struct {
+    int fd;
+    uint64_t segment;
+} replay_reader_t;
+
+// Mapped records go to the callback in place; others are read from their file
+static bool replay_deliver(MessageLog* log, const replay_item_t* item, replay_reader_t* reader,
+                           message_log_replay_fn callback, void* context) {
+    if (item->sealed) {
+        const message_log_record_t* header = (const message_log_record_t*)(item->sealed->map + item->entry.offset);
+        if (record_crc(header, header + 1) != header->crc) return false;
+        callback(context, header->lane, header->sequence, header + 1, header->size);
+        return true;
+    }
+    void* payload = NULL;
+    if (!read_record(log, &item->entry, &reader->fd, &reader->segment, &payload)) return false;
+    callback(context, item->entry.lane, item->entry.sequence, payload, item->entry.size);
+    free(payload);
+    return true;
+}
+
+bool message_log_replay(MessageLog* log, uint64_t from, uint64_t to, message_log_replay_fn callback, void* context,
+                        uint64_t* delivered) {
+    if (delivered) *delivered = 0;
+    if (!log || !callback || from > to) return false;
+
+    size_t count = 0;
+    bool intact = true;
+    replay_item_t* items = replay_collect(log, from, to, &count, &intact);
+    replay_reader_t reader = { -1, 0 };
+    size_t i = 0;
+    for (; i < count && replay_deliver(log, &items[i], &reader, callback, context); i++) {
+        if (delivered) (*delivered)++;
+    }
+    if (reader.fd >= 0) close(reader.fd);
+    free(items);
+    return intact && i == count;
+}
+
+typedef struct {
+    MessageLog* log;
+    const replay_item_t* items;
+    const size_t* runs;             // First item of each lane; runs[run_count] is the item count
+    size_t run_count;
+    message_log_replay_fn callback;
+    void* context;
+    atomic_uint64_t next_run;
+    atomic_uint64_t delivered;
+    atomic_uint64_t stopped;        // Lanes cut short by a record that failed to read
+} replay_job_t;
+
+static void* replay_worker(void* arg) {
+    replay_job_t* job = (replay_job_t*)arg;
+    replay_reader_t reader = { -1, 0 };
+    for (;;) {
+        uint64_t run = atomic_fetch_add(&job->next_run, 1);
+        if (run >= job->run_count) break;
+        size_t first = job->runs[run], end = job->runs[run + 1];
+        size_t i = first;
+        while (i < end && replay_deliver(job->log, &job->items[i], &reader, job->callback, job->context)) i++;
+        atomic_fetch_add(&job->delivered, i - first);
+        if (i < end) atomic_fetch_add(&job->stopped, 1);
+    }
+    if (reader.fd >= 0) close(reader.fd);
+    return NULL;
+}
+
+bool message_log_replay_parallel(MessageLog* log, uint64_t from, uint64_t to, message_log_replay_fn callback,
+                                 void* context, uint32_t threads, uint64_t* delivered) {
+    if (delivered) *delivered = 0;
+    if (!log || !callback || from > to) return false;
+
+    size_t count = 0;
+    bool intact = true;
+    replay_item_t* items = replay_collect(log, from, to, &count, &intact);
+    if (count == 0) {
+        free(items);
+        return intact;
+    }
+
+    // One run per lane, each in log order
+    qsort(items, count, sizeof(replay_item_t), compare_lane);
+    size_t* runs = (size_t*)malloc((count + 1) * sizeof(size_t));
+    if (!runs) {
+        free(items);
+        return false;
+    }
+    size_t run_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (i == 0 || items[i].entry.lane != items[i - 1].entry.lane) runs[run_count++] = i;
+    }
+    runs[run_count] = count;
+
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (uint32_t)cpus : 1;
+    }
+    if (threads > MESSAGE_LOG_REPLAY_THREADS) threads = MESSAGE_LOG_REPLAY_THREADS;
+    if (threads > run_count) threads = (uint32_t)run_count;
+
+    replay_job_t job;
+    job.log = log;
+    job.items = items;
+    job.runs = runs;
+    job.run_count = run_count;
+    job.callback = callback;
+    job.context = context;
+    atomic_store(&job.next_run, 0);
+    atomic_store(&job.delivered, 0);
+    atomic_store(&job.stopped, 0);
+
+    // The caller is one of the workers
+    pthread_t workers[MESSAGE_LOG_REPLAY_THREADS];
+    uint32_t started = 0;
+    while (started + 1 < threads && pthread_create(&workers[started], NULL, replay_worker, &job) == 0) started++;
+    replay_worker(&job);
+    for (uint32_t i = 0; i < started; i++) pthread_join(workers[i], NULL);
+
+    if (delivered) *delivered = atomic_load(&job.delivered);
+    bool complete = atomic_load(&job.stopped) == 0;
+    free(runs);
+    free(items);
+    return intact && complete;
+}
+
+void message_log_get_stats(MessageLog* log, struct message_log_stats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!log) return;
+
+    pthread_mutex_lock(&log->lock);
+    *stats = log->stats;
+    pthread_mutex_unlock(&log->lock);
+}
+
+#else
+
+MessageLog* message_log_open(const char* directory, const message_log_config_t* config) {
+    (void)directory;
+    (void)config;
+    return NULL;
+}
+
+void message_log_close(MessageLog* log) { (void)log; }
+
+void message_log_set_lane_durability(MessageLog* log, uint32_t lane, message_log_durability_t durability) {
+    (void)log;
+    (void)lane;
+    (void)durability;
+}
+
+uint64_t message_log_append(MessageLog* log, uint32_t lane, uint64_t sequence, const void* data, size_t size) {
+    (void)log;
+    (void)lane;
+    (void)sequence;
+    (void)data;
+    (void)size;
+    return 0;
+}
+
+bool message_log_wait_durable(MessageLog* log, uint64_t position) { (void)log; (void)position; return false; }
+bool message_log_flush(MessageLog* log) { (void)log; return false; }
+
+void* message_log_read(MessageLog* log, uint64_t sequence, size_t* size, uint32_t* lane) {
+    (void)log;
+    (void)sequence;
+    (void)size;
+    (void)lane;
+    return NULL;
+}
+
+bool message_log_replay(MessageLog* log, uint64_t from, uint64_t to, message_log_replay_fn callback, void* context,
+                        uint64_t* delivered) {
+    (void)log;
+    (void)from;
+    (void)to;
+    (void)callback;
+    (void)context;
+    if (delivered) *delivered = 0;
+    return false;
+}
+
+bool message_log_replay_parallel(MessageLog* log, uint64_t from, uint64_t to, message_log_replay_fn callback,
+                                 void* context, uint32_t threads, uint64_t* delivered) {
+    (void)threads;
+    return message_log_replay(log, from, to, callback, context, delivered);
+}
+
+void message_log_get_stats(MessageLog* log, struct message_log_stats* stats) {
+    (void)log;
+    if (stats) memset(stats, 0, sizeof(*stats));
+}
+
+#endif
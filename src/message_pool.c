@@ -0,0 +1,234 @@
+#include "message_pool.h"
+#include "bi_buffer.h"
+#include "portable_atomic.h"
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#  define message_pool_yield() SwitchToThread()
+#else
+#  include <pthread.h>
+#  include <sched.h>
+#  define message_pool_yield() sched_yield()
+#endif
+
+#define MESSAGE_POOL_LARGE UINT32_MAX
+#define MESSAGE_POOL_SPINS 64
+
+/* Stored just before every block so release needs no lookup. */
+typedef struct {
+    uint32_t sizeClass;     // MESSAGE_POOL_LARGE for malloc fall-through
+    size_t capacity;
+} MessagePoolHeader;
+
+#define MESSAGE_POOL_HEADER_SIZE \
+    ((sizeof(MessagePoolHeader) + MESSAGE_POOL_ALIGNMENT - 1) & ~(size_t)(MESSAGE_POOL_ALIGNMENT - 1))
+
+/* Free blocks are linked through their (unused) payload. */
+typedef struct MessagePoolNode {
+    struct MessagePoolNode* next;       // Next block in the same batch
+    struct MessagePoolNode* batchNext;  // Next batch in the depot (batch heads only)
+    size_t count;                       // Blocks in this batch (batch heads only)
+} MessagePoolNode;
+
+typedef struct {
+    MessagePoolNode* head;
+    size_t count;
+} MessagePoolBin;
+
+typedef struct {
+    atomic_size_t lock;
+    atomic_size_t batchCount;   // Readable without the lock
+    MessagePoolNode* batches;
+    uint8_t pad[SOMA_ALIGNMENT - 2 * sizeof(atomic_size_t) - sizeof(MessagePoolNode*)];
+} MessagePoolDepot;
+
+static MessagePoolDepot message_pool_depots[MESSAGE_POOL_CLASS_COUNT];
+static atomic_size_t message_pool_heap_count;
+static SOMA_THREAD_LOCAL MessagePoolBin message_pool_bins[MESSAGE_POOL_CLASS_COUNT];
+static SOMA_THREAD_LOCAL bool message_pool_registered;
+
+/* Thread exit hands the bins back to the depot: a pthread key (fiber local
+ * storage on Windows) whose destructor flushes, set on a thread's first use
+ * of its bins. Destructors of other keys may still allocate after it has run;
+ * their use sets the key again and the flush repeats. */
+#if defined(_WIN32)
+static DWORD message_pool_key = FLS_OUT_OF_INDEXES;
+static INIT_ONCE message_pool_key_once = INIT_ONCE_STATIC_INIT;
+
+static VOID NTAPI message_pool_thread_exit(PVOID value) {
+    (void)value;
+    message_pool_registered = false;
+    message_pool_thread_flush();
+}
+
+static BOOL CALLBACK message_pool_key_init(PINIT_ONCE once, PVOID param, PVOID* context) {
+    (void)once; (void)param; (void)context;
+    message_pool_key = FlsAlloc(message_pool_thread_exit);
+    return TRUE;
+}
+
+static void message_pool_register(void) {
+    InitOnceExecuteOnce(&message_pool_key_once, message_pool_key_init, NULL, NULL);
+    if (message_pool_key == FLS_OUT_OF_INDEXES) return;
+    message_pool_registered = FlsSetValue(message_pool_key, (PVOID)1) != 0;
+}
+#else
+static pthread_key_t message_pool_key;
+static pthread_once_t message_pool_key_once = PTHREAD_ONCE_INIT;
+static bool message_pool_key_ready;
+
+static void message_pool_thread_exit(void* value) {
+    (void)value;
+    message_pool_registered = false;
+    message_pool_thread_flush();
+}
+
+static void message_pool_key_init(void) {
+    message_pool_key_ready = pthread_key_create(&message_pool_key, message_pool_thread_exit) == 0;
+}
+
+static void message_pool_register(void) {
+    pthread_once(&message_pool_key_once, message_pool_key_init);
+    if (!message_pool_key_ready) return;
+    message_pool_registered = pthread_setspecific(message_pool_key, (void*)1) == 0;
+}
+#endif
+
+static inline MessagePoolBin* message_pool_bin(int cls) {
+    if (!message_pool_registered) message_pool_register();
+    return &message_pool_bins[cls];
+}
+
+static inline MessagePoolHeader* message_pool_header(const void* ptr) {
+    return (MessagePoolHeader*)((uint8_t*)ptr - MESSAGE_POOL_HEADER_SIZE);
+}
+
+static inline int message_pool_class_of(size_t size) {
+    if (size > MESSAGE_POOL_MAX_SIZE) return -1;
+    int cls = 0;
+    size_t classSize = MESSAGE_POOL_MIN_SIZE;
+    while (classSize < size) {
+        classSize <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
+static void message_pool_lock(MessagePoolDepot* depot) {
+    unsigned spins = 0;
+    for (;;) {
+        size_t expected = 0;
+        if (atomic_load_size_relaxed(&depot->lock) == 0 && atomic_cas_size(&depot->lock, &expected, 1)) return;
+        // The critical section is a few pointer moves; only a preempted holder takes longer
+        if (++spins >= MESSAGE_POOL_SPINS) {
+            message_pool_yield();
+            spins = 0;
+        }
+    }
+}
+
+static inline void message_pool_unlock(MessagePoolDepot* depot) {
+    atomic_store_size_release(&depot->lock, 0);
+}
+
+static void message_pool_push_batch(int cls, MessagePoolNode* chain, size_t count) {
+    MessagePoolDepot* depot = &message_pool_depots[cls];
+    chain->count = count;
+    message_pool_lock(depot);
+    chain->batchNext = depot->batches;
+    depot->batches = chain;
+    atomic_store_size_release(&depot->batchCount, atomic_load_size_relaxed(&depot->batchCount) + 1);
+    message_pool_unlock(depot);
+}
+
+static MessagePoolNode* message_pool_pop_batch(int cls, size_t* count) {
+    MessagePoolDepot* depot = &message_pool_depots[cls];
+    // Unlocked peek keeps an empty depot from costing a lock round trip
+    if (atomic_load_size_relaxed(&depot->batchCount) == 0) return NULL;
+
+    message_pool_lock(depot);
+    MessagePoolNode* chain = depot->batches;
+    if (chain) {
+        depot->batches = chain->batchNext;
+        atomic_store_size_release(&depot->batchCount, atomic_load_size_relaxed(&depot->batchCount) - 1);
+    }
+    message_pool_unlock(depot);
+
+    if (chain) *count = chain->count;
+    return chain;
+}
+
+void* message_pool_alloc(size_t size) {
+    int cls = message_pool_class_of(size);
+    if (cls < 0) {
+        MessagePoolHeader* large = malloc(MESSAGE_POOL_HEADER_SIZE + size);
+        if (!large) return NULL;
+        large->sizeClass = MESSAGE_POOL_LARGE;
+        large->capacity = size;
+        return (uint8_t*)large + MESSAGE_POOL_HEADER_SIZE;
+    }
+
+    MessagePoolBin* bin = message_pool_bin(cls);
+    if (!bin->head) bin->head = message_pool_pop_batch(cls, &bin->count);
+
+    if (bin->head) {
+        MessagePoolNode* node = bin->head;
+        bin->head = node->next;
+        bin->count--;
+        return node;
+    }
+
+    size_t classSize = (size_t)MESSAGE_POOL_MIN_SIZE << cls;
+    MessagePoolHeader* header = malloc(MESSAGE_POOL_HEADER_SIZE + classSize);
+    if (!header) return NULL;
+    atomic_fetch_add_size(&message_pool_heap_count, 1);
+    header->sizeClass = (uint32_t)cls;
+    header->capacity = classSize;
+    return (uint8_t*)header + MESSAGE_POOL_HEADER_SIZE;
+}
+
+void message_pool_release(void* ptr) {
+    if (!ptr) return;
+    MessagePoolHeader* header = message_pool_header(ptr);
+    if (header->sizeClass == MESSAGE_POOL_LARGE) {
+        free(header);
+        return;
+    }
+
+    int cls = (int)header->sizeClass;
+    MessagePoolBin* bin = message_pool_bin(cls);
+    MessagePoolNode* node = ptr;
+    node->next = bin->head;
+    bin->head = node;
+    bin->count++;
+
+    // Keep one batch of headroom locally and hand the rest to the depot
+    if (bin->count >= 2 * MESSAGE_POOL_BATCH) {
+        MessagePoolNode* chain = bin->head;
+        MessagePoolNode* tail = chain;
+        for (size_t i = 1; i < MESSAGE_POOL_BATCH; ++i) tail = tail->next;
+        bin->head = tail->next;
+        tail->next = NULL;
+        bin->count -= MESSAGE_POOL_BATCH;
+        message_pool_push_batch(cls, chain, MESSAGE_POOL_BATCH);
+    }
+}
+
+size_t message_pool_capacity(const void* ptr) {
+    return ptr ? message_pool_header(ptr)->capacity : 0;
+}
+
+void message_pool_thread_flush(void) {
+    for (int cls = 0; cls < MESSAGE_POOL_CLASS_COUNT; ++cls) {
+        MessagePoolBin* bin = &message_pool_bins[cls];
+        if (!bin->head) continue;
+        message_pool_push_batch(cls, bin->head, bin->count);
+        bin->head = NULL;
+        bin->count = 0;
+    }
+}
+
+size_t message_pool_heap_allocations(void) {
+    return atomic_load_size(&message_pool_heap_count);
+}
@@ -0,0 +1,315 @@
+#include "metrics_registry.h"
+#include "portable_atomic.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define METRICS_LOAD(ptr) __atomic_load_n(ptr, __ATOMIC_RELAXED)
+#else
+#  define METRICS_LOAD(ptr) (*(ptr))   // MSVC: aligned volatile word reads do not tear
+#endif
+
+static const uint64_t metrics_bounds_ns[METRICS_HISTOGRAM_BOUNDS] = {
+    1000, 5000, 10000, 50000, 100000, 500000,
+    1000000, 5000000, 10000000, 50000000, 100000000, 500000000, 1000000000
+};
+
+typedef struct {
+    char name[METRICS_NAME_MAX];
+    char labels[METRICS_LABELS_MAX];
+    const char* help;
+    MetricType type;
+    MetricWidth width;
+    const volatile void* value;         // Word series
+    MetricReadFn fn;                    // Derived series, with context
+    const void* context;
+    const LatencyHistogram* histogram;
+    const void* owner;
+} MetricSeries;
+
+struct MetricsRegistry {
+    atomic_size_t lock;                 // Writers and renderers; never taken on the data path
+    MetricSeries* series;               // Families contiguous, in first-registration order
+    size_t count;
+    size_t capacity;
+};
+
+static void registry_lock(MetricsRegistry* registry) {
+    for (;;) {
+        size_t expected = 0;
+        if (atomic_load_size(&registry->lock) == 0 && atomic_cas_size(&registry->lock, &expected, 1)) return;
+    }
+}
+
+static inline void registry_unlock(MetricsRegistry* registry) {
+    atomic_store_size_release(&registry->lock, 0);
+}
+
+MetricsRegistry* metrics_registry_create(void) {
+    MetricsRegistry* registry = (MetricsRegistry*)calloc(1, sizeof(MetricsRegistry));
+    if (!registry) return NULL;
+    atomic_store_size(&registry->lock, 0);
+    return registry;
+}
+
+void metrics_registry_destroy(MetricsRegistry* registry) {
+    if (!registry) return;
+    free(registry->series);
+    free(registry);
+}
+
+/* [a-zA-Z_:][a-zA-Z0-9_:]*, short enough for the histogram suffixes. */
+static bool metrics_valid_name(const char* name) {
+    if (!name || !*name || strlen(name) + sizeof("_bucket") > METRICS_NAME_MAX) return false;
+    for (const char* p = name; *p; ++p) {
+        char c = *p;
+        bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':';
+        if (!alpha && !(p != name && c >= '0' && c <= '9')) return false;
+    }
+    return true;
+}
+
+static bool registry_insert(MetricsRegistry* registry, const MetricSeries* add) {
+    registry_lock(registry);
+
+    // A family stays together: new series go after the last of their name
+    size_t at = registry->count;
+    for (size_t i = 0; i < registry->count; ++i) {
+        const MetricSeries* s = &registry->series[i];
+        if (strcmp(s->name, add->name) != 0) continue;
+        if (s->type != add->type) {
+            registry_unlock(registry);
+            return false;
+        }
+        if (strcmp(s->labels, add->labels) == 0) {
+            registry_unlock(registry);
+            return true;        // Already exported
+        }
+        at = i + 1;
+    }
+
+    if (registry->count == registry->capacity) {
+        size_t capacity = registry->capacity ? registry->capacity * 2 : 64;
+        MetricSeries* grown = (MetricSeries*)realloc(registry->series, capacity * sizeof(MetricSeries));
+        if (!grown) {
+            registry_unlock(registry);
+            return false;
+        }
+        registry->series = grown;
+        registry->capacity = capacity;
+    }
+    memmove(&registry->series[at + 1], &registry->series[at], (registry->count - at) * sizeof(MetricSeries));
+    registry->series[at] = *add;
+    registry->count++;
+
+    registry_unlock(registry);
+    return true;
+}
+
+static bool metrics_prepare(MetricSeries* s, const void* owner, MetricType type, const char* name,
+                            const char* help, const char* labels) {
+    memset(s, 0, sizeof(*s));
+    if (!metrics_valid_name(name) || (labels && strlen(labels) >= METRICS_LABELS_MAX)) return false;
+    strcpy(s->name, name);
+    if (labels) strcpy(s->labels, labels);
+    s->help = help ? help : "";
+    s->type = type;
+    s->owner = owner;
+    return true;
+}
+
+bool metrics_registry_add(MetricsRegistry* registry, const void* owner, MetricType type, const char* name,
+                          const char* help, const char* labels, MetricWidth width, const volatile void* value) {
+    MetricSeries s;
+    if (!registry || !value || type == METRIC_HISTOGRAM || !metrics_prepare(&s, owner, type, name, help, labels)) {
+        return false;
+    }
+    s.width = width;
+    s.value = value;
+    return registry_insert(registry, &s);
+}
+
+bool metrics_registry_add_fn(MetricsRegistry* registry, const void* owner, MetricType type, const char* name,
+                             const char* help, const char* labels, MetricReadFn fn, const void* context) {
+    MetricSeries s;
+    if (!registry || !fn || type == METRIC_HISTOGRAM || !metrics_prepare(&s, owner, type, name, help, labels)) {
+        return false;
+    }
+    s.fn = fn;
+    s.context = context;
+    return registry_insert(registry, &s);
+}
+
+bool metrics_registry_add_histogram(MetricsRegistry* registry, const void* owner, const char* name,
+                                    const char* help, const char* labels, const LatencyHistogram* histogram) {
+    MetricSeries s;
+    if (!registry || !histogram || !metrics_prepare(&s, owner, METRIC_HISTOGRAM, name, help, labels)) {
+        return false;
+    }
+    s.histogram = histogram;
+    return registry_insert(registry, &s);
+}
+
+size_t metrics_registry_remove(MetricsRegistry* registry, const void* owner, size_t size) {
+    if (!registry) return 0;
+    uintptr_t base = (uintptr_t)owner;
+    registry_lock(registry);
+    size_t kept = 0;
+    for (size_t i = 0; i < registry->count; ++i) {
+        uintptr_t at = (uintptr_t)registry->series[i].owner;
+        bool owned = size ? (at >= base && at - base < size) : at == base;
+        if (!owned) registry->series[kept++] = registry->series[i];
+    }
+    size_t removed = registry->count - kept;
+    registry->count = kept;
+    registry_unlock(registry);
+    return removed;
+}
+
+size_t metrics_registry_count(MetricsRegistry* registry) {
+    if (!registry) return 0;
+    registry_lock(registry);
+    size_t count = registry->count;
+    registry_unlock(registry);
+    return count;
+}
+
+const char* metrics_labels(char* out, size_t size, const char* base, const char* key, const char* value) {
+    bool joined = base && *base;
+    snprintf(out, size, "%s%s%s=\"%s\"", joined ? base : "", joined ? "," : "", key, value);
+    return out;
+}
+
+/* ---- Rendering ---- */
+
+static bool text_append(MetricsText* out, const char* format, ...) {
+    for (;;) {
+        size_t room = out->capacity - out->length;
+        va_list args;
+        va_start(args, format);
+        int written = vsnprintf(out->data + out->length, room, format, args);
+        va_end(args);
+        if (written < 0) return false;
+        if ((size_t)written < room) {
+            out->length += (size_t)written;
+            return true;
+        }
+        size_t capacity = out->capacity * 2;
+        while (capacity - out->length <= (size_t)written) capacity *= 2;
+        char* grown = (char*)realloc(out->data, capacity);
+        if (!grown) return false;
+        out->data = grown;
+        out->capacity = capacity;
+    }
+}
+
+/* Prometheus spells the special values its own way. They are told apart by
+ * their bits: the library builds with -ffast-math, which folds isnan and
+ * isinf to false. */
+static bool text_append_double(MetricsText* out, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if ((bits & 0x7FF0000000000000ull) == 0x7FF0000000000000ull) {
+        if (bits & 0x000FFFFFFFFFFFFFull) return text_append(out, "NaN");
+        return text_append(out, (bits >> 63) ? "-Inf" : "+Inf");
+    }
+    return text_append(out, "%.17g", value);
+}
+
+static const char* metrics_type_name(MetricType type) {
+    return type == METRIC_COUNTER ? "counter" : type == METRIC_GAUGE ? "gauge" : "histogram";
+}
+
+/* name{labels} or name{labels,extra} or name{extra}, as the parts exist. */
+static bool text_append_series(MetricsText* out, const char* name, const char* suffix, const char* labels,
+                               const char* extra) {
+    if (!*labels && !extra) return text_append(out, "%s%s ", name, suffix);
+    return text_append(out, "%s%s{%s%s%s} ", name, suffix, labels, (*labels && extra) ? "," : "",
+                       extra ? extra : "");
+}
+
+static bool render_value(MetricsText* out, const MetricSeries* s) {
+    if (!text_append_series(out, s->name, "", s->labels, NULL)) return false;
+    if (s->fn) {
+        if (!text_append_double(out, s->fn(s->context))) return false;
+    } else {
+        switch (s->width) {
+        case METRIC_U32:
+            if (!text_append(out, "%u", (unsigned)METRICS_LOAD((const volatile uint32_t*)s->value))) return false;
+            break;
+        case METRIC_U64:
+            if (!text_append(out, "%llu", (unsigned long long)METRICS_LOAD((const volatile uint64_t*)s->value))) {
+                return false;
+            }
+            break;
+        case METRIC_SIZE:
+            if (!text_append(out, "%llu", (unsigned long long)METRICS_LOAD((const volatile size_t*)s->value))) {
+                return false;
+            }
+            break;
+        default: {
+            uint64_t bits = METRICS_LOAD((const volatile uint64_t*)s->value);
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            if (!text_append_double(out, value)) return false;
+            break;
+        }
+        }
+    }
+    return text_append(out, "\n");
+}
+
+static bool render_histogram(MetricsText* out, const MetricSeries* s) {
+    uint64_t below[METRICS_HISTOGRAM_BOUNDS], total;
+    double sum_ns;
+    latency_histogram_cumulative(s->histogram, metrics_bounds_ns, METRICS_HISTOGRAM_BOUNDS, below, &total, &sum_ns);
+
+    char le[32];
+    for (size_t i = 0; i < METRICS_HISTOGRAM_BOUNDS; ++i) {
+        snprintf(le, sizeof(le), "le=\"%g\"", (double)metrics_bounds_ns[i] / 1e9);
+        if (!text_append_series(out, s->name, "_bucket", s->labels, le) ||
+            !text_append(out, "%llu\n", (unsigned long long)below[i])) {
+            return false;
+        }
+    }
+    return text_append_series(out, s->name, "_bucket", s->labels, "le=\"+Inf\"") &&
+           text_append(out, "%llu\n", (unsigned long long)total) &&
+           text_append_series(out, s->name, "_sum", s->labels, NULL) &&
+           text_append_double(out, sum_ns / 1e9) && text_append(out, "\n") &&
+           text_append_series(out, s->name, "_count", s->labels, NULL) &&
+           text_append(out, "%llu\n", (unsigned long long)total);
+}
+
+bool metrics_registry_render(MetricsRegistry* registry, MetricsText* out) {
+    if (!registry || !out) return false;
+    if (!out->data) {
+        out->data = (char*)malloc(4096);
+        if (!out->data) return false;
+        out->capacity = 4096;
+    }
+    out->length = 0;
+    out->data[0] = '\0';
+
+    registry_lock(registry);
+    bool ok = true;
+    for (size_t i = 0; ok && i < registry->count; ++i) {
+        const MetricSeries* s = &registry->series[i];
+        if (i == 0 || strcmp(registry->series[i - 1].name, s->name) != 0) {
+            ok = text_append(out, "# HELP %s %s\n# TYPE %s %s\n", s->name, s->help, s->name,
+                             metrics_type_name(s->type));
+        }
+        if (ok) ok = s->histogram ? render_histogram(out, s) : render_value(out, s);
+    }
+    registry_unlock(registry);
+    return ok;
+}
+
+void metrics_text_free(MetricsText* text) {
+    if (!text) return;
+    free(text->data);
+    text->data = NULL;
+    text->length = 0;
+    text->capacity = 0;
+}
@@ -0,0 +1,430 @@
+#include "net_transport.h"
+#include "feedback_handshake.h"
+#include "portable_atomic.h"
+#include "umsbb_clock.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <pthread.h>
+#  include <sched.h>
+#  include <unistd.h>
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <netinet/tcp.h>
+#  include <sys/socket.h>
+#  include <sys/uio.h>
+#  define NET_TRANSPORT_POSIX 1
+#endif
+
+#if defined(NET_TRANSPORT_POSIX)
+
+#if defined(MSG_NOSIGNAL)
+#  define NET_TRANSPORT_SEND_FLAGS MSG_NOSIGNAL
+#else
+#  define NET_TRANSPORT_SEND_FLAGS 0
+#endif
+
+typedef struct {
+    uint32_t size;
+    uint32_t sequence;
+    uint16_t kind;
+    uint16_t feedback;
+} NetFrameHeader;
+
+struct NetTransport {
+    twin_lane_manager_t* manager;
+    uint32_t lane_id;
+    int fd;
+    pthread_t thread;
+    bool threaded;
+    atomic_size_t state;        // NET_STATE_* bits, one word so the loop tests both at once
+
+    // Sending: a control frame goes out whole before any data; `sentInFrame`
+    // bytes of the oldest unreleased TX frame are already on the wire
+    uint8_t control[NET_TRANSPORT_HEADER];
+    size_t controlLength;
+    size_t controlSent;
+    bool ackDue;
+    uint32_t ackSequence;       // Last sequence delivered to our RX ring
+    size_t sentInFrame;
+    bool wantWrite;
+
+    // Receiving: parsed from `staging`, or a large payload read in place
+    uint8_t* staging;
+    size_t stagingLength;
+    bool directActive;
+    twin_lane_claim_t direct;
+    uint8_t* directPayload;
+    size_t directSize;
+    size_t directReceived;
+    bool rxBlocked;             // RX ring full, stop reading until it drains
+
+    // Bumped by the transport thread, read by net_transport_get_stats
+    struct {
+        atomic_size_t frames_sent;
+        atomic_size_t frames_received;
+        atomic_size_t bytes_sent;
+        atomic_size_t bytes_received;
+        atomic_size_t send_calls;
+        atomic_size_t recv_calls;
+        atomic_size_t acks_sent;
+        atomic_size_t acks_received;
+        atomic_size_t direct_frames;
+    } stats;
+};
+
+static inline void net_count(atomic_size_t* counter, size_t amount) {
+    atomic_fetch_add_size_relaxed(counter, amount);
+}
+
+static void net_encode(uint8_t* out, uint32_t size, uint32_t sequence, uint16_t kind, uint16_t feedback) {
+    uint32_t words[2] = { htonl(size), htonl(sequence) };
+    uint16_t halves[2] = { htons(kind), htons(feedback) };
+    memcpy(out, words, sizeof(words));
+    memcpy(out + 8, halves, sizeof(halves));
+}
+
+static NetFrameHeader net_decode(const uint8_t* in) {
+    uint32_t words[2];
+    uint16_t halves[2];
+    memcpy(words, in, sizeof(words));
+    memcpy(halves, in + 8, sizeof(halves));
+    NetFrameHeader header = { ntohl(words[0]), ntohl(words[1]), ntohs(halves[0]), ntohs(halves[1]) };
+    return header;
+}
+
+#define NET_STATE_OPEN ((size_t)1)       // Stream usable
+#define NET_STATE_RUNNING ((size_t)2)    // Transport thread asked to keep going
+#define NET_STATE_LIVE (NET_STATE_OPEN | NET_STATE_RUNNING)
+
+static void net_fail(NetTransport* t) {
+    atomic_fetch_and_size(&t->state, ~NET_STATE_OPEN);
+}
+
+static inline bool net_open(NetTransport* t) {
+    return (atomic_load_size(&t->state) & NET_STATE_OPEN) != 0;
+}
+
+NetTransport* net_transport_create(twin_lane_manager_t* manager, uint32_t lane_id, int socket_fd) {
+    if (!manager || lane_id >= manager->lane_count || socket_fd < 0) return NULL;
+    NetTransport* t = (NetTransport*)calloc(1, sizeof(NetTransport));
+    if (!t) return NULL;
+    t->staging = (uint8_t*)malloc(NET_TRANSPORT_RECV_BUFFER);
+    if (!t->staging) {
+        free(t);
+        return NULL;
+    }
+    t->manager = manager;
+    t->lane_id = lane_id;
+    t->fd = socket_fd;
+
+    int flags = fcntl(socket_fd, F_GETFL, 0);
+    fcntl(socket_fd, F_SETFL, flags | O_NONBLOCK);
+    // Batching is ours to do; let small frames out without Nagle's delay
+    int one = 1;
+    setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#if defined(SO_NOSIGPIPE)
+    setsockopt(socket_fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+    atomic_store_size(&t->state, NET_STATE_OPEN);
+    return t;
+}
+
+/* Gather pending control and up to NET_TRANSPORT_BATCH TX frames into one sendmsg. */
+static bool net_send_pass(NetTransport* t) {
+    twin_lane_manager_t* manager = t->manager;
+    struct iovec iov[2 * NET_TRANSPORT_BATCH + 1];
+    uint8_t headers[NET_TRANSPORT_BATCH][NET_TRANSPORT_HEADER];
+    uint64_t ends[NET_TRANSPORT_BATCH];
+    size_t lengths[NET_TRANSPORT_BATCH], sizes[NET_TRANSPORT_BATCH];
+    int count = 0, frames = 0;
+
+    // ACKs go out between frames, never inside a partly sent one
+    if (t->controlSent == t->controlLength && t->ackDue && t->sentInFrame == 0) {
+        net_encode(t->control, 0, t->ackSequence, NET_FRAME_FEEDBACK, FEEDBACK_TYPE_ACK);
+        t->controlLength = NET_TRANSPORT_HEADER;
+        t->controlSent = 0;
+        t->ackDue = false;
+    }
+    if (t->controlSent < t->controlLength) {
+        iov[count].iov_base = t->control + t->controlSent;
+        iov[count++].iov_len = t->controlLength - t->controlSent;
+    }
+
+    uint64_t cursor = twin_lane_tx_cursor(manager, t->lane_id);
+    size_t skip = t->sentInFrame;
+    const void* payload;
+    size_t size;
+    uint32_t sequence;
+    while (frames < NET_TRANSPORT_BATCH &&
+           (payload = twin_lane_peek_tx(manager, t->lane_id, &cursor, &size, &sequence))) {
+        net_encode(headers[frames], (uint32_t)size, sequence, NET_FRAME_DATA, 0);
+        size_t headerSkip = skip < NET_TRANSPORT_HEADER ? skip : NET_TRANSPORT_HEADER;
+        if (headerSkip < NET_TRANSPORT_HEADER) {
+            iov[count].iov_base = headers[frames] + headerSkip;
+            iov[count++].iov_len = NET_TRANSPORT_HEADER - headerSkip;
+        }
+        size_t payloadSkip = skip - headerSkip;
+        iov[count].iov_base = (void*)((const uint8_t*)payload + payloadSkip);
+        iov[count++].iov_len = size - payloadSkip;
+        lengths[frames] = NET_TRANSPORT_HEADER + size - skip;
+        sizes[frames] = size;
+        ends[frames++] = cursor;
+        skip = 0;
+    }
+    if (count == 0) return false;
+
+    struct msghdr message = {0};
+    message.msg_iov = iov;
+    message.msg_iovlen = (size_t)count;
+    ssize_t written = sendmsg(t->fd, &message, NET_TRANSPORT_SEND_FLAGS);
+    if (written < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            t->wantWrite = true;
+        } else {
+            net_fail(t);
+        }
+        return false;
+    }
+    t->wantWrite = false;
+    net_count(&t->stats.send_calls, 1);
+
+    size_t left = (size_t)written;
+    if (t->controlSent < t->controlLength) {
+        size_t take = t->controlLength - t->controlSent;
+        if (take > left) take = left;
+        t->controlSent += take;
+        left -= take;
+        if (t->controlSent == t->controlLength) net_count(&t->stats.acks_sent, 1);
+    }
+
+    // Release every frame that went out whole; remember how far into the next one we got
+    uint64_t released = 0;
+    bool release = false;
+    for (int i = 0; i < frames; ++i) {
+        if (left >= lengths[i]) {
+            left -= lengths[i];
+            released = ends[i];
+            release = true;
+            t->sentInFrame = 0;
+            net_count(&t->stats.frames_sent, 1);
+            net_count(&t->stats.bytes_sent, sizes[i]);
+        } else {
+            t->sentInFrame += left;
+            break;
+        }
+    }
+    if (release) twin_lane_release_tx(manager, t->lane_id, released);
+    return true;
+}
+
+static void net_delivered(NetTransport* t, uint32_t sequence, size_t size) {
+    t->ackSequence = sequence;
+    t->ackDue = true;
+    net_count(&t->stats.frames_received, 1);
+    net_count(&t->stats.bytes_received, size);
+}
+
+/* Parse whole frames out of the staging buffer; returns whether any were consumed. */
+static bool net_parse(NetTransport* t) {
+    twin_lane_manager_t* manager = t->manager;
+    size_t rxCapacity = manager->lanes[t->lane_id].rx.capacity;
+    size_t position = 0;
+    bool consumed = false;
+    t->rxBlocked = false;
+
+    while (t->stagingLength - position >= NET_TRANSPORT_HEADER) {
+        NetFrameHeader header = net_decode(t->staging + position);
+        const uint8_t* body = t->staging + position + NET_TRANSPORT_HEADER;
+        size_t available = t->stagingLength - position - NET_TRANSPORT_HEADER;
+
+        if (header.kind == NET_FRAME_FEEDBACK) {
+            if (header.feedback == FEEDBACK_TYPE_ACK) {
+                twin_lane_update_flow_control(manager, t->lane_id, header.sequence);
+                net_count(&t->stats.acks_received, 1);
+            }
+            position += NET_TRANSPORT_HEADER;
+            consumed = true;
+            continue;
+        }
+        if (header.kind != NET_FRAME_DATA || header.size == 0 ||
+            header.size > rxCapacity - TWIN_LANE_RECORD_HEADER) {
+            net_fail(t);    // Not our protocol, or a frame our RX ring can never hold
+            return consumed;
+        }
+
+        if (available >= header.size) {
+            if (!twin_lane_deliver(manager, t->lane_id, body, header.size, header.sequence)) {
+                t->rxBlocked = true;
+                break;
+            }
+            net_delivered(t, header.sequence, header.size);
+            position += NET_TRANSPORT_HEADER + header.size;
+            consumed = true;
+        } else if (header.size >= NET_TRANSPORT_DIRECT_BYTES) {
+            // Take what has arrived, read the rest straight into the ring
+            uint8_t* payload = twin_lane_claim_rx(manager, t->lane_id, header.size, header.sequence, &t->direct);
+            if (!payload) {
+                t->rxBlocked = true;
+                break;
+            }
+            memcpy(payload, body, available);
+            t->directActive = true;
+            t->directPayload = payload;
+            t->directSize = header.size;
+            t->directReceived = available;
+            position = t->stagingLength;
+            consumed = true;
+            break;
+        } else {
+            break;  // Wait for the rest of the frame
+        }
+    }
+
+    if (position) {
+        memmove(t->staging, t->staging + position, t->stagingLength - position);
+        t->stagingLength -= position;
+    }
+    return consumed;
+}
+
+static bool net_recv_pass(NetTransport* t) {
+    if (t->directActive) {
+        ssize_t got = recv(t->fd, t->directPayload + t->directReceived, t->directSize - t->directReceived, 0);
+        if (got == 0) {
+            net_fail(t);
+            return false;
+        }
+        if (got < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) net_fail(t);
+            return false;
+        }
+        net_count(&t->stats.recv_calls, 1);
+        t->directReceived += (size_t)got;
+        if (t->directReceived == t->directSize) {
+            twin_lane_commit_rx(t->manager, t->lane_id, &t->direct);
+            t->directActive = false;
+            net_count(&t->stats.direct_frames, 1);
+            net_delivered(t, t->direct.sequence, t->directSize);
+        }
+        return true;
+    }
+
+    // Retry frames held back by a full RX ring before reading more
+    bool moved = false;
+    if (t->rxBlocked) {
+        moved = net_parse(t);
+        if (t->rxBlocked) return moved;
+    }
+
+    if (t->stagingLength == NET_TRANSPORT_RECV_BUFFER) return moved;
+    ssize_t got = recv(t->fd, t->staging + t->stagingLength, NET_TRANSPORT_RECV_BUFFER - t->stagingLength, 0);
+    if (got == 0) {
+        net_fail(t);
+        return moved;
+    }
+    if (got < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) net_fail(t);
+        return moved;
+    }
+    net_count(&t->stats.recv_calls, 1);
+    t->stagingLength += (size_t)got;
+    net_parse(t);
+    return true;
+}
+
+bool net_transport_poll(NetTransport* t) {
+    if (!t || !net_open(t)) return false;
+    bool received = net_recv_pass(t);
+    bool sent = net_send_pass(t);
+    return received || sent;
+}
+
+static void* net_transport_main(void* arg) {
+    NetTransport* t = (NetTransport*)arg;
+    uint64_t lastActivity = umsbb_clock_ns();
+    while ((atomic_load_size(&t->state) & NET_STATE_LIVE) == NET_STATE_LIVE) {
+        if (net_transport_poll(t)) {
+            lastActivity = umsbb_clock_ns();
+            continue;
+        }
+        if (umsbb_clock_ns() - lastActivity < NET_TRANSPORT_SPIN_NS) {
+            sched_yield();
+            continue;
+        }
+        // With the RX ring full there is no point waking for input
+        short events = (short)((t->rxBlocked ? 0 : POLLIN) | (t->wantWrite ? POLLOUT : 0));
+        struct pollfd p = { t->fd, events, 0 };
+        poll(&p, 1, NET_TRANSPORT_IDLE_MS);
+    }
+    return NULL;
+}
+
+bool net_transport_start(NetTransport* t) {
+    if (!t || t->threaded) return false;
+    atomic_fetch_or_size(&t->state, NET_STATE_RUNNING);
+    if (pthread_create(&t->thread, NULL, net_transport_main, t) != 0) {
+        atomic_fetch_and_size(&t->state, ~NET_STATE_RUNNING);
+        return false;
+    }
+    t->threaded = true;
+    return true;
+}
+
+bool net_transport_is_open(NetTransport* t) {
+    return t && net_open(t);
+}
+
+void net_transport_get_stats(NetTransport* t, struct net_transport_stats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!t) return;
+    stats->frames_sent = atomic_load_size_relaxed(&t->stats.frames_sent);
+    stats->frames_received = atomic_load_size_relaxed(&t->stats.frames_received);
+    stats->bytes_sent = atomic_load_size_relaxed(&t->stats.bytes_sent);
+    stats->bytes_received = atomic_load_size_relaxed(&t->stats.bytes_received);
+    stats->send_calls = atomic_load_size_relaxed(&t->stats.send_calls);
+    stats->recv_calls = atomic_load_size_relaxed(&t->stats.recv_calls);
+    stats->acks_sent = atomic_load_size_relaxed(&t->stats.acks_sent);
+    stats->acks_received = atomic_load_size_relaxed(&t->stats.acks_received);
+    stats->direct_frames = atomic_load_size_relaxed(&t->stats.direct_frames);
+}
+
+void net_transport_destroy(NetTransport* t) {
+    if (!t) return;
+    if (t->threaded) {
+        atomic_fetch_and_size(&t->state, ~NET_STATE_RUNNING);
+        pthread_join(t->thread, NULL);
+    }
+    // A half-read bulk frame is never committed: its bytes are not all there
+    close(t->fd);
+    free(t->staging);
+    free(t);
+}
+
+#else
+
+NetTransport* net_transport_create(twin_lane_manager_t* manager, uint32_t lane_id, int socket_fd) {
+    (void)manager;
+    (void)lane_id;
+    (void)socket_fd;
+    return NULL;
+}
+
+bool net_transport_start(NetTransport* transport) { (void)transport; return false; }
+bool net_transport_poll(NetTransport* transport) { (void)transport; return false; }
+bool net_transport_is_open(NetTransport* transport) { (void)transport; return false; }
+
+void net_transport_get_stats(NetTransport* transport, struct net_transport_stats* stats) {
+    (void)transport;
+    if (stats) memset(stats, 0, sizeof(*stats));
+}
+
+void net_transport_destroy(NetTransport* transport) { (void)transport; }
+
+#endif
@@ -0,0 +1,250 @@
+#include "offload_planner.h"
+#include "umsbb_clock.h"
+#include <stdlib.h>
+#include <string.h>
+
+static inline unsigned offload_bucket(size_t size) {
+    uint64_t v = size ? (uint64_t)size : 1;
+#if defined(__GNUC__) || defined(__clang__)
+    unsigned log = 63u - (unsigned)__builtin_clzll(v);
+#else
+    unsigned log = 0;
+    while (v >>= 1) log++;
+#endif
+    return log < OFFLOAD_PLANNER_BUCKETS ? log : OFFLOAD_PLANNER_BUCKETS - 1;
+}
+
+static void planner_lock(OffloadPlanner* planner) {
+    for (;;) {
+        uint32_t expected = 0;
+        if (atomic_load(&planner->lock) == 0 && atomic_compare_exchange_weak(&planner->lock, &expected, 1)) {
+            return;
+        }
+    }
+}
+
+static inline void planner_unlock(OffloadPlanner* planner) {
+    atomic_store(&planner->lock, 0);
+}
+
+// Least squares over the buckets, weighted by 1 / cost^2 so each bucket's
+// relative error counts the same
+static void model_fit(OffloadModel* model) {
+    double w = 0, x = 0, y = 0, xx = 0, xy = 0;
+    uint32_t points = 0;
+    for (unsigned i = 0; i < OFFLOAD_PLANNER_BUCKETS; i++) {
+        const OffloadBucket* bucket = &model->buckets[i];
+        if (bucket->samples == 0 || bucket->ns <= 0) continue;
+        double weight = 1.0 / (bucket->ns * bucket->ns);
+        w += weight;
+        x += weight * bucket->bytes;
+        y += weight * bucket->ns;
+        xx += weight * bucket->bytes * bucket->bytes;
+        xy += weight * bucket->bytes * bucket->ns;
+        points++;
+    }
+    double det = w * xx - x * x;
+    model->fitted = points >= 2 && det > 0;
+    if (!model->fitted) return;
+
+    model->nsPerByte = (w * xy - x * y) / det;
+    model->fixedNs = (y - model->nsPerByte * x) / w;
+    // Costs never fall with size, nor below zero
+    if (model->nsPerByte < 0) {
+        model->nsPerByte = 0;
+        model->fixedNs = y / w;
+    } else if (model->fixedNs < 0) {
+        model->fixedNs = 0;
+        model->nsPerByte = xy / xx;
+    }
+}
+
+static void model_sample(OffloadModel* model, size_t size, double ns) {
+    OffloadBucket* bucket = &model->buckets[offload_bucket(size)];
+    if (bucket->samples == 0) {
+        bucket->bytes = (double)size;
+        bucket->ns = ns;
+    } else {
+        bucket->bytes += OFFLOAD_PLANNER_ALPHA * ((double)size - bucket->bytes);
+        bucket->ns += OFFLOAD_PLANNER_ALPHA * (ns - bucket->ns);
+    }
+    bucket->samples++;
+    model->samples++;
+}
+
+static void state_update_crossover(OffloadOpState* state) {
+    const OffloadModel* cpu = &state->path[OFFLOAD_PATH_CPU];
+    const OffloadModel* gpu = &state->path[OFFLOAD_PATH_GPU];
+    if (!cpu->fitted || !gpu->fitted) {
+        state->crossover = OFFLOAD_PLANNER_DEFAULT_CROSSOVER;
+        return;
+    }
+    // The GPU wins where (gpu fixed - cpu fixed) + (gpu slope - cpu slope) * size < 0
+    double fixed = gpu->fixedNs - cpu->fixedNs;
+    double slope = gpu->nsPerByte - cpu->nsPerByte;
+    if (slope >= 0) {
+        state->crossover = (fixed < 0 && slope == 0) ? 0 : SIZE_MAX;
+    } else if (fixed < 0) {
+        state->crossover = 0;
+    } else {
+        double size = fixed / -slope;
+        state->crossover = (size >= (double)SIZE_MAX) ? SIZE_MAX : (size_t)size + 1;
+    }
+}
+
+void offload_planner_init(OffloadPlanner* planner, bool gpuAvailable) {
+    memset(planner, 0, sizeof(*planner));
+    planner->gpuAvailable = gpuAvailable;
+    for (int op = 0; op < OFFLOAD_OP_COUNT; op++) {
+        planner->ops[op].crossover = OFFLOAD_PLANNER_DEFAULT_CROSSOVER;
+    }
+    atomic_store(&planner->lock, 0);
+}
+
+void offload_planner_set_gpu(OffloadPlanner* planner, bool gpuAvailable) {
+    planner_lock(planner);
+    planner->gpuAvailable = gpuAvailable;
+    planner_unlock(planner);
+}
+
+// Fastest of the calibration runs, 0 if the path failed
+static uint64_t time_run(OffloadRunFn run, void* context, void* dst, const void* src, size_t size) {
+    uint64_t best = 0;
+    for (int i = 0; i < OFFLOAD_PLANNER_CALIBRATION_RUNS; i++) {
+        uint64_t start = umsbb_clock_ns();
+        if (!run(context, dst, src, size)) return 0;
+        uint64_t ns = umsbb_clock_ns() - start;
+        if (ns == 0) ns = 1;
+        if (best == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+bool offload_planner_calibrate(OffloadPlanner* planner, OffloadRunFn cpu, OffloadRunFn gpu, void* context,
+                               size_t maxBytes) {
+    if (!planner || !cpu || !gpu || maxBytes < OFFLOAD_PLANNER_CALIBRATION_MIN) return false;
+    if (maxBytes > OFFLOAD_PLANNER_CALIBRATION_MAX) maxBytes = OFFLOAD_PLANNER_CALIBRATION_MAX;
+
+    uint8_t* src = (uint8_t*)malloc(maxBytes);
+    uint8_t* dst = (uint8_t*)malloc(maxBytes);
+    if (!src || !dst) {
+        free(src);
+        free(dst);
+        return false;
+    }
+    memset(src, 0x5A, maxBytes);
+    memset(dst, 0, maxBytes);
+
+    // Measured outside the lock; operations keep deciding meanwhile
+    enum { STEPS = 16 };
+    size_t sizes[STEPS];
+    uint64_t cpuNs[STEPS], gpuNs[STEPS];
+    int steps = 0;
+    bool gpuOk = true;
+    for (size_t size = OFFLOAD_PLANNER_CALIBRATION_MIN; size <= maxBytes && steps < STEPS; size *= 4) {
+        sizes[steps] = size;
+        cpuNs[steps] = time_run(cpu, context, dst, src, size);
+        gpuNs[steps] = gpuOk ? time_run(gpu, context, dst, src, size) : 0;
+        gpuOk &= gpuNs[steps] != 0;
+        steps++;
+    }
+    free(src);
+    free(dst);
+
+    planner_lock(planner);
+    for (int op = 0; op < OFFLOAD_OP_COUNT; op++) {
+        OffloadOpState* state = &planner->ops[op];
+        for (int i = 0; i < steps; i++) {
+            // A fresh calibration replaces what the buckets had learnt
+            OffloadBucket* bucket = &state->path[OFFLOAD_PATH_CPU].buckets[offload_bucket(sizes[i])];
+            if (cpuNs[i]) *bucket = (OffloadBucket){ (double)sizes[i], (double)cpuNs[i], 1 };
+            bucket = &state->path[OFFLOAD_PATH_GPU].buckets[offload_bucket(sizes[i])];
+            if (gpuNs[i]) *bucket = (OffloadBucket){ (double)sizes[i], (double)gpuNs[i], 1 };
+            if (gpuNs[i] && state->gpuMeanNs == 0) state->gpuMeanNs = (double)gpuNs[i];
+        }
+        state->path[OFFLOAD_PATH_CPU].samples += (uint64_t)steps;
+        if (gpuOk) state->path[OFFLOAD_PATH_GPU].samples += (uint64_t)steps;
+        model_fit(&state->path[OFFLOAD_PATH_CPU]);
+        model_fit(&state->path[OFFLOAD_PATH_GPU]);
+        state_update_crossover(state);
+    }
+    if (!gpuOk) planner->gpuAvailable = false;
+    planner_unlock(planner);
+    return gpuOk;
+}
+
+OffloadPath offload_planner_choose(OffloadPlanner* planner, OffloadOp op, size_t size) {
+    if (!planner || !planner->gpuAvailable || op >= OFFLOAD_OP_COUNT) return OFFLOAD_PATH_CPU;
+
+    planner_lock(planner);
+    OffloadOpState* state = &planner->ops[op];
+    const OffloadModel* cpu = &state->path[OFFLOAD_PATH_CPU];
+    const OffloadModel* gpu = &state->path[OFFLOAD_PATH_GPU];
+    bool offload;
+    if (cpu->fitted && gpu->fitted) {
+        double cpuNs = cpu->fixedNs + cpu->nsPerByte * (double)size;
+        double gpuNs = gpu->fixedNs + gpu->nsPerByte * (double)size + state->gpuInFlight * state->gpuMeanNs;
+        offload = gpuNs < cpuNs;
+
+        // Near the crossover, now and then try the other path
+        size_t pivot = state->crossover;
+        if (pivot < OFFLOAD_PLANNER_CALIBRATION_MIN) pivot = OFFLOAD_PLANNER_CALIBRATION_MIN;
+        if (pivot > OFFLOAD_PLANNER_CALIBRATION_MAX) pivot = OFFLOAD_PLANNER_CALIBRATION_MAX;
+        if (++state->decisions % OFFLOAD_PLANNER_EXPLORE_EVERY == 0 && size >= pivot / 4 && size / 4 <= pivot) {
+            offload = !offload;
+            state->explored++;
+        }
+    } else {
+        offload = size > OFFLOAD_PLANNER_DEFAULT_CROSSOVER;
+    }
+    if (offload) state->gpuInFlight++;
+    planner_unlock(planner);
+    return offload ? OFFLOAD_PATH_GPU : OFFLOAD_PATH_CPU;
+}
+
+void offload_planner_complete(OffloadPlanner* planner, OffloadOp op, OffloadPath path, size_t size, uint64_t ns,
+                              bool ok) {
+    if (!planner || op >= OFFLOAD_OP_COUNT) return;
+
+    planner_lock(planner);
+    OffloadOpState* state = &planner->ops[op];
+    if (path == OFFLOAD_PATH_GPU && state->gpuInFlight > 0) state->gpuInFlight--;
+    if (ok) {
+        OffloadModel* model = &state->path[path];
+        model_sample(model, size, (double)ns);
+        model_fit(model);
+        if (path == OFFLOAD_PATH_GPU) {
+            state->gpuMeanNs += (state->gpuMeanNs == 0) ? (double)ns : OFFLOAD_PLANNER_ALPHA * ((double)ns - state->gpuMeanNs);
+        }
+        state_update_crossover(state);
+    }
+    planner_unlock(planner);
+}
+
+size_t offload_planner_crossover(OffloadPlanner* planner, OffloadOp op) {
+    if (!planner || op >= OFFLOAD_OP_COUNT) return SIZE_MAX;
+    planner_lock(planner);
+    size_t crossover = planner->gpuAvailable ? planner->ops[op].crossover : SIZE_MAX;
+    planner_unlock(planner);
+    return crossover;
+}
+
+void offload_planner_stats(OffloadPlanner* planner, OffloadOp op, OffloadStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    out->crossover = SIZE_MAX;
+    if (!planner || op >= OFFLOAD_OP_COUNT) return;
+
+    planner_lock(planner);
+    const OffloadOpState* state = &planner->ops[op];
+    out->cpuFixedNs = state->path[OFFLOAD_PATH_CPU].fixedNs;
+    out->cpuNsPerByte = state->path[OFFLOAD_PATH_CPU].nsPerByte;
+    out->gpuFixedNs = state->path[OFFLOAD_PATH_GPU].fixedNs;
+    out->gpuNsPerByte = state->path[OFFLOAD_PATH_GPU].nsPerByte;
+    out->crossover = planner->gpuAvailable ? state->crossover : SIZE_MAX;
+    out->cpuSamples = state->path[OFFLOAD_PATH_CPU].samples;
+    out->gpuSamples = state->path[OFFLOAD_PATH_GPU].samples;
+    out->explored = state->explored;
+    out->gpuInFlight = state->gpuInFlight;
+    planner_unlock(planner);
+}
@@ -3,7 +3,13 @@
  * Mock implementation for testing UMSBB v3.1 parallel processing capabilities
  */
 
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // pthread_setaffinity_np
+#endif
 #include "../include/parallel_throughput_engine.h"
+#include "../include/umsbb_clock.h"
+#include "../include/umsbb_trace.h"
+#include "../include/message_pool.h"
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -18,6 +24,437 @@
 #define THREAD_RETURN_TYPE void*
 #endif
 
+#if UMSBB_MAX_WORKER_THREADS > 32
+#error "parked_workers holds one bit per worker"
+#endif
+
+static inline void worker_cpu_relax(void) {
+#if defined(_MSC_VER)
+    YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static inline void worker_yield(void) {
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+static parallel_idle_t idle_policy_for(throughput_strategy_t strategy) {
+    switch (strategy) {
+        case THROUGHPUT_STRATEGY_LATENCY_OPTIMIZED: return PARALLEL_IDLE_SPIN;
+        case THROUGHPUT_STRATEGY_BANDWIDTH_OPTIMIZED: return PARALLEL_IDLE_SLEEP;
+        default: return PARALLEL_IDLE_PARK;
+    }
+}
+
+// Wake one parked worker, `preferred` if it is parked. The parked bit is
+// claimed first so concurrent submits wake different workers.
+static void wake_one(parallel_engine_t* engine, uint32_t preferred) {
+    uint32_t parked = atomic_load(&engine->parked_workers);
+    while (parked) {
+        uint32_t index = preferred;
+        if (!(parked & (1u << index))) {
+            for (index = 0; !(parked & (1u << index)); index++) { }
+        }
+        uint32_t expected = parked;
+        if (atomic_compare_exchange_weak(&engine->parked_workers, &expected, parked & ~(1u << index))) {
+            event_signal(&engine->workers[index].wake);
+            UMSBB_TRACE_ALWAYS(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_SIGNAL, index, 0);
+            return;
+        }
+        parked = atomic_load(&engine->parked_workers);
+    }
+}
+
+// Apply worker->cpu_core to a running thread
+static bool pin_worker(parallel_worker_t* worker) {
+    if (!worker->thread_handle) return true; // Applied at start
+#if defined(_WIN32)
+    GROUP_AFFINITY affinity;
+    memset(&affinity, 0, sizeof(affinity));
+    affinity.Mask = (KAFFINITY)1 << (worker->cpu_core % 64);
+    affinity.Group = (WORD)(worker->cpu_core / 64);
+    return SetThreadGroupAffinity((HANDLE)worker->thread_handle, &affinity, NULL) != 0;
+#elif defined(__linux__) && !defined(__EMSCRIPTEN__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(worker->cpu_core, &set);
+    return pthread_setaffinity_np(*(pthread_t*)worker->thread_handle, sizeof(set), &set) == 0;
+#else
+    return false; // No hard affinity API
+#endif
+}
+
+static cpu_topology_t* engine_topology(parallel_engine_t* engine) {
+    if (!engine->topology) {
+        cpu_topology_t* topology = malloc(sizeof(cpu_topology_t));
+        if (!topology) return NULL;
+        cpu_topology_discover(topology);
+        engine->topology = topology;
+    }
+    return engine->topology;
+}
+
+static void set_parked(parallel_worker_t* worker, bool parked) {
+    parallel_engine_t* engine = worker->engine;
+    uint32_t bit = 1u << worker->thread_id;
+    for (;;) {
+        uint32_t current = atomic_load(&engine->parked_workers);
+        uint32_t next = parked ? (current | bit) : (current & ~bit);
+        if (next == current) return;
+        if (atomic_compare_exchange_weak(&engine->parked_workers, &current, next)) return;
+    }
+}
+
+// Ring operations. Reserve a run with one CAS, fill or copy it, then publish
+// it in reservation order with one store.
+static void ring_wait_turn(UMSBB_ATOMIC(uint64_t)* cursor, uint64_t start) {
+    for (uint32_t spins = 1; atomic_load(cursor) != start; spins++) {
+        if (spins % 64 == 0) worker_yield();
+        else worker_cpu_relax();
+    }
+}
+
+static uint32_t ring_reserve(parallel_ring_buffer_t* ring, uint32_t count, uint64_t* start) {
+    for (;;) {
+        uint64_t tail = atomic_load(&ring->reserve_tail);
+        uint64_t room = ring->capacity - (tail - atomic_load(&ring->head));
+        uint32_t n = count < room ? count : (uint32_t)room;
+        if (n == 0) return 0;
+        if (atomic_compare_exchange_weak(&ring->reserve_tail, &tail, tail + n)) {
+            *start = tail;
+            return n;
+        }
+    }
+}
+
+static void ring_publish(parallel_ring_buffer_t* ring, uint64_t start, uint32_t count) {
+    ring_wait_turn(&ring->tail, start);
+    atomic_store(&ring->tail, start + count);
+}
+
+uint32_t parallel_ring_buffer_push_bulk(parallel_ring_buffer_t* ring, const parallel_task_t* tasks, uint32_t count) {
+    uint64_t start;
+    uint32_t n = ring_reserve(ring, count, &start);
+    for (uint32_t i = 0; i < n; i++) {
+        ring->items[(start + i) & ring->mask] = tasks[i];
+    }
+    if (n) ring_publish(ring, start, n);
+    return n;
+}
+
+uint32_t parallel_ring_buffer_pop_bulk(parallel_ring_buffer_t* ring, parallel_task_t* tasks, uint32_t count) {
+    uint64_t start;
+    uint32_t n;
+    for (;;) {
+        start = atomic_load(&ring->reserve_head);
+        uint64_t available = atomic_load(&ring->tail) - start;
+        n = count < available ? count : (uint32_t)available;
+        if (n == 0) return 0;
+        if (atomic_compare_exchange_weak(&ring->reserve_head, &start, start + n)) break;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        tasks[i] = ring->items[(start + i) & ring->mask];
+    }
+    // Hand the slots back to producers in claim order
+    ring_wait_turn(&ring->head, start);
+    atomic_store(&ring->head, start + n);
+    return n;
+}
+
+// Deque operations (Chase-Lev). Owner: push/pop at the bottom. Anyone: steal
+// at the top. Sequentially consistent atomics order the owner's bottom store
+// against the top load in pop, which is what the algorithm requires.
+static bool deque_push(parallel_deque_t* deque, const parallel_task_t* task) {
+    int64_t bottom = atomic_load(&deque->bottom);
+    int64_t top = atomic_load(&deque->top);
+    if (bottom - top > (int64_t)deque->mask) {
+        return false; // Full
+    }
+    deque->items[bottom & deque->mask] = *task;
+    atomic_store(&deque->bottom, bottom + 1);
+    return true;
+}
+
+static bool deque_pop(parallel_deque_t* deque, parallel_task_t* task) {
+    int64_t bottom = atomic_load(&deque->bottom) - 1;
+    atomic_store(&deque->bottom, bottom);
+    int64_t top = atomic_load(&deque->top);
+    
+    if (top > bottom) {
+        atomic_store(&deque->bottom, bottom + 1); // Empty
+        return false;
+    }
+    
+    *task = deque->items[bottom & deque->mask];
+    if (top == bottom) {
+        // Last task: race thieves for it
+        bool won = atomic_compare_exchange_strong(&deque->top, &top, top + 1);
+        atomic_store(&deque->bottom, bottom + 1);
+        return won;
+    }
+    return true;
+}
+
+static bool deque_steal(parallel_deque_t* deque, parallel_task_t* task) {
+    int64_t top = atomic_load(&deque->top);
+    int64_t bottom = atomic_load(&deque->bottom);
+    if (top >= bottom) {
+        return false;
+    }
+    // The slot cannot be reused before top moves past it, so a copy that
+    // loses the CAS is simply discarded
+    *task = deque->items[top & deque->mask];
+    return atomic_compare_exchange_strong(&deque->top, &top, top + 1);
+}
+
+static uint32_t deque_size(parallel_deque_t* deque) {
+    int64_t size = atomic_load(&deque->bottom) - atomic_load(&deque->top);
+    return size > 0 ? (uint32_t)size : 0;
+}
+
+static uint32_t worker_random(parallel_worker_t* worker) {
+    uint32_t x = worker->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return worker->rng = x;
+}
+
+static uint32_t worker_batch_size(parallel_worker_t* worker) {
+    uint32_t batch = worker->engine->batch_size;
+    if (batch == 0) batch = 1;
+    return batch > UMSBB_DEQUE_SIZE / 2 ? UMSBB_DEQUE_SIZE / 2 : batch;
+}
+
+// Final status for a task nobody will run; tells the submitter, drops the copy
+static void fail_task(parallel_task_t* task) {
+    if (task->origin) atomic_store(&task->origin->status, PARALLEL_STATUS_ERROR);
+    else message_pool_release(task->data);
+}
+
+// Run one lane's handler over a run of that lane's tasks
+static void run_handler(parallel_worker_t* worker, const parallel_task_t* tasks, uint32_t count) {
+    parallel_engine_t* engine = worker->engine;
+    parallel_handler_t* handler = &engine->handlers[tasks[0].lane_id];
+    parallel_work_item_t* items = worker->batch;
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const parallel_task_t* task = &tasks[i];
+        parallel_work_item_t* item = &items[i];
+        item->message_id = task->origin ? task->origin->message_id : 0;
+        item->lane_id = task->lane_id;
+        item->priority = task->priority;
+        item->size = task->size;
+        item->data = task->data;
+        item->timestamp = task->timestamp;
+        item->language_id = task->language_id;
+        atomic_store(&item->status, PARALLEL_STATUS_PROCESSING);
+        item->flags = task->origin ? 0 : PARALLEL_ITEM_OWNED;
+        item->origin = task->origin;
+        bytes += task->size;
+    }
+    if (handler->fn) handler->fn(items, count, handler->ctx);
+    
+    for (uint32_t i = 0; i < count; i++) {
+        parallel_work_item_t* item = &items[i];
+        uint32_t status = atomic_load(&item->status);
+        if (status == PARALLEL_STATUS_ERROR) {
+            atomic_fetch_add(&engine->total_errors, 1);
+        } else {
+            status = PARALLEL_STATUS_COMPLETE;
+        }
+        if (tasks[i].origin) atomic_store(&tasks[i].origin->status, status);
+        else message_pool_release(tasks[i].data);
+    }
+    atomic_fetch_add(&worker->messages_processed, count);
+    atomic_fetch_add(&worker->bytes_processed, bytes);
+}
+
+// Hand a batch to the handlers, one call per lane present
+static void process_tasks(parallel_worker_t* worker, parallel_task_t* tasks, uint32_t count) {
+    uint32_t start = 0;
+    while (start < count) {
+        // Gather the run of tasks sharing tasks[start]'s lane
+        uint32_t lane = tasks[start].lane_id;
+        uint32_t end = start + 1;
+        for (uint32_t i = end; i < count; i++) {
+            if (tasks[i].lane_id != lane) continue;
+            if (i != end) {
+                parallel_task_t swap = tasks[end];
+                tasks[end] = tasks[i];
+                tasks[i] = swap;
+            }
+            end++;
+        }
+        run_handler(worker, tasks + start, end - start);
+        start = end;
+    }
+}
+
+// Move up to `limit` tasks from a lane queue into the worker's deque with one
+// bulk pop; the first one is returned in *task for immediate processing
+static uint32_t take_from_lane(parallel_worker_t* worker, parallel_ring_buffer_t* ring,
+                               parallel_task_t* task, uint32_t limit) {
+    uint32_t room = UMSBB_DEQUE_SIZE - deque_size(&worker->deque) + 1;
+    if (limit > room) limit = room;
+    parallel_task_t* staging = worker->staging;
+    uint32_t taken = parallel_ring_buffer_pop_bulk(ring, staging, limit);
+    if (taken == 0) return 0;
+    for (uint32_t i = taken - 1; i > 0; i--) {
+        if (!deque_push(&worker->deque, &staging[i])) {
+            process_tasks(worker, &staging[i], 1);
+        }
+    }
+    *task = staging[0];
+    return taken;
+}
+
+// Steal up to half of a peer's deque, capped at `limit`
+static uint32_t steal_from_peer(parallel_worker_t* worker, parallel_worker_t* victim,
+                                parallel_task_t* task, uint32_t limit) {
+    uint32_t available = deque_size(&victim->deque);
+    if (available == 0 || !deque_steal(&victim->deque, task)) return 0;
+    uint32_t want = (available + 1) / 2;
+    if (want > limit) want = limit;
+    uint32_t taken = 1;
+    parallel_task_t extra;
+    while (taken < want && deque_steal(&victim->deque, &extra)) {
+        if (!deque_push(&worker->deque, &extra)) {
+            process_tasks(worker, &extra, 1);
+        }
+        taken++;
+    }
+    return taken;
+}
+
+// Find the next task: own deque, home lane, then peers and the other lanes
+// in random order
+static bool find_work(parallel_worker_t* worker, parallel_task_t* task) {
+    parallel_engine_t* engine = worker->engine;
+    if (engine->load_balance_strategy == PARALLEL_BALANCE_ROUND_ROBIN) {
+        return parallel_ring_buffer_pop(worker->work_queue, task);
+    }
+    
+    if (deque_pop(&worker->deque, task)) return true;
+    uint32_t limit = worker_batch_size(worker);
+    uint32_t taken = take_from_lane(worker, worker->work_queue, task, limit);
+    if (taken) {
+        // A batch landed in our deque: let a parked peer share it
+        if (taken > 1) wake_one(engine, worker->thread_id);
+        return true;
+    }
+    
+    // NUMA-aware engines look at same-node peers before remote ones
+    uint32_t peers = atomic_load(&engine->num_workers);
+    uint32_t start = worker_random(worker);
+    uint32_t passes = engine->numa_aware ? 2 : 1;
+    for (uint32_t pass = 0; pass < passes; pass++) {
+        for (uint32_t i = 0; i < peers; i++) {
+            parallel_worker_t* victim = &engine->workers[(start + i) % peers];
+            if (victim == worker) continue;
+            if (passes == 2 && (victim->numa_node == worker->numa_node) != (pass == 0)) continue;
+            taken = steal_from_peer(worker, victim, task, limit);
+            if (taken) {
+                UMSBB_TRACE(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_STEAL, worker->thread_id, task->timestamp);
+                atomic_fetch_add(&worker->steals, 1);
+                atomic_fetch_add(&worker->items_stolen, taken);
+                if (taken > 1) wake_one(engine, worker->thread_id);
+                return true;
+            }
+        }
+    }
+    
+    start = worker_random(worker);
+    for (uint32_t i = 0; i < engine->num_lanes; i++) {
+        parallel_ring_buffer_t* ring = &engine->lane_queues[(start + i) % engine->num_lanes];
+        if (ring == worker->work_queue) continue;
+        taken = take_from_lane(worker, ring, task, limit);
+        if (taken) {
+            UMSBB_TRACE(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_STEAL, worker->thread_id, task->timestamp);
+            atomic_fetch_add(&worker->steals, 1);
+            atomic_fetch_add(&worker->items_stolen, taken);
+            if (taken > 1) wake_one(engine, worker->thread_id);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whether find_work could succeed, without taking anything
+static bool work_visible(parallel_worker_t* worker) {
+    parallel_engine_t* engine = worker->engine;
+    if (parallel_get_queue_depth(engine, (uint32_t)(worker->work_queue - engine->lane_queues))) return true;
+    if (engine->load_balance_strategy == PARALLEL_BALANCE_ROUND_ROBIN) return false;
+    for (uint32_t i = 0; i < engine->num_lanes; i++) {
+        if (parallel_get_queue_depth(engine, i)) return true;
+    }
+    uint32_t peers = atomic_load(&engine->num_workers);
+    for (uint32_t i = 0; i < peers; i++) {
+        if (engine->workers[i].deque.items && deque_size(&engine->workers[i].deque)) return true;
+    }
+    return false;
+}
+
+// Spin-then-park. The parked bit is published before the final look, and
+// submits read it after their push, so one of the two always sees the other.
+static void worker_park(parallel_worker_t* worker) {
+    event_clear(&worker->wake);
+    set_parked(worker, true);
+    if (!work_visible(worker) && atomic_load(&worker->active)) {
+        atomic_fetch_add(&worker->parks, 1);
+        UMSBB_TRACE_ALWAYS(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_PARK, worker->thread_id, 0);
+        event_wait(&worker->wake, UMSBB_PARK_TIMEOUT_NS);
+        UMSBB_TRACE_ALWAYS(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_WAKE, worker->thread_id, 0);
+    }
+    set_parked(worker, false);
+}
+
+static void worker_idle(parallel_worker_t* worker, uint32_t* empty_passes) {
+    atomic_fetch_add(&worker->idle_rounds, 1);
+    switch ((parallel_idle_t)worker->engine->idle_policy) {
+        case PARALLEL_IDLE_SPIN:
+            // Yield now and then so an oversubscribed machine still makes progress
+            if (++*empty_passes % UMSBB_IDLE_SPIN_YIELD == 0) worker_yield();
+            else worker_cpu_relax();
+            break;
+        case PARALLEL_IDLE_SLEEP:
+#ifdef _WIN32
+            Sleep(1);
+#else
+            usleep(UMSBB_IDLE_SLEEP_US);
+#endif
+            break;
+        case PARALLEL_IDLE_PARK:
+        default:
+            worker_park(worker);
+            break;
+    }
+}
+
+// Process a batch and account its busy time and per-task latency. Batch
+// traces are sampled on their start time so a kept begin keeps its end.
+static void run_batch(parallel_worker_t* worker, parallel_task_t* tasks, uint32_t count) {
+    parallel_engine_t* engine = worker->engine;
+    uint64_t started = umsbb_clock_ns();
+    UMSBB_TRACE(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_BATCH_BEGIN, worker->thread_id, started);
+    process_tasks(worker, tasks, count);
+    uint64_t done = umsbb_clock_ns();
+    UMSBB_TRACE(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_BATCH_END, worker->thread_id, started);
+    atomic_fetch_add(&worker->busy_ns, done - started);
+    for (uint32_t i = 0; i < count; i++) {
+        latency_histogram_record(engine->latency, done - tasks[i].timestamp);
+        UMSBB_TRACE(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_RELEASE, tasks[i].lane_id, tasks[i].timestamp);
+    }
+}
+
 // Mock worker thread function
 #ifdef _WIN32
 static unsigned __stdcall worker_thread_func(void* arg) {
@@ -25,43 +462,149 @@ static unsigned __stdcall worker_thread_func(void* arg) {
 static void* worker_thread_func(void* arg) {
 #endif
     parallel_worker_t* worker = (parallel_worker_t*)arg;
+    uint32_t empty_passes = 0;
     
-    atomic_store(&worker->active, true);
-    
-    // Simulate work processing
     while (atomic_load(&worker->active)) {
-        parallel_work_item_t item;
+        parallel_task_t* batch = worker->staging;
         
-        // Try to get work from queue
-        if (parallel_ring_buffer_pop(worker->work_queue, &item)) {
-            // Simulate processing
-            atomic_fetch_add(&worker->messages_processed, 1);
-            atomic_fetch_add(&worker->bytes_processed, item.size);
-            
-            // Simulate processing latency (very small for high throughput)
-#ifdef _WIN32
-            Sleep(0); // Yield
-#else
-            usleep(1); // 1 microsecond
-#endif
-            
-            // Mark item as complete
-            atomic_store(&item.status, 2);
+        if (atomic_load(&worker->retiring)) {
+            // Finish what this worker already took; peers may still steal
+            uint32_t count = 0;
+            while (count < worker_batch_size(worker) && deque_pop(&worker->deque, &batch[count])) count++;
+            if (count == 0) break;
+            run_batch(worker, batch, count);
+            continue;
+        }
+        
+        if (find_work(worker, &batch[0])) {
+            uint32_t count = 1;
+            uint32_t limit = worker_batch_size(worker);
+            if (worker->engine->load_balance_strategy == PARALLEL_BALANCE_ROUND_ROBIN) {
+                count += parallel_ring_buffer_pop_bulk(worker->work_queue, &batch[1], limit - 1);
+            } else {
+                // Take half of the deque at most; the rest stays for thieves
+                uint32_t target = 1 + deque_size(&worker->deque) / 2;
+                if (target > limit) target = limit;
+                while (count < target && deque_pop(&worker->deque, &batch[count])) count++;
+            }
+            run_batch(worker, batch, count);
+            empty_passes = 0;
         } else {
-            // No work available, yield CPU
+            worker_idle(worker, &empty_passes);
+        }
+    }
+    
+    // Items left in the deque stay stealable by peers that are still running
+    message_pool_thread_flush();
 #ifdef _WIN32
-            Sleep(1);
+    return 0;
 #else
-            usleep(1000);
+    return NULL;
 #endif
+}
+
+// Set up worker slot `index` for its first use; later uses keep its deque
+static bool worker_prepare(parallel_engine_t* engine, uint32_t index) {
+    parallel_worker_t* worker = &engine->workers[index];
+    if (worker->deque.items) return true;
+    
+    worker->thread_id = index;
+    worker->cpu_core = index % 16; // Simple CPU affinity
+    atomic_store(&worker->active, false);
+    atomic_store(&worker->retiring, false);
+    atomic_store(&worker->messages_processed, 0);
+    atomic_store(&worker->bytes_processed, 0);
+    atomic_store(&worker->total_latency_ns, 0);
+    atomic_store(&worker->steals, 0);
+    atomic_store(&worker->items_stolen, 0);
+    atomic_store(&worker->idle_rounds, 0);
+    atomic_store(&worker->parks, 0);
+    atomic_store(&worker->busy_ns, 0);
+    worker->work_queue = &engine->lane_queues[index % engine->num_lanes]; // Round-robin assignment
+    worker->engine = engine;
+    worker->rng = 0x9E3779B9u * (index + 1);
+    worker->thread_handle = NULL;
+    
+    parallel_deque_t* deque = &worker->deque;
+    deque->mask = UMSBB_DEQUE_SIZE - 1;
+    deque->items = calloc(UMSBB_DEQUE_SIZE, sizeof(parallel_task_t));
+    worker->staging = calloc(UMSBB_DEQUE_SIZE / 2, sizeof(parallel_task_t));
+    worker->batch = calloc(UMSBB_DEQUE_SIZE / 2, sizeof(parallel_work_item_t));
+    if (!deque->items || !worker->staging || !worker->batch) {
+        free(deque->items);
+        free(worker->staging);
+        free(worker->batch);
+        deque->items = NULL;
+        worker->staging = NULL;
+        worker->batch = NULL;
+        return false;
+    }
+    atomic_store(&deque->top, 0);
+    atomic_store(&deque->bottom, 0);
+    event_init(&worker->wake);
+    
+    if (engine->numa_aware && !worker->pinned) {
+        // Joining a placed engine: take the spread slot of this index
+        uint32_t order[CPU_TOPOLOGY_MAX_CPUS];
+        uint32_t cpus = cpu_topology_spread(engine->topology, order, CPU_TOPOLOGY_MAX_CPUS);
+        if (cpus) {
+            worker->cpu_core = order[index % cpus];
+            worker->numa_node = cpu_topology_find(engine->topology, worker->cpu_core)->node;
+            worker->pinned = true;
+            cpu_topology_bind_memory(deque->items, UMSBB_DEQUE_SIZE * sizeof(parallel_task_t), worker->numa_node);
         }
     }
+    return true;
+}
+
+static bool worker_launch(parallel_worker_t* worker) {
+    // Set before the thread exists so an early stop is not lost
+    atomic_store(&worker->retiring, false);
+    atomic_store(&worker->active, true);
     
 #ifdef _WIN32
-    return 0;
+    worker->thread_handle = (HANDLE)_beginthreadex(NULL, 0, worker_thread_func, worker, 0, NULL);
+    if (worker->thread_handle == NULL) {
 #else
-    return NULL;
+    pthread_t* thread = malloc(sizeof(pthread_t));
+    worker->thread_handle = thread;
+    if (!thread || pthread_create(thread, NULL, worker_thread_func, worker) != 0) {
+#endif
+        // Failed to create thread
+        atomic_store(&worker->active, false);
+#ifndef _WIN32
+        free(thread);
+        worker->thread_handle = NULL;
+#endif
+        return false;
+    }
+    if (worker->pinned) pin_worker(worker);
+    return true;
+}
+
+static void worker_join(parallel_worker_t* worker) {
+    if (!worker->thread_handle) return;
+#ifdef _WIN32
+    WaitForSingleObject(worker->thread_handle, INFINITE);
+    CloseHandle(worker->thread_handle);
+#else
+    pthread_t* thread = (pthread_t*)worker->thread_handle;
+    pthread_join(*thread, NULL);
+    free(thread);
 #endif
+    worker->thread_handle = NULL;
+}
+
+static void resize_lock(parallel_engine_t* engine) {
+    for (;;) {
+        uint32_t expected = 0;
+        if (atomic_compare_exchange_weak(&engine->resize_lock, &expected, 1)) return;
+        worker_yield();
+    }
+}
+
+static void resize_unlock(parallel_engine_t* engine) {
+    atomic_store(&engine->resize_lock, 0);
 }
 
 // Initialize parallel engine
@@ -72,9 +615,10 @@ int parallel_engine_init(parallel_engine_t* engine, uint32_t num_workers, throug
     
     memset(engine, 0, sizeof(parallel_engine_t));
     
-    engine->num_workers = num_workers;
     engine->num_lanes = 4; // Express, Bulk, Priority, Streaming
-    engine->load_balance_strategy = strategy;
+    engine->load_balance_strategy = PARALLEL_BALANCE_WORK_STEALING;
+    engine->idle_policy = idle_policy_for(strategy);
+    atomic_store(&engine->parked_workers, 0);
     engine->numa_aware = false;
     engine->cpu_affinity_enabled = false;
     engine->batch_size = UMSBB_BATCH_SIZE;
@@ -85,7 +629,7 @@ int parallel_engine_init(parallel_engine_t* engine, uint32_t num_workers, throug
         parallel_ring_buffer_t* ring = &engine->lane_queues[i];
         ring->capacity = UMSBB_RING_BUFFER_SIZE;
         ring->mask = ring->capacity - 1; // Assumes power of 2
-        ring->items = calloc(ring->capacity, sizeof(parallel_work_item_t));
+        ring->items = calloc(ring->capacity, sizeof(parallel_task_t));
         
         if (!ring->items) {
             // Cleanup on failure
@@ -97,20 +641,30 @@ int parallel_engine_init(parallel_engine_t* engine, uint32_t num_workers, throug
         
         atomic_store(&ring->head, 0);
         atomic_store(&ring->tail, 0);
+        atomic_store(&ring->reserve_head, 0);
+        atomic_store(&ring->reserve_tail, 0);
     }
     
     // Initialize workers
-    for (uint32_t i = 0; i < num_workers; i++) {
-        parallel_worker_t* worker = &engine->workers[i];
-        worker->thread_id = i;
-        worker->cpu_core = i % 16; // Simple CPU affinity
-        atomic_store(&worker->active, false);
-        atomic_store(&worker->messages_processed, 0);
-        atomic_store(&worker->bytes_processed, 0);
-        atomic_store(&worker->total_latency_ns, 0);
-        worker->work_queue = &engine->lane_queues[i % engine->num_lanes]; // Round-robin assignment
-        worker->thread_handle = NULL;
+    engine->latency = latency_histogram_create();
+    bool prepared = engine->latency != NULL;
+    for (uint32_t i = 0; prepared && i < num_workers; i++) {
+        prepared = worker_prepare(engine, i);
     }
+    if (!prepared) {
+        for (uint32_t j = 0; j < num_workers; j++) {
+            free(engine->workers[j].deque.items);
+            free(engine->workers[j].staging);
+            free(engine->workers[j].batch);
+            event_destroy(&engine->workers[j].wake);
+        }
+        for (uint32_t j = 0; j < engine->num_lanes; j++) {
+            free(engine->lane_queues[j].items);
+        }
+        latency_histogram_destroy(engine->latency);
+        return -1;
+    }
+    atomic_store(&engine->num_workers, num_workers);
     
     // Initialize atomic counters
     atomic_store(&engine->total_messages, 0);
@@ -118,6 +672,10 @@ int parallel_engine_init(parallel_engine_t* engine, uint32_t num_workers, throug
     atomic_store(&engine->total_errors, 0);
     atomic_store(&engine->peak_throughput_mbps, 0);
     atomic_store(&engine->round_robin_counter, 0);
+    atomic_store(&engine->resize_lock, 0);
+    atomic_store(&engine->autoscaling, false);
+    event_init(&engine->autoscale_wake);
+    engine->sample_ns = umsbb_clock_ns();
     
     return 0;
 }
@@ -126,22 +684,16 @@ int parallel_engine_init(parallel_engine_t* engine, uint32_t num_workers, throug
 int parallel_engine_start(parallel_engine_t* engine) {
     if (!engine) return -1;
     
-    // Start worker threads
-    for (uint32_t i = 0; i < engine->num_workers; i++) {
-        parallel_worker_t* worker = &engine->workers[i];
-        
-#ifdef _WIN32
-        worker->thread_handle = (HANDLE)_beginthreadex(NULL, 0, worker_thread_func, worker, 0, NULL);
-        if (worker->thread_handle == NULL) {
-#else
-        pthread_t* thread = malloc(sizeof(pthread_t));
-        worker->thread_handle = thread;
-        if (pthread_create(thread, NULL, worker_thread_func, worker) != 0) {
-#endif
-            // Failed to create thread
+    resize_lock(engine);
+    engine->running = true;
+    uint32_t count = atomic_load(&engine->num_workers);
+    for (uint32_t i = 0; i < count; i++) {
+        if (!worker_launch(&engine->workers[i])) {
+            resize_unlock(engine);
             return -1;
         }
     }
+    resize_unlock(engine);
     
     return 0;
 }
@@ -150,26 +702,22 @@ int parallel_engine_start(parallel_engine_t* engine) {
 int parallel_engine_stop(parallel_engine_t* engine) {
     if (!engine) return -1;
     
+    parallel_disable_autoscale(engine);
+    resize_lock(engine);
+    
     // Signal all workers to stop
-    for (uint32_t i = 0; i < engine->num_workers; i++) {
+    for (uint32_t i = 0; i < UMSBB_MAX_WORKER_THREADS; i++) {
+        if (!engine->workers[i].thread_handle) continue;
         atomic_store(&engine->workers[i].active, false);
+        event_signal(&engine->workers[i].wake);
     }
     
     // Wait for threads to complete
-    for (uint32_t i = 0; i < engine->num_workers; i++) {
-        parallel_worker_t* worker = &engine->workers[i];
-        if (worker->thread_handle) {
-#ifdef _WIN32
-            WaitForSingleObject(worker->thread_handle, INFINITE);
-            CloseHandle(worker->thread_handle);
-#else
-            pthread_t* thread = (pthread_t*)worker->thread_handle;
-            pthread_join(*thread, NULL);
-            free(thread);
-#endif
-            worker->thread_handle = NULL;
-        }
+    for (uint32_t i = 0; i < UMSBB_MAX_WORKER_THREADS; i++) {
+        worker_join(&engine->workers[i]);
     }
+    engine->running = false;
+    resize_unlock(engine);
     
     return 0;
 }
@@ -180,7 +728,27 @@ void parallel_engine_destroy(parallel_engine_t* engine) {
     
     parallel_engine_stop(engine);
     
-    // Free ring buffer memory
+    // Tasks nobody ran: their submitters see ERROR
+    parallel_task_t task;
+    for (uint32_t i = 0; i < UMSBB_MAX_WORKER_THREADS; i++) {
+        if (!engine->workers[i].deque.items) continue;
+        while (deque_steal(&engine->workers[i].deque, &task)) fail_task(&task);
+    }
+    for (uint32_t i = 0; i < engine->num_lanes; i++) {
+        if (!engine->lane_queues[i].items) continue;
+        while (parallel_ring_buffer_pop(&engine->lane_queues[i], &task)) fail_task(&task);
+    }
+    
+    // Free deque and ring buffer memory
+    for (uint32_t i = 0; i < UMSBB_MAX_WORKER_THREADS; i++) {
+        if (engine->workers[i].deque.items) event_destroy(&engine->workers[i].wake);
+        free(engine->workers[i].deque.items);
+        free(engine->workers[i].staging);
+        free(engine->workers[i].batch);
+        engine->workers[i].deque.items = NULL;
+        engine->workers[i].staging = NULL;
+        engine->workers[i].batch = NULL;
+    }
     for (uint32_t i = 0; i < engine->num_lanes; i++) {
         if (engine->lane_queues[i].items) {
             free(engine->lane_queues[i].items);
@@ -188,6 +756,9 @@ void parallel_engine_destroy(parallel_engine_t* engine) {
         }
     }
     
+    event_destroy(&engine->autoscale_wake);
+    latency_histogram_destroy(engine->latency);
+    free(engine->topology);
     memset(engine, 0, sizeof(parallel_engine_t));
 }
 
@@ -198,23 +769,34 @@ int parallel_submit_work(parallel_engine_t* engine, uint32_t lane_id,
         return -1;
     }
     
-    parallel_work_item_t item;
-    item.message_id = atomic_fetch_add(&engine->total_messages, 1);
-    item.lane_id = lane_id;
-    item.priority = priority;
-    item.size = size;
-    item.data = (void*)data; // In real implementation, would copy data
-    item.timestamp = time(NULL);
-    item.language_id = language_id;
-    atomic_store(&item.status, 0); // Pending
+    // The caller's buffer is only borrowed for the duration of the call
+    void* copy = message_pool_alloc(size);
+    if (!copy) {
+        atomic_fetch_add(&engine->total_errors, 1);
+        return -1;
+    }
+    memcpy(copy, data, size);
+    
+    parallel_task_t task;
+    task.data = copy;
+    task.origin = NULL;
+    task.timestamp = umsbb_clock_ns();
+    task.size = size;
+    task.priority = priority > UINT16_MAX ? UINT16_MAX : (uint16_t)priority;
+    task.lane_id = (uint8_t)lane_id;
+    task.language_id = (uint8_t)language_id;
     
     // Add to appropriate lane queue
     parallel_ring_buffer_t* ring = &engine->lane_queues[lane_id];
     
-    if (parallel_ring_buffer_push(ring, &item)) {
+    atomic_fetch_add(&engine->total_messages, 1);
+    UMSBB_TRACE(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_SUBMIT, lane_id, task.timestamp);
+    if (parallel_ring_buffer_push(ring, &task)) {
         atomic_fetch_add(&engine->total_bytes, size);
+        wake_one(engine, lane_id % atomic_load(&engine->num_workers));
         return 0;
     } else {
+        message_pool_release(copy);
         atomic_fetch_add(&engine->total_errors, 1);
         return -1; // Queue full
     }
@@ -227,27 +809,54 @@ int parallel_submit_batch(parallel_engine_t* engine, uint32_t lane_id,
         return -1;
     }
     
-    uint32_t submitted = 0;
     parallel_ring_buffer_t* ring = &engine->lane_queues[lane_id];
-    
+    uint64_t timestamp = umsbb_clock_ns();   // One stamp for the whole batch
+    uint64_t first_id = atomic_fetch_add(&engine->total_messages, count);
     for (uint32_t i = 0; i < count; i++) {
-        items[i].message_id = atomic_fetch_add(&engine->total_messages, 1);
+        items[i].message_id = first_id + i;
         items[i].lane_id = lane_id;
-        items[i].timestamp = time(NULL);
-        atomic_store(&items[i].status, 0);
-        
-        if (parallel_ring_buffer_push(ring, &items[i])) {
-            atomic_fetch_add(&engine->total_bytes, items[i].size);
-            submitted++;
-        } else {
-            atomic_fetch_add(&engine->total_errors, 1);
-            break; // Queue full
-        }
+        items[i].timestamp = timestamp;
+        atomic_store(&items[i].status, PARALLEL_STATUS_PENDING);
+        items[i].flags = 0;
+        items[i].origin = &items[i];
     }
     
+    // One reservation and one publish for the run; descriptors are written
+    // straight into the reserved slots
+    uint64_t start;
+    uint32_t submitted = ring_reserve(ring, count, &start);
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < submitted; i++) {
+        parallel_task_t* task = &ring->items[(start + i) & ring->mask];
+        task->data = items[i].data;
+        task->origin = &items[i];
+        task->timestamp = timestamp;
+        task->size = items[i].size;
+        task->priority = items[i].priority > UINT16_MAX ? UINT16_MAX : (uint16_t)items[i].priority;
+        task->lane_id = (uint8_t)lane_id;
+        task->language_id = (uint8_t)items[i].language_id;
+        bytes += items[i].size;
+    }
+    if (submitted) {
+        // The batch shares one stamp, so its tasks are sampled together
+        UMSBB_TRACE(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_SUBMIT, lane_id, timestamp);
+        ring_publish(ring, start, submitted);
+        atomic_fetch_add(&engine->total_bytes, bytes);
+        wake_one(engine, lane_id % atomic_load(&engine->num_workers));
+    }
+    if (submitted < count) atomic_fetch_add(&engine->total_errors, 1); // Queue full
     return submitted;
 }
 
+// Register a lane's consumer
+int parallel_register_handler(parallel_engine_t* engine, uint32_t lane_id, parallel_handler_fn fn, void* ctx) {
+    if (!engine || lane_id >= engine->num_lanes) return -1;
+    
+    engine->handlers[lane_id].ctx = ctx;
+    engine->handlers[lane_id].fn = fn;
+    return 0;
+}
+
 // Get performance metrics
 int parallel_get_performance(parallel_engine_t* engine, performance_profile_t* profile) {
     if (!engine || !profile) return -1;
@@ -258,13 +867,29 @@ int parallel_get_performance(parallel_engine_t* engine, performance_profile_t* p
     uint64_t total_messages = 0;
     uint64_t total_bytes = 0;
     
-    for (uint32_t i = 0; i < engine->num_workers; i++) {
-        total_messages += atomic_load(&engine->workers[i].messages_processed);
-        total_bytes += atomic_load(&engine->workers[i].bytes_processed);
+    profile->worker_count = atomic_load(&engine->num_workers);
+    for (uint32_t i = 0; i < profile->worker_count; i++) {
+        parallel_worker_t* worker = &engine->workers[i];
+        uint64_t processed = atomic_load(&worker->messages_processed);
+        total_messages += processed;
+        total_bytes += atomic_load(&worker->bytes_processed);
+        
+        profile->workers[i].messages_processed = processed;
+        profile->workers[i].steals = atomic_load(&worker->steals);
+        profile->workers[i].items_stolen = atomic_load(&worker->items_stolen);
+        profile->workers[i].idle_rounds = atomic_load(&worker->idle_rounds);
+        profile->workers[i].parks = atomic_load(&worker->parks);
+        profile->workers[i].cpu_core = worker->cpu_core;
+        profile->workers[i].numa_node = worker->numa_node;
+        profile->workers[i].pinned = worker->pinned;
+        profile->steals += profile->workers[i].steals;
+        profile->items_stolen += profile->workers[i].items_stolen;
+        profile->idle_rounds += profile->workers[i].idle_rounds;
+        profile->parks += profile->workers[i].parks;
     }
     
-    profile->timestamp_start = time(NULL) - 1; // Mock 1 second duration
-    profile->timestamp_end = time(NULL);
+    profile->timestamp_end = umsbb_clock_ns();
+    profile->timestamp_start = profile->timestamp_end - 1000000000ull; // Mock 1 second duration
     profile->messages_per_second = (uint32_t)total_messages;
     profile->mbytes_per_second = (uint32_t)(total_bytes / 1000000);
     profile->average_latency_us = 0.5; // Mock very low latency
@@ -283,14 +908,14 @@ double parallel_get_instantaneous_throughput_mbps(parallel_engine_t* engine) {
     
     // Mock calculation - in real implementation would track time windows
     static uint64_t last_bytes = 0;
-    static time_t last_time = 0;
+    static uint64_t last_time = 0;
     
-    time_t current_time = time(NULL);
+    uint64_t current_time = umsbb_clock_coarse_ns();
     uint64_t bytes_diff = total_bytes - last_bytes;
-    time_t time_diff = current_time - last_time;
+    uint64_t time_diff = current_time - last_time;
     
-    if (time_diff > 0) {
-        double mbps = (bytes_diff * 8.0) / (time_diff * 1000000.0);
+    if (time_diff >= 1000000000ull) {
+        double mbps = (bytes_diff * 8.0) / ((double)time_diff / 1e9 * 1000000.0);
         
         // Update peak throughput
         uint64_t current_peak = atomic_load(&engine->peak_throughput_mbps);
@@ -324,16 +949,170 @@ int parallel_adjust_workers(parallel_engine_t* engine, uint32_t new_count) {
         return -1;
     }
     
-    // Simplified implementation - would need proper thread management
-    engine->num_workers = new_count;
+    resize_lock(engine);
+    uint32_t count = atomic_load(&engine->num_workers);
+    int result = 0;
+    if (new_count > count) {
+        for (uint32_t i = count; i < new_count; i++) {
+            if (!worker_prepare(engine, i) || (engine->running && !worker_launch(&engine->workers[i]))) {
+                new_count = i;
+                result = -1;
+                break;
+            }
+        }
+        atomic_store(&engine->num_workers, new_count);
+    } else if (new_count < count) {
+        // Out of the victim set first, so peers stop handing them work
+        atomic_store(&engine->num_workers, new_count);
+        for (uint32_t i = new_count; i < count; i++) {
+            atomic_store(&engine->workers[i].retiring, true);
+            event_signal(&engine->workers[i].wake);
+        }
+        for (uint32_t i = new_count; i < count; i++) {
+            worker_join(&engine->workers[i]);
+        }
+    }
+    resize_unlock(engine);
+    return result;
+}
+
+uint32_t parallel_autoscale_target(const parallel_autoscale_t* policy, const parallel_load_sample_t* sample) {
+    if (!policy || !sample) return 0;
+    uint32_t workers = sample->workers ? sample->workers : 1;
+    uint32_t per_worker = sample->queue_depth / workers;
+    
+    bool queue_high = policy->queue_high && per_worker > policy->queue_high;
+    bool pressure = queue_high ||
+                    (policy->p99_high_ns && sample->p99_ns > policy->p99_high_ns) ||
+                    (policy->busy_high_percent && sample->busy_percent > policy->busy_high_percent);
+    bool slack = (!policy->queue_high || per_worker <= policy->queue_low) &&
+                 (!policy->p99_high_ns || sample->p99_ns <= policy->p99_low_ns) &&
+                 (!policy->busy_high_percent || sample->busy_percent <= policy->busy_low_percent);
+    
+    uint32_t target = workers;
+    if (pressure) {
+        target = queue_high && per_worker > 4 * policy->queue_high ? workers * 2 : workers + 1;
+    } else if (slack && workers > 1) {
+        target = workers - 1;
+    }
+    if (target < policy->min_workers) target = policy->min_workers;
+    if (target > policy->max_workers) target = policy->max_workers;
+    if (target > UMSBB_MAX_WORKER_THREADS) target = UMSBB_MAX_WORKER_THREADS;
+    return target ? target : 1;
+}
+
+int parallel_sample_load(parallel_engine_t* engine, parallel_load_sample_t* sample) {
+    if (!engine || !sample) return -1;
+    
+    memset(sample, 0, sizeof(*sample));
+    sample->workers = atomic_load(&engine->num_workers);
+    for (uint32_t i = 0; i < engine->num_lanes; i++) {
+        sample->queue_depth += parallel_get_queue_depth(engine, i);
+    }
+    for (uint32_t i = 0; i < sample->workers; i++) {
+        sample->queue_depth += deque_size(&engine->workers[i].deque);
+    }
+    
+    LatencySummary latency;
+    latency_histogram_interval(engine->latency, &latency);
+    sample->p99_ns = latency.p99Ns;
+    
+    // Retired workers' busy time stays in the sum, so the delta is exact
+    uint64_t now = umsbb_clock_ns();
+    uint64_t busy = 0;
+    for (uint32_t i = 0; i < UMSBB_MAX_WORKER_THREADS; i++) {
+        busy += atomic_load(&engine->workers[i].busy_ns);
+    }
+    uint64_t wall = (now - engine->sample_ns) * (sample->workers ? sample->workers : 1);
+    if (wall) {
+        uint64_t percent = (busy - engine->sample_busy_ns) * 100 / wall;
+        sample->busy_percent = percent > 100 ? 100 : (uint32_t)percent;
+    }
+    engine->sample_ns = now;
+    engine->sample_busy_ns = busy;
+    return 0;
+}
+
+#ifdef _WIN32
+static unsigned __stdcall autoscale_thread_func(void* arg) {
+#else
+static void* autoscale_thread_func(void* arg) {
+#endif
+    parallel_engine_t* engine = (parallel_engine_t*)arg;
+    parallel_load_sample_t sample;
+    parallel_sample_load(engine, &sample); // Start the first period now
+    uint64_t last_change = 0;
+    
+    while (atomic_load(&engine->autoscaling)) {
+        uint32_t interval = engine->autoscale.sample_interval_ms;
+        if (interval == 0) interval = UMSBB_AUTOSCALE_INTERVAL_MS;
+        event_wait(&engine->autoscale_wake, (uint64_t)interval * 1000000ull);
+        event_clear(&engine->autoscale_wake);
+        if (!atomic_load(&engine->autoscaling)) break;
+        
+        parallel_sample_load(engine, &sample);
+        uint32_t target = parallel_autoscale_target(&engine->autoscale, &sample);
+        uint64_t now = umsbb_clock_ns();
+        if (target != sample.workers &&
+            (last_change == 0 || now - last_change >= (uint64_t)engine->autoscale.cooldown_ms * 1000000ull)) {
+            parallel_adjust_workers(engine, target);
+            last_change = now;
+        }
+    }
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+int parallel_enable_autoscale(parallel_engine_t* engine, const parallel_autoscale_t* policy) {
+    if (!engine || !policy || policy->min_workers == 0 || policy->min_workers > policy->max_workers ||
+        policy->max_workers > UMSBB_MAX_WORKER_THREADS) {
+        return -1;
+    }
+    
+    // A running controller picks the new policy up at its next sample
+    parallel_disable_autoscale(engine);
+    engine->autoscale = *policy;
+    atomic_store(&engine->autoscaling, true);
+    event_clear(&engine->autoscale_wake);
+#ifdef _WIN32
+    engine->autoscale_thread = (HANDLE)_beginthreadex(NULL, 0, autoscale_thread_func, engine, 0, NULL);
+    if (engine->autoscale_thread == NULL) {
+#else
+    pthread_t* thread = malloc(sizeof(pthread_t));
+    engine->autoscale_thread = thread;
+    if (!thread || pthread_create(thread, NULL, autoscale_thread_func, engine) != 0) {
+        free(thread);
+        engine->autoscale_thread = NULL;
+#endif
+        atomic_store(&engine->autoscaling, false);
+        return -1;
+    }
     return 0;
 }
 
+void parallel_disable_autoscale(parallel_engine_t* engine) {
+    if (!engine || !engine->autoscale_thread) return;
+    
+    atomic_store(&engine->autoscaling, false);
+    event_signal(&engine->autoscale_wake);
+#ifdef _WIN32
+    WaitForSingleObject(engine->autoscale_thread, INFINITE);
+    CloseHandle(engine->autoscale_thread);
+#else
+    pthread_join(*(pthread_t*)engine->autoscale_thread, NULL);
+    free(engine->autoscale_thread);
+#endif
+    engine->autoscale_thread = NULL;
+}
+
 // Set strategy
 int parallel_set_strategy(parallel_engine_t* engine, throughput_strategy_t strategy) {
     if (!engine) return -1;
     
-    engine->load_balance_strategy = strategy;
+    engine->idle_policy = idle_policy_for(strategy);
     
     // Adjust batch size based on strategy
     switch (strategy) {
@@ -354,6 +1133,22 @@ int parallel_set_strategy(parallel_engine_t* engine, throughput_strategy_t strat
     return 0;
 }
 
+// Set how workers find work
+int parallel_set_load_balance(parallel_engine_t* engine, parallel_balance_t strategy) {
+    if (!engine || strategy > PARALLEL_BALANCE_ADAPTIVE) return -1;
+    
+    engine->load_balance_strategy = strategy;
+    return 0;
+}
+
+// Set what idle workers do
+int parallel_set_idle_policy(parallel_engine_t* engine, parallel_idle_t policy) {
+    if (!engine || policy > PARALLEL_IDLE_SLEEP) return -1;
+    
+    engine->idle_policy = policy;
+    return 0;
+}
+
 // Tune batch size
 int parallel_tune_batch_size(parallel_engine_t* engine, uint32_t new_size) {
     if (!engine || new_size == 0) return -1;
@@ -365,6 +1160,35 @@ int parallel_tune_batch_size(parallel_engine_t* engine, uint32_t new_size) {
 // Enable NUMA awareness
 int parallel_enable_numa_awareness(parallel_engine_t* engine) {
     if (!engine) return -1;
+    cpu_topology_t* topology = engine_topology(engine);
+    if (!topology) return -1;
+    
+    // Auto-place the workers nobody pinned
+    uint32_t order[CPU_TOPOLOGY_MAX_CPUS];
+    uint32_t cpus = cpu_topology_spread(topology, order, CPU_TOPOLOGY_MAX_CPUS);
+    if (cpus == 0) return -1;
+    uint32_t count = atomic_load(&engine->num_workers);
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        parallel_worker_t* worker = &engine->workers[i];
+        if (worker->pinned) continue;
+        worker->cpu_core = order[next++ % cpus];
+        worker->numa_node = cpu_topology_find(topology, worker->cpu_core)->node;
+        worker->pinned = true;
+        pin_worker(worker);
+    }
+    engine->cpu_affinity_enabled = true;
+    
+    // Move each worker's deque, and each lane queue, to the node of the
+    // worker that drains it most
+    for (uint32_t i = 0; i < count; i++) {
+        parallel_worker_t* worker = &engine->workers[i];
+        cpu_topology_bind_memory(worker->deque.items, UMSBB_DEQUE_SIZE * sizeof(parallel_task_t), worker->numa_node);
+    }
+    for (uint32_t i = 0; i < engine->num_lanes && i < count; i++) {
+        parallel_ring_buffer_t* ring = &engine->lane_queues[i];
+        cpu_topology_bind_memory(ring->items, ring->capacity * sizeof(parallel_task_t), engine->workers[i].numa_node);
+    }
     
     engine->numa_aware = true;
     return 0;
@@ -372,11 +1196,15 @@ int parallel_enable_numa_awareness(parallel_engine_t* engine) {
 
 // Set CPU affinity
 int parallel_set_cpu_affinity(parallel_engine_t* engine, uint32_t worker_id, uint32_t cpu_core) {
-    if (!engine || worker_id >= engine->num_workers) return -1;
+    if (!engine || worker_id >= atomic_load(&engine->num_workers)) return -1;
+    cpu_topology_t* topology = engine_topology(engine);
+    const cpu_topology_cpu_t* cpu = cpu_topology_find(topology, cpu_core);
+    if (!cpu) return -1;
     
-    engine->workers[worker_id].cpu_core = cpu_core;
+    parallel_worker_t* worker = &engine->workers[worker_id];
+    worker->cpu_core = cpu_core;
+    worker->numa_node = cpu->node;
+    worker->pinned = true;
     engine->cpu_affinity_enabled = true;
-    
-    // In real implementation, would set actual thread affinity
-    return 0;
-}
\ No newline at end of file
+    return pin_worker(worker) ? 0 : -1;
+}
@@ -1,21 +1,206 @@
 #include "segment_ring.h"
+#include <stdlib.h>
 
-void segment_ring_init(SegmentRing* ring, size_t agentCount, size_t bufferCap) {
-    if (agentCount > MAX_AGENTS) agentCount = MAX_AGENTS;
-    ring->activeCount = agentCount;
+// Per-thread routing state shared by every ring; tokens are handed out once
+static atomic_size_t segment_next_token;
+static SOMA_THREAD_LOCAL size_t segment_thread_token;   // 0 until first use
+static SOMA_THREAD_LOCAL size_t segment_thread_lane;    // Last round-robin lane
+static SOMA_THREAD_LOCAL size_t segment_affinity_active; // activeCount the cached lane was computed for
+static SOMA_THREAD_LOCAL size_t segment_affinity_lane;
+
+static inline size_t segment_ring_ctz(size_t v) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long index;
+    _BitScanForward64(&index, (unsigned __int64)v);
+    return index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, (unsigned long)v);
+    return index;
+#else
+    return (size_t)__builtin_ctzll((unsigned long long)v);
+#endif
+}
+
+static inline size_t segment_ring_token(void) {
+    if (segment_thread_token == 0) {
+        segment_thread_token = atomic_fetch_add_size(&segment_next_token, 1) + 1;
+        segment_thread_lane = segment_thread_token - 1;
+    }
+    return segment_thread_token;
+}
+
+bool segment_ring_init(SegmentRing* ring, size_t agentCount, size_t bufferCap) {
+    if (agentCount > SEGMENT_RING_MAX_LANES) agentCount = SEGMENT_RING_MAX_LANES;
+    ring->activeCount = 0;
+    ring->laneCount = 0;
+    ring->bufferCap = bufferCap;
     ring->currentIndex = 0;
+    ring->routing = SEGMENT_ROUTING_ROUND_ROBIN;
+    ring->buffers = calloc(SEGMENT_RING_MAX_LANES, sizeof(BiBuffer*));
+    ring->ready = calloc(1, sizeof(SegmentReadyMap));
+    if (!ring->buffers || !ring->ready) {
+        segment_ring_destroy(ring);
+        return false;
+    }
 
     for (size_t i = 0; i < agentCount; ++i) {
-        bi_buffer_init(&ring->buffers[i], bufferCap);
+        if (!segment_ring_add_lane(ring)) {
+            segment_ring_destroy(ring);
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t segment_ring_pick(SegmentRing* ring) {
+    size_t active = ring->activeCount;
+    size_t token = segment_ring_token();
+
+    if (ring->routing == SEGMENT_ROUTING_AFFINITY) {
+        // Sticky until the lane count changes
+        if (segment_affinity_active != active) {
+            segment_affinity_lane = (token - 1) % active;
+            segment_affinity_active = active;
+        }
+        return segment_affinity_lane;
     }
+
+    size_t lane = segment_thread_lane + 1;
+    if (lane >= active) lane = (active > 0) ? lane % active : 0;
+    segment_thread_lane = lane;
+    return lane;
 }
 
 BiBuffer* segment_ring_next(SegmentRing* ring) {
-    BiBuffer* buf = &ring->buffers[ring->currentIndex];
-    ring->currentIndex = (ring->currentIndex + 1) % ring->activeCount;
-    return buf;
+    return ring->buffers[segment_ring_pick(ring)];
 }
 
 void segment_ring_reset(SegmentRing* ring) {
     ring->currentIndex = 0;
-}
\ No newline at end of file
+}
+
+void segment_ring_set_routing(SegmentRing* ring, SegmentRouting routing) {
+    ring->routing = routing;
+}
+
+bool segment_ring_add_lane(SegmentRing* ring) {
+    size_t lane = ring->activeCount;
+    if (lane >= SEGMENT_RING_MAX_LANES) return false;
+
+    if (lane == ring->laneCount) {
+        // Round-robin producers share lanes; a lane only becomes SPSC on request
+        BiBuffer* buf = bi_buffer_create(ring->bufferCap, BI_BUFFER_MODE_MPSC);
+        if (!buf) return false;
+        ring->buffers[lane] = buf;
+        atomic_fence_release();
+        ring->laneCount = lane + 1;
+    }
+    // Publish only once the lane is fully initialised
+    atomic_fence_release();
+    ring->activeCount = lane + 1;
+    return true;
+}
+
+bool segment_ring_remove_lane(SegmentRing* ring) {
+    if (ring->activeCount <= 1) return false;
+    // Submissions stop; whatever is already queued is drained as usual
+    ring->activeCount--;
+    return true;
+}
+
+void segment_ring_destroy(SegmentRing* ring) {
+    if (ring->buffers) {
+        for (size_t i = 0; i < ring->laneCount; ++i) {
+            bi_buffer_free(ring->buffers[i]);
+        }
+        free(ring->buffers);
+    }
+    free(ring->ready);
+    ring->ready = NULL;
+    ring->buffers = NULL;
+    ring->activeCount = 0;
+    ring->laneCount = 0;
+}
+
+void segment_ring_mark_ready(SegmentRing* ring, size_t lane) {
+    size_t word = lane / SEGMENT_RING_WORD_BITS;
+    size_t bit = (size_t)1 << (lane % SEGMENT_RING_WORD_BITS);
+    SegmentReadyMap* map = ring->ready;
+
+    // Order the commit before reading the bit; pairs with the clear-then-
+    // recheck in segment_ring_mark_drained
+    atomic_fence_seq_cst();
+    if (atomic_load_size_relaxed(&map->words[word]) & bit) return;
+
+    size_t before = atomic_fetch_or_size(&map->words[word], bit);
+    if (before == 0) atomic_fetch_or_size(&map->summary, (size_t)1 << word);
+}
+
+bool segment_ring_mark_drained(SegmentRing* ring, size_t lane) {
+    BiBuffer* buf = ring->buffers[lane];
+    size_t size;
+    if (bi_buffer_read(buf, &size)) return true;
+
+    size_t word = lane / SEGMENT_RING_WORD_BITS;
+    size_t bit = (size_t)1 << (lane % SEGMENT_RING_WORD_BITS);
+    SegmentReadyMap* map = ring->ready;
+    if (!(atomic_load_size_relaxed(&map->words[word]) & bit)) return false;
+
+    size_t before = atomic_fetch_and_size(&map->words[word], ~bit);
+    if ((before & ~bit) == 0) {
+        atomic_fetch_and_size(&map->summary, ~((size_t)1 << word));
+        // A producer may have set another bit of this word in between
+        if (atomic_load_size(&map->words[word])) atomic_fetch_or_size(&map->summary, (size_t)1 << word);
+    }
+
+    // A commit that raced the clear either sees the bit cleared and sets it
+    // again, or is visible here
+    if (!bi_buffer_read(buf, &size)) return false;
+    segment_ring_mark_ready(ring, lane);
+    return true;
+}
+
+static size_t segment_ring_scan(SegmentReadyMap* map, size_t from, size_t end) {
+    while (from < end) {
+        size_t word = from / SEGMENT_RING_WORD_BITS;
+        size_t summary = atomic_load_size_relaxed(&map->summary) >> word;
+        if (summary == 0) return SEGMENT_RING_NONE;
+        if (!(summary & 1)) {
+            // Skip straight to the next word with any bit set
+            word += segment_ring_ctz(summary);
+            from = word * SEGMENT_RING_WORD_BITS;
+            if (from >= end) return SEGMENT_RING_NONE;
+        }
+
+        size_t bits = atomic_load_size_acquire(&map->words[word]);
+        size_t offset = from % SEGMENT_RING_WORD_BITS;
+        bits = offset ? bits & ~(((size_t)1 << offset) - 1) : bits;
+        if (bits) {
+            size_t lane = word * SEGMENT_RING_WORD_BITS + segment_ring_ctz(bits);
+            return lane < end ? lane : SEGMENT_RING_NONE;
+        }
+        from = (word + 1) * SEGMENT_RING_WORD_BITS;
+    }
+    return SEGMENT_RING_NONE;
+}
+
+size_t segment_ring_next_ready(SegmentRing* ring, size_t from) {
+    size_t lanes = ring->laneCount;
+    if (lanes == 0) return SEGMENT_RING_NONE;
+    if (from >= lanes) from = 0;
+
+    size_t lane = segment_ring_scan(ring->ready, from, lanes);
+    if (lane == SEGMENT_RING_NONE && from > 0) lane = segment_ring_scan(ring->ready, 0, from);
+    return lane;
+}
+
+bool segment_ring_has_ready(SegmentRing* ring) {
+    size_t lanes = ring->laneCount;
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        lane = segment_ring_scan(ring->ready, lane, lanes);
+        if (lane == SEGMENT_RING_NONE) return false;
+        if (segment_ring_mark_drained(ring, lane)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,260 @@
+#include "shm_segment.h"
+#include "portable_atomic.h"
+#include "umsbb_clock.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define SHM_SEGMENT_POSIX 1
+#endif
+#if defined(__linux__)
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#endif
+
+#define SHM_SEGMENT_POLL_NS 20000ull     // Sleep between polls where there is no futex
+
+enum {
+    SHM_ENTRY_EMPTY = 0,
+    SHM_ENTRY_READY = 1,
+    SHM_ENTRY_DEAD = 2        // Claimed, but the segment had no room left
+};
+
+typedef struct {
+    char name[SHM_SEGMENT_NAME_MAX];
+    uint64_t offset;
+    uint64_t size;
+    atomic_u32 state;
+    uint32_t reserved;
+} ShmEntry;
+
+/* Lives at offset 0 of every segment. */
+typedef struct {
+    atomic_u32 magic;           // Stored last by the creator
+    uint32_t version;
+    uint32_t headerSize;        // Catches a layout mismatch within a version
+    uint32_t alignment;
+    uint64_t size;              // Mapped bytes, header included
+    atomic_u32 usedUnits;       // Allocated SHM_SEGMENT_ALIGNMENT units, header included
+    atomic_u32 entryCount;
+    ShmEntry entries[SHM_SEGMENT_MAX_ENTRIES];
+} ShmHeader;
+
+#define SHM_SEGMENT_UNITS(bytes) (((uint64_t)(bytes) + SHM_SEGMENT_ALIGNMENT - 1) / SHM_SEGMENT_ALIGNMENT)
+
+struct ShmSegment {
+    ShmHeader* header;
+    char* base;
+    size_t size;
+    bool owner;
+    char name[SHM_SEGMENT_NAME_MAX + 1];    // With the leading '/' on POSIX
+#if defined(_WIN32)
+    HANDLE mapping;
+#elif defined(SHM_SEGMENT_POSIX)
+    int fd;
+#endif
+};
+
+static bool shm_segment_name(ShmSegment* segment, const char* name) {
+    size_t length = name ? strlen(name) : 0;
+    if (length == 0 || length >= SHM_SEGMENT_NAME_MAX) return false;
+#if defined(SHM_SEGMENT_POSIX)
+    segment->name[0] = '/';
+    memcpy(segment->name + 1, name, length + 1);
+#else
+    memcpy(segment->name, name, length + 1);
+#endif
+    return true;
+}
+
+/* OS-level create or open; fills base and size. */
+static bool shm_segment_map(ShmSegment* segment, size_t size, bool create) {
+#if defined(_WIN32)
+    if (create) {
+        segment->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                              (DWORD)((uint64_t)size >> 32), (DWORD)size, segment->name);
+        if (segment->mapping && GetLastError() == ERROR_ALREADY_EXISTS) {
+            CloseHandle(segment->mapping);
+            segment->mapping = NULL;
+        }
+    } else {
+        segment->mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, segment->name);
+    }
+    if (!segment->mapping) return false;
+    segment->base = (char*)MapViewOfFile(segment->mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (!segment->base) {
+        CloseHandle(segment->mapping);
+        return false;
+    }
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(segment->base, &info, sizeof(info));
+    segment->size = create ? size : (size_t)info.RegionSize;
+    return true;
+#elif defined(SHM_SEGMENT_POSIX)
+    segment->fd = shm_open(segment->name, create ? (O_RDWR | O_CREAT | O_EXCL) : O_RDWR, 0600);
+    if (segment->fd < 0) return false;
+    if (create) {
+        if (ftruncate(segment->fd, (off_t)size) != 0) goto fail;
+    } else {
+        struct stat st;
+        if (fstat(segment->fd, &st) != 0 || (size_t)st.st_size < sizeof(ShmHeader)) goto fail;
+        size = (size_t)st.st_size;
+    }
+    segment->base = (char*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+    if (segment->base == MAP_FAILED) goto fail;
+    segment->size = size;
+    return true;
+fail:
+    close(segment->fd);
+    if (create) shm_unlink(segment->name);
+    return false;
+#else
+    (void)size;
+    (void)create;
+    return false;
+#endif
+}
+
+static void shm_segment_unmap(ShmSegment* segment) {
+#if defined(_WIN32)
+    UnmapViewOfFile(segment->base);
+    CloseHandle(segment->mapping);
+#elif defined(SHM_SEGMENT_POSIX)
+    munmap(segment->base, segment->size);
+    close(segment->fd);
+    if (segment->owner) shm_unlink(segment->name);
+#endif
+}
+
+ShmSegment* shm_segment_create(const char* name, size_t size) {
+    ShmSegment* segment = (ShmSegment*)calloc(1, sizeof(ShmSegment));
+    if (!segment) return NULL;
+    uint64_t headerUnits = SHM_SEGMENT_UNITS(sizeof(ShmHeader));
+    uint64_t total = (headerUnits + SHM_SEGMENT_UNITS(size)) * SHM_SEGMENT_ALIGNMENT;
+    if (total / SHM_SEGMENT_ALIGNMENT > UINT32_MAX || total > SIZE_MAX ||
+        !shm_segment_name(segment, name) || !shm_segment_map(segment, (size_t)total, true)) {
+        free(segment);
+        return NULL;
+    }
+    segment->owner = true;
+
+    // New mappings are zero-filled; publish the header with the magic last
+    ShmHeader* header = segment->header = (ShmHeader*)segment->base;
+    header->version = SHM_SEGMENT_VERSION;
+    header->headerSize = (uint32_t)sizeof(ShmHeader);
+    header->alignment = SHM_SEGMENT_ALIGNMENT;
+    header->size = total;
+    atomic_store_u32(&header->usedUnits, (uint32_t)headerUnits);
+    atomic_store_u32(&header->entryCount, 0);
+    atomic_store_u32(&header->magic, SHM_SEGMENT_MAGIC);
+    return segment;
+}
+
+ShmSegment* shm_segment_open(const char* name) {
+    ShmSegment* segment = (ShmSegment*)calloc(1, sizeof(ShmSegment));
+    if (!segment) return NULL;
+    if (!shm_segment_name(segment, name) || !shm_segment_map(segment, 0, false)) {
+        free(segment);
+        return NULL;
+    }
+    ShmHeader* header = segment->header = (ShmHeader*)segment->base;
+    if (atomic_load_u32(&header->magic) != SHM_SEGMENT_MAGIC || header->version != SHM_SEGMENT_VERSION ||
+        header->headerSize != sizeof(ShmHeader) || header->alignment != SHM_SEGMENT_ALIGNMENT ||
+        header->size > segment->size) {
+        shm_segment_unmap(segment);
+        free(segment);
+        return NULL;
+    }
+    segment->size = (size_t)header->size;
+    return segment;
+}
+
+void shm_segment_close(ShmSegment* segment) {
+    if (!segment) return;
+    shm_segment_unmap(segment);
+    free(segment);
+}
+
+void* shm_segment_alloc(ShmSegment* segment, const char* name, size_t size) {
+    if (!segment || !name || strlen(name) >= SHM_SEGMENT_NAME_MAX) return NULL;
+    ShmHeader* header = segment->header;
+    uint32_t index = atomic_fetch_add_u32(&header->entryCount, 1);
+    if (index >= SHM_SEGMENT_MAX_ENTRIES) return NULL;
+    ShmEntry* entry = &header->entries[index];
+
+    uint64_t units = SHM_SEGMENT_UNITS(size ? size : 1);
+    uint64_t limit = header->size / SHM_SEGMENT_ALIGNMENT;
+    uint32_t used = atomic_load_u32(&header->usedUnits);
+    do {
+        if (used + units > limit) {
+            atomic_store_u32(&entry->state, SHM_ENTRY_DEAD);
+            return NULL;
+        }
+    } while (!atomic_cas_u32(&header->usedUnits, &used, (uint32_t)(used + units)));
+
+    strcpy(entry->name, name);
+    entry->offset = (uint64_t)used * SHM_SEGMENT_ALIGNMENT;
+    entry->size = size;
+    atomic_store_u32(&entry->state, SHM_ENTRY_READY);
+    return segment->base + entry->offset;
+}
+
+void* shm_segment_find(ShmSegment* segment, const char* name, size_t* size) {
+    if (!segment || !name) return NULL;
+    ShmHeader* header = segment->header;
+    uint32_t count = atomic_load_u32(&header->entryCount);
+    if (count > SHM_SEGMENT_MAX_ENTRIES) count = SHM_SEGMENT_MAX_ENTRIES;
+    for (uint32_t i = 0; i < count; ++i) {
+        ShmEntry* entry = &header->entries[i];
+        if (atomic_load_u32(&entry->state) != SHM_ENTRY_READY) continue;
+        if (strncmp(entry->name, name, SHM_SEGMENT_NAME_MAX) != 0) continue;
+        if (size) *size = (size_t)entry->size;
+        return segment->base + entry->offset;
+    }
+    return NULL;
+}
+
+uint64_t shm_segment_offset(const ShmSegment* segment, const void* ptr) {
+    return (uint64_t)((const char*)ptr - segment->base);
+}
+
+void* shm_segment_pointer(const ShmSegment* segment, uint64_t offset) {
+    return offset < segment->size ? segment->base + offset : NULL;
+}
+
+size_t shm_segment_size(const ShmSegment* segment) {
+    return segment ? segment->size : 0;
+}
+
+void shm_segment_wait(void* word, uint32_t expected, uint64_t timeout_ns) {
+#if defined(__linux__)
+    // Not FUTEX_PRIVATE: the waker may be another process
+    struct timespec ts = { (time_t)(timeout_ns / 1000000000ull), (long)(timeout_ns % 1000000000ull) };
+    syscall(SYS_futex, word, FUTEX_WAIT, expected, &ts, NULL, 0);
+#else
+    uint64_t deadline = umsbb_clock_ns() + timeout_ns;
+    while (atomic_load_u32((atomic_u32*)word) == expected && umsbb_clock_ns() < deadline) {
+#  if defined(_WIN32)
+        Sleep(0);
+#  else
+        struct timespec ts = { 0, (long)SHM_SEGMENT_POLL_NS };
+        nanosleep(&ts, NULL);
+#  endif
+    }
+#endif
+}
+
+void shm_segment_wake(void* word) {
+#if defined(__linux__)
+    syscall(SYS_futex, word, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+#else
+    (void)word;
+#endif
+}
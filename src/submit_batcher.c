@@ -0,0 +1,295 @@
+#include "submit_batcher.h"
+#include "umsbb_clock.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#  include <windows.h>
+#  define submit_batch_yield() SwitchToThread()
+#else
+#  include <sched.h>
+#  define submit_batch_yield() sched_yield()
+#endif
+
+struct SubmitBatchStage {
+    atomic_size_t lock;         // Held by the owner while staging and by any thread flushing
+    atomic_size_t count;        // Records staged; only the owner raises it from 0
+    struct SubmitBatchStage* next;
+    const void* owner;          // Address of a thread-local of the owning thread
+    uint8_t* frame;             // SubmitBatchHeader, then the records
+    size_t capacity;
+    size_t bytes;               // Of frame in use, header included
+    uint64_t first_ns;          // When the oldest staged message arrived
+};
+
+typedef struct {
+    const SubmitBatcher* batcher;
+    uint64_t id;
+    SubmitBatchStage* stage;    // NULL: this thread has no stage on the batcher yet
+} SubmitBatchCacheEntry;
+
+static atomic_size_t submit_batch_ids;
+static SOMA_THREAD_LOCAL SubmitBatchCacheEntry submit_batch_cache[SUBMIT_BATCH_CACHE_WAYS];
+
+void submit_batch_default_config(SubmitBatchConfig* config) {
+    if (!config) return;
+    config->max_records = 32;
+    config->max_bytes = 16 * 1024;
+    config->max_record = 512;
+    config->max_delay_ns = 100000;
+}
+
+static void submit_batch_lock(SubmitBatchStage* stage) {
+    size_t expected = 0;
+    while (!atomic_cas_size(&stage->lock, &expected, 1)) {
+        expected = 0;
+        submit_batch_yield();
+    }
+}
+
+static bool submit_batch_try_lock(SubmitBatchStage* stage) {
+    size_t expected = 0;
+    return atomic_cas_size(&stage->lock, &expected, 1);
+}
+
+static void submit_batch_unlock(SubmitBatchStage* stage) {
+    atomic_store_size_release(&stage->lock, 0);
+}
+
+/* The calling thread's stage on `batcher`; with `create`, made on first use. */
+static SubmitBatchStage* submit_batch_own_stage(SubmitBatcher* batcher, bool create) {
+    SubmitBatchCacheEntry* entry = &submit_batch_cache[batcher->lane % SUBMIT_BATCH_CACHE_WAYS];
+    if (entry->batcher == batcher && entry->id == batcher->id && (entry->stage || !create)) return entry->stage;
+
+    const void* self = &submit_batch_cache;
+    SubmitBatchStage* stage = (SubmitBatchStage*)(uintptr_t)atomic_load_size_acquire(&batcher->stages);
+    for (; stage; stage = stage->next) {
+        if (stage->owner == self) break;
+    }
+    if (!stage && create) {
+        stage = (SubmitBatchStage*)calloc(1, sizeof(SubmitBatchStage));
+        if (!stage) return NULL;
+        stage->owner = self;
+        stage->bytes = sizeof(SubmitBatchHeader);
+        size_t head = atomic_load_size(&batcher->stages);
+        do {
+            stage->next = (SubmitBatchStage*)(uintptr_t)head;
+        } while (!atomic_cas_size(&batcher->stages, &head, (size_t)(uintptr_t)stage));
+    }
+    entry->batcher = batcher;
+    entry->id = batcher->id;
+    entry->stage = stage;
+    return stage;
+}
+
+/* Commit a locked stage as one frame; false leaves it staged. */
+static bool submit_batch_flush_locked(SubmitBatcher* batcher, SubmitBatchStage* stage) {
+    size_t count = atomic_load_size_relaxed(&stage->count);
+    if (count == 0) return true;
+
+    SubmitBatchHeader* header = (SubmitBatchHeader*)stage->frame;
+    header->count = (uint32_t)count;
+    header->reserved = 0;
+    header->committed_ns = 0;
+    if (!batcher->commit(batcher->context, batcher->lane, stage->frame, stage->bytes, (uint32_t)count)) return false;
+
+    atomic_fetch_add_size(&batcher->frames, 1);
+    atomic_fetch_add_size(&batcher->records, count);
+    stage->bytes = sizeof(SubmitBatchHeader);
+    // Release: the owner may claim straight after seeing the stage empty
+    atomic_store_size_release(&stage->count, 0);
+    atomic_fetch_add_size(&batcher->staged, (size_t)-1);
+    return true;
+}
+
+static size_t submit_batch_clamp(size_t value, size_t low, size_t high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+void submit_batcher_configure(SubmitBatcher* batcher, const SubmitBatchConfig* config) {
+    if (!batcher || !config) return;
+    // One record of max_record bytes always fits a frame
+    size_t bytes = submit_batch_clamp(config->max_bytes, sizeof(SubmitBatchHeader) + SUBMIT_BATCH_RECORD_SIZE(0),
+                                      UINT32_MAX / 2);
+    size_t record = submit_batch_clamp(config->max_record, 0,
+                                       bytes - sizeof(SubmitBatchHeader) - sizeof(SubmitRecord));
+    atomic_store_size(&batcher->max_bytes, bytes);
+    atomic_store_size(&batcher->max_record, record);
+    atomic_store_size(&batcher->max_delay_ns, (size_t)config->max_delay_ns);
+    atomic_store_size(&batcher->max_records, config->max_records);
+    if (config->max_records <= 1) atomic_store_size(&batcher->target, 1);
+}
+
+SubmitBatcher* submit_batcher_create(size_t lane, const SubmitBatchConfig* config,
+                                     submit_batch_commit_fn commit, void* context) {
+    if (!commit) return NULL;
+    SubmitBatcher* batcher = (SubmitBatcher*)calloc(1, sizeof(SubmitBatcher));
+    if (!batcher) return NULL;
+
+    SubmitBatchConfig defaults;
+    if (!config) {
+        submit_batch_default_config(&defaults);
+        config = &defaults;
+    }
+    batcher->lane = lane;
+    batcher->id = atomic_fetch_add_size(&submit_batch_ids, 1) + 1;
+    batcher->commit = commit;
+    batcher->context = context;
+    submit_batcher_configure(batcher, config);
+
+    // Start unbatched: only a consumer falling behind makes batches worth their delay
+    size_t max = config->max_records > 1 ? config->max_records : 1;
+    batch_init(&batcher->batch, 1, max, max / 8 ? max / 8 : 1);
+    atomic_store_size(&batcher->target, 1);
+    batcher->offset = 0;
+    return batcher;
+}
+
+void submit_batcher_destroy(SubmitBatcher* batcher) {
+    if (!batcher) return;
+    SubmitBatchStage* stage = (SubmitBatchStage*)(uintptr_t)atomic_load_size(&batcher->stages);
+    while (stage) {
+        SubmitBatchStage* next = stage->next;
+        free(stage->frame);
+        free(stage);
+        stage = next;
+    }
+    free(batcher);
+}
+
+bool submit_batcher_flush_own(SubmitBatcher* batcher) {
+    if (!batcher) return true;
+    SubmitBatchStage* stage = submit_batch_own_stage(batcher, false);
+    // Only this thread stages into it, so an empty stage stays empty here
+    if (!stage || atomic_load_size_acquire(&stage->count) == 0) return true;
+    submit_batch_lock(stage);
+    bool ok = submit_batch_flush_locked(batcher, stage);
+    submit_batch_unlock(stage);
+    return ok;
+}
+
+SubmitBatchResult submit_batcher_submit(SubmitBatcher* batcher, const void* msg, size_t size) {
+    size_t target = atomic_load_size_relaxed(&batcher->target);
+    if (target <= 1 || size > atomic_load_size_relaxed(&batcher->max_record)) {
+        return submit_batcher_flush_own(batcher) ? SUBMIT_BATCH_DIRECT : SUBMIT_BATCH_REFUSED;
+    }
+
+    SubmitBatchStage* stage = submit_batch_own_stage(batcher, true);
+    if (!stage) return SUBMIT_BATCH_DIRECT;
+
+    size_t maxBytes = atomic_load_size_relaxed(&batcher->max_bytes);
+    size_t recordSize = SUBMIT_BATCH_RECORD_SIZE(size);
+    submit_batch_lock(stage);
+    size_t count = atomic_load_size_relaxed(&stage->count);
+    if (count > 0 && stage->bytes + recordSize > maxBytes) {
+        if (!submit_batch_flush_locked(batcher, stage)) {
+            submit_batch_unlock(stage);
+            return SUBMIT_BATCH_REFUSED;
+        }
+        count = 0;
+    }
+    if (stage->bytes + recordSize > stage->capacity) {
+        size_t capacity = stage->bytes + recordSize > maxBytes ? stage->bytes + recordSize : maxBytes;
+        uint8_t* grown = (uint8_t*)realloc(stage->frame, capacity);
+        if (!grown) {
+            bool ok = submit_batch_flush_locked(batcher, stage);
+            submit_batch_unlock(stage);
+            return ok ? SUBMIT_BATCH_DIRECT : SUBMIT_BATCH_REFUSED;
+        }
+        stage->frame = grown;
+        stage->capacity = capacity;
+    }
+
+    SubmitRecord* record = (SubmitRecord*)(stage->frame + stage->bytes);
+    record->length = (uint32_t)size;
+    record->offset = (uint32_t)stage->bytes;
+    record->index = (uint32_t)count;
+    record->reserved = 0;
+    memcpy(record + 1, msg, size);
+    stage->bytes += recordSize;
+
+    uint64_t now = umsbb_clock_ns();
+    if (count == 0) {
+        stage->first_ns = now;
+        atomic_fetch_add_size(&batcher->staged, 1);
+    }
+    atomic_store_size_relaxed(&stage->count, ++count);
+
+    // A refused flush keeps the batch staged for the next submit or a deadline sweep
+    if (count >= target || stage->bytes + SUBMIT_BATCH_RECORD_SIZE(0) > maxBytes ||
+        now - stage->first_ns >= atomic_load_size_relaxed(&batcher->max_delay_ns)) {
+        submit_batch_flush_locked(batcher, stage);
+    }
+    submit_batch_unlock(stage);
+    return SUBMIT_BATCH_STAGED;
+}
+
+size_t submit_batcher_flush(SubmitBatcher* batcher, bool expired_only) {
+    if (!batcher || atomic_load_size_relaxed(&batcher->staged) == 0) return 0;
+    uint64_t now = expired_only ? umsbb_clock_ns() : 0;
+    uint64_t delay = atomic_load_size_relaxed(&batcher->max_delay_ns);
+
+    size_t flushed = 0;
+    SubmitBatchStage* stage = (SubmitBatchStage*)(uintptr_t)atomic_load_size_acquire(&batcher->stages);
+    for (; stage; stage = stage->next) {
+        if (atomic_load_size_relaxed(&stage->count) == 0) continue;
+        // A sweep never waits for a producer that is busy staging
+        if (expired_only) {
+            if (!submit_batch_try_lock(stage)) continue;
+        } else {
+            submit_batch_lock(stage);
+        }
+        bool due = atomic_load_size_relaxed(&stage->count) > 0 && (!expired_only || now - stage->first_ns >= delay);
+        if (due && submit_batch_flush_locked(batcher, stage)) {
+            flushed++;
+            if (expired_only) atomic_fetch_add_size(&batcher->deadline_flushes, 1);
+        }
+        submit_batch_unlock(stage);
+    }
+    return flushed;
+}
+
+void submit_batcher_observe(SubmitBatcher* batcher, size_t backlog, size_t capacity, uint64_t latency_ns) {
+    if (!batcher) return;
+    AdaptiveBatch* batch = &batcher->batch;
+    size_t max = atomic_load_size_relaxed(&batcher->max_records);
+    batch->max = max > 1 ? max : 1;
+    batch->step = batch->max / 8 ? batch->max / 8 : 1;
+    if (batch->current > batch->max) batch->current = batch->max;
+
+    // A quarter of the ring behind, or frames queued as long as the deadline,
+    // is full pressure
+    size_t score = capacity ? (size_t)((double)backlog * 400.0 / (double)capacity) : 0;
+    uint64_t delay = atomic_load_size_relaxed(&batcher->max_delay_ns);
+    if (delay && latency_ns) {
+        size_t waited = latency_ns >= delay ? 100 : (size_t)(latency_ns * 100 / delay);
+        if (waited > score) score = waited;
+    }
+    if (score > 100) score = 100;
+    atomic_store_size_relaxed(&batcher->target, batch_next(batch, score));
+}
+
+void submit_batcher_get_stats(SubmitBatcher* batcher, SubmitBatchStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!batcher) return;
+    out->frames = atomic_load_size_relaxed(&batcher->frames);
+    out->records = atomic_load_size_relaxed(&batcher->records);
+    out->deadline_flushes = atomic_load_size_relaxed(&batcher->deadline_flushes);
+    out->target = atomic_load_size_relaxed(&batcher->target);
+}
+
+bool submit_batch_frame_valid(const void* payload, size_t size) {
+    if (!payload || size < sizeof(SubmitBatchHeader)) return false;
+    const SubmitBatchHeader* header = (const SubmitBatchHeader*)payload;
+    size_t offset = sizeof(SubmitBatchHeader);
+    uint32_t index = 0;
+    while (offset < size) {
+        if (size - offset < sizeof(SubmitRecord)) return false;
+        const SubmitRecord* record = submit_batch_record(payload, offset);
+        if (record->offset != offset || record->index != index) return false;
+        if (record->length > size - offset - sizeof(SubmitRecord)) return false;
+        offset += SUBMIT_BATCH_RECORD_SIZE(record->length);
+        index++;
+    }
+    return offset == size && index == header->count && index > 0;
+}
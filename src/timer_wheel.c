@@ -0,0 +1,121 @@
+#include "timer_wheel.h"
+#include <string.h>
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_SPAN (1ull << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+static inline void list_reset(timer_wheel_timer_t* head) {
+    head->next = head;
+    head->prev = head;
+}
+
+static inline void list_append(timer_wheel_timer_t* head, timer_wheel_timer_t* timer) {
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+static inline void list_unlink(timer_wheel_timer_t* timer) {
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+// Move a whole slot onto `local` so callbacks can re-arm into it safely
+static void list_take(timer_wheel_timer_t* head, timer_wheel_timer_t* local) {
+    list_reset(local);
+    if (head->next == head) return;
+    local->next = head->next;
+    local->prev = head->prev;
+    local->next->prev = local;
+    local->prev->next = local;
+    list_reset(head);
+}
+
+static void place(timer_wheel_t* wheel, timer_wheel_timer_t* timer) {
+    uint64_t expires = timer->expires > wheel->now ? timer->expires : wheel->now;
+    uint64_t delta = expires - wheel->now;
+    if (delta >= TIMER_WHEEL_SPAN) {
+        // Out of range: park on the top level and re-hash when its slot comes round
+        expires = wheel->now + TIMER_WHEEL_SPAN - 1;
+        delta = TIMER_WHEEL_SPAN - 1;
+    }
+    uint32_t level = 0;
+    while (level + 1 < TIMER_WHEEL_LEVELS && delta >= 1ull << (TIMER_WHEEL_BITS * (level + 1))) level++;
+    uint32_t slot = (uint32_t)(expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    list_append(&wheel->slots[level][slot], timer);
+}
+
+void timer_wheel_init(timer_wheel_t* wheel, uint64_t tick_ns, uint64_t now_ns) {
+    if (!wheel) return;
+
+    memset(wheel, 0, sizeof(*wheel));
+    for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (uint32_t slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) list_reset(&wheel->slots[level][slot]);
+    }
+    wheel->tick_ns = tick_ns ? tick_ns : 1;
+    wheel->origin_ns = now_ns;
+}
+
+void timer_wheel_arm(timer_wheel_t* wheel, timer_wheel_timer_t* timer, uint64_t deadline_ns) {
+    if (!wheel || !timer) return;
+
+    if (timer_wheel_armed(timer)) {
+        list_unlink(timer);
+    } else {
+        wheel->armed++;
+    }
+    uint64_t offset = deadline_ns > wheel->origin_ns ? deadline_ns - wheel->origin_ns : 0;
+    uint64_t expires = offset / wheel->tick_ns + (offset % wheel->tick_ns != 0);
+    timer->expires = expires > wheel->now ? expires : wheel->now + 1;
+    place(wheel, timer);
+}
+
+void timer_wheel_cancel(timer_wheel_t* wheel, timer_wheel_timer_t* timer) {
+    if (!wheel || !timer || !timer_wheel_armed(timer)) return;
+
+    list_unlink(timer);
+    wheel->armed--;
+}
+
+// Re-hash one upper slot into the levels below; returns the slot index
+static uint32_t cascade(timer_wheel_t* wheel, uint32_t level) {
+    uint32_t slot = (uint32_t)(wheel->now >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    timer_wheel_timer_t local;
+    list_take(&wheel->slots[level][slot], &local);
+    while (local.next != &local) {
+        timer_wheel_timer_t* timer = local.next;
+        list_unlink(timer);
+        place(wheel, timer);
+    }
+    return slot;
+}
+
+uint32_t timer_wheel_advance(timer_wheel_t* wheel, uint64_t now_ns, timer_wheel_callback_t callback, void* context) {
+    if (!wheel) return 0;
+
+    uint64_t target = now_ns > wheel->origin_ns ? (now_ns - wheel->origin_ns) / wheel->tick_ns : 0;
+    uint32_t fired = 0;
+    while (wheel->now < target) {
+        if (wheel->armed == 0) {
+            wheel->now = target; // Nothing to cascade or fire on the way
+            break;
+        }
+        wheel->now++;
+        uint32_t slot = (uint32_t)wheel->now & TIMER_WHEEL_MASK;
+        for (uint32_t level = 1; slot == 0 && level < TIMER_WHEEL_LEVELS; level++) slot = cascade(wheel, level);
+
+        timer_wheel_timer_t local;
+        list_take(&wheel->slots[0][wheel->now & TIMER_WHEEL_MASK], &local);
+        while (local.next != &local) {
+            timer_wheel_timer_t* timer = local.next;
+            list_unlink(timer);
+            wheel->armed--;
+            fired++;
+            if (callback) callback(timer, context);
+        }
+    }
+    return fired;
+}
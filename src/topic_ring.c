@@ -0,0 +1,283 @@
+#include "topic_ring.h"
+#include "portable_atomic.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#  include <malloc.h>
+#  define topic_aligned_alloc(align, sz) _aligned_malloc(sz, align)
+#  define topic_aligned_free(ptr) _aligned_free(ptr)
+#elif defined(_WIN32)
+#  define topic_aligned_alloc(align, sz) malloc(sz)
+#  define topic_aligned_free(ptr) free(ptr)
+#else
+#  define topic_aligned_alloc(align, sz) aligned_alloc(align, sz)
+#  define topic_aligned_free(ptr) free(ptr)
+#endif
+
+#ifdef _WIN32
+#  include <windows.h>
+#  define topic_yield() SwitchToThread()
+#else
+#  include <sched.h>
+#  define topic_yield() sched_yield()
+#endif
+
+#define TOPIC_SLOT_FREE 0
+#define TOPIC_SLOT_JOINING 1
+#define TOPIC_SLOT_ACTIVE 2
+
+/*
+ * Low bit of a subscriber's cursor while it holds a batch. Ring indices are
+ * multiples of BI_BUFFER_FRAME_ALIGN, so the bit is otherwise clear; an
+ * overrun only moves cursors without it, which keeps held views valid.
+ */
+#define TOPIC_CURSOR_HELD ((size_t)1)
+
+TopicRing* topic_ring_create(size_t capacity) {
+    size_t bytes = (sizeof(TopicRing) + SOMA_ALIGNMENT - 1) & ~(size_t)(SOMA_ALIGNMENT - 1);
+    TopicRing* topic = topic_aligned_alloc(SOMA_ALIGNMENT, bytes);
+    if (!topic) return NULL;
+    memset(topic, 0, sizeof(TopicRing));
+
+    // MPSC: any thread may publish, and peeking is read-only
+    topic->buffer = bi_buffer_create(capacity, BI_BUFFER_MODE_MPSC);
+    if (!topic->buffer) {
+        topic_aligned_free(topic);
+        return NULL;
+    }
+    return topic;
+}
+
+void topic_ring_destroy(TopicRing* topic) {
+    if (!topic) return;
+    bi_buffer_free(topic->buffer);
+    topic_aligned_free(topic);
+}
+
+/* First index that has not been committed, walking from `index`. */
+static size_t topic_ring_frontier(TopicRing* topic, size_t index) {
+    size_t size;
+    size_t cursor = index;
+    while (bi_buffer_peek(topic->buffer, &cursor, &size)) index = cursor;
+    return index;
+}
+
+static bool topic_ring_try_lock(TopicRing* topic) {
+    size_t expected = 0;
+    return atomic_cas_size(&topic->reclaiming, &expected, 1);
+}
+
+static void topic_ring_lock(TopicRing* topic) {
+    while (!topic_ring_try_lock(topic)) topic_yield();
+}
+
+static void topic_ring_unlock(TopicRing* topic) {
+    atomic_store_size_release(&topic->reclaiming, 0);
+}
+
+/* Release frames every subscriber is done with. Caller holds the lock. */
+static void topic_ring_reclaim_locked(TopicRing* topic) {
+    BiBuffer* buf = topic->buffer;
+    size_t readIndex = bi_buffer_read_cursor(buf);
+    size_t target = readIndex;
+    size_t behind = SIZE_MAX;   // Distance of `target` past readIndex, SIZE_MAX with no subscribers
+
+    for (size_t i = 0; i < TOPIC_RING_MAX_SUBSCRIBERS; i++) {
+        TopicSubscriber* sub = &topic->slots[i];
+        if (atomic_load_size_acquire(&sub->state) != TOPIC_SLOT_ACTIVE) continue;
+        size_t cursor = atomic_load_size_acquire(&sub->cursor) & ~TOPIC_CURSOR_HELD;
+        if (cursor - readIndex < behind) {
+            behind = cursor - readIndex;
+            target = cursor;
+        }
+    }
+    // Nobody is listening: everything committed so far can go
+    if (behind == SIZE_MAX) target = topic_ring_frontier(topic, readIndex);
+    bi_buffer_release_to(buf, target);
+}
+
+static void topic_ring_reclaim(TopicRing* topic) {
+    if (!topic_ring_try_lock(topic)) return;
+    topic_ring_reclaim_locked(topic);
+    topic_ring_unlock(topic);
+}
+
+/*
+ * Move the DROP subscribers sitting at the oldest unreleased frame to the
+ * frontier. Caller holds the lock. Returns true if any cursor moved.
+ */
+static bool topic_ring_overrun_locked(TopicRing* topic) {
+    size_t readIndex = bi_buffer_read_cursor(topic->buffer);
+    size_t frontier = topic_ring_frontier(topic, readIndex);
+    bool moved = false;
+
+    for (size_t i = 0; i < TOPIC_RING_MAX_SUBSCRIBERS; i++) {
+        TopicSubscriber* sub = &topic->slots[i];
+        if (sub->policy != TOPIC_SLOW_DROP) continue;
+        if (atomic_load_size_acquire(&sub->state) != TOPIC_SLOT_ACTIVE) continue;
+
+        size_t cursor = atomic_load_size_acquire(&sub->cursor);
+        if (cursor != readIndex || cursor == frontier) continue;
+        // Fails if the subscriber just started a batch; it keeps its place
+        if (!atomic_cas_size(&sub->cursor, &cursor, frontier)) continue;
+
+        size_t skipped = 0, size;
+        while (cursor != frontier && bi_buffer_peek(topic->buffer, &cursor, &size)) skipped++;
+        atomic_fetch_add_size(&sub->dropped, skipped);
+        atomic_fetch_add_size(&sub->overruns, 1);
+        moved = true;
+    }
+    return moved;
+}
+
+uint32_t topic_ring_subscribe(TopicRing* topic, TopicSlowPolicy policy) {
+    if (!topic) return TOPIC_RING_NO_SUBSCRIBER;
+    for (uint32_t i = 0; i < TOPIC_RING_MAX_SUBSCRIBERS; i++) {
+        TopicSubscriber* sub = &topic->slots[i];
+        size_t expected = TOPIC_SLOT_FREE;
+        if (!atomic_cas_size(&sub->state, &expected, TOPIC_SLOT_JOINING)) continue;
+
+        sub->policy = policy;
+        sub->held = 0;
+        sub->next = 0;
+        sub->batch = 0;
+        sub->skipped = 0;
+        atomic_store_size(&sub->delivered, 0);
+        atomic_store_size(&sub->dropped, 0);
+        atomic_store_size(&sub->overruns, 0);
+        atomic_store_size(&sub->corrupted, 0);
+
+        // Under the lock the frontier cannot be reclaimed before the
+        // cursor holds it back
+        topic_ring_lock(topic);
+        size_t start = topic_ring_frontier(topic, bi_buffer_read_cursor(topic->buffer));
+        atomic_store_size_release(&sub->cursor, start);
+        atomic_store_size_release(&sub->state, TOPIC_SLOT_ACTIVE);
+        topic_ring_unlock(topic);
+        atomic_fetch_add_size(&topic->subscribers, 1);
+        return i;
+    }
+    return TOPIC_RING_NO_SUBSCRIBER;
+}
+
+static TopicSubscriber* topic_ring_subscriber(TopicRing* topic, uint32_t subscriber) {
+    if (!topic || subscriber >= TOPIC_RING_MAX_SUBSCRIBERS) return NULL;
+    TopicSubscriber* sub = &topic->slots[subscriber];
+    return atomic_load_size_acquire(&sub->state) == TOPIC_SLOT_ACTIVE ? sub : NULL;
+}
+
+void topic_ring_unsubscribe(TopicRing* topic, uint32_t subscriber) {
+    TopicSubscriber* sub = topic_ring_subscriber(topic, subscriber);
+    if (!sub) return;
+    // The reclaimer must not read this slot's cursor while a joiner resets it
+    topic_ring_lock(topic);
+    atomic_store_size_release(&sub->state, TOPIC_SLOT_FREE);
+    atomic_fetch_add_size(&topic->subscribers, (size_t)-1);
+    topic_ring_reclaim_locked(topic);
+    topic_ring_unlock(topic);
+}
+
+bool topic_ring_publish(TopicRing* topic, const void* data, size_t size, checksum_policy_t policy) {
+    if (!topic || (!data && size > 0)) return false;
+    // Nobody would ever read it
+    if (atomic_load_size_acquire(&topic->subscribers) == 0) return true;
+
+    BiBuffer* buf = topic->buffer;
+    void* dst = bi_buffer_claim(buf, size);
+    if (!dst) {
+        // Full: hand back what every subscriber is done with, then move
+        // DROP subscribers out of the way
+        topic_ring_lock(topic);
+        topic_ring_reclaim_locked(topic);
+        dst = bi_buffer_claim(buf, size);
+        if (!dst && topic_ring_overrun_locked(topic)) {
+            topic_ring_reclaim_locked(topic);
+            dst = bi_buffer_claim(buf, size);
+        }
+        topic_ring_unlock(topic);
+        if (!dst) {
+            atomic_fetch_add_size(&topic->refused, 1);
+            return false;
+        }
+    }
+
+    if (size > 0) memcpy(dst, data, size);
+    BiBufferFrame* frame = bi_buffer_frame(dst);
+    frame->sequence = (uint32_t)atomic_fetch_add_size(&topic->sequence, 1);
+    frame->flags = (uint16_t)(policy & CHECKSUM_POLICY_MASK);
+    frame->checksum = checksum_compute(policy, dst, size);
+    bi_buffer_commit(buf, dst, size);
+    atomic_fetch_add_size(&topic->published, 1);
+    return true;
+}
+
+size_t topic_ring_read(TopicRing* topic, uint32_t subscriber, TopicMessage* out, size_t max) {
+    TopicSubscriber* sub = topic_ring_subscriber(topic, subscriber);
+    if (!sub || !out || max == 0) return 0;
+
+    size_t cursor = atomic_load_size_acquire(&sub->cursor);
+    if (cursor & TOPIC_CURSOR_HELD) {
+        // Batch still outstanding: read it again from its start
+        cursor = sub->held;
+    } else {
+        // Pin the cursor so an overrun cannot move it under the views
+        while (!atomic_cas_size(&sub->cursor, &cursor, cursor | TOPIC_CURSOR_HELD)) {}
+    }
+    sub->held = cursor;
+    sub->next = cursor;
+    sub->skipped = 0;
+
+    size_t count = 0;
+    size_t size;
+    void* data;
+    while (count < max && (data = bi_buffer_peek(topic->buffer, &cursor, &size)) != NULL) {
+        BiBufferFrame* frame = bi_buffer_frame(data);
+        if (!checksum_verify((checksum_policy_t)(frame->flags & CHECKSUM_POLICY_MASK), data, size, frame->checksum)) {
+            // Skipped for good once the batch is released
+            sub->skipped++;
+            sub->next = cursor;
+            continue;
+        }
+        out[count].data = data;
+        out[count].size = size;
+        out[count].sequence = frame->sequence;
+        count++;
+        sub->next = cursor;
+    }
+    sub->batch = count;
+    if (count == 0) {
+        // Nothing to hold; an idle poll stays off the reclaim lock
+        if (sub->skipped) atomic_fetch_add_size(&sub->corrupted, sub->skipped);
+        atomic_store_size_release(&sub->cursor, sub->next);
+    }
+    return count;
+}
+
+bool topic_ring_release(TopicRing* topic, uint32_t subscriber) {
+    TopicSubscriber* sub = topic_ring_subscriber(topic, subscriber);
+    if (!sub) return false;
+    if (!(atomic_load_size_relaxed(&sub->cursor) & TOPIC_CURSOR_HELD)) return false;
+
+    // Overruns skip held cursors, so only this thread writes it now
+    atomic_store_size_release(&sub->cursor, sub->next);
+    atomic_fetch_add_size(&sub->delivered, sub->batch);
+    if (sub->skipped) atomic_fetch_add_size(&sub->corrupted, sub->skipped);
+    sub->batch = 0;
+    sub->skipped = 0;
+    // Only the oldest cursors can free anything
+    if (sub->held == bi_buffer_read_cursor(topic->buffer)) topic_ring_reclaim(topic);
+    return true;
+}
+
+bool topic_ring_subscriber_stats(TopicRing* topic, uint32_t subscriber, TopicSubscriberStats* out) {
+    TopicSubscriber* sub = topic_ring_subscriber(topic, subscriber);
+    if (!sub || !out) return false;
+    out->delivered = atomic_load_size_relaxed(&sub->delivered);
+    out->dropped = atomic_load_size_relaxed(&sub->dropped);
+    out->overruns = atomic_load_size_relaxed(&sub->overruns);
+    out->corrupted = atomic_load_size_relaxed(&sub->corrupted);
+    size_t cursor = atomic_load_size_acquire(&sub->cursor) & ~TOPIC_CURSOR_HELD;
+    out->lag = atomic_load_size_acquire(&topic->buffer->writeIndex) - cursor;
+    return true;
+}
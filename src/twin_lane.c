@@ -1,16 +1,13 @@
 #include "twin_lane.h"
+#include "message_pool.h"
+#include "umsbb_clock.h"
+#include "umsbb_trace.h"
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 #ifdef _WIN32
     #include <windows.h>
-    static uint64_t get_timestamp_us() {
-        LARGE_INTEGER frequency, counter;
-        QueryPerformanceFrequency(&frequency);
-        QueryPerformanceCounter(&counter);
-        return (counter.QuadPart * 1000000ULL) / frequency.QuadPart;
-    }
     
     static int posix_memalign(void **memptr, size_t alignment, size_t size) {
         *memptr = _aligned_malloc(size, alignment);
@@ -19,23 +16,154 @@
     
     #define free_aligned(ptr) _aligned_free(ptr)
 #else
-    #include <sys/time.h>
-    static uint64_t get_timestamp_us() {
-        struct timeval tv;
-        gettimeofday(&tv, NULL);
-        return tv.tv_sec * 1000000ULL + tv.tv_usec;
-    }
-    
     #define free_aligned(ptr) free(ptr)
 #endif
 
+
+#ifdef _WIN32
+    #define twin_lane_yield() SwitchToThread()
+#else
+    #include <sched.h>
+    #define twin_lane_yield() sched_yield()
+#endif
+
+#define TWIN_LANE_PAD UINT32_MAX        // Size of a record that only fills the end of the buffer
+#define TWIN_LANE_RECORD_LENGTH(size) \
+    (((size_t)(size) + TWIN_LANE_RECORD_HEADER + TWIN_LANE_RECORD_ALIGN - 1) & ~(size_t)(TWIN_LANE_RECORD_ALIGN - 1))
+
+typedef struct {
+    uint32_t size;
+    uint32_t sequence;
+} twin_record_t;
+
+static inline void twin_lane_cpu_relax(void) {
+#if defined(_MSC_VER)
+    YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static size_t twin_ring_capacity(size_t requested) {
+    size_t capacity = TWIN_LANE_MIN_CAPACITY;
+    while (capacity < requested && capacity <= SIZE_MAX / 2) capacity <<= 1;
+    return capacity;
+}
+
+#define TWIN_RING_BLOCK_SIZE(capacity) (sizeof(twin_ring_shared_t) + (size_t)(capacity))
+
+/* Point `ring` at a block holding its positions followed by its data. */
+static void twin_ring_bind(twin_ring_t* ring, twin_ring_shared_t* shared, bool owned) {
+    ring->shared = shared;
+    ring->data = (char*)(shared + 1);
+    ring->capacity = (size_t)shared->capacity;
+    ring->owned = owned;
+}
+
+static void twin_ring_format(twin_ring_shared_t* shared, size_t capacity) {
+    memset(shared, 0, TWIN_RING_BLOCK_SIZE(capacity));
+    shared->capacity = capacity;
+    atomic_store(&shared->head, 0);
+    atomic_store(&shared->reserve, 0);
+    atomic_store(&shared->tail, 0);
+    atomic_store(&shared->doorbell, 0);
+    atomic_store(&shared->waiters, 0);
+}
+
+static bool twin_ring_init(twin_ring_t* ring, size_t requested) {
+    size_t capacity = twin_ring_capacity(requested);
+    void* block = NULL;
+    if (posix_memalign(&block, 64, TWIN_RING_BLOCK_SIZE(capacity)) != 0) return false;
+    twin_ring_format((twin_ring_shared_t*)block, capacity);
+    twin_ring_bind(ring, (twin_ring_shared_t*)block, true);
+    return true;
+}
+
+static void twin_ring_free(twin_ring_t* ring) {
+    if (ring->shared && ring->owned) free_aligned(ring->shared);
+    ring->shared = NULL;
+    ring->data = NULL;
+    ring->capacity = 0;
+}
+
+static inline twin_record_t* twin_ring_record(const twin_ring_t* ring, uint64_t position) {
+    return (twin_record_t*)(ring->data + (position & (ring->capacity - 1)));
+}
+
+/*
+ * Claim [start, end) for a record of `size` payload bytes, including any
+ * padding needed to keep it contiguous. Fails without side effects when the
+ * ring lacks the room.
+ */
+static bool twin_ring_reserve(twin_ring_t* ring, size_t size, uint64_t* start, uint64_t* end) {
+    size_t length = TWIN_LANE_RECORD_LENGTH(size);
+    if (size > UINT32_MAX - 1 || length > ring->capacity) return false;
+    for (;;) {
+        uint64_t position = atomic_load(&ring->shared->reserve);
+        size_t offset = (size_t)(position & (ring->capacity - 1));
+        size_t pad = offset + length > ring->capacity ? ring->capacity - offset : 0;
+        uint64_t next = position + pad + length;
+        if (next - atomic_load(&ring->shared->tail) > ring->capacity) return false;
+        uint64_t expected = position;
+        if (atomic_compare_exchange_weak(&ring->shared->reserve, &expected, next)) {
+            *start = position;
+            *end = next;
+            return true;
+        }
+    }
+}
+
+/* Write the header (and any padding) of a reserved record; returns its payload. */
+static void* twin_ring_place(twin_ring_t* ring, uint64_t start, uint64_t end, size_t size, uint32_t sequence) {
+    uint64_t position = end - TWIN_LANE_RECORD_LENGTH(size);
+    if (position != start) twin_ring_record(ring, start)->size = TWIN_LANE_PAD;
+    twin_record_t* record = twin_ring_record(ring, position);
+    record->size = (uint32_t)size;
+    record->sequence = sequence;
+    return record + 1;
+}
+
+/* Copy a record into a reserved range. */
+static void twin_ring_fill(twin_ring_t* ring, uint64_t start, uint64_t end, const void* data, size_t size, uint32_t sequence) {
+    memcpy(twin_ring_place(ring, start, end, size, sequence), data, size);
+}
+
+/* Writers publish in reservation order: wait for the ones ahead of us. */
+static void twin_ring_wait_turn(twin_ring_t* ring, uint64_t start) {
+    for (unsigned spins = 1; atomic_load(&ring->shared->head) != start; ++spins) {
+        if (spins % 64 == 0) twin_lane_yield();
+        else twin_lane_cpu_relax();
+    }
+}
+
+/* Make [.., end) readable and ring the doorbell if a reader sleeps on it;
+ * true if it rang. */
+static bool twin_ring_publish(twin_ring_t* ring, uint64_t end) {
+    atomic_store(&ring->shared->head, end);
+    if (!atomic_load(&ring->shared->waiters)) return false;
+    atomic_fetch_add(&ring->shared->doorbell, 1);
+    shm_segment_wake((void*)&ring->shared->doorbell);
+    return true;
+}
+
+/* Skip a padding record at `position`, if that is what is there. */
+static inline uint64_t twin_ring_skip_pad(const twin_ring_t* ring, uint64_t position, const twin_record_t* record) {
+    if (record->size != TWIN_LANE_PAD) return position;
+    return position + ring->capacity - (size_t)(position & (ring->capacity - 1));
+}
+
 bool twin_lane_init(twin_lane_manager_t* manager, uint32_t max_lanes) {
     if (!manager || max_lanes == 0) return false;
     
     memset(manager, 0, sizeof(twin_lane_manager_t));
     
-    manager->lanes = calloc(max_lanes, sizeof(twin_lane_t));
-    if (!manager->lanes) return false;
+    // Lanes hold cache-line aligned cursors, beyond what calloc promises
+    void* lanes = NULL;
+    if (posix_memalign(&lanes, _Alignof(twin_lane_t), (size_t)max_lanes * sizeof(twin_lane_t)) != 0) return false;
+    memset(lanes, 0, (size_t)max_lanes * sizeof(twin_lane_t));
+    manager->lanes = (twin_lane_t*)lanes;
     
     manager->max_lanes = max_lanes;
     manager->lane_count = 0;
@@ -54,56 +182,122 @@ void twin_lane_destroy(twin_lane_manager_t* manager) {
     if (manager->lanes) {
         for (uint32_t i = 0; i < manager->lane_count; i++) {
             twin_lane_t* lane = &manager->lanes[i];
-            if (lane->tx_ring) free_aligned(lane->tx_ring);
-            if (lane->rx_ring) free_aligned(lane->rx_ring);
+            twin_ring_free(&lane->tx);
+            twin_ring_free(&lane->rx);
+            latency_histogram_destroy(lane->tx_latency);
+            latency_histogram_destroy(lane->rx_latency);
         }
-        free(manager->lanes);
+        free_aligned(manager->lanes);
     }
     
     memset(manager, 0, sizeof(twin_lane_manager_t));
 }
 
+/* Finish a lane whose rings are bound; on failure the rings are released. */
+static uint32_t twin_lane_activate(twin_lane_manager_t* manager, twin_lane_t* lane, uint32_t peer_node_id) {
+    uint32_t lane_id = manager->lane_count;
+    lane->lane_id = lane_id;
+    lane->peer_node_id = peer_node_id;
+    lane->symmetric_bandwidth = (lane->tx.capacity == lane->rx.capacity);
+    
+    lane->tx_latency = latency_histogram_create();
+    lane->rx_latency = latency_histogram_create();
+    if (!lane->tx_latency || !lane->rx_latency) {
+        latency_histogram_destroy(lane->tx_latency);
+        latency_histogram_destroy(lane->rx_latency);
+        lane->tx_latency = lane->rx_latency = NULL;
+        twin_ring_free(&lane->tx);
+        twin_ring_free(&lane->rx);
+        return UINT32_MAX;
+    }
+    
+    atomic_store(&lane->sync_sequence, 0);
+    atomic_store(&lane->flow_control_state, 0);
+    
+    // Initialize flow control windows
+    atomic_store(&lane->tx_window_size, 64);  // Start with 64 outstanding messages
+    atomic_store(&lane->tx_inflight, 0);
+    atomic_store(&lane->tx_sent, 0);
+    atomic_store(&lane->tx_acked, 0);
+    
+    manager->lane_count++;
+    return lane_id;
+}
+
 uint32_t twin_lane_create(twin_lane_manager_t* manager, uint32_t peer_node_id, size_t tx_capacity, size_t rx_capacity) {
     if (!manager || manager->lane_count >= manager->max_lanes) return UINT32_MAX;
     
-    uint32_t lane_id = manager->lane_count++;
-    twin_lane_t* lane = &manager->lanes[lane_id];
-    
+    twin_lane_t* lane = &manager->lanes[manager->lane_count];
     memset(lane, 0, sizeof(twin_lane_t));
     
-    lane->lane_id = lane_id;
-    lane->peer_node_id = peer_node_id;
-    lane->symmetric_bandwidth = (tx_capacity == rx_capacity);
-    lane->tx_capacity = tx_capacity;
-    lane->rx_capacity = rx_capacity;
-    
-    // Allocate cache-aligned ring buffers
-    if (posix_memalign(&lane->tx_ring, 64, tx_capacity) != 0) {
+    // Cache-aligned byte rings, rounded up to a power of two
+    if (!twin_ring_init(&lane->tx, tx_capacity)) {
         return UINT32_MAX;
     }
     
-    if (posix_memalign(&lane->rx_ring, 64, rx_capacity) != 0) {
-        free_aligned(lane->tx_ring);
+    if (!twin_ring_init(&lane->rx, rx_capacity)) {
+        twin_ring_free(&lane->tx);
         return UINT32_MAX;
     }
     
-    memset(lane->tx_ring, 0, tx_capacity);
-    memset(lane->rx_ring, 0, rx_capacity);
-    
-    atomic_store(&lane->tx_head, 0);
-    atomic_store(&lane->tx_tail, 0);
-    atomic_store(&lane->rx_head, 0);
-    atomic_store(&lane->rx_tail, 0);
-    atomic_store(&lane->sync_sequence, 0);
-    atomic_store(&lane->flow_control_state, 0);
+    return twin_lane_activate(manager, lane, peer_node_id);
+}
+
+/* Segment entry of ring `index` (0: creator to attacher, 1: the reverse). */
+static bool twin_lane_shared_name(char* out, const char* name, int index) {
+    size_t length = name ? strlen(name) : 0;
+    if (length == 0 || length + 3 > SHM_SEGMENT_NAME_MAX) return false;
+    memcpy(out, name, length);
+    out[length] = '/';
+    out[length + 1] = (char)('0' + index);
+    out[length + 2] = '\0';
+    return true;
+}
+
+uint32_t twin_lane_create_shared(twin_lane_manager_t* manager, ShmSegment* segment, const char* name,
+                                 uint32_t peer_node_id, size_t tx_capacity, size_t rx_capacity) {
+    if (!manager || !segment || manager->lane_count >= manager->max_lanes) return UINT32_MAX;
+    
+    char names[2][SHM_SEGMENT_NAME_MAX];
+    if (!twin_lane_shared_name(names[0], name, 0) || !twin_lane_shared_name(names[1], name, 1)) return UINT32_MAX;
+    if (shm_segment_find(segment, names[0], NULL)) return UINT32_MAX;  // Name taken
+    
+    size_t capacities[2] = { twin_ring_capacity(tx_capacity), twin_ring_capacity(rx_capacity) };
+    twin_ring_shared_t* blocks[2];
+    for (int i = 0; i < 2; ++i) {
+        blocks[i] = (twin_ring_shared_t*)shm_segment_alloc(segment, names[i], TWIN_RING_BLOCK_SIZE(capacities[i]));
+        if (!blocks[i]) return UINT32_MAX;  // Segment full; its space is not reclaimed
+        twin_ring_format(blocks[i], capacities[i]);
+    }
     
-    // Initialize flow control windows
-    lane->tx_window_size = 64;  // Start with 64 outstanding messages
-    lane->rx_window_size = 64;
-    atomic_store(&lane->tx_inflight, 0);
-    atomic_store(&lane->rx_inflight, 0);
+    twin_lane_t* lane = &manager->lanes[manager->lane_count];
+    memset(lane, 0, sizeof(twin_lane_t));
+    twin_ring_bind(&lane->tx, blocks[0], false);
+    twin_ring_bind(&lane->rx, blocks[1], false);
+    return twin_lane_activate(manager, lane, peer_node_id);
+}
+
+uint32_t twin_lane_attach_shared(twin_lane_manager_t* manager, ShmSegment* segment, const char* name,
+                                 uint32_t peer_node_id) {
+    if (!manager || !segment || manager->lane_count >= manager->max_lanes) return UINT32_MAX;
+    
+    char names[2][SHM_SEGMENT_NAME_MAX];
+    if (!twin_lane_shared_name(names[0], name, 0) || !twin_lane_shared_name(names[1], name, 1)) return UINT32_MAX;
+    
+    // The creator's TX ring is our RX ring
+    twin_ring_shared_t* blocks[2];
+    for (int i = 0; i < 2; ++i) {
+        size_t size = 0;
+        blocks[i] = (twin_ring_shared_t*)shm_segment_find(segment, names[i], &size);
+        if (!blocks[i] || size < sizeof(twin_ring_shared_t) ||
+            size != TWIN_RING_BLOCK_SIZE(blocks[i]->capacity)) return UINT32_MAX;
+    }
     
-    return lane_id;
+    twin_lane_t* lane = &manager->lanes[manager->lane_count];
+    memset(lane, 0, sizeof(twin_lane_t));
+    twin_ring_bind(&lane->tx, blocks[1], false);
+    twin_ring_bind(&lane->rx, blocks[0], false);
+    return twin_lane_activate(manager, lane, peer_node_id);
 }
 
 bool twin_lane_destroy_lane(twin_lane_manager_t* manager, uint32_t lane_id) {
@@ -111,19 +305,14 @@ bool twin_lane_destroy_lane(twin_lane_manager_t* manager, uint32_t lane_id) {
     
     twin_lane_t* lane = &manager->lanes[lane_id];
     
-    if (lane->tx_ring) {
-        free_aligned(lane->tx_ring);
-        lane->tx_ring = NULL;
-    }
-    
-    if (lane->rx_ring) {
-        free_aligned(lane->rx_ring);
-        lane->rx_ring = NULL;
-    }
+    // Capacity 0 marks the lane inactive
+    twin_ring_free(&lane->tx);
+    twin_ring_free(&lane->rx);
     
-    // Mark lane as inactive by setting capacity to 0
-    lane->tx_capacity = 0;
-    lane->rx_capacity = 0;
+    latency_histogram_destroy(lane->tx_latency);
+    latency_histogram_destroy(lane->rx_latency);
+    lane->tx_latency = NULL;
+    lane->rx_latency = NULL;
     
     return true;
 }
@@ -132,41 +321,39 @@ bool twin_lane_send(twin_lane_manager_t* manager, uint32_t lane_id, const void*
     if (!manager || lane_id >= manager->lane_count || !data || size == 0) return false;
     
     twin_lane_t* lane = &manager->lanes[lane_id];
-    if (lane->tx_capacity == 0) return false; // Lane destroyed
+    if (lane->tx.capacity == 0) return false; // Lane destroyed
     
-    uint64_t start_time = get_timestamp_us();
+    uint64_t start_time = umsbb_clock_ns();
     
-    // Check flow control
-    uint32_t inflight = atomic_load(&lane->tx_inflight);
-    if (inflight >= lane->tx_window_size) {
-        return false; // Flow control limit reached
+    // Take a window slot; the CAS keeps concurrent senders within the window
+    for (;;) {
+        uint32_t inflight = atomic_load(&lane->tx_inflight);
+        if (inflight >= atomic_load(&lane->tx_window_size)) {
+            return false; // Flow control limit reached
+        }
+        uint32_t expected = inflight;
+        if (atomic_compare_exchange_weak(&lane->tx_inflight, &expected, inflight + 1)) break;
     }
     
-    // Get TX slot
-    uint64_t tx_head = atomic_fetch_add(&lane->tx_head, 1);
-    uint64_t slot_offset = (tx_head % (lane->tx_capacity / (size + sizeof(uint64_t) + sizeof(uint32_t)))) * 
-                          (size + sizeof(uint64_t) + sizeof(uint32_t));
-    
-    if (slot_offset + size + sizeof(uint64_t) + sizeof(uint32_t) > lane->tx_capacity) {
+    uint64_t start, end;
+    if (!twin_ring_reserve(&lane->tx, size, &start, &end)) {
+        atomic_fetch_sub(&lane->tx_inflight, 1);
         return false; // Not enough space
     }
+    UMSBB_TRACE(UMSBB_TRACE_TWIN_TX, UMSBB_TRACE_CLAIM, lane_id, sequence);
+    twin_ring_fill(&lane->tx, start, end, data, size, sequence);
     
-    char* slot_addr = (char*)lane->tx_ring + slot_offset;
-    
-    // Write message with header: [sequence][size][data]
-    *(uint64_t*)slot_addr = sequence;
-    *(uint32_t*)(slot_addr + sizeof(uint64_t)) = (uint32_t)size;
-    memcpy(slot_addr + sizeof(uint64_t) + sizeof(uint32_t), data, size);
-    
-    // Update metrics
+    // Publish; senders ahead of us commit first, so this section is ours alone
+    twin_ring_wait_turn(&lane->tx, start);
+    uint64_t sent = atomic_load(&lane->tx_sent);
+    lane->tx_sent_sequences[sent % TWIN_LANE_MAX_WINDOW] = sequence;
     lane->tx_messages++;
     lane->tx_bytes += size;
-    atomic_fetch_add(&lane->tx_inflight, 1);
+    atomic_store(&lane->tx_sent, sent + 1);
+    UMSBB_TRACE(UMSBB_TRACE_TWIN_TX, UMSBB_TRACE_COMMIT, lane_id, sequence);
+    if (twin_ring_publish(&lane->tx, end)) UMSBB_TRACE(UMSBB_TRACE_TWIN_TX, UMSBB_TRACE_SIGNAL, lane_id, sequence);
     
-    // Update latency tracking
-    uint64_t end_time = get_timestamp_us();
-    double latency = (double)(end_time - start_time);
-    lane->tx_latency_us = (lane->tx_latency_us * 0.9) + (latency * 0.1);
+    latency_histogram_record(lane->tx_latency, umsbb_clock_ns() - start_time);
     
     // Update global sequence for coordination
     atomic_store(&manager->global_tx_sequence, sequence);
@@ -178,65 +365,180 @@ void* twin_lane_receive(twin_lane_manager_t* manager, uint32_t lane_id, size_t*
     if (!manager || lane_id >= manager->lane_count || !size || !sequence) return NULL;
     
     twin_lane_t* lane = &manager->lanes[lane_id];
-    if (lane->rx_capacity == 0) return NULL; // Lane destroyed
-    
-    uint64_t start_time = get_timestamp_us();
-    
-    uint64_t rx_tail = atomic_load(&lane->rx_tail);
-    uint64_t rx_head = atomic_load(&lane->rx_head);
-    
-    // Check if messages available
-    if (rx_tail >= rx_head) {
-        *size = 0;
-        *sequence = 0;
-        return NULL;
+    twin_ring_t* ring = &lane->rx;
+    *size = 0;
+    *sequence = 0;
+    if (ring->capacity == 0) return NULL; // Lane destroyed
+    
+    uint64_t start_time = umsbb_clock_ns();
+    
+    // Copy, then claim with a CAS on the tail. A record cannot be reused
+    // before the tail passes it, so a copy whose CAS succeeds is intact; a
+    // failed CAS means another receiver took it and the copy is discarded.
+    for (;;) {
+        uint64_t rx_tail = atomic_load(&ring->shared->tail);
+        if (rx_tail == atomic_load(&ring->shared->head)) return NULL; // Empty
+        
+        const twin_record_t* record = twin_ring_record(ring, rx_tail);
+        uint64_t position = twin_ring_skip_pad(ring, rx_tail, record);
+        if (position != rx_tail) {
+            uint64_t expected = rx_tail;
+            atomic_compare_exchange_strong(&ring->shared->tail, &expected, position);
+            continue;
+        }
+        
+        twin_record_t header = *record;
+        size_t offset = (size_t)(rx_tail & (ring->capacity - 1));
+        if (header.size == 0 || header.size > ring->capacity - offset - TWIN_LANE_RECORD_HEADER) {
+            continue; // Torn read of a record another receiver already took
+        }
+        
+        // Pooled result buffer, released with umsbb_message_release
+        void* result = message_pool_alloc(header.size);
+        if (!result) return NULL;
+        memcpy(result, record + 1, header.size);
+        
+        uint64_t expected = rx_tail;
+        if (!atomic_compare_exchange_strong(&ring->shared->tail, &expected, rx_tail + TWIN_LANE_RECORD_LENGTH(header.size))) {
+            message_pool_release(result);
+            continue;
+        }
+        
+        *size = header.size;
+        *sequence = header.sequence;
+        UMSBB_TRACE(UMSBB_TRACE_TWIN_RX, UMSBB_TRACE_DRAIN, lane_id, header.sequence);
+        
+        // Update metrics
+        lane->rx_messages++;
+        lane->rx_bytes += header.size;
+        
+        latency_histogram_record(lane->rx_latency, umsbb_clock_ns() - start_time);
+        
+        return result;
+    }
+}
+
+uint64_t twin_lane_tx_cursor(twin_lane_manager_t* manager, uint32_t lane_id) {
+    if (!manager || lane_id >= manager->lane_count) return 0;
+    twin_ring_t* ring = &manager->lanes[lane_id].tx;
+    return ring->capacity ? atomic_load(&ring->shared->tail) : 0;
+}
+
+const void* twin_lane_peek_tx(twin_lane_manager_t* manager, uint32_t lane_id, uint64_t* cursor, size_t* size, uint32_t* sequence) {
+    if (!manager || lane_id >= manager->lane_count || !cursor || !size || !sequence) return NULL;
+    
+    twin_ring_t* ring = &manager->lanes[lane_id].tx;
+    if (ring->capacity == 0) return NULL;
+    
+    uint64_t tx_head = atomic_load(&ring->shared->head);
+    while (*cursor != tx_head) {
+        const twin_record_t* record = twin_ring_record(ring, *cursor);
+        uint64_t position = twin_ring_skip_pad(ring, *cursor, record);
+        if (position != *cursor) {
+            *cursor = position;
+            continue;
+        }
+        *size = record->size;
+        *sequence = record->sequence;
+        *cursor += TWIN_LANE_RECORD_LENGTH(record->size);
+        UMSBB_TRACE(UMSBB_TRACE_TWIN_TX, UMSBB_TRACE_DRAIN, lane_id, record->sequence);
+        return record + 1;
+    }
+    return NULL;
+}
+
+void twin_lane_release_tx(twin_lane_manager_t* manager, uint32_t lane_id, uint64_t cursor) {
+    if (!manager || lane_id >= manager->lane_count) return;
+    twin_ring_t* ring = &manager->lanes[lane_id].tx;
+    if (ring->capacity) atomic_store(&ring->shared->tail, cursor);
+}
+
+size_t twin_lane_drain_tx(twin_lane_manager_t* manager, uint32_t lane_id, twin_lane_frame_fn fn, void* context, size_t max_frames) {
+    if (!fn) return 0;
+    
+    uint64_t cursor = twin_lane_tx_cursor(manager, lane_id);
+    uint64_t released = cursor;
+    size_t frames = 0, size;
+    uint32_t sequence, last = 0;
+    const void* frame;
+    while (frames < max_frames && (frame = twin_lane_peek_tx(manager, lane_id, &cursor, &size, &sequence))) {
+        if (!fn(context, frame, size, sequence)) break;
+        released = cursor;
+        last = sequence;
+        frames++;
     }
     
-    // Calculate slot offset (simplified - assumes fixed slot size)
-    uint64_t max_slot_size = 4096; // Maximum message size
-    uint64_t slot_offset = (rx_tail % (lane->rx_capacity / max_slot_size)) * max_slot_size;
-    
-    char* slot_addr = (char*)lane->rx_ring + slot_offset;
+    // One release for the whole batch, traced under its last frame
+    if (frames) {
+        twin_lane_release_tx(manager, lane_id, released);
+        UMSBB_TRACE(UMSBB_TRACE_TWIN_TX, UMSBB_TRACE_RELEASE, lane_id, last);
+    }
+    (void)last;
+    return frames;
+}
+
+bool twin_lane_deliver(twin_lane_manager_t* manager, uint32_t lane_id, const void* data, size_t size, uint32_t sequence) {
+    if (!manager || lane_id >= manager->lane_count || !data || size == 0) return false;
     
-    // Read message header: [sequence][size][data]
-    uint64_t msg_sequence = *(uint64_t*)slot_addr;
-    uint32_t msg_size = *(uint32_t*)(slot_addr + sizeof(uint64_t));
+    twin_lane_t* lane = &manager->lanes[lane_id];
+    if (lane->rx.capacity == 0) return false;
     
-    if (msg_size == 0 || msg_size > max_slot_size - sizeof(uint64_t) - sizeof(uint32_t)) {
-        // Invalid message, advance tail
-        atomic_fetch_add(&lane->rx_tail, 1);
-        *size = 0;
-        *sequence = 0;
-        return NULL;
-    }
+    uint64_t start, end;
+    if (!twin_ring_reserve(&lane->rx, size, &start, &end)) return false;
+    UMSBB_TRACE(UMSBB_TRACE_TWIN_RX, UMSBB_TRACE_CLAIM, lane_id, sequence);
+    twin_ring_fill(&lane->rx, start, end, data, size, sequence);
     
-    // Allocate result buffer
-    void* result = malloc(msg_size);
-    if (!result) {
-        *size = 0;
-        *sequence = 0;
-        return NULL;
-    }
+    twin_ring_wait_turn(&lane->rx, start);
+    UMSBB_TRACE(UMSBB_TRACE_TWIN_RX, UMSBB_TRACE_COMMIT, lane_id, sequence);
+    if (twin_ring_publish(&lane->rx, end)) UMSBB_TRACE(UMSBB_TRACE_TWIN_RX, UMSBB_TRACE_SIGNAL, lane_id, sequence);
     
-    // Copy message data
-    memcpy(result, slot_addr + sizeof(uint64_t) + sizeof(uint32_t), msg_size);
-    *size = msg_size;
-    *sequence = (uint32_t)msg_sequence;
+    atomic_store(&manager->global_rx_sequence, sequence);
+    return true;
+}
+
+void* twin_lane_claim_rx(twin_lane_manager_t* manager, uint32_t lane_id, size_t size, uint32_t sequence, twin_lane_claim_t* claim) {
+    if (!manager || lane_id >= manager->lane_count || size == 0 || !claim) return NULL;
     
-    // Advance RX tail
-    atomic_fetch_add(&lane->rx_tail, 1);
-    atomic_fetch_add(&lane->rx_inflight, 1);
+    twin_lane_t* lane = &manager->lanes[lane_id];
+    if (lane->rx.capacity == 0) return NULL;
     
-    // Update metrics
-    lane->rx_messages++;
-    lane->rx_bytes += msg_size;
+    if (!twin_ring_reserve(&lane->rx, size, &claim->start, &claim->end)) return NULL;
+    claim->sequence = sequence;
+    UMSBB_TRACE(UMSBB_TRACE_TWIN_RX, UMSBB_TRACE_CLAIM, lane_id, sequence);
+    return twin_ring_place(&lane->rx, claim->start, claim->end, size, sequence);
+}
+
+void twin_lane_commit_rx(twin_lane_manager_t* manager, uint32_t lane_id, const twin_lane_claim_t* claim) {
+    if (!manager || lane_id >= manager->lane_count || !claim) return;
     
-    // Update latency tracking
-    uint64_t end_time = get_timestamp_us();
-    double latency = (double)(end_time - start_time);
-    lane->rx_latency_us = (lane->rx_latency_us * 0.9) + (latency * 0.1);
+    twin_lane_t* lane = &manager->lanes[lane_id];
+    twin_ring_wait_turn(&lane->rx, claim->start);
+    UMSBB_TRACE(UMSBB_TRACE_TWIN_RX, UMSBB_TRACE_COMMIT, lane_id, claim->sequence);
+    if (twin_ring_publish(&lane->rx, claim->end)) UMSBB_TRACE(UMSBB_TRACE_TWIN_RX, UMSBB_TRACE_SIGNAL, lane_id, claim->sequence);
+    atomic_store(&manager->global_rx_sequence, claim->sequence);
+}
+
+bool twin_lane_wait(twin_lane_manager_t* manager, uint32_t lane_id, twin_direction_t direction, uint64_t timeout_ns) {
+    if (!manager || lane_id >= manager->lane_count) return false;
     
-    return result;
+    twin_lane_t* lane = &manager->lanes[lane_id];
+    twin_ring_t* ring = direction == TWIN_DIRECTION_TX ? &lane->tx : &lane->rx;
+    if (ring->capacity == 0) return false;
+    twin_ring_shared_t* shared = ring->shared;
+    
+    uint64_t deadline = umsbb_clock_ns() + timeout_ns;
+    for (;;) {
+        if (atomic_load(&shared->head) != atomic_load(&shared->tail)) return true;
+        uint64_t now = umsbb_clock_ns();
+        if (now >= deadline) return false;
+        
+        // Register before the final check so a publish in between rings the bell
+        atomic_fetch_add(&shared->waiters, 1);
+        uint32_t bell = atomic_load(&shared->doorbell);
+        bool empty = atomic_load(&shared->head) == atomic_load(&shared->tail);
+        if (empty) shm_segment_wait((void*)&shared->doorbell, bell, deadline - now);
+        atomic_fetch_sub(&shared->waiters, 1);
+    }
 }
 
 bool twin_lane_can_send(twin_lane_manager_t* manager, uint32_t lane_id) {
@@ -245,39 +547,60 @@ bool twin_lane_can_send(twin_lane_manager_t* manager, uint32_t lane_id) {
     twin_lane_t* lane = &manager->lanes[lane_id];
     uint32_t inflight = atomic_load(&lane->tx_inflight);
     
-    return inflight < lane->tx_window_size;
+    return inflight < atomic_load(&lane->tx_window_size);
 }
 
-void twin_lane_update_flow_control(twin_lane_manager_t* manager, uint32_t lane_id, uint32_t ack_sequence) {
-    if (!manager || lane_id >= manager->lane_count) return;
+uint32_t twin_lane_update_flow_control(twin_lane_manager_t* manager, uint32_t lane_id, uint32_t ack_sequence) {
+    if (!manager || lane_id >= manager->lane_count) return 0;
     
     twin_lane_t* lane = &manager->lanes[lane_id];
     
-    // Decrease inflight count for acknowledged message
-    uint32_t current_inflight = atomic_load(&lane->tx_inflight);
-    if (current_inflight > 0) {
-        atomic_fetch_sub(&lane->tx_inflight, 1);
+    // Advance the acknowledged prefix over every send the ACK covers. Sends in
+    // [tx_acked, tx_sent) are within the window, so their slots are live; a
+    // concurrent ACK that moves tx_acked first makes us rescan.
+    uint32_t credited = 0;
+    for (;;) {
+        uint64_t acked = atomic_load(&lane->tx_acked);
+        uint64_t sent = atomic_load(&lane->tx_sent);
+        uint64_t next = acked;
+        while (next < sent &&
+               (int32_t)(lane->tx_sent_sequences[next % TWIN_LANE_MAX_WINDOW] - ack_sequence) <= 0) {
+            next++;
+        }
+        if (next == acked) break;
+        uint64_t expected = acked;
+        if (atomic_compare_exchange_strong(&lane->tx_acked, &expected, next)) {
+            credited = (uint32_t)(next - acked);
+            break;
+        }
     }
     
-    // Adaptive window sizing based on network conditions
-    // Increase window if ACKs are coming back quickly
-    uint64_t current_time = get_timestamp_us();
-    static uint64_t last_ack_time = 0;
-    
-    if (last_ack_time > 0) {
-        uint64_t ack_interval = current_time - last_ack_time;
+    // Update sync sequence for coordination
+    atomic_store(&lane->sync_sequence, ack_sequence);
+    if (credited == 0) return 0;
+    atomic_fetch_sub(&lane->tx_inflight, credited);
+    UMSBB_TRACE(UMSBB_TRACE_TWIN_TX, UMSBB_TRACE_ACK, lane_id, ack_sequence);
+    
+    // Adaptive window sizing on the per-message ACK interval, so batching
+    // ACKs does not read as a slow peer: grow while messages are
+    // acknowledged within 1 ms of each other, shrink once per slow batch
+    uint64_t current_time = umsbb_clock_us();
+    
+    if (lane->last_ack_us > 0) {
+        uint64_t ack_interval = (current_time - lane->last_ack_us) / credited;
+        uint32_t window = atomic_load(&lane->tx_window_size);
         
-        if (ack_interval < 1000 && lane->tx_window_size < 256) { // < 1ms
-            lane->tx_window_size += 2; // Increase window
-        } else if (ack_interval > 10000 && lane->tx_window_size > 8) { // > 10ms
-            lane->tx_window_size -= 1; // Decrease window
+        if (ack_interval < 1000 && window < TWIN_LANE_MAX_WINDOW) {
+            uint32_t grown = window + 2 * credited;
+            atomic_store(&lane->tx_window_size, grown < TWIN_LANE_MAX_WINDOW ? grown : TWIN_LANE_MAX_WINDOW);
+        } else if (ack_interval > 10000 && window > 8) {
+            atomic_store(&lane->tx_window_size, window - 1);
         }
     }
     
-    last_ack_time = current_time;
+    lane->last_ack_us = current_time;
     
-    // Update sync sequence for coordination
-    atomic_store(&lane->sync_sequence, ack_sequence);
+    return credited;
 }
 
 void twin_lane_get_duplex_metrics(twin_lane_manager_t* manager, uint32_t lane_id, struct duplex_metrics* metrics) {
@@ -285,46 +608,47 @@ void twin_lane_get_duplex_metrics(twin_lane_manager_t* manager, uint32_t lane_id
     
     twin_lane_t* lane = &manager->lanes[lane_id];
     
-    // Calculate rates (simplified - using static variables for demo)
-    static uint64_t last_tx_messages = 0;
-    static uint64_t last_rx_messages = 0;
-    static uint64_t last_tx_bytes = 0;
-    static uint64_t last_rx_bytes = 0;
-    static uint64_t last_timestamp = 0;
+    memset(metrics, 0, sizeof(struct duplex_metrics));
     
-    uint64_t current_time = get_timestamp_us();
-    uint64_t time_diff = current_time - last_timestamp;
+    // Rates since this lane's previous metrics call
+    uint64_t current_time = umsbb_clock_us();
+    uint64_t time_diff = current_time - lane->metrics_timestamp_us;
     
     if (time_diff > 0) {
-        uint64_t tx_msg_diff = lane->tx_messages - last_tx_messages;
-        uint64_t rx_msg_diff = lane->rx_messages - last_rx_messages;
-        uint64_t tx_byte_diff = lane->tx_bytes - last_tx_bytes;
-        uint64_t rx_byte_diff = lane->rx_bytes - last_rx_bytes;
+        uint64_t tx_msg_diff = lane->tx_messages - lane->metrics_tx_messages;
+        uint64_t rx_msg_diff = lane->rx_messages - lane->metrics_rx_messages;
+        uint64_t tx_byte_diff = lane->tx_bytes - lane->metrics_tx_bytes;
+        uint64_t rx_byte_diff = lane->rx_bytes - lane->metrics_rx_bytes;
         
         metrics->tx_messages_per_second = (tx_msg_diff * 1000000) / time_diff;
         metrics->rx_messages_per_second = (rx_msg_diff * 1000000) / time_diff;
         metrics->tx_bytes_per_second = (tx_byte_diff * 1000000) / time_diff;
         metrics->rx_bytes_per_second = (rx_byte_diff * 1000000) / time_diff;
         
-        last_tx_messages = lane->tx_messages;
-        last_rx_messages = lane->rx_messages;
-        last_tx_bytes = lane->tx_bytes;
-        last_rx_bytes = lane->rx_bytes;
-        last_timestamp = current_time;
+        lane->metrics_tx_messages = lane->tx_messages;
+        lane->metrics_rx_messages = lane->rx_messages;
+        lane->metrics_tx_bytes = lane->tx_bytes;
+        lane->metrics_rx_bytes = lane->rx_bytes;
+        lane->metrics_timestamp_us = current_time;
     }
     
-    metrics->tx_latency_us = lane->tx_latency_us;
-    metrics->rx_latency_us = lane->rx_latency_us;
+    latency_histogram_summary(lane->tx_latency, &metrics->tx_latency);
+    latency_histogram_summary(lane->rx_latency, &metrics->rx_latency);
+    metrics->tx_latency_us = metrics->tx_latency.meanNs / 1000.0;
+    metrics->rx_latency_us = metrics->rx_latency.meanNs / 1000.0;
     
     // Calculate duplex efficiency
     double total_bandwidth = metrics->tx_bytes_per_second + metrics->rx_bytes_per_second;
-    double theoretical_max = (double)(lane->tx_capacity + lane->rx_capacity);
+    double theoretical_max = (double)(lane->tx.capacity + lane->rx.capacity);
     metrics->duplex_efficiency = (total_bandwidth / theoretical_max) * 100.0;
     
-    // Calculate congestion levels based on flow control state
+    // Congestion: TX window use, and how full the RX ring is (the peer
+    // may write it directly, so there is no receive-side message count)
     uint32_t tx_inflight = atomic_load(&lane->tx_inflight);
-    uint32_t rx_inflight = atomic_load(&lane->rx_inflight);
     
-    metrics->tx_congestion_level = (tx_inflight * 100) / lane->tx_window_size;
-    metrics->rx_congestion_level = (rx_inflight * 100) / lane->rx_window_size;
+    metrics->tx_congestion_level = (tx_inflight * 100) / atomic_load(&lane->tx_window_size);
+    if (lane->rx.capacity) {
+        uint64_t queued = atomic_load(&lane->rx.shared->head) - atomic_load(&lane->rx.shared->tail);
+        metrics->rx_congestion_level = (uint32_t)(queued * 100 / lane->rx.capacity);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include "umsbb_clock.h"
+#include "portable_atomic.h"
+#include <time.h>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#endif
+#if defined(__EMSCRIPTEN__)
+#  include <emscripten.h>
+#endif
+
+#if defined(__EMSCRIPTEN__)
+    // performance.now() is the only clock there is
+#elif defined(_MSC_VER) && defined(_M_X64)
+#  include <intrin.h>
+#  define UMSBB_CLOCK_TSC 1
+#elif (defined(__x86_64__) || defined(__i386__)) && defined(__SIZEOF_INT128__)
+#  include <cpuid.h>
+#  include <x86intrin.h>
+#  define UMSBB_CLOCK_TSC 1
+#elif defined(__aarch64__) && defined(__SIZEOF_INT128__)
+#  define UMSBB_CLOCK_CNTVCT 1
+#endif
+
+#define UMSBB_CLOCK_SHIFT 32
+#define UMSBB_CLOCK_REFINE_NS 1000000000ull    // Counter time after which the scale is refined
+
+enum {
+    CLOCK_UNCALIBRATED = 0,
+    CLOCK_CALIBRATING = 1,     // Callers use the OS clock meanwhile
+    CLOCK_COUNTER = 2,
+    CLOCK_OS = 3
+};
+
+/* ns = baseNs + ((ticks - baseTicks) * mult) >> UMSBB_CLOCK_SHIFT */
+typedef struct {
+    uint64_t baseTicks;
+    uint64_t baseNs;
+    uint64_t mult;
+} ClockScale;
+
+/* Slot 0 holds the initial calibration and slot 1 the refined one. Each is
+ * written once before clock_current points at it, so readers never see a
+ * scale change under them. */
+static ClockScale clock_scales[2];
+static atomic_u32 clock_current;
+static atomic_u32 clock_state;
+static atomic_u32 clock_refining;
+static uint64_t clock_start_ticks;
+static uint64_t clock_start_ns;
+static uint64_t clock_refine_ticks;
+
+uint64_t umsbb_clock_os_ns(void) {
+#if defined(__EMSCRIPTEN__)
+    return (uint64_t)(emscripten_get_now() * 1000000.0);
+#elif defined(_WIN32)
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER counter;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    uint64_t c = (uint64_t)counter.QuadPart, f = (uint64_t)freq.QuadPart;
+    return (c / f) * 1000000000ull + (c % f) * 1000000000ull / f;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+#if defined(UMSBB_CLOCK_TSC) || defined(UMSBB_CLOCK_CNTVCT)
+
+static inline uint64_t clock_ticks(void) {
+#if defined(UMSBB_CLOCK_TSC)
+    return __rdtsc();
+#else
+    uint64_t v;
+    __asm__ __volatile__("isb\n\tmrs %0, cntvct_el0" : "=r"(v) : : "memory");
+    return v;
+#endif
+}
+
+static inline uint64_t clock_scale(uint64_t ticks, uint64_t mult) {
+#if defined(__SIZEOF_INT128__)
+    return (uint64_t)(((__uint128_t)ticks * mult) >> UMSBB_CLOCK_SHIFT);
+#else
+    uint64_t hi, lo = _umul128(ticks, mult, &hi);
+    return __shiftright128(lo, hi, UMSBB_CLOCK_SHIFT);
+#endif
+}
+
+/* Counter and OS clock read as close together as we can get them. */
+static void clock_sample(uint64_t* ticks, uint64_t* ns) {
+    uint64_t before = clock_ticks();
+    *ns = umsbb_clock_os_ns();
+    uint64_t after = clock_ticks();
+    uint64_t best = after - before;
+    *ticks = before + best / 2;
+    for (int i = 1; i < 5; ++i) {
+        before = clock_ticks();
+        uint64_t os = umsbb_clock_os_ns();
+        after = clock_ticks();
+        if (after - before < best) {
+            best = after - before;
+            *ticks = before + (after - before) / 2;
+            *ns = os;
+        }
+    }
+}
+
+static bool clock_counter_usable(void) {
+#if defined(UMSBB_CLOCK_TSC)
+    // Invariant TSC: constant rate across P-states and halts, synchronised across cores
+    unsigned int regs[4] = {0};
+#  if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, (int)0x80000000);
+    if ((unsigned int)info[0] < 0x80000007u) return false;
+    __cpuid(info, (int)0x80000007);
+    regs[3] = (unsigned int)info[3];
+#  else
+    if (!__get_cpuid(0x80000007u, &regs[0], &regs[1], &regs[2], &regs[3])) return false;
+#  endif
+    return (regs[3] & (1u << 8)) != 0;
+#else
+    return true;
+#endif
+}
+
+static void clock_calibrate(void) {
+    uint64_t t0, n0, t1, n1;
+#if defined(UMSBB_CLOCK_CNTVCT)
+    // The architected counter states its own frequency
+    uint64_t freq;
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(freq));
+    clock_sample(&t1, &n1);
+    t0 = t1;
+    n0 = n1;
+    clock_scales[0].mult = (uint64_t)(1e9 * 4294967296.0 / (double)freq);
+    clock_refine_ticks = UINT64_MAX;
+#else
+    clock_sample(&t0, &n0);
+    do {
+        clock_sample(&t1, &n1);
+    } while (n1 - n0 < UMSBB_CLOCK_CALIBRATION_NS || t1 == t0);
+    double nsPerTick = (double)(n1 - n0) / (double)(t1 - t0);
+    clock_scales[0].mult = (uint64_t)(nsPerTick * 4294967296.0);
+    clock_refine_ticks = (uint64_t)((double)UMSBB_CLOCK_REFINE_NS / nsPerTick);
+#endif
+    clock_scales[0].baseTicks = t1;
+    clock_scales[0].baseNs = n1;
+    clock_start_ticks = t0;
+    clock_start_ns = n0;
+    atomic_store_u32(&clock_current, 0);
+}
+
+/* Re-measure the rate over the whole time since calibration, continuing the
+ * current line from the new anchor so the clock does not step. */
+static void clock_refine(const ClockScale* s) {
+    uint32_t expected = 0;
+    if (atomic_load_u32(&clock_refining) || !atomic_cas_u32(&clock_refining, &expected, 1)) return;
+    uint64_t t, n;
+    clock_sample(&t, &n);
+    ClockScale* next = &clock_scales[1];
+    next->mult = (uint64_t)((double)(n - clock_start_ns) / (double)(t - clock_start_ticks) * 4294967296.0);
+    next->baseTicks = t;
+    next->baseNs = s->baseNs + clock_scale(t - s->baseTicks, s->mult);
+    atomic_store_u32(&clock_current, 1);
+}
+
+#endif
+
+void umsbb_clock_init(void) {
+    uint32_t expected = CLOCK_UNCALIBRATED;
+    if (!atomic_cas_u32(&clock_state, &expected, CLOCK_CALIBRATING)) return;
+#if defined(UMSBB_CLOCK_TSC) || defined(UMSBB_CLOCK_CNTVCT)
+    if (clock_counter_usable()) {
+        clock_calibrate();
+        atomic_store_u32(&clock_state, CLOCK_COUNTER);
+        return;
+    }
+#endif
+    atomic_store_u32(&clock_state, CLOCK_OS);
+}
+
+uint64_t umsbb_clock_ns(void) {
+    uint32_t state = atomic_load_u32(&clock_state);
+    if (state == CLOCK_UNCALIBRATED) {
+        umsbb_clock_init();
+        state = atomic_load_u32(&clock_state);
+    }
+#if defined(UMSBB_CLOCK_TSC) || defined(UMSBB_CLOCK_CNTVCT)
+    if (state == CLOCK_COUNTER) {
+        uint32_t current = atomic_load_u32(&clock_current);
+        const ClockScale* s = &clock_scales[current];
+        int64_t delta = (int64_t)(clock_ticks() - s->baseTicks);
+        // A core whose counter trails the anchor's by a few ticks
+        if (delta < 0) return s->baseNs;
+        if (current == 0 && (uint64_t)delta > clock_refine_ticks) clock_refine(s);
+        return s->baseNs + clock_scale((uint64_t)delta, s->mult);
+    }
+#endif
+    return umsbb_clock_os_ns();
+}
+
+uint64_t umsbb_clock_us(void) {
+    return umsbb_clock_ns() / 1000;
+}
+
+uint64_t umsbb_clock_coarse_ns(void) {
+#if defined(CLOCK_MONOTONIC_COARSE) && !defined(__EMSCRIPTEN__)
+    // vDSO read of the tick-granular clock; no syscall, no counter read
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#else
+    return umsbb_clock_ns();
+#endif
+}
+
+const char* umsbb_clock_source(void) {
+    umsbb_clock_init();
+    if (atomic_load_u32(&clock_state) == CLOCK_COUNTER) {
+#if defined(UMSBB_CLOCK_TSC)
+        return "tsc";
+#else
+        return "cntvct";
+#endif
+    }
+#if defined(__EMSCRIPTEN__)
+    return "emscripten";
+#elif defined(_WIN32)
+    return "qpc";
+#else
+    return "monotonic";
+#endif
+}
@@ -11,8 +11,25 @@
  * - Error handling
  * - Statistics and diagnostics
  * 
- * Compile to WebAssembly: emcc umsbb_complete_core.c -o umsbb_core.wasm
+ * Compile to WebAssembly:
+ *   emcc -Iinclude src/umsbb_complete_core.c src/wasm_kernels.c src/checksum_engine.c src/umsbb_clock.c -o umsbb_core.wasm
  * Or customize and build your own version
+ *
+ * Add -msimd128 (build_core.py --simd) for the SIMD128 variant: payload
+ * copies, the segment scan and the checksum engine run on v128. Runtimes
+ * without SIMD128 reject that module, so ship both and let the connector's
+ * feature test pick one.
+ *
+ * Add -pthread -s SHARED_MEMORY=1 (build_core.py --threads) for workers:
+ * memory becomes a SharedArrayBuffer, the ATOMIC_* macros become wasm
+ * atomics, and every worker running the module can use the same handles.
+ * Writers reserve space in a segment with a CAS on its reserve position, so
+ * any number share one, and publish each record through a commit word in
+ * its header; the segment's one reader at a time stops at the first record
+ * not yet committed. A record that would run past the segment's end leaves
+ * a padding record over the tail and starts at the beginning. Consumers block in
+ * umsbb_wait_message (Atomics.wait) until a write notifies them. A handle
+ * may only be destroyed once no worker is using it.
  */
 
 #include <stdint.h>
@@ -20,6 +37,10 @@
 #include <stdbool.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
+#include "checksum_engine.h"
+#include "umsbb_clock.h"
+#include "wasm_kernels.h"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -28,6 +49,13 @@
 #define WASM_EXPORT
 #endif
 
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <emscripten/threading.h>
+#define UMSBB_SHARED_MEMORY 1
+#else
+#define UMSBB_SHARED_MEMORY 0
+#endif
+
 // =============================================================================
 // CONFIGURATION AND CONSTANTS
 // =============================================================================
@@ -43,11 +71,18 @@
 #define UMSBB_SEGMENT_COUNT 8                     // 8 parallel segments
 #define UMSBB_MAX_BUFFERS 256                     // Maximum concurrent buffers
 #define UMSBB_ALIGNMENT 64                        // Cache line alignment
+#define UMSBB_ALL_SEGMENTS ((1u << UMSBB_SEGMENT_COUNT) - 1)
+#define UMSBB_HANDLE_INDEX_BITS 8                 // log2(UMSBB_MAX_BUFFERS)
+#define UMSBB_HANDLE_INDEX_MASK ((1u << UMSBB_HANDLE_INDEX_BITS) - 1)
 
 // Performance tuning
 #define UMSBB_DEFAULT_BUFFER_SIZE (16 * 1024 * 1024)  // 16MB default
 #define UMSBB_HEADER_SIZE 64                          // Message header size
 #define UMSBB_MAGIC_NUMBER 0x554D5342                 // "UMSB" magic
+#define UMSBB_RECORD_COMMITTED 1                      // Record state: readable
+#define UMSBB_RECORD_PADDING 2                        // Record state: skip to the segment start
+#define UMSBB_RECORD_SKIPPED 3                        // Record state: cancelled reservation
+#define UMSBB_TICKET_SEGMENT_BITS 3                   // Reservation ticket: position << 3 | segment
 
 // Error codes
 typedef enum {
@@ -77,7 +112,10 @@ typedef uint32_t umsbb_handle_t;
     #define ATOMIC_ADD(ptr, val) __atomic_add_fetch(ptr, val, __ATOMIC_ACQ_REL)
     #define ATOMIC_SUB(ptr, val) __atomic_sub_fetch(ptr, val, __ATOMIC_ACQ_REL)
     #define ATOMIC_CAS(ptr, expected, desired) __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+    #define ATOMIC_OR(ptr, val) __atomic_fetch_or(ptr, val, __ATOMIC_SEQ_CST)
+    #define ATOMIC_AND(ptr, val) __atomic_fetch_and(ptr, val, __ATOMIC_SEQ_CST)
     #define MEMORY_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+    #define LOWEST_BIT(mask) ((uint32_t)__builtin_ctz(mask))
 #elif defined(_MSC_VER)
     #include <intrin.h>
     #define ATOMIC_LOAD(ptr) (*(volatile typeof(*ptr)*)(ptr))
@@ -85,7 +123,15 @@ typedef uint32_t umsbb_handle_t;
     #define ATOMIC_ADD(ptr, val) _InterlockedAdd((volatile long*)(ptr), (val))
     #define ATOMIC_SUB(ptr, val) _InterlockedAdd((volatile long*)(ptr), -(val))
     #define ATOMIC_CAS(ptr, expected, desired) (_InterlockedCompareExchange((volatile long*)(ptr), (desired), (expected)) == (expected))
+    #define ATOMIC_OR(ptr, val) _InterlockedOr((volatile long*)(ptr), (long)(val))
+    #define ATOMIC_AND(ptr, val) _InterlockedAnd((volatile long*)(ptr), (long)(val))
     #define MEMORY_BARRIER() _ReadWriteBarrier()
+    static __inline uint32_t umsbb_lowest_bit(uint32_t mask) {
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (uint32_t)index;
+    }
+    #define LOWEST_BIT(mask) umsbb_lowest_bit(mask)
 #else
     // Fallback for other compilers (not thread-safe)
     #define ATOMIC_LOAD(ptr) (*(ptr))
@@ -93,7 +139,15 @@ typedef uint32_t umsbb_handle_t;
     #define ATOMIC_ADD(ptr, val) (*(ptr) += (val))
     #define ATOMIC_SUB(ptr, val) (*(ptr) -= (val))
     #define ATOMIC_CAS(ptr, expected, desired) ((*(ptr) == *(expected)) ? (*(ptr) = (desired), true) : (*(expected) = *(ptr), false))
+    #define ATOMIC_OR(ptr, val) (*(ptr) |= (val))
+    #define ATOMIC_AND(ptr, val) (*(ptr) &= (val))
     #define MEMORY_BARRIER()
+    static uint32_t umsbb_lowest_bit(uint32_t mask) {
+        uint32_t index = 0;
+        while (!(mask & 1u)) { mask >>= 1; index++; }
+        return index;
+    }
+    #define LOWEST_BIT(mask) umsbb_lowest_bit(mask)
 #endif
 
 // =============================================================================
@@ -107,20 +161,26 @@ typedef struct {
     uint64_t sequence;       // Sequence number
     uint64_t timestamp;      // Timestamp
     uint32_t checksum;       // Data checksum
-    uint32_t flags;          // Message flags
-    uint8_t reserved[32];    // Reserved for future use
+    uint32_t flags;          // Message flags (low bits: checksum_policy_t)
+    uint32_t span;           // Bytes the record occupies, header included
+    volatile uint32_t state; // Commit word: 0 until the writer publishes the record
+    uint8_t reserved[24];    // Reserved for future use
 } umsbb_message_header_t;
 
+_Static_assert(sizeof(umsbb_message_header_t) == UMSBB_HEADER_SIZE, "record header is one cache line");
+_Static_assert(UMSBB_SEGMENT_COUNT == 1u << UMSBB_TICKET_SEGMENT_BITS, "ticket names every segment");
+
 // Buffer segment structure
 typedef struct {
     volatile uint64_t read_pos;      // Current read position
-    volatile uint64_t write_pos;     // Current write position
+    volatile uint64_t reserve_pos;   // End of the space writers have reserved
     volatile uint64_t message_count; // Messages in this segment
     volatile uint32_t active;        // Segment active flag
+    volatile uint32_t read_claim;    // Held by the one reader consuming here
     uint8_t* data;                   // Segment data pointer
     uint32_t size;                   // Segment size
     uint32_t segment_id;             // Segment identifier
-    uint8_t padding[32];             // Cache line padding
+    uint8_t padding[28];             // Cache line padding
 } umsbb_segment_t;
 
 // Main buffer structure
@@ -147,7 +207,9 @@ typedef struct {
     // Configuration
     uint32_t max_message_size;
     uint32_t segment_size;
+    volatile uint32_t checksum_policy; // checksum_policy_t for new messages
     volatile uint32_t active_segments;
+    volatile uint32_t ready_mask;    // Bit per segment holding messages; set on write, cleared when drained empty
     volatile uint32_t initialized;
     
     // Performance tracking
@@ -155,38 +217,41 @@ typedef struct {
     volatile uint64_t last_read_time;
     volatile uint32_t peak_pending_messages;
     volatile uint32_t current_pending_messages;
+    volatile uint32_t wake_sequence; // Bumped per write; consumers wait on it
     
-    uint8_t padding[128];            // Cache line padding
+    uint8_t padding[124];            // Cache line padding
 } umsbb_buffer_t;
 
-// Global buffer registry
-static umsbb_buffer_t* g_buffers[UMSBB_MAX_BUFFERS] = {0};
-static volatile uint32_t g_next_handle = 1;
+// Handle table. A handle packs a slot index (low bits; 0 is never used, so
+// no handle is 0) with the slot's generation, which destroy bumps: a stale
+// handle stops matching the moment its buffer goes. Freed slots go on a
+// lock-free list whose head carries an ABA tag in its high half.
+typedef struct {
+    volatile uint32_t handle;        // Live handle, 0 while free
+    volatile uint32_t generation;    // Generation the next handle gets
+    volatile uint32_t next_free;     // Free-list link
+    umsbb_buffer_t* volatile buffer;
+} umsbb_handle_slot_t;
+
+_Static_assert(UMSBB_MAX_BUFFERS == 1u << UMSBB_HANDLE_INDEX_BITS, "handle index covers the table");
+
+static umsbb_handle_slot_t g_handle_slots[UMSBB_MAX_BUFFERS];
+static volatile uint64_t g_free_slots = 0;      // Top free index | tag << 32
+static volatile uint32_t g_unused_slots = 1;    // Lowest index never handed out
 static volatile uint32_t g_active_buffers = 0;
 
 // =============================================================================
 // UTILITY FUNCTIONS
 // =============================================================================
 
-// Get current timestamp
+// Get current timestamp in microseconds
 static uint64_t umsbb_get_timestamp(void) {
-    #ifdef __EMSCRIPTEN__
-        return (uint64_t)(emscripten_get_now() * 1000000.0); // Convert to microseconds
-    #else
-        // Fallback timestamp (not precise)
-        static uint64_t counter = 0;
-        return ATOMIC_ADD(&counter, 1);
-    #endif
+    return umsbb_clock_us();
 }
 
-// Calculate simple checksum
-static uint32_t umsbb_calculate_checksum(const void* data, uint32_t size) {
-    const uint8_t* bytes = (const uint8_t*)data;
-    uint32_t checksum = 0;
-    for (uint32_t i = 0; i < size; i++) {
-        checksum = (checksum * 31) + bytes[i];
-    }
-    return checksum;
+// Checksum message data with the shared engine
+static uint32_t umsbb_calculate_checksum(uint32_t policy, const void* data, uint32_t size) {
+    return checksum_compute((checksum_policy_t)(policy & CHECKSUM_POLICY_MASK), data, size);
 }
 
 // Align size to cache line boundary
@@ -194,57 +259,102 @@ static uint32_t umsbb_align_size(uint32_t size) {
     return (size + UMSBB_ALIGNMENT - 1) & ~(UMSBB_ALIGNMENT - 1);
 }
 
-// Get next available handle
-static uint32_t umsbb_get_next_handle(void) {
-    uint32_t handle;
+// Take a free handle slot: a recycled one, else one never used; 0 when
+// every slot is live
+static uint32_t umsbb_alloc_slot(void) {
+    for (;;) {
+        uint64_t head = ATOMIC_LOAD(&g_free_slots);
+        while ((uint32_t)head) {
+            uint32_t index = (uint32_t)head;
+            uint64_t next = (((head >> 32) + 1) << 32) | ATOMIC_LOAD(&g_handle_slots[index].next_free);
+            if (ATOMIC_CAS(&g_free_slots, &head, next)) return index;
+        }
+        
+        uint32_t unused = ATOMIC_LOAD(&g_unused_slots);
+        while (unused < UMSBB_MAX_BUFFERS) {
+            if (ATOMIC_CAS(&g_unused_slots, &unused, unused + 1)) return unused;
+        }
+        
+        // A slot freed while we looked is worth another pass
+        if (!(uint32_t)ATOMIC_LOAD(&g_free_slots)) return 0;
+    }
+}
+
+static void umsbb_free_slot(uint32_t index) {
+    uint64_t head = ATOMIC_LOAD(&g_free_slots);
+    uint64_t next;
     do {
-        handle = ATOMIC_ADD(&g_next_handle, 1);
-    } while (handle == 0 || handle >= UMSBB_MAX_BUFFERS);
-    return handle;
+        ATOMIC_STORE(&g_handle_slots[index].next_free, (uint32_t)head);
+        next = (((head >> 32) + 1) << 32) | index;
+    } while (!ATOMIC_CAS(&g_free_slots, &head, next));
 }
 
-// Find buffer by handle
+// Find buffer by handle: one compare against the slot's live handle
 static umsbb_buffer_t* umsbb_find_buffer(umsbb_handle_t handle) {
-    if (handle == 0 || handle >= UMSBB_MAX_BUFFERS) {
-        return NULL;
-    }
-    
-    umsbb_buffer_t* buffer = g_buffers[handle];
-    if (buffer && ATOMIC_LOAD(&buffer->initialized) && buffer->magic == UMSBB_MAGIC_NUMBER) {
-        return buffer;
+    umsbb_handle_slot_t* slot = &g_handle_slots[handle & UMSBB_HANDLE_INDEX_MASK];
+    if (handle != 0 && ATOMIC_LOAD(&slot->handle) == handle) {
+        return slot->buffer;
     }
     
     return NULL;
 }
 
+// Blocks the calling worker; emscripten spins instead on the browser main
+// thread, where Atomics.wait is not allowed
+static void umsbb_futex_wait(volatile uint32_t* word, uint32_t expected, double timeout_ms) {
+#if UMSBB_SHARED_MEMORY
+    emscripten_futex_wait(word, expected, timeout_ms);
+#else
+    (void)word; (void)expected; (void)timeout_ms;
+#endif
+}
+
+static void umsbb_futex_wake(volatile uint32_t* word) {
+#if UMSBB_SHARED_MEMORY
+    emscripten_futex_wake(word, INT_MAX);
+#else
+    (void)word;
+#endif
+}
+
+// Take one side of a segment; a worker that loses tries another segment
+static bool umsbb_try_claim(volatile uint32_t* side) {
+    uint32_t expected = 0;
+    return ATOMIC_LOAD(side) == 0 && ATOMIC_CAS(side, &expected, 1);
+}
+
+static void umsbb_release(volatile uint32_t* side) {
+    ATOMIC_STORE(side, 0);
+}
+
 // Select optimal segment for writing
 static uint32_t umsbb_select_write_segment(umsbb_buffer_t* buffer) {
-    uint32_t best_segment = 0;
-    uint64_t min_pending = UINT64_MAX;
-    
+    // An empty segment has the least pending data; only scan when none is
+    uint32_t empty = ~ATOMIC_LOAD(&buffer->ready_mask) & UMSBB_ALL_SEGMENTS;
+    if (empty) return LOWEST_BIT(empty);
+
+    // Pending bytes never exceed the 32-bit segment size; inactive segments
+    // rank last
+    uint32_t pending[UMSBB_SEGMENT_COUNT];
     for (uint32_t i = 0; i < UMSBB_SEGMENT_COUNT; i++) {
-        if (ATOMIC_LOAD(&buffer->segments[i].active)) {
-            uint64_t pending = ATOMIC_LOAD(&buffer->segments[i].write_pos) - 
-                              ATOMIC_LOAD(&buffer->segments[i].read_pos);
-            if (pending < min_pending) {
-                min_pending = pending;
-                best_segment = i;
-            }
-        }
+        pending[i] = ATOMIC_LOAD(&buffer->segments[i].active)
+            ? (uint32_t)(ATOMIC_LOAD(&buffer->segments[i].reserve_pos) - ATOMIC_LOAD(&buffer->segments[i].read_pos))
+            : UINT32_MAX;
     }
     
-    return best_segment;
+    return wasm_min_index(pending, UMSBB_SEGMENT_COUNT);
 }
 
-// Select optimal segment for reading
-static uint32_t umsbb_select_read_segment(umsbb_buffer_t* buffer) {
-    for (uint32_t i = 0; i < UMSBB_SEGMENT_COUNT; i++) {
-        if (ATOMIC_LOAD(&buffer->segments[i].active) && 
-            ATOMIC_LOAD(&buffer->segments[i].message_count) > 0) {
-            return i;
-        }
+// Claim the lowest segment holding messages that no other reader holds,
+// passing over those in `skip`; UMSBB_SEGMENT_COUNT when there is none
+static uint32_t umsbb_claim_read_segment(umsbb_buffer_t* buffer, uint32_t skip) {
+    uint32_t ready = ATOMIC_LOAD(&buffer->ready_mask) & ~skip;
+    while (ready) {
+        uint32_t segment_idx = LOWEST_BIT(ready);
+        if (umsbb_try_claim(&buffer->segments[segment_idx].read_claim)) return segment_idx;
+        ready &= ready - 1;
     }
-    return 0; // Default to first segment
+    return UMSBB_SEGMENT_COUNT;
 }
 
 // =============================================================================
@@ -264,7 +374,7 @@ static int umsbb_init_segment(umsbb_segment_t* segment, uint32_t segment_id,
     segment->data = memory;
     segment->size = size;
     ATOMIC_STORE(&segment->read_pos, 0);
-    ATOMIC_STORE(&segment->write_pos, 0);
+    ATOMIC_STORE(&segment->reserve_pos, 0);
     ATOMIC_STORE(&segment->message_count, 0);
     ATOMIC_STORE(&segment->active, 1);
     
@@ -289,8 +399,8 @@ WASM_EXPORT umsbb_handle_t umsbb_create_buffer(uint32_t size_mb) {
         return 0;
     }
     
-    // Allocate buffer memory
-    uint8_t* buffer_memory = (uint8_t*)malloc(total_size + UMSBB_ALIGNMENT);
+    // Allocate buffer memory; zeroed, so every record starts unpublished
+    uint8_t* buffer_memory = (uint8_t*)calloc(1, total_size + UMSBB_ALIGNMENT);
     if (!buffer_memory) {
         free(buffer);
         return 0;
@@ -301,12 +411,14 @@ WASM_EXPORT umsbb_handle_t umsbb_create_buffer(uint32_t size_mb) {
                                         ~(UMSBB_ALIGNMENT - 1));
     
     // Get handle
-    uint32_t handle = umsbb_get_next_handle();
-    if (handle == 0 || handle >= UMSBB_MAX_BUFFERS) {
+    uint32_t index = umsbb_alloc_slot();
+    if (index == 0) {
         free(buffer_memory);
         free(buffer);
         return 0;
     }
+    umsbb_handle_slot_t* slot = &g_handle_slots[index];
+    uint32_t handle = (ATOMIC_LOAD(&slot->generation) << UMSBB_HANDLE_INDEX_BITS) | index;
     
     // Initialize buffer structure
     memset(buffer, 0, sizeof(umsbb_buffer_t));
@@ -318,12 +430,14 @@ WASM_EXPORT umsbb_handle_t umsbb_create_buffer(uint32_t size_mb) {
     buffer->buffer_memory = buffer_memory;
     buffer->max_message_size = UMSBB_MAX_MESSAGE_SIZE;
     buffer->segment_size = segment_size;
+    buffer->checksum_policy = CHECKSUM_POLICY_DEFAULT;
     
     // Initialize segments
     for (uint32_t i = 0; i < UMSBB_SEGMENT_COUNT; i++) {
         uint8_t* segment_memory = aligned_memory + (i * segment_size);
         if (umsbb_init_segment(&buffer->segments[i], i, segment_memory, segment_size) != UMSBB_SUCCESS) {
             // Cleanup on failure
+            umsbb_free_slot(index);
             free(buffer_memory);
             free(buffer);
             return 0;
@@ -332,16 +446,77 @@ WASM_EXPORT umsbb_handle_t umsbb_create_buffer(uint32_t size_mb) {
     
     ATOMIC_STORE(&buffer->active_segments, UMSBB_SEGMENT_COUNT);
     
-    // Register buffer
-    g_buffers[handle] = buffer;
+    ATOMIC_STORE(&buffer->initialized, 1);
     ATOMIC_ADD(&g_active_buffers, 1);
     
-    // Mark as initialized (must be last)
-    ATOMIC_STORE(&buffer->initialized, 1);
+    // Register buffer; publishing the handle must be last
+    slot->buffer = buffer;
+    ATOMIC_STORE(&slot->handle, handle);
     
     return handle;
 }
 
+// Commit word of the record starting `offset` bytes into a segment
+static volatile uint32_t* umsbb_record_state(umsbb_segment_t* segment, uint32_t offset) {
+    return (volatile uint32_t*)(segment->data + offset + offsetof(umsbb_message_header_t, state));
+}
+
+// Reserve a record of `total_size` bytes. When it would run past the end of
+// the segment the tail is reserved with it and published as a padding
+// record, so a wrap costs at most one record's worth of space. Returns the
+// record's position, or UINT64_MAX when the segment has no room.
+static uint64_t umsbb_reserve_record(umsbb_segment_t* segment, uint32_t total_size) {
+    uint64_t position = ATOMIC_LOAD(&segment->reserve_pos);
+    for (;;) {
+        uint32_t offset = (uint32_t)(position % segment->size);
+        uint32_t tail = segment->size - offset;
+        uint32_t padding = total_size > tail ? tail : 0;
+        if (position + padding + total_size > ATOMIC_LOAD(&segment->read_pos) + segment->size) {
+            return UINT64_MAX;
+        }
+        if (ATOMIC_CAS(&segment->reserve_pos, &position, position + padding + total_size)) {
+            if (padding) {
+                ATOMIC_STORE(umsbb_record_state(segment, offset), UMSBB_RECORD_PADDING);
+            }
+            return position + padding;
+        }
+    }
+}
+
+// Copy a record into its reserved space and publish it; NULL `data` means
+// the payload was built in place. The count goes up first so a reader
+// taking the record never sees it at zero.
+static void umsbb_commit_record(umsbb_segment_t* segment, uint64_t position,
+                                const umsbb_message_header_t* header, const void* data) {
+    uint32_t offset = (uint32_t)(position % segment->size);
+    memcpy(segment->data + offset, header, offsetof(umsbb_message_header_t, state));
+    if (data) {
+        wasm_copy_bytes(segment->data + offset + sizeof(*header), data, header->size);
+    }
+    ATOMIC_ADD(&segment->message_count, 1);
+    ATOMIC_STORE(umsbb_record_state(segment, offset), UMSBB_RECORD_COMMITTED);
+}
+
+// Publish `count` messages committed to a segment
+static void umsbb_publish_writes(umsbb_buffer_t* buffer, uint32_t segment_idx, uint32_t count,
+                                 uint64_t bytes, uint64_t timestamp) {
+    // Publish the segment as readable; the fence pairs with the reader's
+    // clear-then-recheck so the bit is never left clear over a message
+    MEMORY_BARRIER();
+    uint32_t segment_bit = 1u << segment_idx;
+    if (!(ATOMIC_LOAD(&buffer->ready_mask) & segment_bit)) ATOMIC_OR(&buffer->ready_mask, segment_bit);
+    ATOMIC_ADD(&buffer->total_bytes_written, bytes);
+    ATOMIC_ADD(&buffer->write_operations, count);
+    ATOMIC_STORE(&buffer->last_write_time, timestamp);
+    
+    // Update pending message count
+    uint32_t pending = ATOMIC_ADD(&buffer->current_pending_messages, count);
+    uint32_t peak = ATOMIC_LOAD(&buffer->peak_pending_messages);
+    if (pending > peak) {
+        ATOMIC_STORE(&buffer->peak_pending_messages, pending);
+    }
+}
+
 // Write message to buffer
 WASM_EXPORT int umsbb_write_message(umsbb_handle_t handle, const void* data, uint32_t size) {
     // Validate parameters
@@ -355,69 +530,351 @@ WASM_EXPORT int umsbb_write_message(umsbb_handle_t handle, const void* data, uin
         return UMSBB_ERROR_INVALID_HANDLE;
     }
     
-    // Select segment
-    uint32_t segment_idx = umsbb_select_write_segment(buffer);
-    umsbb_segment_t* segment = &buffer->segments[segment_idx];
+    // Prepare message header; the checksum is taken before reserving so the
+    // record is unpublished for no longer than the copy
+    umsbb_message_header_t header;
+    memset(&header, 0, sizeof(header));
+    
+    header.magic = UMSBB_MAGIC_NUMBER;
+    header.size = size;
+    header.timestamp = umsbb_get_timestamp();
+    header.flags = ATOMIC_LOAD(&buffer->checksum_policy);
+    header.checksum = umsbb_calculate_checksum(header.flags, data, size);
     
     // Calculate total message size (header + data)
     uint32_t total_size = sizeof(umsbb_message_header_t) + size;
     total_size = umsbb_align_size(total_size);
     
-    // Check available space
-    uint64_t current_write = ATOMIC_LOAD(&segment->write_pos);
-    uint64_t current_read = ATOMIC_LOAD(&segment->read_pos);
-    
-    if (current_write + total_size > current_read + segment->size) {
+    // Select segment and reserve space in it; other writers share it
+    uint32_t segment_idx = umsbb_select_write_segment(buffer);
+    umsbb_segment_t* segment = &buffer->segments[segment_idx];
+    uint64_t position = umsbb_reserve_record(segment, total_size);
+    if (position == UINT64_MAX) {
         ATOMIC_ADD(&buffer->failed_writes, 1);
         return UMSBB_ERROR_BUFFER_FULL;
     }
     
-    // Prepare message header
+    header.span = total_size;
+    header.sequence = ATOMIC_ADD(&buffer->total_messages_written, 1);
+    umsbb_commit_record(segment, position, &header, data);
+    umsbb_publish_writes(buffer, segment_idx, 1, size, header.timestamp);
+    
+    MEMORY_BARRIER();
+    
+    // Wake consumers parked in umsbb_wait_message or on Atomics.wait
+    ATOMIC_ADD(&buffer->wake_sequence, 1);
+    umsbb_futex_wake(&buffer->wake_sequence);
+    
+    return UMSBB_SUCCESS;
+}
+
+// Write `count` messages packed back to back at `data`, `lengths[i]` bytes
+// each, so JS crosses into wasm once per batch. Messages go to one segment
+// until it fills, then to the best other one, and consumers are woken once.
+// Returns how many were written, stopping at the first invalid length or
+// when no segment has room, or the error when that was the first message.
+WASM_EXPORT int umsbb_write_batch(umsbb_handle_t handle, const void* data,
+                                  const uint32_t* lengths, uint32_t count) {
+    // Validate parameters
+    if (!data || !lengths || count > INT_MAX) {
+        return UMSBB_ERROR_INVALID_PARAMS;
+    }
+    
+    // Find buffer
+    umsbb_buffer_t* buffer = umsbb_find_buffer(handle);
+    if (!buffer) {
+        return UMSBB_ERROR_INVALID_HANDLE;
+    }
+    
+    const uint8_t* next = (const uint8_t*)data;
+    uint32_t written = 0;
+    int error = UMSBB_SUCCESS;
+    
     umsbb_message_header_t header;
     memset(&header, 0, sizeof(header));
-    
     header.magic = UMSBB_MAGIC_NUMBER;
-    header.size = size;
-    header.sequence = ATOMIC_ADD(&buffer->total_messages_written, 1);
     header.timestamp = umsbb_get_timestamp();
-    header.checksum = umsbb_calculate_checksum(data, size);
-    header.flags = 0;
+    header.flags = ATOMIC_LOAD(&buffer->checksum_policy);
     
-    // Calculate write position in buffer
-    uint32_t write_offset = current_write % segment->size;
+    uint32_t segment_idx = umsbb_select_write_segment(buffer);
+    uint32_t placed = 0;
+    uint64_t bytes = 0;
+    
+    for (; written < count; written++) {
+        uint32_t size = lengths[written];
+        if (size == 0 || size > UMSBB_MAX_MESSAGE_SIZE) {
+            error = UMSBB_ERROR_INVALID_PARAMS;
+            break;
+        }
+        uint32_t total_size = umsbb_align_size(sizeof(umsbb_message_header_t) + size);
+        header.size = size;
+        header.span = total_size;
+        header.checksum = umsbb_calculate_checksum(header.flags, next, size);
+        
+        uint64_t position = umsbb_reserve_record(&buffer->segments[segment_idx], total_size);
+        if (position == UINT64_MAX) {
+            // This segment is full: publish what it took and try the best other one
+            if (placed > 0) {
+                umsbb_publish_writes(buffer, segment_idx, placed, bytes, header.timestamp);
+                placed = 0;
+                bytes = 0;
+            }
+            uint32_t best = umsbb_select_write_segment(buffer);
+            if (best != segment_idx) {
+                segment_idx = best;
+                position = umsbb_reserve_record(&buffer->segments[segment_idx], total_size);
+            }
+            if (position == UINT64_MAX) {
+                ATOMIC_ADD(&buffer->failed_writes, 1);
+                error = UMSBB_ERROR_BUFFER_FULL;
+                break;
+            }
+        }
+        
+        header.sequence = ATOMIC_ADD(&buffer->total_messages_written, 1);
+        umsbb_commit_record(&buffer->segments[segment_idx], position, &header, next);
+        next += size;
+        bytes += size;
+        placed++;
+    }
     
-    // Handle wrap-around
-    if (write_offset + total_size > segment->size) {
-        // Reset to beginning of segment
-        write_offset = 0;
-        current_write = current_read + segment->size; // Skip to next cycle
+    if (placed > 0) {
+        umsbb_publish_writes(buffer, segment_idx, placed, bytes, header.timestamp);
     }
     
-    // Write header
-    memcpy(segment->data + write_offset, &header, sizeof(header));
+    if (written > 0) {
+        MEMORY_BARRIER();
+        ATOMIC_ADD(&buffer->wake_sequence, 1);
+        umsbb_futex_wake(&buffer->wake_sequence);
+    }
     
-    // Write data
-    memcpy(segment->data + write_offset + sizeof(header), data, size);
+    return (written > 0 || count == 0) ? (int)written : error;
+}
+
+// Reserve room for a message of up to `size` bytes and return where its
+// payload goes, so a producer can build it in place. Pass `*ticket` to
+// umsbb_commit_message with the bytes actually written, or to
+// umsbb_cancel_message. Until then the record holds back the readers of
+// its segment, so fill it promptly. NULL when the buffer is full.
+WASM_EXPORT void* umsbb_reserve_message(umsbb_handle_t handle, uint32_t size, uint64_t* ticket) {
+    if (!ticket || size == 0 || size > UMSBB_MAX_MESSAGE_SIZE) {
+        return NULL;
+    }
     
-    // Update positions
-    ATOMIC_STORE(&segment->write_pos, current_write + total_size);
-    ATOMIC_ADD(&segment->message_count, 1);
-    ATOMIC_ADD(&buffer->total_bytes_written, size);
-    ATOMIC_ADD(&buffer->write_operations, 1);
-    ATOMIC_STORE(&buffer->last_write_time, header.timestamp);
+    umsbb_buffer_t* buffer = umsbb_find_buffer(handle);
+    if (!buffer) {
+        return NULL;
+    }
     
-    // Update pending message count
-    uint32_t pending = ATOMIC_ADD(&buffer->current_pending_messages, 1);
-    uint32_t peak = ATOMIC_LOAD(&buffer->peak_pending_messages);
-    if (pending > peak) {
-        ATOMIC_STORE(&buffer->peak_pending_messages, pending);
+    uint32_t total_size = umsbb_align_size(sizeof(umsbb_message_header_t) + size);
+    uint32_t segment_idx = umsbb_select_write_segment(buffer);
+    umsbb_segment_t* segment = &buffer->segments[segment_idx];
+    uint64_t position = umsbb_reserve_record(segment, total_size);
+    if (position == UINT64_MAX) {
+        ATOMIC_ADD(&buffer->failed_writes, 1);
+        return NULL;
     }
     
+    // The span goes in now so commit and cancel know the record's extent
+    umsbb_message_header_t* record = (umsbb_message_header_t*)(segment->data + position % segment->size);
+    record->span = total_size;
+    *ticket = (position << UMSBB_TICKET_SEGMENT_BITS) | segment_idx;
+    return (uint8_t*)record + sizeof(*record);
+}
+
+// The unpublished record a ticket names, or NULL for a ticket that names none
+static umsbb_message_header_t* umsbb_ticket_record(umsbb_buffer_t* buffer, uint64_t ticket,
+                                                   umsbb_segment_t** segment_out) {
+    umsbb_segment_t* segment = &buffer->segments[ticket & (UMSBB_SEGMENT_COUNT - 1)];
+    uint64_t position = ticket >> UMSBB_TICKET_SEGMENT_BITS;
+    if (position < ATOMIC_LOAD(&segment->read_pos) || position >= ATOMIC_LOAD(&segment->reserve_pos)) {
+        return NULL;
+    }
+    uint32_t offset = (uint32_t)(position % segment->size);
+    if (offset % UMSBB_ALIGNMENT != 0 || ATOMIC_LOAD(umsbb_record_state(segment, offset)) != 0) {
+        return NULL;
+    }
+    *segment_out = segment;
+    return (umsbb_message_header_t*)(segment->data + offset);
+}
+
+// Publish a reserved message of `size` bytes (at most what was reserved)
+WASM_EXPORT int umsbb_commit_message(umsbb_handle_t handle, uint64_t ticket, uint32_t size) {
+    umsbb_buffer_t* buffer = umsbb_find_buffer(handle);
+    if (!buffer) {
+        return UMSBB_ERROR_INVALID_HANDLE;
+    }
+    
+    umsbb_segment_t* segment;
+    umsbb_message_header_t* record = umsbb_ticket_record(buffer, ticket, &segment);
+    if (!record || size == 0 || size > record->span - sizeof(*record)) {
+        return UMSBB_ERROR_INVALID_PARAMS;
+    }
+    
+    umsbb_message_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = UMSBB_MAGIC_NUMBER;
+    header.size = size;
+    header.span = record->span;
+    header.timestamp = umsbb_get_timestamp();
+    header.flags = ATOMIC_LOAD(&buffer->checksum_policy);
+    header.checksum = umsbb_calculate_checksum(header.flags, (uint8_t*)record + sizeof(header), size);
+    header.sequence = ATOMIC_ADD(&buffer->total_messages_written, 1);
+    
+    uint32_t segment_idx = (uint32_t)(ticket & (UMSBB_SEGMENT_COUNT - 1));
+    umsbb_commit_record(segment, ticket >> UMSBB_TICKET_SEGMENT_BITS, &header, NULL);
+    umsbb_publish_writes(buffer, segment_idx, 1, size, header.timestamp);
+    
     MEMORY_BARRIER();
+    ATOMIC_ADD(&buffer->wake_sequence, 1);
+    umsbb_futex_wake(&buffer->wake_sequence);
+    
+    return UMSBB_SUCCESS;
+}
+
+// Give a reservation up; readers pass over its space
+WASM_EXPORT int umsbb_cancel_message(umsbb_handle_t handle, uint64_t ticket) {
+    umsbb_buffer_t* buffer = umsbb_find_buffer(handle);
+    if (!buffer) {
+        return UMSBB_ERROR_INVALID_HANDLE;
+    }
+    
+    umsbb_segment_t* segment;
+    umsbb_message_header_t* record = umsbb_ticket_record(buffer, ticket, &segment);
+    if (!record) {
+        return UMSBB_ERROR_INVALID_PARAMS;
+    }
+    ATOMIC_STORE(&record->state, UMSBB_RECORD_SKIPPED);
+    return UMSBB_SUCCESS;
+}
+
+// Clear the commit word at every record boundary in a consumed span: a later
+// record may start at any of them and must read as unpublished until its
+// writer commits it
+static void umsbb_clear_span(umsbb_segment_t* segment, uint32_t offset, uint32_t span) {
+    for (uint32_t at = offset; at < offset + span; at += UMSBB_ALIGNMENT) {
+        ATOMIC_STORE(umsbb_record_state(segment, at), 0);
+    }
+}
+
+// Find the next committed record of a claimed read segment, passing over
+// padding and cancelled records, and copy its header to `header`. Records
+// are found in reservation order, so one whose writer is still copying holds
+// back the records behind it.
+static int umsbb_next_record(umsbb_buffer_t* buffer, umsbb_segment_t* segment,
+                             umsbb_message_header_t* header, uint64_t* position) {
+    // Check if there are messages available
+    if (ATOMIC_LOAD(&segment->message_count) == 0) {
+        return UMSBB_ERROR_BUFFER_EMPTY;
+    }
+    
+    for (;;) {
+        // Get current positions
+        uint64_t current_read = ATOMIC_LOAD(&segment->read_pos);
+        if (current_read >= ATOMIC_LOAD(&segment->reserve_pos)) {
+            return UMSBB_ERROR_BUFFER_EMPTY;
+        }
+        
+        // Calculate read position in buffer
+        uint32_t read_offset = current_read % segment->size;
+        uint32_t state = ATOMIC_LOAD(umsbb_record_state(segment, read_offset));
+        
+        if (state == UMSBB_RECORD_PADDING) {
+            // Skip the tail a wrapping writer left unused
+            uint32_t span = segment->size - read_offset;
+            umsbb_clear_span(segment, read_offset, span);
+            ATOMIC_STORE(&segment->read_pos, current_read + span);
+            continue;
+        }
+        if (state != UMSBB_RECORD_COMMITTED && state != UMSBB_RECORD_SKIPPED) {
+            return UMSBB_ERROR_BUFFER_EMPTY;
+        }
+        
+        // Read message header
+        memcpy(header, segment->data + read_offset, offsetof(umsbb_message_header_t, state));
+        uint32_t total_size = header->span;
+        
+        // Validate header
+        if (total_size < sizeof(*header) || total_size % UMSBB_ALIGNMENT != 0 ||
+            read_offset + total_size > segment->size) {
+            ATOMIC_ADD(&buffer->failed_reads, 1);
+            return UMSBB_ERROR_CORRUPTED_DATA;
+        }
+        if (state == UMSBB_RECORD_SKIPPED) {
+            umsbb_clear_span(segment, read_offset, total_size);
+            ATOMIC_STORE(&segment->read_pos, current_read + total_size);
+            continue;
+        }
+        if (header->magic != UMSBB_MAGIC_NUMBER || header->size > total_size - sizeof(*header)) {
+            ATOMIC_ADD(&buffer->failed_reads, 1);
+            return UMSBB_ERROR_CORRUPTED_DATA;
+        }
+        
+        *position = current_read;
+        return UMSBB_SUCCESS;
+    }
+}
+
+// Verify a record's payload with the policy its writer recorded
+static bool umsbb_payload_intact(umsbb_buffer_t* buffer, const umsbb_message_header_t* header,
+                                 const void* payload) {
+    if ((header->flags & CHECKSUM_POLICY_MASK) != CHECKSUM_POLICY_NONE &&
+        umsbb_calculate_checksum(header->flags, payload, header->size) != header->checksum) {
+        ATOMIC_ADD(&buffer->failed_reads, 1);
+        return false;
+    }
+    return true;
+}
+
+// Hand a consumed record's space back to writers
+static void umsbb_retire_record(umsbb_buffer_t* buffer, uint32_t segment_idx,
+                                uint64_t position, uint32_t span) {
+    umsbb_segment_t* segment = &buffer->segments[segment_idx];
+    umsbb_clear_span(segment, (uint32_t)(position % segment->size), span);
+    ATOMIC_STORE(&segment->read_pos, position + span);
+    if (ATOMIC_SUB(&segment->message_count, 1) == 0) {
+        uint32_t segment_bit = 1u << segment_idx;
+        ATOMIC_AND(&buffer->ready_mask, ~segment_bit);
+        if (ATOMIC_LOAD(&segment->message_count) > 0) ATOMIC_OR(&buffer->ready_mask, segment_bit);
+    }
+}
+
+// Take the next record from a claimed read segment into `buffer_out`; the
+// caller releases the claim and counts the read
+static int umsbb_take_message(umsbb_buffer_t* buffer, uint32_t segment_idx,
+                              void* buffer_out, uint32_t buffer_size, uint32_t* actual_size) {
+    umsbb_segment_t* segment = &buffer->segments[segment_idx];
+    umsbb_message_header_t header;
+    uint64_t position;
+    int result = umsbb_next_record(buffer, segment, &header, &position);
+    if (result != UMSBB_SUCCESS) {
+        return result;
+    }
+    
+    if (header.size > buffer_size) {
+        return UMSBB_ERROR_INVALID_SIZE;
+    }
+    
+    // Read message data
+    wasm_copy_bytes(buffer_out, segment->data + position % segment->size + sizeof(header), header.size);
+    if (!umsbb_payload_intact(buffer, &header, buffer_out)) {
+        return UMSBB_ERROR_CORRUPTED_DATA;
+    }
     
+    umsbb_retire_record(buffer, segment_idx, position, header.span);
+    *actual_size = header.size;
     return UMSBB_SUCCESS;
 }
 
+// Count `count` messages of `bytes` taken by one call
+static void umsbb_count_reads(umsbb_buffer_t* buffer, uint32_t count, uint64_t bytes) {
+    ATOMIC_ADD(&buffer->total_messages_read, count);
+    ATOMIC_ADD(&buffer->total_bytes_read, bytes);
+    ATOMIC_ADD(&buffer->read_operations, count);
+    ATOMIC_STORE(&buffer->last_read_time, umsbb_get_timestamp());
+    ATOMIC_SUB(&buffer->current_pending_messages, count);
+}
+
 // Read message from buffer
 WASM_EXPORT int umsbb_read_message(umsbb_handle_t handle, void* buffer_out, 
                                    uint32_t buffer_size, uint32_t* actual_size) {
@@ -432,63 +889,156 @@ WASM_EXPORT int umsbb_read_message(umsbb_handle_t handle, void* buffer_out,
         return UMSBB_ERROR_INVALID_HANDLE;
     }
     
-    // Select segment
-    uint32_t segment_idx = umsbb_select_read_segment(buffer);
-    umsbb_segment_t* segment = &buffer->segments[segment_idx];
-    
-    // Check if there are messages available
-    if (ATOMIC_LOAD(&segment->message_count) == 0) {
-        return UMSBB_ERROR_BUFFER_EMPTY;
+    // Select segment; other readers skip it until read_pos is published. One
+    // whose next record is still being copied sends us to the next.
+    uint32_t tried = 0;
+    int result = UMSBB_ERROR_BUFFER_EMPTY;
+    for (;;) {
+        uint32_t segment_idx = umsbb_claim_read_segment(buffer, tried);
+        if (segment_idx == UMSBB_SEGMENT_COUNT) {
+            break;
+        }
+        result = umsbb_take_message(buffer, segment_idx, buffer_out, buffer_size, actual_size);
+        umsbb_release(&buffer->segments[segment_idx].read_claim);
+        if (result != UMSBB_ERROR_BUFFER_EMPTY) {
+            break;
+        }
+        tried |= 1u << segment_idx;
+    }
+    if (result == UMSBB_SUCCESS) {
+        umsbb_count_reads(buffer, 1, *actual_size);
     }
     
-    // Get current positions
-    uint64_t current_read = ATOMIC_LOAD(&segment->read_pos);
-    uint64_t current_write = ATOMIC_LOAD(&segment->write_pos);
+    MEMORY_BARRIER();
     
-    if (current_read >= current_write) {
-        return UMSBB_ERROR_BUFFER_EMPTY;
+    return result;
+}
+
+// Read up to `max_messages`, packed back to back into `buffer_out` with each
+// size in `lengths`. Each claimed segment is drained before the next ready
+// one is claimed. Stops when none is left or the next message would overflow
+// `out_capacity`; that message stays for the next call. Returns the count,
+// or the error when nothing was read.
+WASM_EXPORT int umsbb_read_batch(umsbb_handle_t handle, void* buffer_out, uint32_t out_capacity,
+                                 uint32_t* lengths, uint32_t max_messages) {
+    // Validate parameters
+    if (!buffer_out || out_capacity == 0 || !lengths || max_messages == 0 || max_messages > INT_MAX) {
+        return UMSBB_ERROR_INVALID_PARAMS;
     }
     
-    // Calculate read position in buffer
-    uint32_t read_offset = current_read % segment->size;
-    
-    // Read message header
-    umsbb_message_header_t header;
-    memcpy(&header, segment->data + read_offset, sizeof(header));
+    // Find buffer
+    umsbb_buffer_t* buffer = umsbb_find_buffer(handle);
+    if (!buffer) {
+        return UMSBB_ERROR_INVALID_HANDLE;
+    }
     
-    // Validate header
-    if (header.magic != UMSBB_MAGIC_NUMBER) {
-        ATOMIC_ADD(&buffer->failed_reads, 1);
-        return UMSBB_ERROR_CORRUPTED_DATA;
+    uint8_t* out = (uint8_t*)buffer_out;
+    uint32_t used = 0;
+    uint32_t taken = 0;
+    uint64_t bytes = 0;
+    uint32_t tried = 0;
+    int result = UMSBB_ERROR_BUFFER_EMPTY;
+    
+    while (taken < max_messages) {
+        uint32_t segment_idx = umsbb_claim_read_segment(buffer, tried);
+        if (segment_idx == UMSBB_SEGMENT_COUNT) {
+            result = UMSBB_ERROR_BUFFER_EMPTY;
+            break;
+        }
+        tried |= 1u << segment_idx;
+        
+        do {
+            uint32_t size;
+            result = umsbb_take_message(buffer, segment_idx, out + used, out_capacity - used, &size);
+            if (result != UMSBB_SUCCESS) break;
+            lengths[taken++] = size;
+            used += size;
+            bytes += size;
+        } while (taken < max_messages);
+        umsbb_release(&buffer->segments[segment_idx].read_claim);
+        
+        // A drained segment sends us to the next; anything else ends the batch
+        if (result != UMSBB_ERROR_BUFFER_EMPTY) break;
     }
     
-    if (header.size > buffer_size) {
-        return UMSBB_ERROR_INVALID_SIZE;
+    if (taken > 0) {
+        umsbb_count_reads(buffer, taken, bytes);
     }
     
-    // Read message data
-    memcpy(buffer_out, segment->data + read_offset + sizeof(header), header.size);
+    MEMORY_BARRIER();
     
-    // Verify checksum
-    uint32_t calculated_checksum = umsbb_calculate_checksum(buffer_out, header.size);
-    if (calculated_checksum != header.checksum) {
-        ATOMIC_ADD(&buffer->failed_reads, 1);
-        return UMSBB_ERROR_CORRUPTED_DATA;
+    return taken > 0 ? (int)taken : result;
+}
+
+// Borrow the next message where it lies instead of copying it out. Its
+// segment stays claimed, so other readers pass it by, until `*ticket` goes to
+// umsbb_release_message; release promptly. The checksum is verified in place.
+WASM_EXPORT int umsbb_peek_message(umsbb_handle_t handle, const void** data,
+                                   uint32_t* size, uint64_t* ticket) {
+    // Validate parameters
+    if (!data || !size || !ticket) {
+        return UMSBB_ERROR_INVALID_PARAMS;
     }
     
-    // Update positions
-    uint32_t total_size = sizeof(umsbb_message_header_t) + header.size;
-    total_size = umsbb_align_size(total_size);
+    // Find buffer
+    umsbb_buffer_t* buffer = umsbb_find_buffer(handle);
+    if (!buffer) {
+        return UMSBB_ERROR_INVALID_HANDLE;
+    }
     
-    ATOMIC_STORE(&segment->read_pos, current_read + total_size);
-    ATOMIC_SUB(&segment->message_count, 1);
-    ATOMIC_ADD(&buffer->total_messages_read, 1);
-    ATOMIC_ADD(&buffer->total_bytes_read, header.size);
-    ATOMIC_ADD(&buffer->read_operations, 1);
-    ATOMIC_STORE(&buffer->last_read_time, umsbb_get_timestamp());
-    ATOMIC_SUB(&buffer->current_pending_messages, 1);
+    uint32_t tried = 0;
+    for (;;) {
+        uint32_t segment_idx = umsbb_claim_read_segment(buffer, tried);
+        if (segment_idx == UMSBB_SEGMENT_COUNT) {
+            return UMSBB_ERROR_BUFFER_EMPTY;
+        }
+        umsbb_segment_t* segment = &buffer->segments[segment_idx];
+        umsbb_message_header_t header;
+        uint64_t position;
+        int result = umsbb_next_record(buffer, segment, &header, &position);
+        if (result == UMSBB_SUCCESS) {
+            const uint8_t* payload = segment->data + position % segment->size + sizeof(header);
+            if (umsbb_payload_intact(buffer, &header, payload)) {
+                *data = payload;
+                *size = header.size;
+                *ticket = (position << UMSBB_TICKET_SEGMENT_BITS) | segment_idx;
+                return UMSBB_SUCCESS;
+            }
+            result = UMSBB_ERROR_CORRUPTED_DATA;
+        }
+        umsbb_release(&segment->read_claim);
+        if (result != UMSBB_ERROR_BUFFER_EMPTY) {
+            return result;
+        }
+        tried |= 1u << segment_idx;
+    }
+}
+
+// Consume a message borrowed by umsbb_peek_message and release its segment
+WASM_EXPORT int umsbb_release_message(umsbb_handle_t handle, uint64_t ticket) {
+    umsbb_buffer_t* buffer = umsbb_find_buffer(handle);
+    if (!buffer) {
+        return UMSBB_ERROR_INVALID_HANDLE;
+    }
     
-    *actual_size = header.size;
+    // Only the head of a claimed segment can be on loan
+    uint32_t segment_idx = (uint32_t)(ticket & (UMSBB_SEGMENT_COUNT - 1));
+    umsbb_segment_t* segment = &buffer->segments[segment_idx];
+    uint64_t position = ticket >> UMSBB_TICKET_SEGMENT_BITS;
+    if (!ATOMIC_LOAD(&segment->read_claim) || ATOMIC_LOAD(&segment->read_pos) != position ||
+        position >= ATOMIC_LOAD(&segment->reserve_pos)) {
+        return UMSBB_ERROR_INVALID_PARAMS;
+    }
+    uint32_t offset = (uint32_t)(position % segment->size);
+    if (ATOMIC_LOAD(umsbb_record_state(segment, offset)) != UMSBB_RECORD_COMMITTED) {
+        return UMSBB_ERROR_INVALID_PARAMS;
+    }
+    
+    const umsbb_message_header_t* record = (const umsbb_message_header_t*)(segment->data + offset);
+    uint32_t size = record->size;
+    umsbb_retire_record(buffer, segment_idx, position, record->span);
+    umsbb_release(&segment->read_claim);
+    umsbb_count_reads(buffer, 1, size);
     
     MEMORY_BARRIER();
     
@@ -526,6 +1076,52 @@ WASM_EXPORT uint32_t umsbb_get_pending_messages(umsbb_handle_t handle) {
     return ATOMIC_LOAD(&buffer->current_pending_messages);
 }
 
+// Block until the buffer holds a message or `timeout_ms` passes. Success means
+// one was pending on return; another consumer may take it first, so loop on
+// umsbb_read_message. Single-threaded builds never block.
+WASM_EXPORT int umsbb_wait_message(umsbb_handle_t handle, uint32_t timeout_ms) {
+    umsbb_buffer_t* buffer = umsbb_find_buffer(handle);
+    if (!buffer) {
+        return UMSBB_ERROR_INVALID_HANDLE;
+    }
+    
+    uint64_t deadline = umsbb_get_timestamp() + (uint64_t)timeout_ms * 1000;
+    for (;;) {
+        // Read the sequence first: a write after this check changes it and
+        // the wait returns at once
+        uint32_t seen = ATOMIC_LOAD(&buffer->wake_sequence);
+        if (ATOMIC_LOAD(&buffer->current_pending_messages) > 0) {
+            return UMSBB_SUCCESS;
+        }
+        uint64_t now = umsbb_get_timestamp();
+        if (!UMSBB_SHARED_MEMORY || now >= deadline) {
+            return UMSBB_ERROR_TIMEOUT;
+        }
+        umsbb_futex_wait(&buffer->wake_sequence, seen, (double)(deadline - now) / 1000.0);
+    }
+}
+
+// Byte offset of the buffer's wake word in linear memory, for JS to
+// Atomics.wait / Atomics.waitAsync on (Int32Array index offset >> 2)
+WASM_EXPORT uint32_t umsbb_get_wait_address(umsbb_handle_t handle) {
+    umsbb_buffer_t* buffer = umsbb_find_buffer(handle);
+    return buffer ? (uint32_t)(uintptr_t)&buffer->wake_sequence : 0;
+}
+
+// Nonzero when built with -pthread and handles work from every worker
+WASM_EXPORT int umsbb_is_shared_memory(void) {
+    return UMSBB_SHARED_MEMORY;
+}
+
+// Nonzero for the -msimd128 variant
+WASM_EXPORT int umsbb_is_simd_build(void) {
+#if defined(__wasm_simd128__)
+    return 1;
+#else
+    return 0;
+#endif
+}
+
 // Get active segments
 WASM_EXPORT uint32_t umsbb_get_active_segments(umsbb_handle_t handle) {
     umsbb_buffer_t* buffer = umsbb_find_buffer(handle);
@@ -621,20 +1217,37 @@ WASM_EXPORT void umsbb_get_buffer_config(umsbb_handle_t handle,
     if (max_message_size) *max_message_size = buffer->max_message_size;
 }
 
+// Select the checksum policy for messages written from now on; messages already
+// in the buffer keep the policy recorded in their header
+WASM_EXPORT int umsbb_set_checksum_policy(umsbb_handle_t handle, uint32_t policy) {
+    umsbb_buffer_t* buffer = umsbb_find_buffer(handle);
+    if (!buffer) {
+        return UMSBB_ERROR_INVALID_HANDLE;
+    }
+    if (policy > CHECKSUM_POLICY_STRONG) {
+        return UMSBB_ERROR_INVALID_PARAMS;
+    }
+    
+    ATOMIC_STORE(&buffer->checksum_policy, policy);
+    return UMSBB_SUCCESS;
+}
+
 // =============================================================================
 // CLEANUP AND SHUTDOWN
 // =============================================================================
 
 // Destroy buffer and free resources
 WASM_EXPORT int umsbb_destroy_buffer(umsbb_handle_t handle) {
-    if (handle == 0 || handle >= UMSBB_MAX_BUFFERS) {
-        return UMSBB_ERROR_INVALID_HANDLE;
-    }
+    uint32_t index = handle & UMSBB_HANDLE_INDEX_MASK;
+    umsbb_handle_slot_t* slot = &g_handle_slots[index];
     
-    umsbb_buffer_t* buffer = g_buffers[handle];
-    if (!buffer) {
+    // Retire the handle; of racing destroys only one gets past here
+    uint32_t expected = handle;
+    if (handle == 0 || !ATOMIC_CAS(&slot->handle, &expected, 0)) {
         return UMSBB_ERROR_INVALID_HANDLE;
     }
+    umsbb_buffer_t* buffer = slot->buffer;
+    slot->buffer = NULL;
     
     // Mark as not initialized
     ATOMIC_STORE(&buffer->initialized, 0);
@@ -649,13 +1262,15 @@ WASM_EXPORT int umsbb_destroy_buffer(umsbb_handle_t handle) {
         free(buffer->buffer_memory);
     }
     
-    // Clear from registry
-    g_buffers[handle] = NULL;
-    ATOMIC_SUB(&g_active_buffers, 1);
-    
     // Free buffer structure
     free(buffer);
     
+    // The slot's next handle differs from every one it gave out before
+    ATOMIC_STORE(&slot->generation,
+                 (ATOMIC_LOAD(&slot->generation) + 1) & (UINT32_MAX >> UMSBB_HANDLE_INDEX_BITS));
+    ATOMIC_SUB(&g_active_buffers, 1);
+    umsbb_free_slot(index);
+    
     return UMSBB_SUCCESS;
 }
 
@@ -713,14 +1328,8 @@ WASM_EXPORT int umsbb_write_multiple_messages(umsbb_handle_t handle,
 
 // Initialize the UMSBB system
 WASM_EXPORT int umsbb_init_system(void) {
-    // Clear buffer registry
-    for (uint32_t i = 0; i < UMSBB_MAX_BUFFERS; i++) {
-        g_buffers[i] = NULL;
-    }
-    
-    ATOMIC_STORE(&g_next_handle, 1);
-    ATOMIC_STORE(&g_active_buffers, 0);
-    
+    // The handle table is ready statically, and buffers still alive keep
+    // their handles across a re-init
     return UMSBB_SUCCESS;
 }
 
@@ -728,8 +1337,9 @@ WASM_EXPORT int umsbb_init_system(void) {
 WASM_EXPORT int umsbb_shutdown_system(void) {
     // Destroy all active buffers
     for (uint32_t i = 1; i < UMSBB_MAX_BUFFERS; i++) {
-        if (g_buffers[i] != NULL) {
-            umsbb_destroy_buffer(i);
+        uint32_t handle = ATOMIC_LOAD(&g_handle_slots[i].handle);
+        if (handle != 0) {
+            umsbb_destroy_buffer(handle);
         }
     }
     
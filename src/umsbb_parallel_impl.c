@@ -8,6 +8,7 @@
 #define UMSBB_ENABLE_MULTILANG 1
 
 #include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include "../include/umsbb_clock.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -48,16 +49,7 @@ struct UniversalMultiSegmentedBiBufferBus {
 
 // Helper function to get current time in nanoseconds
 static uint64_t get_time_ns() {
-#ifdef _WIN32
-    LARGE_INTEGER freq, counter;
-    QueryPerformanceFrequency(&freq);
-    QueryPerformanceCounter(&counter);
-    return (counter.QuadPart * 1000000000ULL) / freq.QuadPart;
-#else
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
-#endif
+    return umsbb_clock_ns();
 }
 
 // Initialize UMSBB
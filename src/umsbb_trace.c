@@ -0,0 +1,208 @@
+#include "umsbb_trace.h"
+#include "umsbb_clock.h"
+#include "portable_atomic.h"
+#include "bi_buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(_WIN32) && defined(UMSBB_TRACE_ETW)
+#  include <windows.h>
+#  include <TraceLoggingProvider.h>
+TRACELOGGING_DEFINE_PROVIDER(umsbb_trace_provider, "UMSBB",
+    (0x6a1f3c52, 0x8d4e, 0x4b7a, 0x9c21, 0x5e0f7d3a6b18));
+static volatile LONG umsbb_trace_etw_state;     // 0 unregistered, 1 registering, 2 registered
+#endif
+
+#define UMSBB_TRACE_MASK (UMSBB_TRACE_RING_RECORDS - 1)
+
+typedef struct UmsbbTraceRing {
+    umsbb_trace_record_t records[UMSBB_TRACE_RING_RECORDS];    // Written by the owner only
+    atomic_size_t head;                 // Records ever written; published with release
+    atomic_size_t start;                // Records before this were dropped by a reset
+    struct UmsbbTraceRing* next;
+    const void* owner;                  // Address of a thread-local of the owning thread
+    uint32_t thread;
+} UmsbbTraceRing;
+
+umsbb_trace_threshold_t umsbb_trace_threshold;
+static atomic_u32 umsbb_trace_one_in;
+static atomic_size_t umsbb_trace_rings;        // UmsbbTraceRing list, pushed to by first-time recorders
+static atomic_size_t umsbb_trace_thread_count;
+static SOMA_THREAD_LOCAL UmsbbTraceRing* umsbb_trace_ring;
+
+static const char* const umsbb_trace_module_names[UMSBB_TRACE_MODULE_COUNT] = {
+    "bi_buffer", "fast_lane", "twin_tx", "twin_rx", "parallel", "handshake"
+};
+
+static const char* const umsbb_trace_event_names[UMSBB_TRACE_EVENT_COUNT] = {
+    "submit", "claim", "commit", "signal", "drain", "release", "ack", "timeout",
+    "retry", "fail", "batch", "batch", "steal", "park", "wake"
+};
+
+const char* umsbb_trace_module_name(umsbb_trace_module_t module) {
+    return (unsigned)module < UMSBB_TRACE_MODULE_COUNT ? umsbb_trace_module_names[module] : "unknown";
+}
+
+const char* umsbb_trace_event_name(umsbb_trace_event_t event) {
+    return (unsigned)event < UMSBB_TRACE_EVENT_COUNT ? umsbb_trace_event_names[event] : "unknown";
+}
+
+static void umsbb_trace_store_threshold(uint64_t threshold) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    umsbb_trace_threshold = threshold;
+#else
+    atomic_store_explicit(&umsbb_trace_threshold, threshold, memory_order_relaxed);
+#endif
+}
+
+void umsbb_trace_set_sampling(uint32_t one_in) {
+    atomic_store_u32(&umsbb_trace_one_in, one_in);
+    // One in N hashes falls below 2^32 / N
+    umsbb_trace_store_threshold(one_in ? ((uint64_t)1 << 32) / one_in : 0);
+}
+
+uint32_t umsbb_trace_get_sampling(void) {
+    return atomic_load_u32(&umsbb_trace_one_in);
+}
+
+/* The calling thread's ring, created on first use. */
+static UmsbbTraceRing* umsbb_trace_acquire_ring(void) {
+    // As in the arena allocator, a thread-local's address identifies this
+    // thread; a new thread on the address of an exited one continues its ring
+    const void* self = &umsbb_trace_ring;
+    UmsbbTraceRing* ring = (UmsbbTraceRing*)(uintptr_t)atomic_load_size_acquire(&umsbb_trace_rings);
+    for (; ring; ring = ring->next) {
+        if (ring->owner == self) break;
+    }
+    if (!ring) {
+        ring = (UmsbbTraceRing*)calloc(1, sizeof(UmsbbTraceRing));
+        if (!ring) return NULL;
+        ring->owner = self;
+        ring->thread = (uint32_t)atomic_fetch_add_size(&umsbb_trace_thread_count, 1);
+        size_t head = atomic_load_size(&umsbb_trace_rings);
+        do {
+            ring->next = (UmsbbTraceRing*)(uintptr_t)head;
+        } while (!atomic_cas_size(&umsbb_trace_rings, &head, (size_t)(uintptr_t)ring));
+    }
+    umsbb_trace_ring = ring;
+    return ring;
+}
+
+#if defined(_WIN32) && defined(UMSBB_TRACE_ETW)
+static void umsbb_trace_etw(const umsbb_trace_record_t* record) {
+    if (umsbb_trace_etw_state != 2) {
+        if (InterlockedCompareExchange(&umsbb_trace_etw_state, 1, 0) != 0) return;
+        TraceLoggingRegister(umsbb_trace_provider);
+        InterlockedExchange(&umsbb_trace_etw_state, 2);
+    }
+    TraceLoggingWrite(umsbb_trace_provider, "Trace",
+                      TraceLoggingString(umsbb_trace_module_name((umsbb_trace_module_t)record->module), "Module"),
+                      TraceLoggingString(umsbb_trace_event_name((umsbb_trace_event_t)record->event), "Event"),
+                      TraceLoggingUInt32(record->lane, "Lane"),
+                      TraceLoggingUInt64(record->seq, "Seq"));
+}
+#endif
+
+void umsbb_trace_record(umsbb_trace_module_t module, umsbb_trace_event_t event, uint32_t lane, uint64_t seq) {
+    UmsbbTraceRing* ring = umsbb_trace_ring;
+    if (!ring && !(ring = umsbb_trace_acquire_ring())) return;
+
+    // Single writer: fill the slot, then publish it by moving head
+    size_t head = atomic_load_size_relaxed(&ring->head);
+    umsbb_trace_record_t* record = &ring->records[head & UMSBB_TRACE_MASK];
+    record->ns = umsbb_clock_ns();
+    record->seq = seq;
+    record->lane = lane;
+    record->module = (uint8_t)module;
+    record->event = (uint8_t)event;
+    record->reserved = 0;
+    atomic_store_size_release(&ring->head, head + 1);
+
+#if defined(_WIN32) && defined(UMSBB_TRACE_ETW)
+    umsbb_trace_etw(record);
+#endif
+}
+
+size_t umsbb_trace_collect(umsbb_trace_visit_fn visit, void* context) {
+    umsbb_trace_record_t* copy = (umsbb_trace_record_t*)malloc(sizeof(umsbb_trace_record_t) * UMSBB_TRACE_RING_RECORDS);
+    if (!copy) return 0;
+
+    size_t visited = 0;
+    UmsbbTraceRing* ring = (UmsbbTraceRing*)(uintptr_t)atomic_load_size_acquire(&umsbb_trace_rings);
+    for (; ring; ring = ring->next) {
+        size_t head = atomic_load_size_acquire(&ring->head);
+        size_t first = atomic_load_size(&ring->start);
+        if (head - first > UMSBB_TRACE_RING_RECORDS) first = head - UMSBB_TRACE_RING_RECORDS;
+        for (size_t i = first; i != head; ++i) {
+            copy[i - first] = ring->records[i & UMSBB_TRACE_MASK];
+        }
+
+        // The owner may have lapped part of the copy while it was taken
+        atomic_fence_acquire();
+        size_t now = atomic_load_size_relaxed(&ring->head);
+        size_t valid = (now - first > UMSBB_TRACE_RING_RECORDS) ? now - UMSBB_TRACE_RING_RECORDS : first;
+        for (size_t i = valid; i - first < head - first; ++i) {
+            visit(ring->thread, &copy[i - first], context);
+            visited++;
+        }
+    }
+    free(copy);
+    return visited;
+}
+
+void umsbb_trace_reset(void) {
+    UmsbbTraceRing* ring = (UmsbbTraceRing*)(uintptr_t)atomic_load_size_acquire(&umsbb_trace_rings);
+    for (; ring; ring = ring->next) {
+        atomic_store_size(&ring->start, atomic_load_size_acquire(&ring->head));
+    }
+}
+
+typedef struct {
+    FILE* out;
+    uint64_t origin;
+    size_t written;
+    bool minimum;       // First pass: find the earliest stamp
+} UmsbbTraceDump;
+
+static void umsbb_trace_write_event(uint32_t thread, const umsbb_trace_record_t* record, void* context) {
+    UmsbbTraceDump* dump = (UmsbbTraceDump*)context;
+    if (dump->minimum) {
+        if (dump->written++ == 0 || record->ns < dump->origin) dump->origin = record->ns;
+        return;
+    }
+
+    const char* phase = "i";
+    if (record->event == UMSBB_TRACE_BATCH_BEGIN) phase = "B";
+    else if (record->event == UMSBB_TRACE_BATCH_END) phase = "E";
+
+    fprintf(dump->out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",%s\"ts\":%.3f,\"pid\":1,\"tid\":%u,"
+                       "\"args\":{\"lane\":%u,\"seq\":%llu}}",
+            umsbb_trace_event_name((umsbb_trace_event_t)record->event),
+            umsbb_trace_module_name((umsbb_trace_module_t)record->module), phase,
+            phase[0] == 'i' ? "\"s\":\"t\"," : "",
+            record->ns > dump->origin ? (double)(record->ns - dump->origin) / 1000.0 : 0.0, thread + 1,
+            record->lane, (unsigned long long)record->seq);
+}
+
+bool umsbb_trace_dump_chrome(const char* path) {
+    if (!path) return false;
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+
+    UmsbbTraceDump dump = { out, 0, 0, true };
+    umsbb_trace_collect(umsbb_trace_write_event, &dump);
+    dump.minimum = false;
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+                 "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"umsbb\"}}");
+    UmsbbTraceRing* ring = (UmsbbTraceRing*)(uintptr_t)atomic_load_size_acquire(&umsbb_trace_rings);
+    for (; ring; ring = ring->next) {
+        fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+                ring->thread + 1, ring->thread);
+    }
+    umsbb_trace_collect(umsbb_trace_write_event, &dump);
+    fprintf(out, "\n]}\n");
+
+    bool ok = !ferror(out);
+    return fclose(out) == 0 && ok;
+}
@@ -4,11 +4,37 @@
  * 
  * This is a web-optimized version of the UMSBB core designed specifically
  * for WebAssembly compilation and direct webpage integration.
+ *
+ * Built with -pthread the module's memory is a SharedArrayBuffer and every
+ * worker running the module sees the same buffers. A per-buffer lock word
+ * serialises writers and readers; the lock and the buffer's sequence word
+ * are waited on with memory.atomic.wait (Atomics.wait) and woken with
+ * notify, so a consumer blocks in umsbb_wait_message instead of polling.
+ * Single-threaded builds keep the same code: the atomics lower to plain
+ * loads and stores and the waits never happen.
+ *
+ * Built with -msimd128 the payload copies, the segment scan and the checksum
+ * engine run on v128 (wasm_kernels); the default build is scalar and runs
+ * everywhere.
+ *
+ * Buffers and rings come from a WasmHeap that grows linear memory as needed
+ * and takes back everything umsbb_destroy_buffer frees. Every call holds a
+ * reference on its buffer's slot, so destroy waits for calls still inside
+ * the buffer (and wakes parked consumers) before its memory is reused.
+ *
+ * umsbb_write_batch and umsbb_read_batch move many messages packed in one
+ * region per call, so JS pays the call boundary once per batch.
  */
 
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "checksum_engine.h"
+#include "umsbb_clock.h"
+#include "wasm_heap.h"
+#include "wasm_kernels.h"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -17,6 +43,25 @@
 #define WASM_EXPORT
 #endif
 
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <emscripten/threading.h>
+#define UMSBB_SHARED_MEMORY 1
+#else
+#define UMSBB_SHARED_MEMORY 0
+#endif
+
+// Real wasm atomics with -pthread (-matomics); plain accesses otherwise
+#define WASM_LOAD(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define WASM_STORE(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#define WASM_ADD(ptr, val) __atomic_add_fetch(ptr, val, __ATOMIC_SEQ_CST)
+#define WASM_SUB(ptr, val) __atomic_sub_fetch(ptr, val, __ATOMIC_SEQ_CST)
+#define WASM_EXCHANGE(ptr, val) __atomic_exchange_n(ptr, val, __ATOMIC_ACQ_REL)
+#define WASM_CAS(ptr, expected, desired) \
+    __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+// Slot references pair a store with a later load on the other side
+#define WASM_LOAD_SC(ptr) __atomic_load_n(ptr, __ATOMIC_SEQ_CST)
+#define WASM_STORE_SC(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_SEQ_CST)
+
 // Configuration constants - Optimized for WebAssembly
 #define UMSBB_MAX_BUFFERS 16
 #define UMSBB_NUM_SEGMENTS 8
@@ -24,6 +69,7 @@
 #define UMSBB_MAX_MESSAGE_SIZE (1024 * 1024)      // 1MB
 #define UMSBB_HEADER_SIZE 16
 #define UMSBB_ALIGNMENT 8                         // 8-byte alignment for better performance
+#define UMSBB_BATCH_CHUNK 64                      // Batch messages placed per lock hold
 
 // Error codes
 typedef enum {
@@ -70,51 +116,88 @@ typedef struct {
     umsbb_segment_t segments[UMSBB_NUM_SEGMENTS];
     volatile uint32_t current_write_segment;
     volatile uint32_t current_read_segment;
+    uint32_t lock;                  // 0 free, 1 held, 2 held with waiters
+    uint32_t sequence;              // Bumped per write; consumers wait on it
     uint32_t segment_size;
     uint32_t num_segments;
     umsbb_stats_t stats;
+    checksum_policy_t checksum_policy;
     int is_initialized;
 } umsbb_buffer_t;
 
 // Global state
 static umsbb_buffer_t* g_buffers[UMSBB_MAX_BUFFERS];
-static int g_system_initialized = 0;
-static volatile uint32_t g_next_buffer_id = 1;
+static uint32_t g_system_initialized = 0;
+static uint32_t g_registry_lock = 0;        // Buffer slots, init and shutdown
+static uint32_t g_slot_users[UMSBB_MAX_BUFFERS];    // Calls inside each slot's buffer
+static uint32_t g_slot_closing[UMSBB_MAX_BUFFERS];  // Destroy waiting for them to leave
+static WasmHeap g_heap;                     // Zero-initialised: ready to use
 
-// Utility functions
-static uint32_t calculate_checksum(const void* data, size_t size) {
-    const uint8_t* bytes = (const uint8_t*)data;
-    uint32_t checksum = 0x5A5A5A5A;
-    for (size_t i = 0; i < size; i++) {
-        checksum = ((checksum << 1) | (checksum >> 31)) ^ bytes[i];
+// Blocks the calling worker; emscripten spins instead on the browser main
+// thread, where Atomics.wait is not allowed
+static void wasm_futex_wait(uint32_t* word, uint32_t expected, double timeout_ms) {
+#if UMSBB_SHARED_MEMORY
+    emscripten_futex_wait(word, expected, timeout_ms);
+#else
+    (void)word; (void)expected; (void)timeout_ms;
+#endif
+}
+
+static void wasm_futex_wake(uint32_t* word, int count) {
+#if UMSBB_SHARED_MEMORY
+    emscripten_futex_wake(word, count);
+#else
+    (void)word; (void)count;
+#endif
+}
+
+static void wasm_lock(uint32_t* word) {
+    uint32_t state = 0;
+    if (WASM_CAS(word, &state, 1)) return;
+    // Contended: mark it so the holder wakes us, then sleep until released
+    if (state != 2) state = WASM_EXCHANGE(word, 2);
+    while (state != 0) {
+        wasm_futex_wait(word, 2, (double)INFINITY);
+        state = WASM_EXCHANGE(word, 2);
     }
-    return checksum;
 }
 
-static uint64_t get_timestamp_ms() {
-    // Simplified timestamp for WebAssembly
-    static uint64_t counter = 0;
-    return ++counter;
+static void wasm_unlock(uint32_t* word) {
+    if (WASM_EXCHANGE(word, 0) == 2) wasm_futex_wake(word, 1);
 }
 
-static void* wasm_malloc(size_t size) {
-    // Optimized allocation for WebAssembly with better alignment
-    static uint8_t heap[8 * 1024 * 1024]; // 8MB heap
-    static size_t heap_pos = 0;
-    
-    // Ensure alignment for better performance
-    size = (size + UMSBB_ALIGNMENT - 1) & ~(UMSBB_ALIGNMENT - 1);
-    
-    if (heap_pos + size > sizeof(heap)) {
-        return NULL; // Out of memory
+static void release_buffer(int buffer_id) {
+    if (WASM_SUB(&g_slot_users[buffer_id], 1) == 0 && WASM_LOAD_SC(&g_slot_closing[buffer_id])) {
+        wasm_futex_wake(&g_slot_users[buffer_id], INT_MAX);
     }
-    
-    void* ptr = &heap[heap_pos];
-    heap_pos += size;
-    
-    // Zero-initialize for consistency
-    memset(ptr, 0, size);
-    return ptr;
+}
+
+// Pins the buffer until release_buffer; destroy will not free it meanwhile
+static umsbb_buffer_t* acquire_buffer(int buffer_id) {
+    if (!WASM_LOAD(&g_system_initialized) || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) return NULL;
+    WASM_ADD(&g_slot_users[buffer_id], 1);
+    umsbb_buffer_t* buffer = WASM_LOAD_SC(&g_buffers[buffer_id]);
+    if (!buffer || !WASM_LOAD(&buffer->is_initialized)) {
+        release_buffer(buffer_id);
+        return NULL;
+    }
+    return buffer;
+}
+
+static void free_buffer(umsbb_buffer_t* buffer) {
+    for (uint32_t i = 0; i < buffer->num_segments; i++) {
+        wasm_heap_free(&g_heap, buffer->segments[i].data);
+    }
+    wasm_heap_free(&g_heap, buffer);
+}
+
+// Utility functions
+static uint32_t calculate_checksum(const umsbb_buffer_t* buffer, const void* data, size_t size) {
+    return checksum_compute(buffer->checksum_policy, data, size);
+}
+
+static uint64_t get_timestamp_ms() {
+    return umsbb_clock_coarse_ns() / 1000000;
 }
 
 // Forward declarations
@@ -123,37 +206,36 @@ WASM_EXPORT int umsbb_destroy_buffer(int buffer_id);
 // Core API Functions
 
 WASM_EXPORT int umsbb_init_system() {
-    if (g_system_initialized) {
-        return UMSBB_SUCCESS;
-    }
-    
-    // Initialize global state
-    for (int i = 0; i < UMSBB_MAX_BUFFERS; i++) {
-        g_buffers[i] = NULL;
+    wasm_lock(&g_registry_lock);
+    if (!g_system_initialized) {
+        // Initialize global state
+        for (int i = 0; i < UMSBB_MAX_BUFFERS; i++) {
+            WASM_STORE(&g_buffers[i], NULL);
+        }
+        WASM_STORE(&g_system_initialized, 1);
     }
-    
-    g_system_initialized = 1;
+    wasm_unlock(&g_registry_lock);
     return UMSBB_SUCCESS;
 }
 
 WASM_EXPORT int umsbb_shutdown_system() {
-    if (!g_system_initialized) {
+    if (!WASM_LOAD(&g_system_initialized)) {
         return UMSBB_ERROR_SYSTEM_NOT_INITIALIZED;
     }
     
     // Clean up all buffers
     for (int i = 0; i < UMSBB_MAX_BUFFERS; i++) {
-        if (g_buffers[i]) {
+        if (WASM_LOAD(&g_buffers[i])) {
             umsbb_destroy_buffer(i);
         }
     }
     
-    g_system_initialized = 0;
+    WASM_STORE(&g_system_initialized, 0);
     return UMSBB_SUCCESS;
 }
 
 WASM_EXPORT int umsbb_create_buffer(uint32_t segment_size, uint32_t num_segments) {
-    if (!g_system_initialized) {
+    if (!WASM_LOAD(&g_system_initialized)) {
         return UMSBB_ERROR_SYSTEM_NOT_INITIALIZED;
     }
     
@@ -161,34 +243,23 @@ WASM_EXPORT int umsbb_create_buffer(uint32_t segment_size, uint32_t num_segments
         return UMSBB_ERROR_INVALID_PARAMS;
     }
     
-    // Find free buffer slot
-    int buffer_id = -1;
-    for (int i = 0; i < UMSBB_MAX_BUFFERS; i++) {
-        if (g_buffers[i] == NULL) {
-            buffer_id = i;
-            break;
-        }
-    }
-    
-    if (buffer_id == -1) {
-        return UMSBB_ERROR_MEMORY_ALLOCATION;
-    }
-    
     // Allocate buffer structure
-    umsbb_buffer_t* buffer = (umsbb_buffer_t*)wasm_malloc(sizeof(umsbb_buffer_t));
+    umsbb_buffer_t* buffer = (umsbb_buffer_t*)wasm_heap_alloc(&g_heap, sizeof(umsbb_buffer_t));
     if (!buffer) {
         return UMSBB_ERROR_MEMORY_ALLOCATION;
     }
     
-    // Initialize buffer
+    // Initialize buffer; ring storage is only read where it was written
     memset(buffer, 0, sizeof(umsbb_buffer_t));
     buffer->segment_size = segment_size;
     buffer->num_segments = num_segments;
+    buffer->checksum_policy = CHECKSUM_POLICY_DEFAULT;
     
     // Allocate segments
     for (uint32_t i = 0; i < num_segments; i++) {
-        buffer->segments[i].data = (uint8_t*)wasm_malloc(segment_size);
+        buffer->segments[i].data = (uint8_t*)wasm_heap_alloc(&g_heap, segment_size);
         if (!buffer->segments[i].data) {
+            free_buffer(buffer);
             return UMSBB_ERROR_MEMORY_ALLOCATION;
         }
         buffer->segments[i].capacity = segment_size;
@@ -198,42 +269,86 @@ WASM_EXPORT int umsbb_create_buffer(uint32_t segment_size, uint32_t num_segments
     }
     
     buffer->is_initialized = 1;
-    g_buffers[buffer_id] = buffer;
+    
+    // Publish in a free slot; the release store makes the buffer visible whole
+    int buffer_id = -1;
+    wasm_lock(&g_registry_lock);
+    for (int i = 0; i < UMSBB_MAX_BUFFERS; i++) {
+        if (g_buffers[i] == NULL && !g_slot_closing[i]) {
+            buffer_id = i;
+            WASM_STORE(&g_buffers[i], buffer);
+            break;
+        }
+    }
+    wasm_unlock(&g_registry_lock);
+    
+    if (buffer_id == -1) {
+        free_buffer(buffer);
+        return UMSBB_ERROR_MEMORY_ALLOCATION;
+    }
     
     return buffer_id;
 }
 
 WASM_EXPORT int umsbb_destroy_buffer(int buffer_id) {
-    if (!g_system_initialized || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
+    if (!WASM_LOAD(&g_system_initialized) || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
         return UMSBB_ERROR_INVALID_PARAMS;
     }
     
+    wasm_lock(&g_registry_lock);
     umsbb_buffer_t* buffer = g_buffers[buffer_id];
     if (!buffer) {
+        wasm_unlock(&g_registry_lock);
         return UMSBB_ERROR_INVALID_BUFFER;
     }
+    // The slot stays reserved until the memory is back in the heap
+    WASM_STORE_SC(&g_slot_closing[buffer_id], 1);
+    WASM_STORE_SC(&g_buffers[buffer_id], NULL);
+    wasm_unlock(&g_registry_lock);
     
-    buffer->is_initialized = 0;
-    g_buffers[buffer_id] = NULL;
+    // Release anyone still waiting, then let calls in flight leave
+    wasm_lock(&buffer->lock);
+    WASM_STORE(&buffer->is_initialized, 0);
+    wasm_unlock(&buffer->lock);
+    WASM_ADD(&buffer->sequence, 1);
+    wasm_futex_wake(&buffer->sequence, INT_MAX);
+    
+    uint32_t users;
+    while ((users = WASM_LOAD_SC(&g_slot_users[buffer_id])) != 0) {
+        wasm_futex_wait(&g_slot_users[buffer_id], users, (double)INFINITY);
+    }
+    free_buffer(buffer);
+    WASM_STORE(&g_slot_closing[buffer_id], 0);
     
     return UMSBB_SUCCESS;
 }
 
-WASM_EXPORT int umsbb_write_message(int buffer_id, const void* data, uint32_t size) {
-    if (!g_system_initialized || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
+// The header has no room to record the policy, so it can only change while
+// the buffer is drained
+WASM_EXPORT int umsbb_set_checksum_policy(int buffer_id, uint32_t policy) {
+    if (!WASM_LOAD(&g_system_initialized) || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
         return UMSBB_ERROR_INVALID_PARAMS;
     }
     
-    if (!data || size == 0 || size > UMSBB_MAX_MESSAGE_SIZE) {
-        return UMSBB_ERROR_INVALID_PARAMS;
-    }
-    
-    umsbb_buffer_t* buffer = g_buffers[buffer_id];
-    if (!buffer || !buffer->is_initialized) {
+    umsbb_buffer_t* buffer = acquire_buffer(buffer_id);
+    if (!buffer) {
         return UMSBB_ERROR_INVALID_BUFFER;
     }
     
-    uint32_t total_size = UMSBB_HEADER_SIZE + size;
+    int result = UMSBB_ERROR_INVALID_PARAMS;
+    wasm_lock(&buffer->lock);
+    if (policy <= CHECKSUM_POLICY_STRONG && buffer->stats.pending_messages == 0) {
+        buffer->checksum_policy = (checksum_policy_t)policy;
+        result = UMSBB_SUCCESS;
+    }
+    wasm_unlock(&buffer->lock);
+    release_buffer(buffer_id);
+    return result;
+}
+
+// Place one message in the write segment; the caller holds the buffer lock
+static void append_locked(umsbb_buffer_t* buffer, const umsbb_message_header_t* header, const void* data) {
+    uint32_t total_size = UMSBB_HEADER_SIZE + header->size;
     
     // Find segment with enough space
     uint32_t segment_idx = buffer->current_write_segment;
@@ -245,8 +360,9 @@ WASM_EXPORT int umsbb_write_message(int buffer_id, const void* data, uint32_t si
         segment_idx = (segment_idx + 1) % buffer->num_segments;
         segment = &buffer->segments[segment_idx];
         
-        // Reset segment if it's full
+        // Reset segment if it's full; what it still held is dropped
         if (segment->write_pos + total_size > segment->capacity) {
+            WASM_SUB(&buffer->stats.pending_messages, segment->message_count);
             segment->write_pos = 0;
             segment->read_pos = 0;
             segment->message_count = 0;
@@ -256,62 +372,44 @@ WASM_EXPORT int umsbb_write_message(int buffer_id, const void* data, uint32_t si
     }
     
     // Write message header
-    umsbb_message_header_t header;
-    header.size = size;
-    header.checksum = calculate_checksum(data, size);
-    header.timestamp = get_timestamp_ms();
-    
-    memcpy(segment->data + segment->write_pos, &header, UMSBB_HEADER_SIZE);
-    memcpy(segment->data + segment->write_pos + UMSBB_HEADER_SIZE, data, size);
+    memcpy(segment->data + segment->write_pos, header, UMSBB_HEADER_SIZE);
+    wasm_copy_bytes(segment->data + segment->write_pos + UMSBB_HEADER_SIZE, data, header->size);
     
     segment->write_pos += total_size;
     segment->message_count++;
     
     // Update statistics
     buffer->stats.total_messages_written++;
-    buffer->stats.total_bytes_written += size;
-    buffer->stats.pending_messages++;
+    buffer->stats.total_bytes_written += header->size;
+    uint32_t pending = WASM_ADD(&buffer->stats.pending_messages, 1);
     
-    if (buffer->stats.pending_messages > buffer->stats.peak_pending_messages) {
-        buffer->stats.peak_pending_messages = buffer->stats.pending_messages;
+    if (pending > buffer->stats.peak_pending_messages) {
+        buffer->stats.peak_pending_messages = pending;
     }
-    
-    buffer->stats.average_message_size = 
-        (double)buffer->stats.total_bytes_written / buffer->stats.total_messages_written;
-    
-    return UMSBB_SUCCESS;
 }
 
-WASM_EXPORT int umsbb_read_message(int buffer_id, void* output_buffer, uint32_t max_size) {
-    if (!g_system_initialized || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
-        return UMSBB_ERROR_INVALID_PARAMS;
-    }
-    
-    if (!output_buffer || max_size == 0) {
-        return UMSBB_ERROR_INVALID_PARAMS;
-    }
-    
-    umsbb_buffer_t* buffer = g_buffers[buffer_id];
-    if (!buffer || !buffer->is_initialized) {
-        return UMSBB_ERROR_INVALID_BUFFER;
-    }
-    
+// Take the next message into `output_buffer`; the caller holds the buffer
+// lock. Returns its size, or an error with the message left in place.
+static int take_locked(umsbb_buffer_t* buffer, void* output_buffer, uint32_t max_size) {
     // Find segment with messages
     uint32_t segment_idx = buffer->current_read_segment;
     umsbb_segment_t* segment = &buffer->segments[segment_idx];
     
     // Check if current segment has messages
     if (segment->read_pos >= segment->write_pos || segment->message_count == 0) {
-        // Try other segments
-        for (uint32_t i = 0; i < buffer->num_segments; i++) {
-            uint32_t idx = (segment_idx + i) % buffer->num_segments;
-            if (buffer->segments[idx].message_count > 0 && 
-                buffer->segments[idx].read_pos < buffer->segments[idx].write_pos) {
-                segment_idx = idx;
-                segment = &buffer->segments[segment_idx];
-                buffer->current_read_segment = segment_idx;
-                break;
-            }
+        // The next segment holding messages, counting on from this one
+        uint32_t num_segments = buffer->num_segments;
+        uint32_t counts[UMSBB_NUM_SEGMENTS] = {0};
+        for (uint32_t i = 0; i < num_segments; i++) {
+            counts[i] = buffer->segments[i].message_count;
+        }
+        uint32_t ready = wasm_nonzero_mask(counts, num_segments);
+        uint32_t rotated = ((ready >> segment_idx) | (ready << (num_segments - segment_idx))) &
+                           ((1u << num_segments) - 1);
+        if (rotated) {
+            segment_idx = (segment_idx + (uint32_t)__builtin_ctz(rotated)) % num_segments;
+            segment = &buffer->segments[segment_idx];
+            buffer->current_read_segment = segment_idx;
         }
         
         if (segment->read_pos >= segment->write_pos || segment->message_count == 0) {
@@ -332,11 +430,10 @@ WASM_EXPORT int umsbb_read_message(int buffer_id, void* output_buffer, uint32_t
     }
     
     // Read message data
-    memcpy(output_buffer, segment->data + segment->read_pos + UMSBB_HEADER_SIZE, header.size);
+    wasm_copy_bytes(output_buffer, segment->data + segment->read_pos + UMSBB_HEADER_SIZE, header.size);
     
     // Verify checksum
-    uint32_t checksum = calculate_checksum(output_buffer, header.size);
-    if (checksum != header.checksum) {
+    if (!checksum_verify(buffer->checksum_policy, output_buffer, header.size, header.checksum)) {
         return UMSBB_ERROR_INVALID_PARAMS; // Corruption detected
     }
     
@@ -346,49 +443,287 @@ WASM_EXPORT int umsbb_read_message(int buffer_id, void* output_buffer, uint32_t
     // Update statistics
     buffer->stats.total_messages_read++;
     buffer->stats.total_bytes_read += header.size;
-    buffer->stats.pending_messages--;
-    
+    WASM_SUB(&buffer->stats.pending_messages, 1);
     return (int)header.size;
 }
 
-// Statistics and info functions
-WASM_EXPORT uint64_t umsbb_get_total_messages(int buffer_id) {
-    if (!g_system_initialized || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
-        return 0;
+WASM_EXPORT int umsbb_write_message(int buffer_id, const void* data, uint32_t size) {
+    if (!WASM_LOAD(&g_system_initialized) || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
+        return UMSBB_ERROR_INVALID_PARAMS;
     }
     
-    umsbb_buffer_t* buffer = g_buffers[buffer_id];
-    if (!buffer || !buffer->is_initialized) {
-        return 0;
+    if (!data || size == 0 || size > UMSBB_MAX_MESSAGE_SIZE) {
+        return UMSBB_ERROR_INVALID_PARAMS;
+    }
+    
+    umsbb_buffer_t* buffer = acquire_buffer(buffer_id);
+    if (!buffer) {
+        return UMSBB_ERROR_INVALID_BUFFER;
+    }
+    
+    // Checksum before taking the lock; it only reads the caller's bytes
+    umsbb_message_header_t header;
+    header.size = size;
+    header.checksum = calculate_checksum(buffer, data, size);
+    header.timestamp = get_timestamp_ms();
+    
+    wasm_lock(&buffer->lock);
+    if (!buffer->is_initialized) {
+        wasm_unlock(&buffer->lock);
+        release_buffer(buffer_id);
+        return UMSBB_ERROR_INVALID_BUFFER;
     }
+    append_locked(buffer, &header, data);
+    buffer->stats.average_message_size = 
+        (double)buffer->stats.total_bytes_written / buffer->stats.total_messages_written;
+    wasm_unlock(&buffer->lock);
+    
+    // Wake consumers parked in umsbb_wait_message or on Atomics.wait
+    WASM_ADD(&buffer->sequence, 1);
+    wasm_futex_wake(&buffer->sequence, INT_MAX);
     
-    return buffer->stats.total_messages_written;
+    release_buffer(buffer_id);
+    return UMSBB_SUCCESS;
 }
 
-WASM_EXPORT uint64_t umsbb_get_total_bytes(int buffer_id) {
-    if (!g_system_initialized || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
+// Write `count` messages packed back to back at `data`, `lengths[i]` bytes
+// each, so JS crosses into wasm once per batch instead of once per message.
+// Headers are checksummed outside the lock a chunk at a time; each chunk is
+// placed under one lock with one wake. Stops at the first invalid length and
+// returns how many were written, or the error when that was the first.
+WASM_EXPORT int umsbb_write_batch(int buffer_id, const void* data, const uint32_t* lengths, uint32_t count) {
+    if (!WASM_LOAD(&g_system_initialized) || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
+        return UMSBB_ERROR_INVALID_PARAMS;
+    }
+    
+    if (!data || !lengths || count > INT_MAX) {
+        return UMSBB_ERROR_INVALID_PARAMS;
+    }
+    
+    umsbb_buffer_t* buffer = acquire_buffer(buffer_id);
+    if (!buffer) {
+        return UMSBB_ERROR_INVALID_BUFFER;
+    }
+    
+    umsbb_message_header_t headers[UMSBB_BATCH_CHUNK];
+    const uint8_t* next = (const uint8_t*)data;
+    uint32_t written = 0;
+    int error = UMSBB_SUCCESS;
+    
+    while (written < count && error == UMSBB_SUCCESS) {
+        const uint8_t* chunk = next;
+        uint64_t timestamp = get_timestamp_ms();
+        uint32_t n = 0;
+        while (n < UMSBB_BATCH_CHUNK && written + n < count) {
+            uint32_t size = lengths[written + n];
+            if (size == 0 || size > UMSBB_MAX_MESSAGE_SIZE) {
+                error = UMSBB_ERROR_INVALID_PARAMS;
+                break;
+            }
+            headers[n].size = size;
+            headers[n].checksum = calculate_checksum(buffer, next, size);
+            headers[n].timestamp = timestamp;
+            next += size;
+            n++;
+        }
+        if (n == 0) {
+            break;
+        }
+        
+        wasm_lock(&buffer->lock);
+        if (!buffer->is_initialized) {
+            wasm_unlock(&buffer->lock);
+            error = UMSBB_ERROR_INVALID_BUFFER;
+            break;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            append_locked(buffer, &headers[i], chunk);
+            chunk += headers[i].size;
+        }
+        buffer->stats.average_message_size = 
+            (double)buffer->stats.total_bytes_written / buffer->stats.total_messages_written;
+        wasm_unlock(&buffer->lock);
+        written += n;
+        
+        WASM_ADD(&buffer->sequence, 1);
+        wasm_futex_wake(&buffer->sequence, INT_MAX);
+    }
+    
+    release_buffer(buffer_id);
+    return (written > 0 || count == 0) ? (int)written : error;
+}
+
+WASM_EXPORT int umsbb_read_message(int buffer_id, void* output_buffer, uint32_t max_size) {
+    if (!WASM_LOAD(&g_system_initialized) || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
+        return UMSBB_ERROR_INVALID_PARAMS;
+    }
+    
+    if (!output_buffer || max_size == 0) {
+        return UMSBB_ERROR_INVALID_PARAMS;
+    }
+    
+    umsbb_buffer_t* buffer = acquire_buffer(buffer_id);
+    if (!buffer) {
+        return UMSBB_ERROR_INVALID_BUFFER;
+    }
+    
+    // Nothing to take: skip the lock so idle consumers stay off it
+    if (WASM_LOAD(&buffer->stats.pending_messages) == 0) {
+        release_buffer(buffer_id);
+        return UMSBB_ERROR_BUFFER_EMPTY;
+    }
+    
+    wasm_lock(&buffer->lock);
+    int result = take_locked(buffer, output_buffer, max_size);
+    wasm_unlock(&buffer->lock);
+    release_buffer(buffer_id);
+    return result;
+}
+
+// Read up to `max_messages` under one lock, packed back to back into
+// `output_buffer` with each size in `lengths`. Stops when the buffer runs
+// dry or the next message would overflow `out_capacity`; that message stays
+// for the next call. Returns the count, or the error when nothing was read.
+WASM_EXPORT int umsbb_read_batch(int buffer_id, void* output_buffer, uint32_t out_capacity,
+                                 uint32_t* lengths, uint32_t max_messages) {
+    if (!WASM_LOAD(&g_system_initialized) || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
+        return UMSBB_ERROR_INVALID_PARAMS;
+    }
+    
+    if (!output_buffer || out_capacity == 0 || !lengths || max_messages == 0 || max_messages > INT_MAX) {
+        return UMSBB_ERROR_INVALID_PARAMS;
+    }
+    
+    umsbb_buffer_t* buffer = acquire_buffer(buffer_id);
+    if (!buffer) {
+        return UMSBB_ERROR_INVALID_BUFFER;
+    }
+    
+    if (WASM_LOAD(&buffer->stats.pending_messages) == 0) {
+        release_buffer(buffer_id);
+        return UMSBB_ERROR_BUFFER_EMPTY;
+    }
+    
+    uint8_t* out = (uint8_t*)output_buffer;
+    uint32_t used = 0;
+    uint32_t taken = 0;
+    int result = UMSBB_ERROR_BUFFER_EMPTY;
+    
+    wasm_lock(&buffer->lock);
+    while (taken < max_messages) {
+        result = take_locked(buffer, out + used, out_capacity - used);
+        if (result < 0) {
+            break;
+        }
+        lengths[taken++] = (uint32_t)result;
+        used += (uint32_t)result;
+    }
+    wasm_unlock(&buffer->lock);
+    
+    release_buffer(buffer_id);
+    return taken > 0 ? (int)taken : result;
+}
+
+// Block until the buffer holds a message or `timeout_ms` passes. Success means
+// one was pending on return; another consumer may still take it first, so
+// loop on umsbb_read_message. Single-threaded builds never block.
+WASM_EXPORT int umsbb_wait_message(int buffer_id, uint32_t timeout_ms) {
+    umsbb_buffer_t* buffer = acquire_buffer(buffer_id);
+    if (!buffer) {
+        return UMSBB_ERROR_INVALID_BUFFER;
+    }
+    
+    uint64_t deadline = get_timestamp_ms() + timeout_ms;
+    int result;
+    for (;;) {
+        // Read the sequence first: a write after this check changes it and
+        // the wait returns at once
+        uint32_t seen = WASM_LOAD(&buffer->sequence);
+        if (WASM_LOAD(&buffer->stats.pending_messages) > 0) {
+            result = UMSBB_SUCCESS;
+            break;
+        }
+        if (!WASM_LOAD(&buffer->is_initialized)) {
+            result = UMSBB_ERROR_INVALID_BUFFER;
+            break;
+        }
+        uint64_t now = get_timestamp_ms();
+        if (!UMSBB_SHARED_MEMORY || now >= deadline) {
+            result = UMSBB_ERROR_BUFFER_EMPTY;
+            break;
+        }
+        wasm_futex_wait(&buffer->sequence, seen, (double)(deadline - now));
+    }
+    release_buffer(buffer_id);
+    return result;
+}
+
+// Byte offset of the buffer's sequence word in linear memory, for JS to
+// Atomics.wait / Atomics.waitAsync on (Int32Array index offset >> 2). It
+// changes after every write, and once more when the buffer is destroyed;
+// the address is reused after that.
+WASM_EXPORT uint32_t umsbb_get_wait_address(int buffer_id) {
+    umsbb_buffer_t* buffer = acquire_buffer(buffer_id);
+    if (!buffer) {
         return 0;
     }
     
-    umsbb_buffer_t* buffer = g_buffers[buffer_id];
-    if (!buffer || !buffer->is_initialized) {
+    uint32_t address = (uint32_t)(uintptr_t)&buffer->sequence;
+    release_buffer(buffer_id);
+    return address;
+}
+
+// Nonzero when built with -pthread: memory is shared and handles can be used
+// from any worker running this module
+WASM_EXPORT int umsbb_is_shared_memory() {
+    return UMSBB_SHARED_MEMORY;
+}
+
+// Nonzero for the -msimd128 variant: copies, scans and checksums run on v128
+WASM_EXPORT int umsbb_is_simd_build() {
+#if defined(__wasm_simd128__)
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+// Statistics and info functions
+WASM_EXPORT uint64_t umsbb_get_total_messages(int buffer_id) {
+    umsbb_buffer_t* buffer = acquire_buffer(buffer_id);
+    if (!buffer) {
         return 0;
     }
     
-    return buffer->stats.total_bytes_written;
+    wasm_lock(&buffer->lock);
+    uint64_t total = buffer->stats.total_messages_written;
+    wasm_unlock(&buffer->lock);
+    release_buffer(buffer_id);
+    return total;
 }
 
-WASM_EXPORT uint32_t umsbb_get_pending_messages(int buffer_id) {
-    if (!g_system_initialized || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
+WASM_EXPORT uint64_t umsbb_get_total_bytes(int buffer_id) {
+    umsbb_buffer_t* buffer = acquire_buffer(buffer_id);
+    if (!buffer) {
         return 0;
     }
     
-    umsbb_buffer_t* buffer = g_buffers[buffer_id];
-    if (!buffer || !buffer->is_initialized) {
+    wasm_lock(&buffer->lock);
+    uint64_t total = buffer->stats.total_bytes_written;
+    wasm_unlock(&buffer->lock);
+    release_buffer(buffer_id);
+    return total;
+}
+
+WASM_EXPORT uint32_t umsbb_get_pending_messages(int buffer_id) {
+    umsbb_buffer_t* buffer = acquire_buffer(buffer_id);
+    if (!buffer) {
         return 0;
     }
     
-    return buffer->stats.pending_messages;
+    uint32_t pending = WASM_LOAD(&buffer->stats.pending_messages);
+    release_buffer(buffer_id);
+    return pending;
 }
 
 WASM_EXPORT const char* umsbb_get_version() {
@@ -411,7 +746,7 @@ WASM_EXPORT const char* umsbb_get_error_string(int error_code) {
 
 // Performance testing function
 WASM_EXPORT int umsbb_run_performance_test(int buffer_id, uint32_t message_count, uint32_t message_size) {
-    if (!g_system_initialized || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
+    if (!WASM_LOAD(&g_system_initialized) || buffer_id < 0 || buffer_id >= UMSBB_MAX_BUFFERS) {
         return UMSBB_ERROR_INVALID_PARAMS;
     }
     
@@ -419,14 +754,15 @@ WASM_EXPORT int umsbb_run_performance_test(int buffer_id, uint32_t message_count
         return UMSBB_ERROR_MESSAGE_TOO_LARGE;
     }
     
-    umsbb_buffer_t* buffer = g_buffers[buffer_id];
-    if (!buffer || !buffer->is_initialized) {
+    // Held for the whole run so the buffer cannot be destroyed under it
+    if (!acquire_buffer(buffer_id)) {
         return UMSBB_ERROR_INVALID_BUFFER;
     }
     
     // Allocate test data
-    uint8_t* test_data = (uint8_t*)wasm_malloc(message_size);
+    uint8_t* test_data = (uint8_t*)wasm_heap_alloc(&g_heap, message_size);
     if (!test_data) {
+        release_buffer(buffer_id);
         return UMSBB_ERROR_MEMORY_ALLOCATION;
     }
     
@@ -435,29 +771,27 @@ WASM_EXPORT int umsbb_run_performance_test(int buffer_id, uint32_t message_count
         test_data[i] = (uint8_t)(i & 0xFF);
     }
     
-    // Record start statistics
-    uint64_t start_messages = buffer->stats.total_messages_written;
-    
-    // Write messages
-    for (uint32_t i = 0; i < message_count; i++) {
-        int result = umsbb_write_message(buffer_id, test_data, message_size);
-        if (result != UMSBB_SUCCESS) {
-            return result;
+    // Write messages; other workers may be writing too, so count our own
+    int result = UMSBB_SUCCESS;
+    uint32_t messages_written = 0;
+    for (uint32_t i = 0; i < message_count && result == UMSBB_SUCCESS; i++) {
+        result = umsbb_write_message(buffer_id, test_data, message_size);
+        if (result == UMSBB_SUCCESS) {
+            messages_written++;
         }
     }
     
-    // Calculate messages written
-    uint64_t messages_written = buffer->stats.total_messages_written - start_messages;
-    
-    return (int)messages_written;
+    wasm_heap_free(&g_heap, test_data);
+    release_buffer(buffer_id);
+    return result == UMSBB_SUCCESS ? (int)messages_written : result;
 }
 
-// Memory management for WebAssembly
+// Memory management for WebAssembly; blocks come from the buffers' heap and
+// are not zeroed
 WASM_EXPORT void* umsbb_malloc(size_t size) {
-    return wasm_malloc(size);
+    return wasm_heap_alloc(&g_heap, size);
 }
 
 WASM_EXPORT void umsbb_free(void* ptr) {
-    // Simple allocator doesn't support free
-    (void)ptr;
+    wasm_heap_free(&g_heap, ptr);
 }
\ No newline at end of file
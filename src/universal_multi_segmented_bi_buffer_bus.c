@@ -1,56 +1,275 @@
 #include "universal_multi_segmented_bi_buffer_bus.h"
+#include "umsbb_clock.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#if defined(_WIN32)
+#  include <windows.h>
+#  define umsbb_yield() SwitchToThread()
+#else
+#  include <sched.h>
+#  define umsbb_yield() sched_yield()
+#endif
+
+#if UMSBB_ENABLE_FLOW_CONTROL
+static HighWaterMark* umsbb_create_gate(UniversalMultiSegmentedBiBufferBus* bus, size_t capacity) {
+    size_t high, low, batch;
+    flow_control_marks(&bus->flow, capacity, &high, &low, &batch);
+    return hwm_create_marks(high, low, batch);
+}
+
+// Re-derive a lane's marks from the rounded capacity of its ring, or of the
+// region a resize has queued
+static void umsbb_fit_gate(UniversalMultiSegmentedBiBufferBus* bus, size_t lane) {
+    size_t high, low, batch;
+    flow_control_marks(&bus->flow, bi_buffer_target_capacity(bus->ring.buffers[lane]), &high, &low, &batch);
+    hwm_set_marks(bus->credit[lane], high, low, batch);
+}
+
+static void umsbb_destroy_gates(UniversalMultiSegmentedBiBufferBus* bus) {
+    if (!bus->credit) return;
+    for (size_t i = 0; i < SEGMENT_RING_MAX_LANES; ++i) hwm_destroy(bus->credit[i]);
+    free(bus->credit);
+    bus->credit = NULL;
+}
+#endif
+
+// Lane credit, charged per frame; without flow control only a full ring refuses
+static inline bool umsbb_credit_acquire(UniversalMultiSegmentedBiBufferBus* bus, size_t lane, size_t bytes) {
+#if UMSBB_ENABLE_FLOW_CONTROL
+    return hwm_try_acquire(bus->credit[lane], bytes);
+#else
+    (void)bus;
+    (void)lane;
+    (void)bytes;
+    return true;
+#endif
+}
+
+static inline void umsbb_credit_refund(UniversalMultiSegmentedBiBufferBus* bus, size_t lane, size_t bytes) {
+#if UMSBB_ENABLE_FLOW_CONTROL
+    hwm_refund(bus->credit[lane], bytes);
+#else
+    (void)bus;
+    (void)lane;
+    (void)bytes;
+#endif
+}
+
+static inline void umsbb_credit_release(UniversalMultiSegmentedBiBufferBus* bus, size_t lane, size_t bytes) {
+#if UMSBB_ENABLE_FLOW_CONTROL
+    hwm_release(bus->credit[lane], bytes);
+#else
+    (void)bus;
+    (void)lane;
+    (void)bytes;
+#endif
+}
+
+#if UMSBB_ENABLE_BATCHING
+// NULL until umsbb_configure_batching first turns batching on for the lane
+static inline SubmitBatcher* umsbb_batcher(UniversalMultiSegmentedBiBufferBus* bus, size_t lane) {
+    return (SubmitBatcher*)(uintptr_t)atomic_load_size_acquire(&bus->batchers[lane]);
+}
+#endif
+
+// Whether a frame holds a SubmitBatcher batch, which only batching builds write
+static inline bool umsbb_frame_batched(const BiBufferFrame* frame) {
+#if UMSBB_ENABLE_BATCHING
+    return (frame->flags & SUBMIT_BATCH_FRAME_FLAG) != 0;
+#else
+    (void)frame;
+    return false;
+#endif
+}
+
+#if UMSBB_ENABLE_RELIABILITY
+// Retransmit store callback: reliable messages travel on the consumer's twin lane
+static bool umsbb_resend_reliable(void* context, const handshake_entry_t* entry, const void* payload) {
+    UniversalMultiSegmentedBiBufferBus* bus = (UniversalMultiSegmentedBiBufferBus*)context;
+    return twin_lane_send(&bus->twin_lanes, entry->consumer_id, payload, entry->message_size,
+                          (uint32_t)entry->sequence);
+}
+
+// Message log replay handler: a logged message goes back out on the lane it was sent on
+static void umsbb_replay_logged(void* context, uint32_t lane, uint64_t sequence, const void* data, size_t size) {
+    UniversalMultiSegmentedBiBufferBus* bus = (UniversalMultiSegmentedBiBufferBus*)context;
+    twin_lane_send(&bus->twin_lanes, lane, data, size, (uint32_t)sequence);
+}
+#endif
+
+// Fault tolerance bookkeeping of the lane APIs, dropped with it
+static inline void umsbb_note_health(UniversalMultiSegmentedBiBufferBus* bus, uint32_t component) {
+#if UMSBB_ENABLE_RELIABILITY
+    fault_tolerance_update_component_health(&bus->fault_tolerance, component, true, 0);
+#else
+    (void)bus;
+    (void)component;
+#endif
+}
+
+static inline void umsbb_note_fault(UniversalMultiSegmentedBiBufferBus* bus, fault_type_t type, uint32_t component,
+                                    const char* description) {
+#if UMSBB_ENABLE_RELIABILITY
+    fault_tolerance_report_fault(&bus->fault_tolerance, type, component, description);
+#else
+    (void)bus;
+    (void)type;
+    (void)component;
+    (void)description;
+#endif
+}
+
+#if UMSBB_ENABLE_GPU
+static bool umsbb_offload_cpu(void* context, void* dst, const void* src, size_t size) {
+    (void)context;
+    memcpy(dst, src, size);
+    return true;
+}
+
+static bool umsbb_offload_gpu(void* context, void* dst, const void* src, size_t size) {
+    (void)context;
+    return gpu_parallel_copy(dst, src, size, get_gpu_capabilities().max_threads);
+}
+
+// Time memcpy against the GPU copy on this node to find where offloading pays
+static void umsbb_calibrate_offload(UniversalMultiSegmentedBiBufferBus* bus) {
+    offload_planner_set_gpu(&bus->offload, true);
+    offload_planner_calibrate(&bus->offload, umsbb_offload_cpu, umsbb_offload_gpu, bus, OFFLOAD_PLANNER_CALIBRATION_MAX);
+}
+
+// Copy with whichever path the planner expects to be faster, feeding the
+// observed time back; true if the GPU did the copy
+static bool umsbb_offload_copy(UniversalMultiSegmentedBiBufferBus* bus, OffloadOp op, void* dst, const void* src,
+                               size_t size) {
+    if (!bus->gpu_enabled) {
+        memcpy(dst, src, size);
+        return false;
+    }
+
+    OffloadPath path = offload_planner_choose(&bus->offload, op, size);
+    uint64_t start = umsbb_clock_ns();
+    if (path == OFFLOAD_PATH_GPU) {
+        if (umsbb_offload_gpu(bus, dst, src, size)) {
+            offload_planner_complete(&bus->offload, op, OFFLOAD_PATH_GPU, size, umsbb_clock_ns() - start, true);
+            return true;
+        }
+        offload_planner_complete(&bus->offload, op, OFFLOAD_PATH_GPU, size, 0, false);
+        start = umsbb_clock_ns();
+    }
+    memcpy(dst, src, size);
+    offload_planner_complete(&bus->offload, op, OFFLOAD_PATH_CPU, size, umsbb_clock_ns() - start, true);
+    return false;
+}
+#else
+static inline bool umsbb_offload_copy(UniversalMultiSegmentedBiBufferBus* bus, OffloadOp op, void* dst,
+                                      const void* src, size_t size) {
+    (void)bus;
+    (void)op;
+    memcpy(dst, src, size);
+    return false;
+}
+#endif
+
+uint32_t umsbb_feature_mask(void) {
+    return UMSBB_FEATURES;
+}
 
 UniversalMultiSegmentedBiBufferBus* umsbb_init(size_t bufCap, uint32_t segmentCount) {
+    return umsbb_init_with_lanes(bufCap, segmentCount, NULL);
+}
+
+UniversalMultiSegmentedBiBufferBus* umsbb_init_with_lanes(size_t bufCap, uint32_t segmentCount,
+                                                          const fast_lane_config_t lanes[LANE_COUNT]) {
     UniversalMultiSegmentedBiBufferBus* bus = malloc(sizeof(UniversalMultiSegmentedBiBufferBus));
     if (!bus) return NULL;
     
+    // Calibrate the clock here rather than on the first message
+    umsbb_clock_init();
+    
     // Auto-determine segment count if not specified
     if (segmentCount == 0) {
         segmentCount = 4; // Default
     }
     
-    segment_ring_init(&bus->ring, segmentCount, bufCap);
-    arena_init(&bus->arena, bufCap * segmentCount);
-    feedback_clear(&bus->feedback);
-    batch_init(&bus->batch, 1, 8, 1);
-    flow_control_init(&bus->flow, bufCap * 0.8);
-    event_init(&bus->scheduler);
-    
-    // Initialize V3.0 enhanced systems
-    if (!fast_lane_init(&bus->fast_lanes)) {
+    if (!segment_ring_init(&bus->ring, segmentCount, bufCap)) {
         free(bus);
         return NULL;
     }
-    
-    if (!twin_lane_init(&bus->twin_lanes, 32)) { // Support up to 32 twin lanes
-        fast_lane_destroy(&bus->fast_lanes);
-        free(bus);
-        return NULL;
+    event_init(&bus->scheduler);
+#if UMSBB_ENABLE_FEEDBACK
+    // Telemetry slots for every lane umsbb_scale_segments can bring online
+    bool feedbackReady = feedback_init_sparse(&bus->feedback, SEGMENT_RING_MAX_LANES);
+    for (size_t i = 0; feedbackReady && i < bus->ring.laneCount; ++i) {
+        feedbackReady = feedback_enable_lane(&bus->feedback, i);
     }
-    
-    if (!handshake_init(&bus->handshake, 1024)) { // Support 1024 pending messages
-        fast_lane_destroy(&bus->fast_lanes);
-        twin_lane_destroy(&bus->twin_lanes);
-        free(bus);
-        return NULL;
+    if (!feedbackReady) goto fail_feedback;
+#endif
+#if UMSBB_ENABLE_FLOW_CONTROL
+    flow_control_init_ratio(&bus->flow, 0.8);
+    bus->credit = calloc(SEGMENT_RING_MAX_LANES, sizeof(HighWaterMark*));
+    bool gatesReady = bus->credit != NULL;
+    for (size_t i = 0; gatesReady && i < bus->ring.laneCount; ++i) {
+        bus->credit[i] = umsbb_create_gate(bus, bi_buffer_capacity(bus->ring.buffers[i]));
+        gatesReady = bus->credit[i] != NULL;
     }
+    if (!gatesReady) goto fail_gates;
+#endif
+#if UMSBB_ENABLE_BATCHING
+    bus->batchers = calloc(SEGMENT_RING_MAX_LANES, sizeof(atomic_size_t));
+    if (!bus->batchers) goto fail_batchers;
+#endif
     
-    if (!fault_tolerance_init(&bus->fault_tolerance, 512)) { // Track 512 fault records
-        fast_lane_destroy(&bus->fast_lanes);
-        twin_lane_destroy(&bus->twin_lanes);
-        handshake_destroy(&bus->handshake);
-        free(bus);
-        return NULL;
+    // Initialize V3.0 enhanced systems
+#if UMSBB_ENABLE_FAST_LANES
+    if (!fast_lane_init_ex(&bus->fast_lanes, lanes)) goto fail_fast_lanes;
+#  if UMSBB_ENABLE_GPU
+    bus->gpu_coalescer = NULL;
+    memset(bus->gpu_spill, 0, sizeof(bus->gpu_spill));
+    bus->gpu_result = NULL;
+    bus->gpu_result_context = NULL;
+#  endif
+#else
+    (void)lanes;
+#endif
+#if UMSBB_ENABLE_MULTILANG
+    bus->active_languages = 0;
+    memset(bus->language_performance_stats, 0, sizeof(bus->language_performance_stats));
+    // Language pairs follow the learned routes until one is pinned
+    for (size_t s = 0; s < WASM_LANG_COUNT; ++s) {
+        for (size_t t = 0; t < WASM_LANG_COUNT; ++t) atomic_store_uchar(&bus->lang_to_lane_map[s][t], LANE_COUNT);
     }
+    for (size_t i = 0; i < LANE_COUNT; ++i) {
+        bus->lane_priority_weights[i] = LANE_ROUTER_WEIGHT_DEFAULT;
+        bus->lane_performance_history[i] = 0.0;
+    }
+#  if UMSBB_ENABLE_FAST_LANES
+    lane_router_init(&bus->router, &bus->fast_lanes);
+    for (size_t i = 0; i < LANE_COUNT; ++i) {
+        bus->lane_performance_history[i] = lane_router_cost(&bus->router, (lane_type_t)i);
+    }
+#  endif
+#endif
+    
+#if UMSBB_ENABLE_TWIN_LANES
+    if (!twin_lane_init(&bus->twin_lanes, 32)) goto fail_twin_lanes; // Support up to 32 twin lanes
+#endif
+#if UMSBB_ENABLE_TOPICS
+    for (size_t i = 0; i < UMSBB_MAX_TOPICS; ++i) atomic_store_size(&bus->topics[i], 0);
+#endif
     
-    bus->sequence = 0;
+#if UMSBB_ENABLE_RELIABILITY
+    if (!handshake_init(&bus->handshake, 1024)) goto fail_handshake; // Support 1024 pending messages
+    handshake_set_retransmit(&bus->handshake, HANDSHAKE_RETAIN_BUDGET, umsbb_resend_reliable, bus);
+    
+    if (!fault_tolerance_init(&bus->fault_tolerance, 512)) goto fail_fault_tolerance; // Track 512 fault records
+#endif
+    
+    atomic_store_size(&bus->sequence, 0);
+    bus->checksum_policy = CHECKSUM_POLICY_DEFAULT;
     bus->segment_count = segmentCount;
-    bus->gpu_enabled = false;
-    bus->load_factor = 0.0;
-    bus->total_operations = 0;
+    atomic_store_size(&bus->total_operations, 0);
     
     // Initialize performance metrics
     bus->messages_per_second = 0;
@@ -58,208 +277,712 @@ UniversalMultiSegmentedBiBufferBus* umsbb_init(size_t bufCap, uint32_t segmentCo
     bus->system_latency_us = 0.0;
     bus->throughput_mbps = 0.0;
     bus->reliability_score = 1.0;
+    bus->api_level = UMSBB_API_LEVEL;
+    bus->optional_features_enabled = UMSBB_API_LEVEL > 0;
     
+#if UMSBB_ENABLE_PARALLEL
+    // Parallel processing stays off until umsbb_enable_parallel_processing
+    bus->parallel_processing_enabled = false;
+    bus->worker_thread_count = 0;
+    bus->current_strategy = THROUGHPUT_STRATEGY_BALANCED;
+#endif
+    
+#if UMSBB_ENABLE_GPU
+    bus->gpu_enabled = false;
+    offload_planner_init(&bus->offload, false);
     // Initialize GPU if available
     if (gpu_available()) {
         bus->gpu_enabled = initialize_gpu();
+        if (bus->gpu_enabled) umsbb_calibrate_offload(bus);
     }
+#endif
     
     return bus;
+
+#if UMSBB_ENABLE_RELIABILITY
+fail_fault_tolerance:
+    handshake_destroy(&bus->handshake);
+fail_handshake:
+#endif
+#if UMSBB_ENABLE_TWIN_LANES
+    twin_lane_destroy(&bus->twin_lanes);
+fail_twin_lanes:
+#endif
+#if UMSBB_ENABLE_FAST_LANES
+    fast_lane_destroy(&bus->fast_lanes);
+fail_fast_lanes:
+#endif
+#if UMSBB_ENABLE_BATCHING
+    free(bus->batchers);
+fail_batchers:
+#endif
+#if UMSBB_ENABLE_FLOW_CONTROL
+fail_gates:
+    umsbb_destroy_gates(bus);
+#endif
+#if UMSBB_ENABLE_FEEDBACK
+fail_feedback:
+    feedback_destroy(&bus->feedback);
+#endif
+    event_destroy(&bus->scheduler);
+    segment_ring_destroy(&bus->ring);
+    free(bus);
+    return NULL;
+}
+
+// Sampled per-lane telemetry; the entry is only built if it will be kept
+static inline void umsbb_push_feedback(UniversalMultiSegmentedBiBufferBus* bus, size_t lane, uint32_t sequence,
+                                       FeedbackType type, const char* note) {
+#if UMSBB_ENABLE_FEEDBACK
+    if (!feedback_should_record(&bus->feedback, lane, type, sequence)) return;
+    FeedbackEntry fb = {
+        .sequence = sequence,
+        .type = type,
+        .note = note,
+        .timestamp = 0
+    };
+    feedback_push(&bus->feedback, lane, fb);
+#else
+    (void)bus;
+    (void)lane;
+    (void)sequence;
+    (void)type;
+    (void)note;
+#endif
+}
+
+// Operation count behind umsbb_get_load_factor, which the minimal bus lacks;
+// producers and consumers on every lane add to it
+static inline void umsbb_count_operations(UniversalMultiSegmentedBiBufferBus* bus, size_t count) {
+#if UMSBB_API_LEVEL >= 1
+    atomic_fetch_add_size(&bus->total_operations, count);
+#else
+    (void)bus;
+    (void)count;
+#endif
 }
 
+#if UMSBB_API_LEVEL >= 1
 void umsbb_submit(UniversalMultiSegmentedBiBufferBus* bus, const char* msg, size_t size) {
-    size_t lane = bus->ring.currentIndex;
-    umsbb_submit_to(bus, lane, msg, size);
-    bus->ring.currentIndex = (lane + 1) % bus->ring.activeCount;
+    // Thread-local routing: producers share no cursor
+    umsbb_submit_to(bus, segment_ring_pick(&bus->ring), msg, size);
 }
+#endif
+
+// Claim ring space for a producer already holding `size`'s credit; a
+// batched frame takes one sequence number per record
+static umsbb_reservation umsbb_claim_credited(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, size_t size,
+                                              size_t records) {
+    umsbb_reservation handle = { .data = NULL, .size = 0, .lane = laneIndex, .sequence = 0 };
+    void* ptr = bi_buffer_claim(bus->ring.buffers[laneIndex], size);
+    if (!ptr) {
+        umsbb_credit_refund(bus, laneIndex, BI_BUFFER_FRAME_SIZE(size));
+        umsbb_push_feedback(bus, laneIndex, (uint32_t)atomic_load_size(&bus->sequence), FEEDBACK_SKIPPED, "Buffer claim failed");
+        return handle;
+    }
+
+    handle.data = ptr;
+    handle.size = size;
+    handle.sequence = (uint32_t)atomic_fetch_add_size(&bus->sequence, records);
+    return handle;
+}
+
+static umsbb_reservation umsbb_reserve_frame(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, size_t size,
+                                             size_t records) {
+    umsbb_reservation handle = { .data = NULL, .size = 0, .lane = laneIndex, .sequence = 0 };
+
+    // Credit is charged per frame, matching what the consumer hands back
+    if (!umsbb_credit_acquire(bus, laneIndex, BI_BUFFER_FRAME_SIZE(size))) {
+        umsbb_push_feedback(bus, laneIndex, (uint32_t)atomic_load_size(&bus->sequence), FEEDBACK_THROTTLED, "High-water mark reached");
+        return handle;
+    }
+    return umsbb_claim_credited(bus, laneIndex, size, records);
+}
+
+umsbb_reservation umsbb_reserve(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, size_t size) {
+    umsbb_reservation handle = { .data = NULL, .size = 0, .lane = laneIndex, .sequence = 0 };
+    if (!bus || laneIndex >= bus->ring.activeCount) return handle;
+#if UMSBB_ENABLE_BATCHING
+    // Messages this thread has staged go first
+    if (!submit_batcher_flush_own(umsbb_batcher(bus, laneIndex))) return handle;
+#endif
+    return umsbb_reserve_frame(bus, laneIndex, size, 1);
+}
+
+bool umsbb_configure_lane_mode(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, BiBufferMode mode) {
+    if (!bus || laneIndex >= bus->ring.laneCount) return false;
+    return bi_buffer_set_mode(bus->ring.buffers[laneIndex], mode);
+}
+
+bool umsbb_configure_segment_routing(UniversalMultiSegmentedBiBufferBus* bus, SegmentRouting routing) {
+    if (!bus || routing > SEGMENT_ROUTING_AFFINITY) return false;
+    segment_ring_set_routing(&bus->ring, routing);
+    return true;
+}
+
+bool umsbb_configure_checksum(UniversalMultiSegmentedBiBufferBus* bus, checksum_policy_t policy) {
+    if (!bus || policy > CHECKSUM_POLICY_STRONG) return false;
+    bus->checksum_policy = policy;
+    return true;
+}
+
+// Verify a frame with the policy its producer recorded
+static inline bool umsbb_frame_intact(const BiBufferFrame* frame, const void* data, size_t size) {
+    return checksum_verify((checksum_policy_t)(frame->flags & CHECKSUM_POLICY_MASK), data, size, frame->checksum);
+}
+
+static bool umsbb_commit_frame(UniversalMultiSegmentedBiBufferBus* bus, umsbb_reservation* handle, uint16_t flags,
+                               size_t records) {
+    BiBuffer* target = bus->ring.buffers[handle->lane];
+
+    BiBufferFrame* frame = bi_buffer_frame(handle->data);
+    frame->sequence = handle->sequence;
+    frame->flags = (uint16_t)(bus->checksum_policy | flags);
+    frame->checksum = checksum_compute(bus->checksum_policy, handle->data, handle->size);
+    bi_buffer_commit(target, handle->data, handle->size);
+    // mark_ready fences after the commit, which event_notify relies on too
+    segment_ring_mark_ready(&bus->ring, handle->lane);
+    event_notify(&bus->scheduler);
+
+    umsbb_push_feedback(bus, handle->lane, handle->sequence, FEEDBACK_OK, "Message submitted successfully");
+
+    umsbb_count_operations(bus, records);
+    handle->data = NULL; // A reservation can only be committed once
+    return true;
+}
+
+bool umsbb_commit(UniversalMultiSegmentedBiBufferBus* bus, umsbb_reservation* handle) {
+    // A lane removed after the reservation still accepts the commit
+    if (!bus || !handle || !handle->data || handle->lane >= bus->ring.laneCount) return false;
+    return umsbb_commit_frame(bus, handle, 0, 1);
+}
+
+bool umsbb_commit_length(UniversalMultiSegmentedBiBufferBus* bus, umsbb_reservation* handle, size_t length) {
+    if (!bus || !handle || !handle->data || handle->lane >= bus->ring.laneCount) return false;
+    if (length > handle->size) return false;
+    // The trimmed tail goes back as credit now; the consumer only hands
+    // back the frame it reads
+    umsbb_credit_release(bus, handle->lane, BI_BUFFER_FRAME_SIZE(handle->size) - BI_BUFFER_FRAME_SIZE(length));
+    handle->size = length;
+    return umsbb_commit_frame(bus, handle, 0, 1);
+}
+
+bool umsbb_cancel(UniversalMultiSegmentedBiBufferBus* bus, umsbb_reservation* handle) {
+    if (!bus || !handle || !handle->data || handle->lane >= bus->ring.laneCount) return false;
+    bi_buffer_cancel(bus->ring.buffers[handle->lane], handle->data);
+    umsbb_credit_release(bus, handle->lane, BI_BUFFER_FRAME_SIZE(handle->size));
+    umsbb_push_feedback(bus, handle->lane, handle->sequence, FEEDBACK_SKIPPED, "Reservation cancelled");
+    handle->data = NULL;
+    return true;
+}
+
+#if UMSBB_ENABLE_BATCHING
+// SubmitBatcher commit: the staged frame is copied in whole and stamped with
+// its commit time. A lane retired since the messages were staged takes them.
+static bool umsbb_commit_batch(void* context, size_t lane, const void* frame, size_t size, uint32_t count) {
+    UniversalMultiSegmentedBiBufferBus* bus = (UniversalMultiSegmentedBiBufferBus*)context;
+    if (lane >= bus->ring.laneCount) return false;
+    umsbb_reservation handle = umsbb_reserve_frame(bus, lane, size, count);
+    if (!handle.data) return false;
+
+    memcpy(handle.data, frame, size);
+    ((SubmitBatchHeader*)handle.data)->committed_ns = umsbb_clock_ns();
+    return umsbb_commit_frame(bus, &handle, SUBMIT_BATCH_FRAME_FLAG, count);
+}
+#endif
 
 bool umsbb_submit_to(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, const char* msg, size_t size) {
     if (laneIndex >= bus->ring.activeCount) return false;
-    BiBuffer* target = &bus->ring.buffers[laneIndex];
-
-    if (flow_should_throttle(target, &bus->flow)) {
-        FeedbackEntry fb = {
-            .sequence = bus->sequence,
-            .type = FEEDBACK_THROTTLED,
-            .note = "High-water mark reached",
-            .timestamp = (uint64_t)time(NULL)
-        };
-        feedback_push(&bus->feedback, fb);
-        return false;
-    }
 
-    // Try GPU acceleration for large messages
-    if (bus->gpu_enabled && size > 1024 * 1024) {
-        if (try_gpu_execute((void*)msg, size)) {
-            bus->total_operations++;
-            return true;
-        }
+#if UMSBB_ENABLE_BATCHING
+    SubmitBatcher* batcher = umsbb_batcher(bus, laneIndex);
+    if (batcher) {
+        SubmitBatchResult staged = submit_batcher_submit(batcher, msg, size);
+        if (staged != SUBMIT_BATCH_DIRECT) return staged == SUBMIT_BATCH_STAGED;
     }
+#endif
+    umsbb_reservation handle = umsbb_reserve_frame(bus, laneIndex, size, 1);
+    if (!handle.data) return false;
 
-    // Check adaptive batching - accumulate multiple messages if beneficial
-    size_t batchSize = batch_next(&bus->batch, 85); // Assume 85% success rate for now
-    
-    MessageCapsule* cap = arena_alloc(&bus->arena, sizeof(MessageCapsule));
-    if (!cap) {
-        FeedbackEntry fb = {
-            .sequence = bus->sequence,
-            .type = FEEDBACK_SKIPPED,
-            .note = "Arena allocation failed",
-            .timestamp = (uint64_t)time(NULL)
-        };
-        feedback_push(&bus->feedback, fb);
+    umsbb_offload_copy(bus, OFFLOAD_OP_SUBMIT, handle.data, msg, size);
+    return umsbb_commit(bus, &handle);
+}
+
+bool umsbb_submit_wait(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, const char* msg, size_t size,
+                       uint64_t timeoutNs) {
+    if (!bus || laneIndex >= bus->ring.activeCount) return false;
+#if UMSBB_ENABLE_BATCHING
+    if (!submit_batcher_flush_own(umsbb_batcher(bus, laneIndex))) return false;
+#endif
+
+#if UMSBB_ENABLE_FLOW_CONTROL
+    if (!hwm_acquire_wait(bus->credit[laneIndex], BI_BUFFER_FRAME_SIZE(size), timeoutNs)) {
+        umsbb_push_feedback(bus, laneIndex, (uint32_t)atomic_load_size(&bus->sequence), FEEDBACK_THROTTLED, "High-water mark reached");
         return false;
     }
-    
-    capsule_wrap(cap, bus->sequence++, msg, size);
+    umsbb_reservation handle = umsbb_claim_credited(bus, laneIndex, size, 1);
+#else
+    // No credit to park on: retry the claim until the consumer makes room
+    umsbb_reservation handle = umsbb_claim_credited(bus, laneIndex, size, 1);
+    uint64_t start = timeoutNs ? umsbb_clock_ns() : 0;
+    while (!handle.data && timeoutNs != 0) {
+        if (timeoutNs != EVENT_WAIT_FOREVER && umsbb_clock_ns() - start >= timeoutNs) break;
+        umsbb_yield();
+        handle = umsbb_claim_credited(bus, laneIndex, size, 1);
+    }
+#endif
+    if (!handle.data) return false;
 
-    void* ptr = bi_buffer_claim(target, sizeof(MessageCapsule));
-    if (ptr) {
-        memcpy(ptr, cap, sizeof(MessageCapsule));
-        bi_buffer_commit(target, ptr, sizeof(MessageCapsule));
-        event_signal(&bus->scheduler);
-        
-        // Track successful submission for batching feedback
-        FeedbackEntry fb = {
-            .sequence = cap->header.sequence,
-            .type = FEEDBACK_OK,
-            .note = "Message submitted successfully",
-            .timestamp = (uint64_t)time(NULL)
-        };
-        feedback_push(&bus->feedback, fb);
-        
-        bus->total_operations++;
-        bus->load_factor = (double)bus->total_operations / (bus->segment_count * 1000.0);
-        return true;
+    memcpy(handle.data, msg, size);
+    return umsbb_commit(bus, &handle);
+}
+
+#if UMSBB_ENABLE_FLOW_CONTROL
+bool umsbb_get_backpressure_stats(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, HighWaterMarkStats* out) {
+    if (!bus || !out || laneIndex >= bus->ring.laneCount) return false;
+    hwm_get_stats(bus->credit[laneIndex], out);
+    return true;
+}
+#endif
+
+#if UMSBB_ENABLE_BATCHING
+bool umsbb_configure_batching(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex,
+                              const SubmitBatchConfig* config) {
+    if (!bus || laneIndex >= bus->ring.laneCount) return false;
+    SubmitBatchConfig limits;
+    if (config) {
+        limits = *config;
     } else {
-        FeedbackEntry fb = {
-            .sequence = cap->header.sequence,
-            .type = FEEDBACK_SKIPPED,
-            .note = "Buffer claim failed",
-            .timestamp = (uint64_t)time(NULL)
-        };
-        feedback_push(&bus->feedback, fb);
-        return false;
+        submit_batch_default_config(&limits);
     }
+    // A full frame must be claimable, and payable from the lane's credit
+    size_t fit = bi_buffer_capacity(bus->ring.buffers[laneIndex]) / 4;
+    if (limits.max_bytes > fit) limits.max_bytes = (uint32_t)fit;
+
+    SubmitBatcher* batcher = umsbb_batcher(bus, laneIndex);
+    if (!batcher) {
+        if (limits.max_records <= 1) return true;
+        batcher = submit_batcher_create(laneIndex, &limits, umsbb_commit_batch, bus);
+        if (!batcher) return false;
+        size_t expected = 0;
+        if (atomic_cas_size(&bus->batchers[laneIndex], &expected, (size_t)(uintptr_t)batcher)) return true;
+        submit_batcher_destroy(batcher); // Lost to a concurrent configure
+        batcher = (SubmitBatcher*)(uintptr_t)expected;
+    }
+    // Kept when turned off: frames already batched still need unpacking
+    submit_batcher_configure(batcher, &limits);
+    if (limits.max_records <= 1) submit_batcher_flush(batcher, false);
+    return true;
 }
 
+size_t umsbb_flush_batches(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex) {
+    if (!bus || laneIndex >= bus->ring.laneCount) return 0;
+    return submit_batcher_flush(umsbb_batcher(bus, laneIndex), false);
+}
+
+bool umsbb_get_batching_stats(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, SubmitBatchStats* out) {
+    if (!bus || !out || laneIndex >= bus->ring.laneCount) return false;
+    SubmitBatcher* batcher = umsbb_batcher(bus, laneIndex);
+    if (!batcher) return false;
+    submit_batcher_get_stats(batcher, out);
+    return true;
+}
+#endif
+
+#if UMSBB_API_LEVEL >= 1
 void umsbb_drain(UniversalMultiSegmentedBiBufferBus* bus) {
-    size_t lane = bus->ring.currentIndex;
-    umsbb_drain_from(bus, lane);
-    bus->ring.currentIndex = (lane + 1) % bus->ring.activeCount;
+    // Next lane with work from the ready map; with none, probe the current one
+    size_t lane = segment_ring_next_ready(&bus->ring, bus->ring.currentIndex);
+    size_t size;
+    if (lane == SEGMENT_RING_NONE) lane = bus->ring.currentIndex;
+    if (lane >= bus->ring.laneCount) lane = 0;
+    umsbb_message_release(umsbb_drain_from(bus, lane, &size));
+    // Retired lanes are still drained until empty
+    bus->ring.currentIndex = (lane + 1) % bus->ring.laneCount;
 }
+#endif
 
-void* umsbb_drain_from(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, size_t* dataSize) {
-    *dataSize = 0;
-    if (laneIndex >= bus->ring.activeCount) return NULL;
-    BiBuffer* buf = &bus->ring.buffers[laneIndex];
+#if UMSBB_ENABLE_BATCHING
+// Commit the lane's staged messages whose deadline has passed
+static inline bool umsbb_flush_expired(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex) {
+    SubmitBatcher* batcher = umsbb_batcher(bus, laneIndex);
+    return batcher && submit_batcher_flush(batcher, true) > 0;
+}
+
+// Feed a frame the consumer retires on a batching lane to its AdaptiveBatch:
+// the lane's backlog and, for a batched frame, how long it sat in the ring
+static void umsbb_observe_batching(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, SubmitBatcher* batcher,
+                                   const SubmitBatchHeader* batched) {
+    BiBuffer* buf = bus->ring.buffers[laneIndex];
+    uint64_t latency = 0;
+    if (batched) {
+        uint64_t now = umsbb_clock_ns();
+        latency = now > batched->committed_ns ? now - batched->committed_ns : 0;
+    }
+    submit_batcher_observe(batcher, bi_buffer_backlog(buf), bi_buffer_capacity(buf), latency);
+}
+#endif
+
+// Checksum and layout of a frame; a batched one is checked when its first
+// record is read (`offset` 0) and trusted for the rest
+static inline bool umsbb_frame_readable(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex,
+                                        const BiBufferFrame* frame, const void* data, size_t size, size_t offset) {
+    if (!umsbb_frame_batched(frame)) return umsbb_frame_intact(frame, data, size);
+#if UMSBB_ENABLE_BATCHING
+    if (!umsbb_batcher(bus, laneIndex)) return false;
+    return offset != 0 || (umsbb_frame_intact(frame, data, size) && submit_batch_frame_valid(data, size));
+#else
+    (void)bus;
+    (void)laneIndex;
+    (void)offset;
+    return false;
+#endif
+}
+
+bool umsbb_drain_view(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, umsbb_msg_view* view) {
+    if (!bus || !view || laneIndex >= bus->ring.laneCount) return false;
+    BiBuffer* buf = bus->ring.buffers[laneIndex];
 
     size_t size;
     void* ptr = bi_buffer_read(buf, &size);
+#if UMSBB_ENABLE_BATCHING
+    // An empty lane is where staged messages past their deadline go out
+    if (!ptr && umsbb_flush_expired(bus, laneIndex)) ptr = bi_buffer_read(buf, &size);
+    SubmitBatcher* batcher = umsbb_batcher(bus, laneIndex);
+    size_t offset = batcher ? batcher->offset : 0;
+#else
+    size_t offset = 0;
+#endif
     if (!ptr) {
-        FeedbackEntry fb = {
-            .sequence = bus->sequence,
-            .type = FEEDBACK_IDLE,
-            .note = "No data to drain",
-            .timestamp = (uint64_t)time(NULL)
-        };
-        feedback_push(&bus->feedback, fb);
-        return NULL;
+        segment_ring_mark_drained(&bus->ring, laneIndex); // Drop a stale ready bit
+        return false;
     }
 
-    MessageCapsule* cap = (MessageCapsule*)ptr;
-    FeedbackEntry fb = {
-        .sequence = cap->header.sequence,
-        .timestamp = (uint64_t)time(NULL),
-        .note = "",
-        .type = FEEDBACK_OK
-    };
-
-    if (!capsule_validate(cap)) {
-        fb.type = FEEDBACK_CORRUPTED;
-        fb.note = "Checksum mismatch - state machine integrity failure";
-        feedback_push(&bus->feedback, fb);
+    BiBufferFrame* frame = bi_buffer_frame(ptr);
+    if (!umsbb_frame_readable(bus, laneIndex, frame, ptr, size, offset)) {
+        umsbb_push_feedback(bus, laneIndex, frame->sequence, FEEDBACK_CORRUPTED,
+                            "Checksum mismatch - state machine integrity failure");
         bi_buffer_release(buf);
-        return NULL;
+        umsbb_credit_release(bus, laneIndex, BI_BUFFER_FRAME_SIZE(size));
+        segment_ring_mark_drained(&bus->ring, laneIndex);
+        return false;
     }
 
-    // Allocate memory for the payload data
-    void* result = malloc(cap->size);
-    if (!result) {
-        fb.type = FEEDBACK_SKIPPED;
-        fb.note = "Memory allocation failed";
-        feedback_push(&bus->feedback, fb);
-        bi_buffer_release(buf);
-        return NULL;
+    frame->state = MSG_STATE_CONSUMING;
+    view->data = ptr;
+    view->size = size;
+    view->sequence = frame->sequence;
+#if UMSBB_ENABLE_BATCHING
+    if (umsbb_frame_batched(frame)) {
+        if (offset == 0) batcher->offset = (uint32_t)(offset = sizeof(SubmitBatchHeader));
+        const SubmitRecord* record = submit_batch_record(ptr, offset);
+        view->data = record + 1;
+        view->size = record->length;
+        view->sequence = frame->sequence + record->index;
     }
+#endif
+    return true;
+}
 
-    // Copy payload data
-    memcpy(result, cap->payload, cap->size);
-    *dataSize = cap->size;
+// Only clear the event if no more data is available across all buffers.
+// Look again after clearing: a commit that raced the clear re-signals here
+// instead of leaving a blocked consumer asleep with data in the ring.
+static void umsbb_update_scheduler(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex) {
+    if (segment_ring_mark_drained(&bus->ring, laneIndex)) return;
+    if (segment_ring_has_ready(&bus->ring)) return;
+    event_clear(&bus->scheduler);
+    if (segment_ring_has_ready(&bus->ring)) event_signal(&bus->scheduler);
+}
 
-    if (bus->gpu_enabled && try_gpu_execute(result, cap->size)) {
-        fb.type = FEEDBACK_GPU_EXECUTED;
-        fb.note = "GPU acceleration successful";
-        batch_next(&bus->batch, 95); // High success rate for GPU
-    } else {
-        fb.type = FEEDBACK_CPU_EXECUTED;
-        fb.note = "CPU fallback execution";
-        batch_next(&bus->batch, 75); // Lower success rate for CPU
+#if UMSBB_ENABLE_BATCHING
+// Commit staged messages past their deadline; returns how long a consumer
+// may then sleep, at most `timeoutNs`, without missing the next deadline
+static uint64_t umsbb_flush_due(UniversalMultiSegmentedBiBufferBus* bus, uint64_t timeoutNs) {
+    for (size_t lane = 0; lane < bus->ring.laneCount; ++lane) {
+        SubmitBatcher* batcher = umsbb_batcher(bus, lane);
+        if (!batcher) continue;
+        submit_batcher_flush(batcher, true);
+        if (atomic_load_size_relaxed(&batcher->staged) == 0) continue;
+        uint64_t delay = atomic_load_size_relaxed(&batcher->max_delay_ns);
+        if (delay < 1000) delay = 1000; // A stage that could not go yet is not worth spinning on
+        if (delay < timeoutNs) timeoutNs = delay;
+    }
+    return timeoutNs;
+}
+#endif
+
+bool umsbb_wait(UniversalMultiSegmentedBiBufferBus* bus, uint64_t timeoutNs) {
+    if (!bus) return false;
+#if UMSBB_ENABLE_BATCHING
+    // Sleep in slices no longer than a staged message may wait
+    for (;;) {
+        uint64_t slice = umsbb_flush_due(bus, timeoutNs);
+        if (segment_ring_has_ready(&bus->ring)) return true;
+        event_clear(&bus->scheduler);
+        if (segment_ring_has_ready(&bus->ring)) return true;
+        if (event_wait(&bus->scheduler, slice)) return true;
+        if (slice == timeoutNs) return false;
+        if (timeoutNs != EVENT_WAIT_FOREVER) timeoutNs -= slice;
     }
+#else
+    if (segment_ring_has_ready(&bus->ring)) return true;
+    event_clear(&bus->scheduler);
+    if (segment_ring_has_ready(&bus->ring)) return true;
+    return event_wait(&bus->scheduler, timeoutNs);
+#endif
+}
 
-    feedback_push(&bus->feedback, fb);
+int umsbb_event_fd(UniversalMultiSegmentedBiBufferBus* bus) {
+    return bus ? event_fd(&bus->scheduler) : -1;
+}
+
+void umsbb_release_view(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex) {
+    if (!bus || laneIndex >= bus->ring.laneCount) return;
+    BiBuffer* buf = bus->ring.buffers[laneIndex];
+
+#if UMSBB_ENABLE_BATCHING
+    size_t size;
+    void* held = bi_buffer_read(buf, &size);
+    SubmitBatcher* batcher = umsbb_batcher(bus, laneIndex);
+    if (held && batcher) {
+        const SubmitBatchHeader* batched = NULL;
+        if (umsbb_frame_batched(bi_buffer_frame(held))) {
+            // The frame stays at the head until its last record is released
+            size_t offset = batcher->offset;
+            if (offset != 0) {
+                offset += SUBMIT_BATCH_RECORD_SIZE(submit_batch_record(held, offset)->length);
+                if (offset < size) {
+                    batcher->offset = (uint32_t)offset;
+                    umsbb_count_operations(bus, 1);
+                    return;
+                }
+            }
+            batcher->offset = 0;
+            batched = (const SubmitBatchHeader*)held;
+        }
+        umsbb_observe_batching(bus, laneIndex, batcher, batched);
+    }
     bi_buffer_release(buf); // This transitions through FEEDBACK → FREE
-    
-    bus->total_operations++;
-    
-    // Only clear event if no more data is available across all buffers
-    bool hasMoreData = false;
-    for (size_t i = 0; i < bus->ring.activeCount; ++i) {
-        size_t testSize;
-        if (bi_buffer_read(&bus->ring.buffers[i], &testSize)) {
-            hasMoreData = true;
-            break;
+    if (held) umsbb_credit_release(bus, laneIndex, BI_BUFFER_FRAME_SIZE(size));
+#elif UMSBB_ENABLE_FLOW_CONTROL
+    size_t size;
+    bool held = bi_buffer_read(buf, &size) != NULL;
+    bi_buffer_release(buf); // This transitions through FEEDBACK → FREE
+    if (held) umsbb_credit_release(bus, laneIndex, BI_BUFFER_FRAME_SIZE(size));
+#else
+    bi_buffer_release(buf);
+#endif
+    umsbb_count_operations(bus, 1);
+    umsbb_update_scheduler(bus, laneIndex);
+}
+
+size_t umsbb_drain_batch(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex,
+                         umsbb_msg_view* out, size_t max) {
+    if (!bus || !out || max == 0 || laneIndex >= bus->ring.laneCount) return 0;
+    BiBuffer* buf = bus->ring.buffers[laneIndex];
+
+#if UMSBB_ENABLE_BATCHING
+    umsbb_flush_expired(bus, laneIndex);
+    SubmitBatcher* batcher = umsbb_batcher(bus, laneIndex);
+    size_t resume = batcher ? batcher->offset : 0; // Into the head frame when it is partly released
+#endif
+    size_t cursor = bi_buffer_read_cursor(buf);
+    size_t count = 0;
+    while (count < max) {
+        size_t size;
+        void* ptr = bi_buffer_peek(buf, &cursor, &size);
+        if (!ptr) break;
+#if UMSBB_ENABLE_BATCHING
+        size_t offset = resume;
+        resume = 0;
+#else
+        size_t offset = 0;
+#endif
+
+        BiBufferFrame* frame = bi_buffer_frame(ptr);
+        if (!umsbb_frame_readable(bus, laneIndex, frame, ptr, size, offset)) {
+            if (count > 0) break; // Leave it at the head of the next batch
+            umsbb_push_feedback(bus, laneIndex, frame->sequence, FEEDBACK_CORRUPTED,
+                                "Checksum mismatch - state machine integrity failure");
+            bi_buffer_release_to(buf, cursor);
+            umsbb_credit_release(bus, laneIndex, BI_BUFFER_FRAME_SIZE(size));
+            continue;
         }
+
+        frame->state = MSG_STATE_CONSUMING;
+#if UMSBB_ENABLE_BATCHING
+        if (umsbb_frame_batched(frame)) {
+            // A frame cut short by `max` starts the next batch
+            for (offset = offset ? offset : sizeof(SubmitBatchHeader); offset < size && count < max; count++) {
+                const SubmitRecord* record = submit_batch_record(ptr, offset);
+                out[count].data = record + 1;
+                out[count].size = record->length;
+                out[count].sequence = frame->sequence + record->index;
+                offset += SUBMIT_BATCH_RECORD_SIZE(record->length);
+            }
+            continue;
+        }
+#endif
+        out[count].data = ptr;
+        out[count].size = size;
+        out[count].sequence = frame->sequence;
+        count++;
     }
-    if (!hasMoreData) {
-        event_clear(&bus->scheduler);
+    if (count == 0) segment_ring_mark_drained(&bus->ring, laneIndex);
+    return count;
+}
+
+#if UMSBB_ENABLE_BATCHING
+// umsbb_release_batch on a batching lane, where views may be records: walk
+// the frames again, retire those whose every message is in `views` and
+// remember how far into a frame that is only partly released the batch got
+static void umsbb_release_records(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, SubmitBatcher* batcher,
+                                  const umsbb_msg_view* views, size_t count) {
+    BiBuffer* buf = bus->ring.buffers[laneIndex];
+    size_t cursor = bi_buffer_read_cursor(buf);
+    size_t released = cursor;
+    size_t offset = batcher->offset;
+    size_t bytes = 0, i = 0;
+    const SubmitBatchHeader* batched = NULL;
+    while (i < count) {
+        size_t size;
+        void* ptr = bi_buffer_peek(buf, &cursor, &size);
+        if (!ptr) break;
+
+        if (!umsbb_frame_batched(bi_buffer_frame(ptr))) {
+            if (views[i].data != ptr) break;
+            i++;
+        } else {
+            size_t start = offset;
+            if (offset == 0) offset = sizeof(SubmitBatchHeader);
+            while (i < count && offset < size) {
+                const SubmitRecord* record = submit_batch_record(ptr, offset);
+                if (views[i].data != record + 1) break;
+                offset += SUBMIT_BATCH_RECORD_SIZE(record->length);
+                i++;
+            }
+            if (offset < size) {
+                // Nothing of it released: it is still checked when read next
+                if (start == 0 && offset == sizeof(SubmitBatchHeader)) offset = 0;
+                break;
+            }
+            batched = (const SubmitBatchHeader*)ptr;
+        }
+        released = cursor;
+        bytes += BI_BUFFER_FRAME_SIZE(size);
+        offset = 0;
     }
-    
+    batcher->offset = (uint32_t)offset;
+
+    if (bytes > 0) {
+        umsbb_observe_batching(bus, laneIndex, batcher, batched);
+        bi_buffer_release_to(buf, released);
+        umsbb_credit_release(bus, laneIndex, bytes);
+    }
+    umsbb_count_operations(bus, i);
+    umsbb_update_scheduler(bus, laneIndex);
+}
+#endif
+
+void umsbb_release_batch(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex,
+                         const umsbb_msg_view* views, size_t count) {
+    if (!bus || !views || count == 0 || laneIndex >= bus->ring.laneCount) return;
+#if UMSBB_ENABLE_BATCHING
+    SubmitBatcher* batcher = umsbb_batcher(bus, laneIndex);
+    if (batcher) {
+        umsbb_release_records(bus, laneIndex, batcher, views, count);
+        return;
+    }
+#endif
+    BiBuffer* buf = bus->ring.buffers[laneIndex];
+
+    // The batch is always the oldest run of frames, so everything up to the
+    // end of the last view can be retired with one index store
+    bi_buffer_release_to(buf, bi_buffer_cursor_after(buf, views[count - 1].data));
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; ++i) bytes += BI_BUFFER_FRAME_SIZE(views[i].size);
+    umsbb_credit_release(bus, laneIndex, bytes);
+    umsbb_count_operations(bus, count);
+    umsbb_update_scheduler(bus, laneIndex);
+}
+
+void* umsbb_drain_from(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, size_t* dataSize) {
+    *dataSize = 0;
+    if (laneIndex >= bus->ring.laneCount) return NULL;
+
+    umsbb_msg_view view;
+    if (!umsbb_drain_view(bus, laneIndex, &view)) {
+        umsbb_push_feedback(bus, laneIndex, (uint32_t)atomic_load_size(&bus->sequence), FEEDBACK_IDLE, "No data to drain");
+        return NULL;
+    }
+
+    // Copy out for callers that own the result; zero-copy callers use umsbb_drain_view
+    void* result = message_pool_alloc(view.size);
+    if (!result) {
+        umsbb_push_feedback(bus, laneIndex, view.sequence, FEEDBACK_SKIPPED, "Memory allocation failed");
+        umsbb_release_view(bus, laneIndex);
+        return NULL;
+    }
+
+    bool offloaded = umsbb_offload_copy(bus, OFFLOAD_OP_DRAIN, result, view.data, view.size);
+    *dataSize = view.size;
+
+    if (offloaded) {
+        umsbb_push_feedback(bus, laneIndex, view.sequence, FEEDBACK_GPU_EXECUTED, "GPU acceleration successful");
+    } else {
+        umsbb_push_feedback(bus, laneIndex, view.sequence, FEEDBACK_CPU_EXECUTED, "CPU fallback execution");
+    }
+
+    umsbb_release_view(bus, laneIndex);
     return result;
 }
 
 // Legacy drain_from function for compatibility
 void umsbb_drain_from_legacy(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex) {
     size_t size;
-    void* data = umsbb_drain_from(bus, laneIndex, &size);
-    if (data) {
-        free(data); // Just discard the data for legacy compatibility
-    }
+    umsbb_message_release(umsbb_drain_from(bus, laneIndex, &size)); // Discarded for legacy compatibility
 }
 
+void umsbb_message_release(void* msg) {
+    message_pool_release(msg);
+}
+
+#if UMSBB_ENABLE_GPU
 // Enhanced API functions
 bool umsbb_configure_gpu(UniversalMultiSegmentedBiBufferBus* bus, bool enable) {
     if (!bus) return false;
     
     if (enable && gpu_available()) {
         bus->gpu_enabled = initialize_gpu();
+        if (bus->gpu_enabled) umsbb_calibrate_offload(bus);
         return bus->gpu_enabled;
     } else {
         bus->gpu_enabled = false;
+        offload_planner_set_gpu(&bus->offload, false);
         return true;
     }
 }
 
+bool umsbb_get_offload_stats(UniversalMultiSegmentedBiBufferBus* bus, OffloadOp op, OffloadStats* out) {
+    if (!bus || !out || op >= OFFLOAD_OP_COUNT) return false;
+    offload_planner_stats(&bus->offload, op, out);
+    return true;
+}
+#endif
+
+#if UMSBB_API_LEVEL >= 1
 double umsbb_get_load_factor(UniversalMultiSegmentedBiBufferBus* bus) {
     if (!bus) return 0.0;
-    return bus->load_factor;
+    return (double)atomic_load_size_relaxed(&bus->total_operations) / (bus->segment_count * 1000.0);
 }
+#endif
 
+#if UMSBB_API_LEVEL >= 2
 uint32_t umsbb_get_optimal_segments(UniversalMultiSegmentedBiBufferBus* bus) {
     if (!bus) return 4;
     
     // Calculate optimal segments based on load factor
-    double load = bus->load_factor;
+    double load = umsbb_get_load_factor(bus);
     if (load > 0.8) {
         return bus->segment_count * 2; // Scale up
     } else if (load < 0.3 && bus->segment_count > 2) {
@@ -270,39 +993,163 @@ uint32_t umsbb_get_optimal_segments(UniversalMultiSegmentedBiBufferBus* bus) {
 }
 
 bool umsbb_scale_segments(UniversalMultiSegmentedBiBufferBus* bus, uint32_t newCount) {
-    if (!bus || newCount == 0 || newCount == bus->segment_count) return false;
-    
-    // For now, this is a placeholder - full implementation would require
-    // careful migration of existing data
-    bus->segment_count = newCount;
+    if (!bus || newCount == 0) return false;
+    if (newCount > SEGMENT_RING_MAX_LANES) newCount = SEGMENT_RING_MAX_LANES;
+
+    // Lanes are added or retired one at a time while traffic keeps flowing;
+    // retired lanes stop taking submissions and are drained as usual
+    while (bus->ring.activeCount < newCount) {
+        size_t lane = bus->ring.activeCount;
+#if UMSBB_ENABLE_FEEDBACK
+        if (!feedback_enable_lane(&bus->feedback, lane)) break;
+#endif
+#if UMSBB_ENABLE_FLOW_CONTROL
+        // Revived lanes keep their gate and its outstanding credit
+        if (!bus->credit[lane] && !(bus->credit[lane] = umsbb_create_gate(bus, bus->ring.bufferCap))) break;
+#else
+        (void)lane;
+#endif
+        if (!segment_ring_add_lane(&bus->ring)) break;
+#if UMSBB_ENABLE_FLOW_CONTROL
+        umsbb_fit_gate(bus, lane);
+#endif
+    }
+    while (bus->ring.activeCount > newCount) {
+        if (!segment_ring_remove_lane(&bus->ring)) break;
+    }
+    bus->segment_count = (uint32_t)bus->ring.activeCount;
+    return true;
+}
+
+bool umsbb_resize_lane(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, size_t newCap) {
+    if (!bus || laneIndex >= bus->ring.laneCount) return false;
+    if (!bi_buffer_resize(bus->ring.buffers[laneIndex], newCap)) return false;
+
+#if UMSBB_ENABLE_FLOW_CONTROL
+    // Messages still in the old region stay charged and are returned as drained
+    umsbb_fit_gate(bus, laneIndex);
+#endif
+    return true;
+}
+#endif
+
+#if UMSBB_ENABLE_FEEDBACK
+void umsbb_feedback_cursor(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, FeedbackCursor* cursor) {
+    feedback_cursor_init(&bus->feedback, laneIndex, cursor);
+}
+
+size_t umsbb_read_feedback(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, FeedbackCursor* cursor,
+                           FeedbackEntry* out, size_t max) {
+    if (!bus || !cursor) return 0;
+    return feedback_read(&bus->feedback, laneIndex, cursor, out, max);
+}
+
+void umsbb_configure_feedback_sampling(UniversalMultiSegmentedBiBufferBus* bus, uint32_t sampleEvery) {
+    if (bus) feedback_set_sampling(&bus->feedback, sampleEvery);
+}
+#endif
+
+#if UMSBB_ENABLE_FAST_LANES
+#if UMSBB_ENABLE_GPU
+struct umsbb_spilled_result {
+    struct umsbb_spilled_result* next;
+    uint32_t priority;
+    size_t size;
+    uint8_t data[];
+};
+
+static void umsbb_spill_lock(umsbb_gpu_spill* spill) {
+    while (atomic_exchange_u32(&spill->lock, 1)) umsbb_yield();
+}
+
+static void umsbb_spill_unlock(umsbb_gpu_spill* spill) {
+    atomic_store_u32(&spill->lock, 0);
+}
+
+// Queue a coalesced result behind the others its full lane refused
+static bool umsbb_spill_result(UniversalMultiSegmentedBiBufferBus* bus, uint32_t lane, const void* data, size_t size,
+                               uint32_t priority) {
+    struct umsbb_spilled_result* entry = malloc(sizeof(*entry) + size);
+    if (!entry) return false;
+    entry->next = NULL;
+    entry->priority = priority;
+    entry->size = size;
+    memcpy(entry->data, data, size);
+
+    umsbb_gpu_spill* spill = &bus->gpu_spill[lane];
+    umsbb_spill_lock(spill);
+    if (spill->tail) {
+        spill->tail->next = entry;
+    } else {
+        spill->head = entry;
+    }
+    spill->tail = entry;
+    atomic_store_size(&spill->count, atomic_load_size_relaxed(&spill->count) + 1);
+    umsbb_spill_unlock(spill);
     return true;
 }
 
-FeedbackEntry* umsbb_get_feedback(UniversalMultiSegmentedBiBufferBus* bus, size_t* count) {
-    *count = bus->feedback.count;
-    return bus->feedback.entries;
+// Move spilled results into their lane, oldest first, while it has room;
+// true if any went in
+static bool umsbb_flush_spill(UniversalMultiSegmentedBiBufferBus* bus, lane_type_t lane) {
+    umsbb_gpu_spill* spill = &bus->gpu_spill[lane];
+    if (atomic_load_size(&spill->count) == 0) return false;
+
+    size_t moved = 0;
+    umsbb_spill_lock(spill);
+    struct umsbb_spilled_result* entry;
+    while ((entry = spill->head) != NULL &&
+           fast_lane_try_submit(&bus->fast_lanes, lane, entry->data, entry->size, entry->priority)) {
+        spill->head = entry->next;
+        free(entry);
+        moved++;
+    }
+    if (!spill->head) spill->tail = NULL;
+    atomic_store_size(&spill->count, atomic_load_size_relaxed(&spill->count) - moved);
+    umsbb_spill_unlock(spill);
+    return moved > 0;
 }
 
+// Results still spilled when the bus goes away
+static void umsbb_free_spills(UniversalMultiSegmentedBiBufferBus* bus) {
+    for (size_t lane = 0; lane < LANE_COUNT; ++lane) {
+        struct umsbb_spilled_result* entry = bus->gpu_spill[lane].head;
+        while (entry) {
+            struct umsbb_spilled_result* next = entry->next;
+            free(entry);
+            entry = next;
+        }
+    }
+}
+#endif
+
 // V3.0 Fast Lane API implementations
 bool umsbb_fast_lane_submit(UniversalMultiSegmentedBiBufferBus* bus, lane_type_t lane, 
                            const void* data, size_t size, uint32_t priority) {
     if (!bus) return false;
     
-    bool success = fast_lane_submit(&bus->fast_lanes, lane, data, size, priority);
+    bool success;
+#if UMSBB_ENABLE_GPU
+    if (bus->gpu_coalescer && (lane == LANE_BULK || lane == LANE_STREAMING)) {
+        success = gpu_pipeline_submit_tagged(bus->gpu_coalescer, data, size, (uint32_t)lane, priority) == 0;
+    } else
+#endif
+    {
+        success = fast_lane_submit(&bus->fast_lanes, lane, data, size, priority);
+    }
     
     if (success) {
-        bus->total_operations++;
+        umsbb_count_operations(bus, 1);
         
         // Update performance metrics
         bus->messages_per_second++;
         bus->bytes_per_second += size;
         
         // Report success to fault tolerance system
-        fault_tolerance_update_component_health(&bus->fault_tolerance, (uint32_t)lane, true, 0);
+        umsbb_note_health(bus, (uint32_t)lane);
     } else {
         // Report failure to fault tolerance system
-        fault_tolerance_report_fault(&bus->fault_tolerance, FAULT_TYPE_OVERFLOW, 
-                                   (uint32_t)lane, "Fast lane submit failed");
+        umsbb_note_fault(bus, FAULT_TYPE_OVERFLOW, (uint32_t)lane, "Fast lane submit failed");
     }
     
     return success;
@@ -313,25 +1160,160 @@ void* umsbb_fast_lane_drain(UniversalMultiSegmentedBiBufferBus* bus, lane_type_t
     if (!bus) return NULL;
     
     void* result = fast_lane_drain(&bus->fast_lanes, lane, size, priority);
+#if UMSBB_ENABLE_GPU
+    if (lane == LANE_BULK || lane == LANE_STREAMING) {
+        // Refill the lane from its spill first, then from finished batches
+        bool refilled = umsbb_flush_spill(bus, lane);
+        if (!result && (refilled || (bus->gpu_coalescer && gpu_pipeline_poll(bus->gpu_coalescer)))) {
+            result = fast_lane_drain(&bus->fast_lanes, lane, size, priority);
+        }
+    }
+#endif
     
     if (result) {
-        bus->total_operations++;
+        umsbb_count_operations(bus, 1);
         
         // Update performance metrics
         bus->messages_per_second++;
         bus->bytes_per_second += *size;
         
         // Report success to fault tolerance system
-        fault_tolerance_update_component_health(&bus->fault_tolerance, (uint32_t)lane, true, 0);
+        umsbb_note_health(bus, (uint32_t)lane);
     }
     
     return result;
 }
 
-lane_type_t umsbb_select_optimal_lane(size_t message_size, uint32_t priority, bool latency_critical) {
-    return fast_lane_select_optimal(message_size, priority, latency_critical);
+#if UMSBB_ENABLE_GPU
+// Tag of a message umsbb_drain_to_gpu moved off a ring lane: the flag, the
+// ring lane in bits 32-62 and its sequence in the low 32 bits
+#define UMSBB_COALESCED_RING (1ull << 63)
+
+// Scatter one coalesced result back into its fast lane. A fast lane submit's
+// tag is its priority; a ring lane message goes to the result handler with
+// its lane and sequence, or without one to its fast lane at priority 0. The
+// source has already let go of the message, so a full lane spills it rather
+// than drop it, and while a spill is waiting newer results queue behind it.
+static void umsbb_coalesced_result(void* context, uint64_t tag, const void* data, size_t size, uint32_t lane) {
+    UniversalMultiSegmentedBiBufferBus* bus = (UniversalMultiSegmentedBiBufferBus*)context;
+    if ((tag & UMSBB_COALESCED_RING) && bus->gpu_result) {
+        bus->gpu_result(bus->gpu_result_context, (size_t)((tag >> 32) & 0x7FFFFFFFu), (uint32_t)tag, data, size);
+        return;
+    }
+    uint32_t priority = (tag & UMSBB_COALESCED_RING) ? 0 : (uint32_t)tag;
+    if (atomic_load_size(&bus->gpu_spill[lane].count) == 0 &&
+        fast_lane_submit(&bus->fast_lanes, (lane_type_t)lane, data, size, priority)) {
+        return;
+    }
+    if (!umsbb_spill_result(bus, lane, data, size, priority)) {
+        umsbb_note_fault(bus, FAULT_TYPE_OVERFLOW, lane, "Coalesced GPU result dropped");
+    }
+}
+
+// A message moved off a ring lane that failed its checksum in the kernel
+static void umsbb_coalesced_reject(void* context, uint64_t tag, uint32_t lane, batch_record_status_t status) {
+    (void)lane;
+    if (!(tag & UMSBB_COALESCED_RING) || status != BATCH_RECORD_CORRUPT) return;
+    UniversalMultiSegmentedBiBufferBus* bus = (UniversalMultiSegmentedBiBufferBus*)context;
+    umsbb_push_feedback(bus, (size_t)((tag >> 32) & 0x7FFFFFFFu), (uint32_t)tag, FEEDBACK_CORRUPTED,
+                        "Checksum mismatch - detected in GPU batch");
+}
+
+bool umsbb_enable_gpu_coalescing(UniversalMultiSegmentedBiBufferBus* bus, const gpu_pipeline_config_t* config) {
+    if (!bus || bus->gpu_coalescer) return false;
+    
+    gpu_pipeline_config_t pipeline;
+    if (config) {
+        pipeline = *config;
+    } else {
+        gpu_pipeline_default_config(&pipeline);
+    }
+    pipeline.on_result = umsbb_coalesced_result;
+    pipeline.on_reject = umsbb_coalesced_reject;
+    pipeline.on_complete = NULL;
+    pipeline.context = bus;
+    
+    // The ring of the buffer goes unused: every result has a lane
+    gpu_accelerated_buffer_t* coalescer = malloc(sizeof(gpu_accelerated_buffer_t));
+    if (!coalescer) return false;
+    if (gpu_buffer_init(coalescer, 4096, bus->gpu_enabled ? GPU_PROCESSING_HYBRID : GPU_PROCESSING_DISABLED) != 0) {
+        free(coalescer);
+        return false;
+    }
+    if (gpu_pipeline_start(coalescer, &pipeline) != 0) {
+        gpu_buffer_cleanup(coalescer);
+        free(coalescer);
+        return false;
+    }
+    bus->gpu_coalescer = coalescer;
+    return true;
 }
 
+uint32_t umsbb_poll_gpu_coalescing(UniversalMultiSegmentedBiBufferBus* bus) {
+    if (!bus) return 0;
+    umsbb_flush_spill(bus, LANE_BULK);
+    umsbb_flush_spill(bus, LANE_STREAMING);
+    if (!bus->gpu_coalescer) return 0;
+    return gpu_pipeline_poll(bus->gpu_coalescer);
+}
+
+size_t umsbb_drain_to_gpu(UniversalMultiSegmentedBiBufferBus* bus, size_t laneIndex, size_t max) {
+    if (!bus || !bus->gpu_coalescer || max == 0 || laneIndex >= bus->ring.laneCount) return 0;
+    BiBuffer* buf = bus->ring.buffers[laneIndex];
+
+    // Frames are copied out as they are, checksums and all; the kernel verifies them
+    size_t cursor = bi_buffer_read_cursor(buf);
+    size_t released = cursor;
+    size_t count = 0, bytes = 0;
+    bool empty = true;
+    while (count < max) {
+        size_t size;
+        void* ptr = bi_buffer_peek(buf, &cursor, &size);
+        if (!ptr) break;
+        empty = false;
+
+        BiBufferFrame* frame = bi_buffer_frame(ptr);
+        if (umsbb_frame_batched(frame)) break; // Unpacked by umsbb_drain_from, like a frame too large for a stage
+        uint64_t tag = UMSBB_COALESCED_RING | ((uint64_t)laneIndex << 32) | frame->sequence;
+        if (gpu_pipeline_submit_checked(bus->gpu_coalescer, ptr, size, LANE_BULK, tag,
+                                        (checksum_policy_t)(frame->flags & CHECKSUM_POLICY_MASK),
+                                        frame->checksum) != 0) {
+            break; // Larger than a stage: left at the head for umsbb_drain_from
+        }
+        released = cursor;
+        bytes += BI_BUFFER_FRAME_SIZE(size);
+        count++;
+    }
+
+    if (count > 0) {
+        bi_buffer_release_to(buf, released);
+        umsbb_credit_release(bus, laneIndex, bytes);
+        umsbb_count_operations(bus, count);
+        umsbb_update_scheduler(bus, laneIndex);
+    } else if (empty) {
+        segment_ring_mark_drained(&bus->ring, laneIndex);
+    }
+    return count;
+}
+
+bool umsbb_set_gpu_result_handler(UniversalMultiSegmentedBiBufferBus* bus, umsbb_gpu_result_fn handler, void* context) {
+    // The pipeline's threads read it, and they start after this
+    if (!bus || bus->gpu_coalescer) return false;
+    bus->gpu_result = handler;
+    bus->gpu_result_context = context;
+    return true;
+}
+
+void umsbb_disable_gpu_coalescing(UniversalMultiSegmentedBiBufferBus* bus) {
+    if (!bus || !bus->gpu_coalescer) return;
+    gpu_buffer_cleanup(bus->gpu_coalescer);
+    free(bus->gpu_coalescer);
+    bus->gpu_coalescer = NULL;
+}
+#endif
+#endif
+
+#if UMSBB_ENABLE_TWIN_LANES
 // V3.0 Twin Lane API implementations
 uint32_t umsbb_twin_lane_create(UniversalMultiSegmentedBiBufferBus* bus, uint32_t peer_node_id, 
                                size_t tx_capacity, size_t rx_capacity) {
@@ -341,11 +1323,10 @@ uint32_t umsbb_twin_lane_create(UniversalMultiSegmentedBiBufferBus* bus, uint32_
     
     if (lane_id != UINT32_MAX) {
         // Report successful creation to fault tolerance system
-        fault_tolerance_update_component_health(&bus->fault_tolerance, lane_id + 1000, true, 0);
+        umsbb_note_health(bus, lane_id + 1000);
     } else {
         // Report failure
-        fault_tolerance_report_fault(&bus->fault_tolerance, FAULT_TYPE_MEMORY, 
-                                   0, "Twin lane creation failed");
+        umsbb_note_fault(bus, FAULT_TYPE_MEMORY, 0, "Twin lane creation failed");
     }
     
     return lane_id;
@@ -358,15 +1339,14 @@ bool umsbb_twin_lane_send(UniversalMultiSegmentedBiBufferBus* bus, uint32_t lane
     bool success = twin_lane_send(&bus->twin_lanes, lane_id, data, size, sequence);
     
     if (success) {
-        bus->total_operations++;
+        umsbb_count_operations(bus, 1);
         bus->bytes_per_second += size;
         
         // Report success to fault tolerance system
-        fault_tolerance_update_component_health(&bus->fault_tolerance, lane_id + 1000, true, 0);
+        umsbb_note_health(bus, lane_id + 1000);
     } else {
         // Report failure
-        fault_tolerance_report_fault(&bus->fault_tolerance, FAULT_TYPE_OVERFLOW, 
-                                   lane_id + 1000, "Twin lane send failed");
+        umsbb_note_fault(bus, FAULT_TYPE_OVERFLOW, lane_id + 1000, "Twin lane send failed");
     }
     
     return success;
@@ -379,16 +1359,75 @@ void* umsbb_twin_lane_receive(UniversalMultiSegmentedBiBufferBus* bus, uint32_t
     void* result = twin_lane_receive(&bus->twin_lanes, lane_id, size, sequence);
     
     if (result) {
-        bus->total_operations++;
+        umsbb_count_operations(bus, 1);
         bus->bytes_per_second += *size;
         
         // Report success to fault tolerance system
-        fault_tolerance_update_component_health(&bus->fault_tolerance, lane_id + 1000, true, 0);
+        umsbb_note_health(bus, lane_id + 1000);
     }
     
     return result;
 }
+#endif
+
+#if UMSBB_ENABLE_TOPICS
+static inline TopicRing* umsbb_topic(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic) {
+    if (!bus || topic >= UMSBB_MAX_TOPICS) return NULL;
+    return (TopicRing*)(uintptr_t)atomic_load_size_acquire(&bus->topics[topic]);
+}
+
+/* The topic's ring, installed with a CAS so racing creators agree on one. */
+static TopicRing* umsbb_topic_install(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, size_t capacity) {
+    TopicRing* ring = topic_ring_create(capacity ? capacity : bus->ring.bufferCap);
+    if (!ring) return NULL;
+    size_t expected = 0;
+    if (atomic_cas_size(&bus->topics[topic], &expected, (size_t)(uintptr_t)ring)) return ring;
+    topic_ring_destroy(ring);
+    return NULL;
+}
+
+bool umsbb_topic_create(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, size_t capacity) {
+    if (!bus || topic >= UMSBB_MAX_TOPICS || umsbb_topic(bus, topic)) return false;
+    return umsbb_topic_install(bus, topic, capacity) != NULL;
+}
+
+uint32_t umsbb_subscribe(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, TopicSlowPolicy policy) {
+    if (!bus || topic >= UMSBB_MAX_TOPICS) return TOPIC_RING_NO_SUBSCRIBER;
+    TopicRing* ring = umsbb_topic(bus, topic);
+    // A losing creator picks up the winner's ring
+    if (!ring && !(ring = umsbb_topic_install(bus, topic, 0)) && !(ring = umsbb_topic(bus, topic))) {
+        return TOPIC_RING_NO_SUBSCRIBER;
+    }
+    return topic_ring_subscribe(ring, policy);
+}
+
+void umsbb_unsubscribe(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, uint32_t subscriber) {
+    topic_ring_unsubscribe(umsbb_topic(bus, topic), subscriber);
+}
+
+bool umsbb_publish(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, const void* data, size_t size) {
+    if (!bus || topic >= UMSBB_MAX_TOPICS) return false;
+    TopicRing* ring = umsbb_topic(bus, topic);
+    if (!ring) return true;
+    return topic_ring_publish(ring, data, size, bus->checksum_policy);
+}
+
+size_t umsbb_topic_read(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, uint32_t subscriber,
+                        TopicMessage* out, size_t max) {
+    return topic_ring_read(umsbb_topic(bus, topic), subscriber, out, max);
+}
+
+bool umsbb_topic_release(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, uint32_t subscriber) {
+    return topic_ring_release(umsbb_topic(bus, topic), subscriber);
+}
+
+bool umsbb_topic_stats(UniversalMultiSegmentedBiBufferBus* bus, uint32_t topic, uint32_t subscriber,
+                       TopicSubscriberStats* out) {
+    return topic_ring_subscriber_stats(umsbb_topic(bus, topic), subscriber, out);
+}
+#endif
 
+#if UMSBB_ENABLE_RELIABILITY
 // V3.0 Reliable Delivery API implementations
 uint64_t umsbb_send_reliable(UniversalMultiSegmentedBiBufferBus* bus, uint32_t producer_id, 
                             uint32_t consumer_id, const void* data, size_t size) {
@@ -397,11 +1436,14 @@ uint64_t umsbb_send_reliable(UniversalMultiSegmentedBiBufferBus* bus, uint32_t p
     uint64_t sequence = handshake_send_message(&bus->handshake, producer_id, consumer_id, data, size);
     
     if (sequence > 0) {
-        bus->total_operations++;
+        umsbb_count_operations(bus, 1);
         bus->bytes_per_second += size;
         
-        // Persist message for zero-loss guarantee
-        fault_tolerance_persist_message(sequence, data, size);
+        // Persist before sending, so a consumer never sees a message the log could lose
+        fault_tolerance_persist_lane_message(consumer_id, sequence, data, size);
+        
+        // A first send that does not fit goes out later from the retained copy
+        twin_lane_send(&bus->twin_lanes, consumer_id, data, size, (uint32_t)sequence);
         
         // Update reliability score
         bus->reliability_score = (bus->reliability_score * 0.95) + (1.0 * 0.05);
@@ -417,26 +1459,44 @@ uint64_t umsbb_send_reliable(UniversalMultiSegmentedBiBufferBus* bus, uint32_t p
     return sequence;
 }
 
+// Flow control and reliability score for one accepted feedback message
+static void umsbb_apply_feedback_flow(UniversalMultiSegmentedBiBufferBus* bus, const feedback_message_t* feedback) {
+    // A SACK's sequence is cumulative, like the twin lane's own ACKs
+    bool positive = feedback->type == FEEDBACK_TYPE_ACK || feedback->type == FEEDBACK_TYPE_SACK;
+    if (positive) {
+        twin_lane_update_flow_control(&bus->twin_lanes, feedback->consumer_id, 
+                                    (uint32_t)feedback->sequence);
+    }
+    
+    // Update reliability score
+    double feedback_score = positive ? 1.0 : 0.0;
+    bus->reliability_score = (bus->reliability_score * 0.9) + (feedback_score * 0.1);
+}
+
 bool umsbb_send_feedback(UniversalMultiSegmentedBiBufferBus* bus, const feedback_message_t* feedback) {
     if (!bus || !feedback) return false;
     
     bool success = handshake_process_feedback(&bus->handshake, feedback);
     
     if (success) {
-        // Update flow control based on feedback
-        if (feedback->type == FEEDBACK_TYPE_ACK) {
-            twin_lane_update_flow_control(&bus->twin_lanes, feedback->consumer_id, 
-                                        (uint32_t)feedback->sequence);
-        }
-        
-        // Update reliability score
-        double feedback_score = (feedback->type == FEEDBACK_TYPE_ACK) ? 1.0 : 0.0;
-        bus->reliability_score = (bus->reliability_score * 0.9) + (feedback_score * 0.1);
+        umsbb_apply_feedback_flow(bus, feedback);
     }
     
     return success;
 }
 
+uint32_t umsbb_send_feedback_batch(UniversalMultiSegmentedBiBufferBus* bus, const feedback_message_t* feedback,
+                                   uint32_t count) {
+    if (!bus || !feedback) return 0;
+    
+    uint32_t matched = handshake_process_feedback_batch(&bus->handshake, feedback, count);
+    for (uint32_t i = 0; i < count; i++) {
+        umsbb_apply_feedback_flow(bus, &feedback[i]);
+    }
+    
+    return matched;
+}
+
 bool umsbb_process_acknowledgments(UniversalMultiSegmentedBiBufferBus* bus) {
     if (!bus) return false;
     
@@ -450,6 +1510,22 @@ bool umsbb_process_acknowledgments(UniversalMultiSegmentedBiBufferBus* bus) {
 }
 
 // V3.0 Fault Tolerance API implementations
+bool umsbb_enable_persistence(UniversalMultiSegmentedBiBufferBus* bus, const char* directory,
+                              const message_log_config_t* config) {
+    if (!bus) return false;
+    
+    if (!fault_tolerance_enable_persistence(&bus->fault_tolerance, directory, config)) return false;
+    fault_tolerance_set_replay_handler(&bus->fault_tolerance, umsbb_replay_logged, bus);
+    return true;
+}
+
+void umsbb_set_lane_durability(UniversalMultiSegmentedBiBufferBus* bus, uint32_t lane,
+                               message_log_durability_t durability) {
+    if (!bus) return;
+    
+    fault_tolerance_set_lane_durability(&bus->fault_tolerance, lane, durability);
+}
+
 bool umsbb_is_component_healthy(UniversalMultiSegmentedBiBufferBus* bus, uint32_t component_id) {
     if (!bus) return false;
     
@@ -474,7 +1550,191 @@ double umsbb_get_system_health(UniversalMultiSegmentedBiBufferBus* bus) {
     
     return fault_tolerance_get_system_health(&bus->fault_tolerance);
 }
+#endif
+
+#if UMSBB_ENABLE_PARALLEL
+// V3.1 Parallel Processing API implementations
+bool umsbb_enable_parallel_processing(UniversalMultiSegmentedBiBufferBus* bus, uint32_t worker_count, 
+                                     throughput_strategy_t strategy) {
+    if (!bus || bus->parallel_processing_enabled) return false;
+    
+    if (parallel_engine_init(&bus->parallel_engine, worker_count, strategy) != 0) {
+        return false;
+    }
+    parallel_set_strategy(&bus->parallel_engine, strategy);
+    
+    if (parallel_engine_start(&bus->parallel_engine) != 0) {
+        parallel_engine_destroy(&bus->parallel_engine);
+        return false;
+    }
+    
+    bus->parallel_processing_enabled = true;
+    bus->worker_thread_count = worker_count;
+    bus->current_strategy = strategy;
+    return true;
+}
+
+void umsbb_disable_parallel_processing(UniversalMultiSegmentedBiBufferBus* bus) {
+    if (!bus || !bus->parallel_processing_enabled) return;
+    
+    parallel_engine_destroy(&bus->parallel_engine);
+    bus->parallel_processing_enabled = false;
+    bus->worker_thread_count = 0;
+}
+
+bool umsbb_register_parallel_handler(UniversalMultiSegmentedBiBufferBus* bus, uint32_t lane_id,
+                                     parallel_handler_fn fn, void* ctx) {
+    if (!bus || !bus->parallel_processing_enabled) return false;
+    
+    return parallel_register_handler(&bus->parallel_engine, lane_id, fn, ctx) == 0;
+}
 
+bool umsbb_submit_parallel(UniversalMultiSegmentedBiBufferBus* bus, uint32_t lane_id,
+                          const void* data, uint32_t size, uint32_t priority, uint32_t language_id) {
+    if (!bus || !bus->parallel_processing_enabled || !data) return false;
+    
+    if (parallel_submit_work(&bus->parallel_engine, lane_id, data, size, priority, language_id) != 0) {
+        return false;
+    }
+    umsbb_count_operations(bus, 1);
+#if UMSBB_ENABLE_MULTILANG
+    if (language_id < WASM_LANG_COUNT) {
+        bus->language_performance_stats[language_id]++;
+    }
+#endif
+    return true;
+}
+
+bool umsbb_submit_batch_parallel(UniversalMultiSegmentedBiBufferBus* bus, 
+                                multilang_message_t* messages, uint32_t count) {
+    if (!bus || !bus->parallel_processing_enabled || !messages || count == 0) return false;
+    
+    uint32_t successful = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        multilang_message_t* msg = &messages[i];
+        
+        // Route by message characteristics
+        uint32_t lane_id;
+        if (msg->size > 8192) {
+            lane_id = LANE_BULK;
+        } else if (msg->priority > 150) {
+            lane_id = LANE_PRIORITY;
+        } else {
+            lane_id = LANE_STREAMING;
+        }
+        
+        if (umsbb_submit_parallel(bus, lane_id, msg->data, (uint32_t)msg->size,
+                                  msg->priority, msg->source_lang)) {
+            successful++;
+        }
+    }
+    return successful == count;
+}
+
+performance_profile_t umsbb_get_parallel_performance(UniversalMultiSegmentedBiBufferBus* bus) {
+    performance_profile_t profile;
+    memset(&profile, 0, sizeof(profile));
+    
+    if (!bus || !bus->parallel_processing_enabled) return profile;
+    
+    parallel_get_performance(&bus->parallel_engine, &profile);
+    return profile;
+}
+
+double umsbb_get_peak_throughput_mbps(UniversalMultiSegmentedBiBufferBus* bus) {
+    if (!bus || !bus->parallel_processing_enabled) return 0.0;
+    
+    return parallel_get_instantaneous_throughput_mbps(&bus->parallel_engine);
+}
+
+uint32_t umsbb_get_active_workers(UniversalMultiSegmentedBiBufferBus* bus) {
+    if (!bus || !bus->parallel_processing_enabled) return 0;
+    
+    // Live count: the scaling controller may have moved it
+    return atomic_load(&bus->parallel_engine.num_workers);
+}
+
+bool umsbb_enable_auto_scaling(UniversalMultiSegmentedBiBufferBus* bus, const parallel_autoscale_t* policy) {
+    if (!bus || !bus->parallel_processing_enabled) return false;
+    
+    return parallel_enable_autoscale(&bus->parallel_engine, policy) == 0;
+}
+
+bool umsbb_tune_parallel_performance(UniversalMultiSegmentedBiBufferBus* bus, 
+                                    uint32_t new_worker_count, uint32_t new_batch_size) {
+    if (!bus || !bus->parallel_processing_enabled) return false;
+    
+    int workers = parallel_adjust_workers(&bus->parallel_engine, new_worker_count);
+    int batch = parallel_tune_batch_size(&bus->parallel_engine, new_batch_size);
+    if (workers == 0) {
+        bus->worker_thread_count = new_worker_count;
+    }
+    return workers == 0 && batch == 0;
+}
+#endif
+
+#if UMSBB_ENABLE_MULTILANG
+// Whether `lane` is enabled and takes `size` bytes
+static bool umsbb_lane_fits(UniversalMultiSegmentedBiBufferBus* bus, lane_type_t lane, size_t size) {
+#if UMSBB_ENABLE_FAST_LANES
+    const fast_lane_t* l = &bus->fast_lanes.lanes[lane];
+    return l->capacity && size <= l->slot_size;
+#else
+    (void)bus;
+    (void)lane;
+    (void)size;
+    return true;
+#endif
+}
+
+lane_type_t umsbb_select_priority_lane(UniversalMultiSegmentedBiBufferBus* bus, 
+                                      const lane_selection_criteria_t* criteria) {
+    if (!bus || !criteria) return LANE_STREAMING;
+    
+    if ((unsigned)criteria->source_lang < WASM_LANG_COUNT && (unsigned)criteria->target_lang < WASM_LANG_COUNT) {
+        lane_type_t pinned = (lane_type_t)atomic_load_uchar(
+            &bus->lang_to_lane_map[criteria->source_lang][criteria->target_lang]);
+        if (pinned < LANE_COUNT && umsbb_lane_fits(bus, pinned, criteria->message_size)) return pinned;
+    }
+    if (criteria->priority >= LANE_ROUTER_PRIORITY && umsbb_lane_fits(bus, LANE_PRIORITY, criteria->message_size)) {
+        return LANE_PRIORITY;
+    }
+#if UMSBB_ENABLE_FAST_LANES
+    return lane_router_select(&bus->router, &bus->fast_lanes, criteria->message_size,
+                              criteria->latency_critical, criteria->timeout_ms);
+#else
+    return fast_lane_select_optimal(criteria->message_size, 0, criteria->latency_critical);
+#endif
+}
+
+bool umsbb_configure_lane_routing(UniversalMultiSegmentedBiBufferBus* bus, 
+                                 wasm_language_t source, wasm_language_t target, 
+                                 lane_type_t preferred_lane) {
+    if (!bus || (unsigned)source >= WASM_LANG_COUNT || (unsigned)target >= WASM_LANG_COUNT) return false;
+    if ((unsigned)preferred_lane > LANE_COUNT) return false;
+    if (preferred_lane < LANE_COUNT && !umsbb_lane_fits(bus, preferred_lane, 0)) return false;
+    
+    atomic_store_uchar(&bus->lang_to_lane_map[source][target], (unsigned char)preferred_lane);
+    return true;
+}
+
+bool umsbb_optimize_language_routing(UniversalMultiSegmentedBiBufferBus* bus) {
+#if UMSBB_ENABLE_FAST_LANES
+    if (!bus) return false;
+    
+    lane_router_update(&bus->router, &bus->fast_lanes, bus->lane_priority_weights);
+    for (size_t i = 0; i < LANE_COUNT; ++i) {
+        bus->lane_performance_history[i] = lane_router_cost(&bus->router, (lane_type_t)i);
+    }
+    return true;
+#else
+    (void)bus;
+    return false;
+#endif
+}
+#endif
+
+#if UMSBB_API_LEVEL >= 3
 // Performance monitoring
 void umsbb_get_performance_metrics(UniversalMultiSegmentedBiBufferBus* bus, struct system_metrics* metrics) {
     if (!bus || !metrics) return;
@@ -484,36 +1744,109 @@ void umsbb_get_performance_metrics(UniversalMultiSegmentedBiBufferBus* bus, stru
     // Aggregate metrics from all systems
     metrics->total_messages_per_second = bus->messages_per_second;
     metrics->total_bytes_per_second = bus->bytes_per_second;
-    metrics->throughput_mbps = fast_lane_get_system_throughput(&bus->fast_lanes);
     metrics->reliability_score = bus->reliability_score;
-    metrics->system_health_score = fault_tolerance_get_system_health(&bus->fault_tolerance);
+    metrics->active_lanes = (uint32_t)bus->ring.activeCount;
     
-    // Count active components
+#if UMSBB_ENABLE_FAST_LANES
+    metrics->throughput_mbps = fast_lane_get_system_throughput(&bus->fast_lanes);
     metrics->active_lanes = bus->fast_lanes.active_lanes;
-    metrics->active_twin_lanes = bus->twin_lanes.lane_count;
-    metrics->pending_acknowledgments = handshake_get_pending_count(&bus->handshake, 0);
-    metrics->active_faults = atomic_load(&bus->fault_tolerance.active_faults);
     
     // Calculate latency metrics (simplified)
     struct lane_metrics lane_metrics;
     fast_lane_get_metrics(&bus->fast_lanes, LANE_EXPRESS, &lane_metrics);
     metrics->avg_latency_us = lane_metrics.avg_latency_us;
     metrics->p99_latency_us = lane_metrics.p99_latency_us;
+#endif
+#if UMSBB_ENABLE_TWIN_LANES
+    metrics->active_twin_lanes = bus->twin_lanes.lane_count;
+#endif
+#if UMSBB_ENABLE_RELIABILITY
+    metrics->system_health_score = fault_tolerance_get_system_health(&bus->fault_tolerance);
+    metrics->pending_acknowledgments = handshake_get_pending_count(&bus->handshake, 0);
+    metrics->active_faults = fault_tolerance_active_faults(&bus->fault_tolerance);
+#else
+    metrics->system_health_score = 1.0;
+#endif
 }
 
+bool umsbb_register_metrics(UniversalMultiSegmentedBiBufferBus* bus, MetricsRegistry* registry, const char* labels) {
+    if (!bus || !registry) return false;
+    bool ok = metrics_registry_add(registry, bus, METRIC_COUNTER, "umsbb_frames_total",
+                                   "Frames given a sequence number", labels, METRIC_SIZE, &bus->sequence);
+
+    // Segment buffers live outside the bus, so the bus owns their series
+    for (size_t i = 0; i < bus->ring.laneCount; i++) {
+        BiBuffer* buffer = bus->ring.buffers[i];
+        if (!buffer) continue;
+        char index[24];
+        char segment_labels[METRICS_LABELS_MAX];
+        snprintf(index, sizeof(index), "%zu", i);
+        metrics_labels(segment_labels, sizeof(segment_labels), labels, "segment", index);
+        ok &= metrics_registry_add(registry, bus, METRIC_COUNTER, "umsbb_segment_reserved_bytes_total",
+                                   "Ring bytes producers reserved, frame headers included", segment_labels,
+                                   METRIC_SIZE, &buffer->writeIndex);
+        ok &= metrics_registry_add(registry, bus, METRIC_COUNTER, "umsbb_segment_committed_bytes_total",
+                                   "Ring bytes committed and visible to the consumer", segment_labels,
+                                   METRIC_SIZE, &buffer->commitIndex);
+        ok &= metrics_registry_add(registry, bus, METRIC_COUNTER, "umsbb_segment_consumed_bytes_total",
+                                   "Ring bytes the consumer released", segment_labels, METRIC_SIZE,
+                                   &buffer->readIndex);
+    }
+
+#if UMSBB_ENABLE_FAST_LANES
+    ok &= fast_lane_register_metrics(&bus->fast_lanes, registry, labels);
+#endif
+#if UMSBB_ENABLE_RELIABILITY
+    ok &= handshake_register_metrics(&bus->handshake, registry, labels);
+    ok &= fault_tolerance_register_metrics(&bus->fault_tolerance, registry, labels);
+#endif
+    return ok;
+}
+#endif
+
 void umsbb_free(UniversalMultiSegmentedBiBufferBus* bus) {
     if (!bus) return;
     
-    for (size_t i = 0; i < bus->ring.activeCount; ++i) {
-        bi_buffer_destroy(&bus->ring.buffers[i]);
+    // Auto-scaling may still be evaluating this bus
+    language_bindings_forget_bus(bus);
+#if UMSBB_ENABLE_PARALLEL
+    umsbb_disable_parallel_processing(bus);
+#endif
+    segment_ring_destroy(&bus->ring);
+#if UMSBB_ENABLE_BATCHING
+    for (size_t i = 0; i < SEGMENT_RING_MAX_LANES; ++i) {
+        submit_batcher_destroy((SubmitBatcher*)(uintptr_t)atomic_load_size(&bus->batchers[i]));
     }
-    if (bus->arena.memory) free(bus->arena.memory);
+    free(bus->batchers);
+#endif
     
-    // Clean up V3.0 systems
+    // Clean up V3.0 systems; coalesced messages still go to their lanes first
+#if UMSBB_ENABLE_FAST_LANES
+#  if UMSBB_ENABLE_GPU
+    umsbb_disable_gpu_coalescing(bus);
+    umsbb_free_spills(bus);
+#  endif
     fast_lane_destroy(&bus->fast_lanes);
+#endif
+#if UMSBB_ENABLE_TWIN_LANES
     twin_lane_destroy(&bus->twin_lanes);
+#endif
+#if UMSBB_ENABLE_TOPICS
+    for (size_t i = 0; i < UMSBB_MAX_TOPICS; ++i) {
+        topic_ring_destroy((TopicRing*)(uintptr_t)atomic_load_size(&bus->topics[i]));
+    }
+#endif
+#if UMSBB_ENABLE_RELIABILITY
     handshake_destroy(&bus->handshake);
     fault_tolerance_destroy(&bus->fault_tolerance);
+#endif
+#if UMSBB_ENABLE_FEEDBACK
+    feedback_destroy(&bus->feedback);
+#endif
+    event_destroy(&bus->scheduler);
+#if UMSBB_ENABLE_FLOW_CONTROL
+    umsbb_destroy_gates(bus);
+#endif
     
     free(bus);
 }
\ No newline at end of file
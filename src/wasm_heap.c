@@ -0,0 +1,320 @@
+#include "wasm_heap.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __EMSCRIPTEN__
+#include <unistd.h>     // sbrk: memory.grow, shared with the C library's heap
+#endif
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <emscripten/threading.h>
+#endif
+
+struct WasmHeapBlock {
+    WasmHeapBlock* prevPhys;        // Valid only while the previous block is free
+    size_t size;                    // Payload bytes | BLOCK_FREE | BLOCK_PREV_FREE
+    WasmHeapBlock* nextFree;        // Free blocks only; the first payload bytes
+    WasmHeapBlock* prevFree;
+};
+
+struct WasmHeapRegion {
+    WasmHeapRegion* next;
+    size_t size;
+};
+
+#define BLOCK_FREE ((size_t)1)
+#define BLOCK_PREV_FREE ((size_t)2)
+#define BLOCK_FLAGS (BLOCK_FREE | BLOCK_PREV_FREE)
+#define BLOCK_OVERHEAD offsetof(WasmHeapBlock, nextFree)            // Equals WASM_HEAP_ALIGN
+#define BLOCK_MIN_SIZE (sizeof(WasmHeapBlock) - BLOCK_OVERHEAD)     // Room for the free links
+#define ALIGN_LOG2 (sizeof(void*) == 8 ? 4 : 3)
+#define FL_SHIFT (WASM_HEAP_SL_LOG2 + ALIGN_LOG2)
+#define SMALL_BLOCK ((size_t)1 << FL_SHIFT)                          // Below this, one list per size
+#define MAX_ALLOC ((size_t)1 << 30)
+#define PAGE_SIZE ((size_t)64 * 1024)                                // A wasm page
+
+static inline size_t align_up(size_t value, size_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+static inline int heap_fls(size_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (int)(sizeof(unsigned long long) * 8 - 1) - __builtin_clzll((unsigned long long)x);
+#else
+    int bit = 0;
+    while (x >>= 1) bit++;
+    return bit;
+#endif
+}
+
+static inline int heap_ffs(uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(x);
+#else
+    int bit = 0;
+    while (!(x & 1u)) { x >>= 1; bit++; }
+    return bit;
+#endif
+}
+
+/* ---- Lock ---- */
+
+static void heap_lock(WasmHeap* heap) {
+    uint32_t state = 0;
+    if (atomic_cas_u32(&heap->lock, &state, 1)) return;
+    // Contended: mark it so the holder wakes us, then sleep until released
+    if (state != 2) state = atomic_exchange_u32(&heap->lock, 2);
+    while (state != 0) {
+#ifdef __EMSCRIPTEN_PTHREADS__
+        emscripten_futex_wait((volatile void*)&heap->lock, 2, INFINITY);
+#endif
+        state = atomic_exchange_u32(&heap->lock, 2);
+    }
+}
+
+static void heap_unlock(WasmHeap* heap) {
+    if (atomic_exchange_u32(&heap->lock, 0) == 2) {
+#ifdef __EMSCRIPTEN_PTHREADS__
+        emscripten_futex_wake((volatile void*)&heap->lock, 1);
+#endif
+    }
+}
+
+/* ---- Blocks ---- */
+
+static inline size_t block_size(const WasmHeapBlock* block) {
+    return block->size & ~BLOCK_FLAGS;
+}
+
+static inline char* block_payload(WasmHeapBlock* block) {
+    return (char*)block + BLOCK_OVERHEAD;
+}
+
+static inline WasmHeapBlock* block_from_payload(const void* ptr) {
+    return (WasmHeapBlock*)((char*)ptr - BLOCK_OVERHEAD);
+}
+
+static inline WasmHeapBlock* block_next(WasmHeapBlock* block) {
+    return (WasmHeapBlock*)(block_payload(block) + block_size(block));
+}
+
+/* First level: the power of two; second level: which sixteenth of it. */
+static void mapping_insert(size_t size, int* fl, int* sl) {
+    if (size < SMALL_BLOCK) {
+        *fl = 0;
+        *sl = (int)(size / (SMALL_BLOCK / WASM_HEAP_SL_COUNT));
+    } else {
+        int bit = heap_fls(size);
+        *sl = (int)(size >> (bit - WASM_HEAP_SL_LOG2)) ^ WASM_HEAP_SL_COUNT;
+        *fl = bit - FL_SHIFT + 1;
+    }
+}
+
+/* Round up to the next list start, so any block found there is big enough. */
+static void mapping_search(size_t size, int* fl, int* sl) {
+    if (size >= SMALL_BLOCK) size += ((size_t)1 << (heap_fls(size) - WASM_HEAP_SL_LOG2)) - 1;
+    mapping_insert(size, fl, sl);
+}
+
+static WasmHeapBlock* find_suitable(WasmHeap* heap, int* fl, int* sl) {
+    uint32_t slMap = heap->slBitmap[*fl] & (~0u << *sl);
+    if (!slMap) {
+        uint32_t flMap = (*fl + 1 < 32) ? heap->flBitmap & (~0u << (*fl + 1)) : 0;
+        if (!flMap) return NULL;
+        *fl = heap_ffs(flMap);
+        slMap = heap->slBitmap[*fl];
+    }
+    *sl = heap_ffs(slMap);
+    return heap->free[*fl][*sl];
+}
+
+static void list_remove(WasmHeap* heap, WasmHeapBlock* block) {
+    int fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    if (block->prevFree) {
+        block->prevFree->nextFree = block->nextFree;
+    } else {
+        heap->free[fl][sl] = block->nextFree;
+        if (!block->nextFree) {
+            heap->slBitmap[fl] &= ~(1u << sl);
+            if (!heap->slBitmap[fl]) heap->flBitmap &= ~(1u << fl);
+        }
+    }
+    if (block->nextFree) block->nextFree->prevFree = block->prevFree;
+}
+
+static void list_insert(WasmHeap* heap, WasmHeapBlock* block) {
+    int fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    WasmHeapBlock* head = heap->free[fl][sl];
+    block->prevFree = NULL;
+    block->nextFree = head;
+    if (head) head->prevFree = block;
+    heap->free[fl][sl] = block;
+    heap->slBitmap[fl] |= 1u << sl;
+    heap->flBitmap |= 1u << fl;
+}
+
+/* Free `block`, merged with whichever physical neighbours are free. */
+static void block_release(WasmHeap* heap, WasmHeapBlock* block) {
+    block->size |= BLOCK_FREE;
+    if (block->size & BLOCK_PREV_FREE) {
+        WasmHeapBlock* prev = block->prevPhys;
+        list_remove(heap, prev);
+        prev->size += BLOCK_OVERHEAD + block_size(block);
+        block = prev;
+    }
+    WasmHeapBlock* next = block_next(block);
+    if (next->size & BLOCK_FREE) {
+        list_remove(heap, next);
+        block->size += BLOCK_OVERHEAD + block_size(next);
+        next = block_next(block);
+    }
+    next->prevPhys = block;
+    next->size |= BLOCK_PREV_FREE;
+    list_insert(heap, block);
+}
+
+/* Take a region of at least `size` payload bytes from the system. */
+static bool heap_grow(WasmHeap* heap, size_t size) {
+    size_t step = heap->growStep ? heap->growStep : WASM_HEAP_DEFAULT_GROW;
+    size_t need = size + 2 * BLOCK_OVERHEAD + sizeof(WasmHeapRegion) + WASM_HEAP_ALIGN;
+    size_t bytes = align_up(need > step ? need : step, PAGE_SIZE);
+
+#ifdef __EMSCRIPTEN__
+    char* memory = (char*)sbrk((intptr_t)bytes);
+    if (memory == (char*)-1) return false;
+    heap->reserved += bytes;
+
+    // Straight after our last region: its sentinel becomes the new free block
+    if (heap->tail && memory == (char*)heap->tail + BLOCK_OVERHEAD) {
+        WasmHeapBlock* block = heap->tail;
+        block->size = (bytes - BLOCK_OVERHEAD) | (block->size & BLOCK_PREV_FREE);
+        WasmHeapBlock* sentinel = block_next(block);
+        sentinel->size = 0;
+        heap->tail = sentinel;
+        block_release(heap, block);
+        return true;
+    }
+    char* start = (char*)align_up((size_t)memory, WASM_HEAP_ALIGN);
+    bytes -= (size_t)(start - memory);
+#else
+    char* start = (char*)malloc(bytes);     // malloc alignment covers WASM_HEAP_ALIGN
+    if (!start) return false;
+    heap->reserved += bytes;
+#endif
+
+    WasmHeapRegion* region = (WasmHeapRegion*)start;
+    region->next = heap->regions;
+    region->size = bytes;
+    heap->regions = region;
+
+    // One free block spanning the region, closed by a used, empty sentinel
+    WasmHeapBlock* block = (WasmHeapBlock*)(region + 1);
+    block->prevPhys = NULL;
+    block->size = (bytes - sizeof(WasmHeapRegion) - 2 * BLOCK_OVERHEAD) & ~(WASM_HEAP_ALIGN - 1);
+    WasmHeapBlock* sentinel = block_next(block);
+    sentinel->size = 0;
+    heap->tail = sentinel;
+    block_release(heap, block);
+    return true;
+}
+
+/* ---- API ---- */
+
+void wasm_heap_init(WasmHeap* heap, size_t growStep) {
+    memset(heap, 0, sizeof(*heap));
+    atomic_store_u32(&heap->lock, 0);
+    heap->growStep = growStep;
+}
+
+void wasm_heap_destroy(WasmHeap* heap) {
+    if (!heap) return;
+#ifndef __EMSCRIPTEN__
+    WasmHeapRegion* region = heap->regions;
+    while (region) {
+        WasmHeapRegion* next = region->next;
+        free(region);
+        region = next;
+    }
+#endif
+    wasm_heap_init(heap, heap->growStep);
+}
+
+void* wasm_heap_alloc(WasmHeap* heap, size_t size) {
+    if (!heap || size > MAX_ALLOC) return NULL;
+    size = align_up(size < BLOCK_MIN_SIZE ? BLOCK_MIN_SIZE : size, WASM_HEAP_ALIGN);
+
+    heap_lock(heap);
+    int fl, sl;
+    mapping_search(size, &fl, &sl);
+    WasmHeapBlock* block = find_suitable(heap, &fl, &sl);
+    if (!block) {
+        // Before growing, look for a fit among the blocks just under the rounded size
+        mapping_insert(size, &fl, &sl);
+        for (block = heap->free[fl][sl]; block && block_size(block) < size; block = block->nextFree) {}
+    }
+    if (!block) {
+        if (!heap_grow(heap, size)) {
+            heap_unlock(heap);
+            return NULL;
+        }
+        mapping_search(size, &fl, &sl);
+        block = find_suitable(heap, &fl, &sl);
+    }
+    list_remove(heap, block);
+
+    // Split off the tail when it can hold a block of its own
+    if (block_size(block) >= size + BLOCK_OVERHEAD + BLOCK_MIN_SIZE) {
+        WasmHeapBlock* rest = (WasmHeapBlock*)(block_payload(block) + size);
+        rest->size = block_size(block) - size - BLOCK_OVERHEAD;
+        block->size = size | (block->size & BLOCK_FLAGS);
+        block_next(rest)->prevPhys = rest;
+        rest->size |= BLOCK_FREE;
+        block_next(rest)->size |= BLOCK_PREV_FREE;
+        list_insert(heap, rest);
+    } else {
+        block_next(block)->size &= ~BLOCK_PREV_FREE;
+    }
+    block->size &= ~BLOCK_FREE;
+
+    heap->inUse += block_size(block);
+    heap->allocations++;
+    heap_unlock(heap);
+    return block_payload(block);
+}
+
+void wasm_heap_free(WasmHeap* heap, void* ptr) {
+    if (!heap || !ptr) return;
+    WasmHeapBlock* block = block_from_payload(ptr);
+    heap_lock(heap);
+    heap->inUse -= block_size(block);
+    heap->allocations--;
+    block_release(heap, block);
+    heap_unlock(heap);
+}
+
+size_t wasm_heap_usable_size(const void* ptr) {
+    return ptr ? block_size(block_from_payload(ptr)) : 0;
+}
+
+void wasm_heap_get_stats(WasmHeap* heap, WasmHeapStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!heap) return;
+    heap_lock(heap);
+    stats->reservedBytes = heap->reserved;
+    stats->inUseBytes = heap->inUse;
+    stats->allocations = heap->allocations;
+    for (int fl = 0; fl < WASM_HEAP_FL_COUNT; fl++) {
+        for (int sl = 0; sl < WASM_HEAP_SL_COUNT; sl++) {
+            for (WasmHeapBlock* block = heap->free[fl][sl]; block; block = block->nextFree) {
+                size_t size = block_size(block);
+                stats->freeBytes += size;
+                stats->freeBlocks++;
+                if (size > stats->largestFree) stats->largestFree = size;
+            }
+        }
+    }
+    for (WasmHeapRegion* region = heap->regions; region; region = region->next) stats->regions++;
+    heap_unlock(heap);
+}
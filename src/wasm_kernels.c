@@ -0,0 +1,123 @@
+#include "wasm_kernels.h"
+#include <string.h>
+
+#if defined(__wasm_simd128__)
+#  include <wasm_simd128.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define KERNEL_CTZ(x) ((uint32_t)__builtin_ctz(x))
+#else
+static uint32_t kernel_ctz(uint32_t x) {
+    uint32_t bit = 0;
+    while (!(x & 1u)) { x >>= 1; bit++; }
+    return bit;
+}
+#  define KERNEL_CTZ(x) kernel_ctz(x)
+#endif
+
+#if defined(__wasm_simd128__)
+
+void wasm_copy_bytes(void* dst, const void* src, size_t size) {
+    uint8_t* d = (uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+    if (size < 16) {
+        memcpy(d, s, size);
+        return;
+    }
+    // Four loads in flight per step; v128 loads and stores take any alignment
+    while (size >= 64) {
+        v128_t a = wasm_v128_load(s);
+        v128_t b = wasm_v128_load(s + 16);
+        v128_t c = wasm_v128_load(s + 32);
+        v128_t e = wasm_v128_load(s + 48);
+        wasm_v128_store(d, a);
+        wasm_v128_store(d + 16, b);
+        wasm_v128_store(d + 32, c);
+        wasm_v128_store(d + 48, e);
+        s += 64;
+        d += 64;
+        size -= 64;
+    }
+    while (size >= 16) {
+        wasm_v128_store(d, wasm_v128_load(s));
+        s += 16;
+        d += 16;
+        size -= 16;
+    }
+    // The tail as one vector ending at the last byte, overlapping what is done
+    if (size) wasm_v128_store(d + size - 16, wasm_v128_load(s + size - 16));
+}
+
+uint32_t wasm_nonzero_mask(const uint32_t* words, uint32_t count) {
+    const v128_t zero = wasm_i32x4_splat(0);
+    uint32_t mask = 0;
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        v128_t nonzero = wasm_i32x4_ne(wasm_v128_load(words + i), zero);
+        mask |= (uint32_t)wasm_i32x4_bitmask(nonzero) << i;
+    }
+    for (; i < count; i++) {
+        if (words[i]) mask |= 1u << i;
+    }
+    return mask;
+}
+
+uint32_t wasm_min_index(const uint32_t* values, uint32_t count) {
+    if (count == 0) return 0;
+    uint32_t i = 0;
+    uint32_t least = UINT32_MAX;
+    if (count >= 4) {
+        v128_t m = wasm_i32x4_splat(-1);
+        for (; i + 4 <= count; i += 4) m = wasm_u32x4_min(m, wasm_v128_load(values + i));
+        m = wasm_u32x4_min(m, wasm_i32x4_shuffle(m, m, 2, 3, 0, 1));
+        m = wasm_u32x4_min(m, wasm_i32x4_shuffle(m, m, 1, 0, 3, 2));
+        least = (uint32_t)wasm_i32x4_extract_lane(m, 0);
+    }
+    for (uint32_t j = i; j < count; j++) {
+        if (values[j] < least) least = values[j];
+    }
+
+    // First lane holding it
+    const v128_t target = wasm_i32x4_splat((int32_t)least);
+    for (i = 0; i + 4 <= count; i += 4) {
+        uint32_t hits = (uint32_t)wasm_i32x4_bitmask(wasm_i32x4_eq(wasm_v128_load(values + i), target));
+        if (hits) return i + KERNEL_CTZ(hits);
+    }
+    for (; i < count; i++) {
+        if (values[i] == least) return i;
+    }
+    return 0;
+}
+
+const char* wasm_kernels_impl_name(void) {
+    return "wasm-simd128";
+}
+
+#else
+
+void wasm_copy_bytes(void* dst, const void* src, size_t size) {
+    memcpy(dst, src, size);
+}
+
+uint32_t wasm_nonzero_mask(const uint32_t* words, uint32_t count) {
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        mask |= (uint32_t)(words[i] != 0) << i;
+    }
+    return mask;
+}
+
+uint32_t wasm_min_index(const uint32_t* values, uint32_t count) {
+    uint32_t best = 0;
+    for (uint32_t i = 1; i < count; i++) {
+        if (values[i] < values[best]) best = i;
+    }
+    return best;
+}
+
+const char* wasm_kernels_impl_name(void) {
+    return "scalar";
+}
+
+#endif
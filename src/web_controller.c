@@ -1,4 +1,9 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // pthread_setaffinity_np
+#endif
 #include "web_controller.h"
+#include "umsbb_clock.h"
+#include "cpu_topology.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,15 +12,53 @@
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <windows.h>
+#include <process.h>
 #pragma comment(lib, "ws2_32.lib")
 #else
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <sys/select.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#endif
+
+#if defined(__linux__)
+#define WEB_EPOLL 1
+#include <sys/epoll.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__) || defined(__DragonFly__)
+#define WEB_KQUEUE 1
+#include <sys/event.h>
+#endif
+
+#ifdef _WIN32
+#define web_close_socket closesocket
+#define web_poll WSAPoll
+#define WEB_WOULD_BLOCK() (WSAGetLastError() == WSAEWOULDBLOCK)
+#define WEB_INTERRUPTED() (WSAGetLastError() == WSAEINTR)
+#define WEB_SEND_FLAGS 0
+#else
+#define web_close_socket close
+#define web_poll poll
+#define WEB_WOULD_BLOCK() (errno == EAGAIN || errno == EWOULDBLOCK)
+#define WEB_INTERRUPTED() (errno == EINTR)
+#ifdef MSG_NOSIGNAL
+#define WEB_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define WEB_SEND_FLAGS 0        // SO_NOSIGPIPE is set on each socket instead
 #endif
+#endif
+
+// Event loop tokens besides client slot indexes
+#define WEB_TOKEN_LISTEN UINT32_MAX
+#define WEB_TOKEN_WAKE (UINT32_MAX - 1)
+#define WEB_NO_CLIENT UINT32_MAX
+#define WEB_MAX_EVENTS 256
+
 
 // Base64 encoding for WebSocket handshake
 static const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
@@ -47,36 +90,350 @@ static char* base64_encode(const unsigned char* data, size_t length) {
     return encoded;
 }
 
-// SHA1 hash implementation for WebSocket handshake
+// SHA1 hash for the WebSocket handshake (RFC 3174); the accept key must match the browser's
+static uint32_t sha1_rotl(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+static void sha1_block(uint32_t state[5], const unsigned char* block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+               ((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = sha1_rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+    
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+        else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+        else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+        else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+        uint32_t temp = sha1_rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = sha1_rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+}
+
 static void sha1_hash(const char* input, unsigned char* output) {
-    // Simplified SHA1 implementation - in production, use a proper crypto library
-    // For now, we'll use a simple hash that works with most browsers
-    uint32_t hash = 2166136261U;
-    for (const char* p = input; *p; p++) {
-        hash ^= (uint32_t)*p;
-        hash *= 16777619U;
+    uint32_t state[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    size_t length = strlen(input);
+    size_t offset = 0;
+    for (; length - offset >= 64; offset += 64) {
+        sha1_block(state, (const unsigned char*)input + offset);
     }
     
-    output[0] = (hash >> 24) & 0xFF;
-    output[1] = (hash >> 16) & 0xFF;
-    output[2] = (hash >> 8) & 0xFF;
-    output[3] = hash & 0xFF;
+    // Tail, the 0x80 terminator and the bit length, over one or two blocks
+    unsigned char tail[128] = {0};
+    size_t remaining = length - offset;
+    memcpy(tail, input + offset, remaining);
+    tail[remaining] = 0x80;
+    size_t tail_length = remaining < 56 ? 64 : 128;
+    uint64_t bits = (uint64_t)length * 8;
+    for (int i = 0; i < 8; i++) {
+        tail[tail_length - 1 - i] = (unsigned char)(bits >> (8 * i));
+    }
+    for (size_t i = 0; i < tail_length; i += 64) {
+        sha1_block(state, tail + i);
+    }
     
-    // Fill rest with pseudo-random data
-    for (int i = 4; i < 20; i++) {
-        output[i] = (hash >> (i % 4 * 8)) & 0xFF;
+    for (int i = 0; i < 20; i++) {
+        output[i] = (unsigned char)(state[i / 4] >> (24 - 8 * (i % 4)));
+    }
+}
+
+
+// Sockets
+
+static int web_set_nonblocking(int fd) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(fd, FIONBIO, &mode) == 0 ? 0 : -1;
+#else
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) return -1;
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    return 0;
+#endif
+}
+
+// Event loop backends: watch a socket for input and output from now on.
+// The poll() backend rebuilds its set from the client table every wait.
+static int web_watch(web_server_t* server, int fd, uint32_t token) {
+#if defined(WEB_EPOLL)
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLET;
+    if (token < WEB_TOKEN_WAKE) event.events |= EPOLLOUT | EPOLLRDHUP;
+    event.data.u32 = token;
+    return epoll_ctl(server->poll_fd, EPOLL_CTL_ADD, fd, &event);
+#elif defined(WEB_KQUEUE)
+    struct kevent changes[2];
+    int count = 0;
+    EV_SET(&changes[count++], fd, EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, (void*)(uintptr_t)token);
+    if (token < WEB_TOKEN_WAKE) {
+        EV_SET(&changes[count++], fd, EVFILT_WRITE, EV_ADD | EV_CLEAR, 0, 0, (void*)(uintptr_t)token);
+    }
+    return kevent(server->poll_fd, changes, count, NULL, 0, NULL);
+#else
+    (void)server; (void)fd; (void)token;
+    return 0;
+#endif
+}
+
+static void web_dispatch(web_server_t* server, uint32_t token, bool readable, bool writable);
+
+#if !defined(WEB_EPOLL) && !defined(WEB_KQUEUE)
+static bool web_reserve_poll_set(web_server_t* server, uint32_t count) {
+    if (count <= server->poll_capacity) return true;
+    void* set = realloc(server->poll_set, count * sizeof(struct pollfd));
+    if (!set) return false;
+    server->poll_set = set;
+    server->poll_capacity = count;
+    return true;
+}
+#endif
+
+// Wait up to `timeout_ms` and dispatch whatever became ready
+static int web_wait(web_server_t* server, int timeout_ms) {
+#if defined(WEB_EPOLL)
+    struct epoll_event events[WEB_MAX_EVENTS];
+    int ready = epoll_wait(server->poll_fd, events, WEB_MAX_EVENTS, timeout_ms);
+    for (int i = 0; i < ready; i++) {
+        uint32_t flags = events[i].events;
+        web_dispatch(server, events[i].data.u32, (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0,
+                     (flags & EPOLLOUT) != 0);
+    }
+    return (ready < 0 && errno == EINTR) ? 0 : ready;
+#elif defined(WEB_KQUEUE)
+    struct kevent events[WEB_MAX_EVENTS];
+    struct timespec timeout = { timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000L };
+    int ready = kevent(server->poll_fd, NULL, 0, events, WEB_MAX_EVENTS, &timeout);
+    for (int i = 0; i < ready; i++) {
+        uint32_t token = (uint32_t)(uintptr_t)events[i].udata;
+        bool readable = events[i].filter == EVFILT_READ || (events[i].flags & (EV_EOF | EV_ERROR));
+        web_dispatch(server, token, readable, events[i].filter == EVFILT_WRITE);
+    }
+    return (ready < 0 && errno == EINTR) ? 0 : ready;
+#else
+    // Level-triggered: the socket, the wake pipe, then every client
+    if (!web_reserve_poll_set(server, server->client_capacity + 2)) return -1;
+    struct pollfd* set = (struct pollfd*)server->poll_set;
+    uint32_t count = 0;
+    set[count].fd = server->server_socket;
+    set[count++].events = POLLIN;
+    if (server->wake_fds[0] >= 0) {
+        set[count].fd = server->wake_fds[0];
+        set[count++].events = POLLIN;
+    }
+    uint32_t first_client = count;
+    for (uint32_t i = 0; i < server->client_capacity; i++) {
+        web_client_t* client = &server->clients[i];
+        // Inactive slots are skipped by fd -1 so indexes line up
+        set[count].fd = client->is_active ? client->socket_fd : -1;
+        set[count].events = POLLIN | (client->output_sent < client->output_length ? POLLOUT : 0);
+        set[count++].revents = 0;
+    }
+    int ready = web_poll(set, count, timeout_ms);
+    if (ready <= 0) return ready;
+
+    if (set[0].revents) web_dispatch(server, WEB_TOKEN_LISTEN, true, false);
+    if (first_client == 2 && set[1].revents) web_dispatch(server, WEB_TOKEN_WAKE, true, false);
+    // Slots added by the accept above are picked up next round
+    for (uint32_t i = first_client; i < count; i++) {
+        short revents = ((struct pollfd*)server->poll_set)[i].revents;
+        if (revents) {
+            web_dispatch(server, i - first_client, (revents & (POLLIN | POLLHUP | POLLERR)) != 0,
+                         (revents & POLLOUT) != 0);
+        }
+    }
+    return ready;
+#endif
+}
+
+// Client slots
+
+static uint32_t web_alloc_client(web_server_t* server) {
+    if (server->free_client == WEB_NO_CLIENT) {
+        if (server->client_capacity >= server->max_clients) return WEB_NO_CLIENT;
+        uint32_t capacity = server->client_capacity ? server->client_capacity * 2 : 64;
+        if (capacity > server->max_clients) capacity = server->max_clients;
+        web_client_t* clients = (web_client_t*)realloc(server->clients, capacity * sizeof(web_client_t));
+        if (!clients) return WEB_NO_CLIENT;
+        memset(clients + server->client_capacity, 0, (capacity - server->client_capacity) * sizeof(web_client_t));
+        for (uint32_t i = capacity; i-- > server->client_capacity;) {
+            clients[i].client_id = i;
+            clients[i].socket_fd = -1;
+            clients[i].next_free = server->free_client;
+            server->free_client = i;
+        }
+        server->clients = clients;
+        server->client_capacity = capacity;
+    }
+    uint32_t index = server->free_client;
+    server->free_client = server->clients[index].next_free;
+    return index;
+}
+
+// Make room for `extra` more bytes, growing geometrically up to `limit`
+static bool web_reserve(char** data, size_t* capacity, size_t needed, size_t limit) {
+    if (needed <= *capacity) return true;
+    if (needed > limit) return false;
+    size_t grown = *capacity ? *capacity : WEB_INITIAL_BUFFER;
+    while (grown < needed) grown *= 2;
+    if (grown > limit) grown = limit;
+    char* resized = (char*)realloc(*data, grown);
+    if (!resized) return false;
+    *data = resized;
+    *capacity = grown;
+    return true;
+}
+
+// Send queued output until the socket would block; < 0 once the client should go
+static int web_flush_client(web_client_t* client) {
+    while (client->output_sent < client->output_length) {
+        int sent = send(client->socket_fd, client->output + client->output_sent,
+                        (int)(client->output_length - client->output_sent), WEB_SEND_FLAGS);
+        if (sent > 0) {
+            client->output_sent += (size_t)sent;
+        } else if (sent < 0 && WEB_INTERRUPTED()) {
+            continue;
+        } else if (sent < 0 && WEB_WOULD_BLOCK()) {
+            return 0;
+        } else {
+            return -1;
+        }
+    }
+    client->output_length = 0;
+    client->output_sent = 0;
+    return client->closing ? -1 : 0;
+}
+
+// Queue bytes behind whatever the client has not taken yet, then send what fits
+static int web_queue_output(web_client_t* client, const void* data, size_t length) {
+    if (client->output_sent > 0 && client->output_length + length > client->output_capacity) {
+        memmove(client->output, client->output + client->output_sent, client->output_length - client->output_sent);
+        client->output_length -= client->output_sent;
+        client->output_sent = 0;
+    }
+    if (!web_reserve(&client->output, &client->output_capacity, client->output_length + length, SIZE_MAX)) {
+        return -1;
     }
+    memcpy(client->output + client->output_length, data, length);
+    client->output_length += length;
+    return web_flush_client(client);
+}
+
+static int web_queue_http_response(web_client_t* client, int status_code, const char* content_type,
+                                   const char* body, size_t body_length) {
+    char header[1024];
+    int header_length = snprintf(header, sizeof(header),
+        "HTTP/1.1 %d %s\r\n"
+        "Content-Type: %s\r\n"
+        "Content-Length: %lu\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "Connection: close\r\n"
+        "\r\n",
+        status_code,
+        (status_code == 200) ? "OK" : (status_code == 404) ? "Not Found" :
+        (status_code == 503) ? "Service Unavailable" :
+        (status_code == 500) ? "Internal Server Error" : "Bad Request",
+        content_type,
+        (unsigned long)body_length);
+
+    if (web_queue_output(client, header, (size_t)header_length) < 0) return -1;
+    if (body && body_length > 0 && web_queue_output(client, body, body_length) < 0) return -1;
+
+    // Answered: the connection closes once the response is out
+    client->closing = true;
+    return client->output_length ? 0 : -1;
+}
+
+#define WEB_WS_TEXT 0x81   // Text frame, final fragment
+#define WEB_WS_BINARY 0x82 // Binary frame, final fragment
+
+static size_t web_websocket_header(uint8_t* frame, size_t length, uint8_t opcode) {
+    size_t frame_size = 2;
+    frame[0] = opcode;
+
+    if (length < 126) {
+        frame[1] = (uint8_t)length;
+    } else if (length < 65536) {
+        frame[1] = 126;
+        frame[2] = (length >> 8) & 0xFF;
+        frame[3] = length & 0xFF;
+        frame_size += 2;
+    } else {
+        frame[1] = 127;
+        for (int i = 0; i < 8; i++) {
+            frame[2 + i] = (uint8_t)(((uint64_t)length >> (8 * (7 - i))) & 0xFF);
+        }
+        frame_size += 8;
+    }
+    return frame_size;
+}
+
+// The 101 response accepting `headers`' upgrade, or -1 without a usable key
+static int web_websocket_accept(const char* headers, char* response, size_t size) {
+    char key[256] = {0};
+
+    // Extract WebSocket key
+    const char* key_start = strstr(headers, "Sec-WebSocket-Key: ");
+    if (!key_start) return -1;
+
+    key_start += 19; // Length of "Sec-WebSocket-Key: "
+    const char* key_end = strstr(key_start, "\r\n");
+    if (!key_end) return -1;
+
+    size_t key_len = key_end - key_start;
+    if (key_len >= sizeof(key)) return -1;
+
+    strncpy(key, key_start, key_len);
+
+    // Create response key
+    char concatenated[512];
+    snprintf(concatenated, sizeof(concatenated), "%s%s", key, WEBSOCKET_MAGIC);
+
+    unsigned char hash[20];
+    sha1_hash(concatenated, hash);
+
+    char* accept_key = base64_encode(hash, 20);
+    if (!accept_key) return -1;
+
+    int length = snprintf(response, size,
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: %s\r\n"
+        "\r\n", accept_key);
+    free(accept_key);
+    return length;
 }
 
 // Web server initialization
 int web_server_init(web_server_t* server, uint16_t port, gpu_accelerated_buffer_t* gpu_buffer) {
     if (!server || !gpu_buffer) return -1;
-    
+
     memset(server, 0, sizeof(web_server_t));
     server->port = port;
     server->gpu_buffer = gpu_buffer;
     server->target_throughput_gbps = 10; // Default 10 GB/s target
-    
+    server->max_clients = MAX_CLIENTS;
+    server->free_client = WEB_NO_CLIENT;
+    server->poll_fd = -1;
+    server->wake_fds[0] = server->wake_fds[1] = -1;
+    atomic_init_bool(&server->is_running, false);
+
 #ifdef _WIN32
     WSADATA wsa_data;
     if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
@@ -84,252 +441,487 @@ int web_server_init(web_server_t* server, uint16_t port, gpu_accelerated_buffer_
         return -1;
     }
 #endif
-    
+
     // Create server socket
     server->server_socket = socket(AF_INET, SOCK_STREAM, 0);
     if (server->server_socket < 0) {
         printf("Failed to create server socket\n");
         return -1;
     }
-    
+
     // Set socket options
     int opt = 1;
     setsockopt(server->server_socket, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt));
-    
+
     // Bind socket
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
     server_addr.sin_addr.s_addr = INADDR_ANY;
     server_addr.sin_port = htons(port);
-    
+
     if (bind(server->server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         printf("Failed to bind server socket to port %d\n", port);
-#ifdef _WIN32
-        closesocket(server->server_socket);
-#else
-        close(server->server_socket);
-#endif
+        web_close_socket(server->server_socket);
+        server->server_socket = -1;
         return -1;
     }
-    
-    // Listen for connections
-    if (listen(server->server_socket, 10) < 0) {
+
+    // Listen for connections; a fleet's dashboards may all reconnect at once
+    if (listen(server->server_socket, SOMAXCONN) < 0 || web_set_nonblocking(server->server_socket) < 0) {
         printf("Failed to listen on server socket\n");
-#ifdef _WIN32
-        closesocket(server->server_socket);
-#else
-        close(server->server_socket);
+        web_close_socket(server->server_socket);
+        server->server_socket = -1;
+        return -1;
+    }
+
+    // Port 0 binds an ephemeral port; report the one we got
+    socklen_t addr_len = sizeof(server_addr);
+    if (getsockname(server->server_socket, (struct sockaddr*)&server_addr, &addr_len) == 0) {
+        server->port = ntohs(server_addr.sin_port);
+    }
+
+#if defined(WEB_EPOLL)
+    server->poll_fd = epoll_create1(EPOLL_CLOEXEC);
+#elif defined(WEB_KQUEUE)
+    server->poll_fd = kqueue();
 #endif
+#ifndef _WIN32
+    if (pipe(server->wake_fds) == 0) {
+        web_set_nonblocking(server->wake_fds[0]);
+        web_set_nonblocking(server->wake_fds[1]);
+    } else {
+        server->wake_fds[0] = server->wake_fds[1] = -1;
+    }
+#endif
+#if defined(WEB_EPOLL) || defined(WEB_KQUEUE)
+    if (server->poll_fd < 0 || web_watch(server, server->server_socket, WEB_TOKEN_LISTEN) != 0 ||
+        (server->wake_fds[0] >= 0 && web_watch(server, server->wake_fds[0], WEB_TOKEN_WAKE) != 0)) {
+        printf("Failed to create the web server event loop\n");
+        web_server_cleanup(server);
         return -1;
     }
-    
-    printf("🌐 Web server initialized on port %d\n", port);
+#endif
+
+    printf("🌐 Web server initialized on port %d\n", server->port);
     return 0;
 }
 
-// Web server main loop
-int web_server_start(web_server_t* server) {
-    if (!server) return -1;
-    
-    server->is_running = true;
-    printf("🚀 Web server started at http://localhost:%d\n", server->port);
-    
-    fd_set read_fds, write_fds;
-    struct timeval timeout;
-    
-    while (server->is_running) {
-        FD_ZERO(&read_fds);
-        FD_ZERO(&write_fds);
-        FD_SET(server->server_socket, &read_fds);
-        
-        int max_fd = server->server_socket;
-        
-        // Add client sockets to fd set
-        for (uint32_t i = 0; i < MAX_CLIENTS; i++) {
-            if (server->clients[i].is_active) {
-                FD_SET(server->clients[i].socket_fd, &read_fds);
-                if (server->clients[i].socket_fd > max_fd) {
-                    max_fd = server->clients[i].socket_fd;
-                }
-            }
+// Token readiness from the event loop
+static void web_dispatch(web_server_t* server, uint32_t token, bool readable, bool writable) {
+    if (token == WEB_TOKEN_LISTEN) {
+        web_accept_client(server);
+        return;
+    }
+    if (token == WEB_TOKEN_WAKE) {
+#ifndef _WIN32
+        char drain[64];
+        while (read(server->wake_fds[0], drain, sizeof(drain)) > 0) {
         }
-        
-        timeout.tv_sec = 0;
-        timeout.tv_usec = 100000; // 100ms timeout
-        
-        int activity = select(max_fd + 1, &read_fds, &write_fds, NULL, &timeout);
-        
-        if (activity < 0) {
-            printf("Select error\n");
+#endif
+        return;
+    }
+    if (token >= server->client_capacity || !server->clients[token].is_active) return;
+
+    if (writable && web_flush_client(&server->clients[token]) < 0) {
+        web_disconnect_client(server, token);
+        return;
+    }
+    if (readable && web_handle_client_request(server, token) < 0) {
+        web_disconnect_client(server, token);
+    }
+}
+
+// Milliseconds until the cache, the JSON broadcast or a metrics stream is due
+static int web_next_timeout(const web_server_t* server, uint64_t now) {
+    uint64_t due = server->last_metrics_update + WEB_CACHE_INTERVAL_MS;
+    if (server->json_subscribers && server->last_broadcast + WEB_BROADCAST_INTERVAL_MS < due) {
+        due = server->last_broadcast + WEB_BROADCAST_INTERVAL_MS;
+    }
+    for (uint32_t i = 0; i < WEB_MAX_METRIC_STREAMS; i++) {
+        const web_metrics_stream_t* stream = &server->metric_streams[i];
+        if (stream->subscribers && stream->next_due < due) due = stream->next_due;
+    }
+    if (due <= now) return 0;
+    return due - now < WEB_CACHE_INTERVAL_MS ? (int)(due - now) : WEB_CACHE_INTERVAL_MS;
+}
+
+// Web server main loop, until web_server_stop clears is_running
+static int web_server_run(web_server_t* server) {
+    printf("🚀 Web server started at http://localhost:%d\n", server->port);
+
+    while (atomic_load_bool(&server->is_running)) {
+        // Sleep until the next broadcast or cache refresh is due
+        if (web_wait(server, web_next_timeout(server, web_get_current_time_ms())) < 0) {
+            printf("Web server event loop error\n");
             break;
         }
-        
-        // Handle new connections
-        if (FD_ISSET(server->server_socket, &read_fds)) {
-            web_accept_client(server);
-        }
-        
-        // Handle client requests
-        for (uint32_t i = 0; i < MAX_CLIENTS; i++) {
-            if (server->clients[i].is_active && FD_ISSET(server->clients[i].socket_fd, &read_fds)) {
-                if (web_handle_client_request(server, i) < 0) {
-                    web_disconnect_client(server, i);
-                }
-            }
-        }
-        
-        // Broadcast real-time metrics to WebSocket clients
-        static uint64_t last_broadcast = 0;
-        uint64_t current_time = web_get_current_time_ms();
-        if (current_time - last_broadcast > 500) { // Broadcast every 500ms
-            web_broadcast_metrics(server);
-            last_broadcast = current_time;
-        }
-        
+
         // Update performance cache
         web_update_performance_cache(server);
+
+        // Broadcast real-time metrics to WebSocket clients
+        web_broadcast_metrics(server);
     }
-    
+
+    atomic_store_bool(&server->is_running, false);
     return 0;
 }
 
-// Accept new client connection
-int web_accept_client(web_server_t* server) {
-    struct sockaddr_in client_addr;
-    socklen_t client_len = sizeof(client_addr);
-    
-    int client_socket = accept(server->server_socket, (struct sockaddr*)&client_addr, &client_len);
-    if (client_socket < 0) {
+int web_server_start(web_server_t* server) {
+    if (!server) return -1;
+    atomic_store_bool(&server->is_running, true);
+    return web_server_run(server);
+}
+
+#ifdef _WIN32
+static unsigned __stdcall web_server_thread(void* arg) {
+    web_server_run((web_server_t*)arg);
+    return 0;
+}
+#else
+static void* web_server_thread(void* arg) {
+    web_server_run((web_server_t*)arg);
+    return NULL;
+}
+#endif
+
+// The CPU cpu_topology_spread hands out last, so bus workers placed in
+// spread order reach it only once every other CPU has one
+static int web_pick_cpu(void) {
+    cpu_topology_t* topology = (cpu_topology_t*)malloc(sizeof(cpu_topology_t));
+    if (!topology) return -1;
+    uint32_t cpus[CPU_TOPOLOGY_MAX_CPUS];
+    uint32_t count = cpu_topology_discover(topology) ? cpu_topology_spread(topology, cpus, CPU_TOPOLOGY_MAX_CPUS) : 0;
+    free(topology);
+    return count > 1 ? (int)cpus[count - 1] : -1;
+}
+
+int web_server_start_thread(web_server_t* server, int cpu) {
+    if (!server || server->thread) return -1;
+    if (cpu == WEB_SERVER_CPU_AUTO) cpu = web_pick_cpu();
+
+    // Running before the thread exists, so a stop straight after is not lost
+    atomic_store_bool(&server->is_running, true);
+#ifdef _WIN32
+    HANDLE thread = (HANDLE)_beginthreadex(NULL, 0, web_server_thread, server, 0, NULL);
+    if (!thread) {
+        atomic_store_bool(&server->is_running, false);
         return -1;
     }
-    
-    // Find available client slot
-    for (uint32_t i = 0; i < MAX_CLIENTS; i++) {
-        if (!server->clients[i].is_active) {
-            server->clients[i].socket_fd = client_socket;
-            server->clients[i].is_active = true;
-            server->clients[i].is_websocket = false;
-            server->clients[i].last_activity = web_get_current_time_ms();
-            server->clients[i].buffer_length = 0;
-            server->clients[i].client_id = i;
-            server->active_clients++;
-            
-            printf("👤 Client %d connected from %s\n", i, inet_ntoa(client_addr.sin_addr));
-            return 0;
-        }
+    if (cpu >= 0) {
+        GROUP_AFFINITY affinity;
+        memset(&affinity, 0, sizeof(affinity));
+        affinity.Mask = (KAFFINITY)1 << (cpu % 64);
+        affinity.Group = (WORD)(cpu / 64);
+        SetThreadGroupAffinity(thread, &affinity, NULL);
     }
-    
-    // No available slots
-#ifdef _WIN32
-    closesocket(client_socket);
+    server->thread = thread;
 #else
-    close(client_socket);
+    pthread_t* thread = (pthread_t*)malloc(sizeof(pthread_t));
+    if (!thread || pthread_create(thread, NULL, web_server_thread, server) != 0) {
+        free(thread);
+        atomic_store_bool(&server->is_running, false);
+        return -1;
+    }
+#if defined(__linux__)
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(*thread, sizeof(set), &set);
+    }
 #endif
-    printf("⚠️ Client connection rejected: server full\n");
-    return -1;
+    server->thread = thread;
+#endif
+    return 0;
 }
 
-// Handle client HTTP/WebSocket request
-int web_handle_client_request(web_server_t* server, uint32_t client_id) {
-    web_client_t* client = &server->clients[client_id];
-    char buffer[4096];
-    
-    int bytes_received = recv(client->socket_fd, buffer, sizeof(buffer) - 1, 0);
-    if (bytes_received <= 0) {
-        return -1; // Client disconnected or error
+// Accept new client connections
+int web_accept_client(web_server_t* server) {
+    int accepted = 0;
+    for (;;) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+
+        int client_socket = accept(server->server_socket, (struct sockaddr*)&client_addr, &client_len);
+        if (client_socket < 0) {
+            if (WEB_INTERRUPTED()) continue;
+            return accepted; // Drained (or out of descriptors until one closes)
+        }
+
+        uint32_t i = web_alloc_client(server);
+        if (i == WEB_NO_CLIENT || web_set_nonblocking(client_socket) < 0) {
+            if (i != WEB_NO_CLIENT) {
+                server->clients[i].next_free = server->free_client;
+                server->free_client = i;
+            }
+            web_close_socket(client_socket);
+            printf("⚠️ Client connection rejected: server full\n");
+            continue;
+        }
+
+        int nodelay = 1;
+        setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, (char*)&nodelay, sizeof(nodelay));
+
+        web_client_t* client = &server->clients[i];
+        client->socket_fd = client_socket;
+        client->is_active = true;
+        client->is_websocket = false;
+        client->closing = false;
+        client->last_activity = web_get_current_time_ms();
+        client->buffer_length = 0;
+        client->output_length = 0;
+        client->output_sent = 0;
+
+        if (web_watch(server, client_socket, i) != 0) {
+            web_disconnect_client(server, i);
+            continue;
+        }
+        server->active_clients++;
+        accepted++;
+
+        char address[INET_ADDRSTRLEN] = "?";
+        inet_ntop(AF_INET, &client_addr.sin_addr, address, sizeof(address));
+        printf("👤 Client %u connected from %s\n", i, address);
     }
-    
-    buffer[bytes_received] = '\0';
-    client->last_activity = web_get_current_time_ms();
-    
-    if (client->is_websocket) {
-        // Handle WebSocket frame
-        return web_handle_websocket_frame(server, client_id, buffer, bytes_received);
+}
+
+// Metrics stream subscriptions
+
+static const struct {
+    const char* name;
+    bool real;
+} web_metric_fields[WEB_METRIC_COUNT] = {
+    [WEB_METRIC_THROUGHPUT_GBPS] = { "throughput_gbps", true },
+    [WEB_METRIC_MESSAGES_PER_SECOND] = { "messages_per_second", false },
+    [WEB_METRIC_GPU_UTILIZATION] = { "gpu_utilization", true },
+    [WEB_METRIC_ACTIVE_STREAMS] = { "active_streams", false },
+    [WEB_METRIC_TOTAL_GPU_MEMORY_USED] = { "total_gpu_memory_used", false },
+    [WEB_METRIC_MEMORY_BANDWIDTH_UTILIZATION] = { "memory_bandwidth_utilization", true },
+    [WEB_METRIC_CUDA_KERNEL_LAUNCHES] = { "cuda_kernel_launches", false },
+    [WEB_METRIC_AVERAGE_KERNEL_TIME_MS] = { "average_kernel_time_ms", true },
+    [WEB_METRIC_TOTAL_MESSAGES] = { "total_messages", false },
+    [WEB_METRIC_TOTAL_BYTES] = { "total_bytes", false },
+    [WEB_METRIC_ACTIVE_CLIENTS] = { "active_clients", false },
+    [WEB_METRIC_BROADCASTS_SKIPPED] = { "broadcasts_skipped", false },
+};
+
+const char* web_metric_name(web_metric_field_t field) {
+    return (unsigned)field < WEB_METRIC_COUNT ? web_metric_fields[field].name : NULL;
+}
+
+bool web_metric_is_real(web_metric_field_t field) {
+    return (unsigned)field < WEB_METRIC_COUNT && web_metric_fields[field].real;
+}
+
+// Copy the value of `key` in a query string; false if absent or too long
+static bool web_query_value(const char* query, const char* key, char* value, size_t size) {
+    size_t key_length = strlen(key);
+    for (const char* p = query; p; p = strchr(p, '&'), p = p ? p + 1 : NULL) {
+        if (strncmp(p, key, key_length) == 0 && p[key_length] == '=') {
+            const char* start = p + key_length + 1;
+            size_t length = strcspn(start, "&");
+            if (length >= size) return false;
+            memcpy(value, start, length);
+            value[length] = '\0';
+            return true;
+        }
+    }
+    return false;
+}
+
+// Parse a comma-separated field list into a mask; 0 if a name is unknown
+static uint32_t web_parse_fields(const char* list) {
+    uint32_t mask = 0;
+    while (*list) {
+        size_t length = strcspn(list, ",");
+        uint32_t field = 0;
+        while (field < WEB_METRIC_COUNT && (strlen(web_metric_fields[field].name) != length ||
+                                            strncmp(web_metric_fields[field].name, list, length) != 0)) {
+            field++;
+        }
+        if (field == WEB_METRIC_COUNT) return 0;
+        mask |= 1u << field;
+        list += length;
+        if (*list == ',') list++;
+    }
+    return mask;
+}
+
+// Attach an upgrading client to the JSON broadcast or the binary stream its
+// query asks for; 400 or 503 for a subscription that cannot be served
+static int web_subscribe(web_server_t* server, web_client_t* client, const char* path) {
+    const char* query = strchr(path, '?');
+    char value[256];
+    if (!query || !web_query_value(query + 1, "format", value, sizeof(value)) || strcmp(value, "binary") != 0) {
+        client->metrics_stream = -1;
+        server->json_subscribers++;
+        server->json_refresh = true;
+        return 0;
+    }
+
+    uint32_t interval = WEB_BROADCAST_INTERVAL_MS;
+    if (web_query_value(query + 1, "interval_ms", value, sizeof(value))) {
+        interval = (uint32_t)strtoul(value, NULL, 10);
+        if (interval < WEB_METRICS_MIN_INTERVAL_MS) interval = WEB_METRICS_MIN_INTERVAL_MS;
+    }
+    uint32_t fields = WEB_METRIC_ALL;
+    if (web_query_value(query + 1, "fields", value, sizeof(value))) {
+        fields = web_parse_fields(value);
+        if (!fields) return 400;
+    }
+
+    // Join the stream already serving this shape, or open one
+    int32_t chosen = -1;
+    for (int32_t i = 0; i < WEB_MAX_METRIC_STREAMS; i++) {
+        web_metrics_stream_t* stream = &server->metric_streams[i];
+        if (stream->subscribers && stream->fields == fields && stream->interval_ms == interval) {
+            chosen = i;
+            break;
+        }
+        if (!stream->subscribers && chosen < 0) chosen = i;
+    }
+    if (chosen < 0) return 503;
+
+    web_metrics_stream_t* stream = &server->metric_streams[chosen];
+    if (!stream->subscribers) {
+        memset(stream, 0, sizeof(*stream));
+        stream->fields = fields;
+        stream->interval_ms = interval;
+    }
+    // Everyone in the stream gets a keyframe now, the newcomer's first frame
+    stream->subscribers++;
+    stream->keyframe_pending = true;
+    stream->next_due = web_get_current_time_ms();
+    client->metrics_stream = chosen;
+    return 0;
+}
+
+static void web_unsubscribe(web_server_t* server, web_client_t* client) {
+    if (!client->is_websocket) return;
+    if (client->metrics_stream < 0) {
+        server->json_subscribers--;
     } else {
-        // Parse HTTP request
-        char method[16], path[256], headers[2048];
-        if (web_parse_http_request(buffer, method, path, headers) < 0) {
-            return -1;
+        server->metric_streams[client->metrics_stream].subscribers--;
+    }
+    client->metrics_stream = -1;
+}
+
+// Answer one complete request at the head of the client's buffer
+static int web_handle_http_request(web_server_t* server, web_client_t* client, const char* request) {
+    char method[16], path[256], headers[2048];
+    if (web_parse_http_request(request, method, path, headers) < 0) {
+        return -1;
+    }
+
+    // Check for WebSocket upgrade
+    if (web_is_websocket_upgrade(headers)) {
+        char response[1024];
+        int length = web_websocket_accept(headers, response, sizeof(response));
+        if (length < 0) {
+            const char* bad_request = "Missing Sec-WebSocket-Key";
+            return web_queue_http_response(client, 400, "text/plain", bad_request, strlen(bad_request));
         }
-        
-        // Check for WebSocket upgrade
-        if (web_is_websocket_upgrade(headers)) {
-            if (web_perform_websocket_handshake(client->socket_fd, headers) == 0) {
-                client->is_websocket = true;
-                printf("🔄 Client %d upgraded to WebSocket\n", client_id);
-            }
-            return 0;
+        int refused = web_subscribe(server, client, path);
+        if (refused) {
+            const char* reason = refused == 503 ? "Too many metrics streams" : "Unknown metrics field";
+            return web_queue_http_response(client, refused, "text/plain", reason, strlen(reason));
         }
-        
-        // Handle HTTP request
-        json_response_t* json_response = NULL;
-        char* html_content = NULL;
-        size_t content_length = 0;
-        
-        if (strcmp(path, "/") == 0 || strcmp(path, "/dashboard") == 0) {
-            web_handle_dashboard_request(server, &html_content, &content_length);
-            web_send_http_response(client->socket_fd, 200, "text/html", html_content, content_length);
-            free(html_content);
-        } else if (strcmp(path, "/api/status") == 0) {
-            json_response = json_create_response();
+        client->is_websocket = true;
+        printf("🔄 Client %u upgraded to WebSocket\n", client->client_id);
+        return web_queue_output(client, response, (size_t)length);
+    }
+
+    // Handle HTTP request
+    json_response_t* json_response = NULL;
+    char* html_content = NULL;
+    size_t content_length = 0;
+    int result;
+
+    if (strcmp(path, "/") == 0 || strcmp(path, "/dashboard") == 0) {
+        web_handle_dashboard_request(server, &html_content, &content_length);
+        result = web_queue_http_response(client, 200, "text/html", html_content, content_length);
+        free(html_content);
+    } else if (strcmp(path, "/metrics") == 0 && server->registry) {
+        if (!metrics_registry_render(server->registry, &server->metrics_text)) {
+            const char* failed = "metrics render failed\n";
+            return web_queue_http_response(client, 500, "text/plain", failed, strlen(failed));
+        }
+        result = web_queue_http_response(client, 200, "text/plain; version=0.0.4; charset=utf-8",
+                                         server->metrics_text.data, server->metrics_text.length);
+    } else if (strcmp(path, "/api/status") == 0 || strcmp(path, "/api/metrics") == 0) {
+        json_response = json_create_response();
+        if (!json_response) return -1;
+        if (strcmp(path, "/api/status") == 0) {
             web_handle_status_request(server, json_response);
-            web_send_http_response(client->socket_fd, 200, "application/json", json_response->json_data, json_response->json_length);
-            json_free_response(json_response);
-        } else if (strcmp(path, "/api/metrics") == 0) {
-            json_response = json_create_response();
+        } else {
             web_handle_metrics_request(server, json_response);
-            web_send_http_response(client->socket_fd, 200, "application/json", json_response->json_data, json_response->json_length);
-            json_free_response(json_response);
+        }
+        result = web_queue_http_response(client, 200, "application/json", json_response->json_data,
+                                         json_response->json_length);
+        json_free_response(json_response);
+    } else {
+        // 404 Not Found
+        const char* not_found = "<!DOCTYPE html><html><body><h1>404 Not Found</h1></body></html>";
+        result = web_queue_http_response(client, 404, "text/html", not_found, strlen(not_found));
+    }
+    return result;
+}
+
+// Handle client HTTP/WebSocket input; edge-triggered, so read until the socket is dry
+int web_handle_client_request(web_server_t* server, uint32_t client_id) {
+    if (client_id >= server->client_capacity) return -1;
+    web_client_t* client = &server->clients[client_id];
+
+    for (;;) {
+        // One spare byte keeps the request NUL-terminated
+        size_t wanted = client->buffer_length + WEB_INITIAL_BUFFER + 1;
+        if (wanted > WEB_BUFFER_SIZE + 1) wanted = WEB_BUFFER_SIZE + 1;
+        if (client->buffer_length >= WEB_BUFFER_SIZE ||
+            !web_reserve(&client->buffer, &client->buffer_capacity, wanted, WEB_BUFFER_SIZE + 1)) {
+            return -1; // Request too large
+        }
+
+        int bytes_received = recv(client->socket_fd, client->buffer + client->buffer_length,
+                                  (int)(client->buffer_capacity - 1 - client->buffer_length), 0);
+        if (bytes_received > 0) {
+            client->buffer_length += (size_t)bytes_received;
+            client->last_activity = web_get_current_time_ms();
+
+            if (client->is_websocket) {
+                // Handle WebSocket frame
+                if (web_handle_websocket_frame(server, client_id, client->buffer, client->buffer_length) < 0) {
+                    return -1;
+                }
+                client->buffer_length = 0;
+                continue;
+            }
+
+            client->buffer[client->buffer_length] = '\0';
+            if (client->closing || !strstr(client->buffer, "\r\n\r\n")) continue;
+
+            // Requests carry no body we act on; the response closes the connection
+            if (web_handle_http_request(server, client, client->buffer) < 0) return -1;
+            client->buffer_length = 0;
+            if (!client->is_websocket) return 0;
+        } else if (bytes_received == 0) {
+            return -1; // Client disconnected
+        } else if (WEB_INTERRUPTED()) {
+            continue;
         } else {
-            // 404 Not Found
-            const char* not_found = "<!DOCTYPE html><html><body><h1>404 Not Found</h1></body></html>";
-            web_send_http_response(client->socket_fd, 404, "text/html", not_found, strlen(not_found));
+            return WEB_WOULD_BLOCK() ? 0 : -1;
         }
     }
-    
-    return 0;
 }
 
 // WebSocket handshake
 int web_perform_websocket_handshake(int socket_fd, const char* headers) {
-    char key[256] = {0};
-    
-    // Extract WebSocket key
-    const char* key_start = strstr(headers, "Sec-WebSocket-Key: ");
-    if (!key_start) return -1;
-    
-    key_start += 19; // Length of "Sec-WebSocket-Key: "
-    const char* key_end = strstr(key_start, "\r\n");
-    if (!key_end) return -1;
-    
-    size_t key_len = key_end - key_start;
-    if (key_len >= sizeof(key)) return -1;
-    
-    strncpy(key, key_start, key_len);
-    
-    // Create response key
-    char concatenated[512];
-    snprintf(concatenated, sizeof(concatenated), "%s%s", key, WEBSOCKET_MAGIC);
-    
-    unsigned char hash[20];
-    sha1_hash(concatenated, hash);
-    
-    char* accept_key = base64_encode(hash, 20);
-    if (!accept_key) return -1;
-    
-    // Send handshake response
     char response[1024];
-    snprintf(response, sizeof(response),
-        "HTTP/1.1 101 Switching Protocols\r\n"
-        "Upgrade: websocket\r\n"
-        "Connection: Upgrade\r\n"
-        "Sec-WebSocket-Accept: %s\r\n"
-        "\r\n", accept_key);
-    
-    send(socket_fd, response, strlen(response), 0);
-    free(accept_key);
-    
+    int length = web_websocket_accept(headers, response, sizeof(response));
+    if (length < 0) return -1;
+
+    send(socket_fd, response, length, WEB_SEND_FLAGS);
     return 0;
 }
 
@@ -610,7 +1202,7 @@ int json_add_integer(json_response_t* response, const char* key, uint64_t value)
     if (!response || !key) return -1;
     
     char buffer[256];
-    snprintf(buffer, sizeof(buffer), "\"%s\":%I64u", key, (unsigned long long)value);
+    snprintf(buffer, sizeof(buffer), "\"%s\":%llu", key, (unsigned long long)value);
     strcat(buffer, ",");
     
     size_t needed = response->json_length + strlen(buffer);
@@ -627,6 +1219,60 @@ int json_add_integer(json_response_t* response, const char* key, uint64_t value)
     return 0;
 }
 
+int json_add_string(json_response_t* response, const char* key, const char* value) {
+    if (!response || !key || !value) return -1;
+    
+    // Quotes, backslashes and control characters escaped; the rest passes as is
+    size_t value_length = strlen(value);
+    size_t needed = response->json_length + strlen(key) + value_length * 6 + 8;
+    if (needed >= response->json_capacity) {
+        response->json_capacity = needed * 2;
+        char* new_data = (char*)realloc(response->json_data, response->json_capacity);
+        if (!new_data) return -1;
+        response->json_data = new_data;
+    }
+    
+    char* out = response->json_data + response->json_length;
+    out += sprintf(out, "\"%s\":\"", key);
+    for (size_t i = 0; i < value_length; i++) {
+        unsigned char c = (unsigned char)value[i];
+        if (c == '"' || c == '\\') {
+            *out++ = '\\';
+            *out++ = (char)c;
+        } else if (c < 0x20) {
+            out += sprintf(out, "\\u%04x", c);
+        } else {
+            *out++ = (char)c;
+        }
+    }
+    *out++ = '"';
+    *out++ = ',';
+    *out = '\0';
+    response->json_length = (size_t)(out - response->json_data);
+    
+    return 0;
+}
+
+int json_add_boolean(json_response_t* response, const char* key, bool value) {
+    if (!response || !key) return -1;
+    
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "\"%s\":%s,", key, value ? "true" : "false");
+    
+    size_t needed = response->json_length + strlen(buffer);
+    if (needed >= response->json_capacity) {
+        response->json_capacity = needed * 2;
+        char* new_data = (char*)realloc(response->json_data, response->json_capacity);
+        if (!new_data) return -1;
+        response->json_data = new_data;
+    }
+    
+    strcat(response->json_data, buffer);
+    response->json_length += strlen(buffer);
+    
+    return 0;
+}
+
 int json_finalize(json_response_t* response) {
     if (!response) return -1;
     
@@ -648,11 +1294,25 @@ void json_free_response(json_response_t* response) {
 }
 
 // Handle metrics API request
+int web_handle_status_request(web_server_t* server, json_response_t* response) {
+    if (!server || !response) return -1;
+    
+    json_add_string(response, "status", atomic_load_bool(&server->is_running) ? "running" : "stopped");
+    json_add_integer(response, "port", server->port);
+    json_add_integer(response, "active_clients", server->active_clients);
+    json_add_integer(response, "broadcasts_skipped", server->broadcasts_skipped);
+    json_add_boolean(response, "pause_processing", server->pause_processing);
+    json_add_integer(response, "target_throughput_gbps", server->target_throughput_gbps);
+    
+    json_finalize(response);
+    return 0;
+}
+
 int web_handle_metrics_request(web_server_t* server, json_response_t* response) {
     if (!server || !response) return -1;
     
-    gpu_performance_metrics_t metrics;
-    gpu_update_performance_metrics(server->gpu_buffer, &metrics);
+    // The cache web_update_performance_cache refreshes; zeroed until the first sample
+    gpu_performance_metrics_t metrics = server->last_metrics;
     
     json_add_number(response, "throughput_gbps", metrics.throughput_gbps);
     json_add_integer(response, "messages_per_second", metrics.messages_per_second);
@@ -667,32 +1327,24 @@ int web_handle_metrics_request(web_server_t* server, json_response_t* response)
     return 0;
 }
 
+
 // Utility functions
 uint64_t web_get_current_time_ms(void) {
-#ifdef _WIN32
-    LARGE_INTEGER freq, counter;
-    QueryPerformanceFrequency(&freq);
-    QueryPerformanceCounter(&counter);
-    return (uint64_t)((counter.QuadPart * 1000ULL) / freq.QuadPart);
-#else
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
-#endif
+    return umsbb_clock_coarse_ns() / 1000000;
 }
 
 int web_parse_http_request(const char* request, char* method, char* path, char* headers) {
     const char* line_end = strstr(request, "\r\n");
     if (!line_end) return -1;
-    
+
     // Parse first line: METHOD /path HTTP/1.1
-    sscanf(request, "%15s %255s", method, path);
-    
+    if (sscanf(request, "%15s %255s", method, path) != 2) return -1;
+
     // Copy headers
-    const char* headers_start = strstr(request, "\r\n") + 2;
+    const char* headers_start = line_end + 2;
     strncpy(headers, headers_start, 2047);
     headers[2047] = '\0';
-    
+
     return 0;
 }
 
@@ -700,6 +1352,7 @@ bool web_is_websocket_upgrade(const char* headers) {
     return strstr(headers, "Upgrade: websocket") != NULL;
 }
 
+// Blocking-socket helper; the server itself queues through web_queue_http_response
 int web_send_http_response(int socket_fd, int status_code, const char* content_type, const char* body, size_t body_length) {
     char header[1024];
     snprintf(header, sizeof(header),
@@ -713,116 +1366,274 @@ int web_send_http_response(int socket_fd, int status_code, const char* content_t
         (status_code == 200) ? "OK" : "Not Found",
         content_type,
         (unsigned long)body_length);
-    
-    send(socket_fd, header, strlen(header), 0);
+
+    send(socket_fd, header, strlen(header), WEB_SEND_FLAGS);
     if (body && body_length > 0) {
-        send(socket_fd, body, body_length, 0);
+        send(socket_fd, body, body_length, WEB_SEND_FLAGS);
     }
-    
+
     return 0;
 }
 
-// Broadcast metrics to WebSocket clients
+// Metrics streams
+
+static void web_put_le(uint8_t* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint64_t web_metric_real(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+void web_metrics_snapshot(web_server_t* server, web_metrics_snapshot_t* snapshot) {
+    const gpu_performance_metrics_t* metrics = &server->last_metrics;
+    uint64_t* values = snapshot->values;
+
+    values[WEB_METRIC_THROUGHPUT_GBPS] = web_metric_real(metrics->throughput_gbps);
+    values[WEB_METRIC_MESSAGES_PER_SECOND] = metrics->messages_per_second;
+    values[WEB_METRIC_GPU_UTILIZATION] = web_metric_real(metrics->gpu_utilization);
+    values[WEB_METRIC_ACTIVE_STREAMS] = metrics->active_streams;
+    values[WEB_METRIC_TOTAL_GPU_MEMORY_USED] = metrics->total_gpu_memory_used;
+    values[WEB_METRIC_MEMORY_BANDWIDTH_UTILIZATION] = web_metric_real(metrics->memory_bandwidth_utilization);
+    values[WEB_METRIC_CUDA_KERNEL_LAUNCHES] = metrics->cuda_kernel_launches;
+    values[WEB_METRIC_AVERAGE_KERNEL_TIME_MS] = web_metric_real(metrics->average_kernel_time_ms);
+    values[WEB_METRIC_TOTAL_MESSAGES] = gpu_atomic_load_uint64(&server->gpu_buffer->total_messages);
+    values[WEB_METRIC_TOTAL_BYTES] = gpu_atomic_load_uint64(&server->gpu_buffer->total_bytes);
+    values[WEB_METRIC_ACTIVE_CLIENTS] = server->active_clients;
+    values[WEB_METRIC_BROADCASTS_SKIPPED] = server->broadcasts_skipped;
+    snapshot->timestamp_ms = web_get_current_time_ms();
+}
+
+size_t web_metrics_encode(web_metrics_stream_t* stream, const web_metrics_snapshot_t* snapshot,
+                          uint8_t* out, size_t capacity) {
+    if (capacity < WEB_METRICS_FRAME_MAX) return 0;
+
+    bool keyframe = stream->keyframe_pending;
+    uint8_t* entry = out + WEB_METRICS_HEADER_SIZE;
+    uint32_t count = 0;
+    for (uint32_t field = 0; field < WEB_METRIC_COUNT; field++) {
+        uint64_t value = snapshot->values[field];
+        if (!(stream->fields & (1u << field)) || (!keyframe && value == stream->last[field])) continue;
+        entry[0] = (uint8_t)field;
+        web_put_le(entry + 1, value, 8);
+        entry += WEB_METRICS_ENTRY_SIZE;
+        stream->last[field] = value;
+        count++;
+    }
+    if (count == 0) return 0;
+
+    out[0] = WEB_METRICS_VERSION;
+    out[1] = keyframe ? WEB_METRICS_KEYFRAME : 0;
+    web_put_le(out + 2, count, 2);
+    web_put_le(out + 4, stream->sequence++, 4);
+    web_put_le(out + 8, snapshot->timestamp_ms, 8);
+    stream->keyframe_pending = false;
+    return (size_t)(entry - out);
+}
+
+// Broadcast metrics to WebSocket clients: each frame is built once and the
+// same bytes queued to everyone it is for
 int web_broadcast_metrics(web_server_t* server) {
-    json_response_t* response = json_create_response();
-    if (!response) return -1;
-    
-    web_handle_metrics_request(server, response);
-    
-    // Send to all WebSocket clients
-    for (uint32_t i = 0; i < MAX_CLIENTS; i++) {
-        if (server->clients[i].is_active && server->clients[i].is_websocket) {
-            web_send_websocket_frame(server->clients[i].socket_fd, response->json_data, response->json_length);
+    uint64_t now = web_get_current_time_ms();
+
+    // JSON for the dashboard, when it changed
+    json_response_t* response = NULL;
+    uint8_t json_header[10];
+    size_t json_header_size = 0;
+    if (server->json_subscribers && now - server->last_broadcast >= WEB_BROADCAST_INTERVAL_MS) {
+        server->last_broadcast = now;
+        if (server->json_refresh || memcmp(&server->json_sent, &server->last_metrics, sizeof(server->json_sent)) != 0) {
+            response = json_create_response();
+            if (!response) return -1;
+            web_handle_metrics_request(server, response);
+            json_header_size = web_websocket_header(json_header, response->json_length, WEB_WS_TEXT);
+            server->json_sent = server->last_metrics;
+            server->json_refresh = false;
         }
     }
-    
+
+    // One snapshot for every binary stream that is due
+    uint8_t frames[WEB_MAX_METRIC_STREAMS][10 + WEB_METRICS_FRAME_MAX];
+    size_t frame_sizes[WEB_MAX_METRIC_STREAMS] = {0};
+    bool framed = false;
+    web_metrics_snapshot_t snapshot;
+    bool snapped = false;
+    for (uint32_t i = 0; i < WEB_MAX_METRIC_STREAMS; i++) {
+        web_metrics_stream_t* stream = &server->metric_streams[i];
+        if (!stream->subscribers || stream->next_due > now) continue;
+        stream->next_due += stream->interval_ms;
+        if (stream->next_due <= now) stream->next_due = now + stream->interval_ms;
+        if (!snapped) {
+            web_metrics_snapshot(server, &snapshot);
+            snapped = true;
+        }
+
+        uint8_t payload[WEB_METRICS_FRAME_MAX];
+        size_t length = web_metrics_encode(stream, &snapshot, payload, sizeof(payload));
+        if (length == 0) continue; // Nothing changed
+        size_t header_size = web_websocket_header(frames[i], length, WEB_WS_BINARY);
+        memcpy(frames[i] + header_size, payload, length);
+        frame_sizes[i] = header_size + length;
+        framed = true;
+    }
+    if (!response && !framed) return 0;
+
+    for (uint32_t i = 0; i < server->client_capacity; i++) {
+        web_client_t* client = &server->clients[i];
+        if (!client->is_active || !client->is_websocket || client->closing) continue;
+        int32_t stream = client->metrics_stream;
+        if (stream < 0 ? !response : frame_sizes[stream] == 0) continue;
+
+        // A subscriber this far behind gets the next snapshot instead; a
+        // stream's members then get a keyframe so the gap is repaired
+        if (client->output_length - client->output_sent > WEB_MAX_PENDING_BYTES) {
+            server->broadcasts_skipped++;
+            if (stream >= 0) server->metric_streams[stream].keyframe_pending = true;
+            continue;
+        }
+        int queued = stream < 0
+            ? (web_queue_output(client, json_header, json_header_size) < 0 ? -1 :
+               web_queue_output(client, response->json_data, response->json_length))
+            : web_queue_output(client, frames[stream], frame_sizes[stream]);
+        if (queued < 0) {
+            web_disconnect_client(server, i);
+        }
+    }
+
     json_free_response(response);
     return 0;
 }
 
+// Blocking-socket helper; the server itself queues frames per client
 int web_send_websocket_frame(int socket_fd, const char* data, size_t length) {
     uint8_t frame[10];
-    size_t frame_size = 2;
-    
-    frame[0] = 0x81; // Text frame, final fragment
-    
-    if (length < 126) {
-        frame[1] = (uint8_t)length;
-    } else if (length < 65536) {
-        frame[1] = 126;
-        frame[2] = (length >> 8) & 0xFF;
-        frame[3] = length & 0xFF;
-        frame_size += 2;
-    } else {
-        frame[1] = 127;
-        for (int i = 0; i < 8; i++) {
-            frame[2 + i] = (length >> (8 * (7 - i))) & 0xFF;
-        }
-        frame_size += 8;
-    }
-    
-    send(socket_fd, (char*)frame, frame_size, 0);
-    send(socket_fd, data, length, 0);
-    
+    size_t frame_size = web_websocket_header(frame, length, WEB_WS_TEXT);
+
+    send(socket_fd, (char*)frame, frame_size, WEB_SEND_FLAGS);
+    send(socket_fd, data, length, WEB_SEND_FLAGS);
+
     return 0;
 }
 
 int web_handle_websocket_frame(web_server_t* server, uint32_t client_id, const char* data, size_t length) {
     // Simple WebSocket frame handling - just acknowledge receipt
+    (void)server; (void)client_id; (void)data; (void)length;
     return 0;
 }
 
 void web_disconnect_client(web_server_t* server, uint32_t client_id) {
-    if (client_id >= MAX_CLIENTS || !server->clients[client_id].is_active) return;
-    
-#ifdef _WIN32
-    closesocket(server->clients[client_id].socket_fd);
-#else
-    close(server->clients[client_id].socket_fd);
-#endif
-    
-    server->clients[client_id].is_active = false;
-    server->clients[client_id].is_websocket = false;
+    if (client_id >= server->client_capacity || !server->clients[client_id].is_active) return;
+    web_client_t* client = &server->clients[client_id];
+
+    // Closing the descriptor also drops it from epoll/kqueue
+    web_close_socket(client->socket_fd);
+    web_unsubscribe(server, client);
+
+    client->socket_fd = -1;
+    client->is_active = false;
+    client->is_websocket = false;
+    client->closing = false;
+    client->buffer_length = 0;
+    client->output_length = 0;
+    client->output_sent = 0;
+    client->next_free = server->free_client;
+    server->free_client = client_id;
     server->active_clients--;
-    
-    printf("👋 Client %d disconnected\n", client_id);
+
+    printf("👋 Client %u disconnected\n", client_id);
 }
 
 int web_update_performance_cache(web_server_t* server) {
     uint64_t current_time = web_get_current_time_ms();
-    if (current_time - server->last_metrics_update > 100) { // Update every 100ms
+    if (current_time - server->last_metrics_update >= WEB_CACHE_INTERVAL_MS) {
         gpu_update_performance_metrics(server->gpu_buffer, &server->last_metrics);
         server->last_metrics_update = current_time;
     }
     return 0;
 }
 
+bool web_server_set_metrics_registry(web_server_t* server, MetricsRegistry* registry) {
+    if (!server || !registry) return false;
+    server->registry = registry;
+    return metrics_registry_add(registry, server, METRIC_GAUGE, "umsbb_web_clients",
+                                "Connected HTTP and WebSocket clients", NULL, METRIC_U32,
+                                &server->active_clients) &&
+           metrics_registry_add(registry, server, METRIC_COUNTER, "umsbb_web_broadcasts_skipped_total",
+                                "Subscriber frames dropped for a full output queue", NULL, METRIC_U64,
+                                &server->broadcasts_skipped);
+}
+
 void web_server_stop(web_server_t* server) {
     if (!server) return;
-    server->is_running = false;
+    atomic_store_bool(&server->is_running, false);
+
+#ifndef _WIN32
+    // Cut the event loop's wait short
+    if (server->wake_fds[1] >= 0) {
+        char wake = 1;
+        ssize_t written = write(server->wake_fds[1], &wake, 1);
+        (void)written;
+    }
+#endif
+
+    if (server->thread) {
+#ifdef _WIN32
+        WaitForSingleObject((HANDLE)server->thread, INFINITE);
+        CloseHandle((HANDLE)server->thread);
+#else
+        pthread_join(*(pthread_t*)server->thread, NULL);
+        free(server->thread);
+#endif
+        server->thread = NULL;
+    }
 }
 
 void web_server_cleanup(web_server_t* server) {
     if (!server) return;
-    
-    server->is_running = false;
-    
+
+    web_server_stop(server);
+
     // Disconnect all clients
-    for (uint32_t i = 0; i < MAX_CLIENTS; i++) {
+    for (uint32_t i = 0; i < server->client_capacity; i++) {
         if (server->clients[i].is_active) {
             web_disconnect_client(server, i);
         }
+        free(server->clients[i].buffer);
+        free(server->clients[i].output);
     }
-    
+    free(server->clients);
+    free(server->poll_set);
+    server->clients = NULL;
+    server->poll_set = NULL;
+    server->client_capacity = 0;
+    server->poll_capacity = 0;
+    server->free_client = WEB_NO_CLIENT;
+
+    if (server->registry) {
+        metrics_registry_remove(server->registry, server, 0);
+        server->registry = NULL;
+    }
+    metrics_text_free(&server->metrics_text);
+
+#ifndef _WIN32
+    for (int i = 0; i < 2; i++) {
+        if (server->wake_fds[i] >= 0) close(server->wake_fds[i]);
+        server->wake_fds[i] = -1;
+    }
+    if (server->poll_fd >= 0) close(server->poll_fd);
+    server->poll_fd = -1;
+#endif
+
     // Close server socket
     if (server->server_socket >= 0) {
+        web_close_socket(server->server_socket);
+        server->server_socket = -1;
 #ifdef _WIN32
-        closesocket(server->server_socket);
         WSACleanup();
-#else
-        close(server->server_socket);
 #endif
     }
-    
+
     printf("🧹 Web server cleanup completed\n");
-}
\ No newline at end of file
+}
@@ -53,7 +53,7 @@ void benchmark_drain_performance(UniversalMultiSegmentedBiBufferBus* bus, int it
     
     size_t recv_size = 0;
     for (int i = 0; i < iterations; ++i) {
-        umsbb_drain_from(bus, i % bus->ring.activeCount, &recv_size);
+        umsbb_message_release(umsbb_drain_from(bus, i % bus->ring.activeCount, &recv_size));
     }
     
     double endTime = get_time();
@@ -74,10 +74,12 @@ void benchmark_feedback_performance(UniversalMultiSegmentedBiBufferBus* bus, int
     
     double startTime = get_time();
     
+    FeedbackEntry entries[64];
     for (int i = 0; i < iterations; ++i) {
-        size_t count;
-        FeedbackEntry* entries = umsbb_get_feedback(bus, &count);
-        (void)entries; // Suppress unused variable warning
+        FeedbackCursor cursor;
+        size_t lane = (size_t)i % bus->ring.activeCount;
+        umsbb_feedback_cursor(bus, lane, &cursor);
+        while (umsbb_read_feedback(bus, lane, &cursor, entries, 64) > 0) {}
     }
     
     double endTime = get_time();
@@ -99,10 +101,9 @@ int main() {
     printf("Timestamp: %ld\n\n", (long)time(NULL));
     
     // Initialize with larger capacity for benchmarking
-    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(64 * 1024, 128 * 1024); // 64KB buffers, 128KB arena
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(64 * 1024, 128 * 1024); // 64KB buffers
     printf("✅ Bus initialized with %zu segments\n", bus->ring.activeCount);
-    printf("Buffer capacity: %zu bytes\n", bus->ring.buffers[0].capacity);
-    printf("Arena capacity: %zu bytes\n\n", bus->arena.capacity);
+    printf("Buffer capacity: %zu bytes\n\n", bi_buffer_capacity(bus->ring.buffers[0]));
     
     // Benchmark iterations
     const int BENCH_ITERATIONS = 10000;
@@ -119,20 +120,28 @@ int main() {
     // Summary statistics
     printf("📊 Final Statistics\n");
     printf("===================\n");
-    size_t feedbackCount;
-    FeedbackEntry* entries = umsbb_get_feedback(bus, &feedbackCount);
+    size_t feedbackCount = 0;
+    FeedbackEntry entries[64];
     
-    // Count feedback types
+    // Count feedback types across every lane's retained entries
     int okCount = 0, cpuCount = 0, gpuCount = 0, throttledCount = 0, skippedCount = 0, idleCount = 0;
-    for (size_t i = 0; i < feedbackCount; ++i) {
-        switch (entries[i].type) {
-            case FEEDBACK_OK: okCount++; break;
-            case FEEDBACK_CPU_EXECUTED: cpuCount++; break;
-            case FEEDBACK_GPU_EXECUTED: gpuCount++; break;
-            case FEEDBACK_THROTTLED: throttledCount++; break;
-            case FEEDBACK_SKIPPED: skippedCount++; break;
-            case FEEDBACK_IDLE: idleCount++; break;
-            default: break;
+    for (size_t lane = 0; lane < bus->ring.activeCount; ++lane) {
+        FeedbackCursor cursor;
+        umsbb_feedback_cursor(bus, lane, &cursor);
+        size_t n;
+        while ((n = umsbb_read_feedback(bus, lane, &cursor, entries, 64)) > 0) {
+            feedbackCount += n;
+            for (size_t i = 0; i < n; ++i) {
+                switch (entries[i].type) {
+                    case FEEDBACK_OK: okCount++; break;
+                    case FEEDBACK_CPU_EXECUTED: cpuCount++; break;
+                    case FEEDBACK_GPU_EXECUTED: gpuCount++; break;
+                    case FEEDBACK_THROTTLED: throttledCount++; break;
+                    case FEEDBACK_SKIPPED: skippedCount++; break;
+                    case FEEDBACK_IDLE: idleCount++; break;
+                    default: break;
+                }
+            }
         }
     }
     
@@ -144,7 +153,7 @@ int main() {
     printf("  - Skipped: %d\n", skippedCount);
     printf("  - Idle: %d\n", idleCount);
     
-    double successRate = (double)(okCount + cpuCount + gpuCount) / feedbackCount * 100;
+    double successRate = feedbackCount ? (double)(okCount + cpuCount + gpuCount) / feedbackCount * 100 : 100.0;
     printf("Success rate: %.1f%%\n", successRate);
     
     printf("\n🧹 Cleanup and exit...\n");
@@ -0,0 +1,163 @@
+#include "../include/arena_allocator.h"
+#include "../include/bi_buffer.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "test_check.h"
+
+static void test_steady_state(void) {
+    printf("♻️ Blocks are recycled behind the release cursor\n");
+    ArenaAllocator arena;
+    arena_init_ex(&arena, 256 * 1024, 16 * 1024, 0);
+
+    // Far more bytes than the capacity, with a bounded number in flight
+    void* inflight[64];
+    size_t head = 0, count = 0;
+    int ok = 1;
+    for (int i = 0; i < 200000 && ok; ++i) {
+        if (count == 64) {
+            arena_release(inflight[head]);
+            head = (head + 1) % 64;
+            count--;
+        }
+        size_t len = 16 + (size_t)(i * 13) % 500;
+        uint8_t* p = arena_alloc(&arena, len);
+        if (!p) { ok = 0; break; }
+        memset(p, (int)(i & 0xFF), len);
+        inflight[(head + count) % 64] = p;
+        count++;
+    }
+    CHECK(ok, "200k allocations fit in a 256 KB arena");
+    size_t reserved = arena_reserved(&arena);
+    CHECK(reserved <= 256 * 1024, "reserved bytes stay within capacity");
+
+    for (int i = 0; i < 100000; ++i) {
+        arena_release(inflight[head]);
+        inflight[head] = arena_alloc(&arena, 200);
+        head = (head + 1) % 64;
+    }
+    CHECK(arena_reserved(&arena) == reserved, "steady state allocates no new blocks");
+    arena_destroy(&arena);
+}
+
+static void test_alignment_and_limits(void) {
+    printf("📏 Alignment, oversized requests and capacity\n");
+    ArenaAllocator arena;
+    arena_init_ex(&arena, 64 * 1024, 8 * 1024, 0);
+
+    int aligned = 1;
+    for (int i = 0; i < 50; ++i) {
+        if ((size_t)arena_alloc(&arena, 1 + i) % ARENA_ALIGNMENT) aligned = 0;
+        void* p = arena_alloc_aligned(&arena, 10, 64);
+        if ((size_t)p % 64) aligned = 0;
+    }
+    CHECK(aligned, "results honour the requested alignment");
+
+    void* big = arena_alloc(&arena, 20 * 1024);
+    CHECK(big != NULL, "requests larger than a block get a dedicated block");
+    CHECK(arena_alloc(&arena, 60 * 1024) == NULL, "allocation fails once capacity is reached");
+
+    arena_reset(&arena);
+    CHECK(arena_alloc(&arena, 1000) != NULL, "reset makes the blocks available again");
+    arena_destroy(&arena);
+
+    arena_init_ex(&arena, 0, ARENA_HUGE_PAGE_SIZE, ARENA_FLAG_HUGE_PAGES);
+    uint8_t* p = arena_alloc(&arena, 4096);
+    if (p) memset(p, 1, 4096);
+    CHECK(p != NULL, "huge-page backing works or falls back");
+    arena_destroy(&arena);
+}
+
+#define PRODUCERS 3
+#define MESSAGES 40000
+
+static ArenaAllocator shared;
+static BiBuffer queues[PRODUCERS];
+static atomic_size_t producersDone;
+
+typedef struct {
+    uint32_t producer;
+    uint32_t sequence;
+    uint8_t body[48];
+} Payload;
+
+static void* producer_main(void* arg) {
+    uint32_t id = (uint32_t)(size_t)arg;
+    for (uint32_t i = 0; i < MESSAGES; ++i) {
+        Payload* p;
+        while ((p = arena_alloc(&shared, sizeof(Payload))) == NULL) sched_yield();
+        p->producer = id;
+        p->sequence = i;
+        memset(p->body, (int)i & 0xFF, sizeof(p->body));
+
+        // Hand the pointer to the consumer through the producer's own lane
+        void** slot;
+        while ((slot = bi_buffer_claim(&queues[id], sizeof(void*))) == NULL) sched_yield();
+        *slot = p;
+        bi_buffer_commit(&queues[id], slot, sizeof(void*));
+    }
+    atomic_fetch_add_size(&producersDone, 1);
+    return NULL;
+}
+
+static void test_cross_thread_release(void) {
+    printf("🧵 Producers allocate, a consumer releases\n");
+    arena_init_ex(&shared, 512 * 1024, 16 * 1024, 0);
+    atomic_store_size(&producersDone, 0);
+
+    pthread_t threads[PRODUCERS];
+    for (size_t i = 0; i < PRODUCERS; ++i) {
+        bi_buffer_init_mode(&queues[i], 4096, BI_BUFFER_MODE_SPSC);
+        pthread_create(&threads[i], NULL, producer_main, (void*)i);
+    }
+
+    uint32_t expect[PRODUCERS] = {0};
+    size_t received = 0;
+    int bad = 0;
+    for (;;) {
+        bool done = atomic_load_size(&producersDone) == PRODUCERS;
+        bool any = false;
+        for (size_t q = 0; q < PRODUCERS; ++q) {
+            size_t size;
+            void** slot = bi_buffer_read(&queues[q], &size);
+            if (!slot) continue;
+            Payload* p = *slot;
+            bi_buffer_release(&queues[q]);
+            if (p->producer != q || p->sequence != expect[q] || p->body[47] != (uint8_t)(p->sequence & 0xFF)) bad++;
+            expect[q]++;
+            arena_release(p);
+            received++;
+            any = true;
+        }
+        if (!any) {
+            if (done) break;
+            sched_yield();
+        }
+    }
+    for (size_t i = 0; i < PRODUCERS; ++i) {
+        pthread_join(threads[i], NULL);
+        bi_buffer_destroy(&queues[i]);
+    }
+
+    CHECK(bad == 0, "payloads arrive intact and in per-producer order");
+    CHECK(received == (size_t)PRODUCERS * MESSAGES, "every allocation was delivered");
+    CHECK(arena_reserved(&shared) <= 512 * 1024, "blocks were recycled across threads");
+    arena_destroy(&shared);
+}
+
+int main(void) {
+    printf("🧪 Arena Allocator Tests\n");
+    printf("========================\n");
+
+    test_steady_state();
+    test_alignment_and_limits();
+    test_cross_thread_release();
+
+    if (failures) {
+        printf("\n❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✅ All arena allocator tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include "../include/message_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "test_check.h"
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static void test_hysteresis(void) {
+    printf("📉 Throttled gates reopen only at the low mark\n");
+    HighWaterMark* h = hwm_create_marks(1000, 500, 100);
+    HighWaterMarkStats stats;
+
+    bool all = true;
+    for (int i = 0; i < 10; ++i) all &= hwm_try_acquire(h, 100);
+    CHECK(all, "the full high mark can be acquired");
+    CHECK(!hwm_try_acquire(h, 100) && hwm_is_throttled(h), "exhausted credit throttles the gate");
+
+    for (int i = 0; i < 4; ++i) hwm_release(h, 100);
+    CHECK(!hwm_try_acquire(h, 100), "no credit above the low mark while throttled");
+    hwm_get_stats(h, &stats);
+    CHECK(stats.throttleEvents == 1 && stats.rejected == 2, "one throttle episode, two rejected acquires");
+    CHECK(stats.grants == 0 && stats.outstanding == 600, "released credit is held back");
+
+    hwm_release(h, 100);
+    hwm_get_stats(h, &stats);
+    CHECK(!stats.throttled && stats.grants == 1, "reaching the low mark reopens the gate in one grant");
+    all = true;
+    for (int i = 0; i < 5; ++i) all &= hwm_try_acquire(h, 100);
+    CHECK(all, "producers resume with a high-minus-low window");
+    hwm_destroy(h);
+}
+
+static void test_batched_grants(void) {
+    printf("📦 Credit is returned in batches\n");
+    HighWaterMark* h = hwm_create_marks(1000, 0, 200);
+    HighWaterMarkStats stats;
+
+    for (int i = 0; i < 8; ++i) hwm_try_acquire(h, 100);
+    for (int i = 0; i < 3; ++i) hwm_release(h, 60);
+    hwm_get_stats(h, &stats);
+    CHECK(stats.grants == 0, "releases below the batch size are accumulated");
+    hwm_release(h, 60);
+    hwm_get_stats(h, &stats);
+    CHECK(stats.grants == 1 && stats.outstanding == 560, "a full batch is granted at once");
+
+    hwm_set_marks(h, 2000, 0, 200);
+    hwm_get_stats(h, &stats);
+    CHECK(stats.high == 2000 && stats.outstanding == 560, "raising the high mark keeps the outstanding count");
+    hwm_destroy(h);
+
+    h = hwm_create(100);
+    CHECK(hwm_push(h, 80) && !hwm_is_overflow(h), "legacy push within capacity");
+    CHECK(!hwm_push(h, 30) && hwm_is_overflow(h), "legacy push past capacity overflows");
+    hwm_pop(h, 40);
+    CHECK(!hwm_is_overflow(h), "legacy pop clears the overflow");
+    hwm_destroy(h);
+}
+
+static void test_bus_lane_gate(void) {
+    printf("🚦 Bus lanes throttle with hysteresis\n");
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(4096, 1);
+    char msg[64];
+    memset(msg, 'x', sizeof(msg));
+
+    size_t accepted = 0;
+    while (accepted < 1000 && umsbb_submit_to(bus, 0, msg, sizeof(msg))) accepted++;
+    HighWaterMarkStats stats;
+    umsbb_get_backpressure_stats(bus, 0, &stats);
+    CHECK(accepted > 0 && accepted * BI_BUFFER_FRAME_SIZE(sizeof(msg)) <= stats.high + BI_BUFFER_FRAME_SIZE(sizeof(msg)),
+          "submissions stop at the high mark");
+    CHECK(stats.throttled && stats.throttleEvents == 1, "the lane reports a throttle episode");
+
+    size_t size;
+    umsbb_message_release(umsbb_drain_from(bus, 0, &size));
+    CHECK(!umsbb_submit_to(bus, 0, msg, sizeof(msg)), "one drained message does not reopen the lane");
+
+    size_t drained = 1;
+    while (stats.throttled && drained < accepted) {
+        umsbb_message_release(umsbb_drain_from(bus, 0, &size));
+        drained++;
+        umsbb_get_backpressure_stats(bus, 0, &stats);
+    }
+    CHECK(!stats.throttled && stats.outstanding <= stats.low, "the lane reopens once drained to the low mark");
+    CHECK(umsbb_submit_to(bus, 0, msg, sizeof(msg)), "submissions resume");
+
+    uint64_t start = now_ns();
+    while (umsbb_submit_to(bus, 0, msg, sizeof(msg))) {}
+    CHECK(!umsbb_submit_wait(bus, 0, msg, sizeof(msg), 2000000) && now_ns() - start >= 2000000,
+          "a blocking submit times out without a consumer");
+    umsbb_free(bus);
+}
+
+#define WAIT_MESSAGES 4000
+
+typedef struct {
+    UniversalMultiSegmentedBiBufferBus* bus;
+    size_t received;
+    bool ordered;
+} SlowConsumer;
+
+static void* slow_consumer_main(void* arg) {
+    SlowConsumer* c = arg;
+    uint32_t expect = 0;
+    while (c->received < WAIT_MESSAGES) {
+        if (!umsbb_wait(c->bus, 1000000)) continue;
+        size_t size;
+        void* data = umsbb_drain_from(c->bus, 0, &size);
+        if (!data) continue;
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        if (value != expect++) c->ordered = false;
+        umsbb_message_release(data);
+        if (++c->received % 256 == 0) sleep_ms(1);
+    }
+    message_pool_thread_flush();
+    return NULL;
+}
+
+static void test_submit_wait(void) {
+    printf("⏳ Blocking submits ride out a slow consumer\n");
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(4096, 1);
+    SlowConsumer consumer = { bus, 0, true };
+    pthread_t thread;
+    pthread_create(&thread, NULL, slow_consumer_main, &consumer);
+
+    bool submitted = true;
+    char msg[48] = {0};
+    for (uint32_t i = 0; i < WAIT_MESSAGES && submitted; ++i) {
+        memcpy(msg, &i, sizeof(i));
+        submitted = umsbb_submit_wait(bus, 0, msg, sizeof(msg), EVENT_WAIT_FOREVER);
+    }
+    pthread_join(thread, NULL);
+
+    HighWaterMarkStats stats;
+    umsbb_get_backpressure_stats(bus, 0, &stats);
+    CHECK(submitted && consumer.received == WAIT_MESSAGES && consumer.ordered, "every message delivered in order");
+    CHECK(stats.waits > 0 && stats.throttleEvents > 0, "the producer parked while the consumer lagged");
+    CHECK(stats.rejected <= stats.waits, "each parked submit was refused once, not retried");
+    CHECK(stats.grants < WAIT_MESSAGES / 4, "credit came back in batches");
+    CHECK(stats.outstanding == 0, "all credit returned after the drain");
+    printf("  ℹ️  waits %llu, throttle episodes %llu, grants %llu\n", (unsigned long long)stats.waits,
+           (unsigned long long)stats.throttleEvents, (unsigned long long)stats.grants);
+    umsbb_free(bus);
+}
+
+int main(void) {
+    printf("🧪 Backpressure Tests\n");
+    test_hysteresis();
+    test_batched_grants();
+    test_bus_lane_gate();
+    test_submit_wait();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All backpressure tests passed\n");
+    return 0;
+}
@@ -0,0 +1,404 @@
+#include "../include/batch_kernels.h"
+#include "../include/gpu_accelerated_buffer.h"
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test_check.h"
+
+static uint64_t rng = 88172645463325252ull;
+
+static uint64_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+static void test_byte_swaps(void) {
+    printf("🔀 Vector byte swaps match the scalar ones\n");
+    static uint8_t original[4096 + 16], vector[4096 + 16], scalar[4096 + 16];
+    for (size_t i = 0; i < sizeof(original); i++) original[i] = (uint8_t)next_random();
+    printf("     byte swaps on %s\n", batch_kernels_impl_name());
+
+    bool same = true, swapped = true;
+    void (*swaps[3])(uint8_t*, size_t) = { batch_bswap16, batch_bswap32, batch_bswap64 };
+    for (int w = 0; w < 3; w++) {
+        size_t width = (size_t)2 << w;
+        for (int round = 0; round < 200; round++) {
+            size_t offset = next_random() % 16;
+            size_t size = next_random() % 4096;
+            memcpy(vector, original, sizeof(original));
+            memcpy(scalar, original, sizeof(original));
+            swaps[w](vector + offset, size);
+            batch_kernels_force_scalar(true);
+            swaps[w](scalar + offset, size);
+            batch_kernels_force_scalar(false);
+            same &= memcmp(vector, scalar, sizeof(vector)) == 0;
+
+            // Word i's bytes are reversed; the tail is left alone
+            size_t words = size / width;
+            for (size_t i = 0; i < words * width; i++) {
+                size_t word = i / width, byte = i % width;
+                swapped &= vector[offset + i] == original[offset + word * width + (width - 1 - byte)];
+            }
+            swapped &= memcmp(vector + offset + words * width, original + offset + words * width,
+                              size - words * width) == 0;
+        }
+    }
+    CHECK(same, "every width, length and alignment agrees bit for bit");
+    CHECK(swapped, "each whole word is reversed and trailing bytes stay put");
+}
+
+static bool keep_even_lanes(const void* params, uint8_t* data, uint32_t* length, uint32_t lane) {
+    (void)params;
+    (void)data;
+    (void)length;
+    return lane % 2 == 0;
+}
+
+static bool increment(const void* params, uint8_t* data, uint32_t* length, uint32_t lane) {
+    (void)lane;
+    uint8_t step = params ? *(const uint8_t*)params : 1;
+    for (uint32_t i = 0; i < *length; i++) data[i] = (uint8_t)(data[i] + step);
+    return true;
+}
+
+static void test_registry(void) {
+    printf("🗂️ Kernels are registered and chained by id\n");
+    CHECK(batch_kernel_lookup(BATCH_KERNEL_BSWAP32) && batch_kernel_lookup(BATCH_KERNEL_PROJECT),
+          "the built-in kernels are there from the start");
+    CHECK(!batch_kernel_register(BATCH_KERNEL_BSWAP16, increment) && !batch_kernel_register(BATCH_KERNEL_MAX_ID, increment),
+          "built-in and out-of-range ids cannot be claimed");
+    CHECK(batch_kernel_register(BATCH_KERNEL_FIRST_USER, increment) && !batch_kernel_register(BATCH_KERNEL_FIRST_USER, increment),
+          "a user id is claimed once");
+
+    batch_kernel_chain_t chain;
+    batch_kernel_step_t steps[BATCH_KERNEL_MAX_CHAIN + 1] = { { BATCH_KERNEL_FIRST_USER + 1, NULL } };
+    CHECK(!batch_kernel_resolve(&chain, steps, 1), "a chain naming an unregistered id does not resolve");
+    CHECK(!batch_kernel_resolve(&chain, steps, BATCH_KERNEL_MAX_CHAIN + 1), "nor one that is too long");
+
+    batch_kernel_register(BATCH_KERNEL_FIRST_USER + 1, keep_even_lanes);
+    CHECK(batch_kernel_resolve(&chain, steps, 1) && chain.steps == 1, "once registered it does");
+    batch_kernel_unregister(BATCH_KERNEL_FIRST_USER + 1);
+    batch_kernel_unregister(BATCH_KERNEL_BSWAP16);
+    CHECK(!batch_kernel_lookup(BATCH_KERNEL_FIRST_USER + 1) && batch_kernel_lookup(BATCH_KERNEL_BSWAP16),
+          "user kernels can be unregistered, built-in ones cannot");
+}
+
+#define RECORDS 64
+
+static void test_process(void) {
+    printf("🧾 A batch is verified, then filtered and projected\n");
+    static uint8_t data[RECORDS * 64];
+    uint64_t offsets[RECORDS];
+    uint32_t lengths[RECORDS], lanes[RECORDS], checksums[RECORDS];
+    uint8_t policies[RECORDS], status[RECORDS];
+    for (uint32_t i = 0; i < RECORDS; i++) {
+        offsets[i] = i * 64;
+        lengths[i] = 64;
+        lanes[i] = i % 4;
+        policies[i] = (uint8_t)(i % 3);
+        for (uint32_t j = 0; j < 64; j++) data[i * 64 + j] = (uint8_t)(i + j);
+        checksums[i] = checksum_compute((checksum_policy_t)policies[i], data + offsets[i], lengths[i]);
+    }
+    // Policies FAST and STRONG catch a flipped bit; NONE does not look
+    data[1 * 64 + 5] ^= 0x10;
+    data[2 * 64 + 9] ^= 0x01;
+    data[3 * 64 + 9] ^= 0x01;
+
+    // Keep records whose first byte is even, then bytes 8..15 of them
+    batch_filter_t even = { 0, 0x01, 0x00 };
+    batch_projection_t middle = { 8, 8 };
+    batch_kernel_step_t steps[] = { { BATCH_KERNEL_FILTER, &even }, { BATCH_KERNEL_PROJECT, &middle } };
+    batch_kernel_chain_t chain;
+    batch_kernel_resolve(&chain, steps, 2);
+    uint32_t intact = batch_kernels_process(&chain, data, offsets, lengths, lanes, policies, checksums, status, RECORDS);
+
+    CHECK(status[1] == BATCH_RECORD_CORRUPT && status[2] == BATCH_RECORD_CORRUPT && status[3] != BATCH_RECORD_CORRUPT,
+          "corruption is caught under FAST and STRONG, unchecked under NONE");
+    bool filtered = true, projected = true;
+    uint32_t kept = 0;
+    for (uint32_t i = 4; i < RECORDS; i++) {
+        filtered &= (status[i] == BATCH_RECORD_FILTERED) == (i % 2 == 1);
+        if (status[i] != BATCH_RECORD_OK) continue;
+        kept++;
+        projected &= lengths[i] == 8 && data[offsets[i]] == (uint8_t)(i + 8) && data[offsets[i] + 7] == (uint8_t)(i + 15);
+    }
+    CHECK(filtered, "odd first bytes are filtered out");
+    CHECK(projected, "the rest are cut down to the projected bytes");
+    CHECK(intact == kept + (status[0] == BATCH_RECORD_OK) + (status[3] == BATCH_RECORD_OK), "intact records are counted");
+}
+
+typedef struct {
+    uint8_t* expected;          // Per tag: the result the CPU path produced
+    uint32_t* expected_lengths;
+    uint8_t* expected_status;
+    uint32_t results;
+    uint32_t corrupt;
+    uint32_t filtered;
+    bool identical;
+} compare_t;
+
+static void on_result(void* context, uint64_t tag, const void* data, size_t size, uint32_t lane_id) {
+    compare_t* compare = (compare_t*)context;
+    (void)lane_id;
+    compare->identical &= compare->expected_status[tag] == BATCH_RECORD_OK && size == compare->expected_lengths[tag] &&
+                          memcmp(data, compare->expected + tag * 256, size) == 0;
+    compare->results++;
+}
+
+static void on_reject(void* context, uint64_t tag, uint32_t lane_id, batch_record_status_t status) {
+    compare_t* compare = (compare_t*)context;
+    (void)lane_id;
+    compare->identical &= compare->expected_status[tag] == status;
+    if (status == BATCH_RECORD_CORRUPT) compare->corrupt++;
+    else compare->filtered++;
+}
+
+#define MESSAGES 5000
+
+static void test_pipeline_matches_cpu(void) {
+    printf("🚀 The pipeline's kernel gives the CPU path's results\n");
+    static uint8_t messages[MESSAGES][256], expected[MESSAGES * 256];
+    static uint32_t sizes[MESSAGES], checksums[MESSAGES], expected_lengths[MESSAGES];
+    static uint64_t offsets[MESSAGES];
+    static uint32_t lanes[MESSAGES];
+    static uint8_t policies[MESSAGES], expected_status[MESSAGES];
+    for (uint32_t i = 0; i < MESSAGES; i++) {
+        sizes[i] = 16 + (uint32_t)(next_random() % 240);
+        for (uint32_t j = 0; j < sizes[i]; j++) messages[i][j] = (uint8_t)next_random();
+        policies[i] = CHECKSUM_POLICY_STRONG;
+        checksums[i] = checksum_compute(CHECKSUM_POLICY_STRONG, messages[i], sizes[i]);
+        if (i % 97 == 0) checksums[i] ^= 1;
+        lanes[i] = i % 4;
+        offsets[i] = (uint64_t)i * 256;
+        expected_lengths[i] = sizes[i];
+        memcpy(expected + offsets[i], messages[i], sizes[i]);
+    }
+
+    batch_filter_t filter = { 3, 0x03, 0x01 };
+    batch_projection_t projection = { 4, 200 };
+    gpu_pipeline_config_t config;
+    gpu_pipeline_default_config(&config);
+    config.kernels[0] = (batch_kernel_step_t){ BATCH_KERNEL_FILTER, &filter };
+    config.kernels[1] = (batch_kernel_step_t){ BATCH_KERNEL_BSWAP32, NULL };
+    config.kernels[2] = (batch_kernel_step_t){ BATCH_KERNEL_PROJECT, &projection };
+    config.num_kernels = 3;
+
+    // Reference: one big batch through the kernels on this core
+    batch_kernel_chain_t chain;
+    batch_kernel_resolve(&chain, config.kernels, config.num_kernels);
+    batch_kernels_process(&chain, expected, offsets, expected_lengths, lanes, policies, checksums, expected_status, MESSAGES);
+
+    compare_t compare = { expected, expected_lengths, expected_status, 0, 0, 0, true };
+    config.staging_bytes = 64 * 1024;
+    config.on_result = on_result;
+    config.on_reject = on_reject;
+    config.context = &compare;
+    gpu_accelerated_buffer_t buffer;
+    gpu_buffer_init(&buffer, 1 << 16, GPU_PROCESSING_DISABLED);
+
+    config.kernels[2].id = BATCH_KERNEL_FIRST_USER + 7;
+    CHECK(gpu_pipeline_start(&buffer, &config) != 0, "a chain with an unknown kernel is refused at start");
+    config.kernels[2].id = BATCH_KERNEL_PROJECT;
+    CHECK(gpu_pipeline_start(&buffer, &config) == 0, "the pipeline starts with a three-kernel chain");
+
+    bool submitted = true;
+    for (uint32_t i = 0; i < MESSAGES; i++) {
+        submitted &= gpu_pipeline_submit_checked(&buffer, messages[i], sizes[i], lanes[i], i, CHECKSUM_POLICY_STRONG,
+                                                 checksums[i]) == 0;
+    }
+    gpu_pipeline_drain(&buffer);
+    CHECK(submitted, "every message is accepted");
+
+    uint32_t corrupt = 0, filtered = 0;
+    for (uint32_t i = 0; i < MESSAGES; i++) {
+        corrupt += expected_status[i] == BATCH_RECORD_CORRUPT;
+        filtered += expected_status[i] == BATCH_RECORD_FILTERED;
+    }
+    CHECK(compare.identical, "each result and status matches the CPU path's");
+    CHECK(compare.corrupt == corrupt && corrupt == (MESSAGES + 96) / 97 && compare.filtered == filtered &&
+          compare.results == MESSAGES - corrupt - filtered, "every message is accounted for once");
+    gpu_pipeline_stats_t stats;
+    gpu_pipeline_get_stats(&buffer, &stats);
+    CHECK(stats.messages_corrupt == corrupt && stats.messages_filtered == filtered, "rejections are counted");
+    gpu_buffer_cleanup(&buffer);
+}
+
+static void test_ring_lane_offload(void) {
+    printf("🚌 Ring lane messages are verified in GPU batches\n");
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(1 << 20, 2);
+    gpu_pipeline_config_t config;
+    gpu_pipeline_default_config(&config);
+    config.kernels[0] = (batch_kernel_step_t){ BATCH_KERNEL_BSWAP16, NULL };
+    config.num_kernels = 1;
+    CHECK(umsbb_drain_to_gpu(bus, 0, 10) == 0, "nothing moves without a coalescer");
+    CHECK(umsbb_enable_gpu_coalescing(bus, &config), "coalescing is enabled with a byte-swap kernel");
+
+    FeedbackCursor cursor;
+    umsbb_feedback_cursor(bus, 0, &cursor);
+    uint16_t words[64];
+    uint32_t sequences[300];
+    for (uint32_t i = 0; i < 300; i++) {
+        for (uint32_t j = 0; j < 64; j++) words[j] = (uint16_t)(i * 64 + j);
+        umsbb_reservation handle = umsbb_reserve(bus, 0, sizeof(words));
+        memcpy(handle.data, words, sizeof(words));
+        sequences[i] = handle.sequence;
+        uint8_t* frame = (uint8_t*)handle.data;
+        umsbb_commit(bus, &handle);
+        // One in fifty is damaged after its checksum was taken
+        if (i % 50 == 7) frame[3] ^= 0x40;
+    }
+
+    size_t moved = 0;
+    while (moved < 300) {
+        size_t n = umsbb_drain_to_gpu(bus, 0, 64);
+        if (n == 0) break;
+        moved += n;
+    }
+    size_t size;
+    CHECK(moved == 300 && !umsbb_drain_from(bus, 0, &size), "the lane is emptied into the coalescer");
+
+    uint32_t drained = 0;
+    bool swapped = true, intact = true, unprioritised = true;
+    bool seen[300] = { false };
+    for (int spins = 0; drained < 294 && spins < 20000; spins++) {
+        uint32_t priority;
+        uint8_t* message = (uint8_t*)umsbb_fast_lane_drain(bus, LANE_BULK, &size, &priority);
+        if (!message) {
+            usleep(100);
+            continue;
+        }
+        // Each message starts with its index * 64, byte-swapped by the kernel
+        uint32_t index = (((uint32_t)message[0] << 8) | message[1]) / 64;
+        uint16_t second = (uint16_t)(index * 64 + 1);
+        swapped &= size == sizeof(words) && message[2] == (uint8_t)(second >> 8) && message[3] == (uint8_t)second;
+        intact &= index < 300 && index % 50 != 7 && !seen[index];
+        if (index < 300) seen[index] = true;
+        unprioritised &= priority == 0;
+        drained++;
+        umsbb_message_release(message);
+    }
+    CHECK(drained == 294 && intact, "the intact messages reach the bulk lane once each");
+    CHECK(swapped, "byte-swapped by the kernel");
+    CHECK(unprioritised, "ring lane messages carry no priority there");
+
+    FeedbackEntry entries[FEEDBACK_RING_CAPACITY];
+    size_t read = umsbb_read_feedback(bus, 0, &cursor, entries, FEEDBACK_RING_CAPACITY);
+    uint32_t corrupt = 0;
+    bool known = true;
+    for (size_t i = 0; i < read; i++) {
+        if (entries[i].type != FEEDBACK_CORRUPTED) continue;
+        uint32_t index = 0;
+        while (index < 300 && sequences[index] != entries[i].sequence) index++;
+        known &= index % 50 == 7;
+        corrupt++;
+    }
+    CHECK(corrupt == 6 && known, "each damaged message is reported corrupt on its ring lane");
+    umsbb_free(bus);
+}
+
+static void test_full_result_lane(void) {
+    printf("🚧 Results wait for a full bulk lane instead of being dropped\n");
+    fast_lane_config_t lanes[LANE_COUNT];
+    fast_lane_default_config(lanes);
+    lanes[LANE_BULK].capacity = 16;
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init_with_lanes(1 << 16, 2, lanes);
+    CHECK(umsbb_enable_gpu_coalescing(bus, NULL), "coalescing is enabled");
+
+    uint32_t record[8] = { 0 };
+    for (uint32_t i = 0; i < 200; i++) {
+        record[0] = i;
+        umsbb_submit_to(bus, 0, (const char*)record, sizeof(record));
+    }
+    size_t moved = 0, n;
+    while ((n = umsbb_drain_to_gpu(bus, 0, 64)) > 0) moved += n;
+    // Every batch is delivered into a lane that holds 16
+    umsbb_disable_gpu_coalescing(bus);
+    CHECK(moved == 200 && atomic_load_size(&bus->gpu_spill[LANE_BULK].count) == 200 - 16,
+          "the results the lane has no room for are spilled");
+
+    bool seen[200] = { false };
+    uint32_t drained = 0;
+    bool once = true;
+    size_t size;
+    void* message;
+    while ((message = umsbb_fast_lane_drain(bus, LANE_BULK, &size, NULL)) != NULL) {
+        uint32_t index;
+        memcpy(&index, message, sizeof(index));
+        once &= size == sizeof(record) && index < 200 && !seen[index];
+        if (index < 200) seen[index] = true;
+        drained++;
+        umsbb_message_release(message);
+    }
+    CHECK(drained == 200 && once, "and every one reaches the lane as it drains");
+    umsbb_free(bus);
+}
+
+typedef struct {
+    atomic_size_t delivered;
+    size_t lane[100];
+    uint32_t sequence[100];
+} result_labels;
+
+static void record_label(void* context, size_t lane, uint32_t sequence, const void* data, size_t size) {
+    result_labels* labels = (result_labels*)context;
+    uint32_t index;
+    memcpy(&index, data, sizeof(index));
+    if (size != 32 || index >= 100) return;
+    labels->lane[index] = lane;
+    labels->sequence[index] = sequence;
+    atomic_fetch_add_size(&labels->delivered, 1);
+}
+
+static void test_labelled_results(void) {
+    printf("🏷️  The result handler learns each message's ring lane and sequence\n");
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(1 << 16, 2);
+    static result_labels labels;
+    atomic_store_size(&labels.delivered, 0);
+    CHECK(umsbb_set_gpu_result_handler(bus, record_label, &labels), "the handler is set");
+    CHECK(umsbb_enable_gpu_coalescing(bus, NULL), "coalescing is enabled");
+    CHECK(!umsbb_set_gpu_result_handler(bus, NULL, NULL), "not while coalescing");
+
+    uint32_t record[8] = { 0 };
+    uint32_t sequences[100];
+    for (uint32_t i = 0; i < 100; i++) {
+        record[0] = i;
+        umsbb_reservation handle = umsbb_reserve(bus, i % 2, sizeof(record));
+        memcpy(handle.data, record, sizeof(record));
+        sequences[i] = handle.sequence;
+        umsbb_commit(bus, &handle);
+    }
+    size_t moved = umsbb_drain_to_gpu(bus, 0, 100) + umsbb_drain_to_gpu(bus, 1, 100);
+    umsbb_disable_gpu_coalescing(bus);
+
+    bool labelled = true;
+    for (uint32_t i = 0; i < 100; i++) {
+        labelled &= labels.lane[i] == i % 2 && labels.sequence[i] == sequences[i];
+    }
+    size_t size;
+    CHECK(moved == 100 && atomic_load_size(&labels.delivered) == 100, "every moved message reaches the handler");
+    CHECK(labelled, "with the lane and sequence it was committed under");
+    CHECK(!umsbb_fast_lane_drain(bus, LANE_BULK, &size, NULL), "and none goes to the bulk lane");
+    umsbb_free(bus);
+}
+
+int main(void) {
+    printf("🧪 Batch Kernel Tests\n");
+    test_byte_swaps();
+    test_registry();
+    test_process();
+    test_pipeline_matches_cpu();
+    test_ring_lane_offload();
+    test_full_result_lane();
+    test_labelled_results();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All batch kernel tests passed\n");
+    return 0;
+}
@@ -0,0 +1,376 @@
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "test_check.h"
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_us(long us) {
+    struct timespec ts = { us / 1000000, (us % 1000000) * 1000L };
+    nanosleep(&ts, NULL);
+}
+
+#define SINK_PREFIX 16                      // Keeps payloads as aligned as ring frames
+
+// Frames a SubmitBatcher committed, laid end to end
+typedef struct {
+    _Alignas(16) uint8_t data[64 * 1024];
+    size_t used;
+    size_t frames;
+    bool refuse;
+} sink_t;
+
+static bool sink_commit(void* context, size_t lane, const void* frame, size_t size, uint32_t count) {
+    sink_t* sink = context;
+    (void)lane;
+    (void)count;
+    if (sink->refuse || sink->used + SINK_PREFIX + size > sizeof(sink->data)) return false;
+    uint32_t length = (uint32_t)size;
+    memcpy(sink->data + sink->used, &length, sizeof(length));
+    memcpy(sink->data + sink->used + SINK_PREFIX, frame, size);
+    sink->used += SINK_PREFIX + ((size + 15) & ~(size_t)15);
+    sink->frames++;
+    return true;
+}
+
+// The nth committed frame's payload
+static const uint8_t* sink_frame(const sink_t* sink, size_t n, size_t* size) {
+    size_t at = 0;
+    for (;;) {
+        uint32_t length;
+        if (at >= sink->used) return NULL;
+        memcpy(&length, sink->data + at, sizeof(length));
+        if (n-- == 0) {
+            *size = length;
+            return sink->data + at + SINK_PREFIX;
+        }
+        at += SINK_PREFIX + ((length + 15) & ~(size_t)15);
+    }
+}
+
+static void push_target(SubmitBatcher* batcher, int rounds) {
+    // A consumer half a ring behind
+    for (int i = 0; i < rounds; i++) submit_batcher_observe(batcher, 32768, 65536, 0);
+}
+
+static void test_staging(void) {
+    printf("📦 Staging and commit triggers\n");
+    sink_t* sink = calloc(1, sizeof(sink_t));
+    SubmitBatchConfig config = { .max_records = 8, .max_bytes = 1024, .max_record = 256, .max_delay_ns = 1000000000ull };
+    SubmitBatcher* batcher = submit_batcher_create(0, &config, sink_commit, sink);
+
+    char msg[512] = { 0 };
+    memset(msg, 'm', sizeof(msg));
+    CHECK(submit_batcher_submit(batcher, msg, 16) == SUBMIT_BATCH_DIRECT, "a new batcher sends everything directly");
+
+    push_target(batcher, 8);
+    SubmitBatchStats stats;
+    submit_batcher_get_stats(batcher, &stats);
+    CHECK(stats.target == 8, "a lagging consumer grows the batch to max_records");
+
+    int staged = 1;
+    for (int i = 0; i < 7; i++) {
+        snprintf(msg, sizeof(msg), "record-%d", i);
+        staged &= submit_batcher_submit(batcher, msg, strlen(msg) + 1) == SUBMIT_BATCH_STAGED;
+    }
+    CHECK(staged && sink->frames == 0, "messages below the target wait in the stage");
+    submit_batcher_submit(batcher, "record-7", 9);
+    size_t size = 0;
+    const uint8_t* frame = sink_frame(sink, 0, &size);
+    CHECK(sink->frames == 1 && frame && submit_batch_frame_valid(frame, size), "the eighth commits one well-formed frame");
+    const SubmitBatchHeader* header = (const SubmitBatchHeader*)frame;
+    const SubmitRecord* third = submit_batch_record(frame, sizeof(SubmitBatchHeader) + 2 * SUBMIT_BATCH_RECORD_SIZE(9));
+    CHECK(header->count == 8 && third->index == 2 && strcmp((const char*)(third + 1), "record-2") == 0,
+          "records keep their order and payload");
+
+    // 224 bytes a record: four fit in 1024 with the header
+    for (int i = 0; i < 5; i++) submit_batcher_submit(batcher, msg, 200);
+    CHECK(sink->frames == 2, "a frame that would outgrow max_bytes goes first");
+
+    submit_batcher_submit(batcher, msg, 8);
+    CHECK(submit_batcher_submit(batcher, msg, 300) == SUBMIT_BATCH_DIRECT && sink->frames == 3,
+          "a message over max_record flushes the stage and goes directly");
+
+    sink->refuse = true;
+    for (int i = 0; i < 4; i++) submit_batcher_submit(batcher, msg, 200);
+    CHECK(submit_batcher_submit(batcher, msg, 200) == SUBMIT_BATCH_REFUSED,
+          "a full stage the lane refuses refuses the next message");
+    sink->refuse = false;
+    CHECK(submit_batcher_flush(batcher, false) == 1, "an explicit flush commits what was kept");
+
+    submit_batcher_destroy(batcher);
+    free(sink);
+}
+
+static void test_deadline_and_shrink(void) {
+    printf("⏱️ Deadline and shrinking\n");
+    sink_t* sink = calloc(1, sizeof(sink_t));
+    SubmitBatchConfig config = { .max_records = 64, .max_bytes = 8192, .max_record = 256, .max_delay_ns = 2000000 };
+    SubmitBatcher* batcher = submit_batcher_create(0, &config, sink_commit, sink);
+    push_target(batcher, 8);
+
+    submit_batcher_submit(batcher, "late", 5);
+    CHECK(submit_batcher_flush(batcher, true) == 0, "a stage inside its deadline is not swept");
+    sleep_us(3000);
+    CHECK(submit_batcher_flush(batcher, true) == 1, "a sweep commits it once the deadline has passed");
+    SubmitBatchStats stats;
+    submit_batcher_get_stats(batcher, &stats);
+    CHECK(stats.deadline_flushes == 1 && stats.records == 1, "the deadline flush is counted");
+
+    // End-to-end slow frames push as hard as a lagging consumer
+    submit_batcher_observe(batcher, 0, 65536, 0);
+    size_t before = atomic_load_size(&batcher->target);
+    submit_batcher_observe(batcher, 0, 65536, 4000000);
+    CHECK(atomic_load_size(&batcher->target) > before, "frames queued past the deadline grow the batch");
+
+    for (int i = 0; i < 16; i++) submit_batcher_observe(batcher, 0, 65536, 1000);
+    submit_batcher_get_stats(batcher, &stats);
+    CHECK(stats.target == 1, "a consumer that keeps up shrinks it back to direct submits");
+    CHECK(submit_batcher_submit(batcher, "now", 4) == SUBMIT_BATCH_DIRECT, "at a target of 1 nothing is staged");
+
+    SubmitBatchConfig off = config;
+    off.max_records = 0;
+    submit_batcher_configure(batcher, &off);
+    push_target(batcher, 8);
+    CHECK(submit_batcher_submit(batcher, "off", 4) == SUBMIT_BATCH_DIRECT, "max_records 0 keeps it off under load");
+
+    submit_batcher_destroy(batcher);
+    free(sink);
+}
+
+static void test_frame_validation(void) {
+    printf("🧪 Frame validation\n");
+    sink_t* sink = calloc(1, sizeof(sink_t));
+    SubmitBatcher* batcher = submit_batcher_create(0, NULL, sink_commit, sink);
+    push_target(batcher, 8);
+    for (int i = 0; i < 3; i++) submit_batcher_submit(batcher, "abcdefgh", 8);
+    submit_batcher_flush(batcher, false);
+
+    size_t size = 0;
+    uint8_t* frame = (uint8_t*)sink_frame(sink, 0, &size);
+    CHECK(frame && submit_batch_frame_valid(frame, size), "a committed frame is valid");
+    CHECK(!submit_batch_frame_valid(frame, size - 16), "a truncated frame is not");
+    SubmitRecord* second = (SubmitRecord*)(frame + sizeof(SubmitBatchHeader) + SUBMIT_BATCH_RECORD_SIZE(8));
+    second->length = 4000;
+    CHECK(!submit_batch_frame_valid(frame, size), "a record running past the frame is not");
+    second->length = 8;
+    ((SubmitBatchHeader*)frame)->count = 2;
+    CHECK(!submit_batch_frame_valid(frame, size), "a wrong record count is not");
+
+    submit_batcher_destroy(batcher);
+    free(sink);
+}
+
+// Submit filler until a quarter of the lane is queued, then retire a few
+// frames so the consumer reports its lag
+static size_t build_lag(UniversalMultiSegmentedBiBufferBus* bus, size_t* drained) {
+    char filler[48];
+    memset(filler, 'f', sizeof(filler));
+    size_t sent = 0;
+    while (bi_buffer_backlog(bus->ring.buffers[0]) < 24 * 1024 && umsbb_submit_to(bus, 0, filler, sizeof(filler))) sent++;
+    for (int i = 0; i < 12; i++) {
+        size_t size;
+        umsbb_message_release(umsbb_drain_from(bus, 0, &size));
+        (*drained)++;
+    }
+    return sent;
+}
+
+static void test_bus_lane(void) {
+    printf("🚌 Batched ring lane\n");
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(65536, 1);
+    SubmitBatchConfig config;
+    submit_batch_default_config(&config);
+    config.max_delay_ns = 50000000; // Long enough not to fire on its own here
+    CHECK(umsbb_configure_batching(bus, 0, &config), "batching is configured per lane");
+
+    size_t drained = 0;
+    size_t filler = build_lag(bus, &drained);
+    SubmitBatchStats stats;
+    umsbb_get_batching_stats(bus, 0, &stats);
+    CHECK(stats.target == config.max_records && stats.frames == 0, "consumer lag raises the lane's batch size");
+
+    char msg[32];
+    for (int i = 0; i < 100; i++) {
+        int n = snprintf(msg, sizeof(msg), "tagged-%03d", i);
+        umsbb_submit_to(bus, 0, msg, (size_t)n + 1);
+    }
+    umsbb_get_batching_stats(bus, 0, &stats);
+    CHECK(stats.frames == 3 && stats.records == 96, "100 small submits commit as three full frames");
+    CHECK(umsbb_flush_batches(bus, 0) == 1, "the rest is flushed on request");
+
+    // Drain in batches of 10, which cut frames of 32 records apart
+    umsbb_msg_view views[10];
+    size_t plain = 0, expected = 0;
+    uint32_t last = 0;
+    bool ordered = true, first = true, prefix = false;
+    for (;;) {
+        size_t n = umsbb_drain_batch(bus, 0, views, 10);
+        if (n == 0) break;
+        // Release part of a batch that starts inside a frame; the rest comes again
+        size_t keep = n;
+        if (!prefix && expected > 0 && n > 3) keep = 3;
+        for (size_t i = 0; i < keep; i++) {
+            if (!first && views[i].sequence != last + 1) ordered = false;
+            first = false;
+            last = views[i].sequence;
+            if (((const char*)views[i].data)[0] == 'f') {
+                plain++;
+                if (expected > 0) ordered = false;
+            } else {
+                snprintf(msg, sizeof(msg), "tagged-%03zu", expected++);
+                if (strcmp(msg, views[i].data) != 0) ordered = false;
+            }
+        }
+        umsbb_release_batch(bus, 0, views, keep);
+        if (keep != n) {
+            umsbb_msg_view again;
+            snprintf(msg, sizeof(msg), "tagged-%03zu", expected);
+            prefix = umsbb_drain_view(bus, 0, &again) && again.sequence == last + 1 && strcmp(msg, again.data) == 0;
+        }
+    }
+    CHECK(plain + drained == filler && expected == 100, "every message is drained once");
+    CHECK(ordered, "records come out in submit order with consecutive sequences");
+    CHECK(prefix, "releasing part of a batch leaves the rest at the head");
+
+    // Each message is drained as soon as it is committed
+    for (int i = 0; i < 8; i++) {
+        size_t size;
+        umsbb_submit_to(bus, 0, "x", 2);
+        umsbb_flush_batches(bus, 0);
+        umsbb_message_release(umsbb_drain_from(bus, 0, &size));
+    }
+    umsbb_get_batching_stats(bus, 0, &stats);
+    CHECK(stats.target == 1, "a consumer that keeps up turns batching back off");
+    umsbb_free(bus);
+}
+
+static void test_bus_deadline(void) {
+    printf("⌛ Deadline on a waiting consumer\n");
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(65536, 1);
+    SubmitBatchConfig config;
+    submit_batch_default_config(&config);
+    config.max_delay_ns = 2000000;
+    umsbb_configure_batching(bus, 0, &config);
+
+    size_t drained = 0;
+    size_t filler = build_lag(bus, &drained);
+    char big[1024];
+    memset(big, 'B', sizeof(big));
+    umsbb_submit_to(bus, 0, "one", 4);
+    umsbb_submit_to(bus, 0, "two", 4);
+    CHECK(umsbb_submit_to(bus, 0, big, sizeof(big)), "a message over max_record is accepted directly");
+    umsbb_submit_to(bus, 0, "three", 6);
+
+    for (size_t i = drained; i < filler; i++) {
+        size_t size;
+        umsbb_message_release(umsbb_drain_from(bus, 0, &size));
+    }
+    size_t size = 0;
+    void* msg = umsbb_drain_from(bus, 0, &size);
+    bool order = msg && strcmp(msg, "one") == 0;
+    umsbb_message_release(msg);
+    msg = umsbb_drain_from(bus, 0, &size);
+    order &= msg && strcmp(msg, "two") == 0;
+    umsbb_message_release(msg);
+    msg = umsbb_drain_from(bus, 0, &size);
+    order &= msg && size == sizeof(big);
+    umsbb_message_release(msg);
+    CHECK(order, "a direct message follows the ones its thread had staged");
+
+    uint64_t start = now_ns();
+    bool woke = umsbb_wait(bus, 1000000000ull);
+    uint64_t waited = now_ns() - start;
+    msg = umsbb_drain_from(bus, 0, &size);
+    CHECK(woke && msg && strcmp(msg, "three") == 0, "umsbb_wait delivers a staged message at its deadline");
+    CHECK(waited < 500000000ull, "... without sleeping the whole timeout");
+    umsbb_message_release(msg);
+
+    SubmitBatchStats stats;
+    umsbb_get_batching_stats(bus, 0, &stats);
+    CHECK(stats.deadline_flushes == 1, "the sweep is counted");
+    CHECK(umsbb_configure_batching(bus, 0, &(SubmitBatchConfig){ 0 }) && umsbb_submit_to(bus, 0, "x", 2) &&
+          umsbb_wait(bus, 0), "turned off, submits reach the lane at once");
+    umsbb_free(bus);
+}
+
+#define PRODUCERS 4
+#define PER_PRODUCER 5000
+
+typedef struct {
+    UniversalMultiSegmentedBiBufferBus* bus;
+    uint32_t id;
+} producer_arg;
+
+static void* producer(void* p) {
+    producer_arg* arg = p;
+    for (uint32_t i = 0; i < PER_PRODUCER; i++) {
+        uint32_t msg[2] = { arg->id, i };
+        while (!umsbb_submit_to(arg->bus, 0, (const char*)msg, sizeof(msg))) sched_yield();
+    }
+    return NULL;
+}
+
+static void test_concurrent_producers(void) {
+    printf("🧵 Concurrent producers\n");
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(65536, 1);
+    umsbb_configure_lane_mode(bus, 0, BI_BUFFER_MODE_MPSC);
+    umsbb_configure_batching(bus, 0, NULL);
+
+    pthread_t threads[PRODUCERS];
+    producer_arg args[PRODUCERS];
+    for (uint32_t i = 0; i < PRODUCERS; i++) {
+        args[i].bus = bus;
+        args[i].id = i;
+        pthread_create(&threads[i], NULL, producer, &args[i]);
+    }
+
+    // Producers that finish with messages staged are swept by the deadline
+    uint32_t next[PRODUCERS] = { 0 };
+    size_t received = 0;
+    bool ordered = true;
+    uint64_t start = now_ns();
+    while (received < PRODUCERS * PER_PRODUCER && now_ns() - start < 20000000000ull) {
+        size_t size;
+        uint32_t* msg = umsbb_drain_from(bus, 0, &size);
+        if (!msg) {
+            umsbb_wait(bus, 1000000);
+            continue;
+        }
+        if (size != 2 * sizeof(uint32_t) || msg[0] >= PRODUCERS || msg[1] != next[msg[0]]) ordered = false;
+        else next[msg[0]]++;
+        received++;
+        umsbb_message_release(msg);
+    }
+    for (int i = 0; i < PRODUCERS; i++) pthread_join(threads[i], NULL);
+
+    CHECK(received == PRODUCERS * PER_PRODUCER, "every message arrives");
+    CHECK(ordered, "each producer's messages stay in order");
+    umsbb_free(bus);
+}
+
+int main(void) {
+    printf("🧪 Submit Batching Tests\n");
+    printf("========================\n");
+
+    test_staging();
+    test_deadline_and_shrink();
+    test_frame_validation();
+    test_bus_lane();
+    test_bus_deadline();
+    test_concurrent_producers();
+
+    if (failures) {
+        printf("\n❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✅ All submit batching tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "../include/capsule.h"
+#include "../include/checksum_engine.h"
+#include <stdio.h>
+#include <string.h>
+#include "test_check.h"
+
+static uint8_t data[4096 + 64];
+
+static void test_known_vectors(void) {
+    printf("📐 CRC32C reference vectors\n");
+    CHECK(checksum_crc32c("123456789", 9) == 0xE3069283u, "\"123456789\" -> 0xE3069283");
+    CHECK(checksum_crc32c("", 0) == 0, "empty input -> 0");
+
+    uint8_t zeros[32] = {0};
+    CHECK(checksum_crc32c(zeros, sizeof(zeros)) == 0x8A9136AAu, "32 zero bytes -> 0x8A9136AA");
+}
+
+// Every vector path must agree with scalar so mixed-CPU peers interoperate
+static void test_implementations_agree(void) {
+    printf("🧮 Vector paths match scalar (crc32c: %s, fast: %s)\n",
+           checksum_impl_name(checksum_crc32c_impl()), checksum_impl_name(checksum_fast_impl()));
+
+    const checksum_impl_t impls[] = {
+        CHECKSUM_IMPL_SSE2, CHECKSUM_IMPL_SSE42, CHECKSUM_IMPL_AVX2,
+        CHECKSUM_IMPL_ARMV8_CRC, CHECKSUM_IMPL_WASM_SIMD128
+    };
+    int mismatches = 0;
+    // Odd offsets and lengths exercise unaligned loads, tails and block scrambles
+    for (size_t offset = 0; offset < 3; ++offset) {
+        for (size_t len = 0; len <= 4096; len += (len < 200 ? 1 : 61)) {
+            checksum_force_impl(CHECKSUM_IMPL_SCALAR);
+            uint32_t crc = checksum_crc32c(data + offset, len);
+            uint64_t fast = checksum_fast64(data + offset, len);
+            for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); ++i) {
+                if (!checksum_force_impl(impls[i])) continue;
+                if (checksum_crc32c(data + offset, len) != crc) mismatches++;
+                if (checksum_fast64(data + offset, len) != fast) mismatches++;
+            }
+        }
+    }
+    CHECK(mismatches == 0, "all available implementations produce identical results");
+}
+
+static void test_policies(void) {
+    printf("🛡️ Checksum policies\n");
+    CHECK(checksum_compute(CHECKSUM_POLICY_NONE, data, 100) == 0, "NONE computes nothing");
+    CHECK(checksum_verify(CHECKSUM_POLICY_NONE, data, 100, 12345), "NONE always verifies");
+    CHECK(checksum_compute(CHECKSUM_POLICY_STRONG, data, 100) == checksum_crc32c(data, 100), "STRONG is CRC32C");
+
+    uint32_t fast = checksum_compute(CHECKSUM_POLICY_FAST, data, 100);
+    data[50] ^= 0x01;
+    CHECK(!checksum_verify(CHECKSUM_POLICY_FAST, data, 100, fast), "FAST detects a single bit flip");
+    data[50] ^= 0x01;
+    CHECK(checksum_verify(CHECKSUM_POLICY_FAST, data, 100, fast), "FAST verifies the original data");
+
+    // Zero padding of the final stripe must not make lengths collide
+    uint8_t zeros[64] = {0};
+    CHECK(checksum_fast64(zeros, 10) != checksum_fast64(zeros, 11), "trailing zeros change the hash");
+}
+
+static void test_capsule_roundtrip(void) {
+    printf("💊 Capsule wrap and validate\n");
+    char msg[] = "capsule payload";
+    MessageCapsule cap;
+    capsule_wrap(&cap, 7, msg, sizeof(msg));
+    CHECK(capsule_validate(&cap), "wrapped capsule validates");
+
+    msg[0] = 'C';
+    CHECK(!capsule_validate(&cap), "modified payload is rejected");
+}
+
+int main(void) {
+    printf("🧪 Capsule and Checksum Engine Tests\n");
+    printf("====================================\n");
+
+    uint32_t x = 0x12345678u;
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        data[i] = (uint8_t)x;
+    }
+
+    test_known_vectors();
+    test_implementations_agree();
+    test_policies();
+    test_capsule_roundtrip();
+
+    if (failures) {
+        printf("\n❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✅ All capsule tests passed!\n");
+    return 0;
+}
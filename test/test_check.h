@@ -0,0 +1,13 @@
+#pragma once
+#include <stdio.h>
+
+/*
+ * Check harness shared by the tests: CHECK prints each result and counts the
+ * failures, which main reports and turns into the exit status.
+ */
+static int failures = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { printf("  ✅ %s\n", msg); } \
+    else { printf("  ❌ %s\n", msg); failures++; } \
+} while (0)
@@ -0,0 +1,105 @@
+#include "../include/umsbb_clock.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "test_check.h"
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static int64_t skew(void) {
+    return (int64_t)(umsbb_clock_ns() - umsbb_clock_os_ns());
+}
+
+static int64_t magnitude(int64_t v) { return v < 0 ? -v : v; }
+
+static void test_calibration(void) {
+    printf("⏰ Fast clock tracks the OS monotonic clock\n");
+    umsbb_clock_init();
+    const char* source = umsbb_clock_source();
+    printf("  ℹ️  source: %s\n", source);
+    CHECK(source && strlen(source) > 0, "a clock source is selected");
+    CHECK(magnitude(skew()) < 100000, "fast and OS clocks agree right after calibration");
+
+    uint64_t start = umsbb_clock_ns(), osStart = umsbb_clock_os_ns();
+    sleep_ms(20);
+    uint64_t elapsed = umsbb_clock_ns() - start, osElapsed = umsbb_clock_os_ns() - osStart;
+    CHECK(magnitude((int64_t)(elapsed - osElapsed)) < (int64_t)(osElapsed / 100), "measured intervals match within 1 %");
+    CHECK(umsbb_clock_us() >= start / 1000 + 20000, "microseconds are on the same timeline");
+}
+
+static void test_monotonic(void) {
+    printf("📈 Reads never go backwards on a thread\n");
+    uint64_t last = umsbb_clock_ns();
+    bool monotonic = true;
+    for (int i = 0; i < 1000000; ++i) {
+        uint64_t now = umsbb_clock_ns();
+        if (now < last) monotonic = false;
+        last = now;
+    }
+    CHECK(monotonic, "a million back-to-back reads are non-decreasing");
+}
+
+static void test_refinement(void) {
+    printf("🎯 Refinement after a second does not step the clock\n");
+    // Straddle the refinement point with dense reads
+    uint64_t last = umsbb_clock_ns();
+    uint64_t deadline = umsbb_clock_os_ns() + 1200000000ull;
+    bool monotonic = true;
+    while (umsbb_clock_os_ns() < deadline) {
+        uint64_t now = umsbb_clock_ns();
+        if (now < last) monotonic = false;
+        last = now;
+        sleep_ms(1);
+    }
+    CHECK(monotonic, "no backward step across the refinement");
+    CHECK(magnitude(skew()) < 200000, "still within 200 us of the OS clock");
+}
+
+static void test_coarse(void) {
+    printf("🐢 Coarse clock for non-critical fields\n");
+    uint64_t coarse = umsbb_clock_coarse_ns();
+    uint64_t fine = umsbb_clock_ns();
+    CHECK(coarse <= fine + 1000000 && fine - coarse < 20000000ull, "coarse time trails fine time by at most a few ticks");
+    sleep_ms(30);
+    CHECK(umsbb_clock_coarse_ns() - coarse >= 20000000ull, "coarse time advances");
+}
+
+static void* reader_main(void* arg) {
+    uint64_t* out = arg;
+    *out = umsbb_clock_ns();
+    return NULL;
+}
+
+static void test_threads(void) {
+    printf("🧵 Other threads share the timeline\n");
+    uint64_t before = umsbb_clock_ns();
+    uint64_t seen[4];
+    pthread_t threads[4];
+    for (int i = 0; i < 4; ++i) pthread_create(&threads[i], NULL, reader_main, &seen[i]);
+    for (int i = 0; i < 4; ++i) pthread_join(threads[i], NULL);
+    uint64_t after = umsbb_clock_ns();
+    bool within = true;
+    for (int i = 0; i < 4; ++i) within &= seen[i] + 1000 >= before && seen[i] <= after + 1000;
+    CHECK(within, "reads from other threads fall between this thread's reads");
+}
+
+int main(void) {
+    printf("🧪 Clock Tests\n");
+    test_calibration();
+    test_monotonic();
+    test_refinement();
+    test_coarse();
+    test_threads();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All clock tests passed\n");
+    return 0;
+}
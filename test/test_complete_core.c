@@ -0,0 +1,363 @@
+#include "../include/umsbb_api.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "test_check.h"
+
+// A 1 MB buffer: eight 128 KB segments
+#define CORE_TEST_MB 1
+#define WRAP_MESSAGE 1000       // 64 B header + 1000, aligned: 1088 B records, 120 to a segment
+
+static void fill_message(uint8_t* message, uint32_t id, uint32_t size) {
+    memcpy(message, &id, sizeof(id));
+    for (uint32_t i = sizeof(id); i < size; i++) message[i] = (uint8_t)(id + i);
+}
+
+static bool message_intact(const uint8_t* message, uint32_t size, uint32_t* id) {
+    if (size < sizeof(*id)) return false;
+    memcpy(id, message, sizeof(*id));
+    for (uint32_t i = sizeof(*id); i < size; i++) {
+        if (message[i] != (uint8_t)(*id + i)) return false;
+    }
+    return true;
+}
+
+static void test_wrap_and_padding(void) {
+    printf("🔁 Segments wrap over padding records and reuse the space\n");
+    umsbb_handle_t handle = umsbb_create_buffer(CORE_TEST_MB);
+    CHECK(handle != 0, "buffer is created");
+
+    // 4000 records of 1088 B go round every segment several times; none
+    // divides the segment, so each lap ends in a padding record
+    static uint8_t message[WRAP_MESSAGE], out[WRAP_MESSAGE];
+    static bool seen[4000];
+    bool written = true, intact = true;
+    uint32_t read = 0;
+    for (uint32_t round = 0; round < 40; round++) {
+        for (uint32_t i = 0; i < 100; i++) {
+            fill_message(message, round * 100 + i, WRAP_MESSAGE);
+            written &= umsbb_write_message(handle, message, WRAP_MESSAGE) == UMSBB_SUCCESS;
+        }
+        uint32_t size, id;
+        while (umsbb_read_message(handle, out, sizeof(out), &size) == UMSBB_SUCCESS) {
+            bool ok = size == WRAP_MESSAGE && message_intact(out, size, &id) && id < 4000 && !seen[id];
+            if (ok) seen[id] = true;
+            intact &= ok;
+            read++;
+        }
+    }
+    CHECK(written && read == 4000 && intact, "every message comes back once, intact, across the wraps");
+    CHECK(umsbb_get_pending_messages(handle) == 0, "nothing is left pending");
+
+    // A padding record at most costs one record's worth of a segment
+    uint32_t filled = 0;
+    fill_message(message, 0, WRAP_MESSAGE);
+    while (umsbb_write_message(handle, message, WRAP_MESSAGE) == UMSBB_SUCCESS) filled++;
+    CHECK(filled >= UMSBB_SEGMENT_COUNT * 119, "the drained buffer holds a full load again");
+    uint32_t size;
+    uint32_t drained = 0;
+    while (umsbb_read_message(handle, out, sizeof(out), &size) == UMSBB_SUCCESS) drained++;
+    CHECK(drained == filled, "and gives all of it back");
+
+    umsbb_destroy_buffer(handle);
+}
+
+static uint32_t active_buffers(void) {
+    uint32_t active;
+    umsbb_get_system_info(&active, NULL, NULL, NULL);
+    return active;
+}
+
+static void test_handle_reuse(void) {
+    printf("🎫 Handles are recycled with a new generation\n");
+    uint8_t message[16] = { 0 };
+    bool created = true, stale = true, fresh = true;
+    umsbb_handle_t previous = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+        umsbb_handle_t handle = umsbb_create_buffer(CORE_TEST_MB);
+        created &= handle != 0;
+        fresh &= handle != previous;
+        umsbb_destroy_buffer(handle);
+        // The slot is reused at once, so only the generation tells them apart
+        stale &= umsbb_write_message(handle, message, sizeof(message)) == UMSBB_ERROR_INVALID_HANDLE &&
+                 umsbb_destroy_buffer(handle) == UMSBB_ERROR_INVALID_HANDLE;
+        previous = handle;
+    }
+    CHECK(created && fresh, "1000 create/destroy cycles each get a new handle");
+    CHECK(stale, "a destroyed handle is rejected, also once its slot is reused");
+    CHECK(active_buffers() == 0, "no buffer is left active");
+
+    uint32_t max_buffers;
+    umsbb_get_system_info(NULL, &max_buffers, NULL, NULL);
+    static umsbb_handle_t handles[256];
+    uint32_t live = 0;
+    while (live < max_buffers && (handles[live] = umsbb_create_buffer(CORE_TEST_MB)) != 0) live++;
+    CHECK(live == max_buffers - 1, "every slot but the reserved one can be live");
+    umsbb_destroy_buffer(handles[7]);
+    handles[7] = umsbb_create_buffer(CORE_TEST_MB);
+    CHECK(handles[7] != 0, "a freed slot serves the next create");
+    for (uint32_t i = 0; i < live; i++) umsbb_destroy_buffer(handles[i]);
+    CHECK(active_buffers() == 0, "all of them are destroyed");
+}
+
+typedef struct {
+    umsbb_handle_t handle;
+    volatile int* start;
+    int result;
+} destroyer_t;
+
+static void* destroy_when_started(void* arg) {
+    destroyer_t* destroyer = (destroyer_t*)arg;
+    while (!__atomic_load_n(destroyer->start, __ATOMIC_ACQUIRE)) {}
+    destroyer->result = umsbb_destroy_buffer(destroyer->handle);
+    return NULL;
+}
+
+static void test_racing_destroys(void) {
+    printf("🏁 Racing destroys free a buffer once\n");
+    bool once = true;
+    for (int round = 0; round < 200; round++) {
+        volatile int start = 0;
+        destroyer_t destroyers[2];
+        pthread_t threads[2];
+        umsbb_handle_t handle = umsbb_create_buffer(CORE_TEST_MB);
+        for (int i = 0; i < 2; i++) {
+            destroyers[i] = (destroyer_t){ handle, &start, 1 };
+            pthread_create(&threads[i], NULL, destroy_when_started, &destroyers[i]);
+        }
+        __atomic_store_n(&start, 1, __ATOMIC_RELEASE);
+        for (int i = 0; i < 2; i++) pthread_join(threads[i], NULL);
+        int wins = (destroyers[0].result == UMSBB_SUCCESS) + (destroyers[1].result == UMSBB_SUCCESS);
+        int losses = (destroyers[0].result == UMSBB_ERROR_INVALID_HANDLE) +
+                     (destroyers[1].result == UMSBB_ERROR_INVALID_HANDLE);
+        once &= wins == 1 && losses == 1;
+    }
+    CHECK(once, "of two destroys of one handle exactly one succeeds");
+    CHECK(active_buffers() == 0, "and each buffer is counted out once");
+}
+
+static void test_batches(void) {
+    printf("📦 Batches pack messages back to back\n");
+    umsbb_handle_t handle = umsbb_create_buffer(CORE_TEST_MB);
+    static uint8_t packed[WRAP_MESSAGE * 1200], out[WRAP_MESSAGE * 1200];
+    static uint32_t lengths[1200];
+
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < 10; i++) {
+        lengths[i] = 10 + i * 7;
+        fill_message(packed + total, i, lengths[i]);
+        total += lengths[i];
+    }
+    CHECK(umsbb_write_batch(handle, packed, lengths, 10) == 10, "a batch of 10 is written");
+
+    // Room for the first four only: the fifth stays for the next call
+    uint32_t sizes[10];
+    uint32_t room = lengths[0] + lengths[1] + lengths[2] + lengths[3];
+    CHECK(umsbb_read_batch(handle, out, room + lengths[4] - 1, sizes, 10) == 4,
+          "a short region reads the messages that fit");
+    CHECK(umsbb_read_batch(handle, out + room, sizeof(out) - room, sizes + 4, 10) == 6,
+          "the next call reads the rest");
+    bool intact = true;
+    uint32_t at = 0, id;
+    for (uint32_t i = 0; i < 10; i++) {
+        intact &= sizes[i] == lengths[i] && message_intact(out + at, sizes[i], &id) && id == i;
+        at += sizes[i];
+    }
+    CHECK(intact && at == total, "sizes and payloads come back packed, in order");
+    CHECK(umsbb_read_batch(handle, out, sizeof(out), sizes, 10) == UMSBB_ERROR_BUFFER_EMPTY,
+          "an empty buffer reads nothing");
+
+    uint32_t invalid[3] = { 16, 0, 16 };
+    CHECK(umsbb_write_batch(handle, packed, invalid, 3) == 1, "a batch stops at an invalid length");
+    CHECK(umsbb_write_batch(handle, packed, invalid + 1, 2) == UMSBB_ERROR_INVALID_PARAMS,
+          "and fails when it is the first");
+    umsbb_read_batch(handle, out, sizeof(out), sizes, 10);
+
+    // More than the buffer holds: the batch is cut where the segments fill
+    for (uint32_t i = 0; i < 1200; i++) {
+        lengths[i] = WRAP_MESSAGE;
+        fill_message(packed + i * WRAP_MESSAGE, i, WRAP_MESSAGE);
+    }
+    int written = umsbb_write_batch(handle, packed, lengths, 1200);
+    CHECK(written >= UMSBB_SEGMENT_COUNT * 119 && written < 1200, "a full buffer writes part of a batch");
+    CHECK(umsbb_write_batch(handle, packed, lengths, 1) == UMSBB_ERROR_BUFFER_FULL,
+          "and none of the next");
+    int read = umsbb_read_batch(handle, out, sizeof(out), lengths, 1200);
+    CHECK(read == written, "one read batch drains it");
+
+    umsbb_destroy_buffer(handle);
+}
+
+static void test_reservations(void) {
+    printf("✍️  Reserved messages are built in place\n");
+    umsbb_handle_t handle = umsbb_create_buffer(CORE_TEST_MB);
+    uint8_t out[WRAP_MESSAGE];
+    uint32_t size, id;
+    uint64_t ticket;
+
+    // 128 bytes fill their record exactly, so no alignment slack is left over
+    uint8_t* slot = umsbb_reserve_message(handle, 128, &ticket);
+    CHECK(slot != NULL, "room for 128 bytes is reserved");
+    fill_message(slot, 1, 40);
+    CHECK(umsbb_commit_message(handle, ticket, 129) == UMSBB_ERROR_INVALID_PARAMS,
+          "a commit larger than the reservation is rejected");
+    CHECK(umsbb_commit_message(handle, ticket, 40) == UMSBB_SUCCESS, "a shorter commit publishes it");
+    CHECK(umsbb_commit_message(handle, ticket, 40) == UMSBB_ERROR_INVALID_PARAMS &&
+          umsbb_cancel_message(handle, ticket) == UMSBB_ERROR_INVALID_PARAMS,
+          "a published ticket can be neither committed nor cancelled again");
+    CHECK(umsbb_read_message(handle, out, sizeof(out), &size) == UMSBB_SUCCESS &&
+          size == 40 && message_intact(out, size, &id) && id == 1,
+          "readers see the committed size and payload");
+
+    // Readers pass over a cancelled record to the messages behind it
+    bool cancelled = true, read = true;
+    for (uint32_t i = 0; i < 500; i++) {
+        cancelled &= umsbb_reserve_message(handle, WRAP_MESSAGE, &ticket) != NULL &&
+                     umsbb_cancel_message(handle, ticket) == UMSBB_SUCCESS;
+        fill_message(out, i, 64);
+        umsbb_write_message(handle, out, 64);
+        read &= umsbb_read_message(handle, out, sizeof(out), &size) == UMSBB_SUCCESS &&
+                size == 64 && message_intact(out, size, &id) && id == i;
+    }
+    CHECK(cancelled, "500 reservations are cancelled");
+    CHECK(read, "and the message behind each is read");
+    CHECK(umsbb_cancel_message(handle, ticket) == UMSBB_ERROR_INVALID_PARAMS &&
+          umsbb_commit_message(handle, ticket, 64) == UMSBB_ERROR_INVALID_PARAMS,
+          "a cancelled ticket is spent");
+    CHECK(umsbb_get_pending_messages(handle) == 0, "cancelled records are not counted pending");
+
+    CHECK(umsbb_reserve_message(handle, UMSBB_MAX_MESSAGE_SIZE + 1, &ticket) == NULL &&
+          umsbb_reserve_message(handle, 0, &ticket) == NULL, "invalid sizes reserve nothing");
+    fill_message(out, 0, WRAP_MESSAGE);
+    while (umsbb_write_message(handle, out, WRAP_MESSAGE) == UMSBB_SUCCESS) {}
+    CHECK(umsbb_reserve_message(handle, WRAP_MESSAGE, &ticket) == NULL, "a full buffer reserves nothing");
+
+    umsbb_destroy_buffer(handle);
+}
+
+static void test_loans(void) {
+    printf("👀 Peeked messages are read in place\n");
+    umsbb_handle_t handle = umsbb_create_buffer(CORE_TEST_MB);
+    static uint8_t message[WRAP_MESSAGE];
+    const void* data;
+    uint32_t size, id;
+    uint64_t ticket;
+
+    CHECK(umsbb_peek_message(handle, &data, &size, &ticket) == UMSBB_ERROR_BUFFER_EMPTY,
+          "an empty buffer lends nothing");
+    fill_message(message, 7, 200);
+    umsbb_write_message(handle, message, 200);
+    CHECK(umsbb_peek_message(handle, &data, &size, &ticket) == UMSBB_SUCCESS &&
+          size == 200 && message_intact(data, size, &id) && id == 7,
+          "the payload is read where it lies");
+    CHECK(umsbb_get_pending_messages(handle) == 1, "a message on loan is still pending");
+    CHECK(umsbb_release_message(handle, ticket + 1) == UMSBB_ERROR_INVALID_PARAMS,
+          "a ticket for another segment is rejected");
+    CHECK(umsbb_release_message(handle, ticket) == UMSBB_SUCCESS, "release consumes it");
+    CHECK(umsbb_release_message(handle, ticket) == UMSBB_ERROR_INVALID_PARAMS,
+          "a second release is rejected");
+    CHECK(umsbb_get_pending_messages(handle) == 0 &&
+          umsbb_peek_message(handle, &data, &size, &ticket) == UMSBB_ERROR_BUFFER_EMPTY,
+          "and nothing is left");
+
+    // Loans across the padding at every segment's end
+    bool lent = true;
+    for (uint32_t i = 0; i < 4000; i++) {
+        fill_message(message, i, WRAP_MESSAGE);
+        umsbb_write_message(handle, message, WRAP_MESSAGE);
+        lent &= umsbb_peek_message(handle, &data, &size, &ticket) == UMSBB_SUCCESS &&
+                size == WRAP_MESSAGE && message_intact(data, size, &id) && id == i &&
+                umsbb_release_message(handle, ticket) == UMSBB_SUCCESS;
+    }
+    CHECK(lent, "4000 loans wrap every segment and come back intact");
+
+    umsbb_write_message(handle, message, 16);
+    umsbb_peek_message(handle, &data, &size, &ticket);
+    umsbb_destroy_buffer(handle);
+    CHECK(umsbb_release_message(handle, ticket) == UMSBB_ERROR_INVALID_HANDLE,
+          "a loan does not outlive its buffer");
+}
+
+#define CONCURRENT_WRITERS 4
+#define CONCURRENT_READERS 2
+#define CONCURRENT_MESSAGES 20000   // Per writer
+
+typedef struct {
+    umsbb_handle_t handle;
+    uint32_t index;
+    volatile uint32_t* remaining;   // Messages not read yet, shared by the readers
+    uint8_t* seen;                  // Shared; each id is read by one reader only
+    bool intact;
+} worker_t;
+
+static void* write_messages(void* arg) {
+    worker_t* writer = (worker_t*)arg;
+    uint8_t message[64];
+    for (uint32_t i = 0; i < CONCURRENT_MESSAGES; i++) {
+        fill_message(message, writer->index * CONCURRENT_MESSAGES + i, 16 + i % 48);
+        while (umsbb_write_message(writer->handle, message, 16 + i % 48) == UMSBB_ERROR_BUFFER_FULL) {}
+    }
+    return NULL;
+}
+
+static void* read_messages(void* arg) {
+    worker_t* reader = (worker_t*)arg;
+    uint8_t out[64];
+    uint32_t size, id;
+    while (__atomic_load_n(reader->remaining, __ATOMIC_ACQUIRE) > 0) {
+        if (umsbb_read_message(reader->handle, out, sizeof(out), &size) != UMSBB_SUCCESS) continue;
+        bool ok = message_intact(out, size, &id) && id < CONCURRENT_WRITERS * CONCURRENT_MESSAGES &&
+                  size == 16 + id % CONCURRENT_MESSAGES % 48;
+        if (ok) ok = __atomic_fetch_add(&reader->seen[id], 1, __ATOMIC_RELAXED) == 0;
+        reader->intact &= ok;
+        __atomic_fetch_sub(reader->remaining, 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+static void test_concurrent_writers_and_readers(void) {
+    printf("🧵 Writers share segments and readers share the buffer\n");
+    umsbb_handle_t handle = umsbb_create_buffer(CORE_TEST_MB);
+    static uint8_t seen[CONCURRENT_WRITERS * CONCURRENT_MESSAGES];
+    volatile uint32_t remaining = CONCURRENT_WRITERS * CONCURRENT_MESSAGES;
+    worker_t writers[CONCURRENT_WRITERS], readers[CONCURRENT_READERS];
+    pthread_t threads[CONCURRENT_WRITERS + CONCURRENT_READERS];
+
+    for (uint32_t i = 0; i < CONCURRENT_READERS; i++) {
+        readers[i] = (worker_t){ handle, i, &remaining, seen, true };
+        pthread_create(&threads[CONCURRENT_WRITERS + i], NULL, read_messages, &readers[i]);
+    }
+    for (uint32_t i = 0; i < CONCURRENT_WRITERS; i++) {
+        writers[i] = (worker_t){ handle, i, &remaining, seen, true };
+        pthread_create(&threads[i], NULL, write_messages, &writers[i]);
+    }
+    for (uint32_t i = 0; i < CONCURRENT_WRITERS + CONCURRENT_READERS; i++) pthread_join(threads[i], NULL);
+
+    bool intact = true, all = true;
+    for (uint32_t i = 0; i < CONCURRENT_READERS; i++) intact &= readers[i].intact;
+    for (uint32_t i = 0; i < CONCURRENT_WRITERS * CONCURRENT_MESSAGES; i++) all &= seen[i] == 1;
+    CHECK(intact && all, "80000 messages from 4 writers reach 2 readers once each, intact");
+    CHECK(umsbb_get_pending_messages(handle) == 0 &&
+          umsbb_get_total_messages(handle) == CONCURRENT_WRITERS * CONCURRENT_MESSAGES,
+          "the counters agree");
+    umsbb_destroy_buffer(handle);
+}
+
+int main(void) {
+    printf("🧪 Complete Core Tests\n");
+    test_wrap_and_padding();
+    test_handle_reuse();
+    test_racing_destroys();
+    test_batches();
+    test_reservations();
+    test_loans();
+    test_concurrent_writers_and_readers();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All complete core tests passed\n");
+    return 0;
+}
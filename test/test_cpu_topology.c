@@ -0,0 +1,96 @@
+#include "../include/cpu_topology.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test_check.h"
+
+static void test_discovery(void) {
+    printf("🧭 Discovered topology is consistent\n");
+    cpu_topology_t* topology = malloc(sizeof(cpu_topology_t));
+    CHECK(cpu_topology_discover(topology), "discovery succeeds");
+    printf("  ℹ️  %u CPUs, %u cores, %u nodes\n", topology->cpu_count, topology->core_count, topology->node_count);
+    CHECK((long)topology->cpu_count == sysconf(_SC_NPROCESSORS_ONLN), "every online CPU is listed");
+
+    bool valid = topology->core_count >= 1 && topology->core_count <= topology->cpu_count && topology->node_count >= 1;
+    for (uint32_t i = 0; i < topology->cpu_count; i++) {
+        const cpu_topology_cpu_t* cpu = &topology->cpus[i];
+        valid &= cpu->core < topology->core_count && cpu->node < topology->node_count;
+        if (i > 0) valid &= cpu->cpu > topology->cpus[i - 1].cpu;
+        valid &= cpu_topology_find(topology, cpu->cpu) == cpu;
+    }
+    CHECK(valid, "cores and nodes are dense and CPUs ascend");
+    CHECK(cpu_topology_find(topology, CPU_TOPOLOGY_MAX_CPUS + 1) == NULL, "unknown CPUs are not found");
+
+    uint32_t order[CPU_TOPOLOGY_MAX_CPUS];
+    uint32_t count = cpu_topology_spread(topology, order, CPU_TOPOLOGY_MAX_CPUS);
+    bool first_threads = true;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t smt = cpu_topology_find(topology, order[i])->smt_index;
+        if (i < topology->core_count) first_threads &= smt == 0;
+        else first_threads &= smt > 0;
+    }
+    CHECK(count == topology->cpu_count && first_threads, "the spread covers each physical core before any hyperthread");
+    CHECK(cpu_topology_spread(topology, order, 1) == 1, "the spread can be cut short");
+    free(topology);
+}
+
+static void test_spread_order(void) {
+    printf("🧱 Spread order on two nodes with hyperthreads\n");
+    // Two nodes of two cores with two threads each, siblings in the upper
+    // half the way Linux numbers a dual-socket box
+    cpu_topology_t* topology = calloc(1, sizeof(cpu_topology_t));
+    topology->cpu_count = 8;
+    topology->core_count = 4;
+    topology->node_count = 2;
+    for (uint32_t cpu = 0; cpu < 8; cpu++) {
+        topology->cpus[cpu].cpu = cpu;
+        topology->cpus[cpu].core = cpu % 4;
+        topology->cpus[cpu].node = (cpu % 4) / 2;
+        topology->cpus[cpu].smt_index = cpu / 4;
+    }
+    uint32_t order[8];
+    cpu_topology_spread(topology, order, 8);
+    uint32_t expected[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    CHECK(memcmp(order, expected, sizeof(order)) == 0, "node 0 cores, node 1 cores, then siblings");
+
+    // Siblings adjacent, as some firmware numbers them
+    for (uint32_t cpu = 0; cpu < 8; cpu++) {
+        topology->cpus[cpu].core = cpu / 2;
+        topology->cpus[cpu].node = cpu / 4;
+        topology->cpus[cpu].smt_index = cpu % 2;
+    }
+    cpu_topology_spread(topology, order, 8);
+    uint32_t adjacent[8] = { 0, 2, 4, 6, 1, 3, 5, 7 };
+    CHECK(memcmp(order, adjacent, sizeof(order)) == 0, "adjacent siblings are skipped until every core has a thread");
+    free(topology);
+}
+
+static void test_bind_memory(void) {
+    printf("📍 Memory can be bound to a node\n");
+    size_t size = 1 << 20;
+    char* buffer = malloc(size);
+    memset(buffer, 1, size);
+#if defined(__linux__)
+    CHECK(cpu_topology_bind_memory(buffer, size, 0), "touched pages move to node 0");
+#else
+    CHECK(!cpu_topology_bind_memory(buffer, size, 0), "binding is reported as unsupported");
+#endif
+    CHECK(!cpu_topology_bind_memory(NULL, size, 0), "a null range is refused");
+    CHECK(buffer[size - 1] == 1, "contents survive the move");
+    free(buffer);
+}
+
+int main(void) {
+    printf("🧪 CPU Topology Tests\n");
+    test_discovery();
+    test_spread_order();
+    test_bind_memory();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All CPU topology tests passed\n");
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#if defined(__linux__)
+#include <poll.h>
+#endif
+#include "test_check.h"
+
+static uint64_t now_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static void test_wait_basics(void) {
+    printf("⏱️ Poll, timeout and immediate return\n");
+    EventScheduler e;
+    event_init(&e);
+
+    CHECK(!event_wait(&e, 0), "a zero timeout polls");
+    uint64_t start = now_ns(CLOCK_MONOTONIC);
+    bool woke = event_wait(&e, 5000000);
+    uint64_t elapsed = now_ns(CLOCK_MONOTONIC) - start;
+    CHECK(!woke && elapsed >= 5000000, "an unsignaled wait times out after the timeout");
+
+    event_signal(&e);
+    CHECK(event_wait(&e, EVENT_WAIT_FOREVER), "a pending signal returns immediately");
+    event_clear(&e);
+    CHECK(!event_check(&e), "clear resets the event");
+    event_destroy(&e);
+}
+
+static EventScheduler shared;
+static atomic_size_t woken;
+static uint64_t consumerCpuNs;
+
+static void* sleeper_main(void* arg) {
+    (void)arg;
+    uint64_t cpu = now_ns(CLOCK_THREAD_CPUTIME_ID);
+    if (event_wait(&shared, EVENT_WAIT_FOREVER)) atomic_store_size(&woken, 1);
+    consumerCpuNs = now_ns(CLOCK_THREAD_CPUTIME_ID) - cpu;
+    return NULL;
+}
+
+static void test_parked_consumer(void) {
+    printf("😴 A parked consumer sleeps and is woken\n");
+    event_init(&shared);
+    atomic_store_size(&woken, 0);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, sleeper_main, NULL);
+    sleep_ms(100);
+    CHECK(atomic_load_size(&woken) == 0, "the consumer is still waiting");
+    event_signal(&shared);
+    pthread_join(thread, NULL);
+
+    CHECK(atomic_load_size(&woken) == 1, "event_signal wakes the consumer");
+    printf("  ℹ️ consumer burned %.2f ms CPU during a 100 ms wait\n", consumerCpuNs / 1e6);
+    CHECK(consumerCpuNs < 20000000, "waiting does not burn a core");
+    event_destroy(&shared);
+}
+
+#define PINGS 20000
+
+static EventScheduler ping, pong;
+static atomic_size_t missed;
+
+static void* ponger_main(void* arg) {
+    (void)arg;
+    for (int i = 0; i < PINGS; ++i) {
+        if (!event_wait(&ping, 1000000000ull)) atomic_fetch_add_size(&missed, 1);
+        event_clear(&ping);
+        event_signal(&pong);
+    }
+    return NULL;
+}
+
+static void test_ping_pong(void) {
+    printf("🏓 Ping-pong without lost wakeups\n");
+    event_init(&ping);
+    event_init(&pong);
+    atomic_store_size(&missed, 0);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, ponger_main, NULL);
+    uint64_t start = now_ns(CLOCK_MONOTONIC);
+    for (int i = 0; i < PINGS; ++i) {
+        event_signal(&ping);
+        if (!event_wait(&pong, 1000000000ull)) atomic_fetch_add_size(&missed, 1);
+        event_clear(&pong);
+    }
+    uint64_t elapsed = now_ns(CLOCK_MONOTONIC) - start;
+    pthread_join(thread, NULL);
+
+    printf("  ℹ️ %.2f us per round trip\n", elapsed / 1e3 / PINGS);
+    CHECK(atomic_load_size(&missed) == 0, "every signal was observed by the other side");
+    event_destroy(&ping);
+    event_destroy(&pong);
+}
+
+#define MESSAGES 2000
+
+static UniversalMultiSegmentedBiBufferBus* bus;
+
+static void* producer_main(void* arg) {
+    (void)arg;
+    char msg[32];
+    for (int i = 0; i < MESSAGES; ++i) {
+        snprintf(msg, sizeof(msg), "m%d", i);
+        while (!umsbb_submit_to(bus, (size_t)i % 2, msg, strlen(msg) + 1)) sleep_ms(1);
+        if (i % 100 == 0) sleep_ms(2); // Let the consumer park now and then
+    }
+    return NULL;
+}
+
+static void test_bus_wait(void) {
+    printf("🚌 Blocking bus consumer\n");
+    bus = umsbb_init(64 * 1024, 2);
+    CHECK(!umsbb_wait(bus, 1000000), "an idle bus times out");
+
+#if defined(__linux__)
+    int fd = umsbb_event_fd(bus);
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    CHECK(fd >= 0 && poll(&pfd, 1, 0) == 0, "the event fd is not readable while idle");
+    umsbb_submit_to(bus, 0, "x", 2);
+    CHECK(poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN), "a commit makes the event fd readable");
+    size_t size;
+    umsbb_message_release(umsbb_drain_from(bus, 0, &size));
+    pfd.revents = 0;
+    CHECK(poll(&pfd, 1, 0) == 0, "draining the bus resets the event fd");
+#endif
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, producer_main, NULL);
+    size_t received = 0, timeouts = 0;
+    while (received < MESSAGES && timeouts < 10) {
+        if (!umsbb_wait(bus, 1000000000ull)) {
+            timeouts++;
+            continue;
+        }
+        for (size_t lane = 0; lane < 2; ++lane) {
+            size_t len;
+            void* msg;
+            while ((msg = umsbb_drain_from(bus, lane, &len)) != NULL) {
+                umsbb_message_release(msg);
+                received++;
+            }
+        }
+    }
+    pthread_join(thread, NULL);
+
+    CHECK(received == MESSAGES, "the waiting consumer received every message");
+    CHECK(timeouts == 0, "no wait outlived a pending message");
+    umsbb_free(bus);
+}
+
+int main(void) {
+    printf("🧪 Event Scheduler Tests\n");
+    printf("========================\n");
+
+    test_wait_basics();
+    test_parked_consumer();
+    test_ping_pong();
+    test_bus_wait();
+
+    if (failures) {
+        printf("\n❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✅ All event scheduler tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,342 @@
+#include "../include/fast_lane.h"
+#include "../include/message_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "test_check.h"
+
+static fast_lane_manager_t manager;
+
+static void test_single_thread(void) {
+    printf("🚄 Lengths, priorities and bounds\n");
+    size_t size;
+    uint32_t priority = 0;
+    CHECK(!fast_lane_try_drain(&manager, LANE_EXPRESS, &size, &priority) && size == 0, "an empty lane drains nothing");
+
+    const char* msg = "express";
+    CHECK(fast_lane_try_submit(&manager, LANE_EXPRESS, msg, strlen(msg), 7), "submit into an empty lane");
+    char* out = fast_lane_drain(&manager, LANE_EXPRESS, &size, &priority);
+    CHECK(out && size == strlen(msg) && memcmp(out, msg, size) == 0 && priority == 7,
+          "the slot header carries length and priority");
+    message_pool_release(out);
+
+    char big[257] = {0};
+    CHECK(!fast_lane_submit(&manager, LANE_EXPRESS, big, sizeof(big), 0), "payloads larger than a slot are refused");
+
+    uint32_t capacity = manager.lanes[LANE_PRIORITY].capacity;
+    uint32_t accepted = 0;
+    while (fast_lane_try_submit(&manager, LANE_PRIORITY, &accepted, sizeof(accepted), 0)) accepted++;
+    CHECK(accepted == capacity, "a lane holds exactly its capacity");
+    CHECK(!fast_lane_submit_spin(&manager, LANE_PRIORITY, &accepted, sizeof(accepted), 0, 16),
+          "bounded spin gives up on a full lane");
+
+    bool ordered = true;
+    for (uint32_t i = 0; i < capacity; ++i) {
+        uint32_t* v = fast_lane_drain_spin(&manager, LANE_PRIORITY, &size, NULL, 16);
+        if (!v || size != sizeof(uint32_t) || *v != i) ordered = false;
+        message_pool_release(v);
+    }
+    CHECK(ordered, "messages come back in order across the wrap");
+}
+
+static size_t resident_bytes(void) {
+#if defined(__linux__)
+    FILE* f = fopen("/proc/self/statm", "r");
+    unsigned long pages = 0, resident = 0;
+    if (f) {
+        if (fscanf(f, "%lu %lu", &pages, &resident) != 2) resident = 0;
+        fclose(f);
+    }
+    return (size_t)resident * 4096;
+#else
+    return 0;
+#endif
+}
+
+static void test_lazy_storage(void) {
+    printf("💤 Lane storage is reserved, not committed\n");
+    size_t before = resident_bytes();
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    fast_lane_manager_t lanes;
+    bool ok = fast_lane_init(&lanes);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ms = (double)(t1.tv_sec - t0.tv_sec) * 1e3 + (double)(t1.tv_nsec - t0.tv_nsec) / 1e6;
+    size_t grown = resident_bytes() - before;
+    CHECK(ok && ms < 50.0, "default init does not touch the bulk and streaming rings");
+    CHECK(grown < 16 * 1024 * 1024, "resident memory grows by the prefaulted lanes only");
+
+    uint8_t chunk[4096] = {1};
+    CHECK(fast_lane_try_submit(&lanes, LANE_BULK, chunk, sizeof(chunk), 0), "an untouched bulk slot accepts a message");
+    size_t size;
+    void* out = fast_lane_try_drain(&lanes, LANE_BULK, &size, NULL);
+    CHECK(out && size == sizeof(chunk) && ((uint8_t*)out)[0] == 1, "and returns it");
+    message_pool_release(out);
+    fast_lane_destroy(&lanes);
+
+    fast_lane_config_t config[LANE_COUNT];
+    fast_lane_default_config(config);
+    config[LANE_EXPRESS] = (fast_lane_config_t){ .capacity = 100, .slot_size = 64 };
+    config[LANE_BULK] = (fast_lane_config_t){ .capacity = 0, .slot_size = 0 };
+    ok = fast_lane_init_ex(&lanes, config);
+    CHECK(ok && lanes.lanes[LANE_EXPRESS].capacity == 128, "capacities round up to a power of two");
+    CHECK(!fast_lane_try_submit(&lanes, LANE_EXPRESS, chunk, 65, 0), "the configured slot size is enforced");
+    CHECK(!fast_lane_try_submit(&lanes, LANE_BULK, chunk, 16, 0) &&
+          !fast_lane_try_drain(&lanes, LANE_BULK, &size, NULL), "a zero-sized lane is disabled");
+    fast_lane_destroy(&lanes);
+}
+
+static void test_indirect_lanes(void) {
+    printf("📦 Bulk lanes carry descriptors\n");
+    fast_lane_t* bulk = &manager.lanes[LANE_BULK];
+    CHECK(bulk->slot_stride == 64 && bulk->mapped_size <= 1024 * 1024, "bulk slots are one cache line");
+
+    static uint8_t large[200 * 1024];
+    for (size_t i = 0; i < sizeof(large); ++i) large[i] = (uint8_t)(i * 31);
+    uint8_t small[5000];
+    memset(small, 0x5a, sizeof(small));
+
+    CHECK(fast_lane_try_submit(&manager, LANE_BULK, small, sizeof(small), 1), "a 5 KB message is accepted");
+    CHECK(fast_lane_try_submit(&manager, LANE_BULK, large, sizeof(large), 2), "a message past the old 64 KB ceiling is accepted");
+
+    size_t size;
+    uint32_t priority;
+    uint8_t* out = fast_lane_try_drain(&manager, LANE_BULK, &size, &priority);
+    CHECK(out && size == sizeof(small) && priority == 1 && out[4999] == 0x5a &&
+          message_pool_capacity(out) < 16 * 1024, "the small message takes a small pool block");
+    message_pool_release(out);
+    out = fast_lane_try_drain(&manager, LANE_BULK, &size, &priority);
+    CHECK(out && size == sizeof(large) && memcmp(out, large, size) == 0, "the large message arrives intact");
+    message_pool_release(out);
+
+    // Undrained payloads are released with the lane
+    fast_lane_manager_t lanes;
+    fast_lane_init(&lanes);
+    bool queued = fast_lane_try_submit(&lanes, LANE_STREAMING, large, sizeof(large), 0);
+    fast_lane_destroy(&lanes);
+    CHECK(queued, "destroy reclaims queued descriptors");
+}
+
+static void test_compressed_lanes(void) {
+    printf("🗜️ Compressed bulk and express lanes\n");
+    fast_lane_config_t config[LANE_COUNT];
+    fast_lane_default_config(config);
+    config[LANE_BULK].flags |= FAST_LANE_FLAG_COMPRESS;
+    config[LANE_EXPRESS].flags |= FAST_LANE_FLAG_COMPRESS;
+    config[LANE_EXPRESS].compress_min = 64;
+    fast_lane_manager_t lanes;
+    CHECK(fast_lane_init_ex(&lanes, config), "lanes with compression initialise");
+    lane_codec_set_min_speed(&lanes.lanes[LANE_BULK].codec, 0);    // Backoff from the data alone
+
+    static char json[8192];
+    size_t len = 0;
+    for (int i = 0; len + 64 < sizeof(json); i++) {
+        len += (size_t)snprintf(json + len, sizeof(json) - len, "{\"sensor\":%d,\"value\":%d.5,\"ok\":true},", i % 16, i % 7);
+    }
+    CHECK(fast_lane_try_submit(&lanes, LANE_BULK, json, len, 3), "a JSON payload is submitted");
+    lane_codec_stats_t stats;
+    fast_lane_get_codec_stats(&lanes, LANE_BULK, &stats);
+    CHECK(stats.compressed == 1 && stats.bytes_out * 2 < stats.bytes_in, "it is stored compressed");
+
+    size_t size;
+    uint32_t priority;
+    char* out = fast_lane_try_drain(&lanes, LANE_BULK, &size, &priority);
+    CHECK(out && size == len && priority == 3 && memcmp(out, json, len) == 0, "the drain hands back the original bytes");
+    message_pool_release(out);
+
+    static uint8_t noise[8192];
+    uint32_t x = 2463534242u;
+    for (size_t i = 0; i < sizeof(noise); i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        noise[i] = (uint8_t)x;
+    }
+    fast_lane_try_submit(&lanes, LANE_BULK, noise, sizeof(noise), 0);
+    fast_lane_try_submit(&lanes, LANE_BULK, noise, sizeof(noise), 0);
+    fast_lane_try_submit(&lanes, LANE_BULK, json, 100, 0);
+    fast_lane_get_codec_stats(&lanes, LANE_BULK, &stats);
+    CHECK(stats.attempts == 2 && stats.compressed == 1 && stats.skipped == 1,
+          "incompressible data makes the lane back off, small payloads are never tried");
+    int intact = 1;
+    for (int i = 0; i < 3; i++) {
+        out = fast_lane_try_drain(&lanes, LANE_BULK, &size, &priority);
+        if (!out || (i < 2 && (size != sizeof(noise) || memcmp(out, noise, size) != 0))) intact = 0;
+        if (out && i == 2 && (size != 100 || memcmp(out, json, 100) != 0)) intact = 0;
+        message_pool_release(out);
+    }
+    CHECK(intact, "raw and skipped payloads arrive unchanged");
+
+    // Direct slots hold the compressed bytes themselves
+    CHECK(fast_lane_try_submit(&lanes, LANE_EXPRESS, json, 200, 0), "a small repetitive payload goes express");
+    fast_lane_get_codec_stats(&lanes, LANE_EXPRESS, &stats);
+    out = fast_lane_try_drain(&lanes, LANE_EXPRESS, &size, &priority);
+    CHECK(stats.compressed == 1 && out && size == 200 && memcmp(out, json, 200) == 0,
+          "express slots store and decode it in place");
+    message_pool_release(out);
+
+    fast_lane_get_codec_stats(&lanes, LANE_PRIORITY, &stats);
+    CHECK(stats.attempts == 0, "lanes without the flag never compress");
+    fast_lane_destroy(&lanes);
+}
+
+static void release_batch(fast_lane_message_t* batch, size_t n) {
+    for (size_t i = 0; i < n; ++i) message_pool_release(batch[i].data);
+}
+
+static size_t top_up(fast_lane_manager_t* lanes, lane_type_t type, size_t size, size_t depth) {
+    static uint8_t payload[4096];
+    fast_lane_t* lane = &lanes->lanes[type];
+    size_t added = 0;
+    while (atomic_load_size(&lane->head) - atomic_load_size(&lane->tail) < depth &&
+           fast_lane_try_submit(lanes, type, payload, size, 0)) added++;
+    return added;
+}
+
+static void test_scheduled_drain(void) {
+    printf("⚖️ Weighted, deadline-aware drain across lanes\n");
+    fast_lane_manager_t lanes;
+    fast_lane_init(&lanes);
+    fast_lane_message_t batch[64];
+
+    top_up(&lanes, LANE_PRIORITY, 64, 100);
+    top_up(&lanes, LANE_BULK, 4096, 100);
+    size_t first = fast_lane_drain_scheduled(&lanes, batch, 16);
+    bool all_priority = first == 16;
+    for (size_t i = 0; i < first; ++i) all_priority &= batch[i].lane == LANE_PRIORITY;
+    release_batch(batch, first);
+    CHECK(all_priority, "priority messages preempt the other lanes");
+
+    size_t second = fast_lane_drain_scheduled(&lanes, batch, 16);
+    release_batch(batch, second);
+    size_t third = fast_lane_drain_scheduled(&lanes, batch, 16);
+    size_t bulk_served = 0;
+    for (size_t i = 0; i < third; ++i) bulk_served += batch[i].lane == LANE_BULK;
+    release_batch(batch, third);
+    CHECK(bulk_served > 0, "a priority flood yields after FAST_LANE_PRIORITY_BURST messages");
+
+    // Drain everything, then race express against saturating bulk traffic
+    size_t n;
+    while ((n = fast_lane_drain_scheduled(&lanes, batch, 64)) > 0) release_batch(batch, n);
+    top_up(&lanes, LANE_BULK, 4096, 500);
+    uint8_t ping = 1;
+    fast_lane_try_submit(&lanes, LANE_EXPRESS, &ping, 1, 0);
+    n = fast_lane_drain_scheduled(&lanes, batch, 8);
+    bool express_seen = false;
+    for (size_t i = 0; i < n; ++i) express_seen |= batch[i].lane == LANE_EXPRESS;
+    release_batch(batch, n);
+    CHECK(express_seen, "an express message is not stuck behind a bulk backlog");
+    while ((n = fast_lane_drain_scheduled(&lanes, batch, 64)) > 0) release_batch(batch, n);
+
+    // Both lanes kept busy: bytes follow the 4:2 weights
+    size_t bytes[LANE_COUNT] = {0};
+    for (int round = 0; round < 400; ++round) {
+        top_up(&lanes, LANE_EXPRESS, 256, 256);
+        top_up(&lanes, LANE_STREAMING, 4096, 64);
+        n = fast_lane_drain_scheduled(&lanes, batch, 64);
+        for (size_t i = 0; i < n; ++i) bytes[batch[i].lane] += batch[i].size;
+        release_batch(batch, n);
+    }
+    double ratio = (double)bytes[LANE_EXPRESS] / (double)(bytes[LANE_STREAMING] ? bytes[LANE_STREAMING] : 1);
+    printf("  ℹ️  express/streaming byte ratio %.2f\n", ratio);
+    CHECK(ratio > 1.5 && ratio < 2.7, "drained bytes follow lane_weights");
+
+    while ((n = fast_lane_drain_scheduled(&lanes, batch, 64)) > 0) release_batch(batch, n);
+    fast_lane_destroy(&lanes);
+}
+
+#define PRODUCERS 3
+#define CONSUMERS 3
+#define PER_PRODUCER 20000
+
+typedef struct {
+    uint32_t producer;
+    uint32_t sequence;
+    uint8_t fill[48];
+} lane_record_t;
+
+static atomic_size_t consumed;
+static atomic_size_t torn;
+static atomic_size_t reordered;
+
+static void* producer_main(void* arg) {
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    lane_record_t rec;
+    for (uint32_t i = 0; i < PER_PRODUCER; ++i) {
+        rec.producer = id;
+        rec.sequence = i;
+        // Vary the length so a stale header would be caught
+        size_t len = 8 + (i % sizeof(rec.fill));
+        memset(rec.fill, (int)(i & 0xff), len - 8);
+        while (!fast_lane_submit(&manager, LANE_EXPRESS, &rec, len, id)) sched_yield();
+    }
+    return NULL;
+}
+
+static void* consumer_main(void* arg) {
+    (void)arg;
+    uint32_t last[PRODUCERS];
+    bool seen[PRODUCERS] = {false};
+    while (atomic_load_size(&consumed) < PRODUCERS * PER_PRODUCER) {
+        size_t size;
+        uint32_t priority;
+        lane_record_t* rec = fast_lane_drain_spin(&manager, LANE_EXPRESS, &size, &priority, 64);
+        if (!rec) {
+            sched_yield();
+            continue;
+        }
+        bool intact = rec->producer < PRODUCERS && priority == rec->producer && size == 8 + (rec->sequence % sizeof(rec->fill));
+        for (size_t b = 0; intact && b < size - 8; ++b) intact = rec->fill[b] == (uint8_t)(rec->sequence & 0xff);
+        if (!intact) {
+            atomic_fetch_add_size(&torn, 1);
+        } else {
+            // One consumer's takes are ordered, so each producer's records rise
+            if (seen[rec->producer] && rec->sequence <= last[rec->producer]) atomic_fetch_add_size(&reordered, 1);
+            seen[rec->producer] = true;
+            last[rec->producer] = rec->sequence;
+        }
+        message_pool_release(rec);
+        atomic_fetch_add_size(&consumed, 1);
+    }
+    message_pool_thread_flush();
+    return NULL;
+}
+
+static void test_mpmc(void) {
+    printf("🔀 Many producers and consumers on one lane\n");
+    pthread_t producers[PRODUCERS], consumers[CONSUMERS];
+    for (int i = 0; i < CONSUMERS; ++i) pthread_create(&consumers[i], NULL, consumer_main, NULL);
+    for (int i = 0; i < PRODUCERS; ++i) pthread_create(&producers[i], NULL, producer_main, (void*)(uintptr_t)i);
+    for (int i = 0; i < PRODUCERS; ++i) pthread_join(producers[i], NULL);
+    for (int i = 0; i < CONSUMERS; ++i) pthread_join(consumers[i], NULL);
+
+    size_t size;
+    CHECK(atomic_load_size(&consumed) == PRODUCERS * PER_PRODUCER, "every message consumed once");
+    CHECK(atomic_load_size(&torn) == 0, "no torn or mislabelled messages");
+    CHECK(atomic_load_size(&reordered) == 0, "per-producer order holds for each consumer");
+    CHECK(!fast_lane_try_drain(&manager, LANE_EXPRESS, &size, NULL), "the lane is empty afterwards");
+}
+
+int main(void) {
+    printf("🧪 Fast Lane Tests\n");
+    if (!fast_lane_init(&manager)) {
+        printf("❌ fast_lane_init failed\n");
+        return 1;
+    }
+    test_single_thread();
+    test_mpmc();
+    test_lazy_storage();
+    test_indirect_lanes();
+    test_compressed_lanes();
+    test_scheduled_drain();
+    fast_lane_destroy(&manager);
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All fast lane tests passed\n");
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include "../include/fault_tolerance.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "test_check.h"
+
+#define WORKERS 8
+#define UPDATES 20000
+
+typedef struct {
+    fault_tolerance_manager_t* manager;
+    uint32_t index;
+} worker_t;
+
+static void* update_health(void* arg) {
+    worker_t* worker = (worker_t*)arg;
+    for (uint32_t i = 0; i < UPDATES; i++) {
+        // Every worker hits component 1; each also has one of its own
+        fault_tolerance_update_component_health(worker->manager, 1, i % 100 != 0, 10 + worker->index);
+        fault_tolerance_update_component_health(worker->manager, 10 + worker->index, true, 5);
+    }
+    return NULL;
+}
+
+static void test_sharded_health(void) {
+    printf("🧮 Concurrent health updates aggregate exactly\n");
+    fault_tolerance_manager_t manager;
+    fault_tolerance_init(&manager, 64);
+    pthread_t threads[WORKERS];
+    worker_t workers[WORKERS];
+    for (uint32_t i = 0; i < WORKERS; i++) {
+        workers[i] = (worker_t){ &manager, i };
+        pthread_create(&threads[i], NULL, update_health, &workers[i]);
+    }
+    for (uint32_t i = 0; i < WORKERS; i++) pthread_join(threads[i], NULL);
+
+    component_health_t health;
+    bool found = fault_tolerance_get_component_health(&manager, 1, &health);
+    CHECK(found && health.operations_count == WORKERS * UPDATES, "no update to a shared component is lost");
+    CHECK(health.failure_count == WORKERS * UPDATES / 100 && health.success_count == WORKERS * UPDATES * 99 / 100,
+          "successes and failures are summed over the shards");
+    CHECK(health.max_response_time_us == 10 + WORKERS - 1, "the maximum response time is the largest any shard saw");
+    CHECK(health.avg_response_time_us > 10 && health.avg_response_time_us < 10 + WORKERS,
+          "the mean response time lies within the reported range");
+    CHECK(health.is_healthy && health.health_score == 0.99, "a 99% success rate with a live heartbeat is healthy");
+
+    bool own = true;
+    for (uint32_t i = 0; i < WORKERS; i++) {
+        own &= fault_tolerance_get_component_health(&manager, 10 + i, &health) && health.operations_count == UPDATES;
+    }
+    CHECK(own, "each worker's own component counts its updates");
+    CHECK(!fault_tolerance_get_component_health(&manager, 30, &health), "an unseen component has no snapshot");
+    CHECK(fault_tolerance_get_system_health(&manager) > 0.99, "system health derives from the snapshots");
+    fault_tolerance_destroy(&manager);
+}
+
+static void test_failure_streak(void) {
+    printf("📉 Failure runs mark a component unhealthy until it recovers\n");
+    fault_tolerance_manager_t manager;
+    fault_tolerance_init(&manager, 64);
+    manager.auto_recovery_enabled = false;
+    for (int i = 0; i < 200; i++) fault_tolerance_update_component_health(&manager, 2, true, 1);
+    CHECK(fault_tolerance_is_component_healthy(&manager, 2), "a component with only successes is healthy");
+
+    for (int i = 0; i < 5; i++) fault_tolerance_report_fault(&manager, FAULT_TYPE_CORRUPTION, 2, "bad checksum");
+    component_health_t health;
+    fault_tolerance_get_component_health(&manager, 2, &health);
+    CHECK(health.consecutive_failures == 5 && health.is_degraded && !health.is_healthy,
+          "five reported faults in a row degrade it");
+
+    uint64_t fault_id = atomic_load(&manager.head);
+    CHECK(fault_tolerance_execute_recovery(&manager, fault_id, RECOVERY_ACTION_RESET), "a reset recovers the fault");
+    fault_tolerance_get_component_health(&manager, 2, &health);
+    CHECK(health.consecutive_failures == 0 && health.is_healthy, "the reset ends the failure run");
+    CHECK(fault_tolerance_active_faults(&manager) == 4, "the other four faults stay active");
+
+    fault_tolerance_execute_recovery(&manager, fault_id, RECOVERY_ACTION_ISOLATE);
+    CHECK(!fault_tolerance_is_component_healthy(&manager, 2) && atomic_load(&manager.degraded_components) == 1,
+          "an isolated component is unhealthy and counted as degraded");
+    fault_tolerance_destroy(&manager);
+}
+
+static void test_fault_ring(void) {
+    printf("💍 The fault ring overwrites its oldest entries\n");
+    fault_tolerance_manager_t manager;
+    fault_tolerance_init(&manager, 16);
+    char description[32];
+    uint64_t last = 0;
+    for (int i = 1; i <= 100; i++) {
+        snprintf(description, sizeof(description), "fault %d", i);
+        last = fault_tolerance_report_fault(&manager, FAULT_TYPE_OVERFLOW, 3, description);
+    }
+    CHECK(last == 100, "fault ids count up from 1");
+
+    fault_record_t record;
+    bool newest = true;
+    for (uint64_t id = 85; id <= 100; id++) {
+        snprintf(description, sizeof(description), "fault %llu", (unsigned long long)id);
+        newest &= fault_tolerance_get_fault(&manager, id, &record) && record.fault_id == id &&
+                  strcmp(record.description, description) == 0;
+    }
+    CHECK(newest, "the newest 16 faults are readable with their own contents");
+    CHECK(!fault_tolerance_get_fault(&manager, 84, &record) && !fault_tolerance_get_fault(&manager, 1, &record),
+          "older faults were overwritten");
+    CHECK(fault_tolerance_get_fault(&manager, 100, &record) && record.action_taken == RECOVERY_ACTION_FALLBACK &&
+          record.recovery_successful, "auto recovery is recorded before the fault is published");
+    CHECK(!fault_tolerance_execute_recovery(&manager, 84, RECOVERY_ACTION_RETRY),
+          "recovery of an overwritten fault is refused");
+    CHECK(fault_tolerance_active_faults(&manager) == 0, "every auto-recovered fault is inactive");
+    fault_tolerance_destroy(&manager);
+}
+
+#define REPORTS 20000
+
+static void* report_faults(void* arg) {
+    worker_t* worker = (worker_t*)arg;
+    char description[32];
+    for (uint32_t i = 0; i < REPORTS; i++) {
+        snprintf(description, sizeof(description), "worker %u", worker->index);
+        fault_tolerance_report_fault(worker->manager, FAULT_TYPE_TIMEOUT, worker->index, description);
+    }
+    return NULL;
+}
+
+static void test_fault_storm(void) {
+    printf("🌪️ Concurrent reporters share the ring without locks\n");
+    fault_tolerance_manager_t manager;
+    fault_tolerance_init(&manager, 512);
+    pthread_t threads[WORKERS];
+    worker_t workers[WORKERS];
+    for (uint32_t i = 0; i < WORKERS; i++) {
+        workers[i] = (worker_t){ &manager, i };
+        pthread_create(&threads[i], NULL, report_faults, &workers[i]);
+    }
+    for (uint32_t i = 0; i < WORKERS; i++) pthread_join(threads[i], NULL);
+
+    struct fault_tolerance_metrics metrics;
+    fault_tolerance_get_metrics(&manager, &metrics);
+    CHECK(metrics.total_faults == WORKERS * REPORTS, "every report gets an id");
+    printf("     %llu faults, %llu dropped mid-write\n", (unsigned long long)metrics.total_faults,
+           (unsigned long long)metrics.faults_dropped);
+
+    fault_record_t record;
+    char description[32];
+    uint32_t readable = 0;
+    bool consistent = true;
+    for (uint64_t id = WORKERS * REPORTS - 511; id <= WORKERS * REPORTS; id++) {
+        if (!fault_tolerance_get_fault(&manager, id, &record)) continue;
+        readable++;
+        snprintf(description, sizeof(description), "worker %u", record.component_id);
+        consistent &= record.fault_id == id && strcmp(record.description, description) == 0;
+    }
+    CHECK(readable + metrics.faults_dropped >= 512 && consistent, "the last lap is readable and each record is whole");
+
+    uint64_t counted = 0;
+    component_health_t health;
+    for (uint32_t i = 0; i < WORKERS; i++) {
+        if (fault_tolerance_get_component_health(&manager, i, &health)) counted += health.failure_count;
+    }
+    CHECK(counted == WORKERS * REPORTS, "each fault is counted against its component");
+    fault_tolerance_destroy(&manager);
+}
+
+int main(void) {
+    printf("🧪 Fault Tolerance Tests\n");
+    test_sharded_health();
+    test_failure_streak();
+    test_fault_ring();
+    test_fault_storm();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All fault tolerance tests passed\n");
+    return 0;
+}
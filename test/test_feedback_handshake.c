@@ -0,0 +1,250 @@
+#include "../include/feedback_handshake.h"
+#include "../include/message_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "test_check.h"
+
+static const char payload[] = "reliable";
+
+static void test_single_acks(void) {
+    printf("📬 Single ACKs settle their entry once\n");
+    handshake_manager_t manager;
+    handshake_init(&manager, 8);
+    uint64_t first = handshake_send_message(&manager, 1, 2, payload, sizeof(payload));
+    uint64_t second = handshake_send_message(&manager, 1, 2, payload, sizeof(payload));
+    CHECK(first == 1 && second == 2, "sequences start at 1");
+
+    feedback_message_t ack = handshake_create_ack(second, 1, 2);
+    CHECK(handshake_process_feedback(&manager, &ack), "an ACK matches its entry");
+    CHECK(handshake_process_feedback(&manager, &ack) && manager.successful_acks == 1 &&
+          atomic_load(&manager.pending_count) == 1, "a duplicate ACK is not counted twice");
+    CHECK(atomic_load(&manager.tail) == 1, "the window waits for the oldest entry");
+    feedback_message_t stranger = handshake_create_ack(first, 9, 2);
+    CHECK(!handshake_process_feedback(&manager, &stranger), "another producer's ACK does not match");
+    ack = handshake_create_ack(first, 1, 2);
+    handshake_process_feedback(&manager, &ack);
+    CHECK(atomic_load(&manager.tail) == 3 && atomic_load(&manager.pending_count) == 0, "settled entries leave the window");
+
+    // Slots are reused once the window moves
+    bool sent = true;
+    for (int i = 0; i < 8; i++) sent &= handshake_send_message(&manager, 1, 2, payload, sizeof(payload)) != 0;
+    CHECK(sent && handshake_send_message(&manager, 1, 2, payload, sizeof(payload)) == 0, "a full window refuses sends");
+    handshake_destroy(&manager);
+}
+
+static void test_sack(void) {
+    printf("🧾 One SACK covers a run and its gaps\n");
+    handshake_manager_t manager;
+    handshake_init(&manager, 256);
+    for (int i = 0; i < 100; i++) {
+        handshake_send_message(&manager, 1, 2, payload, sizeof(payload));
+        handshake_send_message(&manager, 3, 2, payload, sizeof(payload));
+    }
+    // Producer 1 holds the odd sequences 1..199; 41 and 45 are missing
+    uint64_t bitmap = 0;
+    for (uint64_t sequence = 43; sequence <= 99; sequence += 2) {
+        if (sequence != 45) bitmap |= 1ull << (sequence - 41);
+    }
+    feedback_message_t sack = handshake_create_sack(39, 41, bitmap, 1, 2);
+    CHECK(handshake_process_feedback(&manager, &sack), "the SACK matches");
+    CHECK(manager.successful_acks == 20 + 28, "the cumulative run and every bitmap bit are acknowledged");
+    CHECK(manager.entries[41 % 256].state == HANDSHAKE_STATE_PENDING &&
+          manager.entries[45 % 256].state == HANDSHAKE_STATE_PENDING, "gaps stay pending");
+    CHECK(manager.entries[2 % 256].state == HANDSHAKE_STATE_PENDING, "other producers' entries are untouched");
+
+    feedback_message_t batch[2] = { handshake_create_sack(399, 0, 0, 1, 2), handshake_create_sack(399, 0, 0, 3, 2) };
+    CHECK(handshake_process_feedback_batch(&manager, batch, 2) == 2, "a batch applies each message");
+    CHECK(manager.successful_acks == 200 && atomic_load(&manager.pending_count) == 0 &&
+          atomic_load(&manager.tail) == atomic_load(&manager.head), "a cumulative point past the head settles everything");
+    CHECK(!handshake_process_feedback(&manager, &sack), "a SACK behind the window matches nothing");
+    handshake_destroy(&manager);
+}
+
+static void test_coalescer(void) {
+    printf("🗜️  Consumers coalesce ACKs by count and by time\n");
+    handshake_manager_t manager;
+    handshake_init(&manager, 256);
+    handshake_ack_coalescer_t coalescer;
+    handshake_coalescer_init(&coalescer, 1, 2, 16, 1000000);
+    for (int i = 0; i < 200; i++) handshake_send_message(&manager, 1, 2, payload, sizeof(payload));
+
+    // Deliver out of order: pairs swapped, one sequence held back
+    feedback_message_t acks[200];
+    uint32_t emitted = 0;
+    for (uint64_t sequence = 1; sequence <= 200; sequence++) {
+        uint64_t delivered = sequence % 2 ? sequence + 1 : sequence - 1;
+        if (delivered == 50) continue;
+        if (handshake_coalescer_receive(&coalescer, delivered, &acks[emitted])) emitted++;
+    }
+    // 12 by count, and 2 where receipts moved past the 64-bit bitmap
+    CHECK(emitted == 14, "ACKs go out per max_messages receipts and when the bitmap fills");
+    CHECK(coalescer.cumulative == 49, "a gap stops the cumulative point");
+    CHECK(handshake_process_feedback_batch(&manager, acks, emitted) == emitted, "every coalesced ACK matches");
+    CHECK(manager.successful_acks == 193 && manager.entries[50].state == HANDSHAKE_STATE_PENDING,
+          "coalesced ACKs settle every receipt they cover");
+
+    feedback_message_t ack;
+    CHECK(!handshake_coalescer_poll(&coalescer, false, &ack), "nothing is due before the delay");
+    CHECK(handshake_coalescer_poll(&coalescer, true, &ack) && ack.type == FEEDBACK_TYPE_SACK, "a forced poll flushes the rest");
+    handshake_process_feedback(&manager, &ack);
+    CHECK(manager.successful_acks == 199 && manager.entries[50].state == HANDSHAKE_STATE_PENDING,
+          "the flush acknowledges only what arrived");
+    CHECK(!handshake_coalescer_poll(&coalescer, true, &ack), "a flushed coalescer has nothing to send");
+
+    CHECK(!handshake_coalescer_receive(&coalescer, 50, &ack) && coalescer.cumulative == 50, "the late sequence closes the gap");
+    CHECK(handshake_coalescer_poll(&coalescer, true, &ack) && handshake_process_feedback(&manager, &ack), "its ACK matches");
+    CHECK(manager.successful_acks == 200 && atomic_load(&manager.pending_count) == 0, "every message is acknowledged");
+
+    handshake_ack_coalescer_t timed;
+    handshake_coalescer_init(&timed, 1, 2, 1000, 0);
+    CHECK(handshake_coalescer_receive(&timed, 1, &ack) && ack.sequence == 1 && ack.sack_bitmap == 0,
+          "a zero delay acknowledges at once");
+
+    handshake_ack_coalescer_t sparse;
+    handshake_coalescer_init(&sparse, 1, 2, 1000, 1000000);
+    CHECK(!handshake_coalescer_receive(&sparse, 3, &ack) && !handshake_coalescer_receive(&sparse, 66, &ack),
+          "receipts within 64 sequences share the bitmap");
+    CHECK(handshake_coalescer_receive(&sparse, 67, &ack) && ack.sequence == 0 && ack.sack_base == 3 &&
+          ack.sack_bitmap == (1ull | 1ull << 63) && sparse.sack_base == 67, "one past it sends the bitmap and restarts it");
+    handshake_destroy(&manager);
+}
+
+static uint32_t count_state(handshake_manager_t* manager, handshake_state_t state) {
+    uint32_t count = 0;
+    uint32_t head = atomic_load(&manager->head);
+    for (uint32_t i = atomic_load(&manager->tail); i != head; i++) count += manager->entries[i % manager->capacity].state == state;
+    return count;
+}
+
+static void test_timeouts(void) {
+    printf("⏱️  Timeouts and retries run off the timer wheel\n");
+    handshake_manager_t manager;
+    handshake_init(&manager, 2048);
+    manager.default_timeout_ms = 20;
+    manager.retry_backoff_ms = 10;
+    manager.max_retries = 2;
+    for (int i = 0; i < 1000; i++) handshake_send_message(&manager, 1, 2, payload, sizeof(payload));
+    for (uint64_t sequence = 1; sequence <= 1000; sequence += 2) {
+        feedback_message_t ack = handshake_create_ack(sequence, 1, 2);
+        handshake_process_feedback(&manager, &ack);
+    }
+    CHECK(manager.timers.armed == 500, "an ACK cancels its entry's deadline");
+    handshake_process_timeouts(&manager);
+    CHECK(manager.timeouts == 0, "nothing times out early");
+
+    usleep(30000);
+    handshake_process_timeouts(&manager);
+    CHECK(manager.timeouts == 500 && count_state(&manager, HANDSHAKE_STATE_RETRY) == 500, "missed deadlines schedule retries");
+    uint64_t first = manager.entries[2].timer.expires;
+    bool jittered = false;
+    for (uint32_t sequence = 4; sequence <= 1000; sequence += 2) jittered |= manager.entries[sequence].timer.expires != first;
+    CHECK(jittered, "retry times are jittered");
+    CHECK(!handshake_retry_failed_messages(&manager), "a retry waits for its backoff");
+
+    usleep(15000);
+    CHECK(handshake_retry_failed_messages(&manager) && count_state(&manager, HANDSHAKE_STATE_PENDING) == 500,
+          "every due retry is resent in one call");
+
+    // Second deadline is doubled, then one more backoff, then the last deadline
+    usleep(50000);
+    handshake_process_timeouts(&manager);
+    usleep(30000);
+    CHECK(handshake_retry_failed_messages(&manager) && manager.retries == 1000, "the second retry follows a longer backoff");
+    usleep(90000);
+    handshake_process_timeouts(&manager);
+    CHECK(manager.failed_deliveries == 500 && atomic_load(&manager.pending_count) == 0 &&
+          atomic_load(&manager.tail) == atomic_load(&manager.head) && manager.timers.armed == 0,
+          "out of retries, entries fail and leave the window");
+    handshake_destroy(&manager);
+}
+
+typedef struct {
+    uint32_t calls;
+    uint64_t last_sequence;
+    bool intact;
+    uint64_t refuse_sequence;
+} resend_log_t;
+
+static bool record_resend(void* context, const handshake_entry_t* entry, const void* data) {
+    resend_log_t* log = (resend_log_t*)context;
+    if (entry->sequence == log->refuse_sequence) return false;
+    log->calls++;
+    log->last_sequence = entry->sequence;
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < entry->message_size; i++) log->intact &= bytes[i] == (unsigned char)(entry->sequence + i);
+    return true;
+}
+
+static void test_retransmit(void) {
+    printf("📦 Retried entries resend their retained payload\n");
+    handshake_manager_t manager;
+    handshake_init(&manager, 64);
+    manager.retry_backoff_ms = 1;
+    resend_log_t log = { 0, 0, true, 8 };
+    handshake_set_retransmit(&manager, 1000, record_resend, &log);
+
+    unsigned char message[100];
+    for (uint64_t sequence = 1; sequence <= 10; sequence++) {
+        for (size_t i = 0; i < sizeof(message); i++) message[i] = (unsigned char)(sequence + i);
+        handshake_send_message(&manager, 1, 2, message, sizeof(message));
+    }
+    memset(message, 0, sizeof(message));
+    CHECK(manager.retained_bytes == 1000, "every send is retained");
+    CHECK(handshake_send_message(&manager, 1, 2, message, sizeof(message)) == 0 && manager.budget_rejections == 1,
+          "a send past the byte budget is refused");
+    size_t size = 0;
+    const unsigned char* kept = handshake_get_payload(&manager, 3, &size);
+    CHECK(kept && size == 100 && kept[0] == 3 && kept[99] == 102, "the store holds its own copy of the payload");
+
+    for (uint64_t sequence = 1; sequence <= 5; sequence++) {
+        feedback_message_t ack = handshake_create_ack(sequence, 1, 2);
+        handshake_process_feedback(&manager, &ack);
+    }
+    CHECK(manager.retained_bytes == 500 && !handshake_get_payload(&manager, 3, NULL), "an ACK releases the payload");
+    const unsigned char* held = handshake_get_payload(&manager, 6, NULL);
+    handshake_payload_retain(held);
+    feedback_message_t ack = handshake_create_ack(6, 1, 2);
+    handshake_process_feedback(&manager, &ack);
+    CHECK(manager.retained_bytes == 400 && held[0] == 6, "a retained reference outlives the entry");
+    handshake_payload_release(held);
+
+    feedback_message_t nack = handshake_create_nack(7, 1, 2, 1, "lost");
+    handshake_process_feedback(&manager, &nack);
+    nack = handshake_create_nack(8, 1, 2, 1, "lost");
+    handshake_process_feedback(&manager, &nack);
+    usleep(5000);
+    handshake_retry_failed_messages(&manager);
+    CHECK(log.calls == 1 && log.last_sequence == 7 && log.intact && manager.resends == 1,
+          "a NACKed entry is resent from the store without the caller");
+    CHECK(manager.entries[8].state == HANDSHAKE_STATE_RETRY && manager.entries[8].retry_count == 1 &&
+          manager.resend_failures == 1, "a refused resend waits another backoff without using a retry");
+    log.refuse_sequence = 0;
+    usleep(5000);
+    handshake_retry_failed_messages(&manager);
+    CHECK(log.calls == 2 && log.last_sequence == 8 && manager.entries[8].state == HANDSHAKE_STATE_PENDING,
+          "it goes out once the callback accepts it");
+
+    handshake_set_retransmit(&manager, 0, NULL, NULL);
+    uint64_t plain = handshake_send_message(&manager, 1, 2, message, sizeof(message));
+    CHECK(plain && !handshake_get_payload(&manager, plain, NULL) && manager.retained_bytes == 400,
+          "a zero budget tracks sends without retaining them");
+    handshake_destroy(&manager);
+}
+
+int main(void) {
+    printf("🧪 Feedback Handshake Tests\n");
+    test_single_acks();
+    test_sack();
+    test_coalescer();
+    test_timeouts();
+    test_retransmit();
+    message_pool_thread_flush();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All feedback handshake tests passed\n");
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "../include/feedback_stream.h"
+#include <stdio.h>
+#include <pthread.h>
+#include "test_check.h"
+
+static void push(FeedbackStream* stream, size_t lane, FeedbackType type, uint32_t sequence) {
+    if (!feedback_should_record(stream, lane, type, sequence)) return;
+    FeedbackEntry e = { .sequence = sequence, .type = type, .note = "test", .timestamp = 0 };
+    feedback_push(stream, lane, e);
+}
+
+static void test_overwrite_oldest(void) {
+    printf("🔁 Overwrite-oldest ring\n");
+    FeedbackStream stream;
+    feedback_init(&stream, 2);
+    feedback_set_sampling(&stream, 1);
+
+    for (uint32_t i = 0; i < 1000; ++i) push(&stream, 0, FEEDBACK_OK, i);
+
+    FeedbackCursor cursor;
+    feedback_cursor_init(&stream, 0, &cursor);
+    FeedbackEntry out[FEEDBACK_RING_CAPACITY];
+    size_t n = feedback_read(&stream, 0, &cursor, out, FEEDBACK_RING_CAPACITY);
+    CHECK(n == FEEDBACK_RING_CAPACITY, "ring retains the newest FEEDBACK_RING_CAPACITY entries");
+    CHECK(out[0].sequence == 1000 - FEEDBACK_RING_CAPACITY && out[n - 1].sequence == 999,
+          "entries are the most recent ones, oldest first");
+    CHECK(out[0].timestamp != 0, "entries are timestamped on push");
+    CHECK(feedback_read(&stream, 0, &cursor, out, 1) == 0, "cursor is caught up");
+
+    feedback_cursor_init(&stream, 1, &cursor);
+    CHECK(feedback_read(&stream, 1, &cursor, out, 1) == 0, "lanes are independent");
+
+    // A stale cursor is resynced and counts what it missed
+    FeedbackCursor stale = { .position = 0, .dropped = 0 };
+    n = feedback_read(&stream, 0, &stale, out, FEEDBACK_RING_CAPACITY);
+    CHECK(n == FEEDBACK_RING_CAPACITY && stale.dropped == 1000 - FEEDBACK_RING_CAPACITY,
+          "lapped cursor reports dropped entries");
+    feedback_destroy(&stream);
+}
+
+static void test_sampling(void) {
+    printf("🎯 Sampling\n");
+    FeedbackStream stream;
+    feedback_init(&stream, 1);
+    feedback_set_sampling(&stream, 10);
+
+    for (uint32_t i = 0; i < 100; ++i) push(&stream, 0, FEEDBACK_OK, i);
+    push(&stream, 0, FEEDBACK_CORRUPTED, 55);
+    push(&stream, 0, FEEDBACK_THROTTLED, 57);
+
+    FeedbackCursor cursor;
+    feedback_cursor_init(&stream, 0, &cursor);
+    FeedbackEntry out[32];
+    size_t n = feedback_read(&stream, 0, &cursor, out, 32);
+    CHECK(n == 12, "every 10th routine event plus all exceptional events");
+    CHECK(out[10].type == FEEDBACK_CORRUPTED && out[11].type == FEEDBACK_THROTTLED,
+          "exceptional events are never sampled out");
+
+    // Repeated empty polls with no traffic in between record one IDLE
+    for (int i = 0; i < 50; ++i) push(&stream, 0, FEEDBACK_IDLE, 100);
+    push(&stream, 0, FEEDBACK_IDLE, 101);
+    n = feedback_read(&stream, 0, &cursor, out, 32);
+    CHECK(n == 2, "IDLE is recorded once per idle period");
+
+    feedback_set_sampling(&stream, 0);
+    push(&stream, 0, FEEDBACK_OK, 0);
+    push(&stream, 0, FEEDBACK_SKIPPED, 1);
+    n = feedback_read(&stream, 0, &cursor, out, 32);
+    CHECK(n == 1 && out[0].type == FEEDBACK_SKIPPED, "sampling 0 keeps exceptional events only");
+    feedback_destroy(&stream);
+}
+
+#define WRITERS 4
+#define PUSHES_PER_WRITER 50000
+
+static FeedbackStream shared;
+static atomic_size_t writersDone;
+
+static void* writer_main(void* arg) {
+    uint32_t id = (uint32_t)(size_t)arg;
+    for (uint32_t i = 0; i < PUSHES_PER_WRITER; ++i) {
+        FeedbackEntry e = { .sequence = i, .type = (FeedbackType)id, .note = "mpsc", .timestamp = 0 };
+        feedback_push(&shared, 0, e);
+    }
+    atomic_fetch_add_size(&writersDone, 1);
+    return NULL;
+}
+
+static void test_concurrent_writers(void) {
+    printf("🧵 Concurrent writers with a live reader\n");
+    feedback_init(&shared, 1);
+    atomic_store_size(&writersDone, 0);
+
+    // Per-writer sequences must never go backwards, even across drops
+    uint32_t last[WRITERS] = {0};
+    int bad = 0;
+    size_t seen = 0;
+    FeedbackCursor cursor;
+    feedback_cursor_init(&shared, 0, &cursor);
+    FeedbackEntry out[64];
+
+    pthread_t threads[WRITERS];
+    for (size_t i = 0; i < WRITERS; ++i) pthread_create(&threads[i], NULL, writer_main, (void*)i);
+
+    for (;;) {
+        bool done = atomic_load_size(&writersDone) == WRITERS;
+        size_t n = feedback_read(&shared, 0, &cursor, out, 64);
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t w = (uint32_t)out[i].type;
+            if (w >= WRITERS || out[i].sequence < last[w]) bad++;
+            else last[w] = out[i].sequence;
+        }
+        seen += n;
+        if (done && n == 0) break;
+    }
+    for (size_t i = 0; i < WRITERS; ++i) pthread_join(threads[i], NULL);
+
+    CHECK(bad == 0, "no torn or reordered entries observed");
+    CHECK(seen + cursor.dropped == (size_t)WRITERS * PUSHES_PER_WRITER, "every entry is either read or counted as dropped");
+    feedback_destroy(&shared);
+}
+
+int main(void) {
+    printf("🧪 Feedback Stream Tests\n");
+    printf("========================\n");
+
+    test_overwrite_oldest();
+    test_sampling();
+    test_concurrent_writers();
+
+    if (failures) {
+        printf("\n❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✅ All feedback stream tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,308 @@
+#include "../include/gpu_accelerated_buffer.h"
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test_check.h"
+
+#define PRODUCERS 4
+#define MESSAGES 50000
+
+typedef struct {
+    uint32_t producer;
+    uint32_t sequence;
+    uint8_t fill[24];
+} message_t;
+
+typedef struct {
+    uint8_t* seen;                  // Per producer and sequence
+    uint64_t messages;
+    uint64_t batches;
+    uint64_t last_batch[MAX_GPU_STREAMS];
+    bool intact;
+    bool lanes;
+    bool unique_batches;
+    uint8_t* batch_seen;
+} collector_t;
+
+static void collect(void* context, const gpu_batch_t* batch) {
+    collector_t* collector = (collector_t*)context;
+    collector->batches++;
+    if (batch->batch_id < 1u << 20) {
+        collector->unique_batches &= collector->batch_seen[batch->batch_id]++ == 0;
+    }
+    for (uint32_t i = 0; i < batch->count; i++) {
+        const message_t* message = (const message_t*)(batch->data + batch->offsets[i]);
+        bool whole = batch->lengths[i] == sizeof(message_t) && message->producer < PRODUCERS &&
+                     message->sequence < MESSAGES && message->fill[23] == (uint8_t)message->sequence;
+        collector->intact &= whole;
+        if (!whole) continue;
+        collector->seen[message->producer * MESSAGES + message->sequence]++;
+        // Even sequences were sent with a lane, odd ones left to the kernel
+        uint32_t expected = (message->sequence % 2 == 0) ? message->sequence % 4
+                                                         : gpu_hash_lane_selection(message, sizeof(message_t));
+        collector->lanes &= batch->lane_ids[i] == expected;
+        collector->messages++;
+    }
+}
+
+typedef struct {
+    gpu_accelerated_buffer_t* buffer;
+    uint32_t index;
+    bool ok;
+} producer_t;
+
+static void* produce(void* arg) {
+    producer_t* producer = (producer_t*)arg;
+    message_t message;
+    memset(&message, 0, sizeof(message));
+    message.producer = producer->index;
+    producer->ok = true;
+    for (uint32_t i = 0; i < MESSAGES; i++) {
+        message.sequence = i;
+        memset(message.fill, (uint8_t)i, sizeof(message.fill));
+        uint32_t lane = (i % 2 == 0) ? i % 4 : GPU_PIPELINE_AUTO_LANE;
+        producer->ok &= gpu_buffer_write_accelerated(producer->buffer, &message, sizeof(message), lane) == 0;
+    }
+    return NULL;
+}
+
+static void test_concurrent_producers(void) {
+    printf("🚚 Producers fill stages while earlier batches are in flight\n");
+    gpu_accelerated_buffer_t buffer;
+    gpu_buffer_init(&buffer, 1 << 16, GPU_PROCESSING_DISABLED);
+
+    collector_t collector;
+    memset(&collector, 0, sizeof(collector));
+    collector.seen = (uint8_t*)calloc(PRODUCERS * MESSAGES, 1);
+    collector.batch_seen = (uint8_t*)calloc(1u << 20, 1);
+    collector.intact = collector.lanes = collector.unique_batches = true;
+
+    gpu_pipeline_config_t config;
+    gpu_pipeline_default_config(&config);
+    config.num_streams = 4;
+    config.staging_bytes = 4096;
+    config.on_complete = collect;
+    config.context = &collector;
+    CHECK(gpu_pipeline_start(&buffer, &config) == 0, "the pipeline starts on the CPU fallback");
+    CHECK(gpu_pipeline_start(&buffer, &config) != 0, "a second start is refused");
+
+    pthread_t threads[PRODUCERS];
+    producer_t producers[PRODUCERS];
+    for (uint32_t i = 0; i < PRODUCERS; i++) {
+        producers[i] = (producer_t){ &buffer, i, false };
+        pthread_create(&threads[i], NULL, produce, &producers[i]);
+    }
+    for (uint32_t i = 0; i < PRODUCERS; i++) pthread_join(threads[i], NULL);
+    bool submitted = true;
+    for (uint32_t i = 0; i < PRODUCERS; i++) submitted &= producers[i].ok;
+    CHECK(submitted, "every write is accepted");
+    CHECK(gpu_pipeline_drain(&buffer) == 0, "the pipeline drains");
+
+    bool once = true;
+    for (uint32_t i = 0; i < PRODUCERS * MESSAGES; i++) once &= collector.seen[i] == 1;
+    CHECK(collector.intact && once && collector.messages == PRODUCERS * MESSAGES,
+          "each message comes back exactly once and intact");
+    CHECK(collector.lanes, "the kernel fills in missing lanes and keeps given ones");
+    CHECK(collector.unique_batches, "each batch has its own id");
+
+    gpu_pipeline_stats_t stats;
+    gpu_pipeline_get_stats(&buffer, &stats);
+    CHECK(stats.batches_submitted == stats.batches_completed && stats.batches_completed == collector.batches,
+          "every submitted batch is retired");
+    CHECK(stats.bytes_completed == (uint64_t)PRODUCERS * MESSAGES * sizeof(message_t) &&
+          buffer.total_bytes == stats.bytes_completed, "bytes are counted as batches retire");
+    CHECK(stats.max_in_flight > 1, "several batches are in flight at once");
+    printf("     %llu batches, at most %u in flight, %llu producer stalls\n",
+           (unsigned long long)stats.batches_completed, stats.max_in_flight,
+           (unsigned long long)stats.producer_stalls);
+
+    gpu_buffer_cleanup(&buffer);
+    free(collector.seen);
+    free(collector.batch_seen);
+}
+
+static void test_ring_completion(void) {
+    printf("🔁 Without a callback, retired batches land in the host ring\n");
+    gpu_accelerated_buffer_t buffer;
+    gpu_buffer_init(&buffer, 1 << 16, GPU_PROCESSING_DISABLED);
+    gpu_pipeline_config_t config;
+    gpu_pipeline_default_config(&config);
+    config.num_streams = 2;
+    config.staging_bytes = 1024;
+    config.flush_timeout_us = 0;
+    gpu_pipeline_start(&buffer, &config);
+
+    uint8_t message[100];
+    for (int i = 0; i < 200; i++) {
+        memset(message, i, sizeof(message));
+        gpu_buffer_write_accelerated(&buffer, message, sizeof(message), 0);
+    }
+    CHECK(buffer.total_messages < 200, "writes return before their batches retire");
+
+    uint8_t big[2048] = { 0 };
+    CHECK(gpu_pipeline_submit(&buffer, big, sizeof(big), 0) != 0, "a message larger than a stage is refused");
+
+    gpu_pipeline_drain(&buffer);
+    CHECK(buffer.total_messages == 200 && buffer.head == 200 * sizeof(message), "every message is written to the ring");
+    uint32_t counts[200] = { 0 };
+    bool whole = true;
+    for (int i = 0; i < 200; i++) {
+        const uint8_t* slot = buffer.host_buffer + i * sizeof(message);
+        whole &= memcmp(slot, slot + 1, sizeof(message) - 1) == 0;
+        counts[slot[0] < 200 ? slot[0] : 0]++;
+    }
+    bool each = true;
+    for (int i = 0; i < 200; i++) each &= counts[i] == 1;
+    CHECK(whole && each, "messages stay whole and each appears once");
+    CHECK(gpu_pipeline_poll(&buffer) == 0, "nothing is left to retire after a drain");
+
+    // Stop retires what is still staged
+    memset(message, 7, sizeof(message));
+    gpu_buffer_write_accelerated(&buffer, message, sizeof(message), 0);
+    gpu_pipeline_stop(&buffer);
+    CHECK(buffer.pipeline == NULL && buffer.total_messages == 201, "stopping delivers the staged message");
+    CHECK(gpu_pipeline_submit(&buffer, message, sizeof(message), 0) != 0, "a stopped pipeline takes no writes");
+    gpu_buffer_cleanup(&buffer);
+}
+
+typedef struct {
+    uint64_t records;
+    uint64_t tag_sum;
+    bool transformed;
+} scatter_t;
+
+// The shared per-record transform: invert every byte
+static void invert(void* context, uint8_t* data, uint32_t length, uint32_t lane_id) {
+    (void)context;
+    (void)lane_id;
+    for (uint32_t i = 0; i < length; i++) data[i] = (uint8_t)~data[i];
+}
+
+static void scatter(void* context, uint64_t tag, const void* data, size_t size, uint32_t lane_id) {
+    scatter_t* results = (scatter_t*)context;
+    const uint8_t* bytes = (const uint8_t*)data;
+    // Record `tag` was tag % 251 repeated, size 1 KB + tag % 3 KB
+    results->transformed &= size == 1024 + tag % 3072 && lane_id == 3 && bytes[0] == (uint8_t)~(tag % 251) &&
+                            bytes[size - 1] == (uint8_t)~(tag % 251);
+    results->tag_sum += tag;
+    __atomic_add_fetch(&results->records, 1, __ATOMIC_RELEASE);
+}
+
+static void test_coalesced_records(void) {
+    printf("📦 Small records coalesce into batches and scatter back one by one\n");
+    gpu_accelerated_buffer_t buffer;
+    gpu_buffer_init(&buffer, 1 << 16, GPU_PROCESSING_DISABLED);
+    scatter_t results = { 0, 0, true };
+    gpu_pipeline_config_t config;
+    gpu_pipeline_default_config(&config);
+    config.staging_bytes = 256 * 1024;
+    config.batch_messages = 64;
+    config.transform = invert;
+    config.on_result = scatter;
+    config.context = &results;
+    gpu_pipeline_start(&buffer, &config);
+
+    static uint8_t record[4096];
+    const uint64_t count = 10000;
+    for (uint64_t tag = 0; tag < count; tag++) {
+        size_t size = 1024 + tag % 3072;
+        memset(record, (int)(tag % 251), size);
+        gpu_pipeline_submit_tagged(&buffer, record, size, 3, tag);
+    }
+    gpu_pipeline_drain(&buffer);
+    CHECK(results.records == count && results.tag_sum == count * (count - 1) / 2,
+          "every record's result comes back with its own tag");
+    CHECK(results.transformed, "each record was transformed in place, whole");
+    gpu_pipeline_stats_t stats;
+    gpu_pipeline_get_stats(&buffer, &stats);
+    CHECK(stats.batches_completed >= count / 64 && stats.batches_completed < count / 16,
+          "records travel in packed batches, not one launch each");
+
+    // A trickle below the batch size still goes out on the timeout
+    uint64_t before = results.records;
+    memset(record, 7, 1024);
+    gpu_pipeline_submit_tagged(&buffer, record, 1024, 3, 7);
+    for (int i = 0; i < 200 && __atomic_load_n(&results.records, __ATOMIC_ACQUIRE) == before; i++) usleep(1000);
+    gpu_pipeline_get_stats(&buffer, &stats);
+    CHECK(results.records == before + 1 && stats.timeout_flushes >= 1,
+          "a lone record is flushed and delivered by the timeout without a poll");
+    gpu_buffer_cleanup(&buffer);
+}
+
+static void add_one(void* context, uint8_t* data, uint32_t length, uint32_t lane_id) {
+    (void)context;
+    (void)lane_id;
+    for (uint32_t i = 0; i < length; i++) data[i]++;
+}
+
+static void test_bus_coalescing(void) {
+    printf("🚌 Bulk and streaming lanes feed the coalescer\n");
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(1 << 20, 2);
+    gpu_pipeline_config_t config;
+    gpu_pipeline_default_config(&config);
+    config.transform = add_one;
+    CHECK(umsbb_enable_gpu_coalescing(bus, &config), "coalescing is enabled");
+    CHECK(!umsbb_enable_gpu_coalescing(bus, &config), "only once");
+
+    uint8_t record[2048];
+    bool submitted = true;
+    for (uint32_t i = 0; i < 1000; i++) {
+        memset(record, (int)(i % 200), sizeof(record));
+        submitted &= umsbb_fast_lane_submit(bus, (i % 2) ? LANE_BULK : LANE_STREAMING, record, sizeof(record), i);
+    }
+    uint8_t express[64] = { 1 };
+    submitted &= umsbb_fast_lane_submit(bus, LANE_EXPRESS, express, sizeof(express), 0);
+    CHECK(submitted, "submits are accepted");
+
+    size_t size;
+    uint32_t priority;
+    void* message = umsbb_fast_lane_drain(bus, LANE_EXPRESS, &size, &priority);
+    CHECK(message && size == sizeof(express) && ((uint8_t*)message)[0] == 1, "other lanes bypass the coalescer");
+    umsbb_message_release(message);
+
+    uint32_t drained = 0;
+    bool transformed = true;
+    uint64_t priorities = 0;
+    for (int spins = 0; drained < 1000 && spins < 100000; spins++) {
+        lane_type_t lane = (spins % 2) ? LANE_BULK : LANE_STREAMING;
+        message = umsbb_fast_lane_drain(bus, lane, &size, &priority);
+        if (!message) {
+            usleep(100);
+            continue;
+        }
+        const uint8_t* bytes = (const uint8_t*)message;
+        transformed &= size == sizeof(record) && bytes[0] == (uint8_t)(priority % 200 + 1) &&
+                       bytes[size - 1] == bytes[0] && (priority % 2 == 1) == (lane == LANE_BULK);
+        priorities += priority;
+        drained++;
+        umsbb_message_release(message);
+    }
+    CHECK(drained == 1000 && priorities == 999 * 1000 / 2, "every record reaches its lane with its priority");
+    CHECK(transformed, "and carries the transform's result");
+
+    umsbb_disable_gpu_coalescing(bus);
+    memset(record, 5, sizeof(record));
+    umsbb_fast_lane_submit(bus, LANE_BULK, record, sizeof(record), 0);
+    message = umsbb_fast_lane_drain(bus, LANE_BULK, &size, &priority);
+    CHECK(message && ((uint8_t*)message)[0] == 5, "disabled, bulk submits go straight to the lane");
+    umsbb_message_release(message);
+    umsbb_free(bus);
+}
+
+int main(void) {
+    printf("🧪 GPU Pipeline Tests\n");
+    test_concurrent_producers();
+    test_ring_completion();
+    test_coalesced_records();
+    test_bus_coalescing();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All GPU pipeline tests passed\n");
+    return 0;
+}
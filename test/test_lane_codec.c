@@ -0,0 +1,204 @@
+#include "../include/lane_codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "test_check.h"
+
+static uint32_t noise_state = 2463534242u;
+
+static void fill_noise(uint8_t* p, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        noise_state ^= noise_state << 13;
+        noise_state ^= noise_state >> 17;
+        noise_state ^= noise_state << 5;
+        p[i] = (uint8_t)noise_state;
+    }
+}
+
+static size_t fill_telemetry(char* p, size_t n) {
+    size_t len = 0;
+    for (int i = 0; len + 96 < n; i++) {
+        len += (size_t)snprintf(p + len, n - len, "{\"ts\":%d,\"node\":\"edge-%02d\",\"cpu\":%d,\"mem\":%d},",
+                                1700000000 + i, i % 12, (i * 7) % 100, (i * 13) % 100);
+    }
+    return len;
+}
+
+/* Compress and decode `size` bytes; true if they come back unchanged. */
+static bool round_trip(const void* data, size_t size, size_t* packed) {
+    size_t bound = lane_codec_bound(size);
+    uint8_t* dst = malloc(bound);
+    uint8_t* back = malloc(size + 1);
+    bool ok = dst && back;
+    if (ok) {
+        *packed = lane_codec_compress(data, size, dst, bound);
+        ok = *packed > 0 && lane_codec_decode(NULL, dst, *packed, back, size) && memcmp(back, data, size) == 0;
+    }
+    free(dst);
+    free(back);
+    return ok;
+}
+
+static void test_round_trips(void) {
+    printf("🔁 Block format round trips\n");
+    static char text[64 * 1024];
+    static uint8_t buf[200 * 1024];
+    size_t packed;
+
+    size_t len = fill_telemetry(text, sizeof(text));
+    CHECK(round_trip(text, len, &packed) && packed * 3 < len, "telemetry JSON shrinks to under a third");
+
+    memset(buf, 'a', sizeof(buf));
+    CHECK(round_trip(buf, sizeof(buf), &packed) && packed < sizeof(buf) / 100, "a run of one byte collapses");
+
+    fill_noise(buf, sizeof(buf));
+    CHECK(round_trip(buf, sizeof(buf), &packed) && packed <= lane_codec_bound(sizeof(buf)),
+          "noise round-trips within the bound");
+
+    int edges = 1;
+    for (size_t n = 0; n < 300; n++) {
+        for (size_t i = 0; i < n; i++) buf[i] = (uint8_t)(i % 5 == 0 ? i : 'x');
+        if (!round_trip(buf, n, &packed)) edges = 0;
+    }
+    CHECK(edges, "every length from 0 to 299 round-trips");
+
+    // Matches further back than the 64 KB window are written as literals
+    fill_noise(buf, 70 * 1024);
+    memcpy(buf + 130 * 1024, buf, 70 * 1024);
+    CHECK(round_trip(buf, sizeof(buf), &packed), "repeats beyond the offset window stay correct");
+}
+
+static void test_corrupt_input(void) {
+    printf("🧨 Corrupt blocks are rejected\n");
+    static char text[16 * 1024];
+    size_t len = fill_telemetry(text, sizeof(text));
+    uint8_t* packed = malloc(lane_codec_bound(len));
+    size_t n = lane_codec_compress(text, len, packed, lane_codec_bound(len));
+    char* back = malloc(len);
+
+    CHECK(!lane_codec_decode(NULL, packed, n - 1, back, len), "a truncated block fails");
+    CHECK(!lane_codec_decode(NULL, packed, n, back, len - 1), "a wrong original length fails");
+
+    // No flipped byte may make the decoder read or write out of bounds
+    int rejected = 0;
+    for (size_t i = 0; i < n; i += 7) {
+        packed[i] ^= 0x5A;
+        if (!lane_codec_decode(NULL, packed, n, back, len)) rejected++;
+        packed[i] ^= 0x5A;
+    }
+    CHECK(rejected > 0, "flipped bytes are caught without overrunning the buffers");
+
+    lane_codec_t codec;
+    lane_codec_init(&codec, 64, 0);
+    lane_codec_decode(&codec, packed, n / 2, back, len);
+    lane_codec_stats_t stats;
+    lane_codec_get_stats(&codec, &stats);
+    CHECK(stats.failures == 1, "failures are counted on the codec");
+    free(packed);
+    free(back);
+}
+
+static void test_adaptive(void) {
+    printf("🧠 Adaptive encode\n");
+    static char text[8192];
+    static uint8_t noise[8192];
+    size_t len = fill_telemetry(text, sizeof(text));
+    fill_noise(noise, sizeof(noise));
+
+    lane_codec_t codec;
+    lane_codec_init(&codec, 1024, 0);
+    // Judge by saving alone so a stalled runner cannot trigger a backoff
+    lane_codec_set_min_speed(&codec, 0);
+    size_t out = 0;
+    CHECK(lane_codec_encode(&codec, text, 512, &out) == NULL, "payloads below min_size are stored raw");
+    const void* packed = lane_codec_encode(&codec, text, len, &out);
+    CHECK(packed && out < len / 2, "compressible payloads are encoded");
+
+    CHECK(lane_codec_encode(&codec, noise, sizeof(noise), &out) == NULL, "noise saves too little and is stored raw");
+    int skipped = 1;
+    for (int i = 0; i < 16; i++) {
+        if (lane_codec_encode(&codec, text, len, &out) != NULL) skipped = 0;
+    }
+    CHECK(skipped, "the next 16 eligible payloads skip the codec");
+    CHECK(lane_codec_encode(&codec, text, len, &out) != NULL, "then it probes again and resumes");
+
+    lane_codec_stats_t stats;
+    lane_codec_get_stats(&codec, &stats);
+    CHECK(stats.attempts == 3 && stats.compressed == 2 && stats.skipped == 16, "stats follow the decisions");
+
+    // Under a floor no compression reaches, the average sinks over a run of attempts
+    lane_codec_t strict;
+    lane_codec_init(&strict, 1024, 0);
+    lane_codec_set_min_speed(&strict, UINT32_MAX);
+    CHECK(lane_codec_encode(&strict, text, len, &out) != NULL, "one slow compression does not back the lane off");
+    int encoded = 1;
+    while (encoded < 32 && lane_codec_encode(&strict, text, len, &out) != NULL) encoded++;
+    CHECK(encoded > 1 && encoded < 32, "a run of slow compressions does");
+
+    lane_codec_t off;
+    lane_codec_init(&off, 0, 0);
+    CHECK(lane_codec_encode(&off, text, len, &out) == NULL, "min_size 0 disables the codec");
+}
+
+typedef struct {
+    int seed;
+    int ok;
+    int packed;
+} codec_thread_arg;
+
+static void* codec_thread(void* p) {
+    codec_thread_arg* arg = p;
+    char text[8192];
+    char back[8192];
+    lane_codec_t codec;
+    lane_codec_init(&codec, 256, 0);
+    arg->ok = 1;
+    for (int round = 0; round < 500; round++) {
+        size_t len = 0;
+        for (int i = 0; len + 64 < sizeof(text); i++) {
+            len += (size_t)snprintf(text + len, sizeof(text) - len, "[%d,%d,\"t%d\"]", arg->seed, round, i % 9);
+        }
+        // A preempted encode may look slow and back off: raw is fine too
+        size_t n = 0;
+        const void* packed = lane_codec_encode(&codec, text, len, &n);
+        if (!packed) continue;
+        if (!lane_codec_decode(&codec, packed, n, back, len) || memcmp(back, text, len) != 0) arg->ok = 0;
+        arg->packed++;
+    }
+    return NULL;
+}
+
+static void test_thread_contexts(void) {
+    printf("🧵 Per-thread contexts\n");
+    pthread_t threads[4];
+    codec_thread_arg args[4];
+    for (int i = 0; i < 4; i++) {
+        args[i].seed = i;
+        args[i].packed = 0;
+        pthread_create(&threads[i], NULL, codec_thread, &args[i]);
+    }
+    int ok = 1;
+    for (int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+        ok &= args[i].ok && args[i].packed > 0;
+    }
+    CHECK(ok, "threads encode concurrently, each in its own scratch");
+}
+
+int main(void) {
+    printf("🧪 Lane Codec Tests\n");
+    printf("===================\n");
+
+    test_round_trips();
+    test_corrupt_input();
+    test_adaptive();
+    test_thread_contexts();
+
+    if (failures) {
+        printf("\n❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✅ All lane codec tests passed!\n");
+    return 0;
+}
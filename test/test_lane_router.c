@@ -0,0 +1,176 @@
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include "../include/message_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "test_check.h"
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static void drain_all(fast_lane_manager_t* manager, lane_type_t lane) {
+    size_t size;
+    void* msg;
+    while ((msg = fast_lane_drain(manager, lane, &size, NULL)) != NULL) message_pool_release(msg);
+}
+
+static void test_static_routes(void) {
+    printf("🗺️  Routes before any update\n");
+    fast_lane_manager_t manager;
+    fast_lane_init(&manager);
+    lane_router_t router;
+    lane_router_init(&router, &manager);
+
+    static const size_t sizes[] = { 16, 256, 300, 3000, 4095, 5000, 100000, 2 * 1024 * 1024 };
+    int same = 1;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (int critical = 0; critical < 2; critical++) {
+            if (lane_router_select(&router, &manager, sizes[i], critical, 0) !=
+                fast_lane_select_optimal(sizes[i], 0, critical)) same = 0;
+        }
+    }
+    CHECK(same, "a new router follows fast_lane_select_optimal");
+    CHECK(lane_router_select(&router, &manager, FAST_LANE_INDIRECT_MAX + 1, true, 0) == router.largest,
+          "messages larger than their route's slots go to the largest lane");
+
+    CHECK(lane_router_select(&router, &manager, 100, false, 0.01) == LANE_EXPRESS &&
+          lane_router_select(&router, &manager, 100, false, 1.0) == LANE_STREAMING,
+          "a timeout shorter than the route's cost takes the critical route");
+
+    sleep_ms(1);
+    lane_router_update(&router, &manager, NULL);
+    sleep_ms(1);
+    CHECK(lane_router_update(&router, &manager, NULL) == 0, "idle lanes leave the routes where they settled");
+    fast_lane_destroy(&manager);
+}
+
+static void test_backlog(void) {
+    printf("🚧 A backed-up lane loses its latency-critical routes\n");
+    fast_lane_manager_t manager;
+    fast_lane_init(&manager);
+    lane_router_t router;
+    lane_router_init(&router, &manager);
+    sleep_ms(1);
+    lane_router_update(&router, &manager, NULL);
+    CHECK(lane_router_select(&router, &manager, 3000, true, 0) == LANE_STREAMING,
+          "3 KB latency-critical messages start on the streaming lane");
+
+    // Bulk traffic the consumer has not got to
+    static char filler[2048];
+    for (int i = 0; i < 4000; i++) fast_lane_submit(&manager, LANE_STREAMING, filler, sizeof(filler), 0);
+    sleep_ms(2);
+    CHECK(lane_router_update(&router, &manager, NULL) > 0, "the update moves routes");
+    CHECK(lane_router_select(&router, &manager, 3000, true, 0) == LANE_BULK &&
+          lane_router_cost(&router, LANE_STREAMING) > lane_router_cost(&router, LANE_BULK),
+          "they move to the idle bulk lane");
+    CHECK(lane_router_select(&router, &manager, 100, true, 0) == LANE_EXPRESS,
+          "small ones stay on the express lane");
+
+    drain_all(&manager, LANE_STREAMING);
+    int updates = 0;
+    while (lane_router_select(&router, &manager, 3000, true, 0) != LANE_STREAMING && updates < 20) {
+        sleep_ms(1);
+        lane_router_update(&router, &manager, NULL);
+        updates++;
+    }
+    CHECK(updates > 1 && updates < 20, "a drained lane wins them back once its cost has settled");
+    fast_lane_destroy(&manager);
+}
+
+static void test_weights_and_congestion(void) {
+    printf("⚖️  Weights and congestion\n");
+    fast_lane_manager_t manager;
+    fast_lane_init(&manager);
+    lane_router_t router;
+    lane_router_init(&router, &manager);
+
+    uint32_t weights[LANE_COUNT] = { 100, 0, 100, 100 };
+    sleep_ms(1);
+    lane_router_update(&router, &manager, weights);
+    CHECK(lane_router_select(&router, &manager, 16 * 1024, false, 0) == LANE_STREAMING,
+          "a lane weighted 0 gives up its routes");
+
+    fast_lane_manager_t fresh;
+    fast_lane_init(&fresh);
+    lane_router_init(&router, &fresh);
+    sleep_ms(1);
+    lane_router_update(&router, &fresh, NULL);
+    // Every submit of the window waited past twice the lane's target
+    char msg[64] = { 0 };
+    for (int i = 0; i < 8; i++) fast_lane_submit(&fresh, LANE_STREAMING, msg, sizeof(msg), 0);
+    atomic_fetch_add_size(&fresh.lanes[LANE_STREAMING].congestion_events, 8);
+    drain_all(&fresh, LANE_STREAMING);
+    sleep_ms(1);
+    lane_router_update(&router, &fresh, NULL);
+    CHECK(lane_router_select(&router, &fresh, 3000, true, 0) == LANE_BULK,
+          "congestion events raise a lane's cost");
+    fast_lane_destroy(&fresh);
+    fast_lane_destroy(&manager);
+}
+
+#if UMSBB_ENABLE_MULTILANG && UMSBB_ENABLE_FAST_LANES
+static void test_bus_routing(void) {
+    printf("🚌 Bus lane selection\n");
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(64 * 1024, 2);
+    lane_selection_criteria_t criteria = {
+        .source_lang = WASM_LANG_PYTHON, .target_lang = WASM_LANG_RUST,
+        .message_size = 3000, .priority = 1, .latency_critical = true
+    };
+    CHECK(umsbb_select_priority_lane(bus, &criteria) == LANE_STREAMING, "unpinned pairs take the learned route");
+
+    criteria.priority = LANE_ROUTER_PRIORITY;
+    criteria.message_size = 512;
+    CHECK(umsbb_select_priority_lane(bus, &criteria) == LANE_PRIORITY, "high priority takes the priority lane");
+
+    CHECK(umsbb_configure_lane_routing(bus, WASM_LANG_PYTHON, WASM_LANG_RUST, LANE_EXPRESS),
+          "a language pair can be pinned");
+    criteria.message_size = 128;
+    CHECK(umsbb_select_priority_lane(bus, &criteria) == LANE_EXPRESS, "pinned pairs go to their lane");
+    criteria.message_size = 3000;
+    criteria.priority = 1;
+    CHECK(umsbb_select_priority_lane(bus, &criteria) == LANE_STREAMING, "messages the pin cannot carry are routed");
+    criteria.source_lang = WASM_LANG_GO;
+    criteria.message_size = 128;
+    CHECK(umsbb_select_priority_lane(bus, &criteria) == LANE_EXPRESS, "other pairs are not affected by the pin");
+    criteria.source_lang = WASM_LANG_PYTHON;
+    criteria.latency_critical = false;
+    CHECK(umsbb_configure_lane_routing(bus, WASM_LANG_PYTHON, WASM_LANG_RUST, LANE_COUNT) &&
+          umsbb_select_priority_lane(bus, &criteria) == LANE_STREAMING, "LANE_COUNT unpins it");
+    CHECK(!umsbb_configure_lane_routing(bus, WASM_LANG_COUNT, WASM_LANG_RUST, LANE_BULK) &&
+          !umsbb_configure_lane_routing(bus, WASM_LANG_PYTHON, WASM_LANG_RUST, (lane_type_t)(LANE_COUNT + 1)),
+          "out-of-range pins are refused");
+
+    static char filler[2048];
+    for (int i = 0; i < 4000; i++) umsbb_fast_lane_submit(bus, LANE_STREAMING, filler, sizeof(filler), 0);
+    sleep_ms(2);
+    CHECK(umsbb_optimize_language_routing(bus) &&
+          bus->lane_performance_history[LANE_STREAMING] > bus->lane_performance_history[LANE_BULK],
+          "optimizing records each lane's cost");
+    criteria.latency_critical = true;
+    criteria.message_size = 3000;
+    CHECK(umsbb_select_priority_lane(bus, &criteria) == LANE_BULK,
+          "3 KB latency-critical messages avoid the backed-up lane");
+    umsbb_free(bus);
+}
+#endif
+
+int main(void) {
+    printf("🧪 Lane Router Tests\n");
+    printf("====================\n");
+
+    test_static_routes();
+    test_backlog();
+    test_weights_and_congestion();
+#if UMSBB_ENABLE_MULTILANG && UMSBB_ENABLE_FAST_LANES
+    test_bus_routing();
+#endif
+
+    if (failures) {
+        printf("\n❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✅ All lane router tests passed!\n");
+    return 0;
+}
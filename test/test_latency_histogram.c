@@ -0,0 +1,202 @@
+#include "../include/latency_histogram.h"
+#include "../include/fast_lane.h"
+#include "../include/twin_lane.h"
+#include "../include/feedback_handshake.h"
+#include "../include/message_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "test_check.h"
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+/* Within the histogram's bucket resolution of the exact value, never below it. */
+static int near(uint64_t reported, uint64_t exact) {
+    return reported >= exact && reported <= exact + exact / LATENCY_HISTOGRAM_SUB_COUNT + 1;
+}
+
+static void test_percentiles(void) {
+    printf("📊 Percentiles within bucket resolution\n");
+    LatencyHistogram* h = latency_histogram_create();
+    LatencySummary s;
+    latency_histogram_summary(h, &s);
+    CHECK(s.count == 0 && s.p999Ns == 0, "an empty histogram reports zeroes");
+
+    for (uint64_t v = 1; v <= 100000; ++v) latency_histogram_record(h, v);
+    latency_histogram_summary(h, &s);
+    CHECK(s.count == 100000 && s.minNs == 1, "every sample counted, small values exact");
+    CHECK(near(s.p50Ns, 50000) && near(s.p99Ns, 99000) && near(s.p999Ns, 99900), "p50, p99 and p999");
+    CHECK(near(s.maxNs, 100000), "max is the top of its bucket");
+    CHECK(s.meanNs > 49000.0 && s.meanNs < 51500.0, "mean from bucket midpoints");
+    CHECK(near(latency_histogram_percentile(h, 0.9), 90000), "arbitrary quantiles");
+
+    latency_histogram_record(h, (uint64_t)1 << 50);
+    latency_histogram_summary(h, &s);
+    CHECK(s.count == 100001 && s.maxNs < ((uint64_t)1 << LATENCY_HISTOGRAM_MAX_BITS),
+          "out-of-range samples land in the last bucket");
+
+    latency_histogram_record(NULL, 1);
+    latency_histogram_summary(NULL, &s);
+    CHECK(s.count == 0, "a NULL histogram ignores samples and reads as empty");
+    latency_histogram_destroy(h);
+}
+
+#define RECORDERS 4
+#define SAMPLES 200000
+
+typedef struct {
+    LatencyHistogram* h;
+    uint64_t value;
+} Recorder;
+
+static void* recorder_main(void* arg) {
+    Recorder* r = arg;
+    for (int i = 0; i < SAMPLES; ++i) latency_histogram_record(r->h, r->value);
+    return NULL;
+}
+
+static void test_threads(void) {
+    printf("🧵 Per-thread shards merge on read\n");
+    LatencyHistogram* h = latency_histogram_create();
+    pthread_t threads[RECORDERS];
+    Recorder recorders[RECORDERS];
+    for (int i = 0; i < RECORDERS; ++i) {
+        recorders[i] = (Recorder){ h, (uint64_t)1000 << (3 * i) };
+        pthread_create(&threads[i], NULL, recorder_main, &recorders[i]);
+    }
+
+    // Readers may merge while the recorders run
+    LatencySummary s;
+    latency_histogram_summary(h, &s);
+    CHECK(s.count <= (uint64_t)RECORDERS * SAMPLES, "a concurrent read sees a partial count");
+
+    for (int i = 0; i < RECORDERS; ++i) pthread_join(threads[i], NULL);
+    latency_histogram_summary(h, &s);
+    CHECK(s.count == (uint64_t)RECORDERS * SAMPLES, "no sample lost across threads");
+    CHECK(s.minNs == 1000, "the lowest thread's value is the minimum");
+    CHECK(near(s.p50Ns, 8000) && near(s.p999Ns, 512000), "quartile boundaries land on the right thread");
+    latency_histogram_destroy(h);
+}
+
+static void test_interval(void) {
+    printf("⏱️  Interval snapshots\n");
+    LatencyHistogram* h = latency_histogram_create();
+    LatencySummary s;
+    for (int i = 0; i < 1000; ++i) latency_histogram_record(h, 100);
+    latency_histogram_interval(h, &s);
+    CHECK(s.count == 1000 && s.p999Ns == 100, "the first interval covers everything so far");
+
+    for (int i = 0; i < 10; ++i) latency_histogram_record(h, 50000);
+    latency_histogram_interval(h, &s);
+    CHECK(s.count == 10 && s.minNs > 49000 && near(s.p50Ns, 50000), "the next interval sees only new samples");
+
+    latency_histogram_interval(h, &s);
+    CHECK(s.count == 0, "a quiet interval is empty");
+    latency_histogram_summary(h, &s);
+    CHECK(s.count == 1010 && s.p50Ns == 100, "the cumulative view is unaffected");
+    latency_histogram_destroy(h);
+}
+
+static void test_cumulative(void) {
+    printf("🪜 Cumulative buckets\n");
+    LatencyHistogram* h = latency_histogram_create();
+    for (int i = 0; i < 10; ++i) latency_histogram_record(h, 100);
+    for (int i = 0; i < 5; ++i) latency_histogram_record(h, 5000);
+    latency_histogram_record(h, 2000000);
+
+    const uint64_t bounds[4] = { 1000, 10000, 1000000, 10000000 };
+    uint64_t below[4], total;
+    double sum;
+    latency_histogram_cumulative(h, bounds, 4, below, &total, &sum);
+    CHECK(below[0] == 10 && below[1] == 15 && below[2] == 15 && below[3] == 16 && total == 16,
+          "counts accumulate across bounds");
+    CHECK(sum >= 10 * 100 + 5 * 5000 + 2000000 && sum <= (10 * 100 + 5 * 5000 + 2000000) * 1.02,
+          "the sum is within bucket resolution");
+
+    latency_histogram_cumulative(NULL, bounds, 4, below, &total, &sum);
+    CHECK(total == 0 && below[3] == 0 && sum == 0.0, "a NULL histogram is empty");
+    latency_histogram_destroy(h);
+}
+
+static void test_fast_lane_metrics(void) {
+    printf("🚄 Fast lanes report per-lane latency and rates\n");
+    fast_lane_manager_t manager;
+    fast_lane_init(&manager);
+    struct lane_metrics express, bulk;
+    fast_lane_get_metrics(&manager, LANE_EXPRESS, &express);
+    fast_lane_get_metrics(&manager, LANE_BULK, &bulk);
+
+    char msg[64] = {0};
+    size_t size;
+    for (int i = 0; i < 500; ++i) fast_lane_submit(&manager, LANE_EXPRESS, msg, sizeof(msg), 0);
+    for (int i = 0; i < 50; ++i) fast_lane_submit(&manager, LANE_BULK, msg, sizeof(msg), 0);
+    sleep_ms(2);
+    for (int i = 0; i < 500; ++i) message_pool_release(fast_lane_drain(&manager, LANE_EXPRESS, &size, NULL));
+    for (int i = 0; i < 50; ++i) message_pool_release(fast_lane_drain(&manager, LANE_BULK, &size, NULL));
+
+    fast_lane_get_metrics(&manager, LANE_EXPRESS, &express);
+    fast_lane_get_metrics(&manager, LANE_BULK, &bulk);
+    CHECK(express.latency.count == 500 && bulk.latency.count == 50, "every drained message is recorded on its lane");
+    CHECK(express.p50_latency_us >= 1000.0 && express.p50_latency_us <= express.p99_latency_us &&
+          express.p99_latency_us <= express.p999_latency_us && express.p999_latency_us <= express.max_latency_us,
+          "queueing time shows up in ordered percentiles");
+    CHECK(express.messages_per_second > 0 && bulk.messages_per_second > 0 &&
+          express.messages_per_second > 5 * bulk.messages_per_second,
+          "rates are tracked per lane");
+
+    fast_lane_get_interval_metrics(&manager, LANE_EXPRESS, &express);
+    fast_lane_submit(&manager, LANE_EXPRESS, msg, sizeof(msg), 0);
+    message_pool_release(fast_lane_drain(&manager, LANE_EXPRESS, &size, NULL));
+    fast_lane_get_interval_metrics(&manager, LANE_EXPRESS, &express);
+    CHECK(express.latency.count == 1 && express.p999_latency_us < 1000.0, "interval metrics cover the last period only");
+    fast_lane_destroy(&manager);
+}
+
+static void test_twin_and_handshake(void) {
+    printf("🔁 Twin lanes and handshakes share the histogram\n");
+    twin_lane_manager_t twins;
+    twin_lane_init(&twins, 2);
+    uint32_t lane = twin_lane_create(&twins, 1, 4096, 4096);
+    char msg[32] = {0};
+    for (uint32_t i = 0; i < 8; ++i) twin_lane_send(&twins, lane, msg, sizeof(msg), i);
+    struct duplex_metrics duplex;
+    twin_lane_get_duplex_metrics(&twins, lane, &duplex);
+    CHECK(duplex.tx_latency.count == 8 && duplex.rx_latency.count == 0, "twin lane sends are recorded per direction");
+    twin_lane_destroy(&twins);
+
+    handshake_manager_t handshake;
+    handshake_init(&handshake, 16);
+    uint64_t sequence = handshake_send_message(&handshake, 1, 2, msg, sizeof(msg));
+    feedback_message_t ack = handshake_create_ack(sequence, 1, 2);
+    handshake_process_feedback(&handshake, &ack);
+    struct handshake_metrics hm;
+    handshake_get_metrics(&handshake, &hm);
+    // The library builds with -ffast-math, so allow for a reciprocal multiply
+    double p99_us = (double)hm.ack_latency.p99Ns / 1000.0;
+    double error = hm.p99_ack_latency_us - p99_us;
+    CHECK(hm.ack_latency.count == 1 && (error < 0 ? -error : error) <= p99_us * 1e-12,
+          "handshake p99 comes from recorded ACK latencies");
+    handshake_destroy(&handshake);
+}
+
+int main(void) {
+    printf("🧪 Latency Histogram Tests\n");
+    test_percentiles();
+    test_threads();
+    test_interval();
+    test_cumulative();
+    test_fast_lane_metrics();
+    test_twin_and_handshake();
+    message_pool_thread_flush();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All latency histogram tests passed\n");
+    return 0;
+}
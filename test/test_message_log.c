@@ -0,0 +1,511 @@
+#include "../include/message_log.h"
+#include "../include/fault_tolerance.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test_check.h"
+
+static void make_directory(char* path) {
+    strcpy(path, "/tmp/umsbb_log_XXXXXX");
+    if (!mkdtemp(path)) path[0] = '\0';
+}
+
+static void remove_directory(const char* path) {
+    DIR* dir = opendir(path);
+    if (!dir) return;
+    struct dirent* item;
+    char file[600];
+    while ((item = readdir(dir))) {
+        if (item->d_name[0] == '.') continue;
+        snprintf(file, sizeof(file), "%s/%s", path, item->d_name);
+        unlink(file);
+    }
+    closedir(dir);
+    rmdir(path);
+}
+
+static uint32_t count_segments(const char* path) {
+    DIR* dir = opendir(path);
+    if (!dir) return 0;
+    uint32_t count = 0;
+    struct dirent* item;
+    while ((item = readdir(dir))) count += strstr(item->d_name, ".wal") != NULL;
+    closedir(dir);
+    return count;
+}
+
+static void fill(char* buffer, size_t size, uint64_t sequence) {
+    for (size_t i = 0; i < size; i++) buffer[i] = (char)(sequence * 31 + i);
+}
+
+static bool matches(const void* data, size_t size, uint64_t sequence) {
+    char expected[512];
+    fill(expected, size, sequence);
+    return data && memcmp(data, expected, size) == 0;
+}
+
+static void count_record(void* context, uint32_t lane, uint64_t sequence, const void* data, size_t size) {
+    (void)lane;
+    (void)sequence;
+    (void)data;
+    (void)size;
+    (*(uint64_t*)context)++;
+}
+
+static void test_append_and_recover(void) {
+    printf("📝 Records read back, and survive a reopen\n");
+    char directory[64];
+    make_directory(directory);
+    MessageLog* log = message_log_open(directory, NULL);
+    CHECK(log != NULL, "a log opens in an empty directory");
+    if (!log) return;
+
+    char buffer[512];
+    bool appended = true;
+    for (uint64_t sequence = 1; sequence <= 100; sequence++) {
+        fill(buffer, (size_t)(sequence * 5), sequence);
+        appended &= message_log_append(log, (uint32_t)(sequence % 4), sequence, buffer, (size_t)(sequence * 5)) != 0;
+    }
+    CHECK(appended, "100 records of varying size are accepted");
+
+    size_t size = 0;
+    uint32_t lane = 0;
+    void* data = message_log_read(log, 42, &size, &lane);
+    CHECK(size == 210 && lane == 2 && matches(data, size, 42), "a record reads back with its size and lane");
+    free(data);
+    CHECK(message_log_read(log, 1000, &size, NULL) == NULL, "an unknown sequence is not found");
+    CHECK(message_log_flush(log), "flush syncs everything appended");
+    message_log_close(log);
+
+    log = message_log_open(directory, NULL);
+    struct message_log_stats stats;
+    message_log_get_stats(log, &stats);
+    CHECK(stats.records_recovered == 100, "reopening indexes every record");
+    bool intact = true;
+    for (uint64_t sequence = 1; sequence <= 100; sequence++) {
+        data = message_log_read(log, sequence, &size, NULL);
+        intact &= size == sequence * 5 && matches(data, size, sequence);
+        free(data);
+    }
+    CHECK(intact, "every recovered record passes its CRC and matches");
+
+    // Appends after a reopen go to a fresh segment and are found alongside
+    fill(buffer, 64, 101);
+    message_log_append(log, 0, 101, buffer, 64);
+    data = message_log_read(log, 101, &size, NULL);
+    CHECK(matches(data, 64, 101) && count_segments(directory) == 2, "new records land in a new segment");
+    free(data);
+    message_log_close(log);
+    remove_directory(directory);
+}
+
+static void test_torn_tail(void) {
+    printf("✂️ A torn tail is dropped on reopen\n");
+    char directory[64];
+    make_directory(directory);
+    message_log_config_t config;
+    message_log_default_config(&config);
+    config.direct_io = false;
+    MessageLog* log = message_log_open(directory, &config);
+    if (!log) {
+        CHECK(false, "the log opens");
+        return;
+    }
+    char buffer[512];
+    for (uint64_t sequence = 1; sequence <= 10; sequence++) {
+        fill(buffer, 100, sequence);
+        message_log_append(log, 0, sequence, buffer, 100);
+    }
+    message_log_close(log);
+
+    // Cut the last record in half and leave stray bytes after it
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%020llu.wal", directory, 1ull);
+    size_t record = (sizeof(message_log_record_t) + 100 + MESSAGE_LOG_ALIGN - 1) & ~(size_t)(MESSAGE_LOG_ALIGN - 1);
+    CHECK(truncate(path, (off_t)(record * 9 + record / 2)) == 0, "the segment is truncated mid-record");
+    FILE* file = fopen(path, "ab");
+    if (file) {
+        fputs("garbage", file);
+        fclose(file);
+    }
+
+    log = message_log_open(directory, &config);
+    struct message_log_stats stats;
+    message_log_get_stats(log, &stats);
+    CHECK(stats.records_recovered == 9 && stats.torn_segments == 1, "the intact prefix is recovered, the tail marked torn");
+    size_t size = 0;
+    void* data = message_log_read(log, 10, &size, NULL);
+    CHECK(data == NULL, "the torn record is gone");
+    data = message_log_read(log, 9, &size, NULL);
+    CHECK(matches(data, size, 9), "the record before it is whole");
+    free(data);
+    message_log_close(log);
+
+    // The rescan indexed the segment; a payload corrupted after that is caught as it is read
+    file = fopen(path, "r+b");
+    if (file) {
+        fseek(file, (long)(record * 4 + sizeof(message_log_record_t) + 10), SEEK_SET);
+        fputc(0x5a, file);
+        fclose(file);
+    }
+    log = message_log_open(directory, &config);
+    message_log_get_stats(log, &stats);
+    CHECK(stats.segments_indexed == 1 && stats.records_recovered == 9 && stats.torn_segments == 0,
+          "the reopen trusts the index without a scan");
+    data = message_log_read(log, 5, &size, NULL);
+    CHECK(data == NULL, "a corrupt payload fails its CRC on read");
+    uint64_t counted = 0, delivered = 0;
+    CHECK(!message_log_replay(log, 1, 9, count_record, &counted, &delivered) && delivered == 4 && counted == 4,
+          "replay stops at the corrupt record");
+    message_log_close(log);
+    remove_directory(directory);
+}
+
+typedef struct {
+    MessageLog* log;
+    uint32_t lane;
+    uint32_t count;
+    bool ok;
+} appender_t;
+
+static void* append_sync(void* arg) {
+    appender_t* appender = (appender_t*)arg;
+    char buffer[128];
+    for (uint32_t i = 0; i < appender->count; i++) {
+        uint64_t sequence = (uint64_t)appender->lane * 100000 + i + 1;
+        fill(buffer, sizeof(buffer), sequence);
+        appender->ok &= message_log_append(appender->log, appender->lane, sequence, buffer, sizeof(buffer)) != 0;
+    }
+    return NULL;
+}
+
+#define APPENDERS 8
+#define SYNC_RECORDS 200
+
+static void test_group_commit(void) {
+    printf("👥 Concurrent SYNC appends share fdatasyncs\n");
+    char directory[64];
+    make_directory(directory);
+    message_log_config_t config;
+    message_log_default_config(&config);
+    config.durability = MESSAGE_LOG_SYNC;
+    MessageLog* log = message_log_open(directory, &config);
+    if (!log) {
+        CHECK(false, "the log opens");
+        return;
+    }
+    pthread_t threads[APPENDERS];
+    appender_t appenders[APPENDERS];
+    for (uint32_t i = 0; i < APPENDERS; i++) {
+        appenders[i] = (appender_t){ log, i + 1, SYNC_RECORDS, true };
+        pthread_create(&threads[i], NULL, append_sync, &appenders[i]);
+    }
+    bool ok = true;
+    for (uint32_t i = 0; i < APPENDERS; i++) {
+        pthread_join(threads[i], NULL);
+        ok &= appenders[i].ok;
+    }
+    struct message_log_stats stats;
+    message_log_get_stats(log, &stats);
+    CHECK(ok && stats.records_appended == APPENDERS * SYNC_RECORDS, "every SYNC append returns durable");
+    printf("     %llu records, %llu batches, %llu syncs\n", (unsigned long long)stats.records_appended,
+           (unsigned long long)stats.batches, (unsigned long long)stats.syncs);
+    CHECK(stats.syncs < stats.records_appended, "fewer syncs than records");
+
+    bool intact = true;
+    for (uint32_t lane = 1; lane <= APPENDERS; lane += 3) {
+        for (uint32_t i = 0; i < SYNC_RECORDS; i += 17) {
+            uint64_t sequence = (uint64_t)lane * 100000 + i + 1;
+            size_t size = 0;
+            uint32_t found_lane = 0;
+            void* data = message_log_read(log, sequence, &size, &found_lane);
+            intact &= found_lane == lane && size == 128 && matches(data, size, sequence);
+            free(data);
+        }
+    }
+    CHECK(intact, "records from every appender read back");
+    message_log_close(log);
+    remove_directory(directory);
+}
+
+static void test_durability_modes(void) {
+    printf("⏱️ ASYNC lanes sync on the interval, others with their batch\n");
+    char directory[64];
+    make_directory(directory);
+    message_log_config_t config;
+    message_log_default_config(&config);
+    config.durability = MESSAGE_LOG_ASYNC;
+    config.sync_interval_ms = 20;
+    MessageLog* log = message_log_open(directory, &config);
+    if (!log) {
+        CHECK(false, "the log opens");
+        return;
+    }
+    char buffer[64];
+    fill(buffer, sizeof(buffer), 1);
+    uint64_t position = message_log_append(log, 0, 1, buffer, sizeof(buffer));
+    usleep(100000);
+    struct message_log_stats stats;
+    message_log_get_stats(log, &stats);
+    CHECK(position != 0 && stats.syncs >= 1, "an ASYNC record is synced within the interval");
+
+    message_log_set_lane_durability(log, 5, MESSAGE_LOG_SYNC);
+    uint64_t before = stats.syncs;
+    position = message_log_append(log, 5, 2, buffer, sizeof(buffer));
+    message_log_get_stats(log, &stats);
+    CHECK(position != 0 && stats.syncs > before, "a SYNC lane returns after its own sync");
+    CHECK(message_log_wait_durable(log, position), "the position it returned is durable");
+    message_log_close(log);
+    remove_directory(directory);
+}
+
+typedef struct {
+    uint64_t first;
+    uint64_t last;
+    uint32_t count;
+    bool ordered;
+    bool intact;
+} replay_t;
+
+static void on_replay(void* context, uint32_t lane, uint64_t sequence, const void* data, size_t size) {
+    replay_t* replay = (replay_t*)context;
+    if (replay->count == 0) replay->first = sequence;
+    replay->ordered &= replay->count == 0 || sequence > replay->last;
+    replay->intact &= lane == sequence % 3 && size == 200 && matches(data, size, sequence);
+    replay->last = sequence;
+    replay->count++;
+}
+
+static void test_segments_and_replay(void) {
+    printf("🎞️ Segments roll, and a range replays in order\n");
+    char directory[64];
+    make_directory(directory);
+    message_log_config_t config;
+    message_log_default_config(&config);
+    config.segment_bytes = 16 * 1024;
+    MessageLog* log = message_log_open(directory, &config);
+    if (!log) {
+        CHECK(false, "the log opens");
+        return;
+    }
+    char buffer[200];
+    for (uint64_t sequence = 1; sequence <= 500; sequence++) {
+        fill(buffer, sizeof(buffer), sequence);
+        message_log_append(log, (uint32_t)(sequence % 3), sequence, buffer, sizeof(buffer));
+    }
+    message_log_flush(log);
+    struct message_log_stats stats;
+    message_log_get_stats(log, &stats);
+    CHECK(stats.segments > 5 && count_segments(directory) == stats.segments, "the log rolls across segment files");
+
+    replay_t replay = { 0, 0, 0, true, true };
+    uint64_t delivered = 0;
+    bool ok = message_log_replay(log, 100, 399, on_replay, &replay, &delivered);
+    CHECK(ok && delivered == 300 && replay.count == 300, "the whole range is delivered");
+    CHECK(replay.first == 100 && replay.last == 399 && replay.ordered, "in sequence order, bounds included");
+    CHECK(replay.intact, "each with its lane and payload");
+    message_log_close(log);
+
+    log = message_log_open(directory, &config);
+    replay = (replay_t){ 0, 0, 0, true, true };
+    ok = message_log_replay(log, 1, 500, on_replay, &replay, &delivered);
+    CHECK(ok && delivered == 500 && replay.intact, "a reopened log replays across every segment");
+    message_log_close(log);
+    remove_directory(directory);
+}
+
+// Swap neighbours so sequences are logged out of order
+static uint64_t shuffled(uint64_t i) {
+    return (i ^ 1) + 1;
+}
+
+#define SEEK_RECORDS 4000
+
+static void test_sparse_index(void) {
+    printf("🗂️ Reopening maps indexed segments; a range seeks through the index\n");
+    char directory[64];
+    make_directory(directory);
+    message_log_config_t config;
+    message_log_default_config(&config);
+    config.segment_bytes = 128 * 1024;
+    MessageLog* log = message_log_open(directory, &config);
+    if (!log) {
+        CHECK(false, "the log opens");
+        return;
+    }
+    char buffer[200];
+    for (uint64_t i = 0; i < SEEK_RECORDS; i++) {
+        fill(buffer, sizeof(buffer), shuffled(i));
+        message_log_append(log, (uint32_t)(i % 3), shuffled(i), buffer, sizeof(buffer));
+    }
+    message_log_close(log);
+
+    log = message_log_open(directory, &config);
+    struct message_log_stats stats;
+    message_log_get_stats(log, &stats);
+    uint32_t segments = count_segments(directory) - 1; // Less the one just opened
+    CHECK(stats.records_recovered == SEEK_RECORDS && stats.segments_indexed == segments && stats.torn_segments == 0,
+          "every segment is recovered from its index");
+
+    bool found = true;
+    for (uint64_t sequence = 1; sequence <= SEEK_RECORDS; sequence += 97) {
+        size_t size = 0;
+        uint32_t lane = 0;
+        void* data = message_log_read(log, sequence, &size, &lane);
+        found &= size == sizeof(buffer) && lane == (uint32_t)((sequence - 1) ^ 1) % 3 && matches(data, size, sequence);
+        free(data);
+    }
+    CHECK(found, "records are read through the index");
+
+    uint64_t counted = 0, delivered = 0;
+    bool ok = message_log_replay(log, 1500, 2499, count_record, &counted, &delivered);
+    CHECK(ok && delivered == 1000 && counted == 1000, "an out-of-order range replays exactly");
+    message_log_close(log);
+
+    // A crash leaves the last segment unindexed with a torn tail
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%020llu.idx", directory, 1ull);
+    CHECK(unlink(path) == 0, "the first segment's index is removed");
+    snprintf(path, sizeof(path), "%s/%020llu.wal", directory, (unsigned long long)segments);
+    FILE* file = fopen(path, "ab");
+    if (file) {
+        fputs("ULOG torn", file);
+        fclose(file);
+    }
+    snprintf(path, sizeof(path), "%s/%020llu.idx", directory, (unsigned long long)segments);
+    unlink(path);
+    log = message_log_open(directory, &config);
+    message_log_get_stats(log, &stats);
+    CHECK(stats.segments_indexed == segments - 2 && stats.torn_segments == 1 && stats.records_recovered == SEEK_RECORDS,
+          "unindexed segments are scanned and the torn tail is dropped");
+    ok = message_log_replay(log, 1, SEEK_RECORDS, count_record, &counted, &delivered);
+    CHECK(ok && delivered == SEEK_RECORDS, "the whole log replays after the rescan");
+    message_log_close(log);
+    remove_directory(directory);
+}
+
+#define REPLAY_LANES 8
+#define REPLAY_RECORDS 4000
+
+typedef struct {
+    uint64_t last[REPLAY_LANES];
+    uint32_t count[REPLAY_LANES];
+    bool ordered[REPLAY_LANES];
+    bool intact[REPLAY_LANES];
+} lanes_t;
+
+// Each lane is delivered by one worker at a time, so its slot needs no lock
+static void on_lane_replay(void* context, uint32_t lane, uint64_t sequence, const void* data, size_t size) {
+    lanes_t* lanes = (lanes_t*)context;
+    if (lane >= REPLAY_LANES) return;
+    lanes->ordered[lane] &= sequence > lanes->last[lane];
+    lanes->intact[lane] &= (sequence - 1) % REPLAY_LANES == lane && size == 64 && matches(data, size, sequence);
+    lanes->last[lane] = sequence;
+    lanes->count[lane]++;
+}
+
+static void test_parallel_replay(void) {
+    printf("🧵 Parallel replay keeps each lane in order\n");
+    char directory[64];
+    make_directory(directory);
+    message_log_config_t config;
+    message_log_default_config(&config);
+    config.segment_bytes = 64 * 1024;
+    MessageLog* log = message_log_open(directory, &config);
+    if (!log) {
+        CHECK(false, "the log opens");
+        return;
+    }
+    char buffer[64];
+    for (uint64_t sequence = 1; sequence <= REPLAY_RECORDS / 2; sequence++) {
+        fill(buffer, sizeof(buffer), sequence);
+        message_log_append(log, (uint32_t)((sequence - 1) % REPLAY_LANES), sequence, buffer, sizeof(buffer));
+    }
+    message_log_close(log);
+
+    // Half mapped from the last run, half appended since
+    log = message_log_open(directory, &config);
+    for (uint64_t sequence = REPLAY_RECORDS / 2 + 1; sequence <= REPLAY_RECORDS; sequence++) {
+        fill(buffer, sizeof(buffer), sequence);
+        message_log_append(log, (uint32_t)((sequence - 1) % REPLAY_LANES), sequence, buffer, sizeof(buffer));
+    }
+    lanes_t lanes;
+    memset(&lanes, 0, sizeof(lanes));
+    for (int i = 0; i < REPLAY_LANES; i++) lanes.ordered[i] = lanes.intact[i] = true;
+    uint64_t delivered = 0;
+    bool ok = message_log_replay_parallel(log, 1, REPLAY_RECORDS, on_lane_replay, &lanes, 4, &delivered);
+    bool ordered = true, intact = true, even = true;
+    for (int i = 0; i < REPLAY_LANES; i++) {
+        ordered &= lanes.ordered[i];
+        intact &= lanes.intact[i];
+        even &= lanes.count[i] == REPLAY_RECORDS / REPLAY_LANES;
+    }
+    CHECK(ok && delivered == REPLAY_RECORDS && even, "every record reaches its own lane");
+    CHECK(ordered, "each lane sees its records in log order");
+    CHECK(intact, "with their payloads");
+    message_log_close(log);
+    remove_directory(directory);
+}
+
+static uint32_t handler_calls = 0;
+
+static void count_replayed(void* context, uint32_t lane, uint64_t sequence, const void* data, size_t size) {
+    (void)context;
+    (void)data;
+    handler_calls += lane == 7 && size == 32 && sequence >= 10 && sequence <= 19;
+}
+
+static void test_fault_tolerance(void) {
+    printf("🛡️ Fault tolerance persists, recovers and replays through the log\n");
+    char directory[64];
+    make_directory(directory);
+    fault_tolerance_manager_t manager;
+    fault_tolerance_init(&manager, 16);
+    char buffer[32];
+    CHECK(!fault_tolerance_persist_message(1, buffer, sizeof(buffer)), "nothing persists before a log is attached");
+    CHECK(fault_tolerance_enable_persistence(&manager, directory, NULL), "a log attaches");
+
+    bool persisted = true;
+    for (uint64_t sequence = 10; sequence < 20; sequence++) {
+        fill(buffer, sizeof(buffer), sequence);
+        persisted &= fault_tolerance_persist_lane_message(7, sequence, buffer, sizeof(buffer));
+    }
+    CHECK(persisted, "lane messages persist");
+    size_t size = 0;
+    void* data = fault_tolerance_recover_message(15, &size);
+    CHECK(size == sizeof(buffer) && matches(data, size, 15), "a persisted message is recovered");
+    free(data);
+    data = fault_tolerance_recover_message(99, &size);
+    CHECK(data == NULL && size == 0, "a missing one reports size 0");
+
+    fault_tolerance_set_replay_handler(&manager, count_replayed, NULL);
+    CHECK(fault_tolerance_replay_messages(&manager, 0, 100) && handler_calls == 10, "replay reaches the handler");
+    struct fault_tolerance_metrics metrics;
+    fault_tolerance_get_metrics(&manager, &metrics);
+    CHECK(metrics.messages_persisted == 10 && metrics.messages_recovered == 11, "metrics count both directions");
+    fault_tolerance_destroy(&manager);
+    CHECK(!fault_tolerance_persist_message(1, buffer, sizeof(buffer)), "destroy closes the log");
+    remove_directory(directory);
+}
+
+int main(void) {
+    printf("🧪 Message Log Tests\n");
+    test_append_and_recover();
+    test_torn_tail();
+    test_group_commit();
+    test_durability_modes();
+    test_segments_and_replay();
+    test_sparse_index();
+    test_parallel_replay();
+    test_fault_tolerance();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All message log tests passed\n");
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "test_check.h"
+
+static void test_size_classes(void) {
+    printf("📦 Size classes\n");
+    void* tiny = message_pool_alloc(0);
+    void* small = message_pool_alloc(65);
+    void* top = message_pool_alloc(MESSAGE_POOL_MAX_SIZE);
+    void* large = message_pool_alloc(MESSAGE_POOL_MAX_SIZE + 1);
+    CHECK(message_pool_capacity(tiny) == MESSAGE_POOL_MIN_SIZE, "zero-byte requests get the smallest class");
+    CHECK(message_pool_capacity(small) == 128, "requests round up to the next power of two");
+    CHECK(message_pool_capacity(top) == MESSAGE_POOL_MAX_SIZE, "the largest class is served from the pool");
+    CHECK(message_pool_capacity(large) == MESSAGE_POOL_MAX_SIZE + 1, "oversized requests fall through to the heap");
+
+    int aligned = 1;
+    void* ptrs[] = { tiny, small, top, large };
+    for (size_t i = 0; i < 4; ++i) {
+        if ((size_t)ptrs[i] % MESSAGE_POOL_ALIGNMENT) aligned = 0;
+        message_pool_release(ptrs[i]);
+    }
+    CHECK(aligned, "all results are MESSAGE_POOL_ALIGNMENT-aligned");
+    message_pool_release(NULL);
+
+    void* again = message_pool_alloc(100);
+    CHECK(again == small, "a released block is reused by the same thread");
+    message_pool_release(again);
+}
+
+static void test_bus_drain_steady_state(void) {
+    printf("🚌 Steady-state draining makes no heap calls\n");
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(64 * 1024, 2);
+    char msg[300];
+    memset(msg, 'm', sizeof(msg));
+
+    // Warm the classes used below, then count
+    for (size_t i = 0; i < sizeof(msg); ++i) {
+        umsbb_submit_to(bus, 0, msg, 1 + i);
+        size_t size;
+        umsbb_message_release(umsbb_drain_from(bus, 0, &size));
+    }
+    size_t before = message_pool_heap_allocations();
+
+    int intact = 1;
+    for (int i = 0; i < 100000; ++i) {
+        size_t len = 1 + (size_t)i % sizeof(msg);
+        umsbb_submit_to(bus, 0, msg, len);
+        size_t size;
+        char* out = umsbb_drain_from(bus, 0, &size);
+        if (!out || size != len || memcmp(out, msg, len) != 0) intact = 0;
+        umsbb_message_release(out);
+    }
+    CHECK(intact, "drained copies match what was submitted");
+    CHECK(message_pool_heap_allocations() == before, "no heap allocations after warm-up");
+
+    universal_data_t* udata = NULL;
+    umsbb_submit_to(bus, 1, msg, 40);
+    for (int i = 0; i < 4 && !udata; ++i) udata = umsbb_drain_direct(bus, LANG_C);
+    CHECK(udata && udata->size == 40 && memcmp(udata->data, msg, 40) == 0, "umsbb_drain_direct adopts the pooled copy");
+
+    universal_data_t converted;
+    CHECK(udata && convert_data_for_language(udata, &converted, LANG_PYTHON) &&
+          converted.source_lang == LANG_PYTHON, "conversion copies into a pooled payload");
+    if (udata) message_pool_release(converted.data);
+    free_universal_data(udata);
+    umsbb_free(bus);
+}
+
+static void test_direct_borrowed(void) {
+    printf("🦀 Borrowed direct sends and in-place views\n");
+    void* bus = umsbb_create_direct(4096, 2, LANG_RUST);
+    char msg[48];
+    memset(msg, 'r', sizeof(msg));
+
+    // Warm the pool, then count heap calls over a steady stream
+    for (int i = 0; i < 64; ++i) {
+        size_t size;
+        umsbb_send_direct(bus, 0, msg, sizeof(msg));
+        umsbb_message_release(umsbb_take_direct(bus, &size, NULL));
+    }
+    size_t before = message_pool_heap_allocations();
+    int intact = 1;
+    for (int i = 0; i < 1000; ++i) {
+        if (!umsbb_send_direct(bus, (uint32_t)i, msg, sizeof(msg))) intact = 0;
+        const void* data;
+        size_t size, lane;
+        if (!umsbb_view_direct(bus, &data, &size, &lane) || size != sizeof(msg) ||
+            lane != (size_t)i % 2 || memcmp(data, msg, size) != 0) intact = 0;
+        umsbb_release_direct(bus, lane);
+    }
+    CHECK(intact, "views show the borrowed bytes on the type's lane");
+    CHECK(message_pool_heap_allocations() == before, "sending and viewing make no heap calls");
+
+    const void* first;
+    const void* again;
+    size_t size, lane;
+    umsbb_send_direct(bus, 1, "one", 3);
+    umsbb_send_direct(bus, 1, "two", 3);
+    CHECK(umsbb_view_direct(bus, &first, &size, &lane) && umsbb_view_direct(bus, &again, &size, &lane) &&
+          first == again, "a held view is returned until it is released");
+    umsbb_release_direct(bus, lane);
+    uint32_t type_id = 0;
+    char* taken = umsbb_take_direct(bus, &size, &type_id);
+    CHECK(taken && size == 3 && memcmp(taken, "two", 3) == 0 && type_id == 1, "a release moves the lane on");
+    umsbb_message_release(taken);
+    CHECK(!umsbb_view_direct(bus, &first, &size, &lane) && !umsbb_take_direct(bus, &size, NULL),
+          "an empty bus has nothing to view or take");
+    CHECK(!umsbb_send_direct(bus, 0, NULL, 8), "a missing payload is refused");
+    umsbb_destroy_direct(bus);
+}
+
+#define ROUNDS 200000
+
+static BiBuffer handoff;
+static atomic_size_t consumerDone;
+
+static void* consumer_main(void* arg) {
+    (void)arg;
+    size_t received = 0;
+    while (received < ROUNDS) {
+        size_t size;
+        void** slot = bi_buffer_read(&handoff, &size);
+        if (!slot) {
+            sched_yield();
+            continue;
+        }
+        void* block = *slot;
+        bi_buffer_release(&handoff);
+        message_pool_release(block);
+        received++;
+    }
+    message_pool_thread_flush();
+    atomic_store_size(&consumerDone, 1);
+    return NULL;
+}
+
+static void test_cross_thread_release(void) {
+    printf("🧵 Blocks drained on one thread and released on another\n");
+    bi_buffer_init_mode(&handoff, 4096, BI_BUFFER_MODE_SPSC);
+    atomic_store_size(&consumerDone, 0);
+
+    pthread_t consumer;
+    pthread_create(&consumer, NULL, consumer_main, NULL);
+
+    size_t before = message_pool_heap_allocations();
+    for (int i = 0; i < ROUNDS; ++i) {
+        void* block = message_pool_alloc(512);
+        memset(block, i & 0xFF, 512);
+        void** slot;
+        while ((slot = bi_buffer_claim(&handoff, sizeof(void*))) == NULL) sched_yield();
+        *slot = block;
+        bi_buffer_commit(&handoff, slot, sizeof(void*));
+    }
+    pthread_join(consumer, NULL);
+    size_t fresh = message_pool_heap_allocations() - before;
+    bi_buffer_destroy(&handoff);
+
+    printf("  ℹ️ %zu heap allocations for %d messages\n", fresh, ROUNDS);
+    CHECK(atomic_load_size(&consumerDone) == 1, "consumer saw every block");
+    // Bounded by what can be in flight in the ring plus the cached batches
+    CHECK(fresh < 1024, "blocks flow back to the producer through the depot");
+}
+
+#define EXIT_BLOCKS 16
+
+static void* exiting_main(void* arg) {
+    (void)arg;
+    void* blocks[EXIT_BLOCKS];
+    for (int i = 0; i < EXIT_BLOCKS; ++i) blocks[i] = message_pool_alloc(MESSAGE_POOL_MAX_SIZE);
+    for (int i = 0; i < EXIT_BLOCKS; ++i) message_pool_release(blocks[i]);
+    return NULL;    // No flush: thread exit hands the cache back
+}
+
+static void test_thread_exit_flush(void) {
+    printf("🚪 A thread's cached blocks return to the depot when it exits\n");
+    pthread_t worker;
+    pthread_create(&worker, NULL, exiting_main, NULL);
+    pthread_join(worker, NULL);
+
+    size_t before = message_pool_heap_allocations();
+    void* blocks[EXIT_BLOCKS];
+    for (int i = 0; i < EXIT_BLOCKS; ++i) blocks[i] = message_pool_alloc(MESSAGE_POOL_MAX_SIZE);
+    CHECK(message_pool_heap_allocations() == before, "the exited thread's blocks are reused");
+    for (int i = 0; i < EXIT_BLOCKS; ++i) message_pool_release(blocks[i]);
+}
+
+int main(void) {
+    printf("🧪 Message Pool Tests\n");
+    printf("=====================\n");
+
+    test_size_classes();
+    test_bus_drain_steady_state();
+    test_direct_borrowed();
+    test_cross_thread_release();
+    test_thread_exit_flush();
+
+    if (failures) {
+        printf("\n❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✅ All message pool tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include "../include/metrics_registry.h"
+#include "../include/fast_lane.h"
+#include "../include/feedback_handshake.h"
+#include "../include/fault_tolerance.h"
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include "../include/message_pool.h"
+#include "../include/portable_atomic.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "test_check.h"
+
+static size_t occurrences(const char* text, const char* needle) {
+    size_t count = 0;
+    for (const char* p = strstr(text, needle); p; p = strstr(p + 1, needle)) count++;
+    return count;
+}
+
+static double half_of(const void* context) {
+    return *(const uint64_t*)context / 2.0;
+}
+
+static void test_series(void) {
+    printf("📈 Words, callbacks and families\n");
+    MetricsRegistry* registry = metrics_registry_create();
+    MetricsText text = {0};
+
+    uint32_t narrow = 7;
+    uint64_t wide = 1ull << 40;
+    size_t sized = 12345;
+    double ratio = 0.25;
+    int owner_a, owner_b;
+
+    CHECK(metrics_registry_add(registry, &owner_a, METRIC_GAUGE, "test_narrow", "A u32", NULL, METRIC_U32, &narrow) &&
+          metrics_registry_add(registry, &owner_a, METRIC_COUNTER, "test_wide_total", "A u64", "lane=\"a\"",
+                               METRIC_U64, &wide) &&
+          metrics_registry_add(registry, &owner_b, METRIC_COUNTER, "test_sized_total", "A size_t", NULL,
+                               METRIC_SIZE, &sized) &&
+          metrics_registry_add(registry, &owner_b, METRIC_GAUGE, "test_ratio", "A double", NULL, METRIC_DOUBLE,
+                               &ratio) &&
+          metrics_registry_add_fn(registry, &owner_b, METRIC_GAUGE, "test_half", "Derived", NULL, half_of, &wide),
+          "every width and a callback register");
+    // A second lane of the first family arrives last but renders beside the first
+    CHECK(metrics_registry_add(registry, &owner_b, METRIC_COUNTER, "test_wide_total", "A u64", "lane=\"b\"",
+                               METRIC_U64, &wide), "a second series joins its family");
+    CHECK(metrics_registry_add(registry, &owner_a, METRIC_GAUGE, "test_narrow", "A u32", NULL, METRIC_U32, &narrow) &&
+          metrics_registry_count(registry) == 6, "registering an existing series is a no-op");
+    CHECK(!metrics_registry_add(registry, &owner_a, METRIC_GAUGE, "test_wide_total", "", "lane=\"c\"",
+                                METRIC_U64, &wide), "a family keeps its type");
+    CHECK(!metrics_registry_add(registry, &owner_a, METRIC_GAUGE, "9starts_with_digit", "", NULL, METRIC_U32,
+                                &narrow) &&
+          !metrics_registry_add(registry, &owner_a, METRIC_GAUGE, "has-dash", "", NULL, METRIC_U32, &narrow) &&
+          !metrics_registry_add(registry, &owner_a, METRIC_GAUGE, "", "", NULL, METRIC_U32, &narrow),
+          "invalid names are refused");
+
+    CHECK(metrics_registry_render(registry, &text), "render succeeds");
+    CHECK(strstr(text.data, "# HELP test_narrow A u32\n# TYPE test_narrow gauge\ntest_narrow 7\n") != NULL,
+          "u32 gauge with HELP and TYPE");
+    CHECK(strstr(text.data, "test_wide_total{lane=\"a\"} 1099511627776\ntest_wide_total{lane=\"b\"} 1099511627776\n")
+          != NULL && occurrences(text.data, "# TYPE test_wide_total counter") == 1,
+          "one family header, series adjacent");
+    CHECK(strstr(text.data, "test_sized_total 12345\n") && strstr(text.data, "test_ratio 0.25\n") &&
+          strstr(text.data, "test_half 549755813888\n"), "size_t, double and callback values");
+
+    // Values are read at render time, never cached
+    narrow = 8;
+    ratio = 0.0 / 0.0;
+    size_t capacity = text.capacity;
+    metrics_registry_render(registry, &text);
+    CHECK(strstr(text.data, "test_narrow 8\n") && strstr(text.data, "test_ratio NaN\n"),
+          "a later render sees new values; NaN spelled for Prometheus");
+    CHECK(text.capacity == capacity, "a steady render reuses its buffer");
+
+    CHECK(metrics_registry_remove(registry, &owner_a, 0) == 2 && metrics_registry_count(registry) == 4,
+          "removing an owner drops only its series");
+    metrics_registry_render(registry, &text);
+    CHECK(!strstr(text.data, "test_narrow") && strstr(text.data, "test_wide_total{lane=\"b\"}"),
+          "removed series stop rendering");
+
+    char labels[METRICS_LABELS_MAX];
+    CHECK(strcmp(metrics_labels(labels, sizeof(labels), "bus=\"main\"", "lane", "bulk"),
+                 "bus=\"main\",lane=\"bulk\"") == 0 &&
+          strcmp(metrics_labels(labels, sizeof(labels), NULL, "lane", "bulk"), "lane=\"bulk\"") == 0,
+          "label sets join");
+
+    metrics_text_free(&text);
+    metrics_registry_destroy(registry);
+}
+
+static void test_histogram(void) {
+    printf("⏱️ Histograms in seconds\n");
+    MetricsRegistry* registry = metrics_registry_create();
+    LatencyHistogram* h = latency_histogram_create();
+    MetricsText text = {0};
+
+    for (int i = 0; i < 90; ++i) latency_histogram_record(h, 800);         // under 1 us
+    for (int i = 0; i < 10; ++i) latency_histogram_record(h, 2000000);     // 2 ms
+    CHECK(metrics_registry_add_histogram(registry, h, "test_latency_seconds", "Latency", "lane=\"x\"", h),
+          "histogram registers");
+    metrics_registry_render(registry, &text);
+
+    CHECK(strstr(text.data, "# TYPE test_latency_seconds histogram\n") != NULL, "histogram TYPE");
+    CHECK(strstr(text.data, "test_latency_seconds_bucket{lane=\"x\",le=\"1e-06\"} 90\n") &&
+          strstr(text.data, "test_latency_seconds_bucket{lane=\"x\",le=\"0.001\"} 90\n") &&
+          strstr(text.data, "test_latency_seconds_bucket{lane=\"x\",le=\"0.005\"} 100\n") &&
+          strstr(text.data, "test_latency_seconds_bucket{lane=\"x\",le=\"+Inf\"} 100\n"),
+          "cumulative buckets");
+    CHECK(occurrences(text.data, "test_latency_seconds_bucket{") == METRICS_HISTOGRAM_BOUNDS + 1,
+          "every bound plus +Inf");
+    CHECK(strstr(text.data, "test_latency_seconds_count{lane=\"x\"} 100\n") &&
+          strstr(text.data, "test_latency_seconds_sum{lane=\"x\"} 0.02"), "count and sum");
+
+    metrics_text_free(&text);
+    metrics_registry_destroy(registry);
+    latency_histogram_destroy(h);
+}
+
+typedef struct {
+    fast_lane_manager_t* lanes;
+    atomic_bool stop;
+} producer_args;
+
+static void* produce(void* arg) {
+    producer_args* args = (producer_args*)arg;
+    char payload[32] = "scrape me";
+    struct lane_metrics m;
+    while (!atomic_load_bool(&args->stop)) {
+        if (!fast_lane_try_submit(args->lanes, LANE_EXPRESS, payload, sizeof(payload), 1)) {
+            fast_lane_get_metrics(args->lanes, LANE_EXPRESS, &m);
+        }
+    }
+    return NULL;
+}
+
+static void test_subsystems(void) {
+    printf("🛣️ Subsystems export what they keep\n");
+    MetricsRegistry* registry = metrics_registry_create();
+    MetricsText text = {0};
+
+    fast_lane_manager_t lanes;
+    handshake_manager_t handshake;
+    fault_tolerance_manager_t faults;
+    fast_lane_init(&lanes);
+    handshake_init(&handshake, 64);
+    fault_tolerance_init(&faults, 64);
+
+    CHECK(fast_lane_register_metrics(&lanes, registry, "bus=\"t\"") &&
+          handshake_register_metrics(&handshake, registry, "bus=\"t\"") &&
+          fault_tolerance_register_metrics(&faults, registry, "bus=\"t\""), "all three register");
+    size_t registered = metrics_registry_count(registry);
+    CHECK(fast_lane_register_metrics(&lanes, registry, "bus=\"t\"") && metrics_registry_count(registry) == registered,
+          "registering twice adds nothing");
+
+    char payload[16] = "x";
+    fast_lane_submit(&lanes, LANE_BULK, payload, sizeof(payload), 1);
+    handshake_send_message(&handshake, 1, 2, payload, sizeof(payload));
+    fault_tolerance_report_fault(&faults, FAULT_TYPE_TIMEOUT, 3, "slow consumer");
+
+    metrics_registry_render(registry, &text);
+    CHECK(strstr(text.data, "umsbb_lane_submitted_total{bus=\"t\",lane=\"bulk\"} 1\n") != NULL,
+          "lane submissions by lane");
+    CHECK(strstr(text.data, "umsbb_lane_latency_seconds_bucket{bus=\"t\",lane=\"express\",le=\"+Inf\"}") != NULL,
+          "lane latency histogram");
+    CHECK(strstr(text.data, "umsbb_handshake_messages_total{bus=\"t\"} 1\n") &&
+          strstr(text.data, "umsbb_handshake_pending{bus=\"t\"} 1\n"), "handshake counters");
+    CHECK(strstr(text.data, "umsbb_faults_total{bus=\"t\"} 1\n") != NULL, "fault counter");
+
+    // Scrapes run alongside a producer without stopping it
+    producer_args args;
+    args.lanes = &lanes;
+    atomic_store_bool(&args.stop, false);
+    pthread_t producer;
+    pthread_create(&producer, NULL, produce, &args);
+    bool rendered = true;
+    for (int i = 0; i < 200; ++i) rendered &= metrics_registry_render(registry, &text);
+    atomic_store_bool(&args.stop, true);
+    pthread_join(producer, NULL);
+    CHECK(rendered, "renders while the lane is hot");
+
+    metrics_registry_remove(registry, &lanes, sizeof(lanes));
+    metrics_registry_remove(registry, &handshake, sizeof(handshake));
+    metrics_registry_remove(registry, &faults, sizeof(faults));
+    CHECK(metrics_registry_count(registry) == 0, "range removal drops embedded owners");
+
+    fast_lane_destroy(&lanes);
+    handshake_destroy(&handshake);
+    fault_tolerance_destroy(&faults);
+    metrics_text_free(&text);
+    metrics_registry_destroy(registry);
+}
+
+static void test_bus(void) {
+    printf("🚌 A whole bus in one call\n");
+    MetricsRegistry* registry = metrics_registry_create();
+    MetricsText text = {0};
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(4096, 2);
+
+    CHECK(umsbb_register_metrics(bus, registry, "bus=\"main\""), "bus registers");
+    umsbb_submit_to(bus, 0, "hello", 5);
+    metrics_registry_render(registry, &text);
+    CHECK(strstr(text.data, "umsbb_frames_total{bus=\"main\"} 1\n") != NULL, "frame sequence");
+    CHECK(strstr(text.data, "umsbb_segment_committed_bytes_total{bus=\"main\",segment=\"0\"}") &&
+          strstr(text.data, "umsbb_segment_reserved_bytes_total{bus=\"main\",segment=\"1\"} 0\n"),
+          "per-segment ring positions");
+    CHECK(strstr(text.data, "umsbb_lane_submitted_total{bus=\"main\",lane=\"express\"}") &&
+          strstr(text.data, "umsbb_faults_active{bus=\"main\"}"), "embedded subsystems included");
+
+    metrics_registry_remove(registry, bus, sizeof(*bus));
+    CHECK(metrics_registry_count(registry) == 0, "removing the bus removes everything it registered");
+
+    umsbb_free(bus);
+    metrics_text_free(&text);
+    metrics_registry_destroy(registry);
+}
+
+int main(void) {
+    printf("🧪 Metrics Registry Tests\n");
+    test_series();
+    test_histogram();
+    test_subsystems();
+    test_bus();
+    message_pool_thread_flush();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All metrics registry tests passed\n");
+    return 0;
+}
@@ -0,0 +1,253 @@
+#include "../include/net_transport.h"
+#include "../include/message_pool.h"
+#include "../include/feedback_handshake.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "test_check.h"
+
+/* Two hosts joined by a stream: a lane on each side, one transport per lane. */
+typedef struct {
+    twin_lane_manager_t near, far;
+    uint32_t nearLane, farLane;
+    NetTransport* nearTransport;
+    NetTransport* farTransport;
+} Link;
+
+static bool link_open(Link* link, size_t capacity) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) return false;
+    twin_lane_init(&link->near, 1);
+    twin_lane_init(&link->far, 1);
+    link->nearLane = twin_lane_create(&link->near, 2, capacity, capacity);
+    link->farLane = twin_lane_create(&link->far, 1, capacity, capacity);
+    link->nearTransport = net_transport_create(&link->near, link->nearLane, fds[0]);
+    link->farTransport = net_transport_create(&link->far, link->farLane, fds[1]);
+    return link->nearTransport && link->farTransport;
+}
+
+static void link_close(Link* link) {
+    net_transport_destroy(link->nearTransport);
+    net_transport_destroy(link->farTransport);
+    twin_lane_destroy(&link->near);
+    twin_lane_destroy(&link->far);
+}
+
+static void fill(unsigned char* buf, size_t size, uint32_t seed) {
+    for (size_t i = 0; i < size; ++i) buf[i] = (unsigned char)(seed * 17 + i);
+}
+
+static bool matches(const unsigned char* buf, size_t size, uint32_t seed) {
+    for (size_t i = 0; i < size; ++i) {
+        if (buf[i] != (unsigned char)(seed * 17 + i)) return false;
+    }
+    return true;
+}
+
+static void* receive_wait(twin_lane_manager_t* manager, uint32_t lane, size_t* size, uint32_t* sequence) {
+    if (!twin_lane_wait(manager, lane, TWIN_DIRECTION_RX, 2000000000ull)) return NULL;
+    return twin_lane_receive(manager, lane, size, sequence);
+}
+
+static void test_request_response(void) {
+    printf("🌐 Request/response across a stream, small and bulk\n");
+    Link link;
+    CHECK(link_open(&link, 256 * 1024), "both ends bridge their lanes");
+    net_transport_start(link.nearTransport);
+    net_transport_start(link.farTransport);
+
+    static unsigned char request[100000];
+    bool intact = true;
+    for (uint32_t i = 1; i <= 2000 && intact; ++i) {
+        // Every 50th request is bulk and takes the in-place receive path
+        size_t length = i % 50 == 0 ? 40000 + i * 10 : 1 + (i * 131) % 3000;
+        fill(request, length, i);
+        while (!twin_lane_send(&link.near, link.nearLane, request, length, i)) { }
+
+        size_t size;
+        uint32_t sequence;
+        unsigned char* served = receive_wait(&link.far, link.farLane, &size, &sequence);
+        intact &= served && sequence == i && size == length && matches(served, size, i);
+        if (served) {
+            while (!twin_lane_send(&link.far, link.farLane, served, size, sequence)) { }
+            message_pool_release(served);
+        }
+
+        unsigned char* response = receive_wait(&link.near, link.nearLane, &size, &sequence);
+        intact &= response && sequence == i && size == length && matches(response, size, i);
+        message_pool_release(response);
+    }
+    CHECK(intact, "every request and response arrives whole and in order");
+
+    struct net_transport_stats stats;
+    net_transport_get_stats(link.farTransport, &stats);
+    CHECK(stats.frames_received == 2000 && stats.bytes_received > 2000u * 40000u / 50, "bulk and small frames all counted");
+    CHECK(stats.acks_received > 0 && stats.acks_sent > 0, "cumulative ACKs flow both ways");
+    link_close(&link);
+}
+
+static void put_be32(unsigned char* out, uint32_t v) {
+    out[0] = (unsigned char)(v >> 24); out[1] = (unsigned char)(v >> 16);
+    out[2] = (unsigned char)(v >> 8); out[3] = (unsigned char)v;
+}
+
+static uint32_t get_be32(const unsigned char* in) {
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+}
+
+static void test_wire_format(void) {
+    printf("🔌 Wire format and in-place bulk receive\n");
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    twin_lane_manager_t manager;
+    twin_lane_init(&manager, 1);
+    uint32_t lane = twin_lane_create(&manager, 1, 128 * 1024, 128 * 1024);
+    NetTransport* transport = net_transport_create(&manager, lane, fds[1]);
+
+    // A bulk frame whose payload arrives in two pieces
+    static unsigned char frame[NET_TRANSPORT_HEADER + 50000];
+    put_be32(frame, 50000);
+    put_be32(frame + 4, 7);
+    frame[8] = 0; frame[9] = NET_FRAME_DATA; frame[10] = 0; frame[11] = 0;
+    fill(frame + NET_TRANSPORT_HEADER, 50000, 7);
+    CHECK(write(fds[0], frame, NET_TRANSPORT_HEADER + 10000) == NET_TRANSPORT_HEADER + 10000, "the peer writes a partial frame");
+    net_transport_poll(transport);
+    size_t size;
+    uint32_t sequence;
+    CHECK(twin_lane_receive(&manager, lane, &size, &sequence) == NULL, "nothing is delivered before the frame is whole");
+    CHECK(write(fds[0], frame + NET_TRANSPORT_HEADER + 10000, 40000) == 40000, "the peer writes the rest");
+    for (int i = 0; i < 100; ++i) net_transport_poll(transport);
+
+    unsigned char* in = twin_lane_receive(&manager, lane, &size, &sequence);
+    CHECK(in && size == 50000 && sequence == 7 && matches(in, size, 7), "the bulk frame lands whole in the RX ring");
+    message_pool_release(in);
+    struct net_transport_stats stats;
+    net_transport_get_stats(transport, &stats);
+    CHECK(stats.direct_frames == 1, "its tail was read straight into the ring");
+
+    unsigned char ack[NET_TRANSPORT_HEADER];
+    CHECK(read(fds[0], ack, sizeof(ack)) == (ssize_t)sizeof(ack) && get_be32(ack + 4) == 7 &&
+          ack[9] == NET_FRAME_FEEDBACK && ack[11] == FEEDBACK_TYPE_ACK, "the delivery is acknowledged on the wire");
+
+    // An ACK from the peer credits our window
+    char msg[8] = {0};
+    for (uint32_t i = 0; i < 5; ++i) twin_lane_send(&manager, lane, msg, sizeof(msg), 100 + i);
+    for (int i = 0; i < 10; ++i) net_transport_poll(transport);
+    put_be32(ack, 0);
+    put_be32(ack + 4, 103);
+    ack[9] = NET_FRAME_FEEDBACK;
+    ack[11] = FEEDBACK_TYPE_ACK;
+    CHECK(write(fds[0], ack, sizeof(ack)) == (ssize_t)sizeof(ack), "the peer acknowledges up to 103");
+    for (int i = 0; i < 10; ++i) net_transport_poll(transport);
+    CHECK(atomic_load(&manager.lanes[lane].tx_inflight) == 1, "one ACK frame credits four sends");
+
+    net_transport_destroy(transport);
+    close(fds[0]);
+    twin_lane_destroy(&manager);
+}
+
+#define BURST 20000
+
+static void test_batching(void) {
+    printf("📦 Bursts go out in batches and ACKs reopen the window\n");
+    Link link;
+    link_open(&link, 64 * 1024);
+    net_transport_start(link.farTransport);
+
+    // Fill the window before the near transport runs, so its first passes batch
+    unsigned char msg[64];
+    uint32_t sent = 0, received = 0;
+    bool ordered = true;
+    while (sent < 64) {
+        fill(msg, sizeof(msg), sent);
+        twin_lane_send(&link.near, link.nearLane, msg, sizeof(msg), sent);
+        sent++;
+    }
+    net_transport_start(link.nearTransport);
+    while (received < BURST) {
+        if (sent < BURST) {
+            fill(msg, sizeof(msg), sent);
+            if (twin_lane_send(&link.near, link.nearLane, msg, sizeof(msg), sent)) sent++;
+        }
+        size_t size;
+        uint32_t sequence;
+        unsigned char* in = twin_lane_receive(&link.far, link.farLane, &size, &sequence);
+        if (in) {
+            ordered &= sequence == received++ && size == sizeof(msg) && matches(in, size, sequence);
+            message_pool_release(in);
+        }
+    }
+    CHECK(ordered, "a burst arrives in order");
+
+    struct net_transport_stats nearStats, farStats;
+    net_transport_get_stats(link.nearTransport, &nearStats);
+    net_transport_get_stats(link.farTransport, &farStats);
+    printf("  ℹ️  %llu frames in %llu sends, %llu ACKs\n", (unsigned long long)nearStats.frames_sent,
+           (unsigned long long)nearStats.send_calls, (unsigned long long)nearStats.acks_received);
+    CHECK(nearStats.frames_sent == BURST && nearStats.send_calls < BURST, "frames share sendmsg calls");
+    CHECK(farStats.acks_sent < BURST, "one ACK covers many frames");
+
+    for (int spin = 0; spin < 2000 && atomic_load(&link.near.lanes[link.nearLane].tx_inflight); ++spin) usleep(1000);
+    CHECK(atomic_load(&link.near.lanes[link.nearLane].tx_inflight) == 0, "the last ACK empties the window");
+    link_close(&link);
+}
+
+static void test_backpressure(void) {
+    printf("🧱 A full RX ring stops reading instead of dropping\n");
+    Link link;
+    link_open(&link, 4096);
+    unsigned char msg[1000];
+    uint32_t sent = 0;
+    // Without ACKs the window caps it; without receives the far ring fills
+    for (int round = 0; round < 200; ++round) {
+        fill(msg, sizeof(msg), sent);
+        if (twin_lane_send(&link.near, link.nearLane, msg, sizeof(msg), sent)) sent++;
+        net_transport_poll(link.nearTransport);
+        net_transport_poll(link.farTransport);
+    }
+    struct net_transport_stats stats;
+    net_transport_get_stats(link.farTransport, &stats);
+    CHECK(stats.frames_received < sent && stats.frames_received >= 3, "delivery pauses at the ring's capacity");
+
+    uint32_t received = 0;
+    bool ordered = true;
+    for (int round = 0; round < 100000 && received < sent; ++round) {
+        net_transport_poll(link.nearTransport);
+        net_transport_poll(link.farTransport);
+        size_t size;
+        uint32_t sequence;
+        unsigned char* in = twin_lane_receive(&link.far, link.farLane, &size, &sequence);
+        if (in) {
+            ordered &= sequence == received++ && matches(in, size, sequence);
+            message_pool_release(in);
+        }
+    }
+    CHECK(received == sent && ordered, "draining the ring lets the rest through, nothing lost");
+
+    net_transport_destroy(link.farTransport);
+    link.farTransport = NULL;
+    for (int round = 0; round < 1000 && net_transport_is_open(link.nearTransport); ++round) {
+        net_transport_poll(link.nearTransport);
+        usleep(100);
+    }
+    CHECK(!net_transport_is_open(link.nearTransport), "a closed peer is noticed");
+    link_close(&link);
+}
+
+int main(void) {
+    printf("🧪 Network Transport Tests\n");
+    test_request_response();
+    test_wire_format();
+    test_batching();
+    test_backpressure();
+    message_pool_thread_flush();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All network transport tests passed\n");
+    return 0;
+}
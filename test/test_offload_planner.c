@@ -0,0 +1,173 @@
+#include "../include/offload_planner.h"
+#include "../include/umsbb_clock.h"
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include <stdio.h>
+#include <string.h>
+#include "test_check.h"
+
+typedef struct {
+    double fixedNs;
+    double nsPerByte;
+} cost_t;
+
+static void feed(OffloadPlanner* planner, OffloadOp op, OffloadPath path, cost_t cost, int rounds) {
+    for (int r = 0; r < rounds; r++) {
+        for (size_t size = 4096; size <= 64u * 1024 * 1024; size *= 2) {
+            // Unbiased noise of +-2%
+            double noise = 1.0 + 0.02 * (double)((int)((size >> 12) + r) % 3 - 1);
+            uint64_t ns = (uint64_t)((cost.fixedNs + cost.nsPerByte * size) * noise);
+            if (path == OFFLOAD_PATH_GPU) offload_planner_choose(planner, op, size);
+            offload_planner_complete(planner, op, path, size, ns, true);
+        }
+    }
+}
+
+static bool near(double value, double expected, double tolerance) {
+    return value > expected * (1 - tolerance) && value < expected * (1 + tolerance);
+}
+
+static void test_crossover(void) {
+    printf("📐 The crossover follows the fitted cost lines\n");
+    OffloadPlanner planner;
+    offload_planner_init(&planner, true);
+    CHECK(offload_planner_choose(&planner, OFFLOAD_OP_SUBMIT, 512 * 1024) == OFFLOAD_PATH_CPU &&
+          offload_planner_choose(&planner, OFFLOAD_OP_SUBMIT, 2 * 1024 * 1024) == OFFLOAD_PATH_GPU,
+          "without samples the default cutoff applies");
+    offload_planner_complete(&planner, OFFLOAD_OP_SUBMIT, OFFLOAD_PATH_GPU, 2 * 1024 * 1024, 0, false);
+
+    // memcpy at 0.1 ns/B against a GPU with 0.8 ms launch cost and 0.005 ns/B
+    feed(&planner, OFFLOAD_OP_SUBMIT, OFFLOAD_PATH_CPU, (cost_t){ 200, 0.1 }, 4);
+    feed(&planner, OFFLOAD_OP_SUBMIT, OFFLOAD_PATH_GPU, (cost_t){ 800000, 0.005 }, 4);
+    OffloadStats stats;
+    offload_planner_stats(&planner, OFFLOAD_OP_SUBMIT, &stats);
+    CHECK(near(stats.cpuNsPerByte, 0.1, 0.1) && near(stats.gpuFixedNs, 800000, 0.1) && near(stats.gpuNsPerByte, 0.005, 0.3),
+          "both cost models are recovered from noisy samples");
+    double expected = (800000.0 - 200) / (0.1 - 0.005);
+    CHECK(near((double)stats.crossover, expected, 0.1), "the crossover is where the lines meet (~8 MB)");
+    printf("     crossover %zu bytes\n", stats.crossover);
+    CHECK(stats.gpuInFlight == 0, "every GPU pick was completed");
+
+    CHECK(offload_planner_choose(&planner, OFFLOAD_OP_SUBMIT, 1024 * 1024) == OFFLOAD_PATH_CPU,
+          "1 MB stays on the CPU on this node");
+    OffloadPath big = offload_planner_choose(&planner, OFFLOAD_OP_SUBMIT, 32u * 1024 * 1024);
+    CHECK(big == OFFLOAD_PATH_GPU, "32 MB goes to the GPU");
+    offload_planner_complete(&planner, OFFLOAD_OP_SUBMIT, big, 32u * 1024 * 1024, 0, false);
+    CHECK(offload_planner_crossover(&planner, OFFLOAD_OP_DRAIN) == OFFLOAD_PLANNER_DEFAULT_CROSSOVER,
+          "each operation type keeps its own crossover");
+}
+
+static void test_online_adjustment(void) {
+    printf("🔄 Observed completions move the crossover\n");
+    OffloadPlanner planner;
+    offload_planner_init(&planner, true);
+    feed(&planner, OFFLOAD_OP_DRAIN, OFFLOAD_PATH_CPU, (cost_t){ 200, 0.1 }, 2);
+    feed(&planner, OFFLOAD_OP_DRAIN, OFFLOAD_PATH_GPU, (cost_t){ 800000, 0.005 }, 2);
+    size_t before = offload_planner_crossover(&planner, OFFLOAD_OP_DRAIN);
+
+    // A faster device link: 20 us launch
+    feed(&planner, OFFLOAD_OP_DRAIN, OFFLOAD_PATH_GPU, (cost_t){ 20000, 0.005 }, 40);
+    size_t after = offload_planner_crossover(&planner, OFFLOAD_OP_DRAIN);
+    CHECK(after < before / 10 && near((double)after, (20000.0 - 200) / 0.095, 0.2),
+          "a faster GPU pulls the crossover down to ~256 KB");
+    printf("     %zu -> %zu bytes\n", before, after);
+
+    // A GPU that never beats memcpy
+    feed(&planner, OFFLOAD_OP_DRAIN, OFFLOAD_PATH_GPU, (cost_t){ 20000, 0.2 }, 40);
+    CHECK(offload_planner_crossover(&planner, OFFLOAD_OP_DRAIN) == SIZE_MAX, "a slower-per-byte GPU never wins");
+}
+
+static void test_queue_depth(void) {
+    printf("🚦 GPU work in flight pushes messages back to the CPU\n");
+    OffloadPlanner planner;
+    offload_planner_init(&planner, true);
+    feed(&planner, OFFLOAD_OP_SUBMIT, OFFLOAD_PATH_CPU, (cost_t){ 200, 0.1 }, 2);
+    feed(&planner, OFFLOAD_OP_SUBMIT, OFFLOAD_PATH_GPU, (cost_t){ 100000, 0.005 }, 2);
+
+    size_t size = 4u * 1024 * 1024;    // ~420 us on the CPU, ~120 us on an idle GPU
+    int gpu = 0;
+    for (int i = 0; i < 8; i++) gpu += offload_planner_choose(&planner, OFFLOAD_OP_SUBMIT, size) == OFFLOAD_PATH_GPU;
+    OffloadStats stats;
+    offload_planner_stats(&planner, OFFLOAD_OP_SUBMIT, &stats);
+    CHECK(gpu >= 1 && gpu < 8 && stats.gpuInFlight == (uint32_t)gpu, "offloading stops once the queue is deep");
+    CHECK(offload_planner_choose(&planner, OFFLOAD_OP_SUBMIT, size) == OFFLOAD_PATH_CPU, "the next message runs on the CPU");
+    for (int i = 0; i < gpu; i++) offload_planner_complete(&planner, OFFLOAD_OP_SUBMIT, OFFLOAD_PATH_GPU, size, 120000, true);
+    CHECK(offload_planner_choose(&planner, OFFLOAD_OP_SUBMIT, size) == OFFLOAD_PATH_GPU, "a drained queue offloads again");
+    offload_planner_complete(&planner, OFFLOAD_OP_SUBMIT, OFFLOAD_PATH_GPU, size, 120000, true);
+
+    size_t crossover = offload_planner_crossover(&planner, OFFLOAD_OP_SUBMIT);
+    uint32_t other = 0;
+    for (int i = 0; i < 10 * OFFLOAD_PLANNER_EXPLORE_EVERY; i++) {
+        OffloadPath path = offload_planner_choose(&planner, OFFLOAD_OP_SUBMIT, crossover / 2);
+        other += path == OFFLOAD_PATH_GPU;
+        offload_planner_complete(&planner, OFFLOAD_OP_SUBMIT, path, crossover / 2, 0, false);
+    }
+    offload_planner_stats(&planner, OFFLOAD_OP_SUBMIT, &stats);
+    CHECK(other >= 9 && other <= 11 && stats.explored == other, "near the crossover the other path is sampled now and then");
+}
+
+static bool busy_gpu(void* context, void* dst, const void* src, size_t size) {
+    (void)context;
+    (void)dst;
+    (void)src;
+    // 100 us launch, then 50 GB/s
+    uint64_t until = umsbb_clock_ns() + 100000 + size / 50;
+    while (umsbb_clock_ns() < until) {
+    }
+    return true;
+}
+
+static bool cpu_copy(void* context, void* dst, const void* src, size_t size) {
+    (void)context;
+    memcpy(dst, src, size);
+    return true;
+}
+
+static bool broken_gpu(void* context, void* dst, const void* src, size_t size) {
+    (void)context;
+    (void)dst;
+    (void)src;
+    (void)size;
+    return false;
+}
+
+static void test_calibration(void) {
+    printf("⏱️ Startup calibration seeds every operation\n");
+    OffloadPlanner planner;
+    offload_planner_init(&planner, true);
+    CHECK(offload_planner_calibrate(&planner, cpu_copy, busy_gpu, NULL, 16u * 1024 * 1024), "calibration runs");
+    OffloadStats submit, drain;
+    offload_planner_stats(&planner, OFFLOAD_OP_SUBMIT, &submit);
+    offload_planner_stats(&planner, OFFLOAD_OP_DRAIN, &drain);
+    CHECK(submit.cpuSamples == 7 && submit.gpuSamples == 7 && drain.crossover == submit.crossover,
+          "seven sizes from 4 KB to 16 MB are timed for both operations");
+    CHECK(near(submit.gpuFixedNs, 100000, 0.5), "the GPU launch latency is measured");
+    printf("     memcpy %.3f ns/B, crossover %zu bytes\n", submit.cpuNsPerByte, submit.crossover);
+    CHECK(offload_planner_choose(&planner, OFFLOAD_OP_DRAIN, 4096) == OFFLOAD_PATH_CPU, "small messages stay on the CPU");
+
+    OffloadPlanner broken;
+    offload_planner_init(&broken, true);
+    CHECK(!offload_planner_calibrate(&broken, cpu_copy, broken_gpu, NULL, 1024 * 1024) &&
+          offload_planner_choose(&broken, OFFLOAD_OP_SUBMIT, 64u * 1024 * 1024) == OFFLOAD_PATH_CPU,
+          "a failing GPU path disables offloading");
+
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(1 << 20, 2);
+    OffloadStats stats;
+    CHECK(bus && umsbb_get_offload_stats(bus, OFFLOAD_OP_SUBMIT, &stats) &&
+          (bus->gpu_enabled || stats.crossover == SIZE_MAX), "a bus without a GPU never offloads");
+    umsbb_free(bus);
+}
+
+int main(void) {
+    printf("🧪 Offload Planner Tests\n");
+    test_crossover();
+    test_online_adjustment();
+    test_queue_depth();
+    test_calibration();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All offload planner tests passed\n");
+    return 0;
+}
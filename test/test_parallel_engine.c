@@ -0,0 +1,560 @@
+#define _GNU_SOURCE
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include "../include/umsbb_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "test_check.h"
+
+static char payload[256];
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static uint64_t processed(parallel_engine_t* engine) {
+    performance_profile_t profile;
+    parallel_get_performance(engine, &profile);
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < profile.worker_count; i++) total += profile.workers[i].messages_processed;
+    return total;
+}
+
+/* Wait until `expected` items were processed, or about five seconds. */
+static bool wait_processed(parallel_engine_t* engine, uint64_t expected) {
+    for (int i = 0; i < 5000 && processed(engine) < expected; i++) sleep_ms(1);
+    return processed(engine) == expected;
+}
+
+#define SKEWED_ITEMS 200000
+
+static void test_skewed_lanes(void) {
+    printf("🪣 Skewed lane traffic spreads over every worker\n");
+    parallel_engine_t engine;
+    CHECK(parallel_engine_init(&engine, 4, THROUGHPUT_STRATEGY_BALANCED) == 0, "engine initializes");
+    CHECK(engine.load_balance_strategy == PARALLEL_BALANCE_WORK_STEALING, "work-stealing is the default");
+    parallel_engine_start(&engine);
+
+    // Enough items that every worker gets scheduled while they flow
+    for (int i = 0; i < SKEWED_ITEMS; i++) {
+        while (parallel_submit_work(&engine, 0, payload, sizeof(payload), 0, 0) != 0) sched_yield();
+    }
+    CHECK(wait_processed(&engine, SKEWED_ITEMS), "every item is processed exactly once");
+
+    performance_profile_t profile;
+    parallel_get_performance(&engine, &profile);
+    bool everyone = true;
+    for (uint32_t i = 0; i < 4; i++) everyone &= profile.workers[i].messages_processed > 0;
+    CHECK(everyone, "workers homed on idle lanes took part");
+    CHECK(profile.steals > 0 && profile.items_stolen >= profile.steals, "steals are counted per operation and item");
+    CHECK(parallel_get_queue_depth(&engine, 0) == 0, "the lane queue is drained");
+    sleep_ms(20);
+    parallel_get_performance(&engine, &profile);
+    CHECK(profile.idle_rounds > 0, "idle passes are counted");
+    parallel_engine_destroy(&engine);
+}
+
+static void test_unhomed_lane(void) {
+    printf("🏚️  Lanes without a home worker are still served\n");
+    parallel_engine_t engine;
+    parallel_engine_init(&engine, 2, THROUGHPUT_STRATEGY_LATENCY_OPTIMIZED);
+    parallel_engine_start(&engine);
+    for (int i = 0; i < 200; i++) parallel_submit_work(&engine, 3, payload, 64, 0, 0);
+    CHECK(wait_processed(&engine, 200), "lane 3 is drained by stealing workers");
+    parallel_engine_destroy(&engine);
+}
+
+static void test_round_robin(void) {
+    printf("🔁 Round-robin keeps workers on their home lane\n");
+    parallel_engine_t engine;
+    parallel_engine_init(&engine, 2, THROUGHPUT_STRATEGY_BALANCED);
+    CHECK(parallel_set_load_balance(&engine, PARALLEL_BALANCE_ROUND_ROBIN) == 0, "strategy can be switched");
+    CHECK(parallel_set_load_balance(&engine, (parallel_balance_t)7) == -1, "unknown strategies are refused");
+    parallel_engine_start(&engine);
+    for (int i = 0; i < 100; i++) {
+        parallel_submit_work(&engine, 0, payload, 64, 0, 0);
+        parallel_submit_work(&engine, 1, payload, 64, 0, 0);
+    }
+    CHECK(wait_processed(&engine, 200), "home lanes are drained");
+
+    performance_profile_t profile;
+    parallel_get_performance(&engine, &profile);
+    CHECK(profile.steals == 0, "nothing is stolen");
+    CHECK(profile.workers[0].messages_processed == 100 && profile.workers[1].messages_processed == 100,
+          "each worker processed its own lane");
+    parallel_engine_destroy(&engine);
+}
+
+static void test_idle_policies(void) {
+    printf("💤 Idle policy follows the throughput strategy\n");
+    parallel_engine_t engine;
+    parallel_engine_init(&engine, 1, THROUGHPUT_STRATEGY_LATENCY_OPTIMIZED);
+    CHECK(engine.idle_policy == PARALLEL_IDLE_SPIN, "latency-optimized workers spin");
+    parallel_set_strategy(&engine, THROUGHPUT_STRATEGY_BALANCED);
+    CHECK(engine.idle_policy == PARALLEL_IDLE_PARK, "balanced workers park");
+    parallel_set_strategy(&engine, THROUGHPUT_STRATEGY_BANDWIDTH_OPTIMIZED);
+    CHECK(engine.idle_policy == PARALLEL_IDLE_SLEEP, "bandwidth-optimized workers batch and sleep");
+    CHECK(parallel_set_idle_policy(&engine, PARALLEL_IDLE_SPIN) == 0 && engine.idle_policy == PARALLEL_IDLE_SPIN,
+          "the policy can be set directly");
+    CHECK(parallel_set_idle_policy(&engine, (parallel_idle_t)9) == -1, "unknown policies are refused");
+    parallel_engine_destroy(&engine);
+
+    parallel_engine_init(&engine, 2, THROUGHPUT_STRATEGY_LATENCY_OPTIMIZED);
+    parallel_engine_start(&engine);
+    for (int i = 0; i < 1000; i++) parallel_submit_work(&engine, 1, payload, 64, 0, 0);
+    CHECK(wait_processed(&engine, 1000), "spinning workers drain their lanes");
+    performance_profile_t profile;
+    parallel_get_performance(&engine, &profile);
+    CHECK(profile.parks == 0 && profile.idle_rounds > 0, "spinning workers never park");
+    parallel_engine_destroy(&engine);
+}
+
+static void test_targeted_wakeup(void) {
+    printf("⏰ Submits wake parked workers\n");
+    parallel_engine_t engine;
+    parallel_engine_init(&engine, 2, THROUGHPUT_STRATEGY_BALANCED);
+    parallel_engine_start(&engine);
+    sleep_ms(10);
+    performance_profile_t profile;
+    parallel_get_performance(&engine, &profile);
+    uint64_t idle = profile.idle_rounds;
+    CHECK(profile.parks > 0, "idle workers park");
+    sleep_ms(10);
+    parallel_get_performance(&engine, &profile);
+    CHECK(profile.idle_rounds - idle < 100, "parked workers stay off the CPU");
+
+    // Each submit lands on parked workers; the park timeout is 2 ms, so a
+    // median well under it means the submit itself woke them
+    uint64_t delays[21];
+    for (int i = 0; i < 21; i++) {
+        sleep_ms(3);
+        uint64_t before = processed(&engine);
+        uint64_t start = umsbb_clock_ns();
+        parallel_submit_work(&engine, (uint32_t)i % 4, payload, 64, 0, 0);
+        while (processed(&engine) == before && umsbb_clock_ns() - start < 100000000ull) sched_yield();
+        delays[i] = umsbb_clock_ns() - start;
+    }
+    for (int i = 1; i < 21; i++) {
+        for (int j = i; j > 0 && delays[j] < delays[j - 1]; j--) {
+            uint64_t t = delays[j]; delays[j] = delays[j - 1]; delays[j - 1] = t;
+        }
+    }
+    printf("  ℹ️  median wake-up %.1f us\n", delays[10] / 1000.0);
+    CHECK(processed(&engine) == 21, "every submit was processed");
+    CHECK(delays[10] < UMSBB_PARK_TIMEOUT_NS / 2, "wake-ups do not wait for the park timeout");
+    parallel_engine_destroy(&engine);
+}
+
+static void test_placement(void) {
+    printf("📌 Workers are pinned and placed by topology\n");
+    parallel_engine_t engine;
+    parallel_engine_init(&engine, 3, THROUGHPUT_STRATEGY_BALANCED);
+    CHECK(parallel_set_cpu_affinity(&engine, 0, CPU_TOPOLOGY_MAX_CPUS + 7) == -1, "an unknown CPU is refused");
+    CHECK(parallel_set_cpu_affinity(&engine, 5, 0) == -1, "an unknown worker is refused");
+    CHECK(parallel_set_cpu_affinity(&engine, 2, 0) == 0, "a worker can be pinned before start");
+    CHECK(parallel_enable_numa_awareness(&engine) == 0 && engine.numa_aware, "NUMA awareness is enabled");
+    parallel_engine_start(&engine);
+
+    performance_profile_t profile;
+    parallel_get_performance(&engine, &profile);
+    bool pinned = true;
+    for (uint32_t i = 0; i < 3; i++) {
+        pinned &= profile.workers[i].pinned;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        pthread_getaffinity_np(*(pthread_t*)engine.workers[i].thread_handle, sizeof(set), &set);
+        pinned &= CPU_COUNT(&set) == 1 && CPU_ISSET(profile.workers[i].cpu_core, &set);
+#endif
+    }
+    CHECK(pinned, "every thread runs on exactly its assigned CPU");
+    CHECK(profile.workers[2].cpu_core == 0, "an explicit pin is kept by auto-placement");
+
+    uint32_t order[CPU_TOPOLOGY_MAX_CPUS];
+    uint32_t cpus = cpu_topology_spread(engine.topology, order, CPU_TOPOLOGY_MAX_CPUS);
+    CHECK(profile.workers[0].cpu_core == order[0] && profile.workers[1].cpu_core == order[1 % cpus],
+          "other workers follow the spread order");
+
+    CHECK(parallel_set_cpu_affinity(&engine, 1, order[0]) == 0 && engine.workers[1].cpu_core == order[0],
+          "a running worker can be re-pinned");
+    for (int i = 0; i < 1000; i++) parallel_submit_work(&engine, 0, payload, 64, 0, 0);
+    CHECK(wait_processed(&engine, 1000), "pinned workers process work");
+    parallel_engine_destroy(&engine);
+}
+
+typedef struct {
+    _Atomic uint32_t calls;
+    _Atomic uint32_t items;
+    _Atomic uint32_t largest;
+    _Atomic uint32_t intact;
+    _Atomic uint32_t borrowed;    // Items whose data is the submitter's own buffer
+    const char* source;           // Buffer of zero-copy submits
+} handler_log_t;
+
+/* Checks each payload starts with its index byte; fails items whose
+ * priority is odd. */
+static void logging_handler(parallel_work_item_t* items, uint32_t count, void* ctx) {
+    handler_log_t* log = (handler_log_t*)ctx;
+    atomic_fetch_add(&log->calls, 1);
+    atomic_fetch_add(&log->items, count);
+    uint32_t largest = atomic_load(&log->largest);
+    while (count > largest && !atomic_compare_exchange_weak(&log->largest, &largest, count)) { }
+    for (uint32_t i = 0; i < count; i++) {
+        const unsigned char* data = (const unsigned char*)items[i].data;
+        if (data[0] == (unsigned char)items[i].priority && atomic_load(&items[i].status) == PARALLEL_STATUS_PROCESSING) {
+            atomic_fetch_add(&log->intact, 1);
+        }
+        if (log->source && items[i].data >= (const void*)log->source &&
+            items[i].data < (const void*)(log->source + 4096)) {
+            atomic_fetch_add(&log->borrowed, 1);
+        }
+        if (items[i].priority % 2) atomic_store(&items[i].status, PARALLEL_STATUS_ERROR);
+    }
+}
+
+static void test_handlers(void) {
+    printf("🧰 Registered handlers run copied payloads in batches\n");
+    parallel_engine_t engine;
+    parallel_engine_init(&engine, 2, THROUGHPUT_STRATEGY_BALANCED);
+    handler_log_t log = { 0 };
+    CHECK(parallel_register_handler(&engine, 4, logging_handler, &log) == -1, "unknown lanes are refused");
+    CHECK(parallel_register_handler(&engine, 1, logging_handler, &log) == 0, "a handler is registered on lane 1");
+
+    // Queue before start so workers find full batches
+    unsigned char buffer[128];
+    for (uint32_t i = 0; i < 1000; i++) {
+        memset(buffer, (unsigned char)(i % 200), sizeof(buffer));
+        parallel_submit_work(&engine, 1, buffer, sizeof(buffer), i % 200, 0);
+    }
+    memset(buffer, 0xEE, sizeof(buffer));    // The engine must not read this any more
+    parallel_engine_start(&engine);
+    CHECK(wait_processed(&engine, 1000), "every item reaches the handler's lane");
+    CHECK(atomic_load(&log.items) == 1000 && atomic_load(&log.intact) == 1000, "payloads are private copies, seen as PROCESSING");
+    CHECK(atomic_load(&log.largest) > 1 && atomic_load(&log.calls) < 1000, "items arrive in batches");
+    CHECK(atomic_load(&engine.total_errors) == 500, "items a handler fails are counted as errors");
+    parallel_engine_destroy(&engine);
+    message_pool_thread_flush();
+}
+
+static void test_zero_copy_batch(void) {
+    printf("📨 Batches are zero-copy and report through their status\n");
+    static char source[4096];
+    static parallel_work_item_t items[64];
+    parallel_engine_t engine;
+    parallel_engine_init(&engine, 2, THROUGHPUT_STRATEGY_BALANCED);
+    handler_log_t log = { 0 };
+    log.source = source;
+    parallel_register_handler(&engine, 2, logging_handler, &log);
+    parallel_engine_start(&engine);
+
+    for (uint32_t i = 0; i < 64; i++) {
+        source[i * 64] = (char)i;
+        memset(&items[i], 0, sizeof(items[i]));
+        items[i].data = source + i * 64;
+        items[i].size = 64;
+        items[i].priority = i;
+    }
+    CHECK(parallel_submit_batch(&engine, 2, items, 64) == 64, "the whole batch is queued");
+    bool settled = false;
+    for (int attempt = 0; attempt < 5000 && !settled; attempt++) {
+        settled = true;
+        for (uint32_t i = 0; i < 64; i++) settled &= atomic_load(&items[i].status) >= PARALLEL_STATUS_COMPLETE;
+        if (!settled) sleep_ms(1);
+    }
+    bool statuses = settled;
+    for (uint32_t i = 0; i < 64; i++) {
+        statuses &= atomic_load(&items[i].status) == (i % 2 ? PARALLEL_STATUS_ERROR : PARALLEL_STATUS_COMPLETE);
+    }
+    CHECK(statuses, "each submitter item ends COMPLETE or ERROR as its handler decided");
+    CHECK(atomic_load(&log.borrowed) == 64, "handlers see the submitter's own buffers");
+    parallel_engine_destroy(&engine);
+
+    // Items still queued when the engine goes away are failed, not lost
+    parallel_engine_init(&engine, 1, THROUGHPUT_STRATEGY_BALANCED);
+    for (uint32_t i = 0; i < 8; i++) atomic_store(&items[i].status, PARALLEL_STATUS_PENDING);
+    parallel_submit_batch(&engine, 0, items, 8);
+    parallel_submit_work(&engine, 0, payload, 64, 0, 0);
+    parallel_engine_destroy(&engine);
+    bool failed = true;
+    for (uint32_t i = 0; i < 8; i++) failed &= atomic_load(&items[i].status) == PARALLEL_STATUS_ERROR;
+    CHECK(failed, "unprocessed batch items are failed on destroy");
+}
+
+static parallel_ring_buffer_t* ring_new(uint32_t capacity) {
+    parallel_ring_buffer_t* ring = calloc(1, sizeof(*ring));
+    ring->capacity = capacity;
+    ring->mask = capacity - 1;
+    ring->items = calloc(capacity, sizeof(parallel_task_t));
+    return ring;
+}
+
+static void ring_free(parallel_ring_buffer_t* ring) {
+    free(ring->items);
+    free(ring);
+}
+
+#define RING_PRODUCERS 3
+#define RING_CONSUMERS 3
+#define RING_PER_PRODUCER 50000
+
+typedef struct {
+    parallel_ring_buffer_t* ring;
+    uint32_t id;
+    _Atomic uint32_t* consumed;
+    _Atomic uint8_t* seen;
+} ring_thread_t;
+
+static void* ring_producer(void* arg) {
+    ring_thread_t* self = arg;
+    parallel_task_t tasks[32];
+    uint32_t rng = 0x9E3779B9u * (self->id + 1);
+    for (uint32_t sent = 0; sent < RING_PER_PRODUCER;) {
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        uint32_t n = 1 + rng % 32;
+        if (n > RING_PER_PRODUCER - sent) n = RING_PER_PRODUCER - sent;
+        for (uint32_t i = 0; i < n; i++) {
+            memset(&tasks[i], 0, sizeof(tasks[i]));
+            tasks[i].size = self->id * RING_PER_PRODUCER + sent + i;
+        }
+        uint32_t pushed = 0;
+        while (pushed < n) {
+            uint32_t moved = parallel_ring_buffer_push_bulk(self->ring, tasks + pushed, n - pushed);
+            if (!moved) sched_yield();
+            pushed += moved;
+        }
+        sent += n;
+    }
+    return NULL;
+}
+
+static void* ring_consumer(void* arg) {
+    ring_thread_t* self = arg;
+    parallel_task_t tasks[32];
+    uint32_t rng = 0x85EBCA6Bu * (self->id + 1);
+    while (atomic_load(self->consumed) < RING_PRODUCERS * RING_PER_PRODUCER) {
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        uint32_t n = parallel_ring_buffer_pop_bulk(self->ring, tasks, 1 + rng % 32);
+        if (!n) { sched_yield(); continue; }
+        for (uint32_t i = 0; i < n; i++) atomic_fetch_add(&self->seen[tasks[i].size], 1);
+        atomic_fetch_add(self->consumed, n);
+    }
+    return NULL;
+}
+
+static void test_ring_bulk(void) {
+    printf("💍 Lane rings move batches with one reservation\n");
+    CHECK(sizeof(parallel_task_t) == 32, "a queued task is half a cache line");
+
+    parallel_ring_buffer_t* ring = ring_new(64);
+    parallel_task_t tasks[100];
+    memset(tasks, 0, sizeof(tasks));
+    for (uint32_t i = 0; i < 100; i++) tasks[i].size = i;
+    CHECK(parallel_ring_buffer_push_bulk(ring, tasks, 40) == 40, "a batch that fits is queued whole");
+    CHECK(parallel_ring_buffer_push_bulk(ring, tasks + 40, 60) == 24, "a batch that does not fit is queued in part");
+    CHECK(!parallel_ring_buffer_push(ring, tasks), "a full ring refuses more");
+    parallel_task_t out[100];
+    uint32_t first = parallel_ring_buffer_pop_bulk(ring, out, 50);
+    uint32_t second = parallel_ring_buffer_pop_bulk(ring, out + 50, 50);
+    bool ordered = first == 50 && second == 14;
+    for (uint32_t i = 0; ordered && i < 64; i++) ordered = out[i].size == i;
+    CHECK(ordered, "pops return what is queued, in order");
+    CHECK(parallel_ring_buffer_pop_bulk(ring, out, 8) == 0, "an empty ring pops nothing");
+    ring_free(ring);
+
+    ring = ring_new(256);
+    static _Atomic uint8_t seen[RING_PRODUCERS * RING_PER_PRODUCER];
+    _Atomic uint32_t consumed = 0;
+    pthread_t threads[RING_PRODUCERS + RING_CONSUMERS];
+    ring_thread_t args[RING_PRODUCERS + RING_CONSUMERS];
+    for (uint32_t i = 0; i < RING_PRODUCERS + RING_CONSUMERS; i++) {
+        bool producer = i < RING_PRODUCERS;
+        args[i] = (ring_thread_t){ ring, producer ? i : i - RING_PRODUCERS, &consumed, seen };
+        pthread_create(&threads[i], NULL, producer ? ring_producer : ring_consumer, &args[i]);
+    }
+    for (uint32_t i = 0; i < RING_PRODUCERS + RING_CONSUMERS; i++) pthread_join(threads[i], NULL);
+    bool once = atomic_load(&consumed) == RING_PRODUCERS * RING_PER_PRODUCER;
+    for (uint32_t i = 0; once && i < RING_PRODUCERS * RING_PER_PRODUCER; i++) once = atomic_load(&seen[i]) == 1;
+    CHECK(once, "concurrent bulk producers and consumers deliver every task exactly once");
+    ring_free(ring);
+}
+
+static void test_autoscale_target(void) {
+    printf("📈 The scaling policy steps within its marks\n");
+    parallel_autoscale_t policy = { 1, 8, 64, 8, 1000000, 100000, 80, 40, 10, 0 };
+    parallel_load_sample_t sample = { 2, 2 * 100, 0, 50 };
+    CHECK(parallel_autoscale_target(&policy, &sample) == 3, "a queue over its mark adds a worker");
+    sample.queue_depth = 2 * 300;
+    CHECK(parallel_autoscale_target(&policy, &sample) == 4, "a queue far over its mark doubles the workers");
+    sample = (parallel_load_sample_t){ 2, 2 * 32, 500000, 60 };
+    CHECK(parallel_autoscale_target(&policy, &sample) == 2, "between the marks nothing changes");
+    sample = (parallel_load_sample_t){ 2, 0, 50000, 90 };
+    CHECK(parallel_autoscale_target(&policy, &sample) == 3, "busy workers add a worker");
+    sample = (parallel_load_sample_t){ 2, 0, 2000000, 10 };
+    CHECK(parallel_autoscale_target(&policy, &sample) == 3, "slow tasks add a worker");
+    sample = (parallel_load_sample_t){ 2, 2 * 8, 100000, 40 };
+    CHECK(parallel_autoscale_target(&policy, &sample) == 1, "an idle engine retires a worker");
+    sample = (parallel_load_sample_t){ 8, 8 * 1000, 0, 100 };
+    CHECK(parallel_autoscale_target(&policy, &sample) == 8, "the maximum holds");
+    policy.min_workers = 2;
+    sample = (parallel_load_sample_t){ 2, 0, 0, 0 };
+    CHECK(parallel_autoscale_target(&policy, &sample) == 2, "the minimum holds");
+    policy.busy_high_percent = 0;
+    sample = (parallel_load_sample_t){ 2, 0, 0, 100 };
+    CHECK(parallel_autoscale_target(&policy, &sample) == 2, "signals without a high mark are ignored");
+}
+
+typedef struct {
+    _Atomic uint32_t handled;
+    uint32_t spin_ns;
+} slow_handler_t;
+
+static void slow_handler(parallel_work_item_t* items, uint32_t count, void* ctx) {
+    (void)items;
+    slow_handler_t* slow = ctx;
+    uint64_t until = umsbb_clock_ns() + (uint64_t)slow->spin_ns * count;
+    while (umsbb_clock_ns() < until) { }
+    atomic_fetch_add(&slow->handled, count);
+}
+
+static uint32_t live_workers(parallel_engine_t* engine) {
+    return atomic_load(&engine->num_workers);
+}
+
+static void test_live_resize(void) {
+    printf("🔧 Workers are added and retired while running\n");
+    parallel_engine_t engine;
+    parallel_engine_init(&engine, 1, THROUGHPUT_STRATEGY_BALANCED);
+    slow_handler_t slow = { 0, 2000 };
+    for (uint32_t lane = 0; lane < 4; lane++) parallel_register_handler(&engine, lane, slow_handler, &slow);
+    parallel_engine_start(&engine);
+
+    CHECK(parallel_adjust_workers(&engine, 4) == 0 && live_workers(&engine) == 4, "a running engine grows");
+    for (uint32_t i = 0; i < 4000; i++) {
+        while (parallel_submit_work(&engine, i % 4, payload, 64, 0, 0) != 0) sched_yield();
+    }
+    performance_profile_t profile;
+    parallel_get_performance(&engine, &profile);
+    bool all_ran = profile.worker_count == 4;
+    CHECK(parallel_adjust_workers(&engine, 1) == 0 && live_workers(&engine) == 1, "it shrinks with work still queued");
+    for (uint32_t i = 1; i < 4; i++) all_ran &= engine.workers[i].thread_handle == NULL;
+    CHECK(all_ran, "retired workers' threads are joined");
+    for (int i = 0; i < 5000 && atomic_load(&slow.handled) < 4000; i++) sleep_ms(1);
+    CHECK(atomic_load(&slow.handled) == 4000 && atomic_load(&engine.total_errors) == 0,
+          "tasks in retired workers' deques still run, once");
+    CHECK(parallel_adjust_workers(&engine, 3) == 0 && live_workers(&engine) == 3, "retired slots can be reused");
+    CHECK(parallel_adjust_workers(&engine, 0) == -1 && parallel_adjust_workers(&engine, UMSBB_MAX_WORKER_THREADS + 1) == -1,
+          "counts outside 1..max are refused");
+    parallel_engine_destroy(&engine);
+    message_pool_thread_flush();
+}
+
+static void test_autoscale(void) {
+    printf("🌊 The controller follows load up and back down\n");
+    parallel_engine_t engine;
+    parallel_engine_init(&engine, 1, THROUGHPUT_STRATEGY_BALANCED);
+    slow_handler_t slow = { 0, 20000 };
+    parallel_register_handler(&engine, 0, slow_handler, &slow);
+    parallel_engine_start(&engine);
+    parallel_autoscale_t policy = { 1, 4, 32, 4, 0, 0, 70, 20, 5, 10 };
+    CHECK(parallel_enable_autoscale(&engine, &policy) == 0, "the controller starts");
+    parallel_autoscale_t bad = policy;
+    bad.min_workers = 5;
+    CHECK(parallel_enable_autoscale(&engine, &bad) != 0 && engine.autoscale.min_workers == 1, "an inverted policy is refused");
+    parallel_enable_autoscale(&engine, &policy);
+
+    uint32_t peak = 1;
+    for (uint32_t i = 0; i < 4000; i++) {
+        while (parallel_submit_work(&engine, 0, payload, 64, 0, 0) != 0) sched_yield();
+        if (live_workers(&engine) > peak) peak = live_workers(&engine);
+    }
+    for (int i = 0; i < 5000 && atomic_load(&slow.handled) < 4000; i++) {
+        if (live_workers(&engine) > peak) peak = live_workers(&engine);
+        sleep_ms(1);
+    }
+    CHECK(peak > 1, "a backlog adds workers");
+    CHECK(atomic_load(&slow.handled) == 4000, "every task ran while scaling");
+    for (int i = 0; i < 3000 && live_workers(&engine) > 1; i++) sleep_ms(1);
+    CHECK(live_workers(&engine) == 1, "an idle engine shrinks back to the minimum");
+    parallel_engine_destroy(&engine);
+    message_pool_thread_flush();
+}
+
+static void test_direct_auto_scaling(void) {
+    printf("🪜 Direct buses scale their consumers from the configuration\n");
+    scaling_config_t config = { 1, 4, 1, 3, 75, 10, false, true };
+    configure_auto_scaling(&config);
+    void* handle = umsbb_create_direct(4096, 2, LANG_C);
+    UniversalMultiSegmentedBiBufferBus* bus = handle;
+    CHECK(bus && bus->parallel_processing_enabled && bus->parallel_engine.autoscale_thread,
+          "the bus runs parallel workers under the controller");
+    CHECK(bus && bus->parallel_engine.autoscale.max_workers == 3, "consumer bounds become the worker bounds");
+    CHECK(get_optimal_consumer_count() == umsbb_get_active_workers(bus), "the consumer count is the live worker count");
+    umsbb_destroy_direct(handle);
+
+    // Freed through the plain API, the bus stops being followed as well
+    bus = umsbb_create_direct(4096, 2, LANG_C);
+    umsbb_free(bus);
+    trigger_scale_evaluation();
+    CHECK(get_optimal_consumer_count() >= config.min_consumers, "a bus freed with umsbb_free is forgotten");
+
+    memset(&config, 0, sizeof(config));
+    configure_auto_scaling(&config);
+    CHECK(get_scaling_config().max_consumers == 0, "the configuration reads back");
+}
+
+static void count_handler(parallel_work_item_t* items, uint32_t count, void* ctx) {
+    (void)items;
+    atomic_fetch_add((_Atomic uint32_t*)ctx, count);
+}
+
+static void test_bus_parallel(void) {
+    printf("🚌 The bus spreads submits over parallel workers\n");
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(4096, 2);
+    _Atomic uint32_t handled = 0;
+    CHECK(!umsbb_register_parallel_handler(bus, 0, count_handler, (void*)&handled), "handlers need parallel processing");
+    CHECK(umsbb_enable_parallel_processing(bus, 2, THROUGHPUT_STRATEGY_BALANCED), "parallel processing starts");
+    CHECK(umsbb_get_active_workers(bus) == 2, "the bus reports its workers");
+    for (uint32_t lane = 0; lane < 4; lane++) umsbb_register_parallel_handler(bus, lane, count_handler, (void*)&handled);
+
+    char message[300];
+    memset(message, 'm', sizeof(message));
+    bool submitted = true;
+    for (int i = 0; i < 500; i++) submitted &= umsbb_submit_parallel(bus, (uint32_t)i % 4, message, sizeof(message), 1, 0);
+    CHECK(submitted, "submits are accepted");
+    for (int i = 0; i < 5000 && atomic_load(&handled) < 500; i++) sleep_ms(1);
+    CHECK(atomic_load(&handled) == 500, "handlers consumed every submit");
+    performance_profile_t profile = umsbb_get_parallel_performance(bus);
+    CHECK(profile.worker_count == 2, "performance is reported through the bus");
+    umsbb_free(bus);
+}
+
+int main(void) {
+    printf("🧪 Parallel Engine Tests\n");
+    memset(payload, 'p', sizeof(payload));
+    test_skewed_lanes();
+    test_unhomed_lane();
+    test_round_robin();
+    test_idle_policies();
+    test_targeted_wakeup();
+    test_placement();
+    test_handlers();
+    test_zero_copy_batch();
+    test_ring_bulk();
+    test_autoscale_target();
+    test_live_resize();
+    test_autoscale();
+    test_bus_parallel();
+    test_direct_auto_scaling();
+    message_pool_thread_flush();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All parallel engine tests passed\n");
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include "../include/segment_ring.h"
+#include <stdio.h>
+#include <pthread.h>
+#include "test_check.h"
+
+static void test_dynamic_lanes(void) {
+    printf("📈 Lanes beyond the old 16-lane limit\n");
+    SegmentRing ring;
+    CHECK(segment_ring_init(&ring, 64, 1024), "ring with 64 lanes initialises");
+    CHECK(ring.activeCount == 64 && ring.laneCount == 64, "all 64 lanes are active");
+
+    int aligned = 1;
+    for (size_t i = 0; i < ring.laneCount; ++i) {
+        if (((size_t)ring.buffers[i] % SOMA_ALIGNMENT) != 0) aligned = 0;
+    }
+    CHECK(aligned, "each lane is a separate cache-aligned allocation");
+    int shared = 1;
+    for (size_t i = 0; i < ring.laneCount; ++i) {
+        if (ring.buffers[i]->mode != BI_BUFFER_MODE_MPSC) shared = 0;
+    }
+    CHECK(shared, "lanes start MPSC, so round-robin producers may share them");
+
+    for (int i = 0; i < 36; ++i) segment_ring_add_lane(&ring);
+    CHECK(ring.activeCount == 100, "lanes are added online");
+    for (int i = 0; i < 50; ++i) segment_ring_remove_lane(&ring);
+    CHECK(ring.activeCount == 50 && ring.laneCount == 100, "retired lanes keep their storage");
+    segment_ring_add_lane(&ring);
+    CHECK(ring.activeCount == 51 && ring.laneCount == 100, "adding revives a retired lane first");
+
+    segment_ring_destroy(&ring);
+    CHECK(segment_ring_init(&ring, SEGMENT_RING_MAX_LANES + 10, 256) &&
+          ring.activeCount == SEGMENT_RING_MAX_LANES, "lane count is clamped to SEGMENT_RING_MAX_LANES");
+    CHECK(!segment_ring_add_lane(&ring), "no lane beyond the limit");
+    segment_ring_destroy(&ring);
+}
+
+static void test_round_robin(void) {
+    printf("🔄 Per-thread round robin\n");
+    SegmentRing ring;
+    segment_ring_init(&ring, 8, 256);
+
+    size_t hits[8] = {0};
+    size_t prev = segment_ring_pick(&ring);
+    int cycles = 1;
+    for (int i = 0; i < 799; ++i) {
+        size_t lane = segment_ring_pick(&ring);
+        hits[lane]++;
+        if (lane != (prev + 1) % 8) cycles = 0;
+        prev = lane;
+    }
+    CHECK(cycles, "a thread visits the lanes in order");
+    int even = 1;
+    for (int i = 0; i < 8; ++i) if (hits[i] < 99 || hits[i] > 100) even = 0;
+    CHECK(even, "traffic is spread evenly");
+
+    segment_ring_remove_lane(&ring);
+    int inRange = 1;
+    for (int i = 0; i < 100; ++i) if (segment_ring_pick(&ring) >= ring.activeCount) inRange = 0;
+    CHECK(inRange, "picks stay within the active lanes after a scale-down");
+    segment_ring_destroy(&ring);
+}
+
+static void commit_to(SegmentRing* ring, size_t lane) {
+    void* slot = bi_buffer_claim(ring->buffers[lane], 8);
+    bi_buffer_commit(ring->buffers[lane], slot, 8);
+    segment_ring_mark_ready(ring, lane);
+}
+
+static void drain_lane(SegmentRing* ring, size_t lane) {
+    size_t size;
+    while (bi_buffer_read(ring->buffers[lane], &size)) bi_buffer_release(ring->buffers[lane]);
+    segment_ring_mark_drained(ring, lane);
+}
+
+static void test_ready_map(void) {
+    printf("🗺️ Ready map across words\n");
+    SegmentRing ring;
+    segment_ring_init(&ring, 200, 1024);
+    CHECK(segment_ring_next_ready(&ring, 0) == SEGMENT_RING_NONE && !segment_ring_has_ready(&ring),
+          "a fresh ring has no ready lanes");
+
+    commit_to(&ring, 3);
+    commit_to(&ring, 70);
+    commit_to(&ring, 199);
+    CHECK(segment_ring_next_ready(&ring, 0) == 3, "lowest ready lane is found");
+    CHECK(segment_ring_next_ready(&ring, 4) == 70, "search skips empty words");
+    CHECK(segment_ring_next_ready(&ring, 71) == 199, "search reaches the last lane");
+    CHECK(segment_ring_next_ready(&ring, 150) == 199 && segment_ring_next_ready(&ring, 200) == 3,
+          "search wraps around to the start");
+
+    drain_lane(&ring, 70);
+    CHECK(segment_ring_next_ready(&ring, 4) == 199, "draining a lane empty clears its bit");
+    commit_to(&ring, 70);
+    commit_to(&ring, 70);
+    size_t size;
+    bi_buffer_read(ring.buffers[70], &size);
+    bi_buffer_release(ring.buffers[70]);
+    CHECK(segment_ring_mark_drained(&ring, 70) && segment_ring_next_ready(&ring, 4) == 70,
+          "a lane with messages left stays ready");
+
+    drain_lane(&ring, 3);
+    drain_lane(&ring, 70);
+    // Consume lane 199 without telling the map: the bit is now stale
+    bi_buffer_read(ring.buffers[199], &size);
+    bi_buffer_release(ring.buffers[199]);
+    CHECK(!segment_ring_has_ready(&ring), "stale bits are verified and dropped");
+    CHECK(segment_ring_next_ready(&ring, 0) == SEGMENT_RING_NONE, "the map is empty again");
+    segment_ring_destroy(&ring);
+}
+
+#define AFFINITY_THREADS 6
+
+static SegmentRing shared;
+static size_t chosen[AFFINITY_THREADS];
+static int sticky[AFFINITY_THREADS];
+
+static void* affinity_main(void* arg) {
+    size_t id = (size_t)arg;
+    chosen[id] = segment_ring_pick(&shared);
+    sticky[id] = 1;
+    for (int i = 0; i < 10000; ++i) {
+        if (segment_ring_pick(&shared) != chosen[id]) sticky[id] = 0;
+    }
+    return NULL;
+}
+
+static void test_affinity(void) {
+    printf("📌 Thread affinity\n");
+    segment_ring_init(&shared, 16, 256);
+    segment_ring_set_routing(&shared, SEGMENT_ROUTING_AFFINITY);
+
+    pthread_t threads[AFFINITY_THREADS];
+    for (size_t i = 0; i < AFFINITY_THREADS; ++i) pthread_create(&threads[i], NULL, affinity_main, (void*)i);
+    for (size_t i = 0; i < AFFINITY_THREADS; ++i) pthread_join(threads[i], NULL);
+
+    int allSticky = 1, distinct = 1;
+    for (size_t i = 0; i < AFFINITY_THREADS; ++i) {
+        if (!sticky[i]) allSticky = 0;
+        for (size_t j = 0; j < i; ++j) if (chosen[i] == chosen[j]) distinct = 0;
+    }
+    CHECK(allSticky, "every thread keeps its lane");
+    CHECK(distinct, "threads get distinct lanes while lanes outnumber them");
+    segment_ring_destroy(&shared);
+}
+
+int main(void) {
+    printf("🧪 Segment Ring Tests\n");
+    printf("=====================\n");
+
+    test_dynamic_lanes();
+    test_round_robin();
+    test_affinity();
+    test_ready_map();
+
+    if (failures) {
+        printf("\n❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✅ All segment ring tests passed!\n");
+    return 0;
+}
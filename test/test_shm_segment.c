@@ -0,0 +1,128 @@
+#include "../include/shm_segment.h"
+#include "../include/twin_lane.h"
+#include "../include/message_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "test_check.h"
+
+static void segment_name(char* out, size_t size, const char* tag) {
+    snprintf(out, size, "umsbb-test-%s-%d", tag, (int)getpid());
+}
+
+static void test_directory(void) {
+    printf("🗂️  Named allocations and offsets\n");
+    char name[SHM_SEGMENT_NAME_MAX];
+    segment_name(name, sizeof(name), "dir");
+    ShmSegment* created = shm_segment_create(name, 64 * 1024);
+    CHECK(created != NULL, "a segment is created");
+    CHECK(shm_segment_create(name, 4096) == NULL, "a taken name is refused");
+
+    char* a = shm_segment_alloc(created, "alpha", 100);
+    char* b = shm_segment_alloc(created, "beta", 1000);
+    CHECK(a && b && ((uintptr_t)a % SHM_SEGMENT_ALIGNMENT) == 0 && b >= a + 100, "allocations are aligned and disjoint");
+    strcpy(a, "hello across processes");
+    CHECK(shm_segment_alloc(created, "huge", 1024 * 1024) == NULL, "an allocation past the end fails");
+
+    ShmSegment* opened = shm_segment_open(name);
+    size_t size = 0;
+    char* seen = shm_segment_find(opened, "alpha", &size);
+    CHECK(opened && seen && size == 100 && strcmp(seen, "hello across processes") == 0, "a second mapping finds the data by name");
+    CHECK(seen != a && shm_segment_offset(opened, seen) == shm_segment_offset(created, a), "mappings differ, offsets agree");
+    CHECK(shm_segment_pointer(opened, shm_segment_offset(created, b)) == shm_segment_find(opened, "beta", NULL),
+          "offsets resolve in the other mapping");
+    CHECK(shm_segment_find(opened, "gamma", NULL) == NULL, "unknown names are not found");
+    shm_segment_close(opened);
+    shm_segment_close(created);
+    CHECK(shm_segment_open(name) == NULL, "the creator removes the name on close");
+}
+
+#define ROUND_TRIPS 20000
+
+/* Echo peer: answers every request on the shared lane with its own bytes. */
+static int echo_main(const char* name) {
+    ShmSegment* segment = shm_segment_open(name);
+    if (!segment) return 2;
+    twin_lane_manager_t manager;
+    twin_lane_init(&manager, 1);
+    uint32_t lane = twin_lane_attach_shared(&manager, segment, "rpc", 7);
+    if (lane == UINT32_MAX) return 3;
+
+    for (int answered = 0; answered < ROUND_TRIPS;) {
+        if (!twin_lane_wait(&manager, lane, TWIN_DIRECTION_RX, 2000000000ull)) return 4;
+        size_t size;
+        uint32_t sequence;
+        void* request;
+        while ((request = twin_lane_receive(&manager, lane, &size, &sequence))) {
+            // A new request acknowledges every earlier response
+            twin_lane_update_flow_control(&manager, lane, sequence - 1);
+            if (!twin_lane_send(&manager, lane, request, size, sequence)) return 5;
+            message_pool_release(request);
+            answered++;
+        }
+    }
+    twin_lane_destroy(&manager);
+    message_pool_thread_flush();
+    shm_segment_close(segment);
+    return 0;
+}
+
+static void test_cross_process(void) {
+    printf("🔀 Request/response between processes over a shared twin lane\n");
+    char name[SHM_SEGMENT_NAME_MAX];
+    segment_name(name, sizeof(name), "rpc");
+    ShmSegment* segment = shm_segment_create(name, 256 * 1024);
+    twin_lane_manager_t manager;
+    twin_lane_init(&manager, 1);
+    uint32_t lane = twin_lane_create_shared(&manager, segment, "rpc", 9, 16384, 16384);
+    CHECK(lane != UINT32_MAX, "a shared lane is created in the segment");
+    CHECK(twin_lane_create_shared(&manager, segment, "rpc", 9, 4096, 4096) == UINT32_MAX, "lane names are unique");
+
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) _exit(echo_main(name));
+
+    unsigned char request[512];
+    bool intact = true;
+    for (uint32_t i = 1; i <= ROUND_TRIPS; ++i) {
+        size_t length = 1 + (i * 61) % sizeof(request);
+        for (size_t j = 0; j < length; ++j) request[j] = (unsigned char)(i + j);
+        while (!twin_lane_send(&manager, lane, request, length, i)) { }
+
+        if (!twin_lane_wait(&manager, lane, TWIN_DIRECTION_RX, 2000000000ull)) { intact = false; break; }
+        size_t size;
+        uint32_t sequence;
+        unsigned char* response = twin_lane_receive(&manager, lane, &size, &sequence);
+        intact &= response && sequence == i && size == length && memcmp(response, request, length) == 0;
+        message_pool_release(response);
+        // The response acknowledges the request
+        twin_lane_update_flow_control(&manager, lane, i);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0, "the peer process attached and answered everything");
+    CHECK(intact, "every response matches its request");
+
+    struct duplex_metrics metrics;
+    twin_lane_get_duplex_metrics(&manager, lane, &metrics);
+    CHECK(metrics.tx_latency.count == ROUND_TRIPS && metrics.rx_latency.count == ROUND_TRIPS,
+          "metrics stay per process");
+    CHECK(!twin_lane_wait(&manager, lane, TWIN_DIRECTION_RX, 1000000ull), "a wait on an idle lane times out");
+    twin_lane_destroy(&manager);
+    shm_segment_close(segment);
+}
+
+int main(void) {
+    printf("🧪 Shared Memory Segment Tests\n");
+    test_directory();
+    test_cross_process();
+    message_pool_thread_flush();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All shared memory segment tests passed\n");
+    return 0;
+}
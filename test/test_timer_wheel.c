@@ -0,0 +1,163 @@
+#include "../include/timer_wheel.h"
+#include "../include/fault_tolerance.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "test_check.h"
+
+typedef struct {
+    timer_wheel_timer_t timer;
+    uint64_t deadline;
+    uint64_t fired_at;
+    uint32_t fired;
+} deadline_t;
+
+typedef struct {
+    uint64_t now;
+    uint64_t tick;
+    uint64_t last_tick;
+    bool ordered;
+} pass_t;
+
+static void on_deadline(timer_wheel_timer_t* timer, void* context) {
+    pass_t* pass = (pass_t*)context;
+    deadline_t* d = TIMER_WHEEL_ENTRY(timer, deadline_t, timer);
+    d->fired++;
+    d->fired_at = pass->now;
+    // Within a tick the order is unspecified
+    uint64_t tick = (d->deadline + pass->tick - 1) / pass->tick;
+    pass->ordered &= tick >= pass->last_tick;
+    pass->last_tick = tick;
+}
+
+#define DEADLINES 5000
+
+static void test_deadlines(void) {
+    printf("⏰ Timers fire once, in order, never early\n");
+    static deadline_t deadlines[DEADLINES];
+    timer_wheel_t wheel;
+    timer_wheel_init(&wheel, 1000, 0);
+    memset(deadlines, 0, sizeof(deadlines));
+    uint64_t x = 88172645463325252ull;
+    for (int i = 0; i < DEADLINES; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        // Spread across the first three levels
+        deadlines[i].deadline = x % (300000ull * 1000);
+        timer_wheel_arm(&wheel, &deadlines[i].timer, deadlines[i].deadline);
+    }
+    CHECK(wheel.armed == DEADLINES, "every timer is armed");
+    for (int i = 0; i < DEADLINES; i += 2) timer_wheel_cancel(&wheel, &deadlines[i].timer);
+    CHECK(wheel.armed == DEADLINES / 2 && !timer_wheel_armed(&deadlines[0].timer), "cancelled timers leave the wheel");
+
+    pass_t pass = { 0, 1000, 0, true };
+    uint32_t fired = 0;
+    // Steps of 333 ticks: a deadline is late by less than one step plus its rounding
+    for (pass.now = 0; pass.now <= 300000ull * 1000 + 333000; pass.now += 333000) {
+        fired += timer_wheel_advance(&wheel, pass.now, on_deadline, &pass);
+    }
+    bool once = true, on_time = true;
+    for (int i = 0; i < DEADLINES; i++) {
+        if (i % 2 == 0) {
+            once &= deadlines[i].fired == 0;
+            continue;
+        }
+        once &= deadlines[i].fired == 1;
+        on_time &= deadlines[i].fired_at >= deadlines[i].deadline &&
+                   deadlines[i].fired_at - deadlines[i].deadline < 333000 + 1000;
+    }
+    CHECK(fired == DEADLINES / 2 && once, "each armed timer fires exactly once; cancelled ones never");
+    CHECK(on_time, "no timer fires before its deadline or a step after it");
+    CHECK(pass.ordered, "timers fire in deadline order across cascades");
+    CHECK(wheel.armed == 0, "the wheel is empty afterwards");
+}
+
+static void test_levels(void) {
+    printf("🪜 Far deadlines cascade down and past the top level\n");
+    timer_wheel_t wheel;
+    timer_wheel_init(&wheel, 1, 0);
+    uint64_t targets[] = { 1, 63, 64, 4095, 4096, 262143, 262144, 16777215, 16777216, 20000000 };
+    enum { COUNT = sizeof(targets) / sizeof(targets[0]) };
+    deadline_t deadlines[COUNT];
+    memset(deadlines, 0, sizeof(deadlines));
+    for (int i = 0; i < COUNT; i++) {
+        deadlines[i].deadline = targets[i];
+        timer_wheel_arm(&wheel, &deadlines[i].timer, targets[i]);
+    }
+    pass_t pass = { 0, 1, 0, true };
+    bool exact = true;
+    for (int i = 0; i < COUNT; i++) {
+        pass.now = targets[i] - 1;
+        exact &= timer_wheel_advance(&wheel, pass.now, on_deadline, &pass) == 0;
+        pass.now = targets[i];
+        exact &= timer_wheel_advance(&wheel, pass.now, on_deadline, &pass) == 1 && deadlines[i].fired == 1;
+    }
+    CHECK(exact, "each deadline fires on its own tick, at every level boundary");
+
+    deadline_t past = { 0 };
+    timer_wheel_arm(&wheel, &past.timer, 5);
+    CHECK(timer_wheel_advance(&wheel, pass.now, on_deadline, &pass) == 0, "a past deadline does not fire within the tick");
+    pass.now++;
+    CHECK(timer_wheel_advance(&wheel, pass.now, on_deadline, &pass) == 1 && past.fired == 1, "it fires on the next one");
+}
+
+typedef struct {
+    timer_wheel_t* wheel;
+    uint64_t now;
+    uint32_t fired;
+} periodic_t;
+
+static void on_period(timer_wheel_timer_t* timer, void* context) {
+    periodic_t* periodic = (periodic_t*)context;
+    periodic->fired++;
+    timer_wheel_arm(periodic->wheel, timer, periodic->now + 10);
+}
+
+static void test_rearm(void) {
+    printf("🔁 A callback can re-arm its own timer\n");
+    timer_wheel_t wheel;
+    timer_wheel_init(&wheel, 1, 0);
+    timer_wheel_timer_t timer = { 0 };
+    periodic_t periodic = { &wheel, 0, 0 };
+    timer_wheel_arm(&wheel, &timer, 10);
+    for (periodic.now = 1; periodic.now <= 100; periodic.now++) timer_wheel_advance(&wheel, periodic.now, on_period, &periodic);
+    CHECK(periodic.fired == 10 && timer_wheel_armed(&timer), "a 10-tick period fires 10 times in 100 ticks");
+    timer_wheel_arm(&wheel, &timer, 1000);
+    CHECK(wheel.armed == 1, "re-arming an armed timer moves it");
+    timer_wheel_cancel(&wheel, &timer);
+    timer_wheel_cancel(&wheel, &timer);
+    CHECK(wheel.armed == 0 && timer_wheel_advance(&wheel, 2000, on_period, &periodic) == 0, "cancelling twice is harmless");
+}
+
+static void test_heartbeats(void) {
+    printf("💓 Fault tolerance puts heartbeat deadlines on a wheel\n");
+    fault_tolerance_manager_t manager;
+    fault_tolerance_init(&manager, 16);
+    manager.heartbeat_timeout_us = 50000;
+    fault_tolerance_update_component_health(&manager, 3, true, 10);
+    fault_tolerance_update_component_health(&manager, 4, true, 10);
+    CHECK(fault_tolerance_check_heartbeats(&manager) == 0, "fresh heartbeats are not overdue");
+    usleep(30000);
+    fault_tolerance_update_component_health(&manager, 4, true, 10);
+    usleep(40000);
+    CHECK(fault_tolerance_check_heartbeats(&manager) == 1 && manager.heartbeat_misses == 1, "only the stale deadline passes");
+    CHECK(!fault_tolerance_is_component_healthy(&manager, 3) && fault_tolerance_is_component_healthy(&manager, 4),
+          "the silent component is unhealthy, the live one is not");
+    fault_tolerance_destroy(&manager);
+}
+
+int main(void) {
+    printf("🧪 Timer Wheel Tests\n");
+    test_deadlines();
+    test_levels();
+    test_rearm();
+    test_heartbeats();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All timer wheel tests passed\n");
+    return 0;
+}
@@ -0,0 +1,263 @@
+#include "../include/topic_ring.h"
+#include "../include/universal_multi_segmented_bi_buffer_bus.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "test_check.h"
+
+static bool publish_u32(TopicRing* topic, uint32_t value) {
+    return topic_ring_publish(topic, &value, sizeof(value), CHECKSUM_POLICY_FAST);
+}
+
+/* Reads and releases everything pending; counts messages that break order. */
+static size_t drain_all(TopicRing* topic, uint32_t sub, uint32_t* next, size_t* disorder) {
+    TopicMessage batch[16];
+    size_t total = 0, n;
+    while ((n = topic_ring_read(topic, sub, batch, 16)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            uint32_t value;
+            memcpy(&value, batch[i].data, sizeof(value));
+            if (value != *next) (*disorder)++;
+            *next = value + 1;
+        }
+        topic_ring_release(topic, sub);
+        total += n;
+    }
+    return total;
+}
+
+static void test_fan_out(void) {
+    printf("📡 Every subscriber reads the same frames\n");
+    TopicRing* topic = topic_ring_create(4096);
+    CHECK(topic != NULL, "topic created");
+    CHECK(publish_u32(topic, 7), "publishing without subscribers succeeds");
+
+    uint32_t a = topic_ring_subscribe(topic, TOPIC_SLOW_BLOCK);
+    uint32_t b = topic_ring_subscribe(topic, TOPIC_SLOW_BLOCK);
+    CHECK(a != TOPIC_RING_NO_SUBSCRIBER && b != TOPIC_RING_NO_SUBSCRIBER && a != b, "two subscribers join");
+
+    TopicMessage none;
+    CHECK(topic_ring_read(topic, a, &none, 1) == 0, "a subscriber does not see messages from before it joined");
+
+    for (uint32_t i = 0; i < 10; i++) publish_u32(topic, i);
+    TopicMessage ma[16], mb[16];
+    size_t na = topic_ring_read(topic, a, ma, 16);
+    size_t nb = topic_ring_read(topic, b, mb, 16);
+    CHECK(na == 10 && nb == 10, "both subscribers see all ten messages");
+    int shared = 1;
+    for (size_t i = 0; i < na && i < nb; i++) {
+        if (ma[i].data != mb[i].data) shared = 0;
+    }
+    CHECK(shared, "they read the same bytes in place");
+    CHECK(topic_ring_read(topic, a, ma, 16) == 10, "reading again before release returns the same batch");
+    CHECK(topic_ring_release(topic, a) && topic_ring_release(topic, b), "both batches release");
+    CHECK(!topic_ring_release(topic, a), "a second release has nothing to release");
+    CHECK(topic_ring_read(topic, a, ma, 16) == 0, "nothing is left after release");
+
+    TopicSubscriberStats stats;
+    CHECK(topic_ring_subscriber_stats(topic, b, &stats) && stats.delivered == 10 && stats.lag == 0,
+          "stats count the delivered messages");
+
+    topic_ring_unsubscribe(topic, a);
+    CHECK(topic_ring_read(topic, a, ma, 16) == 0, "an unsubscribed id reads nothing");
+    topic_ring_destroy(topic);
+}
+
+static void test_slowest_gates(void) {
+    printf("🐢 The slowest BLOCK subscriber gates reclamation\n");
+    TopicRing* topic = topic_ring_create(1024);
+    uint32_t fast = topic_ring_subscribe(topic, TOPIC_SLOW_BLOCK);
+    uint32_t slow = topic_ring_subscribe(topic, TOPIC_SLOW_BLOCK);
+
+    uint32_t fastNext = 0, slowNext = 0;
+    size_t disorder = 0, sent = 0, fastGot = 0;
+    while (publish_u32(topic, (uint32_t)sent)) {
+        sent++;
+        fastGot += drain_all(topic, fast, &fastNext, &disorder);
+    }
+    CHECK(sent > 0 && sent < 1024 / 32 + 1, "publishing stops once the slow subscriber's backlog fills the ring");
+    CHECK(fastGot == sent, "the fast subscriber kept up");
+
+    size_t slowGot = drain_all(topic, slow, &slowNext, &disorder);
+    CHECK(slowGot == sent && disorder == 0, "the slow subscriber still gets every message in order");
+    CHECK(publish_u32(topic, (uint32_t)sent), "space comes back once it catches up");
+    topic_ring_destroy(topic);
+}
+
+static void test_drop_overrun(void) {
+    printf("⏩ DROP subscribers are skipped ahead\n");
+    TopicRing* topic = topic_ring_create(1024);
+    uint32_t live = topic_ring_subscribe(topic, TOPIC_SLOW_BLOCK);
+    uint32_t lossy = topic_ring_subscribe(topic, TOPIC_SLOW_DROP);
+
+    uint32_t liveNext = 0;
+    size_t disorder = 0;
+    int refused = 0;
+    for (uint32_t i = 0; i < 200; i++) {
+        if (!publish_u32(topic, i)) refused++;
+        drain_all(topic, live, &liveNext, &disorder);
+    }
+    CHECK(refused == 0, "an idle DROP subscriber never stalls publishers");
+    CHECK(liveNext == 200 && disorder == 0, "the BLOCK subscriber loses nothing");
+
+    TopicSubscriberStats stats;
+    topic_ring_subscriber_stats(topic, lossy, &stats);
+    CHECK(stats.overruns > 0 && stats.dropped > 0, "the overruns and skipped messages are counted");
+
+    TopicMessage batch[64];
+    size_t n = topic_ring_read(topic, lossy, batch, 64);
+    uint32_t last = 0;
+    if (n) memcpy(&last, batch[n - 1].data, sizeof(last));
+    CHECK(n > 0 && last == 199 && stats.dropped + n == 200, "it resumes at recent messages and accounts for all");
+
+    // A held batch is pinned: publishes are refused rather than tearing it
+    topic_ring_unsubscribe(topic, live);
+    uint32_t i = 0;
+    while (i < 200 && publish_u32(topic, 1000 + i)) i++;
+    memcpy(&last, batch[n - 1].data, sizeof(last));
+    CHECK(i < 200 && last == 199, "a held batch is not overwritten");
+    CHECK(topic_ring_release(topic, lossy) && publish_u32(topic, 2000), "releasing it lets publishers in");
+    topic_ring_destroy(topic);
+}
+
+static void test_corrupt_frames(void) {
+    printf("🧬 Corrupt frames are skipped per subscriber\n");
+    TopicRing* topic = topic_ring_create(1024);
+    uint32_t first = topic_ring_subscribe(topic, TOPIC_SLOW_BLOCK);
+    uint32_t second = topic_ring_subscribe(topic, TOPIC_SLOW_BLOCK);
+    publish_u32(topic, 1);
+    publish_u32(topic, 2);
+    publish_u32(topic, 3);
+
+    TopicMessage batch[4];
+    CHECK(topic_ring_read(topic, first, batch, 4) == 3, "the first subscriber reads all three intact");
+    // Flip a byte of the middle message behind the checksum's back
+    ((uint8_t*)batch[1].data)[0] ^= 0xFF;
+    topic_ring_release(topic, first);
+
+    size_t n = topic_ring_read(topic, second, batch, 4);
+    uint32_t a = 0, b = 0;
+    if (n == 2) {
+        memcpy(&a, batch[0].data, sizeof(a));
+        memcpy(&b, batch[1].data, sizeof(b));
+    }
+    topic_ring_release(topic, second);
+    TopicSubscriberStats stats;
+    topic_ring_subscriber_stats(topic, second, &stats);
+    CHECK(n == 2 && a == 1 && b == 3, "the second subscriber skips the damaged frame");
+    CHECK(stats.corrupted == 1 && stats.delivered == 2, "the skipped frame is counted");
+    topic_ring_destroy(topic);
+}
+
+#define MT_PUBLISHERS 3
+#define MT_MESSAGES 20000
+
+typedef struct {
+    TopicRing* topic;
+    uint32_t id;
+} publisher_arg;
+
+static void* publisher_thread(void* p) {
+    publisher_arg* arg = p;
+    for (uint32_t i = 0; i < MT_MESSAGES; i++) {
+        uint32_t value = (arg->id << 24) | i;
+        while (!topic_ring_publish(arg->topic, &value, sizeof(value), CHECKSUM_POLICY_FAST)) sched_yield();
+    }
+    return NULL;
+}
+
+typedef struct {
+    TopicRing* topic;
+    uint32_t sub;
+    size_t received;
+    size_t disorder;
+} subscriber_arg;
+
+static void* subscriber_thread(void* p) {
+    subscriber_arg* arg = p;
+    uint32_t next[MT_PUBLISHERS] = {0};
+    TopicMessage batch[32];
+    while (arg->received < (size_t)MT_PUBLISHERS * MT_MESSAGES) {
+        size_t n = topic_ring_read(arg->topic, arg->sub, batch, 32);
+        for (size_t i = 0; i < n; i++) {
+            uint32_t value;
+            memcpy(&value, batch[i].data, sizeof(value));
+            uint32_t who = value >> 24;
+            if (who >= MT_PUBLISHERS || (value & 0xFFFFFF) != next[who]) arg->disorder++;
+            else next[who]++;
+        }
+        if (n) topic_ring_release(arg->topic, arg->sub);
+        else sched_yield();
+        arg->received += n;
+    }
+    return NULL;
+}
+
+static void test_concurrent(void) {
+    printf("🧵 Concurrent publishers and subscribers\n");
+    TopicRing* topic = topic_ring_create(16384);
+    subscriber_arg subs[2];
+    pthread_t st[2], pt[MT_PUBLISHERS];
+    publisher_arg pubs[MT_PUBLISHERS];
+    for (int i = 0; i < 2; i++) {
+        subs[i] = (subscriber_arg){ topic, topic_ring_subscribe(topic, TOPIC_SLOW_BLOCK), 0, 0 };
+        pthread_create(&st[i], NULL, subscriber_thread, &subs[i]);
+    }
+    for (uint32_t i = 0; i < MT_PUBLISHERS; i++) {
+        pubs[i] = (publisher_arg){ topic, i };
+        pthread_create(&pt[i], NULL, publisher_thread, &pubs[i]);
+    }
+    for (int i = 0; i < MT_PUBLISHERS; i++) pthread_join(pt[i], NULL);
+    for (int i = 0; i < 2; i++) pthread_join(st[i], NULL);
+
+    CHECK(subs[0].received == (size_t)MT_PUBLISHERS * MT_MESSAGES &&
+          subs[1].received == (size_t)MT_PUBLISHERS * MT_MESSAGES, "each subscriber got every message");
+    CHECK(subs[0].disorder == 0 && subs[1].disorder == 0, "per-publisher order is kept for every subscriber");
+    topic_ring_destroy(topic);
+}
+
+static void test_bus_topics(void) {
+    printf("🚌 Bus topic API\n");
+    UniversalMultiSegmentedBiBufferBus* bus = umsbb_init(4096, 2);
+    CHECK(umsbb_publish(bus, 3, "x", 1), "publishing to an unused topic is a no-op");
+    CHECK(!umsbb_publish(bus, UMSBB_MAX_TOPICS, "x", 1), "topic ids are bounded");
+    CHECK(umsbb_topic_create(bus, 5, 2048) && !umsbb_topic_create(bus, 5, 2048), "a topic is created once");
+
+    uint32_t a = umsbb_subscribe(bus, 3, TOPIC_SLOW_BLOCK);
+    uint32_t b = umsbb_subscribe(bus, 3, TOPIC_SLOW_DROP);
+    CHECK(a != TOPIC_RING_NO_SUBSCRIBER && b != TOPIC_RING_NO_SUBSCRIBER, "subscribing creates the topic");
+    CHECK(umsbb_publish(bus, 3, "event", 5), "publish to two subscribers");
+
+    TopicMessage ma, mb;
+    CHECK(umsbb_topic_read(bus, 3, a, &ma, 1) == 1 && umsbb_topic_read(bus, 3, b, &mb, 1) == 1 &&
+          ma.data == mb.data && ma.size == 5 && memcmp(ma.data, "event", 5) == 0,
+          "both read one copy of the message");
+    umsbb_topic_release(bus, 3, a);
+    umsbb_topic_release(bus, 3, b);
+    TopicSubscriberStats stats;
+    CHECK(umsbb_topic_stats(bus, 3, a, &stats) && stats.delivered == 1, "stats through the bus");
+    umsbb_unsubscribe(bus, 3, a);
+    umsbb_unsubscribe(bus, 3, b);
+    CHECK(umsbb_feature_mask() & UMSBB_FEATURE_TOPICS, "topics are part of the feature mask");
+    umsbb_free(bus);
+}
+
+int main(void) {
+    printf("🧪 Topic Ring Tests\n");
+    printf("===================\n");
+
+    test_fan_out();
+    test_slowest_gates();
+    test_drop_overrun();
+    test_corrupt_frames();
+    test_concurrent();
+    test_bus_topics();
+
+    if (failures) {
+        printf("\n❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✅ All topic ring tests passed!\n");
+    return 0;
+}
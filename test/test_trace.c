@@ -0,0 +1,298 @@
+#include "../include/umsbb_trace.h"
+#include "../include/bi_buffer.h"
+#include "../include/fast_lane.h"
+#include "../include/twin_lane.h"
+#include "../include/feedback_handshake.h"
+#include "../include/message_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "test_check.h"
+
+#define MAX_SEEN 4096
+
+typedef struct {
+    size_t count;
+    umsbb_trace_record_t records[MAX_SEEN];
+    uint32_t threads[MAX_SEEN];
+} seen_t;
+
+static seen_t seen;
+
+static void keep(uint32_t thread, const umsbb_trace_record_t* record, void* context) {
+    seen_t* s = (seen_t*)context;
+    if (s->count < MAX_SEEN) {
+        s->threads[s->count] = thread;
+        s->records[s->count] = *record;
+    }
+    s->count++;
+}
+
+static size_t gather(void) {
+    seen.count = 0;
+    return umsbb_trace_collect(keep, &seen);
+}
+
+/* Events and keys of `module`, in the order recorded. */
+#ifdef UMSBB_ENABLE_TRACING
+static int events_of(umsbb_trace_module_t module, umsbb_trace_event_t* out, uint64_t* seqs, int max) {
+    int n = 0;
+    for (size_t i = 0; i < seen.count && i < MAX_SEEN && n < max; ++i) {
+        if (seen.records[i].module != module) continue;
+        out[n] = (umsbb_trace_event_t)seen.records[i].event;
+        seqs[n++] = seen.records[i].seq;
+    }
+    return n;
+}
+#endif
+
+static void test_record_and_collect(void) {
+    printf("🧵 Records, rings and reset\n");
+    umsbb_trace_reset();
+    CHECK(gather() == 0, "nothing recorded yet");
+
+    umsbb_trace_record(UMSBB_TRACE_BI_BUFFER, UMSBB_TRACE_CLAIM, 7, 100);
+    umsbb_trace_record(UMSBB_TRACE_BI_BUFFER, UMSBB_TRACE_COMMIT, 7, 100);
+    CHECK(gather() == 2, "two records collected");
+    CHECK(seen.records[0].event == UMSBB_TRACE_CLAIM && seen.records[1].event == UMSBB_TRACE_COMMIT,
+          "oldest first within a ring");
+    CHECK(seen.records[0].lane == 7 && seen.records[0].seq == 100 && seen.records[0].module == UMSBB_TRACE_BI_BUFFER,
+          "lane, key and module kept");
+    CHECK(seen.records[1].ns >= seen.records[0].ns && seen.records[0].ns > 0, "stamped in order");
+
+    // Wrap the ring: only the newest UMSBB_TRACE_RING_RECORDS survive
+    umsbb_trace_reset();
+    for (uint64_t i = 0; i < UMSBB_TRACE_RING_RECORDS + 10; ++i) {
+        umsbb_trace_record(UMSBB_TRACE_FAST_LANE, UMSBB_TRACE_DRAIN, 0, i);
+    }
+    size_t kept = gather();
+    CHECK(kept == UMSBB_TRACE_RING_RECORDS && seen.records[0].seq == 10, "a full ring overwrites its oldest records");
+
+    umsbb_trace_reset();
+    CHECK(gather() == 0, "reset drops what was recorded");
+}
+
+static void* record_many(void* arg) {
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    for (uint64_t i = 0; i < 100; ++i) {
+        umsbb_trace_record(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_SUBMIT, id, i);
+    }
+    return NULL;
+}
+
+static void test_threads(void) {
+    printf("🧵 One ring per thread\n");
+    umsbb_trace_reset();
+    pthread_t threads[4];
+    for (uintptr_t i = 0; i < 4; ++i) pthread_create(&threads[i], NULL, record_many, (void*)i);
+    for (int i = 0; i < 4; ++i) pthread_join(threads[i], NULL);
+
+    CHECK(gather() == 400, "every thread's records collected");
+    // Rings of exited threads may be continued by later ones, but a ring
+    // only ever has one writer: each run of 100 comes from a single thread
+    bool ordered = true;
+    for (size_t i = 0; i < seen.count; ++i) {
+        uint64_t expected = i % 100;
+        if (seen.records[i].seq != expected) ordered = false;
+        if (expected && (seen.records[i].lane != seen.records[i - 1].lane || seen.threads[i] != seen.threads[i - 1])) {
+            ordered = false;
+        }
+    }
+    CHECK(ordered, "each thread's records arrive whole and in order");
+}
+
+static void test_sampling_api(void) {
+    printf("🎲 Sampling setting\n");
+    CHECK(umsbb_trace_get_sampling() == 0, "tracing starts off");
+    umsbb_trace_set_sampling(64);
+    CHECK(umsbb_trace_get_sampling() == 64, "one in 64");
+    umsbb_trace_set_sampling(0);
+    CHECK(umsbb_trace_get_sampling() == 0, "and off again");
+    CHECK(strcmp(umsbb_trace_module_name(UMSBB_TRACE_TWIN_RX), "twin_rx") == 0 &&
+          strcmp(umsbb_trace_event_name(UMSBB_TRACE_RELEASE), "release") == 0, "module and event names");
+}
+
+#ifdef UMSBB_ENABLE_TRACING
+
+static void test_bi_buffer_points(void) {
+    printf("🔁 Bi-buffer claim → commit → drain → release\n");
+    BiBuffer* buf = bi_buffer_create(65536, BI_BUFFER_MODE_SPSC);
+    char msg[40] = "traced";
+
+    umsbb_trace_reset();
+    void* slot = bi_buffer_claim(buf, sizeof(msg));
+    bi_buffer_commit(buf, slot, sizeof(msg));
+    size_t size;
+    bi_buffer_read(buf, &size);
+    bi_buffer_release(buf);
+    CHECK(gather() == 0, "nothing is recorded while tracing is off");
+
+    umsbb_trace_set_sampling(1);
+    slot = bi_buffer_claim(buf, sizeof(msg));
+    memcpy(slot, msg, sizeof(msg));
+    bi_buffer_commit(buf, slot, sizeof(msg));
+    bi_buffer_read(buf, &size);
+    bi_buffer_release(buf);
+
+    gather();
+    umsbb_trace_event_t events[8];
+    uint64_t seqs[8];
+    int n = events_of(UMSBB_TRACE_BI_BUFFER, events, seqs, 8);
+    CHECK(n == 4 && events[0] == UMSBB_TRACE_CLAIM && events[1] == UMSBB_TRACE_COMMIT &&
+          events[2] == UMSBB_TRACE_DRAIN && events[3] == UMSBB_TRACE_RELEASE, "four stages in order");
+    CHECK(n == 4 && seqs[0] == seqs[1] && seqs[1] == seqs[2] && seqs[2] == seqs[3], "all keyed by the frame");
+    CHECK(n == 4 && seen.records[0].lane == seen.records[3].lane, "and by the ring");
+
+    // Batched consumers: peek per frame, one release for the batch
+    umsbb_trace_reset();
+    for (int i = 0; i < 3; ++i) {
+        slot = bi_buffer_claim(buf, sizeof(msg));
+        bi_buffer_commit(buf, slot, sizeof(msg));
+    }
+    size_t cursor = bi_buffer_read_cursor(buf);
+    while (bi_buffer_peek(buf, &cursor, &size)) {}
+    bi_buffer_release_to(buf, cursor);
+    gather();
+    umsbb_trace_event_t batch[16];
+    uint64_t batch_seqs[16];
+    n = events_of(UMSBB_TRACE_BI_BUFFER, batch, batch_seqs, 16);
+    CHECK(n == 10 && batch[6] == UMSBB_TRACE_DRAIN && batch[8] == UMSBB_TRACE_DRAIN, "a drain per peeked frame");
+    CHECK(n == 10 && batch[9] == UMSBB_TRACE_RELEASE && batch_seqs[9] == batch_seqs[0],
+          "one release for the batch, keyed by its first frame");
+
+    // Every stage of a message is kept or dropped together
+    umsbb_trace_set_sampling(8);
+    umsbb_trace_reset();
+    const int messages = 2000;
+    for (int i = 0; i < messages; ++i) {
+        slot = bi_buffer_claim(buf, 1 + (i * 37) % 200);
+        bi_buffer_commit(buf, slot, 1 + (i * 37) % 200);
+        bi_buffer_read(buf, &size);
+        bi_buffer_release(buf);
+    }
+    size_t total = gather();
+    size_t claims = 0, releases = 0;
+    for (size_t i = 0; i < seen.count && i < MAX_SEEN; ++i) {
+        if (seen.records[i].event == UMSBB_TRACE_CLAIM) claims++;
+        if (seen.records[i].event == UMSBB_TRACE_RELEASE) releases++;
+    }
+    CHECK(total <= MAX_SEEN && total == claims * 4 && claims == releases, "sampled messages keep all four stages");
+    CHECK(claims > messages / 32 && claims < messages / 3, "roughly one message in eight");
+
+    umsbb_trace_set_sampling(0);
+    bi_buffer_free(buf);
+}
+
+static void test_lane_points(void) {
+    printf("🛣️  Fast lane, twin lane and handshake points\n");
+    umsbb_trace_set_sampling(1);
+    umsbb_trace_reset();
+
+    fast_lane_manager_t manager;
+    fast_lane_init(&manager);
+    uint64_t value = 42;
+    size_t size;
+    fast_lane_try_submit(&manager, LANE_EXPRESS, &value, sizeof(value), 0);
+    message_pool_release(fast_lane_try_drain(&manager, LANE_EXPRESS, &size, NULL));
+    fast_lane_destroy(&manager);
+
+    gather();
+    umsbb_trace_event_t events[16];
+    uint64_t seqs[16];
+    int n = events_of(UMSBB_TRACE_FAST_LANE, events, seqs, 16);
+    CHECK(n == 4 && events[0] == UMSBB_TRACE_CLAIM && events[1] == UMSBB_TRACE_COMMIT &&
+          events[2] == UMSBB_TRACE_DRAIN && events[3] == UMSBB_TRACE_RELEASE, "fast lane stages in order");
+
+    umsbb_trace_reset();
+    twin_lane_manager_t twins;
+    twin_lane_init(&twins, 2);
+    uint32_t lane = twin_lane_create(&twins, 1, 4096, 4096);
+    twin_lane_send(&twins, lane, &value, sizeof(value), 9);
+    uint64_t cursor = twin_lane_tx_cursor(&twins, lane);
+    uint32_t sequence;
+    twin_lane_peek_tx(&twins, lane, &cursor, &size, &sequence);
+    twin_lane_release_tx(&twins, lane, cursor);
+    twin_lane_update_flow_control(&twins, lane, 9);
+    twin_lane_deliver(&twins, lane, &value, sizeof(value), 10);
+    message_pool_release(twin_lane_receive(&twins, lane, &size, &sequence));
+    twin_lane_destroy(&twins);
+
+    gather();
+    n = events_of(UMSBB_TRACE_TWIN_TX, events, seqs, 16);
+    CHECK(n == 4 && events[0] == UMSBB_TRACE_CLAIM && events[1] == UMSBB_TRACE_COMMIT &&
+          events[2] == UMSBB_TRACE_DRAIN && events[3] == UMSBB_TRACE_ACK && seqs[3] == 9, "twin TX send, drain and ACK");
+    n = events_of(UMSBB_TRACE_TWIN_RX, events, seqs, 16);
+    CHECK(n == 3 && events[1] == UMSBB_TRACE_COMMIT && events[2] == UMSBB_TRACE_DRAIN && seqs[2] == 10,
+          "twin RX deliver and receive");
+
+    umsbb_trace_reset();
+    handshake_manager_t handshake;
+    handshake_init(&handshake, 16);
+    uint64_t seq = handshake_send_message(&handshake, 1, 2, &value, sizeof(value));
+    feedback_message_t ack = handshake_create_ack(seq, 1, 2);
+    handshake_process_feedback(&handshake, &ack);
+    handshake_destroy(&handshake);
+
+    gather();
+    n = events_of(UMSBB_TRACE_HANDSHAKE, events, seqs, 16);
+    CHECK(n == 2 && events[0] == UMSBB_TRACE_SUBMIT && events[1] == UMSBB_TRACE_ACK && seqs[1] == seq &&
+          seen.records[0].lane == 2, "handshake submit and ACK, by consumer");
+
+    umsbb_trace_set_sampling(0);
+}
+
+#endif
+
+static size_t count_of(const char* text, const char* needle) {
+    size_t n = 0;
+    for (const char* p = strstr(text, needle); p; p = strstr(p + 1, needle)) n++;
+    return n;
+}
+
+static void test_chrome_dump(void) {
+    printf("📄 Chrome trace export\n");
+    umsbb_trace_reset();
+    umsbb_trace_record(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_BATCH_BEGIN, 0, 5);
+    umsbb_trace_record(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_RELEASE, 3, 77);
+    umsbb_trace_record(UMSBB_TRACE_PARALLEL, UMSBB_TRACE_BATCH_END, 0, 5);
+
+    const char* path = "test_trace_dump.json";
+    CHECK(umsbb_trace_dump_chrome(path), "dump written");
+    FILE* f = fopen(path, "r");
+    char text[65536] = {0};
+    size_t len = f ? fread(text, 1, sizeof(text) - 1, f) : 0;
+    if (f) fclose(f);
+    remove(path);
+
+    CHECK(len > 0 && strncmp(text, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 39) == 0, "trace event JSON object");
+    CHECK(count_of(text, "\"ph\":\"B\"") == 1 && count_of(text, "\"ph\":\"E\"") == 1, "batches become duration events");
+    CHECK(strstr(text, "\"name\":\"release\",\"cat\":\"parallel\",\"ph\":\"i\",\"s\":\"t\"") != NULL &&
+          strstr(text, "\"args\":{\"lane\":3,\"seq\":77}") != NULL, "instants carry lane and key");
+    CHECK(strstr(text, "\"ts\":0.000") != NULL, "timestamps start at the earliest record");
+    CHECK(count_of(text, "\"thread_name\"") >= 1 && len > 4 && strcmp(text + len - 4, "\n]}\n") == 0,
+          "thread names and a closed array");
+    CHECK(!umsbb_trace_dump_chrome("/nonexistent-dir/trace.json"), "unwritable path reported");
+}
+
+int main(void) {
+    printf("🧪 Trace Tests\n");
+    test_sampling_api();
+    test_record_and_collect();
+    test_threads();
+#ifdef UMSBB_ENABLE_TRACING
+    test_bi_buffer_points();
+    test_lane_points();
+#else
+    printf("ℹ️  Built without UMSBB_ENABLE_TRACING: hot-path points skipped\n");
+#endif
+    test_chrome_dump();
+    message_pool_thread_flush();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All trace tests passed\n");
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include "../include/twin_lane.h"
+#include "../include/message_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "test_check.h"
+
+/* Transport stand-in: moves committed TX frames into a lane's RX ring. */
+typedef struct {
+    twin_lane_manager_t* manager;
+    uint32_t peer;
+    uint32_t last_sequence;
+} Loopback;
+
+static bool loopback_frame(void* context, const void* data, size_t size, uint32_t sequence) {
+    Loopback* loop = context;
+    if (!twin_lane_deliver(loop->manager, loop->peer, data, size, sequence)) return false;
+    loop->last_sequence = sequence;
+    return true;
+}
+
+static void fill(unsigned char* buf, size_t size, uint32_t seed) {
+    for (size_t i = 0; i < size; ++i) buf[i] = (unsigned char)(seed * 31 + i);
+}
+
+static bool matches(const unsigned char* buf, size_t size, uint32_t seed) {
+    for (size_t i = 0; i < size; ++i) {
+        if (buf[i] != (unsigned char)(seed * 31 + i)) return false;
+    }
+    return true;
+}
+
+typedef struct {
+    twin_lane_manager_t* manager;
+    uint32_t client, server;
+    Loopback* loop;
+    uint32_t received;
+    bool intact, ordered;
+} Receiver;
+
+/* Move everything across, check it, and acknowledge it in one ACK. */
+static void pump(Receiver* r) {
+    unsigned char* in;
+    size_t size;
+    uint32_t sequence;
+    twin_lane_drain_tx(r->manager, r->client, loopback_frame, r->loop, SIZE_MAX);
+    while ((in = twin_lane_receive(r->manager, r->server, &size, &sequence))) {
+        r->ordered &= sequence == ++r->received;
+        r->intact &= size == 1 + (sequence * 397) % 1500 && matches(in, size, sequence);
+        message_pool_release(in);
+    }
+    twin_lane_update_flow_control(r->manager, r->client, r->loop->last_sequence);
+}
+
+static void test_mixed_sizes(void) {
+    printf("📦 Mixed message sizes survive many wraps\n");
+    twin_lane_manager_t manager;
+    twin_lane_init(&manager, 2);
+    uint32_t client = twin_lane_create(&manager, 1, 4096, 4096);
+    uint32_t server = twin_lane_create(&manager, 0, 3000, 4096);
+    CHECK(manager.lanes[server].tx.capacity == 4096, "capacities round up to a power of two");
+
+    Loopback loop = { &manager, server, 0 };
+    Receiver receiver = { &manager, client, server, &loop, 0, true, true };
+    unsigned char out[2048];
+    size_t size;
+    uint32_t sequence;
+    bool intact = true;
+    for (uint32_t i = 1; i <= 5000; ++i) {
+        size_t length = 1 + (i * 397) % 1500;
+        fill(out, length, i);
+        // Drain and ACK only when the ring is full, so records wrap at every offset
+        if (!twin_lane_send(&manager, client, out, length, i)) {
+            pump(&receiver);
+            if (!twin_lane_send(&manager, client, out, length, i)) { intact = false; break; }
+        }
+    }
+    pump(&receiver);
+    intact &= receiver.intact;
+    bool ordered = receiver.ordered && receiver.received == 5000;
+    CHECK(intact, "every payload arrives with its own size and bytes");
+    CHECK(ordered, "records arrive once, in send order");
+
+    fill(out, 8, 0);
+    CHECK(!twin_lane_send(&manager, client, out, 4096, 1), "a message larger than the ring is refused");
+    CHECK(twin_lane_receive(&manager, server, &size, &sequence) == NULL && size == 0, "an empty ring reads as empty");
+    twin_lane_destroy(&manager);
+}
+
+static void test_ring_full(void) {
+    printf("🧱 A full ring refuses sends until drained\n");
+    twin_lane_manager_t manager;
+    twin_lane_init(&manager, 2);
+    uint32_t lane = twin_lane_create(&manager, 1, 1024, 1024);
+    char msg[300] = {0};
+    int sent = 0;
+    while (twin_lane_send(&manager, lane, msg, 120, (uint32_t)sent)) sent++;
+    CHECK(sent == 1024 / 128, "records are length-prefixed and 8-byte aligned");
+    CHECK(atomic_load(&manager.lanes[lane].tx_inflight) == (uint32_t)sent, "a refused send gives its window slot back");
+
+    Loopback loop = { &manager, lane, 0 };
+    CHECK(twin_lane_drain_tx(&manager, lane, loopback_frame, &loop, 3) == 3, "drains stop at max_frames");
+    CHECK(twin_lane_send(&manager, lane, msg, 300, 100), "freed bytes take a larger message");
+    twin_lane_destroy(&manager);
+}
+
+static void test_cumulative_ack(void) {
+    printf("📬 One cumulative ACK credits the whole window\n");
+    twin_lane_manager_t manager;
+    twin_lane_init(&manager, 1);
+    uint32_t lane = twin_lane_create(&manager, 1, 65536, 65536);
+    char msg[16] = {0};
+    uint32_t window = atomic_load(&manager.lanes[lane].tx_window_size);
+    uint32_t sent = 0;
+    while (twin_lane_send(&manager, lane, msg, sizeof(msg), 1000 + sent)) sent++;
+    CHECK(sent == window && !twin_lane_can_send(&manager, lane), "the window fills to its size");
+
+    Loopback loop = { &manager, lane, 0 };
+    twin_lane_drain_tx(&manager, lane, loopback_frame, &loop, SIZE_MAX);
+    CHECK(twin_lane_update_flow_control(&manager, lane, 999) == 0, "an ACK before the window credits nothing");
+    CHECK(twin_lane_update_flow_control(&manager, lane, 1000 + 9) == 10, "a partial ACK credits its prefix");
+    CHECK(twin_lane_update_flow_control(&manager, lane, 1000 + sent - 1) == sent - 10, "the rest lands in one call");
+    CHECK(atomic_load(&manager.lanes[lane].tx_inflight) == 0 && twin_lane_can_send(&manager, lane), "the window is open again");
+    CHECK(twin_lane_update_flow_control(&manager, lane, 1000 + sent - 1) == 0, "a duplicate ACK is harmless");
+
+    // Fast batched ACKs grow the window rather than shrinking it
+    for (int round = 0; round < 4; ++round) {
+        uint32_t batch = 0, last = 0;
+        while (twin_lane_send(&manager, lane, msg, sizeof(msg), last = 5000 + round * 1000 + batch)) batch++;
+        twin_lane_drain_tx(&manager, lane, loopback_frame, &loop, SIZE_MAX);
+        twin_lane_update_flow_control(&manager, lane, last - 1);
+    }
+    CHECK(atomic_load(&manager.lanes[lane].tx_window_size) > window, "quick ACK batches widen the window");
+    CHECK(atomic_load(&manager.lanes[lane].tx_window_size) <= TWIN_LANE_MAX_WINDOW, "within the maximum");
+
+    // Sequences wrap in serial-number order
+    size_t size;
+    uint32_t sequence;
+    void* in;
+    while ((in = twin_lane_receive(&manager, lane, &size, &sequence))) message_pool_release(in);
+    twin_lane_send(&manager, lane, msg, sizeof(msg), UINT32_MAX - 1);
+    twin_lane_send(&manager, lane, msg, sizeof(msg), 2);
+    CHECK(twin_lane_update_flow_control(&manager, lane, 1) == 1, "an ACK after the wrap covers the sequence before it");
+    CHECK(twin_lane_update_flow_control(&manager, lane, 2) == 1, "and then the one after");
+    twin_lane_destroy(&manager);
+}
+
+#define SENDERS 4
+#define PER_SENDER 20000
+
+typedef struct {
+    twin_lane_manager_t* manager;
+    uint32_t lane;
+    uint32_t id;
+} Sender;
+
+static void* sender_main(void* arg) {
+    Sender* s = arg;
+    unsigned char msg[256];
+    for (uint32_t i = 0; i < PER_SENDER; ++i) {
+        size_t length = 8 + (i * 13 + s->id * 7) % 200;
+        uint32_t sequence = s->id * PER_SENDER + i;
+        fill(msg, length, sequence);
+        while (!twin_lane_send(s->manager, s->lane, msg, length, sequence)) { }
+    }
+    return NULL;
+}
+
+static void test_concurrent_senders(void) {
+    printf("🧵 Concurrent senders publish whole records in order\n");
+    twin_lane_manager_t manager;
+    twin_lane_init(&manager, 2);
+    uint32_t lane = twin_lane_create(&manager, 1, 8192, 8192);
+    pthread_t threads[SENDERS];
+    Sender senders[SENDERS];
+    for (uint32_t i = 0; i < SENDERS; ++i) {
+        senders[i] = (Sender){ &manager, lane, i };
+        pthread_create(&threads[i], NULL, sender_main, &senders[i]);
+    }
+
+    // Drain and credit everything seen, as a transport would
+    Loopback loop = { &manager, lane, 0 };
+    uint32_t next[SENDERS] = {0}, total = 0;
+    bool intact = true, ordered = true;
+    while (total < SENDERS * PER_SENDER) {
+        twin_lane_drain_tx(&manager, lane, loopback_frame, &loop, 64);
+        size_t size;
+        uint32_t sequence;
+        void* in;
+        while ((in = twin_lane_receive(&manager, lane, &size, &sequence))) {
+            uint32_t id = sequence / PER_SENDER, i = sequence % PER_SENDER;
+            ordered &= id < SENDERS && i == next[id]++;
+            intact &= size == 8 + (i * 13 + id * 7) % 200 && matches(in, size, sequence);
+            message_pool_release(in);
+            total++;
+        }
+        // Everything received so far is acknowledged, whatever the sender
+        uint32_t highest = 0;
+        for (uint32_t id = 0; id < SENDERS; ++id) {
+            if (next[id]) highest = highest > id * PER_SENDER + next[id] - 1 ? highest : id * PER_SENDER + next[id] - 1;
+        }
+        twin_lane_update_flow_control(&manager, lane, highest);
+    }
+    for (int i = 0; i < SENDERS; ++i) pthread_join(threads[i], NULL);
+    CHECK(intact, "no record is torn or interleaved");
+    CHECK(ordered, "each sender's records stay in its order");
+    twin_lane_destroy(&manager);
+}
+
+int main(void) {
+    printf("🧪 Twin Lane Tests\n");
+    test_mixed_sizes();
+    test_ring_full();
+    test_cumulative_ack();
+    test_concurrent_senders();
+    message_pool_thread_flush();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All twin lane tests passed\n");
+    return 0;
+}
@@ -1,6 +1,27 @@
 #include "../include/universal_multi_segmented_bi_buffer_bus.h"
 #include "../include/feedback_stream.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "test_check.h"
+
+#define AFFINITY_PRODUCERS 4
+#define AFFINITY_MESSAGES 8     // Per producer; two producers on one lane still fit its credit
+
+typedef struct {
+    UniversalMultiSegmentedBiBufferBus* bus;
+    uint32_t producer;
+} AffinityProducer;
+
+static void* affinity_submit(void* arg) {
+    AffinityProducer* p = arg;
+    for (uint32_t i = 0; i < AFFINITY_MESSAGES; ++i) {
+        uint32_t msg[2] = { p->producer, i };
+        umsbb_submit(p->bus, (const char*)msg, sizeof(msg));
+    }
+    return NULL;
+}
 
 int main() {
     printf("🚀 Universal Multi-Segmented Bi-Buffer Bus Test Suite\n");
@@ -27,8 +48,149 @@ int main() {
     printf("===================\n");
     feedback_render(&bus->feedback);
     
+    printf("\n📐 Scaling lanes online...\n");
+    size_t lastLane = bus->ring.activeCount - 1;
+    umsbb_submit_to(bus, lastLane, "Queued before scale-down", 24);
+    bool scaled = umsbb_scale_segments(bus, 2);
+    size_t size = 0;
+    void* kept = umsbb_drain_from(bus, lastLane, &size);
+    bool rejected = !umsbb_submit_to(bus, lastLane, "After scale-down", 16);
+    printf("   retired lane %zu\n", lastLane);
+    CHECK(scaled && kept && size == 24 && rejected, "Retired lane drained its queued message and takes no new ones");
+    umsbb_message_release(kept);
+    CHECK(umsbb_scale_segments(bus, 2) && bus->ring.activeCount == 2, "Rescaling to the current count is a no-op");
+
+    // Rounded up to a power of two by the ring
+    bool resized = umsbb_resize_lane(bus, 0, 48 * 1024);
+    umsbb_submit_to(bus, 0, "After resize", 12);
+    // Anything still queued in the old region comes out first
+    while ((kept = umsbb_drain_from(bus, 0, &size)) != NULL && size != 12) umsbb_message_release(kept);
+    printf("   lane 0 now holds %zu bytes\n", bi_buffer_capacity(bus->ring.buffers[0]));
+    CHECK(resized && kept && size == 12, "Lane 0 resized without losing traffic");
+    umsbb_message_release(kept);
+#if UMSBB_ENABLE_FLOW_CONTROL
+    size_t high, low, batch;
+    HighWaterMarkStats gate;
+    flow_control_marks(&bus->flow, bi_buffer_capacity(bus->ring.buffers[0]), &high, &low, &batch);
+    hwm_get_stats(bus->credit[0], &gate);
+    CHECK(gate.high == high && gate.low == low,
+          "Lane 0's gate follows the capacity it was given");
+#endif
+    CHECK(umsbb_scale_segments(bus, 8) && bus->ring.activeCount == 8, "Scaled back up to 8 active lanes");
+
+    printf("\n✍️  Zero-copy reservations...\n");
+    umsbb_msg_view view;
+    umsbb_reservation slot = umsbb_reserve(bus, 2, 64);
+    for (int i = 0; slot.data && i < 64; ++i) ((char*)slot.data)[i] = (char)('a' + i % 26);
+    uint32_t sequence = slot.sequence;
+    bool committed = umsbb_commit(bus, &slot);
+    CHECK(committed && !umsbb_commit(bus, &slot), "A reservation commits once");
+    bool viewed = umsbb_drain_view(bus, 2, &view);
+    CHECK(viewed && view.size == 64 && view.sequence == sequence &&
+          ((const char*)view.data)[0] == 'a' && ((const char*)view.data)[63] == 'a' + 63 % 26,
+          "Payload written in place drains with its sequence");
+    umsbb_release_view(bus, 2);
+    CHECK(bi_buffer_backlog(bus->ring.buffers[2]) == 0, "Released view frees its frame");
+
+    // Several laps of a 1 KiB lane only fit if released space is reused
+    int laps = 0;
+    for (int i = 0; i < 32; ++i) {
+        slot = umsbb_reserve(bus, 2, 200);
+        if (!slot.data || !umsbb_commit(bus, &slot) || !umsbb_drain_view(bus, 2, &view)) break;
+        umsbb_release_view(bus, 2);
+        laps++;
+    }
+    CHECK(laps == 32, "Released space is reserved again");
+    CHECK(!umsbb_reserve(bus, 2, 4096).data, "Reservation larger than the lane fails");
+
+    slot = umsbb_reserve(bus, 2, 64);
+    memcpy(slot.data, "short", 5);
+    CHECK(!umsbb_commit_length(bus, &slot, 65) && umsbb_commit_length(bus, &slot, 5), "Commit takes at most the reserved length");
+    viewed = umsbb_drain_view(bus, 2, &view);
+    CHECK(viewed && view.size == 5 && memcmp(view.data, "short", 5) == 0, "Trimmed commit drains its actual length");
+    umsbb_release_view(bus, 2);
+
+    umsbb_reservation dropped = umsbb_reserve(bus, 2, 100);
+    umsbb_reservation behind = umsbb_reserve(bus, 2, 7);
+    memcpy(behind.data, "behind!", 7);
+    umsbb_commit(bus, &behind);
+    CHECK(!umsbb_drain_view(bus, 2, &view), "Open reservation holds back the frames behind it");
+    CHECK(umsbb_cancel(bus, &dropped) && !umsbb_cancel(bus, &dropped), "A reservation cancels once");
+    viewed = umsbb_drain_view(bus, 2, &view);
+    CHECK(viewed && view.size == 7 && memcmp(view.data, "behind!", 7) == 0, "Cancelled reservation no longer blocks the lane");
+    umsbb_release_view(bus, 2);
+    CHECK(bi_buffer_backlog(bus->ring.buffers[2]) == 0, "Lane is empty after the skipped frame");
+
+    printf("\n🛡️  Strong checksums...\n");
+    CHECK(umsbb_configure_checksum(bus, CHECKSUM_POLICY_STRONG), "Lanes switch to CRC32C");
+#if UMSBB_ENABLE_FEEDBACK
+    FeedbackCursor cursor;
+    umsbb_feedback_cursor(bus, 3, &cursor);
+#endif
+    slot = umsbb_reserve(bus, 3, 32);
+    char* payload = slot.data;
+    memset(payload, 'x', 32);
+    sequence = slot.sequence;
+    umsbb_commit(bus, &slot);
+    CHECK((bi_buffer_frame(payload)->flags & CHECKSUM_POLICY_MASK) == CHECKSUM_POLICY_STRONG,
+          "Committed frame records the strong policy");
+    payload[17] ^= 0x01; // One flipped bit after the commit
+    CHECK(!umsbb_drain_view(bus, 3, &view), "Corrupted frame is refused");
+    CHECK(bi_buffer_backlog(bus->ring.buffers[3]) == 0, "and dropped from the lane");
+#if UMSBB_ENABLE_FEEDBACK
+    FeedbackEntry entries[16];
+    size_t reported = umsbb_read_feedback(bus, 3, &cursor, entries, 16);
+    bool corrupted = false;
+    for (size_t i = 0; i < reported; i++) {
+        corrupted |= entries[i].type == FEEDBACK_CORRUPTED && entries[i].sequence == sequence;
+    }
+    CHECK(corrupted, "Lane 3 reports the frame corrupted");
+#endif
+    umsbb_submit_to(bus, 3, "intact", 6);
+    kept = umsbb_drain_from(bus, 3, &size);
+    CHECK(kept && size == 6 && memcmp(kept, "intact", 6) == 0, "Intact frames behind it still drain");
+    umsbb_message_release(kept);
+    umsbb_configure_checksum(bus, CHECKSUM_POLICY_DEFAULT);
+
+    printf("\n📌 Affinity routing...\n");
+    CHECK(umsbb_configure_segment_routing(bus, SEGMENT_ROUTING_AFFINITY), "Producers are pinned to lanes");
+    AffinityProducer producers[AFFINITY_PRODUCERS];
+    pthread_t threads[AFFINITY_PRODUCERS];
+    for (uint32_t i = 0; i < AFFINITY_PRODUCERS; ++i) {
+        producers[i] = (AffinityProducer){ bus, i };
+        pthread_create(&threads[i], NULL, affinity_submit, &producers[i]);
+    }
+    for (uint32_t i = 0; i < AFFINITY_PRODUCERS; ++i) pthread_join(threads[i], NULL);
+
+    size_t lanes[AFFINITY_PRODUCERS];
+    uint32_t received[AFFINITY_PRODUCERS] = { 0 };
+    bool pinned = true, ordered = true;
+    for (size_t lane = 0; lane < bus->ring.activeCount; ++lane) {
+        uint32_t* msg;
+        while ((msg = umsbb_drain_from(bus, lane, &size)) != NULL) {
+            uint32_t producer = msg[0];
+            if (size != 2 * sizeof(uint32_t) || producer >= AFFINITY_PRODUCERS) {
+                pinned = false;
+            } else {
+                if (received[producer] == 0) lanes[producer] = lane;
+                pinned &= lanes[producer] == lane;
+                ordered &= msg[1] == received[producer]++;
+            }
+            umsbb_message_release(msg);
+        }
+    }
+    bool all = true;
+    for (uint32_t i = 0; i < AFFINITY_PRODUCERS; ++i) all &= received[i] == AFFINITY_MESSAGES;
+    CHECK(all && pinned, "Each producer's submits all land on one lane");
+    CHECK(ordered, "and drain in the order it sent them");
+    umsbb_configure_segment_routing(bus, SEGMENT_ROUTING_ROUND_ROBIN);
+
     printf("\n🧹 Cleanup...\n");
     umsbb_free(bus);
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
     printf("✅ Test completed successfully!\n");
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "../include/wasm_heap.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "test_check.h"
+
+static void test_reuse(void) {
+    printf("♻️ Allocation, reuse and merging\n");
+    WasmHeap heap;
+    wasm_heap_init(&heap, 0);
+    WasmHeapStats stats;
+
+    void* a = wasm_heap_alloc(&heap, 100);
+    void* b = wasm_heap_alloc(&heap, 1);
+    void* c = wasm_heap_alloc(&heap, 5000);
+    CHECK(a && b && c, "allocations succeed");
+    CHECK(((uintptr_t)a | (uintptr_t)b | (uintptr_t)c) % WASM_HEAP_ALIGN == 0, "every block is aligned");
+    CHECK(wasm_heap_usable_size(a) >= 100 && wasm_heap_usable_size(b) >= 1 && wasm_heap_usable_size(c) >= 5000,
+          "usable size covers the request");
+    memset(a, 0xAA, 100);
+    memset(c, 0xCC, 5000);
+
+    wasm_heap_get_stats(&heap, &stats);
+    CHECK(stats.allocations == 3 && stats.regions == 1 && stats.reservedBytes >= WASM_HEAP_DEFAULT_GROW,
+          "one default region serves small requests");
+
+    wasm_heap_free(&heap, b);
+    void* again = wasm_heap_alloc(&heap, 1);
+    CHECK(again == b, "a freed block is handed out again");
+    CHECK(((unsigned char*)a)[99] == 0xAA && ((unsigned char*)c)[0] == 0xCC, "neighbours are untouched");
+
+    wasm_heap_free(&heap, a);
+    wasm_heap_free(&heap, again);
+    wasm_heap_free(&heap, c);
+    wasm_heap_get_stats(&heap, &stats);
+    CHECK(stats.allocations == 0 && stats.inUseBytes == 0, "everything returned");
+    CHECK(stats.freeBlocks == 1 && stats.largestFree == stats.freeBytes, "freed neighbours merge into one block");
+
+    void* whole = wasm_heap_alloc(&heap, stats.largestFree);
+    CHECK(whole && whole == a, "the merged block serves one request for all of it");
+    wasm_heap_free(&heap, whole);
+
+    CHECK(wasm_heap_alloc(&heap, (size_t)-1) == NULL, "absurd sizes are refused");
+    wasm_heap_free(&heap, NULL);
+    wasm_heap_destroy(&heap);
+}
+
+static void test_cycles(void) {
+    printf("🔁 Create/destroy cycles keep a fixed footprint\n");
+    WasmHeap heap;
+    wasm_heap_init(&heap, 0);
+    WasmHeapStats stats;
+
+    // A buffer: a header and a handful of rings of mixed sizes
+    size_t reserved = 0;
+    bool steady = true;
+    for (int cycle = 0; cycle < 1000; ++cycle) {
+        void* parts[9];
+        parts[0] = wasm_heap_alloc(&heap, 256);
+        for (int i = 1; i < 9; ++i) parts[i] = wasm_heap_alloc(&heap, (size_t)(16 << 10) * (size_t)(1 + (cycle + i) % 4));
+        for (int i = 0; i < 9; ++i) {
+            if (!parts[i]) steady = false;
+        }
+        for (int i = 8; i >= 0; --i) wasm_heap_free(&heap, parts[(i * 5) % 9]);
+        wasm_heap_get_stats(&heap, &stats);
+        if (cycle == 0) reserved = stats.reservedBytes;
+        else if (stats.reservedBytes != reserved) steady = false;
+    }
+    CHECK(steady, "a thousand cycles never take more memory");
+    CHECK(stats.freeBlocks == 1 && stats.allocations == 0, "and leave nothing fragmented");
+    wasm_heap_destroy(&heap);
+}
+
+static void test_growth(void) {
+    printf("📈 Growth past the first region\n");
+    WasmHeap heap;
+    wasm_heap_init(&heap, 64 * 1024);
+    WasmHeapStats stats;
+
+    void* blocks[32];
+    bool ok = true;
+    for (int i = 0; i < 32; ++i) {
+        blocks[i] = wasm_heap_alloc(&heap, 48 * 1024);
+        if (!blocks[i]) ok = false;
+        else memset(blocks[i], i, 48 * 1024);
+    }
+    void* big = wasm_heap_alloc(&heap, 4 * 1024 * 1024);
+    CHECK(ok && big, "requests beyond the grow step still succeed");
+    wasm_heap_get_stats(&heap, &stats);
+    CHECK(stats.regions > 1 && stats.reservedBytes >= 32 * 48 * 1024 + 4 * 1024 * 1024, "new regions are taken");
+
+    bool intact = true;
+    for (int i = 0; i < 32; ++i) {
+        if (((unsigned char*)blocks[i])[48 * 1024 - 1] != (unsigned char)i) intact = false;
+        wasm_heap_free(&heap, blocks[i]);
+    }
+    wasm_heap_free(&heap, big);
+    CHECK(intact, "blocks keep their contents across growth");
+    wasm_heap_get_stats(&heap, &stats);
+    CHECK(stats.freeBlocks == stats.regions && stats.inUseBytes == 0, "each region merges back to one block");
+    wasm_heap_destroy(&heap);
+    wasm_heap_get_stats(&heap, &stats);
+    CHECK(stats.reservedBytes == 0 && stats.regions == 0, "destroy returns the regions");
+}
+
+#define STRESS_THREADS 4
+#define STRESS_ROUNDS 20000
+
+static WasmHeap shared_heap;
+
+static void* stress(void* arg) {
+    unsigned seed = (unsigned)(uintptr_t)arg * 2654435761u;
+    unsigned char* live[16] = {0};
+    size_t sizes[16] = {0};
+    intptr_t corrupt = 0;
+    for (int round = 0; round < STRESS_ROUNDS; ++round) {
+        seed = seed * 1103515245u + 12345u;
+        int slot = (int)((seed >> 8) % 16);
+        if (live[slot]) {
+            if (live[slot][0] != (unsigned char)slot || live[slot][sizes[slot] - 1] != (unsigned char)slot) corrupt++;
+            wasm_heap_free(&shared_heap, live[slot]);
+            live[slot] = NULL;
+        } else {
+            sizes[slot] = 1 + (seed >> 16) % 8192;
+            live[slot] = (unsigned char*)wasm_heap_alloc(&shared_heap, sizes[slot]);
+            if (!live[slot]) { corrupt++; continue; }
+            memset(live[slot], slot, sizes[slot]);
+        }
+    }
+    for (int i = 0; i < 16; ++i) wasm_heap_free(&shared_heap, live[i]);
+    return (void*)corrupt;
+}
+
+static void test_threads(void) {
+    printf("🧵 Workers sharing one heap\n");
+    wasm_heap_init(&shared_heap, 0);
+    pthread_t threads[STRESS_THREADS];
+    for (uintptr_t i = 0; i < STRESS_THREADS; ++i) pthread_create(&threads[i], NULL, stress, (void*)(i + 1));
+    intptr_t corrupt = 0;
+    for (int i = 0; i < STRESS_THREADS; ++i) {
+        void* result;
+        pthread_join(threads[i], &result);
+        corrupt += (intptr_t)result;
+    }
+    CHECK(corrupt == 0, "no block is handed out twice");
+    WasmHeapStats stats;
+    wasm_heap_get_stats(&shared_heap, &stats);
+    CHECK(stats.allocations == 0 && stats.freeBlocks == stats.regions, "the heap drains back to whole regions");
+    wasm_heap_destroy(&shared_heap);
+}
+
+int main(void) {
+    printf("🧪 WASM Heap Tests\n");
+    test_reuse();
+    test_cycles();
+    test_growth();
+    test_threads();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All wasm heap tests passed\n");
+    return 0;
+}
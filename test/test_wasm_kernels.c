@@ -0,0 +1,79 @@
+#include "../include/wasm_kernels.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "test_check.h"
+
+static uint32_t rng_state = 12345;
+
+static uint32_t next_random(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return rng_state >> 8;
+}
+
+static void test_copy(void) {
+    printf("📋 Copy (%s)\n", wasm_kernels_impl_name());
+    uint8_t src[320], dst[352], expect[352];
+    for (size_t i = 0; i < sizeof(src); i++) src[i] = (uint8_t)next_random();
+
+    // Every length at every alignment, with guard bytes either side
+    bool exact = true;
+    for (size_t offset = 0; offset < 16; offset++) {
+        for (size_t size = 0; size <= 300; size++) {
+            memset(dst, 0xEE, sizeof(dst));
+            memset(expect, 0xEE, sizeof(expect));
+            memcpy(expect + offset + 16, src + offset, size);
+            wasm_copy_bytes(dst + offset + 16, src + offset, size);
+            if (memcmp(dst, expect, sizeof(dst)) != 0) exact = false;
+        }
+    }
+    CHECK(exact, "matches memcpy for every length and alignment");
+}
+
+static void test_scans(void) {
+    printf("🔎 Segment scans (%s)\n", wasm_kernels_impl_name());
+    uint32_t words[40];
+
+    bool masks = true;
+    for (int round = 0; round < 2000; round++) {
+        uint32_t count = next_random() % 33;
+        uint32_t expect = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            words[i] = (next_random() % 3 == 0) ? 0 : next_random() | (next_random() % 2 ? 0x80000000u : 0);
+            if (words[i]) expect |= 1u << i;
+        }
+        if (wasm_nonzero_mask(words, count) != expect) masks = false;
+    }
+    CHECK(masks, "nonzero masks match for 0..32 words");
+
+    bool minimums = true;
+    for (int round = 0; round < 2000; round++) {
+        uint32_t count = 1 + next_random() % 40;
+        uint32_t range = (round % 2) ? 4 : UINT32_MAX;     // Small ranges force ties
+        for (uint32_t i = 0; i < count; i++) words[i] = (next_random() * 2654435761u) % range;
+        if (round % 7 == 0) words[next_random() % count] = UINT32_MAX;
+        uint32_t best = 0;
+        for (uint32_t i = 1; i < count; i++) {
+            if (words[i] < words[best]) best = i;
+        }
+        if (wasm_min_index(words, count) != best) minimums = false;
+    }
+    CHECK(minimums, "minimum index matches, lowest on ties");
+
+    uint32_t all_max[8];
+    memset(all_max, 0xFF, sizeof(all_max));
+    CHECK(wasm_min_index(all_max, 8) == 0 && wasm_min_index(words, 0) == 0, "degenerate inputs pick 0");
+}
+
+int main(void) {
+    printf("🧪 WASM Kernel Tests\n");
+    test_copy();
+    test_scans();
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All wasm kernel tests passed\n");
+    return 0;
+}
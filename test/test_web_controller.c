@@ -0,0 +1,343 @@
+#include "../include/web_controller.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <poll.h>
+#include "test_check.h"
+
+#define CONCURRENT_CLIENTS 300
+#define SUBSCRIBERS 8
+
+static int connect_to(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    struct timeval timeout = { 3, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool send_all(int fd, const char* data) {
+    size_t length = strlen(data);
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent <= 0) return false;
+        data += sent;
+        length -= (size_t)sent;
+    }
+    return true;
+}
+
+/* Everything the server sends until it closes the connection. */
+static size_t read_until_close(int fd, char* out, size_t size) {
+    size_t length = 0;
+    while (length + 1 < size) {
+        ssize_t got = recv(fd, out + length, size - 1 - length, 0);
+        if (got <= 0) break;
+        length += (size_t)got;
+    }
+    out[length] = '\0';
+    return length;
+}
+
+static bool recv_exact(int fd, void* out, size_t size) {
+    size_t length = 0;
+    while (length < size) {
+        ssize_t got = recv(fd, (char*)out + length, size - length, 0);
+        if (got <= 0) return false;
+        length += (size_t)got;
+    }
+    return true;
+}
+
+/* Upgrade `path`; the socket once the 101 is read, else -1. */
+static int websocket_open(uint16_t port, const char* path) {
+    int fd = connect_to(port);
+    if (fd < 0) return -1;
+    char request[512];
+    snprintf(request, sizeof(request),
+             "GET %s HTTP/1.1\r\n"
+             "Upgrade: websocket\r\n"
+             "Connection: Upgrade\r\n"
+             "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+             "\r\n", path);
+    send_all(fd, request);
+
+    // Read the 101 response byte by byte so no frame bytes are consumed
+    char handshake[1024];
+    size_t length = 0;
+    handshake[0] = '\0';
+    while (length + 1 < sizeof(handshake) && recv_exact(fd, handshake + length, 1)) {
+        length++;
+        handshake[length] = '\0';
+        if (length >= 4 && strcmp(handshake + length - 4, "\r\n\r\n") == 0) break;
+    }
+    // The RFC 6455 sample key has a known accept value
+    if (strncmp(handshake, "HTTP/1.1 101", 12) != 0 ||
+        !strstr(handshake, "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=")) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* One server frame: its opcode, or -1. Payloads of up to 64 KB. */
+static int websocket_read(int fd, uint8_t* payload, size_t size, size_t* length) {
+    uint8_t header[2];
+    if (!recv_exact(fd, header, 2)) return -1;
+    *length = header[1] & 0x7F;
+    if (*length == 126) {
+        uint8_t extended[2];
+        if (!recv_exact(fd, extended, 2)) return -1;
+        *length = ((size_t)extended[0] << 8) | extended[1];
+    } else if (*length == 127) {
+        return -1;
+    }
+    if (*length >= size || !recv_exact(fd, payload, *length)) return -1;
+    payload[*length] = '\0';
+    return header[0];
+}
+
+static bool readable_within(int fd, int timeout_ms) {
+    struct pollfd entry = { fd, POLLIN, 0 };
+    return poll(&entry, 1, timeout_ms) > 0;
+}
+
+static uint64_t get_le(const uint8_t* p, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) value = (value << 8) | p[i];
+    return value;
+}
+
+/* Decoded binary metrics frame. */
+typedef struct {
+    bool keyframe;
+    uint32_t count;
+    uint32_t sequence;
+    uint8_t fields[WEB_METRIC_COUNT];
+    uint64_t values[WEB_METRIC_COUNT];
+} MetricsFrame;
+
+static bool metrics_read(int fd, MetricsFrame* frame) {
+    uint8_t payload[1024];
+    size_t length;
+    if (websocket_read(fd, payload, sizeof(payload), &length) != 0x82) return false;
+    if (length < WEB_METRICS_HEADER_SIZE || payload[0] != WEB_METRICS_VERSION) return false;
+    frame->keyframe = (payload[1] & WEB_METRICS_KEYFRAME) != 0;
+    frame->count = (uint32_t)get_le(payload + 2, 2);
+    frame->sequence = (uint32_t)get_le(payload + 4, 4);
+    if (frame->count > WEB_METRIC_COUNT ||
+        length != WEB_METRICS_HEADER_SIZE + frame->count * WEB_METRICS_ENTRY_SIZE) return false;
+    for (uint32_t i = 0; i < frame->count; i++) {
+        const uint8_t* entry = payload + WEB_METRICS_HEADER_SIZE + i * WEB_METRICS_ENTRY_SIZE;
+        frame->fields[i] = entry[0];
+        frame->values[i] = get_le(entry + 1, 8);
+    }
+    return true;
+}
+
+static bool fetch(uint16_t port, const char* request, char* response, size_t size) {
+    int fd = connect_to(port);
+    if (fd < 0) return false;
+    bool ok = send_all(fd, request) && read_until_close(fd, response, size) > 0;
+    close(fd);
+    return ok;
+}
+
+static void test_http_endpoints(web_server_t* server) {
+    printf("🔬 HTTP endpoints\n");
+    static char response[128 * 1024];
+
+    CHECK(fetch(server->port, "GET /api/status HTTP/1.1\r\nHost: x\r\n\r\n", response, sizeof(response)) &&
+          strncmp(response, "HTTP/1.1 200 OK", 15) == 0 && strstr(response, "\"status\":\"running\"") &&
+          strstr(response, "\"pause_processing\":false"),
+          "/api/status reports a running server");
+
+    CHECK(fetch(server->port, "GET /api/metrics HTTP/1.1\r\n\r\n", response, sizeof(response)) &&
+          strncmp(response, "HTTP/1.1 200 OK", 15) == 0 && strstr(response, "\"throughput_gbps\":") &&
+          response[strlen(response) - 1] == '}',
+          "/api/metrics returns a JSON object");
+
+    CHECK(fetch(server->port, "GET /metrics HTTP/1.1\r\n\r\n", response, sizeof(response)) &&
+          strncmp(response, "HTTP/1.1 200 OK", 15) == 0 &&
+          strstr(response, "Content-Type: text/plain; version=0.0.4") &&
+          strstr(response, "# TYPE umsbb_web_clients gauge\numsbb_web_clients 1\n") &&
+          strstr(response, "umsbb_web_broadcasts_skipped_total 0\n"),
+          "/metrics serves the registry in the Prometheus text format");
+
+    bool dashboard = fetch(server->port, "GET / HTTP/1.1\r\n\r\n", response, sizeof(response));
+    const char* body = strstr(response, "\r\n\r\n");
+    const char* declared = strstr(response, "Content-Length: ");
+    CHECK(dashboard && body && declared && strlen(body + 4) == strtoul(declared + 16, NULL, 10) &&
+          strlen(body + 4) > 4096,
+          "the dashboard (larger than one read) arrives whole");
+
+    CHECK(fetch(server->port, "GET /nowhere HTTP/1.1\r\n\r\n", response, sizeof(response)) &&
+          strncmp(response, "HTTP/1.1 404", 12) == 0,
+          "unknown paths are 404");
+
+    // A request trickling in is answered once its headers are complete
+    int fd = connect_to(server->port);
+    bool sent = fd >= 0 && send_all(fd, "GET /api/st");
+    usleep(50000);
+    sent = sent && send_all(fd, "atus HTTP/1.1\r\n");
+    usleep(50000);
+    sent = sent && send_all(fd, "\r\n");
+    CHECK(sent && read_until_close(fd, response, sizeof(response)) > 0 &&
+          strncmp(response, "HTTP/1.1 200 OK", 15) == 0,
+          "a request split across packets is reassembled");
+    if (fd >= 0) close(fd);
+}
+
+static void test_many_clients(web_server_t* server) {
+    printf("🔬 %d concurrent clients\n", CONCURRENT_CLIENTS);
+    int fds[CONCURRENT_CLIENTS];
+    int connected = 0;
+    for (int i = 0; i < CONCURRENT_CLIENTS; i++) {
+        fds[i] = connect_to(server->port);
+        if (fds[i] >= 0) connected++;
+    }
+    CHECK(connected == CONCURRENT_CLIENTS, "every client connects");
+
+    // All connections are open at once before any request goes out
+    int requested = 0;
+    for (int i = 0; i < CONCURRENT_CLIENTS; i++) {
+        if (fds[i] >= 0 && send_all(fds[i], "GET /api/status HTTP/1.1\r\n\r\n")) requested++;
+    }
+
+    int answered = 0;
+    char response[4096];
+    for (int i = 0; i < CONCURRENT_CLIENTS; i++) {
+        if (fds[i] < 0) continue;
+        if (read_until_close(fds[i], response, sizeof(response)) > 0 &&
+            strncmp(response, "HTTP/1.1 200 OK", 15) == 0) {
+            answered++;
+        }
+        close(fds[i]);
+    }
+    CHECK(requested == CONCURRENT_CLIENTS && answered == CONCURRENT_CLIENTS,
+          "every client is answered, well past the old 100-client table");
+}
+
+static void test_websocket_broadcast(web_server_t* server) {
+    printf("🔬 WebSocket broadcast\n");
+    int fds[SUBSCRIBERS];
+    int upgraded = 0;
+    for (int i = 0; i < SUBSCRIBERS; i++) {
+        fds[i] = websocket_open(server->port, "/ws");
+        if (fds[i] >= 0) upgraded++;
+    }
+    CHECK(upgraded == SUBSCRIBERS, "every subscriber completes the handshake");
+
+    int framed = 0;
+    for (int i = 0; i < SUBSCRIBERS; i++) {
+        if (fds[i] < 0) continue;
+        uint8_t payload[65536];
+        size_t length;
+        if (websocket_read(fds[i], payload, sizeof(payload), &length) == 0x81 && payload[0] == '{' &&
+            strstr((char*)payload, "\"throughput_gbps\":")) {
+            framed++;
+        }
+        close(fds[i]);
+    }
+    CHECK(framed == SUBSCRIBERS, "each JSON subscriber receives the metrics on joining");
+}
+
+static void test_binary_stream(web_server_t* server) {
+    printf("🔬 Binary metrics stream\n");
+    const char* path = "/ws?format=binary&interval_ms=20&fields=total_messages,active_clients";
+
+    char response[1024];
+    CHECK(fetch(server->port, "GET /ws?format=binary&fields=bogus HTTP/1.1\r\nUpgrade: websocket\r\n"
+                "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n", response, sizeof(response)) &&
+          strncmp(response, "HTTP/1.1 400", 12) == 0,
+          "an unknown field is refused");
+
+    int fd = websocket_open(server->port, path);
+    MetricsFrame frame;
+    bool first = fd >= 0 && metrics_read(fd, &frame);
+    CHECK(first && frame.keyframe && frame.count == 2 && frame.fields[0] == WEB_METRIC_TOTAL_MESSAGES &&
+          frame.fields[1] == WEB_METRIC_ACTIVE_CLIENTS && frame.values[1] >= 1,
+          "a subscriber starts with a keyframe of just its fields");
+    uint64_t messages = first ? frame.values[0] : 0;
+    uint32_t sequence = first ? frame.sequence : 0;
+
+    CHECK(fd >= 0 && !readable_within(fd, 150), "nothing is sent while nothing changes");
+
+    char data[64] = {0};
+    gpu_buffer_write_accelerated(server->gpu_buffer, data, sizeof(data), 0);
+    bool delta = fd >= 0 && metrics_read(fd, &frame);
+    CHECK(delta && !frame.keyframe && frame.count == 1 && frame.fields[0] == WEB_METRIC_TOTAL_MESSAGES &&
+          frame.values[0] == messages + 1 && frame.sequence == sequence + 1,
+          "a change arrives as a delta of the changed field alone");
+
+    // A second subscriber of the same shape shares the stream: both get its keyframe
+    int peer = websocket_open(server->port, path);
+    MetricsFrame peer_frame;
+    bool joined = peer >= 0 && metrics_read(peer, &peer_frame) && fd >= 0 && metrics_read(fd, &frame);
+    CHECK(joined && frame.keyframe && peer_frame.keyframe && frame.sequence == peer_frame.sequence &&
+          frame.count == 2 && frame.values[1] == peer_frame.values[1],
+          "subscribers of one shape share a frame");
+
+    // A different shape is a stream of its own, defaulting to every field
+    int all = websocket_open(server->port, "/ws?format=binary&interval_ms=20");
+    MetricsFrame all_frame;
+    CHECK(all >= 0 && metrics_read(all, &all_frame) && all_frame.keyframe && all_frame.count == WEB_METRIC_COUNT &&
+          all_frame.sequence == 0,
+          "another shape gets its own stream with all fields");
+
+    if (all >= 0) close(all);
+    if (peer >= 0) close(peer);
+    if (fd >= 0) close(fd);
+}
+
+int main(void) {
+    printf("🧪 Web Controller Tests\n");
+
+    gpu_accelerated_buffer_t buffer;
+    gpu_buffer_init(&buffer, 1 << 16, GPU_PROCESSING_DISABLED);
+
+    web_server_t server;
+    if (web_server_init(&server, 0, &buffer) != 0) {
+        printf("❌ could not start the web server\n");
+        gpu_buffer_cleanup(&buffer);
+        return 1;
+    }
+    CHECK(server.port != 0, "an ephemeral port is reported back");
+    MetricsRegistry* registry = metrics_registry_create();
+    CHECK(web_server_set_metrics_registry(&server, registry), "the server exports its own counters");
+    CHECK(web_server_start_thread(&server, WEB_SERVER_CPU_AUTO) == 0, "the server runs on its own thread");
+
+    test_http_endpoints(&server);
+    test_many_clients(&server);
+    test_websocket_broadcast(&server);
+    test_binary_stream(&server);
+
+    web_server_stop(&server);
+    CHECK(server.thread == NULL && !atomic_load_bool(&server.is_running), "stop wakes and joins the thread");
+    web_server_cleanup(&server);
+    CHECK(metrics_registry_count(registry) == 0, "cleanup removes the server's series");
+    metrics_registry_destroy(registry);
+    gpu_buffer_cleanup(&buffer);
+
+    if (failures) {
+        printf("❌ %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("🎉 All web controller tests passed\n");
+    return 0;
+}